@@ -0,0 +1,173 @@
+-- The first level, evaluated once and then loaded from level1.cache until this file changes
+Level = {
+    assets = {
+        -- The sprites share atlas pages so they batch together, the tileset is only used to bake the tilemap.
+        -- A streamed texture keeps a low mip resident and pages the whole image in while it is drawn.
+        -- A directional texture stacks the image of each direction, {direction} is up, right, down and left.
+        { type = "texture", id = "tank-image", file = "./assets/images/tank-panther-{direction}.png", atlas = true, directional = true },
+        { type = "texture", id = "truck-image", file = "./assets/images/truck-ford-{direction}.png", atlas = true, directional = true },
+        { type = "texture", id = "truck-killed-image", file = "./assets/images/truck-ford-killed.png", atlas = true },
+        { type = "texture", id = "chopper-image", file = "./assets/images/chopper-spritesheet.png", atlas = true },
+        { type = "texture", id = "radar-image", file = "./assets/images/radar.png", atlas = true },
+        { type = "texture", id = "bullet-image", file = "./assets/images/bullet.png", atlas = true },
+        { type = "texture", id = "tilemap-image", file = "./assets/tilemaps/jungle.png", stream = true },
+        { type = "font", id = "arial-font", file = "./assets/fonts/arial.ttf", font_size = 14 },
+        { type = "sound", id = "helicopter-sound", file = "./assets/sounds/helicopter.wav" },
+        { type = "script", id = "patrol-script", file = "./assets/scripts/patrol.lua" },
+        { type = "script", id = "sentry-script", file = "./assets/scripts/sentry.lua" }
+    },
+
+    tilemap = {
+        map_file = "./assets/tilemaps/jungle.map",
+        stream_file = "./assets/tilemaps/jungle.tmb",
+        texture_asset_id = "tilemap-image",
+        tile_size = 32,
+        scale = 4.0,
+        -- The water, where the ground units can't drive
+        blocked_tiles = { "21", "16", "17", "18", "19" },
+        -- The water ripples and the bushes sway, the frames are in the last row of the tileset
+        animated_tiles = {
+            { frames = { "21", "30", "31", "32" }, speed_rate = 4 },
+            { frames = { "23", "33", "23", "35" }, speed_rate = 2 },
+            { frames = { "24", "34", "24", "36" }, speed_rate = 2 }
+        },
+        -- Only what the player's vision reaches is shown
+        fog_of_war = true
+    },
+
+    entities = {
+        {
+            -- Chopper
+            tag = "player",
+            components = {
+                transform = { position = { x = 10, y = 100 }, scale = { x = 1, y = 1 }, rotation = 0 },
+                rigidbody = { velocity = { x = 0, y = 0 } },
+                sprite = { texture_asset_id = "chopper-image", width = 32, height = 32, z_index = 1 },
+                directional_sprite = { direction = "up" },
+                animation = { num_frames = 2, speed_rate = 15, loop = true },
+                keyboard_controller = {
+                    up_velocity = { x = 0, y = -80 },
+                    right_velocity = { x = 80, y = 0 },
+                    down_velocity = { x = 0, y = 80 },
+                    left_velocity = { x = -80, y = 0 }
+                },
+                camera_follow = { damping = 8 },
+                health = { health_percentage = 100 },
+                vision = { radius = 640 },
+                label = { text = "Player", font_asset_id = "arial-font", offset = { x = 0, y = -16 } }
+            }
+        },
+        {
+            -- Radar, in the top right corner of the window
+            components = {
+                transform = { position = { x = -74, y = 10 }, anchor_right = true },
+                rigidbody = { velocity = { x = 0, y = 0 } },
+                sprite = { texture_asset_id = "radar-image", width = 64, height = 64, z_index = 1, fixed = true },
+                animation = { num_frames = 8, speed_rate = 5, loop = true }
+            }
+        },
+        {
+            -- Tank, on sentry duty, firing at the player in range
+            group = "enemies",
+            components = {
+                transform = { position = { x = 500, y = 10 } },
+                rigidbody = { velocity = { x = 0, y = 0 } },
+                sprite = { texture_asset_id = "tank-image", width = 32, height = 32, z_index = 1 },
+                directional_sprite = {},
+                boxcollider = { width = 32, height = 32, layer = "enemy" },
+                projectile_emitter = {
+                    projectile_velocity = { x = 100, y = 0 },
+                    target_range = 400,
+                    repeat_frequency = 5000,
+                    projectile_duration = 3000,
+                    hit_percentage_damage = 0,
+                    friendly = false,
+                    sound_asset_id = "helicopter-sound"
+                },
+                health = { health_percentage = 100, death_burst = 24 },
+                script = { script_id = "sentry-script" }
+            }
+        },
+        {
+            -- Truck, patrolling
+            group = "enemies",
+            components = {
+                transform = { position = { x = 10, y = 10 } },
+                rigidbody = { velocity = { x = 40, y = 0 } },
+                sprite = { texture_asset_id = "truck-image", width = 32, height = 32, z_index = 2 },
+                directional_sprite = {},
+                boxcollider = { width = 32, height = 32, layer = "enemy" },
+                projectile_emitter = {
+                    projectile_velocity = { x = 0, y = 100 },
+                    repeat_frequency = 2000,
+                    projectile_duration = 5000,
+                    hit_percentage_damage = 0,
+                    friendly = false,
+                    sound_asset_id = "helicopter-sound"
+                },
+                health = { health_percentage = 100, wreck_asset_id = "truck-killed-image", death_burst = 24 },
+                script = { script_id = "patrol-script" }
+            }
+        },
+        {
+            -- Truck, driving around the water to the south west of the island
+            group = "enemies",
+            components = {
+                transform = { position = { x = 1600, y = 320 } },
+                rigidbody = { velocity = { x = 0, y = 0 } },
+                sprite = { texture_asset_id = "truck-image", width = 32, height = 32, z_index = 2 },
+                directional_sprite = {},
+                boxcollider = { width = 32, height = 32, layer = "enemy" },
+                health = { health_percentage = 100, wreck_asset_id = "truck-killed-image", death_burst = 24 },
+                path_follow = { goal = { x = 320, y = 2112 }, speed = 60 }
+            }
+        },
+        {
+            -- Tank, guarding the middle of the island, it chases the player in sight
+            group = "enemies",
+            components = {
+                transform = { position = { x = 1152, y = 896 } },
+                rigidbody = { velocity = { x = 0, y = 0 } },
+                sprite = { texture_asset_id = "tank-image", width = 32, height = 32, z_index = 1 },
+                directional_sprite = {},
+                boxcollider = { width = 32, height = 32, layer = "enemy" },
+                projectile_emitter = {
+                    projectile_velocity = { x = 100, y = 0 },
+                    repeat_frequency = 3000,
+                    projectile_duration = 3000,
+                    hit_percentage_damage = 10,
+                    friendly = false,
+                    sound_asset_id = "helicopter-sound"
+                },
+                health = { health_percentage = 100, death_burst = 24 },
+                path_follow = { goal = { x = 1152, y = 896 }, speed = 40 },
+                ai = { sight_range = 600, attack_range = 300 }
+            }
+        },
+        {
+            -- Tanks, rushing the player once it flies over the island
+            group = "enemies",
+            components = {
+                transform = { position = { x = 1856, y = 960 } },
+                rigidbody = { velocity = { x = 0, y = 0 } },
+                sprite = { texture_asset_id = "tank-image", width = 32, height = 32, z_index = 1 },
+                directional_sprite = {},
+                boxcollider = { width = 32, height = 32, layer = "enemy" },
+                health = { health_percentage = 100, death_burst = 24 },
+                flow_follow = { speed = 30 }
+            }
+        },
+        {
+            group = "enemies",
+            components = {
+                transform = { position = { x = 2624, y = 1600 } },
+                rigidbody = { velocity = { x = 0, y = 0 } },
+                sprite = { texture_asset_id = "tank-image", width = 32, height = 32, z_index = 1 },
+                directional_sprite = {},
+                boxcollider = { width = 32, height = 32, layer = "enemy" },
+                health = { health_percentage = 100, death_burst = 24 },
+                flow_follow = { speed = 30 }
+            }
+        }
+    }
+}
@@ -0,0 +1,13 @@
+-- Turns the entities around when they leave the band they patrol
+local MIN_X = 10
+local MAX_X = 600
+
+function update(batch, deltaTime)
+    for i = 1, batch:size() do
+        local x, y = batch:position(i)
+        local vx, vy = batch:velocity(i)
+        if (x < MIN_X and vx < 0) or (x > MAX_X and vx > 0) then
+            batch:set_velocity(i, -vx, vy)
+        end
+    end
+end
@@ -0,0 +1,15 @@
+-- Drives forward, holds its position for a while, then drives back, while its emitter keeps firing
+local DRIVE_SECONDS = 2.5
+local HOLD_SECONDS = 3
+local SPEED = 30
+
+function behaviour(entity)
+    local direction = 1
+    while true do
+        entity:set_velocity(SPEED * direction, 0)
+        wait(DRIVE_SECONDS)
+        entity:set_velocity(0, 0)
+        wait(HOLD_SECONDS)
+        direction = -direction
+    end
+end
@@ -0,0 +1,376 @@
+#include "../src/ECS/ECS.h"
+#include "../src/EventBus/EventBus.h"
+#include "../src/Components/TransformComponent.h"
+#include "../src/Components/RigidBodyComponent.h"
+#include "../src/Components/BoxColliderComponent.h"
+#include "../src/Systems/MovementSystem.h"
+#include "../src/Systems/CollisonSystem.h"
+#include "../src/Resources/TickTimeResource.h"
+#include "../src/Physics/Integration.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// ECS benchmark
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Usage: ecsbenchmark [results.json]
+// Measures the entity, component, system, event and collision costs at a few entity counts.
+// Each benchmark is set up untimed and run BENCHMARK_REPETITIONS times, the median time per
+// item is kept. The results are written in the Google Benchmark JSON layout so the usual
+// compare tools work across versions, the table goes to stderr, stdout is left to the engine log.
+// Each one also lists the time per item of every repetition as "samples", which
+// tools/PerfGate.cpp tests against the ones of a baseline.
+/////////////////////////////////////////////////////////////////////////////////////////////
+const int BENCHMARK_REPETITIONS = 7;
+const int NUM_COLLISION_FRAMES = 10;
+const int NUM_EVENTS = 100000;
+const double DELTA_TIME = 1.0 / 120.0;
+const std::string DEFAULT_RESULTS_FILE = "./ecsbench.json";
+
+struct BenchmarkResult
+{
+    std::string name;
+    int64_t numItems;
+    double nanosecsPerItem;
+    double minNanosecsPerItem;
+    // Of every repetition, in the order they ran
+    std::vector<double> samples;
+};
+
+std::vector<BenchmarkResult> results;
+
+// Keeps the compiler from dropping the measured work
+volatile double benchmarkSink;
+
+class BenchmarkEvent: public Event
+{
+public:
+    int value;
+    BenchmarkEvent(int value): value(value) {}
+};
+
+class BenchmarkListener
+{
+public:
+    double total = 0.0;
+    void OnEvent(BenchmarkEvent& event) { total += event.value; }
+};
+
+template <typename TSetup, typename TRun>
+void Benchmark(const std::string& name, int64_t numItems, TSetup setup, TRun run)
+{
+    std::vector<double> samples;
+    for (int i = 0; i < BENCHMARK_REPETITIONS; i++)
+    {
+        auto state = setup();
+        const auto start = std::chrono::steady_clock::now();
+        run(*state);
+        const auto end = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration<double, std::nano>(end - start).count() / numItems);
+    }
+    const std::vector<double> runSamples = samples;
+    std::sort(samples.begin(), samples.end());
+    results.push_back({name, numItems, samples[samples.size() / 2], samples.front(), runSamples});
+    std::cerr << name << ": " << samples[samples.size() / 2] << " ns/item (min " << samples.front() << ")" << std::endl;
+}
+
+std::unique_ptr<Registry> CreateMovingEntities(int numEntities, StorageMode storageMode = DEFAULT_STORAGE_MODE)
+{
+    auto registry = std::make_unique<Registry>(storageMode);
+    registry->AddSystem<MovementSystem>();
+    registry->SetResource<TickTimeResource>(DELTA_TIME);
+    for (int i = 0; i < numEntities; i++)
+    {
+        Entity entity = registry->CreateEntity();
+        entity.AddComponent<TransformComponent>(glm::vec2(i, i));
+        entity.AddComponent<RigidBodyComponent>(glm::vec2(10.0, 5.0));
+    }
+    registry->Update();
+    return registry;
+}
+
+// Boxes spread over an area growing with their number, so the density and the number of
+// contacts per box stay the same at every size
+std::unique_ptr<Registry> CreateColliders(int numEntities)
+{
+    auto registry = std::make_unique<Registry>();
+    registry->AddSystem<CollisionSystem>();
+    const int side = static_cast<int>(std::sqrt(numEntities)) + 1;
+    uint32_t seed = 1;
+    for (int i = 0; i < numEntities; i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        const float jitter = static_cast<float>(seed >> 24);
+        Entity entity = registry->CreateEntity();
+        entity.AddComponent<TransformComponent>(glm::vec2((i % side) * 40.0f + jitter / 8.0f, (i / side) * 40.0f + jitter / 16.0f));
+        entity.AddComponent<BoxColliderComponent>(32, 32);
+    }
+    registry->Update();
+    return registry;
+}
+
+void BenchmarkEntities(int numEntities)
+{
+    const std::string size = "/" + std::to_string(numEntities);
+    Benchmark("CreateEntity" + size, numEntities, []() { return std::make_unique<Registry>(); }, [numEntities](Registry& registry)
+    {
+        for (int i = 0; i < numEntities; i++)
+        {
+            registry.CreateEntity();
+        }
+        registry.Update();
+    });
+    Benchmark("KillEntity" + size, numEntities, [numEntities]() { return CreateMovingEntities(numEntities); }, [numEntities](Registry& registry)
+    {
+        for (int i = 0; i < numEntities; i++)
+        {
+            registry.KillEntity(registry.GetEntity(i));
+        }
+        registry.Update();
+    });
+}
+
+void BenchmarkComponents(int numEntities)
+{
+    const std::string size = "/" + std::to_string(numEntities);
+    auto createEntities = [numEntities]()
+    {
+        auto registry = std::make_unique<Registry>();
+        for (int i = 0; i < numEntities; i++)
+        {
+            registry->CreateEntity();
+        }
+        registry->Update();
+        return registry;
+    };
+    Benchmark("AddComponent" + size, numEntities, createEntities, [numEntities](Registry& registry)
+    {
+        for (int i = 0; i < numEntities; i++)
+        {
+            registry.AddComponent<TransformComponent>(registry.GetEntity(i), glm::vec2(i, i));
+        }
+    });
+    Benchmark("Instantiate" + size, numEntities, []() { return std::make_unique<Registry>(); }, [numEntities](Registry& registry)
+    {
+        Prefab prefab;
+        prefab.AddComponent<TransformComponent>().AddComponent<RigidBodyComponent>(glm::vec2(10.0, 5.0));
+        registry.Instantiate(prefab, numEntities);
+        registry.Update();
+    });
+    Benchmark("CreateEntity+AddComponent" + size, numEntities, []() { return std::make_unique<Registry>(); }, [numEntities](Registry& registry)
+    {
+        for (int i = 0; i < numEntities; i++)
+        {
+            Entity entity = registry.CreateEntity();
+            entity.AddComponent<TransformComponent>();
+            entity.AddComponent<RigidBodyComponent>(glm::vec2(10.0, 5.0));
+        }
+        registry.Update();
+    });
+    Benchmark("GetComponent" + size, numEntities, [numEntities]() { return CreateMovingEntities(numEntities); }, [numEntities](Registry& registry)
+    {
+        double sum = 0.0;
+        for (int i = 0; i < numEntities; i++)
+        {
+            sum += registry.GetComponent<TransformComponent>(registry.GetEntity(i)).position.x;
+        }
+        benchmarkSink = sum;
+    });
+}
+
+void BenchmarkSystems(int numEntities, std::unique_ptr<JobSystem>& serialJobs, std::unique_ptr<JobSystem>& parallelJobs)
+{
+    const std::string size = "/" + std::to_string(numEntities);
+    auto setup = [numEntities]() { return CreateMovingEntities(numEntities); };
+    Benchmark("MovementSystem/serial" + size, numEntities, setup, [&serialJobs](Registry& registry)
+    {
+        registry.GetSystem<MovementSystem>().Update(registry, serialJobs);
+    });
+    Benchmark("MovementSystem/parallel" + size, numEntities, setup, [&parallelJobs](Registry& registry)
+    {
+        registry.GetSystem<MovementSystem>().Update(registry, parallelJobs);
+    });
+    Benchmark("View" + size, numEntities, setup, [](Registry& registry)
+    {
+        registry.View<TransformComponent, RigidBodyComponent>().Each([](TransformComponent& transform, RigidBodyComponent& rigidBody)
+        {
+            transform.position += rigidBody.velocity * static_cast<float>(DELTA_TIME);
+        });
+    });
+}
+
+void BenchmarkEvents(int numHandlers)
+{
+    struct EventState
+    {
+        std::unique_ptr<EventBus> eventBus = std::make_unique<EventBus>();
+        std::vector<BenchmarkListener> listeners;
+        std::vector<EventSubscription> subscriptions;
+    };
+    auto setup = [numHandlers]()
+    {
+        auto state = std::make_unique<EventState>();
+        state->listeners.resize(numHandlers);
+        for (auto& listener: state->listeners)
+        {
+            state->subscriptions.push_back(state->eventBus->SubscribeToEvent<BenchmarkEvent>(&listener, &BenchmarkListener::OnEvent));
+        }
+        return state;
+    };
+    const std::string handlers = "/" + std::to_string(numHandlers) + "handlers";
+    Benchmark("EmitEvent" + handlers, NUM_EVENTS, setup, [](EventState& state)
+    {
+        for (int i = 0; i < NUM_EVENTS; i++)
+        {
+            state.eventBus->EmitEvent<BenchmarkEvent>(i);
+        }
+    });
+    Benchmark("QueueEvent+Dispatch" + handlers, NUM_EVENTS, setup, [](EventState& state)
+    {
+        for (int i = 0; i < NUM_EVENTS; i++)
+        {
+            state.eventBus->QueueEvent<BenchmarkEvent>(i);
+        }
+        state.eventBus->DispatchQueuedEvents();
+    });
+}
+
+void BenchmarkCollisions(int numEntities)
+{
+    struct CollisionState
+    {
+        std::unique_ptr<Registry> registry;
+        std::unique_ptr<EventBus> eventBus = std::make_unique<EventBus>();
+    };
+    for (auto mode: {BROADPHASE_SPATIAL_HASH, BROADPHASE_SWEEP_AND_PRUNE})
+    {
+        const std::string name = mode == BROADPHASE_SPATIAL_HASH ? "CollisionSystem/spatialhash/" : "CollisionSystem/sweepandprune/";
+        Benchmark(name + std::to_string(numEntities), static_cast<int64_t>(numEntities) * NUM_COLLISION_FRAMES, [numEntities, mode]()
+        {
+            auto state = std::make_unique<CollisionState>();
+            state->registry = CreateColliders(numEntities);
+            state->registry->GetSystem<CollisionSystem>().SetBroadphaseMode(mode);
+            return state;
+        }, [](CollisionState& state)
+        {
+            for (int i = 0; i < NUM_COLLISION_FRAMES; i++)
+            {
+                state.registry->GetSystem<CollisionSystem>().Update(*state.registry, state.eventBus);
+                state.eventBus->ClearQueuedEvents();
+            }
+        });
+    }
+}
+
+// The integration kernels alone over plain arrays, then the movement system over archetype
+// chunks, up to a million entities
+void BenchmarkIntegration(int numEntities, std::unique_ptr<JobSystem>& serialJobs, std::unique_ptr<JobSystem>& parallelJobs)
+{
+    struct IntegrationState
+    {
+        std::vector<TransformComponent> transforms;
+        std::vector<RigidBodyComponent> rigidBodies;
+    };
+    const std::string size = "/" + std::to_string(numEntities);
+    for (int kernel = 0; kernel < NUM_INTEGRATION_KERNELS; kernel++)
+    {
+        if (!Integration::IsKernelSupported(static_cast<IntegrationKernel>(kernel)))
+        {
+            continue;
+        }
+        Benchmark(std::string("Integration/") + Integration::GetKernelName(static_cast<IntegrationKernel>(kernel)) + size, numEntities, [numEntities]()
+        {
+            auto state = std::make_unique<IntegrationState>();
+            for (int i = 0; i < numEntities; i++)
+            {
+                state->transforms.emplace_back(glm::vec2(i, i));
+                state->rigidBodies.emplace_back(glm::vec2(10.0, 5.0));
+            }
+            return state;
+        }, [kernel, numEntities](IntegrationState& state)
+        {
+            Integration::IntegratePositions(static_cast<IntegrationKernel>(kernel), state.transforms.data(), state.rigidBodies.data(), numEntities, static_cast<float>(DELTA_TIME));
+            benchmarkSink = state.transforms.back().position.x;
+        });
+    }
+
+    auto setup = [numEntities]() { return CreateMovingEntities(numEntities, STORAGE_ARCHETYPE); };
+    Benchmark("MovementSystem/archetype/serial" + size, numEntities, setup, [&serialJobs](Registry& registry)
+    {
+        registry.GetSystem<MovementSystem>().Update(registry, serialJobs);
+    });
+    Benchmark("MovementSystem/archetype/parallel" + size, numEntities, setup, [&parallelJobs](Registry& registry)
+    {
+        registry.GetSystem<MovementSystem>().Update(registry, parallelJobs);
+    });
+}
+
+bool WriteResults(const std::string& filePath)
+{
+    std::ofstream file(filePath);
+    if (!file)
+    {
+        return false;
+    }
+    char date[32];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+    file << "{\n  \"context\": {\"date\": \"" << date << "\", \"num_cpus\": " << std::thread::hardware_concurrency()
+        << ", \"library_build_type\": \"release\"},\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const auto& result = results[i];
+        file << "    {\"name\": \"" << result.name << "\", \"run_type\": \"iteration\", \"iterations\": " << result.numItems
+            << ", \"real_time\": " << result.nanosecsPerItem << ", \"cpu_time\": " << result.nanosecsPerItem
+            << ", \"min_time\": " << result.minNanosecsPerItem << ", \"time_unit\": \"ns\", \"items_per_second\": "
+            << 1e9 / result.nanosecsPerItem << ", \"samples\": [";
+        for (size_t j = 0; j < result.samples.size(); j++)
+        {
+            file << (j > 0 ? ", " : "") << result.samples[j];
+        }
+        file << "]}" << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    file << "  ]\n}\n";
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    const std::string resultsFilePath = argc > 1 ? argv[1] : DEFAULT_RESULTS_FILE;
+    auto serialJobs = std::make_unique<JobSystem>(0);
+    auto parallelJobs = std::make_unique<JobSystem>();
+
+    for (int numEntities: {1000, 10000, 100000})
+    {
+        BenchmarkEntities(numEntities);
+        BenchmarkComponents(numEntities);
+        BenchmarkSystems(numEntities, serialJobs, parallelJobs);
+    }
+    for (int numEntities: {1000, 10000, 100000, 1000000})
+    {
+        BenchmarkIntegration(numEntities, serialJobs, parallelJobs);
+    }
+    for (int numHandlers: {1, 8})
+    {
+        BenchmarkEvents(numHandlers);
+    }
+    for (int numEntities: {1000, 10000, 50000})
+    {
+        BenchmarkCollisions(numEntities);
+    }
+
+    if (!WriteResults(resultsFilePath))
+    {
+        std::cerr << "Unable to write the results to " << resultsFilePath << std::endl;
+        return 1;
+    }
+    std::cerr << results.size() << " benchmarks written to " << resultsFilePath << std::endl;
+    return 0;
+}
@@ -0,0 +1,288 @@
+#include "../src/ECS/ECS.h"
+#include "../src/EventBus/EventBus.h"
+#include "../src/Jobs/JobSystem.h"
+#include "../src/Components/TransformComponent.h"
+#include "../src/Components/RigidBodyComponent.h"
+#include "../src/Components/BoxColliderComponent.h"
+#include "../src/Systems/MovementSystem.h"
+#include "../src/Systems/CollisonSystem.h"
+#include "../src/Resources/TickTimeResource.h"
+#include "../src/Renderer/SpriteCullBatch.h"
+#include "../src/Renderer/SpriteBatch.h"
+#include "../src/Renderer/RenderQueue.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Scaling benchmark
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Usage: scalingbenchmark [--pinned] [--max N] [results.csv]
+// Sweeps the entity counts (1k to 1M, or N) and the threads (1, 2, 4... up to every core) over
+// the stages of a headless frame: the movement, the collisions with either broadphase, the
+// render preparation (cull, sort and batch) and the events queued from every thread. A job
+// system of threads - 1 workers runs each point, the calling thread takes part in its work.
+// Each point is run once untimed, then SCALING_REPETITIONS times and the median is kept.
+// The curves go to a CSV (ops per second, speedup and efficiency against the same stage on
+// one thread), the table to stderr. --pinned pins the workers one per core.
+/////////////////////////////////////////////////////////////////////////////////////////////
+const int SCALING_REPETITIONS = 5;
+const int DEFAULT_MAX_ENTITIES = 1000000;
+const double DELTA_TIME = 1.0 / 120.0;
+// Of the render preparation, about a screen of the world
+const SDL_FRect SCALING_CAMERA = {0.0f, 0.0f, 1920.0f, 1080.0f};
+const int NUM_DRAW_ORDERS = 8;
+const std::string DEFAULT_RESULTS_FILE = "./scalingbench.csv";
+
+struct ScalingResult
+{
+    std::string stage;
+    int numEntities;
+    int numThreads;
+    double millisecs;
+};
+
+std::vector<ScalingResult> results;
+
+// Keeps the compiler from dropping the measured work
+volatile double benchmarkSink;
+
+class ScalingEvent: public Event
+{
+public:
+    int value;
+    ScalingEvent(int value): value(value) {}
+};
+
+class ScalingListener
+{
+public:
+    double total = 0.0;
+    void OnEvent(ScalingEvent& event) { total += event.value; }
+};
+
+// What the render preparation keeps of a visible sprite, as the render system does
+struct ScalingSprite
+{
+    int entityId;
+    int drawOrder;
+    SDL_FRect dstRect;
+};
+
+// The entities of one size, set up once and shared by every thread count
+struct ScalingWorld
+{
+    std::unique_ptr<Registry> movers;
+    std::unique_ptr<Registry> colliders;
+    std::unique_ptr<EventBus> eventBus = std::make_unique<EventBus>();
+    ScalingListener listener;
+    EventSubscription subscription;
+    SpriteCullBatch cullBatch;
+    std::vector<int> visibleIndices;
+    std::vector<ScalingSprite> sprites;
+    std::vector<ScalingSprite> sortScratch;
+    RenderCommandList commandList;
+    SpriteBatch spriteBatch;
+};
+
+// Spread over an area growing with their number, so the density and the number of contacts
+// per entity stay the same at every size
+static glm::vec2 GetGridPosition(int index, int side, uint32_t& seed)
+{
+    seed = seed * 1664525u + 1013904223u;
+    const float jitter = static_cast<float>(seed >> 24);
+    return glm::vec2((index % side) * 40.0f + jitter / 8.0f, (index / side) * 40.0f + jitter / 16.0f);
+}
+
+static std::unique_ptr<ScalingWorld> CreateWorld(int numEntities)
+{
+    auto world = std::make_unique<ScalingWorld>();
+    const int side = static_cast<int>(std::sqrt(numEntities)) + 1;
+
+    world->movers = std::make_unique<Registry>(STORAGE_ARCHETYPE);
+    world->movers->AddSystem<MovementSystem>();
+    world->movers->SetResource<TickTimeResource>(DELTA_TIME);
+    Prefab mover;
+    mover.AddComponent<TransformComponent>().AddComponent<RigidBodyComponent>(glm::vec2(10.0, 5.0));
+    world->movers->Instantiate(mover, numEntities);
+    world->movers->Update();
+    uint32_t seed = 1;
+    int index = 0;
+    world->movers->View<TransformComponent>().Each([&](TransformComponent& transform)
+    {
+        transform.position = GetGridPosition(index++, side, seed);
+    });
+
+    world->colliders = std::make_unique<Registry>();
+    world->colliders->AddSystem<CollisionSystem>();
+    seed = 1;
+    for (int i = 0; i < numEntities; i++)
+    {
+        Entity entity = world->colliders->CreateEntity();
+        entity.AddComponent<TransformComponent>(GetGridPosition(i, side, seed));
+        entity.AddComponent<BoxColliderComponent>(32, 32);
+    }
+    world->colliders->Update();
+
+    world->subscription = world->eventBus->SubscribeToEvent<ScalingEvent>(&world->listener, &ScalingListener::OnEvent);
+    world->cullBatch.Reserve(numEntities);
+    return world;
+}
+
+static void Measure(const std::string& stage, int numEntities, int numThreads, const std::function<void()>& run)
+{
+    run();
+    std::vector<double> samples;
+    for (int i = 0; i < SCALING_REPETITIONS; i++)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        const auto end = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    results.push_back({stage, numEntities, numThreads, samples[samples.size() / 2]});
+    std::cerr << stage << "/" << numEntities << "/" << numThreads << " threads: " << samples[samples.size() / 2] << " ms" << std::endl;
+}
+
+static void MeasureStages(ScalingWorld& world, int numEntities, int numThreads, std::unique_ptr<JobSystem>& jobSystem)
+{
+    Measure("movement", numEntities, numThreads, [&world, &jobSystem]()
+    {
+        world.movers->GetSystem<MovementSystem>().Update(*world.movers, jobSystem);
+    });
+
+    for (auto mode: {BROADPHASE_SPATIAL_HASH, BROADPHASE_SWEEP_AND_PRUNE})
+    {
+        world.colliders->GetSystem<CollisionSystem>().SetBroadphaseMode(mode);
+        Measure(mode == BROADPHASE_SPATIAL_HASH ? "collision/spatialhash" : "collision/sweepandprune", numEntities, numThreads, [&world]()
+        {
+            world.colliders->GetSystem<CollisionSystem>().Update(*world.colliders, world.eventBus);
+            world.eventBus->ClearQueuedEvents();
+        });
+    }
+
+    // What the render system does with the sprites of a frame, without the asset lookups
+    Measure("renderprep", numEntities, numThreads, [&world]()
+    {
+        world.cullBatch.Clear();
+        world.movers->View<TransformComponent>().Each([&world](const TransformComponent& transform)
+        {
+            world.cullBatch.Add(transform.position, 32.0f, 32.0f, 0.0f);
+        });
+        world.visibleIndices.clear();
+        world.cullBatch.Cull(SCALING_CAMERA, world.visibleIndices);
+        world.sprites.clear();
+        for (auto index: world.visibleIndices)
+        {
+            world.sprites.push_back({index, index % NUM_DRAW_ORDERS, world.cullBatch.GetDstRect(index)});
+        }
+        RenderQueue::SortByDrawOrder(world.sprites, world.sortScratch);
+        world.commandList.Clear({0, 0, 0, 255});
+        world.spriteBatch.Begin(world.commandList);
+        for (const auto& sprite: world.sprites)
+        {
+            world.spriteBatch.Draw(nullptr, {0, 0, 32, 32}, sprite.dstRect, 0.0f);
+        }
+        world.spriteBatch.End();
+        benchmarkSink = world.spriteBatch.GetNumSprites();
+    });
+
+    // One event per entity, queued from every thread and dispatched on the calling one
+    Measure("events", numEntities, numThreads, [&world, &jobSystem, numEntities]()
+    {
+        jobSystem->ParallelFor(numEntities, DEFAULT_GRAIN_SIZE, [&world](int begin, int end)
+        {
+            for (int i = begin; i < end; i++)
+            {
+                world.eventBus->QueueEvent<ScalingEvent>(i);
+            }
+        });
+        world.eventBus->DispatchQueuedEvents();
+        benchmarkSink = world.listener.total;
+    });
+}
+
+static bool WriteResults(const std::string& filePath)
+{
+    std::ofstream file(filePath);
+    if (!file)
+    {
+        return false;
+    }
+    file << "stage,entities,threads,millisecs,ops_per_sec,speedup,efficiency\n";
+    for (const auto& result: results)
+    {
+        // Against the same stage and size on one thread, which the sweep measures first
+        double baseMillisecs = result.millisecs;
+        for (const auto& base: results)
+        {
+            if (base.stage == result.stage && base.numEntities == result.numEntities && base.numThreads == 1)
+            {
+                baseMillisecs = base.millisecs;
+                break;
+            }
+        }
+        const double speedup = baseMillisecs / result.millisecs;
+        file << result.stage << "," << result.numEntities << "," << result.numThreads << "," << result.millisecs << ","
+            << result.numEntities * 1000.0 / result.millisecs << "," << speedup << "," << speedup / result.numThreads << "\n";
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string resultsFilePath = DEFAULT_RESULTS_FILE;
+    int maxEntities = DEFAULT_MAX_ENTITIES;
+    bool isPinned = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--pinned") == 0)
+        {
+            isPinned = true;
+        }
+        else if (std::strcmp(argv[i], "--max") == 0 && i + 1 < argc)
+        {
+            maxEntities = std::atoi(argv[++i]);
+        }
+        else
+        {
+            resultsFilePath = argv[i];
+        }
+    }
+
+    // Doubling up to every core, the last one included whatever its number
+    const int numCores = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    std::vector<int> threadCounts;
+    for (int numThreads = 1; numThreads < numCores; numThreads *= 2)
+    {
+        threadCounts.push_back(numThreads);
+    }
+    threadCounts.push_back(numCores);
+
+    for (int numEntities = 1000; numEntities <= maxEntities; numEntities *= 10)
+    {
+        auto world = CreateWorld(numEntities);
+        for (int numThreads: threadCounts)
+        {
+            auto jobSystem = std::make_unique<JobSystem>(numThreads - 1, isPinned);
+            MeasureStages(*world, numEntities, numThreads, jobSystem);
+        }
+    }
+
+    if (!WriteResults(resultsFilePath))
+    {
+        std::cerr << "Unable to write the results to " << resultsFilePath << std::endl;
+        return 1;
+    }
+    std::cerr << results.size() << " points written to " << resultsFilePath << std::endl;
+    return 0;
+}
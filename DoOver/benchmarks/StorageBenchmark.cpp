@@ -0,0 +1,87 @@
+#include "../src/ECS/ECS.h"
+#include "../src/Components/TransformComponent.h"
+#include "../src/Components/RigidBodyComponent.h"
+#include "../src/Components/BoxColliderComponent.h"
+#include "../src/Systems/MovementSystem.h"
+#include "../src/Resources/TickTimeResource.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Storage benchmark
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Compares sparse-set pools against archetype chunks on our typical workload: 50k moving
+// entities (Transform + RigidBody, some with a collider) on top of a 500 tile background.
+// Results are written to stderr, stdout is left to the engine log.
+/////////////////////////////////////////////////////////////////////////////////////////////
+const int NUM_MOVING_ENTITIES = 50000;
+const int NUM_TILES = 500;
+const int NUM_FRAMES = 200;
+const double DELTA_TIME = 1.0 / 60.0;
+
+void PopulateRegistry(Registry& registry)
+{
+    for (int i = 0; i < NUM_TILES; i++)
+    {
+        Entity tile = registry.CreateEntity();
+        tile.AddComponent<TransformComponent>(glm::vec2(i * 128.0, 0.0));
+    }
+    for (int i = 0; i < NUM_MOVING_ENTITIES; i++)
+    {
+        Entity entity = registry.CreateEntity();
+        entity.AddComponent<TransformComponent>(glm::vec2(i, i));
+        entity.AddComponent<RigidBodyComponent>(glm::vec2(10.0, 5.0));
+        if (i % 4 == 0)
+        {
+            entity.AddComponent<BoxColliderComponent>(4, 4);
+        }
+    }
+    registry.Update();
+}
+
+template <typename TFunc>
+void Measure(const std::string& name, TFunc frame)
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < NUM_FRAMES; i++)
+    {
+        frame();
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+    const double millisecs = std::chrono::duration<double, std::milli>(end - start).count();
+    std::cerr << name << ": " << millisecs / NUM_FRAMES << " ms/frame" << std::endl;
+}
+
+void IntegrateView(Registry& registry)
+{
+    registry.View<TransformComponent, RigidBodyComponent>().Each([](TransformComponent& transform, RigidBodyComponent& rigidBody)
+    {
+        transform.position.x += rigidBody.velocity.x * DELTA_TIME;
+        transform.position.y += rigidBody.velocity.y * DELTA_TIME;
+    });
+}
+
+int main()
+{
+    Registry poolRegistry(STORAGE_POOL);
+    poolRegistry.AddSystem<MovementSystem>();
+    poolRegistry.SetResource<TickTimeResource>(DELTA_TIME);
+    PopulateRegistry(poolRegistry);
+
+    Registry archetypeRegistry(STORAGE_ARCHETYPE);
+    archetypeRegistry.AddSystem<MovementSystem>();
+    archetypeRegistry.SetResource<TickTimeResource>(DELTA_TIME);
+    PopulateRegistry(archetypeRegistry);
+
+    std::cerr << "Integrating " << NUM_MOVING_ENTITIES << " moving entities over " << NUM_FRAMES << " frames" << std::endl;
+    auto serialJobs = std::make_unique<JobSystem>(0);
+    auto parallelJobs = std::make_unique<JobSystem>();
+    Measure("pool, MovementSystem entity list", [&]() { poolRegistry.GetSystem<MovementSystem>().Update(poolRegistry, serialJobs); });
+    Measure("pool, MovementSystem ParallelEach (" + std::to_string(parallelJobs->GetNumWorkers()) + " workers)", [&]() { poolRegistry.GetSystem<MovementSystem>().Update(poolRegistry, parallelJobs); });
+    Measure("pool, Registry::View", [&]() { IntegrateView(poolRegistry); });
+    Measure("archetype, Registry::View", [&]() { IntegrateView(archetypeRegistry); });
+    Measure("archetype, MovementSystem " + std::string(Integration::GetKernelName(Integration::GetKernel())) + " kernel", [&]() { archetypeRegistry.GetSystem<MovementSystem>().Update(archetypeRegistry, serialJobs); });
+
+    return 0;
+}
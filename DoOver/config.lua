@@ -0,0 +1,48 @@
+-- The engine's performance knobs for this machine, the command line flags override them
+Config = {
+    -- Simulation ticks per second, 0 for the default of 120
+    tick_rate = 0,
+    -- Threads of the job system, 0 for one per core but the main thread's
+    workers = 0,
+    -- Each worker on a core of its own, leaving the first one to the main thread (Linux only)
+    pin_workers = false,
+    -- Of the spatial hash of the moving colliders, about the size of the common boxes
+    broadphase_cell_size = 64,
+    -- Retune the cell size from the collider sizes and pair tests, or switch to sweep and
+    -- prune when they spread too widely, the cell size above is only the starting point
+    broadphase_autotune = true,
+    -- Seconds between two sorts of the stored components by where the entities are, so the
+    -- ones close by are close in memory, 0 never sorts them
+    spatial_sort_seconds = 10,
+    -- Components each pool has room for before it grows
+    pool_reserve = 100,
+    -- Megabytes of video memory the streamed textures page their whole images into
+    texture_stream_budget = 64,
+    -- trace, debug, info, warning or error, no lower than the build compiles in
+    log_level = "trace",
+    -- auto, opengl, opengles, direct3d, metal or software
+    renderer = "auto",
+    -- vsync, adaptive or uncapped, fps caps the frame rate, 0 leaves it to the vsync
+    present = "vsync",
+    fps = 60,
+    -- Borderless over the whole display, or a window of this size
+    fullscreen = true,
+    window_width = 1280,
+    window_height = 720,
+    -- The frames of a taller window are drawn at this height and stretched, 0 for its own
+    render_height = 1080,
+    -- Draws fewer pixels while the frames take longer than the frame time to render
+    dynamic_resolution = false,
+    -- Draws the tiles on screen straight from the tileset, the whole map in one draw, instead
+    -- of baking it into chunk textures
+    direct_tilemap = false,
+    -- Simulates the next frame while this one is submitted, faster on several cores but each
+    -- frame is shown a frame later
+    pipeline_frames = true,
+    -- The same simulation whatever the number of workers, and a checksum of each tick in the
+    -- input recordings that their replays check
+    deterministic = false,
+    -- The last 10 seconds of frame times, profiler scopes, events and input, written there on
+    -- a crash, "" for none
+    flight_recorder = "./flightrecorder.csv"
+}
@@ -0,0 +1,64 @@
+#include "AnimationClip.h"
+#include "../Logger/Logger.h"
+#include <algorithm>
+#include <limits>
+
+int AnimationLibrary::AddClip(const AnimationClip& clip)
+{
+    AnimationClip addedClip = clip;
+    if (addedClip.frames.empty())
+    {
+        Logger::War("Animation clip " + clip.name + " has no frames, it shows nothing");
+        addedClip.frames.push_back({{0, 0, 0, 0}, std::numeric_limits<uint32_t>::max(), NO_ANIMATION_MARKER});
+    }
+    addedClip.durationMicrosecs = 0;
+    for (auto& frame: addedClip.frames)
+    {
+        // A frame of no time would never let the playback move on
+        if (frame.durationMicrosecs == 0)
+        {
+            frame.durationMicrosecs = 1;
+        }
+        addedClip.durationMicrosecs += frame.durationMicrosecs;
+    }
+
+    auto clipHandle = clipHandles.find(addedClip.name);
+    if (clipHandle != clipHandles.end())
+    {
+        clips[clipHandle->second] = std::move(addedClip);
+        return clipHandle->second;
+    }
+    const int handle = static_cast<int>(clips.size());
+    clipHandles.emplace(addedClip.name, handle);
+    clips.push_back(std::move(addedClip));
+    return handle;
+}
+
+int AnimationLibrary::FindClip(const std::string& name) const
+{
+    auto clipHandle = clipHandles.find(name);
+    return clipHandle != clipHandles.end() ? clipHandle->second : INVALID_ANIMATION_CLIP;
+}
+
+int AnimationLibrary::GetStripClip(int numFrames, int frameSpeedRate, bool isLoop, const SDL_Rect& firstFrame)
+{
+    const std::string name = "strip:" + std::to_string(numFrames) + ":" + std::to_string(frameSpeedRate) + ":" + std::to_string(isLoop) + ":" +
+        std::to_string(firstFrame.x) + ":" + std::to_string(firstFrame.y) + ":" + std::to_string(firstFrame.w) + ":" + std::to_string(firstFrame.h);
+    const int handle = FindClip(name);
+    if (handle != INVALID_ANIMATION_CLIP)
+    {
+        return handle;
+    }
+
+    AnimationClip clip;
+    clip.name = name;
+    clip.isLoop = isLoop;
+    // The frame speed rate is in frames per second, no rate holds the first frame
+    const uint32_t frameDuration = frameSpeedRate > 0 ? 1000000 / frameSpeedRate : std::numeric_limits<uint32_t>::max();
+    for (int i = 0; i < std::max(numFrames, 1); i++)
+    {
+        const SDL_Rect srcRect = {firstFrame.x + i * firstFrame.w, firstFrame.y, firstFrame.w, firstFrame.h};
+        clip.frames.push_back({srcRect, frameDuration, NO_ANIMATION_MARKER});
+    }
+    return AddClip(clip);
+}
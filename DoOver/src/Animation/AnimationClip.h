@@ -0,0 +1,57 @@
+#ifndef ANIMATIONCLIP_H
+#define ANIMATIONCLIP_H
+
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+const int NO_ANIMATION_MARKER = -1;
+const int INVALID_ANIMATION_CLIP = -1;
+
+struct AnimationFrame
+{
+    // Rectangle of the frame in the sprite texture, the renderer adds the atlas offset
+    SDL_Rect srcRect;
+    uint32_t durationMicrosecs;
+    // Queued as an AnimationMarkerEvent when the frame starts, the game gives the ids a meaning
+    int marker;
+};
+
+struct AnimationClip
+{
+    std::string name;
+    std::vector<AnimationFrame> frames;
+    bool isLoop = true;
+    // Sum of the frame durations, set by the library
+    uint64_t durationMicrosecs = 0;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Animation library
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The clips the animation components play, referenced by handle. Everything about a frame
+// is worked out when the clip is added, so playing it is an integer step and a lookup.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class AnimationLibrary
+{
+private:
+    std::vector<AnimationClip> clips;
+    // [clip name] -> handle
+    std::unordered_map<std::string, int> clipHandles;
+
+public:
+    // Replaces the clip of the same name, the components playing it keep their handle
+    int AddClip(const AnimationClip& clip);
+    int FindClip(const std::string& name) const;
+
+    // A clip of frames side by side in a row of the texture, starting at the first one, which
+    // is how the level animations are laid out. Shared by all the animations alike.
+    int GetStripClip(int numFrames, int frameSpeedRate, bool isLoop, const SDL_Rect& firstFrame);
+
+    const AnimationClip& GetClip(int clip) const { return clips[clip]; }
+    int GetNumClips() const { return static_cast<int>(clips.size()); }
+};
+
+#endif
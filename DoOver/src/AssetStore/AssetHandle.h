@@ -0,0 +1,18 @@
+#ifndef ASSETHANDLE_H
+#define ASSETHANDLE_H
+
+#include <string>
+
+// Compact id of an asset, resolved once from its string id so the hot paths index vectors
+// instead of comparing strings. The same string always gets the same handle.
+typedef int AssetHandle;
+
+// Handle of the empty asset id
+const AssetHandle INVALID_ASSET_HANDLE = 0;
+
+AssetHandle GetAssetHandle(const std::string& assetId);
+std::string GetAssetId(AssetHandle assetHandle);
+// Handles given so far, they run from 0 to the count
+int GetNumAssetHandles();
+
+#endif
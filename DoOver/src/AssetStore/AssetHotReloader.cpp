@@ -0,0 +1,125 @@
+#include "./AssetHotReloader.h"
+
+#ifdef ASSET_HOT_RELOAD
+
+#include "../Logger/Logger.h"
+#include <SDL2/SDL_image.h>
+#include <sys/stat.h>
+#include <chrono>
+
+static bool GetFileStatus(const std::string& filePath, time_t& lastWriteTime, long long& size)
+{
+    struct stat fileStat;
+    if (stat(filePath.c_str(), &fileStat) != 0)
+    {
+        return false;
+    }
+    lastWriteTime = fileStat.st_mtime;
+    size = fileStat.st_size;
+    return true;
+}
+
+AssetHotReloader::AssetHotReloader()
+{
+    Logger::Log("AssetHotReloader constructor called!");
+}
+
+AssetHotReloader::~AssetHotReloader()
+{
+    if (isRunning)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            isRunning = false;
+        }
+        stopCondition.notify_all();
+        watcher.join();
+    }
+    for (auto& file: reloadedFiles)
+    {
+        SDL_FreeSurface(file.surface);
+    }
+    Logger::Log("AssetHotReloader destructor called!");
+}
+
+void AssetHotReloader::WatchFile(const std::string& filePath, AssetHandle assetHandle)
+{
+    WatchedFile watchedFile = {filePath, assetHandle, 0, 0};
+    GetFileStatus(filePath, watchedFile.lastWriteTime, watchedFile.size);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& file: watchedFiles)
+        {
+            if (file.filePath == filePath && file.assetHandle == assetHandle)
+            {
+                return;
+            }
+        }
+        watchedFiles.push_back(watchedFile);
+    }
+
+    // The thread only exists once something is watched
+    if (!isRunning)
+    {
+        isRunning = true;
+        watcher = std::thread(&AssetHotReloader::Watch, this);
+    }
+}
+
+void AssetHotReloader::TakeReloadedFiles(std::vector<ReloadedFile>& files)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    files.insert(files.end(), reloadedFiles.begin(), reloadedFiles.end());
+    reloadedFiles.clear();
+}
+
+void AssetHotReloader::Watch()
+{
+    std::vector<WatchedFile> files;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            stopCondition.wait_for(lock, std::chrono::milliseconds(HOT_RELOAD_POLL_MILLISECS), [this]() { return !isRunning; });
+            if (!isRunning)
+            {
+                return;
+            }
+            files = watchedFiles;
+        }
+
+        for (auto& file: files)
+        {
+            time_t lastWriteTime;
+            long long size;
+            if (!GetFileStatus(file.filePath, lastWriteTime, size) || (lastWriteTime == file.lastWriteTime && size == file.size))
+            {
+                continue;
+            }
+
+            // Decoding can fail while an editor is still writing the file, it is retried next poll
+            SDL_Surface* surface = nullptr;
+            if (file.assetHandle != INVALID_ASSET_HANDLE)
+            {
+                surface = IMG_Load(file.filePath.c_str());
+                if (!surface)
+                {
+                    continue;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto& watchedFile: watchedFiles)
+            {
+                if (watchedFile.filePath == file.filePath && watchedFile.assetHandle == file.assetHandle)
+                {
+                    watchedFile.lastWriteTime = lastWriteTime;
+                    watchedFile.size = size;
+                }
+            }
+            reloadedFiles.push_back({file.filePath, file.assetHandle, surface});
+        }
+    }
+}
+
+#endif
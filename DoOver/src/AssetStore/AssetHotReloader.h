@@ -0,0 +1,71 @@
+#ifndef ASSETHOTRELOADER_H
+#define ASSETHOTRELOADER_H
+
+#include "AssetHandle.h"
+#include <SDL2/SDL.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <ctime>
+
+// Hot reload is compiled in unless NDEBUG is defined (make release)
+#ifndef NDEBUG
+#define ASSET_HOT_RELOAD
+#endif
+
+#ifdef ASSET_HOT_RELOAD
+
+// How often the watcher thread looks at the files
+const int HOT_RELOAD_POLL_MILLISECS = 250;
+
+// A watched file that changed, images come decoded
+struct ReloadedFile
+{
+    std::string filePath;
+    AssetHandle assetHandle;
+    SDL_Surface* surface;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Asset hot reloader
+/////////////////////////////////////////////////////////////////////////////////////////////
+// A thread polls the modification time of the watched files. Changed images are decoded on
+// that thread, and handed to the main thread which swaps them in at the frame boundary.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class AssetHotReloader
+{
+private:
+    struct WatchedFile
+    {
+        std::string filePath;
+        AssetHandle assetHandle;
+        time_t lastWriteTime;
+        long long size;
+    };
+
+    std::thread watcher;
+    std::atomic<bool> isRunning{false};
+    std::mutex mutex;
+    std::condition_variable stopCondition;
+    std::vector<WatchedFile> watchedFiles;
+    std::vector<ReloadedFile> reloadedFiles;
+
+    void Watch();
+
+public:
+    AssetHotReloader();
+    ~AssetHotReloader();
+
+    // Files without an asset handle (INVALID_ASSET_HANDLE) are reported without decoding
+    void WatchFile(const std::string& filePath, AssetHandle assetHandle);
+
+    // Moves out the files changed since the last call, the caller frees the surfaces
+    void TakeReloadedFiles(std::vector<ReloadedFile>& files);
+};
+
+#endif
+
+#endif
@@ -0,0 +1,107 @@
+#include "./AssetPack.h"
+#include "../Logger/Logger.h"
+#include <cstring>
+#include <fstream>
+
+std::string NormalizeAssetPackPath(const std::string& path)
+{
+    std::string normalized = path;
+    for (auto& ch: normalized)
+    {
+        if (ch == '\\')
+        {
+            ch = '/';
+        }
+    }
+    while (normalized.compare(0, 2, "./") == 0)
+    {
+        normalized.erase(0, 2);
+    }
+    return normalized;
+}
+
+AssetPack::AssetPack()
+{
+    Logger::Log("AssetPack constructor called!");
+}
+
+AssetPack::~AssetPack()
+{
+    Close();
+    Logger::Log("AssetPack destructor called!");
+}
+
+bool AssetPack::Open(const std::string& packFilePath)
+{
+    Close();
+
+    if (!file.Open(packFilePath) && !std::ifstream(packFilePath).good())
+    {
+        return false;
+    }
+    const uint8_t* data = file.GetData();
+    const size_t size = file.GetSize();
+
+    if (!data || size < sizeof(AssetPackHeader))
+    {
+        Logger::Err("Unable to map the asset pack " + packFilePath);
+        Close();
+        return false;
+    }
+
+    const auto* header = reinterpret_cast<const AssetPackHeader*>(data);
+    const size_t tableEnd = sizeof(AssetPackHeader) + static_cast<size_t>(header->numEntries) * sizeof(AssetPackEntry);
+    if (std::memcmp(header->magic, ASSET_PACK_MAGIC, sizeof(ASSET_PACK_MAGIC)) != 0 || header->version != ASSET_PACK_VERSION || tableEnd > size)
+    {
+        Logger::Err("The asset pack " + packFilePath + " is invalid or was built by another version, rebuild it with make pack");
+        Close();
+        return false;
+    }
+
+    const auto* table = reinterpret_cast<const AssetPackEntry*>(data + sizeof(AssetPackHeader));
+    for (uint32_t i = 0; i < header->numEntries; i++)
+    {
+        const AssetPackEntry& entry = table[i];
+        if (entry.offset + entry.size > size)
+        {
+            Logger::Err("The asset pack " + packFilePath + " is truncated");
+            Close();
+            return false;
+        }
+        entries.emplace(std::string(entry.path, strnlen(entry.path, ASSET_PACK_MAX_PATH)), &entry);
+    }
+
+    Logger::Log("Asset pack " + packFilePath + " mapped with " + std::to_string(entries.size()) + " entries");
+    return true;
+}
+
+void AssetPack::Close()
+{
+    entries.clear();
+    file.Close();
+}
+
+bool AssetPack::IsOpen() const
+{
+    return file.IsOpen();
+}
+
+const AssetPackEntry* AssetPack::FindEntry(const std::string& filePath) const
+{
+    if (entries.empty())
+    {
+        return nullptr;
+    }
+    auto entry = entries.find(NormalizeAssetPackPath(filePath));
+    return entry != entries.end() ? entry->second : nullptr;
+}
+
+const uint8_t* AssetPack::GetData(const AssetPackEntry& entry) const
+{
+    return file.GetData() + entry.offset;
+}
+
+int AssetPack::GetNumEntries() const
+{
+    return entries.size();
+}
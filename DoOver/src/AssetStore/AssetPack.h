@@ -0,0 +1,82 @@
+#ifndef ASSETPACK_H
+#define ASSETPACK_H
+
+#include "../Memory/MappedFile.h"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Asset pack
+/////////////////////////////////////////////////////////////////////////////////////////////
+// A single file holding the assets, built by tools/AssetPacker.cpp (make pack):
+//   header | entry table | data
+// Entries are keyed by the asset file path, so loading "./assets/images/tank.png" finds the
+// packed copy without changing the callers. Images are stored decoded as RGBA32, or in 16
+// bit texels when packed with --compact, and read straight from the memory mapping, the
+// other files (e.g. .map) are stored as they are. The mapping is shared, the processes
+// running the game on a machine read the pack from the same pages.
+/////////////////////////////////////////////////////////////////////////////////////////////
+const char ASSET_PACK_MAGIC[4] = {'D', 'O', 'P', 'K'};
+const uint32_t ASSET_PACK_VERSION = 2;
+const int ASSET_PACK_MAX_PATH = 112;
+// Entry data is aligned so the pixels can be uploaded from the mapping as they are
+const int ASSET_PACK_ALIGNMENT = 16;
+
+enum AssetPackEntryType
+{
+    ASSET_PACK_RAW = 0,
+    ASSET_PACK_IMAGE_RGBA32 = 1,
+    // Half the size, a format the GPU samples as it is when the renderer supports it:
+    // opaque images keep 5-6-5 bits of color, cut out ones a 1 bit alpha, the others 4 bits
+    ASSET_PACK_IMAGE_RGB565 = 2,
+    ASSET_PACK_IMAGE_ARGB1555 = 3,
+    ASSET_PACK_IMAGE_ARGB4444 = 4
+};
+
+struct AssetPackHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t numEntries;
+    uint32_t reserved;
+};
+
+struct AssetPackEntry
+{
+    char path[ASSET_PACK_MAX_PATH];
+    uint32_t type;
+    uint32_t width;
+    uint32_t height;
+    uint32_t pitch;
+    uint64_t offset;
+    uint64_t size;
+};
+
+// "./assets/x.png" and "assets/x.png" are the same entry
+std::string NormalizeAssetPackPath(const std::string& path);
+
+class AssetPack
+{
+private:
+    MappedFile file;
+
+    std::unordered_map<std::string, const AssetPackEntry*> entries;
+
+public:
+    AssetPack();
+    ~AssetPack();
+
+    // Maps the whole pack in memory, returns false if it is missing or invalid
+    bool Open(const std::string& packFilePath);
+    void Close();
+    bool IsOpen() const;
+
+    // Entry for the asset file, or nullptr when it was not packed
+    const AssetPackEntry* FindEntry(const std::string& filePath) const;
+    const uint8_t* GetData(const AssetPackEntry& entry) const;
+    int GetNumEntries() const;
+};
+
+#endif
@@ -1,6 +1,80 @@
 #include "./AssetStore.h"
 #include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
 #include <SDL2/SDL_image.h>
+#include <SDL2/SDL_ttf.h>
+
+// Our own copy of the packer imgui vendors, static so it never clashes with imgui's
+#define STB_RECT_PACK_IMPLEMENTATION
+#define STBRP_STATIC
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
+#include "../../libs/imgui/imstb_rectpack.h"
+#pragma GCC diagnostic pop
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Asset handles
+/////////////////////////////////////////////////////////////////////////////////////////////
+struct AssetHandleTable
+{
+    std::mutex mutex;
+    std::unordered_map<std::string, AssetHandle> handles;
+    std::vector<std::string> assetIds;
+
+    AssetHandleTable()
+    {
+        handles.emplace("", INVALID_ASSET_HANDLE);
+        assetIds.push_back("");
+    }
+};
+
+// Components may be created during static initialization, so the table is a function-local static
+static AssetHandleTable& GetAssetHandleTable()
+{
+    static AssetHandleTable table;
+    return table;
+}
+
+AssetHandle GetAssetHandle(const std::string& assetId)
+{
+    auto& table = GetAssetHandleTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    auto handle = table.handles.find(assetId);
+    if (handle != table.handles.end())
+    {
+        return handle->second;
+    }
+    const AssetHandle newHandle = table.assetIds.size();
+    table.handles.emplace(assetId, newHandle);
+    table.assetIds.push_back(assetId);
+    return newHandle;
+}
+
+std::string GetAssetId(AssetHandle assetHandle)
+{
+    auto& table = GetAssetHandleTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    if (assetHandle < 0 || assetHandle >= static_cast<int>(table.assetIds.size()))
+    {
+        return "";
+    }
+    return table.assetIds[assetHandle];
+}
+
+int GetNumAssetHandles()
+{
+    auto& table = GetAssetHandleTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    return table.assetIds.size();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Asset store
+/////////////////////////////////////////////////////////////////////////////////////////////
 
 AssetStore::AssetStore()
 {
@@ -15,26 +89,1017 @@ AssetStore::~AssetStore()
 
 void AssetStore::ClearAssets()
 {
+    generation++;
+    {
+        std::lock_guard<std::mutex> lock(decodedImagesMutex);
+        for (auto& decodedImage: decodedImages)
+        {
+            SDL_FreeSurface(decodedImage.surface);
+        }
+        decodedImages.clear();
+    }
+
     for (auto texture: textures)
     {
-        SDL_DestroyTexture(texture.second);
+        SDL_DestroyTexture(texture);
     }
     textures.clear();
+
+    for (auto page: atlasPages)
+    {
+        SDL_DestroyTexture(page);
+    }
+    atlasPages.clear();
+    regions.clear();
+    fonts.clear();
+    records.clear();
+    scopes.clear();
+
+    for (auto& pending: pendingAtlasSurfaces)
+    {
+        SDL_FreeSurface(pending.second);
+    }
+    pendingAtlasSurfaces.clear();
+
+    for (auto& streamed: streamedTextures)
+    {
+        SDL_DestroyTexture(streamed.placeholder);
+        SDL_DestroyTexture(streamed.texture);
+    }
+    streamedTextures.clear();
+    textureUseFrames.clear();
+    numStreamedBytes = 0;
+
+    for (auto sound: sounds)
+    {
+        if (sound)
+        {
+            Mix_FreeChunk(sound);
+        }
+    }
+    sounds.clear();
+}
+
+bool AssetStore::MountPack(const std::string& packFilePath)
+{
+    if (!pack.Open(packFilePath))
+    {
+        Logger::War("No asset pack at " + packFilePath + ", loading the loose asset files");
+        return false;
+    }
+    return true;
+}
+
+bool AssetStore::GetPackedFile(const std::string& filePath, const char*& data, size_t& size) const
+{
+    const AssetPackEntry* entry = pack.FindEntry(filePath);
+    if (!entry || entry->type != ASSET_PACK_RAW)
+    {
+        return false;
+    }
+    data = reinterpret_cast<const char*>(pack.GetData(*entry));
+    size = entry->size;
+    return true;
+}
+
+// The texel format of a packed image, 0 for the other entries
+static Uint32 GetPackedImageFormat(uint32_t type)
+{
+    switch (type)
+    {
+    case ASSET_PACK_IMAGE_RGBA32: return SDL_PIXELFORMAT_RGBA32;
+    case ASSET_PACK_IMAGE_RGB565: return SDL_PIXELFORMAT_RGB565;
+    case ASSET_PACK_IMAGE_ARGB1555: return SDL_PIXELFORMAT_ARGB1555;
+    case ASSET_PACK_IMAGE_ARGB4444: return SDL_PIXELFORMAT_ARGB4444;
+    default: return 0;
+    }
+}
+
+SDL_Surface* AssetStore::LoadSurface(const std::string& filePath) const
+{
+    // Packed images are already decoded, the surface only wraps the mapped pixels. The texture
+    // made from it keeps their format when the renderer has it, the 16 bit ones take half the
+    // video memory.
+    const AssetPackEntry* entry = pack.FindEntry(filePath);
+    const Uint32 format = entry ? GetPackedImageFormat(entry->type) : 0;
+    if (format != 0)
+    {
+        void* pixels = const_cast<uint8_t*>(pack.GetData(*entry));
+        return SDL_CreateRGBSurfaceWithFormatFrom(pixels, entry->width, entry->height, SDL_BITSPERPIXEL(format), entry->pitch, format);
+    }
+    return IMG_Load(filePath.c_str());
+}
+
+SDL_Surface* AssetStore::LoadDirectionalSurface(const std::string& filePath) const
+{
+    const size_t placeholder = filePath.find(TEXTURE_DIRECTION_PLACEHOLDER);
+    if (placeholder == std::string::npos)
+    {
+        Logger::Err("The directional image " + filePath + " has no " + TEXTURE_DIRECTION_PLACEHOLDER + " in its name");
+        return nullptr;
+    }
+
+    SDL_Surface* directionalSurface = nullptr;
+    for (int direction = 0; direction < NUM_TEXTURE_DIRECTIONS; direction++)
+    {
+        const std::string directionFilePath = std::string(filePath).replace(placeholder, TEXTURE_DIRECTION_PLACEHOLDER.size(), TEXTURE_DIRECTION_NAMES[direction]);
+        SDL_Surface* surface = LoadSurface(directionFilePath);
+        if (!surface)
+        {
+            Logger::Err("Unable to load the image " + directionFilePath + ": " + SDL_GetError());
+            SDL_FreeSurface(directionalSurface);
+            return nullptr;
+        }
+        // Sized after the first direction, the others are cut to the same rectangle
+        if (!directionalSurface)
+        {
+            directionalSurface = SDL_CreateRGBSurfaceWithFormat(0, surface->w, surface->h * NUM_TEXTURE_DIRECTIONS, 32, SDL_PIXELFORMAT_RGBA32);
+        }
+        const int frameHeight = directionalSurface->h / NUM_TEXTURE_DIRECTIONS;
+        // Copied as they are, the transparent texels stay transparent
+        SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+        SDL_Rect srcRect = {0, 0, std::min(surface->w, directionalSurface->w), std::min(surface->h, frameHeight)};
+        SDL_Rect dstRect = {0, direction * frameHeight, srcRect.w, srcRect.h};
+        SDL_BlitSurface(surface, &srcRect, directionalSurface, &dstRect);
+        SDL_FreeSurface(surface);
+    }
+    return directionalSurface;
 }
 
 void AssetStore::AddTexture(SDL_Renderer* renderer, const std::string& assetId, const std::string& filePath)
 {
-    SDL_Surface* surface = IMG_Load(filePath.c_str());
+    if (!AcquireAsset(GetAssetHandle(assetId)))
+    {
+        return;
+    }
+    WatchAsset(GetAssetHandle(assetId), filePath);
+
+    SDL_Surface* surface = LoadSurface(filePath);
     SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
     SDL_FreeSurface(surface);
 
-    // Add the texture to the map
-    textures.emplace(assetId, texture);
+    // Add the texture to the store
+    textures.push_back(texture);
+
+    TextureRegion region;
+    region.texture = texture;
+    SDL_QueryTexture(texture, NULL, NULL, &region.rect.w, &region.rect.h);
+    SetTextureRegion(GetAssetHandle(assetId), region);
 
     Logger::Log("New texture added to the Asset Store with id = " + assetId);
 }
 
+void AssetStore::AddSound(const std::string& assetId, const std::string& filePath)
+{
+    const AssetHandle assetHandle = GetAssetHandle(assetId);
+    if (!AcquireAsset(assetHandle))
+    {
+        return;
+    }
+
+    // Packed sounds are kept as their files, the mixer decodes them from the mapping
+    const char* data;
+    size_t size;
+    Mix_Chunk* sound = GetPackedFile(filePath, data, size)
+        ? Mix_LoadWAV_RW(SDL_RWFromConstMem(data, static_cast<int>(size)), 1)
+        : Mix_LoadWAV(filePath.c_str());
+    if (!sound)
+    {
+        Logger::Err("Unable to load the sound " + filePath + ": " + Mix_GetError());
+        return;
+    }
+    if (assetHandle >= static_cast<int>(sounds.size()))
+    {
+        sounds.resize(assetHandle + 1, nullptr);
+    }
+    sounds[assetHandle] = sound;
+    Logger::Log("New sound added to the Asset Store with id = " + assetId);
+}
+
+Mix_Chunk* AssetStore::GetSound(AssetHandle assetHandle) const
+{
+    if (assetHandle < 0 || assetHandle >= static_cast<int>(sounds.size()))
+    {
+        return nullptr;
+    }
+    return sounds[assetHandle];
+}
+
+void AssetStore::AddFont(SDL_Renderer* renderer, const std::string& assetId, const std::string& filePath, int fontSize)
+{
+    const AssetHandle assetHandle = GetAssetHandle(assetId);
+    if (!AcquireAsset(assetHandle))
+    {
+        return;
+    }
+    const char* data;
+    size_t size;
+    TTF_Font* font = GetPackedFile(filePath, data, size)
+        ? TTF_OpenFontRW(SDL_RWFromConstMem(data, static_cast<int>(size)), 1, fontSize)
+        : TTF_OpenFont(filePath.c_str(), fontSize);
+    if (!font)
+    {
+        Logger::Err("Unable to load the font " + filePath + ": " + TTF_GetError());
+        return;
+    }
+
+    // Each glyph is rendered in its cell, from the pen position on the top of the line, so
+    // the quads line up without the glyph metrics. The blank ones only advance.
+    FontAtlas atlas;
+    atlas.lineHeight = TTF_FontLineSkip(font);
+    const int numGlyphs = FONT_LAST_CHARACTER - FONT_FIRST_CHARACTER + 1;
+    std::vector<SDL_Surface*> surfaces(numGlyphs, nullptr);
+    std::vector<stbrp_rect> rects;
+    for (int i = 0; i < numGlyphs; i++)
+    {
+        const Uint16 character = FONT_FIRST_CHARACTER + i;
+        int minX, maxX, minY, maxY, advance;
+        if (!TTF_GlyphIsProvided(font, character) || TTF_GlyphMetrics(font, character, &minX, &maxX, &minY, &maxY, &advance) != 0)
+        {
+            continue;
+        }
+        atlas.glyphs[i].advance = advance;
+        if (maxX <= minX || maxY <= minY)
+        {
+            continue;
+        }
+        surfaces[i] = TTF_RenderGlyph_Blended(font, character, {255, 255, 255, 255});
+        if (surfaces[i])
+        {
+            stbrp_rect rect;
+            rect.id = i;
+            rect.w = surfaces[i]->w + 2 * ATLAS_PADDING;
+            rect.h = surfaces[i]->h + 2 * ATLAS_PADDING;
+            rect.was_packed = 0;
+            rects.push_back(rect);
+        }
+    }
+    TTF_CloseFont(font);
+
+    int atlasSize = FONT_ATLAS_MIN_SIZE;
+    bool isPacked = false;
+    while (!isPacked && atlasSize <= FONT_ATLAS_MAX_SIZE)
+    {
+        std::vector<stbrp_node> nodes(atlasSize);
+        stbrp_context context;
+        stbrp_init_target(&context, atlasSize, atlasSize, nodes.data(), nodes.size());
+        isPacked = stbrp_pack_rects(&context, rects.data(), rects.size()) != 0;
+        atlasSize *= isPacked ? 1 : 2;
+    }
+    if (!isPacked)
+    {
+        Logger::Err("The glyphs of the font " + filePath + " at size " + std::to_string(fontSize) + " don't fit an atlas");
+        for (auto surface: surfaces)
+        {
+            SDL_FreeSurface(surface);
+        }
+        return;
+    }
+
+    SDL_Surface* atlasSurface = SDL_CreateRGBSurfaceWithFormat(0, atlasSize, atlasSize, 32, SDL_PIXELFORMAT_RGBA32);
+    for (const auto& rect: rects)
+    {
+        SDL_Surface* surface = surfaces[rect.id];
+        SDL_Rect dstRect = {rect.x + ATLAS_PADDING, rect.y + ATLAS_PADDING, surface->w, surface->h};
+        SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+        SDL_BlitSurface(surface, NULL, atlasSurface, &dstRect);
+        atlas.glyphs[rect.id].srcRect = dstRect;
+        SDL_FreeSurface(surface);
+    }
+    atlas.texture = SDL_CreateTextureFromSurface(renderer, atlasSurface);
+    SDL_SetTextureBlendMode(atlas.texture, SDL_BLENDMODE_BLEND);
+    SDL_FreeSurface(atlasSurface);
+    textures.push_back(atlas.texture);
+
+    if (assetHandle >= static_cast<int>(fonts.size()))
+    {
+        fonts.resize(assetHandle + 1);
+    }
+    fonts[assetHandle] = atlas;
+    Logger::Log("New font added to the Asset Store with id = " + assetId + ", " + std::to_string(rects.size()) + " glyphs in a " + std::to_string(atlasSize) + " atlas");
+}
+
+const FontAtlas* AssetStore::GetFont(AssetHandle assetHandle) const
+{
+    if (assetHandle < 0 || assetHandle >= static_cast<int>(fonts.size()) || !fonts[assetHandle].texture)
+    {
+        return nullptr;
+    }
+    return &fonts[assetHandle];
+}
+
+void AssetStore::AddAtlasTexture(const std::string& assetId, const std::string& filePath)
+{
+    if (!AcquireAsset(GetAssetHandle(assetId)))
+    {
+        return;
+    }
+    WatchAsset(GetAssetHandle(assetId), filePath);
+
+    SDL_Surface* surface = LoadSurface(filePath);
+    if (!surface)
+    {
+        Logger::Err("Unable to load the image " + filePath + ": " + SDL_GetError());
+        return;
+    }
+    pendingAtlasSurfaces.emplace_back(GetAssetHandle(assetId), surface);
+}
+
+void AssetStore::BuildAtlas(SDL_Renderer* renderer)
+{
+    if (pendingAtlasSurfaces.empty())
+    {
+        return;
+    }
+
+    std::vector<stbrp_rect> rects(pendingAtlasSurfaces.size());
+    for (int i = 0; i < static_cast<int>(rects.size()); i++)
+    {
+        rects[i].id = i;
+        rects[i].w = pendingAtlasSurfaces[i].second->w + 2 * ATLAS_PADDING;
+        rects[i].h = pendingAtlasSurfaces[i].second->h + 2 * ATLAS_PADDING;
+        rects[i].was_packed = 0;
+    }
+
+    // Fill pages until every image is packed, or the remaining ones never fit a page
+    std::vector<stbrp_node> nodes(ATLAS_PAGE_SIZE);
+    std::vector<stbrp_rect> remaining = rects;
+    while (!remaining.empty())
+    {
+        stbrp_context context;
+        stbrp_init_target(&context, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, nodes.data(), nodes.size());
+        stbrp_pack_rects(&context, remaining.data(), remaining.size());
+
+        SDL_Surface* pageSurface = SDL_CreateRGBSurfaceWithFormat(0, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, 32, SDL_PIXELFORMAT_RGBA32);
+        std::vector<stbrp_rect> unpacked;
+        std::vector<int> packedIds;
+        for (const auto& rect: remaining)
+        {
+            if (!rect.was_packed)
+            {
+                unpacked.push_back(rect);
+                continue;
+            }
+            SDL_Surface* surface = pendingAtlasSurfaces[rect.id].second;
+            SDL_Rect dstRect = {rect.x + ATLAS_PADDING, rect.y + ATLAS_PADDING, surface->w, surface->h};
+            SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+            SDL_BlitSurface(surface, NULL, pageSurface, &dstRect);
+            packedIds.push_back(rect.id);
+
+            TextureRegion region;
+            region.rect = dstRect;
+            SetTextureRegion(pendingAtlasSurfaces[rect.id].first, region);
+        }
+
+        if (packedIds.empty())
+        {
+            SDL_FreeSurface(pageSurface);
+            for (const auto& rect: unpacked)
+            {
+                Logger::War("The image " + GetAssetId(pendingAtlasSurfaces[rect.id].first) + " is larger than an atlas page, it gets its own texture");
+                SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, pendingAtlasSurfaces[rect.id].second);
+                textures.push_back(texture);
+
+                TextureRegion region;
+                region.texture = texture;
+                region.rect = {0, 0, pendingAtlasSurfaces[rect.id].second->w, pendingAtlasSurfaces[rect.id].second->h};
+                SetTextureRegion(pendingAtlasSurfaces[rect.id].first, region);
+            }
+            break;
+        }
+
+        SDL_Texture* page = SDL_CreateTextureFromSurface(renderer, pageSurface);
+        SDL_SetTextureBlendMode(page, SDL_BLENDMODE_BLEND);
+        SDL_FreeSurface(pageSurface);
+        atlasPages.push_back(page);
+        for (auto id: packedIds)
+        {
+            regions[pendingAtlasSurfaces[id].first].texture = page;
+        }
+        remaining = unpacked;
+    }
+
+    for (auto& pending: pendingAtlasSurfaces)
+    {
+        Logger::Log("New texture added to the Asset Store atlas with id = " + GetAssetId(pending.first));
+        SDL_FreeSurface(pending.second);
+    }
+    pendingAtlasSurfaces.clear();
+    Logger::Log("Texture atlas built with " + std::to_string(atlasPages.size()) + " pages");
+}
+
+void AssetStore::LoadTextureAsync(JobSystem& jobSystem, const std::string& assetId, const std::string& filePath, bool isPacked, bool isDirectional, bool isStreamed)
+{
+    const AssetHandle assetHandle = GetAssetHandle(assetId);
+    if (!AcquireAsset(assetHandle))
+    {
+        return;
+    }
+    if (isStreamed)
+    {
+        if (assetHandle >= static_cast<int>(streamedTextures.size()))
+        {
+            streamedTextures.resize(assetHandle + 1);
+        }
+        streamedTextures[assetHandle].filePath = filePath;
+        streamedTextures[assetHandle].isDirectional = isDirectional;
+    }
+    else if (!isDirectional)
+    {
+        WatchAsset(assetHandle, filePath);
+    }
+    const int loadGeneration = generation;
+    numPendingDecodes++;
+
+    jobSystem.Schedule([this, assetHandle, filePath, isPacked, isDirectional, isStreamed, loadGeneration]()
+    {
+        SDL_Surface* surface = DecodeTexture(filePath, isDirectional);
+        if (surface)
+        {
+            std::lock_guard<std::mutex> lock(decodedImagesMutex);
+            decodedImages.push_back({assetHandle, surface, isPacked && !isStreamed, loadGeneration, isStreamed});
+        }
+        numPendingDecodes--;
+    });
+}
+
+SDL_Surface* AssetStore::DecodeTexture(const std::string& filePath, bool isDirectional) const
+{
+    PROFILE_SCOPE("Texture decode");
+    SDL_Surface* surface = isDirectional ? LoadDirectionalSurface(filePath) : LoadSurface(filePath);
+    // The directional images log the one that is missing
+    if (!surface && !isDirectional)
+    {
+        Logger::Err("Unable to load the image " + filePath + ": " + SDL_GetError());
+    }
+    return surface;
+}
+
+void AssetStore::AddDecodedTexture(const std::string& assetId, const std::string& filePath, SDL_Surface* surface, bool isPacked, bool isDirectional, bool isStreamed)
+{
+    const AssetHandle assetHandle = GetAssetHandle(assetId);
+    if (!AcquireAsset(assetHandle))
+    {
+        SDL_FreeSurface(surface);
+        return;
+    }
+    if (isStreamed)
+    {
+        if (assetHandle >= static_cast<int>(streamedTextures.size()))
+        {
+            streamedTextures.resize(assetHandle + 1);
+        }
+        streamedTextures[assetHandle].filePath = filePath;
+        streamedTextures[assetHandle].isDirectional = isDirectional;
+    }
+    else if (!isDirectional)
+    {
+        WatchAsset(assetHandle, filePath);
+    }
+    if (surface)
+    {
+        std::lock_guard<std::mutex> lock(decodedImagesMutex);
+        decodedImages.push_back({assetHandle, surface, isPacked && !isStreamed, generation, isStreamed});
+    }
+}
+
+void AssetStore::ProcessLoadedTextures(SDL_Renderer* renderer, double budgetMillisecs)
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+    const auto isOverBudget = [&]()
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() >= budgetMillisecs;
+    };
+
+    while (!isOverBudget())
+    {
+        DecodedImage decodedImage;
+        {
+            std::lock_guard<std::mutex> lock(decodedImagesMutex);
+            if (decodedImages.empty())
+            {
+                break;
+            }
+            decodedImage = decodedImages.back();
+            decodedImages.pop_back();
+        }
+
+        // Dropped when the scope was released while decoding, or loaded again meanwhile
+        if (decodedImage.generation != generation || GetRefCount(decodedImage.assetHandle) == 0 || (!decodedImage.isStreamed && GetTextureRegion(decodedImage.assetHandle).texture))
+        {
+            SDL_FreeSurface(decodedImage.surface);
+            continue;
+        }
+        if (decodedImage.isStreamed)
+        {
+            UploadStreamedTexture(renderer, decodedImage.assetHandle, decodedImage.surface);
+            SDL_FreeSurface(decodedImage.surface);
+            continue;
+        }
+        if (decodedImage.isPacked)
+        {
+            pendingAtlasSurfaces.emplace_back(decodedImage.assetHandle, decodedImage.surface);
+            continue;
+        }
+
+        SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, decodedImage.surface);
+        SDL_FreeSurface(decodedImage.surface);
+        textures.push_back(texture);
+
+        TextureRegion region;
+        region.texture = texture;
+        SDL_QueryTexture(texture, NULL, NULL, &region.rect.w, &region.rect.h);
+        SetTextureRegion(decodedImage.assetHandle, region);
+        Logger::Log("New texture added to the Asset Store with id = " + GetAssetId(decodedImage.assetHandle));
+    }
+
+    // The atlas is packed in one go, once all its images are there
+    if (!pendingAtlasSurfaces.empty() && !IsLoading() && !isOverBudget())
+    {
+        BuildAtlas(renderer);
+    }
+}
+
+bool AssetStore::IsLoading()
+{
+    std::lock_guard<std::mutex> lock(decodedImagesMutex);
+    return numPendingDecodes > 0 || !decodedImages.empty();
+}
+
+void AssetStore::BeginScope(const std::string& scopeName)
+{
+    currentScope = scopeName;
+    scopes[scopeName];
+}
+
+void AssetStore::ReleaseScope(const std::string& scopeName)
+{
+    auto scope = scopes.find(scopeName);
+    if (scope == scopes.end())
+    {
+        Logger::War("Releasing the asset scope " + scopeName + ", which was never started");
+        return;
+    }
+
+    int numUnloaded = 0;
+    for (auto assetHandle: scope->second)
+    {
+        if (--records[assetHandle].refCount == 0)
+        {
+            UnloadAsset(assetHandle);
+            numUnloaded++;
+        }
+    }
+    scopes.erase(scope);
+    if (currentScope == scopeName)
+    {
+        currentScope.clear();
+    }
+
+    UnloadUnusedAtlasPages();
+    Logger::Log("Asset scope " + scopeName + " released, " + std::to_string(numUnloaded) + " assets unloaded");
+}
+
+bool AssetStore::AcquireAsset(AssetHandle assetHandle)
+{
+    if (assetHandle >= static_cast<int>(records.size()))
+    {
+        records.resize(assetHandle + 1);
+    }
+
+    auto& scopeAssets = scopes[currentScope];
+    if (std::find(scopeAssets.begin(), scopeAssets.end(), assetHandle) == scopeAssets.end())
+    {
+        scopeAssets.push_back(assetHandle);
+        records[assetHandle].refCount++;
+    }
+
+    if (records[assetHandle].isResident)
+    {
+        return false;
+    }
+    records[assetHandle].isResident = true;
+    return true;
+}
+
+void AssetStore::UnloadAsset(AssetHandle assetHandle)
+{
+    records[assetHandle].isResident = false;
+
+    if (assetHandle < static_cast<int>(sounds.size()) && sounds[assetHandle])
+    {
+        Mix_FreeChunk(sounds[assetHandle]);
+        sounds[assetHandle] = nullptr;
+        return;
+    }
+    if (assetHandle < static_cast<int>(fonts.size()) && fonts[assetHandle].texture)
+    {
+        SDL_DestroyTexture(fonts[assetHandle].texture);
+        textures.erase(std::find(textures.begin(), textures.end(), fonts[assetHandle].texture));
+        fonts[assetHandle] = FontAtlas();
+        return;
+    }
+
+    // Images still waiting for the atlas are simply dropped
+    for (auto pending = pendingAtlasSurfaces.begin(); pending != pendingAtlasSurfaces.end(); pending++)
+    {
+        if (pending->first == assetHandle)
+        {
+            SDL_FreeSurface(pending->second);
+            pendingAtlasSurfaces.erase(pending);
+            break;
+        }
+    }
+
+    if (IsStreamed(assetHandle))
+    {
+        EvictStreamedTexture(assetHandle);
+        SDL_DestroyTexture(streamedTextures[assetHandle].placeholder);
+        streamedTextures[assetHandle] = StreamedTexture();
+        if (assetHandle < static_cast<int>(regions.size()))
+        {
+            regions[assetHandle] = TextureRegion();
+        }
+        return;
+    }
+
+    if (assetHandle >= static_cast<int>(regions.size()))
+    {
+        return;
+    }
+    // Textures of their own go right away, atlas pages once all their assets are gone
+    SDL_Texture* texture = regions[assetHandle].texture;
+    auto ownTexture = std::find(textures.begin(), textures.end(), texture);
+    if (texture && ownTexture != textures.end())
+    {
+        SDL_DestroyTexture(texture);
+        textures.erase(ownTexture);
+    }
+    regions[assetHandle] = TextureRegion();
+}
+
+void AssetStore::UnloadUnusedAtlasPages()
+{
+    for (auto page = atlasPages.begin(); page != atlasPages.end();)
+    {
+        const bool isUsed = std::any_of(regions.begin(), regions.end(), [&](const TextureRegion& region) { return region.texture == *page; });
+        if (isUsed)
+        {
+            page++;
+            continue;
+        }
+        SDL_DestroyTexture(*page);
+        page = atlasPages.erase(page);
+    }
+}
+
+int AssetStore::GetRefCount(AssetHandle assetHandle) const
+{
+    if (assetHandle < 0 || assetHandle >= static_cast<int>(records.size()))
+    {
+        return 0;
+    }
+    return records[assetHandle].refCount;
+}
+
+// Estimated from its size and pixel format, 0 for none
+static size_t GetTextureBytes(SDL_Texture* texture)
+{
+    Uint32 format;
+    int width;
+    int height;
+    if (!texture || SDL_QueryTexture(texture, &format, nullptr, &width, &height) != 0)
+    {
+        return 0;
+    }
+    return static_cast<size_t>(width) * height * SDL_BYTESPERPIXEL(format);
+}
+
+int AssetStore::GetNumTextures() const
+{
+    int numStreamed = 0;
+    for (const auto& streamed: streamedTextures)
+    {
+        numStreamed += (streamed.placeholder ? 1 : 0) + (streamed.texture ? 1 : 0);
+    }
+    return textures.size() + atlasPages.size() + numStreamed;
+}
+
+size_t AssetStore::GetNumTextureBytes() const
+{
+    size_t numBytes = numStreamedBytes;
+    for (const auto* group: {&textures, &atlasPages})
+    {
+        for (SDL_Texture* texture: *group)
+        {
+            numBytes += GetTextureBytes(texture);
+        }
+    }
+    for (const auto& streamed: streamedTextures)
+    {
+        numBytes += GetTextureBytes(streamed.placeholder);
+    }
+    return numBytes;
+}
+
+bool AssetStore::IsStreamed(AssetHandle assetHandle) const
+{
+    return assetHandle >= 0 && assetHandle < static_cast<int>(streamedTextures.size()) && !streamedTextures[assetHandle].filePath.empty();
+}
+
+// The mip of the image, each texel the average of the 2^mipLevel pixels on a side it covers
+static SDL_Surface* CreateMipSurface(SDL_Surface* surface, int mipLevel)
+{
+    SDL_Surface* image = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+    if (!image)
+    {
+        return nullptr;
+    }
+    const int blockSize = 1 << mipLevel;
+    const int width = std::max(image->w >> mipLevel, 1);
+    const int height = std::max(image->h >> mipLevel, 1);
+    SDL_Surface* mip = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
+    if (!mip)
+    {
+        SDL_FreeSurface(image);
+        return nullptr;
+    }
+    SDL_LockSurface(image);
+    for (int y = 0; y < height; y++)
+    {
+        uint8_t* mipRow = static_cast<uint8_t*>(mip->pixels) + y * mip->pitch;
+        for (int x = 0; x < width; x++)
+        {
+            // The last block of a side not a multiple of it only averages the pixels there are
+            const int endX = std::min((x + 1) * blockSize, image->w);
+            const int endY = std::min((y + 1) * blockSize, image->h);
+            uint32_t sums[4] = {0, 0, 0, 0};
+            for (int imageY = y * blockSize; imageY < endY; imageY++)
+            {
+                const uint8_t* pixel = static_cast<uint8_t*>(image->pixels) + imageY * image->pitch + x * blockSize * 4;
+                for (int imageX = x * blockSize; imageX < endX; imageX++, pixel += 4)
+                {
+                    for (int channel = 0; channel < 4; channel++)
+                    {
+                        sums[channel] += pixel[channel];
+                    }
+                }
+            }
+            const uint32_t numPixels = std::max((endX - x * blockSize) * (endY - y * blockSize), 1);
+            for (int channel = 0; channel < 4; channel++)
+            {
+                mipRow[x * 4 + channel] = static_cast<uint8_t>(sums[channel] / numPixels);
+            }
+        }
+    }
+    SDL_UnlockSurface(image);
+    SDL_FreeSurface(image);
+    return mip;
+}
+
+void AssetStore::UploadStreamedTexture(SDL_Renderer* renderer, AssetHandle assetHandle, SDL_Surface* surface)
+{
+    StreamedTexture& streamed = streamedTextures[assetHandle];
+    streamed.isDecoding = false;
+    TextureRegion region;
+    region.rect = {0, 0, surface->w, surface->h};
+    if (!streamed.placeholder)
+    {
+        SDL_Surface* mip = CreateMipSurface(surface, TEXTURE_STREAM_PLACEHOLDER_MIP);
+        streamed.placeholder = mip ? SDL_CreateTextureFromSurface(renderer, mip) : nullptr;
+        SDL_FreeSurface(mip);
+        if (!streamed.placeholder)
+        {
+            Logger::Err("Unable to create the placeholder of " + GetAssetId(assetHandle) + ": " + SDL_GetError());
+            return;
+        }
+        region.texture = streamed.placeholder;
+        region.mipLevel = TEXTURE_STREAM_PLACEHOLDER_MIP;
+        SetTextureRegion(assetHandle, region);
+        Logger::Log("New streamed texture added to the Asset Store with id = " + GetAssetId(assetHandle));
+        return;
+    }
+    if (streamed.texture)
+    {
+        return;
+    }
+    streamed.texture = SDL_CreateTextureFromSurface(renderer, surface);
+    if (!streamed.texture)
+    {
+        Logger::Err("Unable to stream in " + GetAssetId(assetHandle) + ": " + SDL_GetError());
+        return;
+    }
+    streamed.numBytes = GetTextureBytes(streamed.texture);
+    numStreamedBytes += streamed.numBytes;
+    region.texture = streamed.texture;
+    SetTextureRegion(assetHandle, region);
+}
+
+void AssetStore::EvictStreamedTexture(AssetHandle assetHandle)
+{
+    StreamedTexture& streamed = streamedTextures[assetHandle];
+    if (!streamed.texture)
+    {
+        return;
+    }
+    SDL_DestroyTexture(streamed.texture);
+    streamed.texture = nullptr;
+    numStreamedBytes -= streamed.numBytes;
+    streamed.numBytes = 0;
+    regions[assetHandle].texture = streamed.placeholder;
+    regions[assetHandle].mipLevel = TEXTURE_STREAM_PLACEHOLDER_MIP;
+}
+
+void AssetStore::SetTextureStreamBudget(size_t numBytes)
+{
+    streamBudgetBytes = numBytes;
+}
+
+void AssetStore::UseTexture(AssetHandle assetHandle) const
+{
+    if (assetHandle >= 0 && assetHandle < static_cast<int>(textureUseFrames.size()))
+    {
+        textureUseFrames[assetHandle] = streamFrame;
+    }
+}
+
+void AssetStore::UpdateTextureStreaming(JobSystem& jobSystem)
+{
+    textureUseFrames.resize(streamedTextures.size(), 0);
+
+    // The whole images drawn with their placeholder are decoded again, not counted as loading
+    for (AssetHandle assetHandle = 0; assetHandle < static_cast<int>(streamedTextures.size()); assetHandle++)
+    {
+        StreamedTexture& streamed = streamedTextures[assetHandle];
+        if (!streamed.placeholder || streamed.texture || streamed.isDecoding || textureUseFrames[assetHandle] != streamFrame)
+        {
+            continue;
+        }
+        streamed.isDecoding = true;
+        const std::string filePath = streamed.filePath;
+        const bool isDirectional = streamed.isDirectional;
+        const int loadGeneration = generation;
+        jobSystem.Schedule([this, assetHandle, filePath, isDirectional, loadGeneration]()
+        {
+            SDL_Surface* surface = DecodeTexture(filePath, isDirectional);
+            if (surface)
+            {
+                std::lock_guard<std::mutex> lock(decodedImagesMutex);
+                decodedImages.push_back({assetHandle, surface, false, loadGeneration, true});
+            }
+        });
+    }
+
+    // Least recently drawn first, the ones drawn in the last frame are kept even over the budget
+    while (numStreamedBytes > streamBudgetBytes)
+    {
+        AssetHandle leastRecent = INVALID_ASSET_HANDLE;
+        for (AssetHandle assetHandle = 0; assetHandle < static_cast<int>(streamedTextures.size()); assetHandle++)
+        {
+            if (streamedTextures[assetHandle].texture && textureUseFrames[assetHandle] != streamFrame && (leastRecent == INVALID_ASSET_HANDLE || textureUseFrames[assetHandle] < textureUseFrames[leastRecent]))
+            {
+                leastRecent = assetHandle;
+            }
+        }
+        if (leastRecent == INVALID_ASSET_HANDLE)
+        {
+            break;
+        }
+        EvictStreamedTexture(leastRecent);
+    }
+    streamFrame++;
+}
+
+void AssetStore::WatchAsset(AssetHandle assetHandle, const std::string& filePath)
+{
+#ifdef ASSET_HOT_RELOAD
+    hotReloader.WatchFile(filePath, assetHandle);
+#endif
+}
+
+void AssetStore::WatchFile(const std::string& filePath, std::function<void()> onChanged)
+{
+#ifdef ASSET_HOT_RELOAD
+    fileWatchers.emplace_back(filePath, onChanged);
+    hotReloader.WatchFile(filePath, INVALID_ASSET_HANDLE);
+#endif
+}
+
+int AssetStore::ProcessHotReloads(SDL_Renderer* renderer)
+{
+#ifdef ASSET_HOT_RELOAD
+    std::vector<ReloadedFile> reloadedFiles;
+    hotReloader.TakeReloadedFiles(reloadedFiles);
+
+    int numReloaded = 0;
+    for (auto& file: reloadedFiles)
+    {
+        if (file.assetHandle == INVALID_ASSET_HANDLE)
+        {
+            for (auto& fileWatcher: fileWatchers)
+            {
+                if (fileWatcher.first == file.filePath)
+                {
+                    fileWatcher.second();
+                }
+            }
+            Logger::Log("Hot reloaded " + file.filePath);
+            numReloaded++;
+            continue;
+        }
+
+        // Assets unloaded since they were loaded are left alone
+        if (GetRefCount(file.assetHandle) > 0 && GetTextureRegion(file.assetHandle).texture)
+        {
+            SwapTexture(renderer, file.assetHandle, file.surface);
+            Logger::Log("Hot reloaded " + file.filePath + " into " + GetAssetId(file.assetHandle));
+            numReloaded++;
+        }
+        SDL_FreeSurface(file.surface);
+    }
+    return numReloaded;
+#else
+    return 0;
+#endif
+}
+
+#ifdef ASSET_HOT_RELOAD
+void AssetStore::SwapTexture(SDL_Renderer* renderer, AssetHandle assetHandle, SDL_Surface* surface)
+{
+    TextureRegion& region = regions[assetHandle];
+
+    // Packed images of the same size are rewritten in their atlas page
+    const bool isPacked = std::find(atlasPages.begin(), atlasPages.end(), region.texture) != atlasPages.end();
+    if (isPacked && surface->w == region.rect.w && surface->h == region.rect.h)
+    {
+        Uint32 pageFormat;
+        SDL_QueryTexture(region.texture, &pageFormat, NULL, NULL, NULL);
+        SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, pageFormat, 0);
+        if (converted)
+        {
+            SDL_UpdateTexture(region.texture, &region.rect, converted->pixels, converted->pitch);
+            SDL_FreeSurface(converted);
+        }
+        return;
+    }
+
+    // Otherwise the asset gets a texture of its own, the previous one goes unless it is a page
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+    if (!texture)
+    {
+        Logger::Err("Unable to hot reload " + GetAssetId(assetHandle) + ": " + SDL_GetError());
+        return;
+    }
+    if (isPacked)
+    {
+        Logger::War("The image " + GetAssetId(assetHandle) + " changed size, it leaves the atlas until the next restart");
+        textures.push_back(texture);
+    }
+    else
+    {
+        auto previousTexture = std::find(textures.begin(), textures.end(), region.texture);
+        if (previousTexture != textures.end())
+        {
+            SDL_DestroyTexture(*previousTexture);
+            textures.erase(previousTexture);
+        }
+        textures.push_back(texture);
+    }
+    region.texture = texture;
+    region.rect = {0, 0, surface->w, surface->h};
+}
+#endif
+
+void AssetStore::SetTextureRegion(AssetHandle assetHandle, const TextureRegion& region)
+{
+    if (assetHandle >= static_cast<int>(regions.size()))
+    {
+        regions.resize(assetHandle + 1);
+    }
+    regions[assetHandle] = region;
+}
+
 SDL_Texture* AssetStore::GetTexture(const std::string& assetId)
 {
-    return textures[assetId];
+    return GetTextureRegion(GetAssetHandle(assetId)).texture;
+}
+
+const TextureRegion& AssetStore::GetTextureRegion(const std::string& assetId)
+{
+    return GetTextureRegion(GetAssetHandle(assetId));
+}
+
+const TextureRegion& AssetStore::GetTextureRegion(AssetHandle assetHandle) const
+{
+    static const TextureRegion missingRegion;
+    if (assetHandle < 0 || assetHandle >= static_cast<int>(regions.size()))
+    {
+        return missingRegion;
+    }
+    return regions[assetHandle];
+}
+
+int AssetStore::GetNumAtlasPages() const
+{
+    return atlasPages.size();
 }
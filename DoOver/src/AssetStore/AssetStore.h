@@ -1,24 +1,234 @@
 #ifndef ASSETSTORE_H
 #define ASSETSTORE_H
 
-#include <map>
 #include <string>
+#include <vector>
 #include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include "AssetHandle.h"
+#include "FontAtlas.h"
+#include "AssetPack.h"
+#include "AssetHotReloader.h"
+#include "../Jobs/JobSystem.h"
+#include <mutex>
+#include <atomic>
+#include <map>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+
+// Size of the atlas pages the small textures are packed into
+const int ATLAS_PAGE_SIZE = 2048;
+// Empty texels around each packed image, so filtering never samples the neighbours
+const int ATLAS_PADDING = 1;
+
+// A directional texture loads one file per direction, named by replacing the placeholder of
+// its file path, and stacks them top to bottom in this order (see DirectionalSpriteComponent)
+const std::string TEXTURE_DIRECTION_PLACEHOLDER = "{direction}";
+const char* const TEXTURE_DIRECTION_NAMES[] = {"up", "right", "down", "left"};
+const int NUM_TEXTURE_DIRECTIONS = 4;
+
+// Mip of a streamed texture that stays resident, each of its texels covers 2^mip image pixels
+// on a side
+const int TEXTURE_STREAM_PLACEHOLDER_MIP = 3;
+// Video memory the whole images of the streamed textures may take
+const int DEFAULT_TEXTURE_STREAM_BUDGET_MB = 64;
+
+// Where an asset lives: a whole texture, or a rectangle of an atlas page
+struct TextureRegion
+{
+    SDL_Texture* texture = nullptr;
+    // Where the asset is in the texture and its size, in the pixels of the whole image
+    SDL_Rect rect = {0, 0, 0, 0};
+    // Of a streamed texture showing its placeholder, the texture is 2^mipLevel times smaller
+    // than the image on a side
+    int mipLevel = 0;
+
+    // The texels of the texture a rectangle of the asset samples
+    SDL_Rect GetSrcRect(const SDL_Rect& assetRect) const
+    {
+        return {rect.x + (assetRect.x >> mipLevel), rect.y + (assetRect.y >> mipLevel), std::max(assetRect.w >> mipLevel, 1), std::max(assetRect.h >> mipLevel, 1)};
+    }
+    // The texels of the whole asset
+    SDL_Rect GetSrcRect() const
+    {
+        return GetSrcRect({0, 0, rect.w, rect.h});
+    }
+};
 
 class AssetStore
 {
 private:
-    std::map<std::string, SDL_Texture*> textures;
-    // TODO: std::map<std::string, TTF_Font* fonts
-    // TODO: std::map<std::string, SDL_Audio* sounds
+    // Textures loaded on their own, and the atlas pages
+    std::vector<SDL_Texture*> textures;
+    std::vector<SDL_Texture*> atlasPages;
+
+    // Packed copies of the asset files, the loose files are used for anything not in it
+    AssetPack pack;
+
+    // [asset handle] -> where the asset is
+    std::vector<TextureRegion> regions;
+
+    // [asset handle] -> number of scopes holding the asset, it is unloaded when it drops to zero
+    struct AssetRecord
+    {
+        int refCount = 0;
+        bool isResident = false;
+    };
+    std::vector<AssetRecord> records;
+
+    // Scope name -> assets it holds, new assets are added to the current scope
+    std::map<std::string, std::vector<AssetHandle>> scopes;
+    std::string currentScope;
+    // [asset handle] -> font, its atlas texture is in the textures as well
+    std::vector<FontAtlas> fonts;
+    // [asset handle] -> sound, decoded to the format of the audio device when loaded
+    std::vector<Mix_Chunk*> sounds;
+
+    // [asset handle] -> the textures of a streamed asset: the placeholder is resident as long as
+    // the asset, the whole image only while it is drawn and the budget has room for it
+    struct StreamedTexture
+    {
+        std::string filePath;
+        SDL_Texture* placeholder = nullptr;
+        SDL_Texture* texture = nullptr;
+        bool isDirectional = false;
+        size_t numBytes = 0;
+        bool isDecoding = false;
+    };
+    std::vector<StreamedTexture> streamedTextures;
+    // [asset handle] -> the frame the streamed texture was last drawn in, 0 for never
+    mutable std::vector<uint32_t> textureUseFrames;
+    uint32_t streamFrame = 1;
+    size_t streamBudgetBytes = static_cast<size_t>(DEFAULT_TEXTURE_STREAM_BUDGET_MB) * 1024 * 1024;
+    // Of the whole images resident
+    size_t numStreamedBytes = 0;
+
+    // Images waiting for BuildAtlas
+    std::vector<std::pair<AssetHandle, SDL_Surface*>> pendingAtlasSurfaces;
+
+    // Images decoded by the job system workers, waiting for the main thread to upload them
+    struct DecodedImage
+    {
+        AssetHandle assetHandle;
+        SDL_Surface* surface;
+        bool isPacked;
+        int generation;
+        bool isStreamed;
+    };
+    std::mutex decodedImagesMutex;
+    std::vector<DecodedImage> decodedImages;
+    std::atomic<int> numPendingDecodes{0};
+
+    // Bumped by ClearAssets, so the images still decoding for the cleared assets are dropped
+    std::atomic<int> generation{0};
+
+    void SetTextureRegion(AssetHandle assetHandle, const TextureRegion& region);
+
+#ifdef ASSET_HOT_RELOAD
+    AssetHotReloader hotReloader;
+    // Other files watched, and what to do when they change
+    std::vector<std::pair<std::string, std::function<void()>>> fileWatchers;
+
+    void SwapTexture(SDL_Renderer* renderer, AssetHandle assetHandle, SDL_Surface* surface);
+#endif
+    void WatchAsset(AssetHandle assetHandle, const std::string& filePath);
+
+    // Surface of the image, pointing into the pack mapping when it is packed
+    SDL_Surface* LoadSurface(const std::string& filePath) const;
+    // One surface with the image of each direction as a row, null when one is missing
+    SDL_Surface* LoadDirectionalSurface(const std::string& filePath) const;
+
+    // Adds a reference from the current scope, returns true if the asset still has to be loaded
+    bool AcquireAsset(AssetHandle assetHandle);
+    void UnloadAsset(AssetHandle assetHandle);
+    void UnloadUnusedAtlasPages();
+
+    bool IsStreamed(AssetHandle assetHandle) const;
+    // The placeholder when the asset has none yet, else the whole image
+    void UploadStreamedTexture(SDL_Renderer* renderer, AssetHandle assetHandle, SDL_Surface* surface);
+    // Back to the placeholder
+    void EvictStreamedTexture(AssetHandle assetHandle);
 
 public:
     AssetStore();
     ~AssetStore();
 
     void ClearAssets();
+
+    // Maps the asset pack, later loads read from it instead of the loose files.
+    // Mount it before loading anything, the packed surfaces point into the mapping.
+    bool MountPack(const std::string& packFilePath);
+    // Contents of a packed file (e.g. a tilemap), false when it is not in the pack
+    bool GetPackedFile(const std::string& filePath, const char*& data, size_t& size) const;
+
+    // Assets are loaded into the current scope (e.g. a level), loading an asset that is already
+    // resident only adds a reference to it. Releasing a scope unloads the assets no other scope
+    // holds, atlas pages are destroyed once none of their assets are left.
+    void BeginScope(const std::string& scopeName);
+    void ReleaseScope(const std::string& scopeName);
+    int GetRefCount(AssetHandle assetHandle) const;
+    int GetNumTextures() const;
+    // Estimated from the size and pixel format of the textures and atlas pages
+    size_t GetNumTextureBytes() const;
+
     void AddTexture(SDL_Renderer* renderer, const std::string& assetId, const std::string& filePath);
+
+    // Queues an image to be packed into the atlas pages by the next BuildAtlas
+    void AddAtlasTexture(const std::string& assetId, const std::string& filePath);
+    void BuildAtlas(SDL_Renderer* renderer);
+
+    // Decodes the image on the job system, the asset handle resolves to an empty region
+    // until ProcessLoadedTextures uploads it. Packed images go to the atlas, which is built
+    // once every pending image is decoded. The images of a directional texture become one
+    // region, their files aren't hot reloaded. A streamed texture is kept out of the atlas and
+    // isn't hot reloaded either, only its placeholder mip is uploaded (see UseTexture).
+    void LoadTextureAsync(JobSystem& jobSystem, const std::string& assetId, const std::string& filePath, bool isPacked = false, bool isDirectional = false, bool isStreamed = false);
+    // The decode of LoadTextureAsync on the calling thread, any thread once the pack is mounted
+    SDL_Surface* DecodeTexture(const std::string& filePath, bool isDirectional) const;
+    // LoadTextureAsync for an image decoded already (e.g. while the window was created), the
+    // store takes the surface. A null surface is an image that failed to decode.
+    void AddDecodedTexture(const std::string& assetId, const std::string& filePath, SDL_Surface* surface, bool isPacked = false, bool isDirectional = false, bool isStreamed = false);
+
+    // Uploads the decoded images on the main thread, and stops once budgetMillisecs are spent
+    void ProcessLoadedTextures(SDL_Renderer* renderer, double budgetMillisecs);
+    bool IsLoading();
+
+    // Texture streaming: the region of a streamed texture shows its placeholder until it is
+    // drawn, the whole image is then decoded again on the job system and swapped in. Past the
+    // budget, the whole images drawn longest ago go back to their placeholders.
+    void SetTextureStreamBudget(size_t numBytes);
+    // Marks the streamed texture as drawn in the frame being recorded, nothing for the others
+    void UseTexture(AssetHandle assetHandle) const;
+    // Once a frame, between the submit of a frame and the recording of the next: requests the
+    // whole images drawn in the last frame and evicts the ones over the budget that weren't
+    void UpdateTextureStreaming(JobSystem& jobSystem);
+
+    // Hot reload, compiled out in release builds where these do nothing. Textures are watched
+    // as they are loaded, other files (e.g. tilemaps) call onChanged on the main thread.
+    void WatchFile(const std::string& filePath, std::function<void()> onChanged);
+    // Swaps in the textures changed on disk, called at the frame boundary. Returns how many
+    // assets were reloaded.
+    int ProcessHotReloads(SDL_Renderer* renderer);
+
+    // Decodes the whole sound up front, the audio device must be open
+    void AddSound(const std::string& assetId, const std::string& filePath);
+    // Null when the sound isn't loaded
+    Mix_Chunk* GetSound(AssetHandle assetHandle) const;
+
+    // Rasterizes the printable ASCII glyphs of the font at the size into an atlas, once
+    void AddFont(SDL_Renderer* renderer, const std::string& assetId, const std::string& filePath, int fontSize);
+    // Null when the font isn't loaded
+    const FontAtlas* GetFont(AssetHandle assetHandle) const;
+
+    // Texture holding the asset (the atlas page for packed assets)
     SDL_Texture* GetTexture(const std::string& assetId);
+
+    // Texture and rectangle of the asset, sprite source rectangles are relative to it.
+    // The string version is meant for tooling, the handle one is an O(1) lookup.
+    const TextureRegion& GetTextureRegion(const std::string& assetId);
+    const TextureRegion& GetTextureRegion(AssetHandle assetHandle) const;
+    int GetNumAtlasPages() const;
 };
 
-#endif
\ No newline at end of file
+#endif
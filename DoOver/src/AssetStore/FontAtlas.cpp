@@ -0,0 +1,55 @@
+#include "./FontAtlas.h"
+#include <algorithm>
+
+const GlyphInfo& FontAtlas::GetGlyph(char character) const
+{
+    const int code = static_cast<unsigned char>(character);
+    if (code < FONT_FIRST_CHARACTER || code > FONT_LAST_CHARACTER)
+    {
+        return glyphs[FONT_FALLBACK_CHARACTER - FONT_FIRST_CHARACTER];
+    }
+    return glyphs[code - FONT_FIRST_CHARACTER];
+}
+
+SDL_FPoint FontAtlas::Layout(const std::string& text, std::vector<GlyphQuad>& quads) const
+{
+    float penX = 0.0f;
+    float penY = 0.0f;
+    float width = 0.0f;
+    for (char character: text)
+    {
+        if (character == '\n')
+        {
+            width = std::max(width, penX);
+            penX = 0.0f;
+            penY += lineHeight;
+            continue;
+        }
+        const GlyphInfo& glyph = GetGlyph(character);
+        if (glyph.srcRect.w > 0)
+        {
+            quads.push_back({glyph.srcRect, {penX + glyph.offsetX, penY + glyph.offsetY, static_cast<float>(glyph.srcRect.w), static_cast<float>(glyph.srcRect.h)}});
+        }
+        penX += glyph.advance;
+    }
+    return {std::max(width, penX), penY + lineHeight};
+}
+
+SDL_FPoint FontAtlas::Measure(const std::string& text) const
+{
+    float penX = 0.0f;
+    float width = 0.0f;
+    int numLines = 1;
+    for (char character: text)
+    {
+        if (character == '\n')
+        {
+            width = std::max(width, penX);
+            penX = 0.0f;
+            numLines++;
+            continue;
+        }
+        penX += GetGlyph(character).advance;
+    }
+    return {std::max(width, penX), static_cast<float>(numLines * lineHeight)};
+}
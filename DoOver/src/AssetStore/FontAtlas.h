@@ -0,0 +1,51 @@
+#ifndef FONTATLAS_H
+#define FONTATLAS_H
+
+#include <SDL2/SDL.h>
+#include <string>
+#include <vector>
+
+// The characters rasterized into the atlas, the others are drawn as FONT_FALLBACK_CHARACTER
+const int FONT_FIRST_CHARACTER = 32;
+const int FONT_LAST_CHARACTER = 126;
+const char FONT_FALLBACK_CHARACTER = '?';
+// Size of the atlas the glyphs are first packed into, doubled until they fit
+const int FONT_ATLAS_MIN_SIZE = 256;
+const int FONT_ATLAS_MAX_SIZE = 2048;
+
+struct GlyphInfo
+{
+    // In the atlas, empty for the blank glyphs (e.g. the space)
+    SDL_Rect srcRect = {0, 0, 0, 0};
+    // From the pen position on the top of the line to the top left of the glyph
+    int offsetX = 0;
+    int offsetY = 0;
+    int advance = 0;
+};
+
+// A glyph placed relative to the top left of the text
+struct GlyphQuad
+{
+    SDL_Rect srcRect;
+    SDL_FRect dstRect;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Font atlas
+/////////////////////////////////////////////////////////////////////////////////////////////
+// A font rasterized once at one size, every glyph white in a single texture so any text in
+// it is drawn in any color with one batch. Laying out a string only looks up the glyphs.
+/////////////////////////////////////////////////////////////////////////////////////////////
+struct FontAtlas
+{
+    SDL_Texture* texture = nullptr;
+    GlyphInfo glyphs[FONT_LAST_CHARACTER - FONT_FIRST_CHARACTER + 1];
+    int lineHeight = 0;
+
+    const GlyphInfo& GetGlyph(char character) const;
+    // Appends the quads of the text, the lines are broken at '\n'. Returns the size of the text.
+    SDL_FPoint Layout(const std::string& text, std::vector<GlyphQuad>& quads) const;
+    SDL_FPoint Measure(const std::string& text) const;
+};
+
+#endif
@@ -0,0 +1,331 @@
+#include "./AudioEngine.h"
+#include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+AudioEngine::AudioEngine(const AssetStore& assetStore): assetStore(assetStore), slots(new Slot[AUDIO_COMMAND_QUEUE_CAPACITY])
+{
+    for (uint64_t i = 0; i < AUDIO_COMMAND_QUEUE_CAPACITY; i++)
+    {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+AudioEngine::~AudioEngine()
+{
+    Close();
+}
+
+bool AudioEngine::Open()
+{
+    if (IsOpen())
+    {
+        return true;
+    }
+    if (Mix_OpenAudio(AUDIO_FREQUENCY, MIX_DEFAULT_FORMAT, 2, AUDIO_CHUNK_SIZE) != 0)
+    {
+        Logger::Err(std::string("Error opening the audio device: ") + Mix_GetError());
+        return false;
+    }
+    Mix_AllocateChannels(AUDIO_NUM_VOICES);
+    voices.assign(AUDIO_NUM_VOICES, Voice());
+    isRunning.store(true, std::memory_order_release);
+    audioThread = std::thread(&AudioEngine::Run, this);
+    LOGGER_INFO("Audio opened with {} voices", AUDIO_NUM_VOICES);
+    return true;
+}
+
+void AudioEngine::Close()
+{
+    if (!IsOpen())
+    {
+        return;
+    }
+    StopMusic();
+    // The thread goes through what is left in the queue before it stops
+    isRunning.store(false, std::memory_order_release);
+    audioThread.join();
+    Mix_CloseAudio();
+    LOGGER_INFO("Audio closed, {} sounds dropped and {} voices stolen", GetNumDropped(), GetNumStolen());
+}
+
+bool AudioEngine::Push(const AudioCommand& command)
+{
+    uint64_t position = enqueuePosition.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true)
+    {
+        slot = &slots[position & (AUDIO_COMMAND_QUEUE_CAPACITY - 1)];
+        const int64_t difference = static_cast<int64_t>(slot->sequence.load(std::memory_order_acquire)) - static_cast<int64_t>(position);
+        if (difference == 0)
+        {
+            if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            return false;
+        }
+        else
+        {
+            position = enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+    slot->command = command;
+    slot->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+bool AudioEngine::Pop(AudioCommand& command)
+{
+    Slot& slot = slots[dequeuePosition & (AUDIO_COMMAND_QUEUE_CAPACITY - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1)
+    {
+        return false;
+    }
+    command = slot.command;
+    slot.sequence.store(dequeuePosition + AUDIO_COMMAND_QUEUE_CAPACITY, std::memory_order_release);
+    dequeuePosition++;
+    return true;
+}
+
+void AudioEngine::Play(AssetHandle sound, int priority, int volume, float pan)
+{
+    if (!IsOpen())
+    {
+        return;
+    }
+    Mix_Chunk* chunk = assetStore.GetSound(sound);
+    if (!chunk)
+    {
+        return;
+    }
+    if (!Push({AUDIO_COMMAND_PLAY, sound, chunk, priority, volume, pan}))
+    {
+        numDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void AudioEngine::PlaySpatial(const std::vector<SpatialSound>& sounds)
+{
+    if (!IsOpen() || sounds.empty())
+    {
+        return;
+    }
+    const glm::vec2 center(listener.x + listener.w * 0.5f, listener.y + listener.h * 0.5f);
+    const glm::vec2 hearingExtent(listener.w * 0.5f + AUDIO_HEARING_MARGIN, listener.h * 0.5f + AUDIO_HEARING_MARGIN);
+    const float fadeDistance = std::max(glm::length(hearingExtent) - AUDIO_FULL_VOLUME_DISTANCE, 1.0f);
+    spatialCommands.clear();
+    for (const auto& spatialSound: sounds)
+    {
+        const glm::vec2 offset = spatialSound.position - center;
+        if (std::abs(offset.x) > hearingExtent.x || std::abs(offset.y) > hearingExtent.y)
+        {
+            numCulled++;
+            continue;
+        }
+        const float fade = std::max(glm::length(offset) - AUDIO_FULL_VOLUME_DISTANCE, 0.0f) / fadeDistance;
+        const int volume = static_cast<int>(MIX_MAX_VOLUME * std::max(1.0f - fade, 0.0f));
+        if (volume < AUDIO_MIN_VOLUME)
+        {
+            numCulled++;
+            continue;
+        }
+        const float pan = glm::clamp(offset.x / hearingExtent.x, -1.0f, 1.0f) * AUDIO_MAX_PAN;
+        auto played = std::find_if(spatialCommands.begin(), spatialCommands.end(), [&spatialSound](const AudioCommand& command) { return command.sound == spatialSound.sound; });
+        if (played == spatialCommands.end())
+        {
+            spatialCommands.push_back({AUDIO_COMMAND_PLAY, spatialSound.sound, nullptr, spatialSound.priority, volume, pan});
+        }
+        else if (volume > played->volume)
+        {
+            played->priority = std::max(played->priority, spatialSound.priority);
+            played->volume = volume;
+            played->pan = pan;
+        }
+    }
+    for (const auto& command: spatialCommands)
+    {
+        Play(command.sound, command.priority, command.volume, command.pan);
+    }
+}
+
+void AudioEngine::StopAll()
+{
+    if (!IsOpen())
+    {
+        return;
+    }
+    while (!Push({AUDIO_COMMAND_STOP_ALL, INVALID_ASSET_HANDLE, nullptr, 0, 0, 0.0f}))
+    {
+        std::this_thread::yield();
+    }
+    const uint64_t position = enqueuePosition.load();
+    while (numProcessed.load(std::memory_order_acquire) < position)
+    {
+        std::this_thread::yield();
+    }
+}
+
+bool AudioEngine::PlayMusic(const std::string& filePath, int loops, int fadeInMillisecs)
+{
+    if (!IsOpen())
+    {
+        return false;
+    }
+    if (music && filePath == musicFilePath)
+    {
+        return true;
+    }
+    StopMusic();
+    musicStream = std::make_unique<MusicStream>();
+    if (!musicStream->Open(filePath))
+    {
+        musicStream.reset();
+        return false;
+    }
+    music = Mix_LoadMUS_RW(musicStream->GetRWops(), 0);
+    if (!music)
+    {
+        Logger::Err("Unable to load the music " + filePath + ": " + Mix_GetError());
+        musicStream.reset();
+        return false;
+    }
+    musicFilePath = filePath;
+    Mix_FadeInMusic(music, loops, fadeInMillisecs);
+    Logger::Log("Streaming the music " + filePath);
+    return true;
+}
+
+void AudioEngine::StopMusic()
+{
+    if (!music)
+    {
+        return;
+    }
+    // The mixer stops reading from the stream before it is closed
+    Mix_HaltMusic();
+    Mix_FreeMusic(music);
+    music = nullptr;
+    LOGGER_INFO("Music {} stopped, the decoder waited for the disk {} times", musicFilePath, musicStream->GetNumStalls());
+    musicStream.reset();
+    musicFilePath.clear();
+}
+
+void AudioEngine::Run()
+{
+#ifdef ENABLE_PROFILER
+    Profiler::SetThreadName("Audio");
+#endif
+    AudioCommand command;
+    while (true)
+    {
+        while (Pop(command))
+        {
+            Process(command);
+            numProcessed.fetch_add(1, std::memory_order_release);
+        }
+        if (!isRunning.load(std::memory_order_acquire) && numProcessed.load() == enqueuePosition.load())
+        {
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void AudioEngine::Process(const AudioCommand& command)
+{
+    if (command.type == AUDIO_COMMAND_STOP_ALL)
+    {
+        Mix_HaltChannel(-1);
+        voices.assign(AUDIO_NUM_VOICES, Voice());
+        lastStartMillisecs.clear();
+        return;
+    }
+
+    const double millisecs = SDL_GetPerformanceCounter() * 1000.0 / SDL_GetPerformanceFrequency();
+    if (command.sound >= static_cast<int>(lastStartMillisecs.size()))
+    {
+        lastStartMillisecs.resize(command.sound + 1, -AUDIO_RETRIGGER_MILLISECS);
+    }
+    if (millisecs - lastStartMillisecs[command.sound] < AUDIO_RETRIGGER_MILLISECS)
+    {
+        return;
+    }
+    const int voice = FindVoice(command);
+    if (voice < 0)
+    {
+        numDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (Mix_PlayChannel(voice, command.chunk, 0) < 0)
+    {
+        return;
+    }
+    Mix_Volume(voice, command.volume);
+    // Centered is the mixer's 255 on both sides, which takes the panning effect off the voice
+    const float right = 1.0f + std::min(command.pan, 0.0f);
+    const float left = 1.0f - std::max(command.pan, 0.0f);
+    Mix_SetPanning(voice, static_cast<Uint8>(255 * left), static_cast<Uint8>(255 * right));
+    voices[voice] = {command.sound, command.priority, command.volume, millisecs};
+    lastStartMillisecs[command.sound] = millisecs;
+}
+
+int AudioEngine::FindVoice(const AudioCommand& command)
+{
+    int freeVoice = -1;
+    int numSameSound = 0;
+    int oldestSameSound = -1;
+    int leastImportant = -1;
+    for (int voice = 0; voice < AUDIO_NUM_VOICES; voice++)
+    {
+        if (!Mix_Playing(voice))
+        {
+            freeVoice = freeVoice < 0 ? voice : freeVoice;
+            continue;
+        }
+        if (voices[voice].sound == command.sound)
+        {
+            numSameSound++;
+            if (oldestSameSound < 0 || voices[voice].startMillisecs < voices[oldestSameSound].startMillisecs)
+            {
+                oldestSameSound = voice;
+            }
+        }
+        const Voice& least = voices[std::max(leastImportant, 0)];
+        const bool isLessImportant = leastImportant < 0
+            || voices[voice].priority < least.priority
+            || (voices[voice].priority == least.priority && voices[voice].volume < least.volume)
+            || (voices[voice].priority == least.priority && voices[voice].volume == least.volume && voices[voice].startMillisecs < least.startMillisecs);
+        if (isLessImportant)
+        {
+            leastImportant = voice;
+        }
+    }
+
+    // A sound at its limit restarts on its oldest voice rather than taking another
+    int stolen;
+    if (numSameSound >= AUDIO_MAX_VOICES_PER_SOUND)
+    {
+        stolen = oldestSameSound;
+    }
+    else if (freeVoice >= 0)
+    {
+        return freeVoice;
+    }
+    else if (voices[leastImportant].priority <= command.priority)
+    {
+        stolen = leastImportant;
+    }
+    else
+    {
+        return -1;
+    }
+    Mix_HaltChannel(stolen);
+    numStolen.fetch_add(1, std::memory_order_relaxed);
+    return stolen;
+}
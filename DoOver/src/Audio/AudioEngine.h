@@ -0,0 +1,161 @@
+#ifndef AUDIOENGINE_H
+#define AUDIOENGINE_H
+
+#include "../AssetStore/AssetStore.h"
+#include "./MusicStream.h"
+#include <SDL2/SDL_mixer.h>
+#include <glm/glm.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+const int AUDIO_FREQUENCY = 44100;
+const int AUDIO_CHUNK_SIZE = 1024;
+// Mixer channels, a sound played with all of them busy steals one of lower priority
+const int AUDIO_NUM_VOICES = 32;
+// The same sound never plays on more voices at once, its oldest one is restarted instead
+const int AUDIO_MAX_VOICES_PER_SOUND = 4;
+// A sound started again this soon after is played only once, so rapid fire doesn't stack
+const double AUDIO_RETRIGGER_MILLISECS = 50.0;
+// Positioned sounds are heard this far past the edges of the camera, the ones further are
+// culled before they take a voice
+const int AUDIO_HEARING_MARGIN = 256;
+// Full volume up to this distance from the center of the camera, fading out to the edge of
+// the hearing range
+const float AUDIO_FULL_VOLUME_DISTANCE = 256.0f;
+// Quieter than this, of MIX_MAX_VOLUME, the sound isn't worth a voice
+const int AUDIO_MIN_VOLUME = 4;
+// How far to one side a sound is panned at most, 1 plays it in one ear only
+const float AUDIO_MAX_PAN = 0.8f;
+// Power of two, the commands pushed with the queue full are dropped
+const uint64_t AUDIO_COMMAND_QUEUE_CAPACITY = 1024;
+
+enum AudioPriority
+{
+    AUDIO_PRIORITY_LOW,
+    AUDIO_PRIORITY_NORMAL,
+    AUDIO_PRIORITY_HIGH
+};
+
+enum AudioCommandType
+{
+    AUDIO_COMMAND_PLAY,
+    AUDIO_COMMAND_STOP_ALL
+};
+
+struct AudioCommand
+{
+    AudioCommandType type;
+    AssetHandle sound;
+    // Resolved when pushed, the asset store is only read on the gameplay side
+    Mix_Chunk* chunk;
+    int priority;
+    // 0 to MIX_MAX_VOLUME
+    int volume;
+    // -1 on the left, 1 on the right
+    float pan;
+};
+
+// A sound played at a place in the world, see PlaySpatial
+struct SpatialSound
+{
+    AssetHandle sound;
+    glm::vec2 position;
+    int priority;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Audio engine
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The systems never call the mixer, Play only pushes a command into a lock-free queue and
+// the audio thread starts the sounds on a bounded pool of voices. When every voice is busy
+// the new sound steals a voice of the lowest priority, the quietest and then the oldest,
+// unless they all play something more important. The sounds are the chunks the asset store
+// preloaded.
+// The positioned sounds come in one batch per tick: the ones out of hearing of the camera
+// are culled there, and the rest are attenuated and panned by their distance to it.
+// The music is streamed from its file as it plays, see MusicStream.
+// Without an audio device (e.g. headless) it stays closed and the commands are ignored.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class AudioEngine
+{
+private:
+    // Bounded multi-producer single-consumer ring, like the log queue
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence;
+        AudioCommand command;
+    };
+
+    // Only touched by the audio thread
+    struct Voice
+    {
+        AssetHandle sound = INVALID_ASSET_HANDLE;
+        int priority = AUDIO_PRIORITY_LOW;
+        int volume = 0;
+        double startMillisecs = 0.0;
+    };
+
+    const AssetStore& assetStore;
+    std::unique_ptr<Slot[]> slots;
+    alignas(64) std::atomic<uint64_t> enqueuePosition{0};
+    alignas(64) uint64_t dequeuePosition = 0;
+    alignas(64) std::atomic<uint64_t> numProcessed{0};
+    std::atomic<bool> isRunning{false};
+    std::atomic<uint64_t> numDropped{0};
+    std::atomic<uint64_t> numStolen{0};
+    uint64_t numCulled = 0;
+    SDL_Rect listener = {0, 0, 0, 0};
+    // The loudest of each sound in the batch
+    std::vector<AudioCommand> spatialCommands;
+    std::unique_ptr<MusicStream> musicStream;
+    Mix_Music* music = nullptr;
+    std::string musicFilePath;
+    std::thread audioThread;
+    std::vector<Voice> voices;
+    // [asset handle] -> when the sound was last started
+    std::vector<double> lastStartMillisecs;
+
+    bool Push(const AudioCommand& command);
+    bool Pop(AudioCommand& command);
+    void Run();
+    void Process(const AudioCommand& command);
+    // Free, or stolen from a sound that matters less, -1 when there is none
+    int FindVoice(const AudioCommand& command);
+
+public:
+    AudioEngine(const AssetStore& assetStore);
+    ~AudioEngine();
+
+    // Opens the audio device and starts the audio thread, false when there is no device
+    bool Open();
+    void Close();
+    bool IsOpen() const { return isRunning.load(std::memory_order_relaxed); }
+
+    // From any thread, never blocks
+    void Play(AssetHandle sound, int priority = AUDIO_PRIORITY_NORMAL, int volume = MIX_MAX_VOLUME, float pan = 0.0f);
+    // The camera the positioned sounds are heard from, set once a tick
+    void SetListener(const SDL_Rect& camera) { listener = camera; }
+    // The positioned sounds of a tick, from the thread that sets the listener or one that
+    // runs exclusively. A sound played by several emitters of the batch is played once,
+    // by the loudest.
+    void PlaySpatial(const std::vector<SpatialSound>& sounds);
+    // Silences every voice and waits for the commands queued before, so the sounds can be
+    // unloaded once it returns
+    void StopAll();
+
+    // On the main thread, the track playing already goes on. Loops forever by default, and
+    // fades in over fadeInMillisecs.
+    bool PlayMusic(const std::string& filePath, int loops = -1, int fadeInMillisecs = 0);
+    void StopMusic();
+
+    // Commands dropped with the queue full, and voices taken from a playing sound
+    uint64_t GetNumDropped() const { return numDropped.load(std::memory_order_relaxed); }
+    uint64_t GetNumStolen() const { return numStolen.load(std::memory_order_relaxed); }
+    // Positioned sounds out of hearing
+    uint64_t GetNumCulled() const { return numCulled; }
+};
+
+#endif
@@ -0,0 +1,212 @@
+#include "./MusicStream.h"
+#include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
+#include <algorithm>
+#include <cstring>
+
+MusicStream::~MusicStream()
+{
+    Close();
+}
+
+bool MusicStream::Open(const std::string& filePath)
+{
+    file = std::fopen(filePath.c_str(), "rb");
+    if (!file)
+    {
+        Logger::Err("Unable to open the music " + filePath);
+        return false;
+    }
+    std::fseek(file, 0, SEEK_END);
+    fileSize = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    head.resize(std::min(fileSize, MUSIC_STREAM_HEAD_BYTES));
+    head.resize(std::fread(head.data(), 1, head.size(), file));
+    buffer.resize(MUSIC_STREAM_BUFFER_BYTES);
+    bufferStart = head.size();
+    bufferEnd = head.size();
+    position = 0;
+    numStalls = 0;
+    isRunning = true;
+    reader = std::thread(&MusicStream::Read, this);
+
+    rwops = SDL_AllocRW();
+    rwops->size = &MusicStream::SizeCallback;
+    rwops->seek = &MusicStream::SeekCallback;
+    rwops->read = &MusicStream::ReadCallback;
+    rwops->write = &MusicStream::WriteCallback;
+    rwops->close = &MusicStream::CloseCallback;
+    rwops->type = SDL_RWOPS_UNKNOWN;
+    rwops->hidden.unknown.data1 = this;
+    return true;
+}
+
+void MusicStream::Close()
+{
+    if (!file)
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isRunning = false;
+    }
+    spaceFree.notify_all();
+    dataReady.notify_all();
+    reader.join();
+    SDL_FreeRW(rwops);
+    rwops = nullptr;
+    std::fclose(file);
+    file = nullptr;
+}
+
+uint64_t MusicStream::GetNumStalls()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return numStalls;
+}
+
+void MusicStream::Read()
+{
+#ifdef ENABLE_PROFILER
+    Profiler::SetThreadName("Music");
+#endif
+    std::vector<uint8_t> chunk(MUSIC_STREAM_READ_BYTES);
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        spaceFree.wait(lock, [this]() { return !isRunning || (bufferEnd < fileSize && bufferEnd - bufferStart < MUSIC_STREAM_BUFFER_BYTES); });
+        if (!isRunning)
+        {
+            return;
+        }
+
+        // The disk is read unlocked, a seek meanwhile moves the buffer and the bytes are dropped
+        const int64_t offset = bufferEnd;
+        const int64_t numBytes = std::min({MUSIC_STREAM_READ_BYTES, MUSIC_STREAM_BUFFER_BYTES - (bufferEnd - bufferStart), fileSize - bufferEnd});
+        lock.unlock();
+        std::fseek(file, static_cast<long>(offset), SEEK_SET);
+        const int64_t numRead = std::fread(chunk.data(), 1, numBytes, file);
+        lock.lock();
+        if (bufferEnd != offset)
+        {
+            continue;
+        }
+        if (numRead == 0)
+        {
+            // Shorter than it was when opened, it ends here
+            fileSize = offset;
+            dataReady.notify_all();
+            continue;
+        }
+        const int64_t ringOffset = offset % MUSIC_STREAM_BUFFER_BYTES;
+        const int64_t numFirst = std::min(numRead, MUSIC_STREAM_BUFFER_BYTES - ringOffset);
+        std::memcpy(buffer.data() + ringOffset, chunk.data(), numFirst);
+        std::memcpy(buffer.data(), chunk.data() + numFirst, numRead - numFirst);
+        bufferEnd += numRead;
+        dataReady.notify_all();
+    }
+}
+
+size_t MusicStream::ReadBuffered(void* data, size_t size)
+{
+    uint8_t* bytes = static_cast<uint8_t*>(data);
+    size_t numCopied = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (numCopied < size && position < fileSize && isRunning)
+    {
+        if (position < static_cast<int64_t>(head.size()))
+        {
+            const int64_t numBytes = std::min<int64_t>(size - numCopied, head.size() - position);
+            std::memcpy(bytes + numCopied, head.data() + position, numBytes);
+            position += numBytes;
+            numCopied += numBytes;
+            continue;
+        }
+
+        // Past what is buffered the read-ahead starts over from here, and the decoder waits
+        if (position < bufferStart || position > bufferEnd)
+        {
+            bufferStart = position;
+            bufferEnd = position;
+            spaceFree.notify_one();
+        }
+        if (position == bufferEnd)
+        {
+            numStalls++;
+            dataReady.wait(lock, [this]() { return !isRunning || position != bufferEnd || position >= fileSize; });
+            continue;
+        }
+
+        const int64_t numBytes = std::min<int64_t>(size - numCopied, bufferEnd - position);
+        const int64_t ringOffset = position % MUSIC_STREAM_BUFFER_BYTES;
+        const int64_t numFirst = std::min(numBytes, MUSIC_STREAM_BUFFER_BYTES - ringOffset);
+        std::memcpy(bytes + numCopied, buffer.data() + ringOffset, numFirst);
+        std::memcpy(bytes + numCopied + numFirst, buffer.data(), numBytes - numFirst);
+        position += numBytes;
+        numCopied += numBytes;
+        // What was read makes room for the read-ahead, a little is kept for the short seeks back
+        bufferStart = std::max(bufferStart, position - MUSIC_STREAM_READ_BYTES);
+        spaceFree.notify_one();
+    }
+    return numCopied;
+}
+
+int64_t MusicStream::Seek(int64_t offset, int whence)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    switch (whence)
+    {
+    case RW_SEEK_CUR:
+        offset += position;
+        break;
+    case RW_SEEK_END:
+        offset += fileSize;
+        break;
+    default:
+        break;
+    }
+    position = std::max<int64_t>(0, std::min(offset, fileSize));
+
+    // Back in the head, the read-ahead goes on from its end while the head plays
+    const int64_t bufferedFrom = std::max<int64_t>(position, head.size());
+    if (bufferedFrom < bufferStart || bufferedFrom > bufferEnd)
+    {
+        bufferStart = bufferedFrom;
+        bufferEnd = bufferedFrom;
+        spaceFree.notify_one();
+    }
+    return position;
+}
+
+Sint64 SDLCALL MusicStream::SizeCallback(SDL_RWops* context)
+{
+    MusicStream* stream = static_cast<MusicStream*>(context->hidden.unknown.data1);
+    std::lock_guard<std::mutex> lock(stream->mutex);
+    return stream->fileSize;
+}
+
+Sint64 SDLCALL MusicStream::SeekCallback(SDL_RWops* context, Sint64 offset, int whence)
+{
+    return static_cast<MusicStream*>(context->hidden.unknown.data1)->Seek(offset, whence);
+}
+
+size_t SDLCALL MusicStream::ReadCallback(SDL_RWops* context, void* data, size_t size, size_t count)
+{
+    if (size == 0)
+    {
+        return 0;
+    }
+    return static_cast<MusicStream*>(context->hidden.unknown.data1)->ReadBuffered(data, size * count) / size;
+}
+
+size_t SDLCALL MusicStream::WriteCallback(SDL_RWops* context, const void* data, size_t size, size_t count)
+{
+    return 0;
+}
+
+// The stream closes itself, after the mixer freed the music
+int SDLCALL MusicStream::CloseCallback(SDL_RWops* context)
+{
+    return 0;
+}
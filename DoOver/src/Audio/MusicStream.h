@@ -0,0 +1,73 @@
+#ifndef MUSICSTREAM_H
+#define MUSICSTREAM_H
+
+#include <SDL2/SDL.h>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// How far ahead of the decoder the file is read
+const int64_t MUSIC_STREAM_BUFFER_BYTES = 256 * 1024;
+// The reader thread's reads from the disk
+const int64_t MUSIC_STREAM_READ_BYTES = 16 * 1024;
+// Kept for good, the headers and the loops seek back to the start of the track
+const int64_t MUSIC_STREAM_HEAD_BYTES = 64 * 1024;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Music stream
+/////////////////////////////////////////////////////////////////////////////////////////////
+// A music file read ahead by a background thread, for the mixer to decode the track as it
+// plays instead of loading it whole. The mixer reads through the SDL_RWops from the audio
+// callback, which is served from the read-ahead buffer and only waits on the disk when the
+// decoder seeks somewhere that isn't buffered. The start of the file stays in memory, so a
+// looping track starts over without a wait.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class MusicStream
+{
+private:
+    std::FILE* file = nullptr;
+    int64_t fileSize = 0;
+    std::vector<uint8_t> head;
+    // Ring holding the file from bufferStart to bufferEnd, the decoder reads at position
+    std::vector<uint8_t> buffer;
+    int64_t bufferStart = 0;
+    int64_t bufferEnd = 0;
+    int64_t position = 0;
+    bool isRunning = false;
+    // Reads of the decoder that had to wait for the disk
+    uint64_t numStalls = 0;
+    std::mutex mutex;
+    std::condition_variable dataReady;
+    std::condition_variable spaceFree;
+    std::thread reader;
+    SDL_RWops* rwops = nullptr;
+
+    void Read();
+    size_t ReadBuffered(void* data, size_t size);
+    int64_t Seek(int64_t offset, int whence);
+
+    static Sint64 SDLCALL SizeCallback(SDL_RWops* context);
+    static Sint64 SDLCALL SeekCallback(SDL_RWops* context, Sint64 offset, int whence);
+    static size_t SDLCALL ReadCallback(SDL_RWops* context, void* data, size_t size, size_t count);
+    static size_t SDLCALL WriteCallback(SDL_RWops* context, const void* data, size_t size, size_t count);
+    static int SDLCALL CloseCallback(SDL_RWops* context);
+
+public:
+    MusicStream() = default;
+    ~MusicStream();
+    MusicStream(const MusicStream&) = delete;
+    MusicStream& operator=(const MusicStream&) = delete;
+
+    // Starts reading ahead, the SDL_RWops is what the mixer loads the music from
+    bool Open(const std::string& filePath);
+    // After the mixer is done with the music
+    void Close();
+    SDL_RWops* GetRWops() const { return rwops; }
+    uint64_t GetNumStalls();
+};
+
+#endif
@@ -0,0 +1,38 @@
+#include "Clock.h"
+#include <SDL2/SDL.h>
+
+double SystemClock::GetMillisecs()
+{
+    return SDL_GetPerformanceCounter() * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+void SystemClock::Wait(double millisecs)
+{
+    const double deadline = GetMillisecs() + millisecs;
+    const double sleepMillisecs = millisecs - CLOCK_SPIN_MILLISECS;
+    if (sleepMillisecs >= 1.0)
+    {
+        SDL_Delay(static_cast<Uint32>(sleepMillisecs));
+    }
+    while (GetMillisecs() < deadline)
+    {
+    }
+}
+
+double ManualClock::GetMillisecs()
+{
+    return millisecs;
+}
+
+void ManualClock::Wait(double millisecs)
+{
+    Advance(millisecs);
+}
+
+void ManualClock::Advance(double millisecs)
+{
+    if (millisecs > 0.0)
+    {
+        this->millisecs += millisecs;
+    }
+}
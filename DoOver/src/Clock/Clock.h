@@ -0,0 +1,51 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+// The end of a wait is spun on instead of slept, the sleeps of some platforms are only
+// accurate to a millisecond or worse
+const double CLOCK_SPIN_MILLISECS = 2.0;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Clock
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Where the game loop reads the time and waits for the next frame. The system clock
+// follows the wall time, the manual clock only moves when it is told to: waiting on it
+// returns at once, so a headless game runs as fast as it can with exact frame times.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class Clock
+{
+public:
+    virtual ~Clock() = default;
+
+    // Milliseconds since an arbitrary start
+    virtual double GetMillisecs() = 0;
+    virtual void Wait(double millisecs) = 0;
+};
+
+class SystemClock: public Clock
+{
+public:
+    SystemClock() = default;
+    virtual ~SystemClock() override = default;
+
+    virtual double GetMillisecs() override;
+    // Sleeps, then spins through the last CLOCK_SPIN_MILLISECS
+    virtual void Wait(double millisecs) override;
+};
+
+class ManualClock: public Clock
+{
+private:
+    double millisecs = 0.0;
+
+public:
+    ManualClock() = default;
+    virtual ~ManualClock() override = default;
+
+    virtual double GetMillisecs() override;
+    // Moves the time forward without sleeping
+    virtual void Wait(double millisecs) override;
+    void Advance(double millisecs);
+};
+
+#endif
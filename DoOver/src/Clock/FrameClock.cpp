@@ -0,0 +1,63 @@
+#include "FrameClock.h"
+#include "../Logger/Logger.h"
+#include <cmath>
+
+FrameClock::FrameClock(double deltaTime)
+{
+    this->deltaTime = deltaTime;
+    Logger::Log("FrameClock constructor called!");
+}
+
+FrameClock::~FrameClock()
+{
+    Logger::Log("FrameClock destructor called!");
+}
+
+void FrameClock::Tick()
+{
+    tick++;
+    millisecs += deltaTime * 1000.0;
+}
+
+void FrameClock::Reset(uint32_t tick)
+{
+    this->tick = tick;
+    millisecs = tick * deltaTime * 1000.0;
+}
+
+uint32_t FrameClock::GetTicksAfter(double delayMillisecs) const
+{
+    if (delayMillisecs < 0.0)
+    {
+        return 1;
+    }
+    return static_cast<uint32_t>(std::floor(delayMillisecs / (deltaTime * 1000.0))) + 1;
+}
+
+double FrameClock::Scale(double frameTime) const
+{
+    return isPaused ? 0.0 : frameTime * timeScale;
+}
+
+void FrameClock::SetDeltaTime(double deltaTime)
+{
+    if (deltaTime > 0.0)
+    {
+        this->deltaTime = deltaTime;
+    }
+}
+
+void FrameClock::SetTimeScale(double timeScale)
+{
+    if (timeScale <= 0.0)
+    {
+        Logger::War("The time scale has to be positive, pause the clock instead");
+        return;
+    }
+    this->timeScale = timeScale;
+}
+
+void FrameClock::SetPaused(bool isPaused)
+{
+    this->isPaused = isPaused;
+}
@@ -0,0 +1,47 @@
+#ifndef FRAMECLOCK_H
+#define FRAMECLOCK_H
+
+#include <cstdint>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Frame clock
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The game time the systems and components see. It is sampled once per simulation tick and
+// only moves by the fixed tick step, so a replay of the same ticks sees the same times, fast
+// forward runs more ticks per frame instead of longer ones, and a paused game stops the ticks.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class FrameClock
+{
+private:
+    uint32_t tick = 0;
+    double deltaTime;
+    double millisecs = 0.0;
+    double timeScale = 1.0;
+    bool isPaused = false;
+
+public:
+    FrameClock(double deltaTime);
+    ~FrameClock();
+
+    // Moves the game time forward by one tick step
+    void Tick();
+    // Restarts the game time at a tick, for replays
+    void Reset(uint32_t tick = 0);
+
+    // The real seconds of a frame converted to the game seconds to simulate
+    double Scale(double frameTime) const;
+
+    uint32_t GetTick() const { return tick; }
+    // Ticks until a delay has fully passed, at least one: the game time is then past it
+    uint32_t GetTicksAfter(double delayMillisecs) const;
+    double GetMillisecs() const { return millisecs; }
+    double GetDeltaTime() const { return deltaTime; }
+    void SetDeltaTime(double deltaTime);
+
+    double GetTimeScale() const { return timeScale; }
+    void SetTimeScale(double timeScale);
+    bool IsPaused() const { return isPaused; }
+    void SetPaused(bool isPaused);
+};
+
+#endif
@@ -0,0 +1,64 @@
+#include "FramePacer.h"
+#include "../Logger/Logger.h"
+#include <cstring>
+
+bool FramePacer::FindPresentMode(const std::string& name, PresentMode& presentMode)
+{
+    for (int i = PRESENT_MODE_VSYNC; i <= PRESENT_MODE_UNCAPPED; i++)
+    {
+        if (name == GetName(static_cast<PresentMode>(i)))
+        {
+            presentMode = static_cast<PresentMode>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* FramePacer::GetName(PresentMode presentMode)
+{
+    switch (presentMode)
+    {
+    case PRESENT_MODE_ADAPTIVE:
+        return "adaptive";
+    case PRESENT_MODE_UNCAPPED:
+        return "uncapped";
+    default:
+        return "vsync";
+    }
+}
+
+void FramePacer::Configure(PresentMode presentMode, int targetFps)
+{
+    this->presentMode = presentMode;
+    targetFrameMillisecs = presentMode == PRESENT_MODE_UNCAPPED || targetFps <= 0 ? 0.0 : 1000.0 / targetFps;
+}
+
+Uint32 FramePacer::GetRendererFlags() const
+{
+    return presentMode == PRESENT_MODE_UNCAPPED ? 0 : SDL_RENDERER_PRESENTVSYNC;
+}
+
+void FramePacer::Apply(SDL_Renderer* renderer) const
+{
+    if (presentMode != PRESENT_MODE_ADAPTIVE)
+    {
+        return;
+    }
+    // The renderer's context is current, its swap interval is the one set
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(renderer, &info) != 0 || std::strncmp(info.name, "opengl", 6) != 0 || SDL_GL_SetSwapInterval(-1) != 0)
+    {
+        Logger::War("Adaptive vsync isn't available, using vsync");
+    }
+}
+
+void FramePacer::WaitForNextFrame(Clock& clock, double frameStartMillisecs) const
+{
+    const double timeToWait = targetFrameMillisecs - (clock.GetMillisecs() - frameStartMillisecs);
+    // Past a frame, the clock moved in a way the pacer can't make up for
+    if (timeToWait > 0.0 && timeToWait <= targetFrameMillisecs)
+    {
+        clock.Wait(timeToWait);
+    }
+}
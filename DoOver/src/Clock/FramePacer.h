@@ -0,0 +1,54 @@
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include "Clock.h"
+#include <SDL2/SDL.h>
+#include <string>
+
+const int DEFAULT_TARGET_FPS = 60;
+
+enum PresentMode
+{
+    // Presents wait for the vertical blank
+    PRESENT_MODE_VSYNC,
+    // Like vsync, a frame that misses the blank is presented at once instead of a frame later
+    PRESENT_MODE_ADAPTIVE,
+    // Neither vsync nor a frame rate cap, to measure the raw throughput
+    PRESENT_MODE_UNCAPPED
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Frame pacer
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Keeps the frames at the target rate: the renderer is created with the present mode, and
+// the game loop waits out what is left of each frame on the clock, which sleeps and then
+// spins so the frames start on time. The uncapped mode never waits.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class FramePacer
+{
+private:
+    PresentMode presentMode = PRESENT_MODE_VSYNC;
+    // 0 when the frames aren't capped
+    double targetFrameMillisecs = 1000.0 / DEFAULT_TARGET_FPS;
+
+public:
+    FramePacer() = default;
+
+    // From the names of the command line (e.g. "adaptive"), false when unknown
+    static bool FindPresentMode(const std::string& name, PresentMode& presentMode);
+    static const char* GetName(PresentMode presentMode);
+
+    // A target of 0 leaves the frame rate to the vsync
+    void Configure(PresentMode presentMode, int targetFps);
+    PresentMode GetPresentMode() const { return presentMode; }
+    double GetTargetFrameMillisecs() const { return targetFrameMillisecs; }
+
+    // What the renderer is created with
+    Uint32 GetRendererFlags() const;
+    // Turns the adaptive vsync on once the renderer is there, only the OpenGL drivers have it
+    void Apply(SDL_Renderer* renderer) const;
+    // Waits until the frame started at frameStartMillisecs lasted the target frame time
+    void WaitForNextFrame(Clock& clock, double frameStartMillisecs) const;
+};
+
+#endif
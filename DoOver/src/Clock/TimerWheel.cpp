@@ -0,0 +1,84 @@
+#include "TimerWheel.h"
+
+void TimerWheel::Insert(const Timer& timer)
+{
+    // The level is picked by how far away the timer is, the slot by its tick at that level
+    const uint32_t delay = timer.tick - currentTick;
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 && delay >= (1u << (TIMER_WHEEL_SLOT_BITS * (level + 1))))
+    {
+        level++;
+    }
+    const int slot = (timer.tick >> (TIMER_WHEEL_SLOT_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+    slots[level][slot].push_back(timer);
+}
+
+void TimerWheel::Cascade(int level)
+{
+    const int slot = (currentTick >> (TIMER_WHEEL_SLOT_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+    cascadeScratch.swap(slots[level][slot]);
+    for (const auto& timer: cascadeScratch)
+    {
+        Insert(timer);
+    }
+    cascadeScratch.clear();
+}
+
+uint32_t TimerWheel::Schedule(uint32_t tick, TimerTag tag, Entity entity)
+{
+    std::lock_guard<std::mutex> lock(scheduleMutex);
+    // The slot of the current tick was already emptied
+    const uint32_t dueTick = static_cast<int32_t>(tick - currentTick) > 0 ? tick : currentTick + 1;
+    Insert({dueTick, tag, entity});
+    numTimers++;
+    return dueTick;
+}
+
+void TimerWheel::Advance(uint32_t tick)
+{
+    for (auto& timers: dueTimers)
+    {
+        timers.clear();
+    }
+    while (currentTick != tick)
+    {
+        currentTick++;
+
+        // Crossing into a new slot of a higher level spreads its timers over the lower levels,
+        // the highest level first so they trickle down to the first one
+        int numLevelsCrossed = 1;
+        while (numLevelsCrossed < TIMER_WHEEL_LEVELS && (currentTick & ((1u << (TIMER_WHEEL_SLOT_BITS * numLevelsCrossed)) - 1)) == 0)
+        {
+            numLevelsCrossed++;
+        }
+        for (int level = numLevelsCrossed - 1; level >= 1; level--)
+        {
+            Cascade(level);
+        }
+
+        auto& slot = slots[0][currentTick & (TIMER_WHEEL_SLOTS - 1)];
+        for (const auto& timer: slot)
+        {
+            dueTimers[timer.tag].push_back(timer);
+        }
+        numTimers -= slot.size();
+        slot.clear();
+    }
+}
+
+void TimerWheel::Reset(uint32_t tick)
+{
+    for (auto& level: slots)
+    {
+        for (auto& slot: level)
+        {
+            slot.clear();
+        }
+    }
+    for (auto& timers: dueTimers)
+    {
+        timers.clear();
+    }
+    numTimers = 0;
+    currentTick = tick;
+}
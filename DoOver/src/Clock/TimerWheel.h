@@ -0,0 +1,74 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include "../ECS/ECS.h"
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Four levels of 256 slots cover every delay a 32-bit tick can express
+const int TIMER_WHEEL_LEVELS = 4;
+const int TIMER_WHEEL_SLOT_BITS = 8;
+const int TIMER_WHEEL_SLOTS = 1 << TIMER_WHEEL_SLOT_BITS;
+
+// What a timer is for, each system that schedules timers reads the due ones of its tag
+enum TimerTag
+{
+    TIMER_PROJECTILE_EMISSION,
+    TIMER_PROJECTILE_EXPIRY,
+    NUM_TIMER_TAGS
+};
+
+struct Timer
+{
+    uint32_t tick;
+    TimerTag tag;
+    Entity entity;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Timer wheel
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Entity events scheduled for a future simulation tick. The timers hang in a hierarchical
+// wheel: the first level has one slot per tick, each next one a slot per 256 ticks of the
+// previous; a slot is spread over the lower level when the wheel reaches it. Scheduling is
+// O(1) and a tick only touches the timers that are due, however many are waiting.
+// Timers can't be cancelled, the systems check on a due timer that it is still the one
+// they expect (e.g. against a tick stored in the component) and drop it otherwise.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class TimerWheel
+{
+private:
+    uint32_t currentTick = 0;
+    int numTimers = 0;
+    std::array<std::array<std::vector<Timer>, TIMER_WHEEL_SLOTS>, TIMER_WHEEL_LEVELS> slots;
+    // [tag] -> timers due on the current tick
+    std::array<std::vector<Timer>, NUM_TIMER_TAGS> dueTimers;
+    std::vector<Timer> cascadeScratch;
+    // Systems running in parallel may schedule at the same time
+    std::mutex scheduleMutex;
+
+    void Insert(const Timer& timer);
+    void Cascade(int level);
+
+public:
+    TimerWheel() = default;
+
+    // A tick that already passed comes due on the next Advance, returns the tick it is due on
+    uint32_t Schedule(uint32_t tick, TimerTag tag, Entity entity);
+
+    // Moves the wheel to the tick, call once per simulation tick before the systems run
+    void Advance(uint32_t tick);
+    // Restarts the empty wheel at a tick, for replays
+    void Reset(uint32_t tick = 0);
+
+    // Timers of the tag due on the current tick, in the order they were scheduled for a tick
+    const std::vector<Timer>& GetDueTimers(TimerTag tag) const { return dueTimers[tag]; }
+
+    uint32_t GetCurrentTick() const { return currentTick; }
+    // Timers waiting, the due ones excluded
+    int GetNumTimers() const { return numTimers; }
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef AICOMPONENT_H
+#define AICOMPONENT_H
+
+#include "../ECS/Reflection.h"
+#include <glm/glm.hpp>
+
+enum AIState
+{
+    // Waits at home for the target to come in sight
+    AI_STATE_IDLE,
+    // Drives to the target
+    AI_STATE_CHASE,
+    // Stops and aims at the target
+    AI_STATE_ATTACK,
+    // Lost the target, drives back home
+    AI_STATE_RETURN
+};
+
+inline const char* const AI_STATE_NAMES[] = {"Idle", "Chase", "Attack", "Return"};
+
+// The state machine of an enemy, stepped by the AISystem a few times per second
+struct AIComponent
+{
+    AIState state;
+    // In world pixels, from the entity to the target
+    float sightRange;
+    float attackRange;
+    // Where the entity goes back to, where it was placed by default
+    glm::vec2 home;
+
+    AIComponent(float sightRange = 0.0f, float attackRange = 0.0f, glm::vec2 home = glm::vec2(0))
+    {
+        this->state = AI_STATE_IDLE;
+        this->sightRange = sightRange;
+        this->attackRange = attackRange;
+        this->home = home;
+    }
+};
+
+REGISTER_COMPONENT(AIComponent, 16)
+REFLECT_COMPONENT(AIComponent,
+    REFLECT_ENUM_FIELD(state, AI_STATE_NAMES),
+    REFLECT_FIELD(sightRange),
+    REFLECT_FIELD(attackRange),
+    REFLECT_FIELD(home))
+
+#endif /* AICOMPONENT_H */
@@ -1,7 +1,8 @@
 #ifndef ANIMATIONCOMPONENT_H
 #define ANIMATIONCOMPONENT_H
 
-#include <SDL2/SDL.h>
+#include "../ECS/Reflection.h"
+#include <cstdint>
 
 struct AnimationComponent
 {
@@ -9,16 +10,34 @@ struct AnimationComponent
     int currentFrame;
     int frameSpeedRate;
     bool isLoop;
-    int startTime;
+    // Game time in milliseconds, from the frame clock
+    double startTime;
+    // The clip of the animation library played, with no clip the AnimationSystem makes one
+    // from numFrames, frameSpeedRate and isLoop over the sprite
+    int clip;
+    // Time spent in the current frame
+    uint32_t frameMicrosecs;
 
-    AnimationComponent(int numFrames = 1, int frameSpeedRate = 1, bool isLoop = true)
+    AnimationComponent(int numFrames = 1, int frameSpeedRate = 1, bool isLoop = true, double startTime = 0.0, int clip = -1)
     {
         this->numFrames = numFrames;
-        this->currentFrame = 1;
+        this->currentFrame = 0;
         this->frameSpeedRate = frameSpeedRate;
         this->isLoop = isLoop;
-        this->startTime = SDL_GetTicks();
+        this->startTime = startTime;
+        this->clip = clip;
+        this->frameMicrosecs = 0;
     }
 };
 
-#endif
\ No newline at end of file
+REGISTER_COMPONENT(AnimationComponent, 3)
+REFLECT_COMPONENT(AnimationComponent,
+    REFLECT_FIELD(numFrames),
+    REFLECT_FIELD(currentFrame),
+    REFLECT_FIELD(frameSpeedRate),
+    REFLECT_FIELD(isLoop),
+    REFLECT_FIELD(startTime),
+    REFLECT_FIELD(clip),
+    REFLECT_FIELD(frameMicrosecs))
+
+#endif
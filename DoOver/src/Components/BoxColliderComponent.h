@@ -1,20 +1,66 @@
 #ifndef BOXCOLLIDERCOMPONENT_H
 #define BOXCOLLIDERCOMPONENT_H
 
+#include "../ECS/Reflection.h"
 #include <glm/glm.hpp>
+#include <cstdint>
 
-struct BoxColliderComponent
+// Two colliders are only tested when each one's layer is in the other's mask
+enum CollisionLayer
+{
+    COLLISION_LAYER_DEFAULT = 1 << 0,
+    COLLISION_LAYER_PLAYER = 1 << 1,
+    COLLISION_LAYER_ENEMY = 1 << 2,
+    COLLISION_LAYER_OBSTACLE = 1 << 3,
+    COLLISION_LAYER_FRIENDLY_PROJECTILE = 1 << 4,
+    COLLISION_LAYER_ENEMY_PROJECTILE = 1 << 5
+};
+
+const uint32_t COLLISION_MASK_ALL = 0xFFFFFFFF;
+
+// Projectiles never test against each other, nor against their own side
+const uint32_t COLLISION_MASK_FRIENDLY_PROJECTILE = COLLISION_LAYER_DEFAULT | COLLISION_LAYER_ENEMY | COLLISION_LAYER_OBSTACLE;
+const uint32_t COLLISION_MASK_ENEMY_PROJECTILE = COLLISION_LAYER_DEFAULT | COLLISION_LAYER_PLAYER | COLLISION_LAYER_OBSTACLE;
+
+// The box fields lead in floats, the same as the transforms they are added to
+struct alignas(16) BoxColliderComponent
 {
-    int width;
-    int height;
     glm::vec2 offset;
+    float width;
+    float height;
+    uint32_t layer;
+    uint32_t mask;
+    // Static colliders never move, they must be flagged when the component is added
+    bool isStatic;
+    // Fast moving colliders are swept from their previous position so they can't tunnel
+    bool isContinuous;
+    // Triggers report their overlaps without a response, nothing is pushed out of them nor hit
+    bool isTrigger;
 
-    BoxColliderComponent(int width = 0, int height = 0, glm::vec2 offset = glm::vec2(0))
+    BoxColliderComponent(float width = 0.0f, float height = 0.0f, glm::vec2 offset = glm::vec2(0), uint32_t layer = COLLISION_LAYER_DEFAULT, uint32_t mask = COLLISION_MASK_ALL, bool isStatic = false, bool isContinuous = false, bool isTrigger = false)
     {
         this->width = width;
         this->height = height;
         this->offset = offset;
+        this->layer = layer;
+        this->mask = mask;
+        this->isStatic = isStatic;
+        this->isContinuous = isContinuous;
+        this->isTrigger = isTrigger;
     }
 };
 
+static_assert(sizeof(BoxColliderComponent) == 32, "BoxColliderComponent is laid out for two per cache line");
+
+REGISTER_COMPONENT(BoxColliderComponent, 4)
+REFLECT_COMPONENT(BoxColliderComponent,
+    REFLECT_FIELD(offset),
+    REFLECT_FIELD(width),
+    REFLECT_FIELD(height),
+    REFLECT_FIELD(layer),
+    REFLECT_FIELD(mask),
+    REFLECT_READONLY_FIELD(isStatic),
+    REFLECT_FIELD(isContinuous),
+    REFLECT_FIELD(isTrigger))
+
 #endif
\ No newline at end of file
@@ -1,9 +1,26 @@
 #ifndef CAMERAFOLLOWCOMPONENT_H
 #define CAMERAFOLLOWCOMPONENT_H
 
+#include "../ECS/Reflection.h"
+
 struct CameraFollowComponent
 {
-    CameraFollowComponent() = default;
+    // The split-screen view that follows the entity
+    int viewportIndex;
+    // How fast the camera catches up, the gap shrinks by e^-damping every second, 0 snaps to
+    // the entity
+    float damping;
+
+    CameraFollowComponent(int viewportIndex = 0, float damping = 0.0f)
+    {
+        this->viewportIndex = viewportIndex;
+        this->damping = damping;
+    }
 };
 
+REGISTER_COMPONENT(CameraFollowComponent, 6)
+REFLECT_RENDER_COMPONENT(CameraFollowComponent,
+    REFLECT_READONLY_FIELD(viewportIndex),
+    REFLECT_FIELD(damping))
+
 #endif /* CAMERAFOLLOWCOMPONENT_H */
@@ -0,0 +1,28 @@
+#ifndef DEATHEFFECTCOMPONENT_H
+#define DEATHEFFECTCOMPONENT_H
+
+#include "../ECS/Reflection.h"
+#include "../AssetStore/AssetHandle.h"
+#include <string>
+
+// What is left behind when the entity dies, played by the DeathSystem
+struct DeathEffectComponent
+{
+    // The sprite of the wreck, none when the entity leaves nothing
+    AssetHandle wreckAssetHandle;
+    // Particles thrown out of the entity
+    int burstCount;
+
+    DeathEffectComponent(const std::string& wreckAssetId = "", int burstCount = 0)
+    {
+        this->wreckAssetHandle = GetAssetHandle(wreckAssetId);
+        this->burstCount = burstCount;
+    }
+};
+
+REGISTER_COMPONENT(DeathEffectComponent, 17)
+REFLECT_COMPONENT(DeathEffectComponent,
+    REFLECT_ASSET_FIELD(wreckAssetHandle),
+    REFLECT_FIELD(burstCount))
+
+#endif
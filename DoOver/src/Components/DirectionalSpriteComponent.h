@@ -0,0 +1,32 @@
+#ifndef DIRECTIONALSPRITECOMPONENT_H
+#define DIRECTIONALSPRITECOMPONENT_H
+
+#include "../ECS/Reflection.h"
+
+// The rows of a directional sprite, top to bottom, as the directional textures are loaded
+enum SpriteDirection
+{
+    SPRITE_DIRECTION_UP,
+    SPRITE_DIRECTION_RIGHT,
+    SPRITE_DIRECTION_DOWN,
+    SPRITE_DIRECTION_LEFT
+};
+
+inline const char* const SPRITE_DIRECTION_NAMES[] = {"Up", "Right", "Down", "Left"};
+
+// Faces the sprite where the entity moves, by picking the row of its source rectangle
+struct DirectionalSpriteComponent
+{
+    SpriteDirection direction;
+
+    DirectionalSpriteComponent(SpriteDirection direction = SPRITE_DIRECTION_RIGHT)
+    {
+        this->direction = direction;
+    }
+};
+
+REGISTER_COMPONENT(DirectionalSpriteComponent, 18)
+REFLECT_RENDER_COMPONENT(DirectionalSpriteComponent,
+    REFLECT_ENUM_FIELD(direction, SPRITE_DIRECTION_NAMES))
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef DORMANTCOMPONENT_H
+#define DORMANTCOMPONENT_H
+
+#include "../ECS/Reflection.h"
+
+// Tags an entity far from the camera, the systems excluding it leave the entity alone until
+// the ActivitySystem wakes it up again
+struct DormantComponent
+{
+};
+
+REGISTER_COMPONENT(DormantComponent, 11)
+REFLECT_COMPONENT(DormantComponent)
+
+#endif /* DORMANTCOMPONENT_H */
@@ -0,0 +1,22 @@
+#ifndef FLOWFOLLOWCOMPONENT_H
+#define FLOWFOLLOWCOMPONENT_H
+
+#include "../ECS/Reflection.h"
+
+// Drives the entity along the flow field shared by every entity going to the same goal
+struct FlowFollowComponent
+{
+    // In world pixels per second
+    float speed;
+
+    FlowFollowComponent(float speed = 0.0f)
+    {
+        this->speed = speed;
+    }
+};
+
+REGISTER_COMPONENT(FlowFollowComponent, 15)
+REFLECT_COMPONENT(FlowFollowComponent,
+    REFLECT_FIELD(speed))
+
+#endif /* FLOWFOLLOWCOMPONENT_H */
@@ -1,6 +1,7 @@
 #ifndef HEALTHCOMPONENT_H
 #define HEALTHCOMPONENT_H
 
+#include "../ECS/Reflection.h"
 
 struct HealthComponent
 {
@@ -12,5 +13,8 @@ struct HealthComponent
     }
 };
 
+REGISTER_COMPONENT(HealthComponent, 9)
+REFLECT_COMPONENT(HealthComponent,
+    REFLECT_FIELD(healthPercentage))
 
 #endif /* HEALTHCOMPONENT_H */
@@ -0,0 +1,33 @@
+#ifndef HIERARCHYCOMPONENT_H
+#define HIERARCHYCOMPONENT_H
+
+#include "../ECS/ECS.h"
+#include <glm/glm.hpp>
+
+// Attaches the entity to a parent, e.g. a turret to its tank. The transform of the entity is
+// then worked out by the HierarchySystem from the parent's and these local values, relative
+// to the parent's position, scale and rotation.
+struct HierarchyComponent
+{
+    Entity parent;
+    glm::vec2 localPosition;
+    glm::vec2 localScale;
+    float localRotation;
+
+    HierarchyComponent(Entity parent = Entity(0, 0, 0), glm::vec2 localPosition = glm::vec2(0), glm::vec2 localScale = glm::vec2(1, 1), float localRotation = 0.0f)
+        : parent(parent)
+    {
+        this->localPosition = localPosition;
+        this->localScale = localScale;
+        this->localRotation = localRotation;
+    }
+};
+
+REGISTER_COMPONENT(HierarchyComponent, 12)
+REFLECT_COMPONENT(HierarchyComponent,
+    REFLECT_FIELD(parent),
+    REFLECT_FIELD(localPosition),
+    REFLECT_FIELD(localScale),
+    REFLECT_FIELD(localRotation))
+
+#endif /* HIERARCHYCOMPONENT_H */
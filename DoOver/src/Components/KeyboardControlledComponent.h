@@ -1,6 +1,7 @@
 #ifndef KeyboardControlledComponent_H
 #define KeyboardControlledComponent_H
 
+#include "../ECS/Reflection.h"
 #include <glm/glm.hpp>
 
 struct KeyboardControlledComponent
@@ -19,4 +20,11 @@ struct KeyboardControlledComponent
     }
 };
 
+REGISTER_COMPONENT(KeyboardControlledComponent, 5)
+REFLECT_COMPONENT(KeyboardControlledComponent,
+    REFLECT_FIELD(upVelocity),
+    REFLECT_FIELD(rightVelocity),
+    REFLECT_FIELD(downVelocity),
+    REFLECT_FIELD(leftVelocity))
+
 #endif /* KeyboardControlledComponent_H */
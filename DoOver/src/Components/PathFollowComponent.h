@@ -0,0 +1,26 @@
+#ifndef PATHFOLLOWCOMPONENT_H
+#define PATHFOLLOWCOMPONENT_H
+
+#include "../ECS/Reflection.h"
+#include <glm/glm.hpp>
+
+struct PathFollowComponent
+{
+    // Where the entity drives to around the blocked tiles, a new goal asks for a new path
+    glm::vec2 goal;
+    // In world pixels per second
+    float speed;
+
+    PathFollowComponent(glm::vec2 goal = glm::vec2(0), float speed = 0.0f)
+    {
+        this->goal = goal;
+        this->speed = speed;
+    }
+};
+
+REGISTER_COMPONENT(PathFollowComponent, 14)
+REFLECT_COMPONENT(PathFollowComponent,
+    REFLECT_FIELD(goal),
+    REFLECT_FIELD(speed))
+
+#endif /* PATHFOLLOWCOMPONENT_H */
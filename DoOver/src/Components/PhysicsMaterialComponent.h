@@ -0,0 +1,32 @@
+#ifndef PHYSICSMATERIALCOMPONENT_H
+#define PHYSICSMATERIALCOMPONENT_H
+
+#include "../ECS/Reflection.h"
+#include <glm/glm.hpp>
+
+// The forces on a rigid body, the MovementSystem integrates the bodies without one at a
+// constant velocity
+struct PhysicsMaterialComponent
+{
+    // In world pixels per second squared
+    glm::vec2 acceleration;
+    // The fraction of the velocity lost per second, 0 keeps it all
+    float damping;
+    // In world pixels per second, 0 for no limit
+    float maxSpeed;
+
+    PhysicsMaterialComponent(glm::vec2 acceleration = glm::vec2(0.0, 0.0), float damping = 0.0f, float maxSpeed = 0.0f)
+    {
+        this->acceleration = acceleration;
+        this->damping = damping;
+        this->maxSpeed = maxSpeed;
+    }
+};
+
+REGISTER_COMPONENT(PhysicsMaterialComponent, 21)
+REFLECT_COMPONENT(PhysicsMaterialComponent,
+    REFLECT_FIELD(acceleration),
+    REFLECT_FIELD(damping),
+    REFLECT_FIELD(maxSpeed))
+
+#endif /* PHYSICSMATERIALCOMPONENT_H */
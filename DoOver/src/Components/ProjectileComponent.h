@@ -1,23 +1,39 @@
 #ifndef PROJECTILECOMPONENT_H
 #define PROJECTILECOMPONENT_H
 
-#include <SDL2/SDL.h>
+#include "../ECS/Reflection.h"
+#include <cstdint>
 
 struct ProjectileComponent
 {
     bool isFriendly;
     int hitPercentDamage;
     int duration;
-    int startTime;
+    // Game time in milliseconds, from the frame clock
+    double startTime;
+    // False while the projectile is parked in its pool
+    bool isActive;
+    // The tick of the expiry scheduled in the timer wheel
+    uint32_t expiryTick;
 
-    ProjectileComponent(bool isFriendly = false, int hitpercentDamage = 0, int duration = 0)
+    ProjectileComponent(bool isFriendly = false, int hitPercentDamage = 0, int duration = 0, double startTime = 0.0, bool isActive = true)
     {
         this->isFriendly = isFriendly;
         this->hitPercentDamage = hitPercentDamage;
         this->duration = duration;
-        this->startTime = SDL_GetTicks();
+        this->startTime = startTime;
+        this->isActive = isActive;
+        this->expiryTick = 0;
     }
 };
 
+REGISTER_COMPONENT(ProjectileComponent, 8)
+REFLECT_COMPONENT(ProjectileComponent,
+    REFLECT_FIELD(isFriendly),
+    REFLECT_FIELD(hitPercentDamage),
+    REFLECT_FIELD(duration),
+    REFLECT_FIELD(startTime),
+    REFLECT_READONLY_FIELD(isActive),
+    REFLECT_READONLY_FIELD(expiryTick))
 
 #endif /* PROJECTILECOMPONENT_H */
@@ -1,7 +1,10 @@
 #ifndef PROJECTILEEMITTERCOMPONENT_H
 #define PROJECTILEEMITTERCOMPONENT_H
 
+#include "../ECS/Reflection.h"
+#include "../AssetStore/AssetHandle.h"
 #include <glm/glm.hpp>
+#include <cstdint>
 
 struct ProjectileEmitterComponent
 {
@@ -10,18 +13,40 @@ struct ProjectileEmitterComponent
     int projectileDuration;
     int hitPercentDamage;
     bool isFriendly;
-    int lastEmissionTime;
+    // Game time in milliseconds, from the frame clock
+    double lastEmissionTime;
+    // The tick of the emission scheduled in the timer wheel
+    uint32_t nextEmissionTick;
+    // Played on each shot, none when invalid
+    AssetHandle soundAssetHandle;
+    // In world pixels, when set the shots go at the nearest hostile in range at the speed of
+    // projectileVelocity, and aren't fired without one. 0 fires along projectileVelocity.
+    float targetRange;
 
-    ProjectileEmitterComponent(glm::vec2 projectileVelocity = glm::vec2(0), int repeatFrequency = 0, int projectileDuration = 10000, int hitPercentDamage = 10, bool isFriendly = false)
+    ProjectileEmitterComponent(glm::vec2 projectileVelocity = glm::vec2(0), int repeatFrequency = 0, int projectileDuration = 10000, int hitPercentDamage = 10, bool isFriendly = false, double lastEmissionTime = 0.0, const std::string& soundAssetId = "", float targetRange = 0.0f)
     {
         this->projectileVelocity = projectileVelocity;
         this->repeatFrequency = repeatFrequency;
         this->projectileDuration = projectileDuration;
         this->hitPercentDamage = hitPercentDamage;
         this->isFriendly = isFriendly;
-        this->lastEmissionTime = SDL_GetTicks();
+        this->lastEmissionTime = lastEmissionTime;
+        this->nextEmissionTick = 0;
+        this->soundAssetHandle = GetAssetHandle(soundAssetId);
+        this->targetRange = targetRange;
     }
 };
 
+REGISTER_COMPONENT(ProjectileEmitterComponent, 7)
+REFLECT_COMPONENT(ProjectileEmitterComponent,
+    REFLECT_FIELD(projectileVelocity),
+    REFLECT_FIELD(repeatFrequency),
+    REFLECT_FIELD(projectileDuration),
+    REFLECT_FIELD(hitPercentDamage),
+    REFLECT_FIELD(isFriendly),
+    REFLECT_FIELD(lastEmissionTime),
+    REFLECT_READONLY_FIELD(nextEmissionTick),
+    REFLECT_ASSET_FIELD(soundAssetHandle),
+    REFLECT_FIELD(targetRange))
 
 #endif /* PROJECTILEEMITTERCOMPONENT_H */
@@ -1,6 +1,7 @@
 #ifndef RIGIDBODYCOMPONENT_H
 #define RIGIDBODYCOMPONENT_H
 
+#include "../ECS/Reflection.h"
 #include <glm/glm.hpp>
 
 struct RigidBodyComponent
@@ -13,4 +14,8 @@ struct RigidBodyComponent
     }
 };
 
+REGISTER_COMPONENT(RigidBodyComponent, 1)
+REFLECT_COMPONENT(RigidBodyComponent,
+    REFLECT_FIELD(velocity))
+
 #endif
\ No newline at end of file
@@ -0,0 +1,23 @@
+#ifndef SCRIPTCOMPONENT_H
+#define SCRIPTCOMPONENT_H
+
+#include "../ECS/Reflection.h"
+#include "../AssetStore/AssetHandle.h"
+#include <string>
+
+// The Lua behaviour of an entity, the script with this id must be loaded in the script engine
+struct ScriptComponent
+{
+    AssetHandle scriptHandle;
+
+    ScriptComponent(const std::string& scriptId = "")
+    {
+        this->scriptHandle = GetAssetHandle(scriptId);
+    }
+};
+
+REGISTER_COMPONENT(ScriptComponent, 10)
+REFLECT_COMPONENT(ScriptComponent,
+    REFLECT_ASSET_FIELD(scriptHandle))
+
+#endif /* SCRIPTCOMPONENT_H */
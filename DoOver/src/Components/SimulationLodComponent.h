@@ -0,0 +1,32 @@
+#ifndef SIMULATIONLODCOMPONENT_H
+#define SIMULATIONLODCOMPONENT_H
+
+#include "../ECS/Reflection.h"
+#include <cstdint>
+
+// Tags an entity at mid range from the camera, the systems respecting it only simulate the
+// entity on one tick out of tickDivisor. The ActivitySystem sets and removes it.
+struct SimulationLodComponent
+{
+    int tickDivisor;
+    // Spreads the entities over the ticks, in [0, tickDivisor)
+    int tickPhase;
+
+    SimulationLodComponent(int tickDivisor = 1, int tickPhase = 0)
+    {
+        this->tickDivisor = tickDivisor;
+        this->tickPhase = tickPhase;
+    }
+
+    bool IsTickDue(uint32_t tick) const
+    {
+        return tickDivisor <= 1 || (tick + tickPhase) % tickDivisor == 0;
+    }
+};
+
+REGISTER_COMPONENT(SimulationLodComponent, 22)
+REFLECT_COMPONENT(SimulationLodComponent,
+    REFLECT_READONLY_FIELD(tickDivisor),
+    REFLECT_READONLY_FIELD(tickPhase))
+
+#endif /* SIMULATIONLODCOMPONENT_H */
@@ -0,0 +1,16 @@
+#ifndef SLEEPINGCOMPONENT_H
+#define SLEEPINGCOMPONENT_H
+
+#include "../ECS/Reflection.h"
+
+// Tags a rigid body that rested for a while, the MovementSystem stops integrating it and the
+// CollisionSystem keeps its box in the broadphase as it was. A velocity written through
+// MovementSystem::SetVelocity, a moved transform or a new contact wakes it up.
+struct SleepingComponent
+{
+};
+
+REGISTER_COMPONENT(SleepingComponent, 20)
+REFLECT_COMPONENT(SleepingComponent)
+
+#endif /* SLEEPINGCOMPONENT_H */
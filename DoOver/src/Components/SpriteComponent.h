@@ -1,27 +1,48 @@
 #ifndef SPRITECOMPONENT_H
 #define SPRITECOMPONENT_H
 
+#include "../ECS/Reflection.h"
+#include "../AssetStore/AssetHandle.h"
 #include <string>
 #include <SDL2/SDL.h>
 
+// Sprites are drawn by increasing layer (zIndex), which is clamped to [0, MAX_SPRITE_LAYERS)
+const int MAX_SPRITE_LAYERS = 16;
+
+// Of SDL_RendererFlip, by value
+inline const char* const SPRITE_FLIP_NAMES[] = {"None", "Horizontal", "Vertical", "Both"};
+
 struct SpriteComponent
 {
-    std::string assetId;
+    AssetHandle assetHandle; // Resolved once from the asset id, see GetAssetId
     int width;
     int height;
-    int zIndex; // TODO: Switch to layers
+    int zIndex;
     bool isFixed;
     SDL_Rect srcRect;
+    // Mirrors the image inside the sprite, before it is rotated
+    SDL_RendererFlip flip;
 
-    SpriteComponent(std::string assetId = "", int width = 0, int height = 0, int zIndex = 0, bool isFixed = false, int srcRectX = 0, int srcRectY = 0)
+    SpriteComponent(const std::string& assetId = "", int width = 0, int height = 0, int zIndex = 0, bool isFixed = false, int srcRectX = 0, int srcRectY = 0, SDL_RendererFlip flip = SDL_FLIP_NONE)
     {
-        this->assetId = assetId;
+        this->assetHandle = GetAssetHandle(assetId);
         this->width = width;
         this->height = height;
         this->zIndex = zIndex;
         this->isFixed = isFixed;
         this->srcRect = {srcRectX, srcRectY, width, height};
+        this->flip = flip;
     }
 };
 
+REGISTER_COMPONENT(SpriteComponent, 2)
+REFLECT_COMPONENT(SpriteComponent,
+    REFLECT_ASSET_FIELD(assetHandle),
+    REFLECT_FIELD(width),
+    REFLECT_FIELD(height),
+    REFLECT_FIELD(zIndex),
+    REFLECT_FIELD(isFixed),
+    REFLECT_FIELD(srcRect),
+    REFLECT_ENUM_FIELD(flip, SPRITE_FLIP_NAMES))
+
 #endif
\ No newline at end of file
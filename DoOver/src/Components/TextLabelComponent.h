@@ -0,0 +1,54 @@
+#ifndef TEXTLABELCOMPONENT_H
+#define TEXTLABELCOMPONENT_H
+
+#include "../ECS/Reflection.h"
+#include "../AssetStore/AssetHandle.h"
+#include <glm/glm.hpp>
+#include <SDL2/SDL.h>
+#include <cstring>
+#include <string>
+
+// Longer text is cut, the components stay trivially copyable
+const int TEXT_LABEL_MAX_LENGTH = 32;
+
+// Text drawn at the entity, laid out again only when it is patched (see RenderTextSystem),
+// so the text, the font and the color are changed through Registry::PatchComponent
+struct TextLabelComponent
+{
+    char text[TEXT_LABEL_MAX_LENGTH];
+    AssetHandle fontAssetHandle;
+    SDL_Color color;
+    // From the position of the entity
+    glm::vec2 offset;
+    float scale;
+    // Drawn at the position on the screen instead of in the world (e.g. the HUD)
+    bool isFixed;
+
+    TextLabelComponent(const std::string& text = "", const std::string& fontAssetId = "", SDL_Color color = {255, 255, 255, 255}, glm::vec2 offset = glm::vec2(0), float scale = 1.0f, bool isFixed = false)
+    {
+        SetText(text);
+        this->fontAssetHandle = GetAssetHandle(fontAssetId);
+        this->color = color;
+        this->offset = offset;
+        this->scale = scale;
+        this->isFixed = isFixed;
+    }
+
+    void SetText(const std::string& text)
+    {
+        const size_t length = text.size() < TEXT_LABEL_MAX_LENGTH - 1 ? text.size() : TEXT_LABEL_MAX_LENGTH - 1;
+        std::memcpy(this->text, text.data(), length);
+        std::memset(this->text + length, 0, TEXT_LABEL_MAX_LENGTH - length);
+    }
+};
+
+REGISTER_COMPONENT(TextLabelComponent, 13)
+REFLECT_RENDER_COMPONENT(TextLabelComponent,
+    REFLECT_FIELD(text),
+    REFLECT_ASSET_FIELD(fontAssetHandle),
+    REFLECT_FIELD(color),
+    REFLECT_FIELD(offset),
+    REFLECT_FIELD(scale),
+    REFLECT_FIELD(isFixed))
+
+#endif
@@ -1,20 +1,36 @@
 #ifndef TRANSFORMCOMPONENT_H
 #define TRANSFORMCOMPONENT_H
 
+#include "../ECS/Reflection.h"
 #include <glm/glm.hpp>
 
-struct TransformComponent
+// All floats and 16-byte aligned, so the loops over the transforms work in one precision and
+// two of them fill a cache line
+struct alignas(16) TransformComponent
 {
     glm::vec2 position;
+    // Position before the last simulation tick, rendering interpolates between the two
+    glm::vec2 previousPosition;
     glm::vec2 scale;
-    double rotation;
+    // Degrees, clockwise
+    float rotation;
 
-    TransformComponent(glm::vec2 position = glm::vec2(0,0), glm::vec2 scale = glm::vec2(1,1), double rotation = 0.0)
+    TransformComponent(glm::vec2 position = glm::vec2(0,0), glm::vec2 scale = glm::vec2(1,1), float rotation = 0.0f)
     {
         this->position = position;
+        this->previousPosition = position;
         this->scale = scale;
         this->rotation = rotation;
     }
 };
 
+static_assert(sizeof(TransformComponent) == 32, "TransformComponent is laid out for two per cache line");
+
+REGISTER_COMPONENT(TransformComponent, 0)
+REFLECT_COMPONENT(TransformComponent,
+    REFLECT_FIELD(position),
+    REFLECT_READONLY_FIELD(previousPosition),
+    REFLECT_FIELD(scale),
+    REFLECT_FIELD(rotation))
+
 #endif
\ No newline at end of file
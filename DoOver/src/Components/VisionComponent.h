@@ -0,0 +1,22 @@
+#ifndef VISIONCOMPONENT_H
+#define VISIONCOMPONENT_H
+
+#include "../ECS/Reflection.h"
+
+// Lifts the fog of war around the entity
+struct VisionComponent
+{
+    // In world pixels
+    float radius;
+
+    VisionComponent(float radius = 0.0f)
+    {
+        this->radius = radius;
+    }
+};
+
+REGISTER_COMPONENT(VisionComponent, 19)
+REFLECT_COMPONENT(VisionComponent,
+    REFLECT_FIELD(radius))
+
+#endif
@@ -0,0 +1,291 @@
+#include "./EntityInspector.h"
+#include "../Components/TransformComponent.h"
+#include <imgui/imgui.h>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <string>
+
+// The value of a field the inspector doesn't write
+static void FormatField(const FieldInfo& field, const unsigned char* value, char* text, size_t size)
+{
+    switch (field.type)
+    {
+    case FIELD_INT: std::snprintf(text, size, "%d", *reinterpret_cast<const int*>(value)); break;
+    case FIELD_UINT32: std::snprintf(text, size, "%u", *reinterpret_cast<const uint32_t*>(value)); break;
+    case FIELD_FLOAT: std::snprintf(text, size, "%.3f", *reinterpret_cast<const float*>(value)); break;
+    case FIELD_DOUBLE: std::snprintf(text, size, "%.3f", *reinterpret_cast<const double*>(value)); break;
+    case FIELD_BOOL: std::snprintf(text, size, "%s", *reinterpret_cast<const bool*>(value) ? "true" : "false"); break;
+    case FIELD_VEC2:
+    {
+        const glm::vec2& vector = *reinterpret_cast<const glm::vec2*>(value);
+        std::snprintf(text, size, "%.3f, %.3f", vector.x, vector.y);
+        break;
+    }
+    case FIELD_RECT:
+    {
+        const SDL_Rect& rect = *reinterpret_cast<const SDL_Rect*>(value);
+        std::snprintf(text, size, "%d, %d, %d x %d", rect.x, rect.y, rect.w, rect.h);
+        break;
+    }
+    case FIELD_COLOR:
+    {
+        const SDL_Color& color = *reinterpret_cast<const SDL_Color*>(value);
+        std::snprintf(text, size, "%d, %d, %d, %d", color.r, color.g, color.b, color.a);
+        break;
+    }
+    case FIELD_ENUM:
+    {
+        const int enumValue = *reinterpret_cast<const int*>(value);
+        if (enumValue >= 0 && enumValue < field.numEnumNames)
+        {
+            std::snprintf(text, size, "%s", field.enumNames[enumValue]);
+        }
+        else
+        {
+            std::snprintf(text, size, "%d", enumValue);
+        }
+        break;
+    }
+    case FIELD_TEXT: std::snprintf(text, size, "%.*s", static_cast<int>(field.size), reinterpret_cast<const char*>(value)); break;
+    case FIELD_ASSET_HANDLE: std::snprintf(text, size, "%s", GetAssetId(*reinterpret_cast<const AssetHandle*>(value)).c_str()); break;
+    case FIELD_ENTITY:
+    {
+        const Entity& entity = *reinterpret_cast<const Entity*>(value);
+        std::snprintf(text, size, "%d (version %d)", entity.GetId(), entity.GetVersion());
+        break;
+    }
+    }
+}
+
+// The asset and entity handles are shown, an id typed in would have to be loaded first
+static bool EditField(const FieldInfo& field, unsigned char* value)
+{
+    if (field.isReadOnly || field.type == FIELD_ASSET_HANDLE || field.type == FIELD_ENTITY)
+    {
+        char text[128];
+        FormatField(field, value, text, sizeof(text));
+        ImGui::LabelText(field.name, "%s", text);
+        return false;
+    }
+    switch (field.type)
+    {
+    case FIELD_INT: return ImGui::InputInt(field.name, reinterpret_cast<int*>(value));
+    case FIELD_UINT32: return ImGui::InputScalar(field.name, ImGuiDataType_U32, value);
+    case FIELD_FLOAT: return ImGui::DragFloat(field.name, reinterpret_cast<float*>(value));
+    case FIELD_DOUBLE: return ImGui::InputDouble(field.name, reinterpret_cast<double*>(value));
+    case FIELD_BOOL: return ImGui::Checkbox(field.name, reinterpret_cast<bool*>(value));
+    case FIELD_VEC2: return ImGui::DragFloat2(field.name, &reinterpret_cast<glm::vec2*>(value)->x);
+    case FIELD_RECT: return ImGui::InputInt4(field.name, &reinterpret_cast<SDL_Rect*>(value)->x);
+    case FIELD_COLOR:
+    {
+        SDL_Color& color = *reinterpret_cast<SDL_Color*>(value);
+        float channels[4] = {color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, color.a / 255.0f};
+        if (!ImGui::ColorEdit4(field.name, channels))
+        {
+            return false;
+        }
+        color = {static_cast<Uint8>(channels[0] * 255.0f + 0.5f), static_cast<Uint8>(channels[1] * 255.0f + 0.5f), static_cast<Uint8>(channels[2] * 255.0f + 0.5f), static_cast<Uint8>(channels[3] * 255.0f + 0.5f)};
+        return true;
+    }
+    case FIELD_ENUM:
+    {
+        int* enumValue = reinterpret_cast<int*>(value);
+        if (*enumValue >= 0 && *enumValue < field.numEnumNames)
+        {
+            return ImGui::Combo(field.name, enumValue, field.enumNames, field.numEnumNames);
+        }
+        return ImGui::InputInt(field.name, enumValue);
+    }
+    case FIELD_TEXT: return ImGui::InputText(field.name, reinterpret_cast<char*>(value), field.size);
+    default: return false;
+    }
+}
+
+// The names of the components of the signature, separated by commas
+static void FormatSignature(const Signature& signature, char* text, size_t size)
+{
+    size_t length = 0;
+    text[0] = '\0';
+    for (int componentId = 0; componentId < static_cast<int>(MAX_COMPONENTS) && length < size; componentId++)
+    {
+        if (signature.test(componentId))
+        {
+            const int written = std::snprintf(text + length, size - length, "%s%s", length > 0 ? ", " : "", GetComponentName(componentId));
+            length += written > 0 ? written : 0;
+        }
+    }
+}
+
+static bool HasComponentNamed(const Signature& signature, const char* filter)
+{
+    for (int componentId = 0; componentId < static_cast<int>(MAX_COMPONENTS); componentId++)
+    {
+        if (signature.test(componentId) && std::strstr(GetComponentName(componentId), filter))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void EntityInspector::Render(Registry& registry)
+{
+    if (!ImGui::Begin("Inspector"))
+    {
+        ImGui::End();
+        return;
+    }
+    if (ImGui::BeginTabBar("InspectorTabs"))
+    {
+        if (ImGui::BeginTabItem("Entities"))
+        {
+            RenderEntities(registry);
+            ImGui::EndTabItem();
+        }
+        if (ImGui::BeginTabItem("Pools"))
+        {
+            RenderPools(registry);
+            ImGui::EndTabItem();
+        }
+        ImGui::EndTabBar();
+    }
+    ImGui::End();
+}
+
+void EntityInspector::RenderEntities(Registry& registry)
+{
+    ImGui::SetNextItemWidth(200);
+    ImGui::InputText("Component", componentFilter, sizeof(componentFilter));
+
+    // The free ids have no components, they aren't listed
+    listedEntityIds.clear();
+    for (int entityId = 0; entityId < registry.GetNumEntityIds(); entityId++)
+    {
+        const Signature& signature = registry.GetEntitySignature(entityId);
+        if (signature.any() && (componentFilter[0] == '\0' || HasComponentNamed(signature, componentFilter)))
+        {
+            listedEntityIds.push_back(entityId);
+        }
+    }
+    ImGui::Text("%d of %d entities", static_cast<int>(listedEntityIds.size()), registry.GetNumEntities());
+
+    ImGui::BeginChild("EntityList", ImVec2(0, ImGui::GetContentRegionAvail().y * 0.5f), true);
+    // Only the visible rows have their signature spelled out
+    ImGuiListClipper clipper;
+    clipper.Begin(listedEntityIds.size());
+    char label[512];
+    while (clipper.Step())
+    {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++)
+        {
+            const int entityId = listedEntityIds[i];
+            const int length = std::snprintf(label, sizeof(label), "%6d  ", entityId);
+            FormatSignature(registry.GetEntitySignature(entityId), label + length, sizeof(label) - length);
+            ImGui::PushID(entityId);
+            if (ImGui::Selectable(label, entityId == selectedEntityId))
+            {
+                selectedEntityId = entityId;
+            }
+            ImGui::PopID();
+        }
+    }
+    ImGui::EndChild();
+
+    const Signature& signature = registry.GetEntitySignature(selectedEntityId);
+    if (!signature.any())
+    {
+        // Killed since it was selected
+        selectedEntityId = -1;
+        return;
+    }
+    const Entity entity = registry.GetEntity(selectedEntityId);
+    ImGui::Text("Entity %d", selectedEntityId);
+    for (int componentId = 0; componentId < static_cast<int>(MAX_COMPONENTS); componentId++)
+    {
+        if (signature.test(componentId) && ImGui::CollapsingHeader(GetComponentName(componentId), ImGuiTreeNodeFlags_DefaultOpen))
+        {
+            ImGui::PushID(componentId);
+            RenderComponent(registry, entity, componentId);
+            ImGui::PopID();
+        }
+    }
+}
+
+// Edits a copy, written back through PatchComponentData only when it changed so the tracked
+// types are flagged like any system write
+void EntityInspector::RenderComponent(Registry& registry, Entity entity, int componentId)
+{
+    const ComponentReflection* reflection = GetComponentReflection(componentId);
+    if (!reflection || !reflection->isTriviallyCopyable)
+    {
+        ImGui::TextDisabled("No editor");
+        return;
+    }
+    editedComponent.resize(reflection->size);
+    std::memcpy(editedComponent.data(), registry.GetComponentData(componentId, entity), reflection->size);
+    bool isEdited = false;
+    for (const auto& field: reflection->fields)
+    {
+        isEdited |= EditField(field, editedComponent.data() + field.offset);
+    }
+    if (!isEdited)
+    {
+        return;
+    }
+    if (componentId == Component<TransformComponent>::GetId())
+    {
+        // Moved, not interpolated from where it was
+        TransformComponent* transform = reinterpret_cast<TransformComponent*>(editedComponent.data());
+        transform->previousPosition = transform->position;
+    }
+    std::memcpy(registry.PatchComponentData(componentId, entity), editedComponent.data(), reflection->size);
+}
+
+void EntityInspector::RenderPools(const Registry& registry)
+{
+    registry.GetComponentStats(componentStats);
+    const bool isPoolStorage = registry.GetStorageMode() == STORAGE_POOL;
+    ImGui::Text("%s storage, %d entity ids for %d entities", isPoolStorage ? "Pool" : "Archetype", registry.GetNumEntityIds(), registry.GetNumEntities());
+
+    ImGui::Columns(7, "Pools");
+    for (const char* title: {"Component", "Live", "Capacity", "Entity slots", "Fragmentation", "Memory", "Wasted"})
+    {
+        ImGui::Text("%s", title);
+        ImGui::NextColumn();
+    }
+    ImGui::Separator();
+    size_t totalBytes = 0;
+    size_t totalUsedBytes = 0;
+    for (const auto& stats: componentStats)
+    {
+        // The share of the bytes the live components don't need
+        const double fragmentation = stats.numBytes > 0 ? 1.0 - static_cast<double>(stats.numUsedBytes) / stats.numBytes : 0.0;
+        ImGui::Text("%s", GetComponentName(stats.componentId));
+        ImGui::NextColumn();
+        ImGui::Text("%d", stats.numComponents);
+        ImGui::NextColumn();
+        ImGui::Text("%d", stats.capacity);
+        ImGui::NextColumn();
+        if (isPoolStorage)
+        {
+            ImGui::Text("%d", stats.numEntitySlots);
+        }
+        else
+        {
+            ImGui::Text("-");
+        }
+        ImGui::NextColumn();
+        ImGui::Text("%5.1f%%", fragmentation * 100.0);
+        ImGui::NextColumn();
+        ImGui::Text("%.1f KB", stats.numBytes / 1024.0);
+        ImGui::NextColumn();
+        ImGui::Text("%.1f KB", (stats.numBytes - stats.numUsedBytes) / 1024.0);
+        ImGui::NextColumn();
+        totalBytes += stats.numBytes;
+        totalUsedBytes += stats.numUsedBytes;
+    }
+    ImGui::Columns(1);
+    ImGui::Separator();
+    ImGui::Text("%.1f KB of components, %.1f KB wasted", totalBytes / 1024.0, (totalBytes - totalUsedBytes) / 1024.0);
+}
@@ -0,0 +1,40 @@
+#ifndef ENTITYINSPECTOR_H
+#define ENTITYINSPECTOR_H
+
+#include "../ECS/ECS.h"
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Entity inspector
+/////////////////////////////////////////////////////////////////////////////////////////////
+// ImGui window over the registry. The entities are listed with their signature spelled out
+// in component names, filtered by a component name, and the components of the one selected
+// are edited live, field by field as their reflection lists them. The pools tab compares
+// what each component type holds to what it needs: the dense capacity and the
+// entity-indexed slots against the live components, and the share of their bytes nothing
+// uses.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class EntityInspector
+{
+private:
+    int selectedEntityId = -1;
+    char componentFilter[64] = "";
+
+    // Reused every frame
+    std::vector<int> listedEntityIds;
+    std::vector<ComponentStats> componentStats;
+    std::vector<unsigned char> editedComponent;
+
+    void RenderEntities(Registry& registry);
+    // Field by field, from the reflection of the component
+    void RenderComponent(Registry& registry, Entity entity, int componentId);
+    void RenderPools(const Registry& registry);
+
+public:
+    EntityInspector() = default;
+
+    // Call between ImGui::NewFrame and ImGui::Render, while no system runs
+    void Render(Registry& registry);
+};
+
+#endif
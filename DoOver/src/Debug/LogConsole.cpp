@@ -0,0 +1,86 @@
+#include "./LogConsole.h"
+#include <imgui/imgui.h>
+#include <vector>
+
+static ImVec4 GetLogColor(LogType type)
+{
+    switch (type)
+    {
+        case LOG_TRACE: return ImVec4(0.5f, 0.5f, 0.5f, 1.0f);
+        case LOG_DEBUG: return ImVec4(0.3f, 0.8f, 0.8f, 1.0f);
+        case LOG_INFO: return ImVec4(0.3f, 0.9f, 0.3f, 1.0f);
+        case LOG_WARNING: return ImVec4(0.9f, 0.9f, 0.2f, 1.0f);
+        case LOG_ERROR: return ImVec4(1.0f, 0.3f, 0.3f, 1.0f);
+    }
+    return ImVec4(1.0f, 1.0f, 1.0f, 1.0f);
+}
+
+void LogConsole::Render(FrameArena& frameArena)
+{
+    if (!ImGui::Begin("Log"))
+    {
+        ImGui::End();
+        return;
+    }
+
+    const char* levels[] = {"Trace", "Debug", "Info", "Warning", "Error"};
+    int level = minLevel;
+    ImGui::SetNextItemWidth(120);
+    if (ImGui::Combo("Level", &level, levels, IM_ARRAYSIZE(levels)))
+    {
+        minLevel = static_cast<LogType>(level);
+    }
+    ImGui::SameLine();
+    ImGui::Checkbox("Auto-scroll", &isAutoScrolling);
+    ImGui::Separator();
+
+    ImGui::BeginChild("LogLines", ImVec2(0, 0), false, ImGuiWindowFlags_HorizontalScrollbar);
+    if (minLevel == LOG_TRACE)
+    {
+        // Every record is a line, the clipper only visits the visible ones
+        ImGuiListClipper clipper;
+        clipper.Begin(Logger::GetHistorySize());
+        while (clipper.Step())
+        {
+            Logger::VisitHistory(clipper.DisplayStart, clipper.DisplayEnd - clipper.DisplayStart, [](const LogRecord& record)
+            {
+                ImGui::TextColored(GetLogColor(record.type), "%s", Logger::FormatRecord(record).c_str());
+            });
+        }
+        clipper.End();
+    }
+    else
+    {
+        // Filtered, the records of the level are found first and only those are drawn
+        std::pmr::vector<int> lines(&frameArena);
+        int index = 0;
+        Logger::VisitHistory(0, Logger::GetHistorySize(), [&](const LogRecord& record)
+        {
+            if (record.type >= minLevel)
+            {
+                lines.push_back(index);
+            }
+            index++;
+        });
+        ImGuiListClipper clipper;
+        clipper.Begin(lines.size());
+        while (clipper.Step())
+        {
+            for (int line = clipper.DisplayStart; line < clipper.DisplayEnd; line++)
+            {
+                Logger::VisitHistory(lines[line], 1, [](const LogRecord& record)
+                {
+                    ImGui::TextColored(GetLogColor(record.type), "%s", Logger::FormatRecord(record).c_str());
+                });
+            }
+        }
+        clipper.End();
+    }
+
+    if (isAutoScrolling && ImGui::GetScrollY() >= ImGui::GetScrollMaxY())
+    {
+        ImGui::SetScrollHereY(1.0f);
+    }
+    ImGui::EndChild();
+    ImGui::End();
+}
@@ -0,0 +1,26 @@
+#ifndef LOGCONSOLE_H
+#define LOGCONSOLE_H
+
+#include "../Logger/Logger.h"
+#include "../Memory/FrameArena.h"
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Log console
+/////////////////////////////////////////////////////////////////////////////////////////////
+// ImGui window over the Logger history. Only the visible lines are formatted, straight
+// from the history ring.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class LogConsole
+{
+private:
+    LogType minLevel = LOG_TRACE;
+    bool isAutoScrolling = true;
+
+public:
+    LogConsole() = default;
+
+    // Call between ImGui::NewFrame and ImGui::Render
+    void Render(FrameArena& frameArena);
+};
+
+#endif
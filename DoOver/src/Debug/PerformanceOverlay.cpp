@@ -0,0 +1,364 @@
+#include "./PerformanceOverlay.h"
+#include <imgui/imgui.h>
+#include <algorithm>
+#include <cstdio>
+
+void PerformanceOverlay::AddFrameTime(double millisecs)
+{
+    frameMillisecs[numFrames % PROFILER_HISTORY_FRAMES] = millisecs;
+    numFrames++;
+}
+
+void PerformanceOverlay::Render(const Registry& registry, const Scheduler& scheduler, const JobSystem& jobSystem, const EventBus& eventBus, const RenderStats& renderStats,
+    const BroadphaseStats& broadphaseStats, const ScriptStats& scriptStats, const FrameArena& frameArena, const MemoryTracker& memoryTracker, const LatencyTracker& latencyTracker)
+{
+    if (!ImGui::Begin("Performance"))
+    {
+        ImGui::End();
+        return;
+    }
+    RenderFrameTimes(latencyTracker);
+    RenderScopes(scheduler);
+    RenderJobs(jobSystem);
+    RenderEntities(registry);
+    RenderRendering(renderStats);
+    RenderCollisions(broadphaseStats);
+    RenderScripts(scriptStats);
+    RenderMemory(frameArena, memoryTracker);
+    RenderEvents(eventBus);
+    ImGui::End();
+}
+
+void PerformanceOverlay::RenderFrameTimes(const LatencyTracker& latencyTracker)
+{
+    // From the last input pressed to the frame that showed it
+    const LatencyStats latency = latencyTracker.GetStats();
+    if (latency.numSamples > 0)
+    {
+        ImGui::Text("Input latency p50 %d ms, p95 %d ms, p99 %d ms, max %d ms (%llu inputs)", latency.p50Millisecs, latency.p95Millisecs, latency.p99Millisecs, latency.maxMillisecs,
+            static_cast<unsigned long long>(latency.numSamples));
+    }
+
+    const int numHistoryFrames = std::min(numFrames, PROFILER_HISTORY_FRAMES);
+    if (numHistoryFrames == 0)
+    {
+        return;
+    }
+    float total = 0.0f;
+    float max = 0.0f;
+    for (int i = 0; i < numHistoryFrames; i++)
+    {
+        total += frameMillisecs[i];
+        max = std::max(max, frameMillisecs[i]);
+    }
+    const float average = total / numHistoryFrames;
+
+    char overlay[64];
+    snprintf(overlay, sizeof(overlay), "avg %.2f ms (%.0f FPS), max %.2f ms", average, average > 0.0f ? 1000.0f / average : 0.0f, max);
+    // Oldest frame first once the ring has wrapped
+    const int offset = numFrames > PROFILER_HISTORY_FRAMES ? numFrames % PROFILER_HISTORY_FRAMES : 0;
+    ImGui::PlotLines("##FrameTimes", frameMillisecs.data(), numHistoryFrames, offset, overlay, 0.0f, std::max(max, 1000.0f / 30), ImVec2(0, 80));
+}
+
+void PerformanceOverlay::RenderScopes(const Scheduler& scheduler)
+{
+    if (!ImGui::CollapsingHeader("Systems", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+        return;
+    }
+    Profiler::GetStats(profileStats);
+    if (profileStats.empty())
+    {
+        // Built without the profiler, only the last run of the scheduler is known
+        for (const auto& timing: scheduler.GetTimings())
+        {
+            ImGui::Text("%-28s %6.3f ms", timing.name.c_str(), timing.millisecs);
+        }
+    }
+    else
+    {
+        // The allocations of the last frame in a build that tracks them
+        const bool isAllocationTracked = AllocationTracker::IsEnabled();
+        ImGui::Columns(isAllocationTracked ? 7 : 6, "Scopes");
+        for (const char* title: {"Scope", "Last", "p50", "p95", "p99", "Calls"})
+        {
+            ImGui::Text("%s", title);
+            ImGui::NextColumn();
+        }
+        if (isAllocationTracked)
+        {
+            ImGui::Text("Allocations");
+            ImGui::NextColumn();
+        }
+        ImGui::Separator();
+        for (const auto& stats: profileStats)
+        {
+            ImGui::Text("%s", stats.name.c_str());
+            ImGui::NextColumn();
+            for (double millisecs: {stats.lastMillisecs, stats.p50Millisecs, stats.p95Millisecs, stats.p99Millisecs})
+            {
+                ImGui::Text("%.3f", millisecs);
+                ImGui::NextColumn();
+            }
+            ImGui::Text("%d", stats.lastNumCalls);
+            ImGui::NextColumn();
+            if (isAllocationTracked)
+            {
+                ImGui::Text("%llu (%.1f KB)", static_cast<unsigned long long>(stats.lastNumAllocations), stats.lastNumAllocatedBytes / 1024.0);
+                ImGui::NextColumn();
+            }
+        }
+        ImGui::Columns(1);
+    }
+    ImGui::Text("Scheduler parallelism: %.2fx", scheduler.GetParallelism());
+}
+
+void PerformanceOverlay::RenderJobs(const JobSystem& jobSystem)
+{
+    // Counted even when collapsed, like the events
+    jobSystem.GetWorkerStats(workerStats);
+    previousWorkerStats.resize(workerStats.size(), {0, 0, 0, 0});
+    if (!ImGui::CollapsingHeader("Jobs", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+        previousWorkerStats = workerStats;
+        return;
+    }
+    if (workerStats.empty())
+    {
+        ImGui::Text("No workers, the jobs run inline");
+        return;
+    }
+    // Of the frame before this one, the one the counts below cover
+    const double lastFrameMillisecs = numFrames > 0 ? frameMillisecs[(numFrames - 1) % PROFILER_HISTORY_FRAMES] : 0.0;
+    ImGui::Columns(5, "Jobs");
+    for (const char* title: {"Worker", "Jobs", "Stolen", "Sleeps", "Busy"})
+    {
+        ImGui::Text("%s", title);
+        ImGui::NextColumn();
+    }
+    ImGui::Separator();
+    for (size_t i = 0; i < workerStats.size(); i++)
+    {
+        const auto& stats = workerStats[i];
+        const auto& previous = previousWorkerStats[i];
+        const double busyMillisecs = (stats.busyNanosecs - previous.busyNanosecs) / 1000000.0;
+        ImGui::Text("%d", static_cast<int>(i));
+        ImGui::NextColumn();
+        ImGui::Text("%llu", static_cast<unsigned long long>(stats.numJobs - previous.numJobs));
+        ImGui::NextColumn();
+        ImGui::Text("%llu", static_cast<unsigned long long>(stats.numStolen - previous.numStolen));
+        ImGui::NextColumn();
+        ImGui::Text("%llu", static_cast<unsigned long long>(stats.numSleeps - previous.numSleeps));
+        ImGui::NextColumn();
+        ImGui::Text("%.2f ms (%3.0f%%)", busyMillisecs, lastFrameMillisecs > 0.0 ? std::min(busyMillisecs / lastFrameMillisecs, 1.0) * 100.0 : 0.0);
+        ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+    previousWorkerStats = workerStats;
+}
+
+void PerformanceOverlay::RenderEntities(const Registry& registry)
+{
+    if (!ImGui::CollapsingHeader("Entities", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+        return;
+    }
+    ImGui::Text("%d entities, %s storage", registry.GetNumEntities(), registry.GetStorageMode() == STORAGE_ARCHETYPE ? "archetype" : "pool");
+
+    registry.GetComponentStats(componentStats);
+    size_t totalBytes = 0;
+    ImGui::Columns(3, "Components");
+    for (const char* title: {"Component", "Count", "Memory"})
+    {
+        ImGui::Text("%s", title);
+        ImGui::NextColumn();
+    }
+    ImGui::Separator();
+    for (const auto& stats: componentStats)
+    {
+        ImGui::Text("%s", GetComponentName(stats.componentId));
+        ImGui::NextColumn();
+        ImGui::Text("%d", stats.numComponents);
+        ImGui::NextColumn();
+        ImGui::Text("%.1f KB", stats.numBytes / 1024.0);
+        ImGui::NextColumn();
+        totalBytes += stats.numBytes;
+    }
+    ImGui::Columns(1);
+    ImGui::Text("Total component memory: %.1f KB", totalBytes / 1024.0);
+}
+
+void PerformanceOverlay::RenderRendering(const RenderStats& renderStats)
+{
+    if (!ImGui::CollapsingHeader("Rendering", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+        return;
+    }
+    ImGui::Text("%d sprites in %d draw calls (%.1f sprites per batch)", renderStats.numSprites, renderStats.numDrawCalls,
+        renderStats.numDrawCalls > 0 ? static_cast<double>(renderStats.numSprites) / renderStats.numDrawCalls : 0.0);
+    ImGui::Text("%d particles in %d draw calls", renderStats.numParticles, renderStats.numParticleDrawCalls);
+    ImGui::Text("Drawn at %.0f%% of the window's resolution", renderStats.resolutionScale * 100.0f);
+}
+
+void PerformanceOverlay::RenderCollisions(const BroadphaseStats& broadphaseStats)
+{
+    if (!ImGui::CollapsingHeader("Collisions", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+        return;
+    }
+    if (broadphaseStats.mode == BROADPHASE_SWEEP_AND_PRUNE)
+    {
+        ImGui::Text("Sweep and prune, retuned %d times", broadphaseStats.numRetunes);
+    }
+    else
+    {
+        ImGui::Text("Spatial hash of %dpx cells, retuned %d times", broadphaseStats.cellSize, broadphaseStats.numRetunes);
+        ImGui::Text("%.1f cells per box, %.1f boxes per cell", broadphaseStats.cellsPerBox, broadphaseStats.boxesPerCell);
+    }
+    ImGui::Text("%d dynamic boxes, sizes %.0f / %.0f / %.0f / %.0f px (min, median, p90, max)", broadphaseStats.numBoxes, broadphaseStats.minSize, broadphaseStats.medianSize,
+        broadphaseStats.p90Size, broadphaseStats.maxSize);
+    ImGui::Text("%d candidate pairs, %d overlapping (%.1f tests per overlap)", broadphaseStats.numCandidatePairs, broadphaseStats.numOverlaps,
+        broadphaseStats.numOverlaps > 0 ? static_cast<double>(broadphaseStats.numCandidatePairs) / broadphaseStats.numOverlaps : 0.0);
+}
+
+void PerformanceOverlay::RenderScripts(const ScriptStats& scriptStats)
+{
+    if (!ImGui::CollapsingHeader("Scripts", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+        return;
+    }
+    ImGui::Text("Lua memory: %.1f KB in use, %.1f KB reserved", scriptStats.numBytesInUse / 1024.0, scriptStats.numBytesReserved / 1024.0);
+    ImGui::Text("GC: %.3f ms this frame, %d cycles", scriptStats.gcMillisecs, scriptStats.numGcCycles);
+    ImGui::Text("Behaviours: %d running, %d resumed last tick", scriptStats.numBehaviours, scriptStats.numResumed);
+}
+
+void PerformanceOverlay::RenderMemory(const FrameArena& frameArena, const MemoryTracker& memoryTracker)
+{
+    if (!ImGui::CollapsingHeader("Memory", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+        return;
+    }
+    ImGui::Columns(4, "Tags");
+    for (const char* title: {"Subsystem", "Current", "Peak", "Budget"})
+    {
+        ImGui::Text("%s", title);
+        ImGui::NextColumn();
+    }
+    ImGui::Separator();
+    for (int tag = 0; tag < NUM_MEMORY_TAGS; tag++)
+    {
+        const MemoryTagStats& stats = memoryTracker.GetStats(static_cast<MemoryTag>(tag));
+        ImGui::Text("%s", MemoryTracker::GetTagName(static_cast<MemoryTag>(tag)));
+        ImGui::NextColumn();
+        // Over budget in red
+        if (stats.isOverBudget)
+        {
+            ImGui::TextColored(ImVec4(0.9f, 0.3f, 0.3f, 1.0f), "%.1f KB", stats.numBytes / 1024.0);
+        }
+        else
+        {
+            ImGui::Text("%.1f KB", stats.numBytes / 1024.0);
+        }
+        ImGui::NextColumn();
+        ImGui::Text("%.1f KB", stats.peakNumBytes / 1024.0);
+        ImGui::NextColumn();
+        if (stats.budgetBytes > 0)
+        {
+            ImGui::Text("%.1f KB", stats.budgetBytes / 1024.0);
+        }
+        else
+        {
+            ImGui::Text("-");
+        }
+        ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+
+    ImGui::Text("Frame arena: %.1f KB used, %.1f KB peak, %.1f KB capacity", frameArena.GetNumUsedBytes() / 1024.0,
+        frameArena.GetPeakUsedBytes() / 1024.0, frameArena.GetCapacity() / 1024.0);
+
+    BlockAllocator::GetStats(blockAllocatorStats);
+    ImGui::Columns(4, "Blocks");
+    for (const char* title: {"Block size", "In use", "Peak", "Pages"})
+    {
+        ImGui::Text("%s", title);
+        ImGui::NextColumn();
+    }
+    ImGui::Separator();
+    for (const auto& stats: blockAllocatorStats)
+    {
+        ImGui::Text("%zu B", stats.blockSize);
+        ImGui::NextColumn();
+        ImGui::Text("%d", stats.numBlocksInUse);
+        ImGui::NextColumn();
+        ImGui::Text("%d", stats.peakNumBlocksInUse);
+        ImGui::NextColumn();
+        ImGui::Text("%d", stats.numPages);
+        ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+}
+
+void PerformanceOverlay::RenderEvents(const EventBus& eventBus)
+{
+    // Counted even when collapsed, so the frame counts are right once it is opened again
+    eventBus.GetEventStats(eventStats);
+    previousEventCounts.resize(eventStats.size());
+    if (!ImGui::CollapsingHeader("Events", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+        for (size_t i = 0; i < eventStats.size(); i++)
+        {
+            previousEventCounts[i] = {eventStats[i].numEmitted, eventStats[i].numHandlerCalls, eventStats[i].handlerNanosecs};
+        }
+        return;
+    }
+    ImGui::Columns(6, "Events");
+    for (const char* title: {"Event", "This frame", "Total", "Handlers", "Calls", "Handler ms"})
+    {
+        ImGui::Text("%s", title);
+        ImGui::NextColumn();
+    }
+    ImGui::Separator();
+    for (size_t i = 0; i < eventStats.size(); i++)
+    {
+        const auto& stats = eventStats[i];
+        const auto& previous = previousEventCounts[i];
+        ImGui::Text("%s", stats.name.c_str());
+        ImGui::NextColumn();
+        ImGui::Text("%llu", static_cast<unsigned long long>(stats.numEmitted - previous.numEmitted));
+        ImGui::NextColumn();
+        ImGui::Text("%llu", static_cast<unsigned long long>(stats.numEmitted));
+        ImGui::NextColumn();
+        ImGui::Text("%d", stats.numHandlers);
+        ImGui::NextColumn();
+        // The calls and the time are of this frame too
+        ImGui::Text("%llu", static_cast<unsigned long long>(stats.numHandlerCalls - previous.numHandlerCalls));
+        ImGui::NextColumn();
+        ImGui::Text("%.3f", (stats.handlerNanosecs - previous.handlerNanosecs) / 1000000.0);
+        ImGui::NextColumn();
+        previousEventCounts[i] = {stats.numEmitted, stats.numHandlerCalls, stats.handlerNanosecs};
+    }
+    ImGui::Columns(1);
+    if (const EventTap* tap = eventBus.GetTap())
+    {
+        ImGui::Text("Tapped: %llu events, %llu overwritten", static_cast<unsigned long long>(tap->GetNumRecorded()), static_cast<unsigned long long>(tap->GetNumOverwritten()));
+    }
+
+    // Where the events come from, out of one event in EVENT_SAMPLE_INTERVAL since the start
+    if (ImGui::TreeNode("Hottest emit sites"))
+    {
+        for (const auto& stats: eventStats)
+        {
+            uint64_t numSamples = 0;
+            for (const auto& site: stats.sites)
+            {
+                numSamples += site.numSamples;
+            }
+            for (size_t i = 0; i < stats.sites.size() && i < 3; i++)
+            {
+                ImGui::Text("%-24s %-24s %5.1f%%", i == 0 ? stats.name.c_str() : "", stats.sites[i].site.c_str(), 100.0 * stats.sites[i].numSamples / numSamples);
+            }
+        }
+        ImGui::TreePop();
+    }
+}
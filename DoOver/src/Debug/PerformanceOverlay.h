@@ -0,0 +1,82 @@
+#ifndef PERFORMANCEOVERLAY_H
+#define PERFORMANCEOVERLAY_H
+
+#include "../ECS/ECS.h"
+#include "../EventBus/EventBus.h"
+#include "../Memory/BlockAllocator.h"
+#include "../Memory/FrameArena.h"
+#include "../Memory/MemoryTracker.h"
+#include "../Physics/BroadphaseTuner.h"
+#include "../Jobs/JobSystem.h"
+#include "../Profiler/LatencyTracker.h"
+#include "../Profiler/Profiler.h"
+#include "../Scheduler/Scheduler.h"
+#include "../Scripting/ScriptEngine.h"
+#include <array>
+#include <vector>
+
+// What the renderer submitted this frame
+struct RenderStats
+{
+    int numSprites;
+    int numDrawCalls;
+    int numParticles;
+    int numParticleDrawCalls;
+    // Of the window's pixels drawn, see ResolutionScaler
+    float resolutionScale;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Performance overlay
+/////////////////////////////////////////////////////////////////////////////////////////////
+// ImGui window with the frame times and the input latency, the profiled scopes, the job system workers, the entities and component
+// memory of the registry, the draw calls, the broadphase statistics, the script memory, the engine allocators and the
+// event counts, refreshed every frame.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class PerformanceOverlay
+{
+private:
+    // [frame % PROFILER_HISTORY_FRAMES] -> frame time in milliseconds
+    std::array<float, PROFILER_HISTORY_FRAMES> frameMillisecs = {};
+    int numFrames = 0;
+
+    // Event counts of the previous frame, to show the events per frame
+    struct EventCounts
+    {
+        uint64_t numEmitted = 0;
+        uint64_t numHandlerCalls = 0;
+        uint64_t handlerNanosecs = 0;
+    };
+    std::vector<EventCounts> previousEventCounts;
+    // Worker stats of the previous frame, to show the jobs per frame
+    std::vector<JobWorkerStats> previousWorkerStats;
+
+    // Reused every frame
+    std::vector<ProfileStats> profileStats;
+    std::vector<ComponentStats> componentStats;
+    std::vector<EventStats> eventStats;
+    std::vector<JobWorkerStats> workerStats;
+    std::vector<BlockAllocatorStats> blockAllocatorStats;
+
+    void RenderFrameTimes(const LatencyTracker& latencyTracker);
+    void RenderScopes(const Scheduler& scheduler);
+    void RenderJobs(const JobSystem& jobSystem);
+    void RenderEntities(const Registry& registry);
+    void RenderRendering(const RenderStats& renderStats);
+    void RenderCollisions(const BroadphaseStats& broadphaseStats);
+    void RenderScripts(const ScriptStats& scriptStats);
+    void RenderMemory(const FrameArena& frameArena, const MemoryTracker& memoryTracker);
+    void RenderEvents(const EventBus& eventBus);
+
+public:
+    PerformanceOverlay() = default;
+
+    // Call once per frame, even when the overlay is hidden, so the frame graph has no holes
+    void AddFrameTime(double millisecs);
+
+    // Call between ImGui::NewFrame and ImGui::Render
+    void Render(const Registry& registry, const Scheduler& scheduler, const JobSystem& jobSystem, const EventBus& eventBus, const RenderStats& renderStats,
+        const BroadphaseStats& broadphaseStats, const ScriptStats& scriptStats, const FrameArena& frameArena, const MemoryTracker& memoryTracker, const LatencyTracker& latencyTracker);
+};
+
+#endif
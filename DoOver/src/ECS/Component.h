@@ -0,0 +1,66 @@
+#ifndef COMPONENT_H
+#define COMPONENT_H
+
+#include <bitset>
+#include <vector>
+
+const unsigned int MAX_COMPONENTS = 64;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Signature
+/////////////////////////////////////////////////////////////////////////////////////////////
+// We use a bitset (1s and 0s) to keep track of which components an entity has,
+// and also helps keep track of which entities a system is interested in.
+/////////////////////////////////////////////////////////////////////////////////////////////
+typedef std::bitset<MAX_COMPONENTS> Signature;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Component
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Every component type declares a compile-time id with REGISTER_COMPONENT, right after
+// its definition. The ids are constants (no static guard on every lookup) and don't depend
+// on the order of first use, so they are stable across builds, save files and the network.
+// Never change or reuse the id of a component that already shipped.
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename TComponent>
+struct ComponentTraits
+{
+    static_assert(sizeof(TComponent) == 0, "Component type is not registered, declare it with REGISTER_COMPONENT(Type, id)");
+};
+
+// Records the name of each component id, returns false if the id was already taken by another type
+bool RegisterComponentName(int componentId, const char* name);
+const char* GetComponentName(int componentId);
+
+#define REGISTER_COMPONENT(TComponent, ID) \
+    template <> \
+    struct ComponentTraits<TComponent> \
+    { \
+        static_assert(ID >= 0 && ID < static_cast<int>(MAX_COMPONENTS), "Component id is out of range"); \
+        static constexpr int id = ID; \
+        static constexpr const char* name = #TComponent; \
+    }; \
+    inline const bool TComponent##IsRegistered = RegisterComponentName(ID, #TComponent);
+
+// Used to get the unique id of a component type
+template <typename TComponent>
+class Component
+{
+public:
+    // Returns the unique id of Component<T>
+    static constexpr int GetId()
+    {
+        return ComponentTraits<TComponent>::id;
+    }
+};
+
+// Builds the signature of a list of component types, e.g. MakeSignature<TransformComponent, SpriteComponent>()
+template <typename ...TComponents>
+Signature MakeSignature()
+{
+    Signature signature;
+    (signature.set(Component<TComponents>::GetId()), ...);
+    return signature;
+}
+
+#endif
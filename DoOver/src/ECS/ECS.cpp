@@ -1,32 +1,176 @@
 #include "ECS.h"
 #include "../Logger/Logger.h"
+#include "../Trace/EventTrace.h"
 #include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
-int IComponent::nextId = 0;
+#ifdef ENABLE_ECS_CHECKS
+void FailEcsCheck(const char* condition, const char* message, const char* file, int line)
+{
+    // Straight to stderr, the logger writes from its own thread and the abort would lose it
+    std::fprintf(stderr, "%s:%d: ECS check failed: %s (%s)\n", file, line, message, condition);
+    std::fflush(stderr);
+    std::abort();
+}
+#endif
+
+// A capacity of the entity handles is exhausted, going on would make handles that alias other
+// entities or registries
+[[noreturn]] static void FailEcsLimit(const std::string& message)
+{
+    std::fprintf(stderr, "ECS limit reached: %s\n", message.c_str());
+    std::fflush(stderr);
+    std::abort();
+}
+
+static const char** GetComponentNames()
+{
+    static const char* componentNames[MAX_COMPONENTS] = {};
+    return componentNames;
+}
+
+static std::vector<int>& GetDuplicateComponentIds()
+{
+    static std::vector<int> duplicateComponentIds;
+    return duplicateComponentIds;
+}
+
+bool RegisterComponentName(int componentId, const char* name)
+{
+    // Runs during static initialization, so the table is a function-local static and nothing is logged here
+    bool isDuplicate = GetComponentNames()[componentId] != nullptr;
+    if (isDuplicate)
+    {
+        GetDuplicateComponentIds().push_back(componentId);
+    }
+    GetComponentNames()[componentId] = name;
+    return !isDuplicate;
+}
 
-int Entity::GetId() const
+const char* GetComponentName(int componentId)
 {
-    return id;
+    const char* name = GetComponentNames()[componentId];
+    return name ? name : "";
+}
+
+static const ComponentReflection** GetComponentReflections()
+{
+    static const ComponentReflection* componentReflections[MAX_COMPONENTS] = {};
+    return componentReflections;
+}
+
+bool RegisterComponentReflection(const ComponentReflection* reflection)
+{
+    // The duplicate ids are already reported by their names
+    const bool isDuplicate = GetComponentReflections()[reflection->componentId] != nullptr;
+    GetComponentReflections()[reflection->componentId] = reflection;
+    return !isDuplicate;
+}
+
+const ComponentReflection* GetComponentReflection(int componentId)
+{
+    return componentId >= 0 && componentId < static_cast<int>(MAX_COMPONENTS) ? GetComponentReflections()[componentId] : nullptr;
+}
+
+void RemapComponentHandles(const ComponentReflection& reflection, void* component, const SnapshotRemap& remap)
+{
+    unsigned char* bytes = static_cast<unsigned char*>(component);
+    for (const auto& field: reflection.fields)
+    {
+        if (field.type == FIELD_ASSET_HANDLE)
+        {
+            AssetHandle* assetHandle = reinterpret_cast<AssetHandle*>(bytes + field.offset);
+            *assetHandle = remap.RemapAssetHandle(*assetHandle);
+        }
+        else if (field.type == FIELD_ENTITY)
+        {
+            // Loaded into the registry of the snapshot, with the same id and version
+            Entity* entity = reinterpret_cast<Entity*>(bytes + field.offset);
+            *entity = Entity(entity->GetId(), entity->GetVersion(), remap.registryIndex);
+        }
+    }
 }
 
+std::atomic<Registry*> Registry::registries[MAX_REGISTRIES];
+
 void Entity::Kill()
 {
-    registry->KillEntity(*this);
+    GetRegistry()->KillEntity(*this);
+}
+
+void Entity::Tag(const std::string& tag)
+{
+    GetRegistry()->TagEntity(*this, tag);
+}
+
+bool Entity::HasTag(const std::string& tag) const
+{
+    return GetRegistry()->EntityHasTag(*this, tag);
+}
+
+void Entity::Group(const std::string& group)
+{
+    GetRegistry()->GroupEntity(*this, group);
+}
+
+bool Entity::BelongsToGroup(const std::string& group) const
+{
+    return GetRegistry()->EntityBelongsToGroup(*this, group);
 }
 
 void System::AddEntityToSystem(Entity entity)
 {
+    const auto entityId = entity.GetId();
+    if (entityId >= static_cast<int>(entityIdToIndex.size()))
+    {
+        entityIdToIndex.resize(entityId + 1, -1);
+    }
+    if (entityIdToIndex[entityId] != -1)
+    {
+        return;
+    }
+    entityIdToIndex[entityId] = entities.size();
     entities.push_back(entity);
+    OnEntityAdded(entity);
 }
 
 void System::RemoveEntityFromSystem(Entity entity)
 {
-    entities.erase(std::remove_if(entities.begin(), entities.end(), [&entity](Entity other)
-                                  { return entity == other; }),
-                   entities.end());
+    if (!HasEntity(entity))
+    {
+        return;
+    }
+
+    // Swap the removed entity with the last one so the removal is O(1)
+    const auto entityId = entity.GetId();
+    const int indexOfRemoved = entityIdToIndex[entityId];
+    const Entity last = entities.back();
+    entities[indexOfRemoved] = last;
+    entityIdToIndex[last.GetId()] = indexOfRemoved;
+    entities.pop_back();
+    entityIdToIndex[entityId] = -1;
+    OnEntityRemoved(entity);
+}
+
+void System::Compact(int numEntities)
+{
+    if (numEntities < static_cast<int>(entityIdToIndex.size()))
+    {
+        entityIdToIndex.resize(numEntities);
+        entityIdToIndex.shrink_to_fit();
+    }
+    entities.shrink_to_fit();
+}
+
+bool System::HasEntity(Entity entity) const
+{
+    const auto entityId = entity.GetId();
+    return entityId < static_cast<int>(entityIdToIndex.size()) && entityIdToIndex[entityId] != -1;
 }
 
-std::vector<Entity> System::GetSystemEntities() const
+const std::vector<Entity>& System::GetSystemEntities() const
 {
     return entities;
 }
@@ -36,81 +180,1997 @@ const Signature &System::GetComponentSignature() const
     return componentSignature;
 }
 
-Entity Registry::CreateEntity()
+bool System::IsInterestedIn(const Signature& entitySignature) const
 {
-    int entityId;
-    if (freeIds.empty())
+    return (entitySignature & componentSignature) == componentSignature && (entitySignature & excludedSignature).none();
+}
+
+Archetype::Archetype(const Signature& signature, const std::vector<ComponentTypeInfo>& typeInfos): signature(signature), typeInfos(typeInfos)
+{
+    size_t rowSize = sizeof(int);
+    for (unsigned int componentId = 0; componentId < MAX_COMPONENTS; componentId++)
     {
-        entityId = numEntities++;
-        if (entityId >= static_cast<int>(entityComponentSignatures.size()))
+        columnOffsets[componentId] = -1;
+        if (signature.test(componentId))
         {
-            entityComponentSignatures.resize(entityId + 1);
+            componentIds.push_back(componentId);
+            rowSize += typeInfos[componentId].size;
         }
-        else
+    }
+
+    // Find how many rows fit in a chunk once every column is aligned to its component type
+    chunkCapacity = ARCHETYPE_CHUNK_SIZE / rowSize;
+    while (true)
+    {
+        size_t offset = chunkCapacity * sizeof(int);
+        for (auto componentId: componentIds)
+        {
+            const auto& info = typeInfos[componentId];
+            offset = (offset + info.alignment - 1) / info.alignment * info.alignment;
+            columnOffsets[componentId] = offset;
+            offset += chunkCapacity * info.size;
+        }
+        if (offset <= ARCHETYPE_CHUNK_SIZE || chunkCapacity == 1)
+        {
+            break;
+        }
+        chunkCapacity--;
+    }
+}
+
+Archetype::~Archetype()
+{
+    for (auto& chunk: chunks)
+    {
+        for (int row = 0; row < chunk->count; row++)
         {
-            // Reuse an id from the list of previously removed entities
-            entityId = freeIds.front();
-            freeIds.pop_front();
+            for (auto componentId: componentIds)
+            {
+                typeInfos[componentId].destroy(chunk->data + columnOffsets[componentId] + row * typeInfos[componentId].size);
+            }
         }
     }
+}
 
-    Entity entity(entityId);
-    entity.registry = this;
-    entitiesToBeAdded.insert(entity);
+EntityLocation Archetype::Allocate(int entityId)
+{
+    if (chunks.empty() || chunks.back()->count == chunkCapacity)
+    {
+        chunks.push_back(std::make_unique<ArchetypeChunk>());
+    }
+    auto& chunk = *chunks.back();
 
-    Logger::Log("Entity created with id = " + std::to_string(entityId));
-    
-    return entity;
+    EntityLocation location;
+    location.archetype = this;
+    location.chunk = chunks.size() - 1;
+    location.row = chunk.count++;
+    GetEntityIds(chunk)[location.row] = entityId;
+    return location;
 }
 
-void Registry::KillEntity(Entity entity)
+int Archetype::Free(int chunk, int row)
+{
+    for (auto componentId: componentIds)
+    {
+        typeInfos[componentId].destroy(GetComponent(chunk, row, componentId));
+    }
+
+    const int lastChunk = chunks.size() - 1;
+    const int lastRow = chunks[lastChunk]->count - 1;
+    int movedEntityId = -1;
+    if (chunk != lastChunk || row != lastRow)
+    {
+        // Fill the hole with the last row to keep the chunks packed
+        for (auto componentId: componentIds)
+        {
+            void* last = GetComponent(lastChunk, lastRow, componentId);
+            typeInfos[componentId].moveConstruct(GetComponent(chunk, row, componentId), last);
+            typeInfos[componentId].destroy(last);
+        }
+        movedEntityId = GetEntityIds(*chunks[lastChunk])[lastRow];
+        GetEntityIds(*chunks[chunk])[row] = movedEntityId;
+    }
+
+    if (--chunks[lastChunk]->count == 0)
+    {
+        chunks.pop_back();
+    }
+    return movedEntityId;
+}
+
+Archetype* ArchetypeStorage::GetOrCreateArchetype(const Signature& signature)
 {
-    entitiesToBeKilled.insert(entity);
+    auto archetype = archetypes.find(signature);
+    if (archetype != archetypes.end())
+    {
+        return archetype->second.get();
+    }
+    auto newArchetype = std::make_unique<Archetype>(signature, typeInfos);
+    archetypeList.push_back(newArchetype.get());
+    return archetypes.emplace(signature, std::move(newArchetype)).first->second.get();
 }
 
-void Registry::AddEntityToSystems(Entity entity)
+void ArchetypeStorage::MoveEntity(int entityId, Archetype* destination)
 {
-    const auto entityId = entity.GetId();
+    const EntityLocation source = entityLocations[entityId];
+    EntityLocation target;
+    if (destination)
+    {
+        target = destination->Allocate(entityId);
+    }
 
-    const auto& entityComponentSignature = entityComponentSignatures[entityId];
+    if (source.archetype)
+    {
+        // Carry the components that both archetypes share over to the new chunk
+        if (destination)
+        {
+            for (auto componentId: source.archetype->GetComponentIds())
+            {
+                if (destination->GetSignature().test(componentId))
+                {
+                    typeInfos[componentId].moveConstruct(
+                        destination->GetComponent(target.chunk, target.row, componentId),
+                        source.archetype->GetComponent(source.chunk, source.row, componentId)
+                    );
+                }
+            }
+        }
+        const int movedEntityId = source.archetype->Free(source.chunk, source.row);
+        if (movedEntityId != -1)
+        {
+            entityLocations[movedEntityId] = source;
+        }
+    }
+
+    entityLocations[entityId] = target;
+}
+
+void ArchetypeStorage::RegisterComponentType(int componentId, const ComponentTypeInfo& typeInfo)
+{
+    if (componentId >= static_cast<int>(typeInfos.size()))
+    {
+        typeInfos.resize(componentId + 1);
+    }
+    if (typeInfos[componentId].size == 0)
+    {
+        typeInfos[componentId] = typeInfo;
+    }
+}
 
-    for (auto& system: systems)
+void ArchetypeStorage::InsertEntities(const std::vector<int>& entityIds, const Signature& signature)
+{
+    if (signature.none() || entityIds.empty())
+    {
+        return;
+    }
+    const int maxEntityId = *std::max_element(entityIds.begin(), entityIds.end());
+    if (maxEntityId >= static_cast<int>(entityLocations.size()))
+    {
+        entityLocations.resize(maxEntityId + 1);
+    }
+    Archetype* archetype = GetOrCreateArchetype(signature);
+    for (auto entityId: entityIds)
+    {
+        entityLocations[entityId] = archetype->Allocate(entityId);
+    }
+}
+
+void* ArchetypeStorage::GetComponentData(int entityId, int componentId) const
+{
+    const EntityLocation& location = entityLocations[entityId];
+    return location.archetype->GetComponent(location.chunk, location.row, componentId);
+}
+
+void ArchetypeStorage::RemoveComponent(int entityId, int componentId)
+{
+    if (entityId >= static_cast<int>(entityLocations.size()))
+    {
+        return;
+    }
+    const EntityLocation& location = entityLocations[entityId];
+    if (!location.archetype || !location.archetype->GetSignature().test(componentId))
+    {
+        return;
+    }
+
+    Signature signature = location.archetype->GetSignature();
+    signature.reset(componentId);
+    MoveEntity(entityId, signature.none() ? nullptr : GetOrCreateArchetype(signature));
+}
+
+void ArchetypeStorage::RemoveEntity(int entityId)
+{
+    if (entityId < static_cast<int>(entityLocations.size()) && entityLocations[entityId].archetype)
+    {
+        MoveEntity(entityId, nullptr);
+    }
+}
+
+void ArchetypeStorage::Compact(int numEntities)
+{
+    if (numEntities < static_cast<int>(entityLocations.size()))
+    {
+        entityLocations.resize(numEntities);
+        entityLocations.shrink_to_fit();
+    }
+}
+
+void ArchetypeStorage::SortEntities(const std::vector<uint32_t>& entityKeys)
+{
+    auto isBefore = [&entityKeys](int entityIdA, int entityIdB) { return IsEntityKeyBefore(entityKeys, entityIdA, entityIdB); };
+    std::vector<int> sortedIds;
+    for (auto archetype: archetypeList)
     {
-        const auto& systemComponentSignature = system.second->GetComponentSignature();
+        // The chunks are packed, row i of the archetype is row i % capacity of chunk i / capacity
+        sortedIds.clear();
+        for (int chunk = 0; chunk < archetype->GetNumChunks(); chunk++)
+        {
+            ArchetypeChunk& archetypeChunk = archetype->GetChunk(chunk);
+            const int* entityIds = archetype->GetEntityIds(archetypeChunk);
+            sortedIds.insert(sortedIds.end(), entityIds, entityIds + archetypeChunk.count);
+        }
+        if (sortedIds.size() < 2 || std::is_sorted(sortedIds.begin(), sortedIds.end(), isBefore))
+        {
+            continue;
+        }
+        std::sort(sortedIds.begin(), sortedIds.end(), isBefore);
 
-        bool isInterested = (entityComponentSignature & systemComponentSignature) == systemComponentSignature;
-        if(isInterested)
+        // Column by column, every component is moved out once and back into its new row
+        const int capacity = archetype->GetChunkCapacity();
+        const int numRows = sortedIds.size();
+        for (auto componentId: archetype->GetComponentIds())
+        {
+            const ComponentTypeInfo& typeInfo = typeInfos[componentId];
+            unsigned char* scratch = static_cast<unsigned char*>(::operator new(numRows * typeInfo.size, std::align_val_t(typeInfo.alignment)));
+            for (int i = 0; i < numRows; i++)
+            {
+                const EntityLocation& location = entityLocations[sortedIds[i]];
+                void* component = archetype->GetComponent(location.chunk, location.row, componentId);
+                typeInfo.moveConstruct(scratch + i * typeInfo.size, component);
+                typeInfo.destroy(component);
+            }
+            for (int i = 0; i < numRows; i++)
+            {
+                typeInfo.moveConstruct(archetype->GetComponent(i / capacity, i % capacity, componentId), scratch + i * typeInfo.size);
+                typeInfo.destroy(scratch + i * typeInfo.size);
+            }
+            ::operator delete(scratch, std::align_val_t(typeInfo.alignment));
+        }
+        for (int i = 0; i < numRows; i++)
         {
-            system.second->AddEntityToSystem(entity);
+            archetype->GetEntityIds(archetype->GetChunk(i / capacity))[i % capacity] = sortedIds[i];
+            entityLocations[sortedIds[i]] = {archetype, i / capacity, i % capacity};
         }
     }
 }
 
-void Registry::RemoveEntityFromSystems(Entity entity)
+void ArchetypeStorage::AddComponentStats(std::vector<ComponentStats>& stats) const
 {
-    for (auto system: systems)
+    for (auto archetype: archetypeList)
     {
-        system.second->RemoveEntityFromSystem(entity);
+        int numEntities = 0;
+        for (int i = 0; i < archetype->GetNumChunks(); i++)
+        {
+            numEntities += archetype->GetChunk(i).count;
+        }
+        const size_t numRows = archetype->GetNumChunks() * archetype->GetChunkCapacity();
+        for (auto componentId: archetype->GetComponentIds())
+        {
+            if (componentId >= static_cast<int>(stats.size()))
+            {
+                stats.resize(componentId + 1, {0, 0, 0, 0, 0, 0});
+            }
+            stats[componentId].componentId = componentId;
+            stats[componentId].numComponents += numEntities;
+            stats[componentId].numBytes += numRows * typeInfos[componentId].size;
+            stats[componentId].capacity += numRows;
+            stats[componentId].numUsedBytes += numEntities * typeInfos[componentId].size;
+        }
     }
 }
 
-void Registry::Update()
+void ArchetypeStorage::Clear()
 {
-    // Processing the entities that are waiting to be created to the active Systems
-    for (auto entity: entitiesToBeAdded)
+    archetypeList.clear();
+    archetypes.clear();
+    entityLocations.clear();
+}
+
+void ComponentBitPlanes::SetBit(std::vector<uint64_t>& plane, int entityId, bool isSet)
+{
+    const size_t word = entityId >> 6;
+    const uint64_t bit = uint64_t(1) << (entityId & 63);
+    if (word >= plane.size())
+    {
+        if (!isSet)
+        {
+            return;
+        }
+        plane.resize(word + 1, 0);
+    }
+    plane[word] = isSet ? plane[word] | bit : plane[word] & ~bit;
+}
+
+void ComponentBitPlanes::Update(int entityId, const Signature& oldSignature, const Signature& newSignature)
+{
+    const Signature changed = oldSignature ^ newSignature;
+    if (changed.none())
+    {
+        return;
+    }
+    for (int componentId = 0; componentId < static_cast<int>(MAX_COMPONENTS); componentId++)
     {
-        AddEntityToSystems(entity);
+        if (changed.test(componentId))
+        {
+            SetBit(planes[componentId], entityId, newSignature.test(componentId));
+        }
     }
-    entitiesToBeAdded.clear();
+    SetBit(entityPlane, entityId, newSignature.any());
+}
 
-    // Processing the entities that are waiting to be killed from the active Systems
-    for (auto entity: entitiesToBeKilled)
+void ComponentBitPlanes::Clear()
+{
+    for (auto& plane: planes)
+    {
+        plane.clear();
+    }
+    entityPlane.clear();
+}
+
+void ComponentBitPlanes::Compact(int numEntities)
+{
+    const size_t numWords = (numEntities + 63) >> 6;
+    entityPlane.resize(std::min(entityPlane.size(), numWords));
+    entityPlane.shrink_to_fit();
+    for (auto& plane: planes)
+    {
+        plane.resize(std::min(plane.size(), numWords));
+        plane.shrink_to_fit();
+    }
+}
+
+size_t ComponentBitPlanes::GetMemoryUsage() const
+{
+    size_t numBytes = entityPlane.capacity() * sizeof(uint64_t);
+    for (const auto& plane: planes)
+    {
+        numBytes += plane.capacity() * sizeof(uint64_t);
+    }
+    return numBytes;
+}
+
+void EntityCommandBuffer::SortAndDeduplicate()
+{
+    auto sortAndDeduplicate = [](auto& commands)
+    {
+        std::sort(commands.begin(), commands.end());
+        commands.erase(std::unique(commands.begin(), commands.end()), commands.end());
+    };
+    sortAndDeduplicate(createdEntityIds);
+    sortAndDeduplicate(killedEntityIds);
+    sortAndDeduplicate(addedComponents);
+    sortAndDeduplicate(removedComponents);
+}
+
+void EntityCommandBuffer::Clear()
+{
+    createdEntityIds.clear();
+    killedEntityIds.clear();
+    addedComponents.clear();
+    removedComponents.clear();
+}
+
+DeferredEntity ThreadCommandBuffer::CreateEntity()
+{
+    commands.push_back({COMMAND_CREATE_ENTITY, Entity(0, 0, 0), numDeferredEntities, 0, nullptr, GetCurrentEventOrder()});
+    return {numDeferredEntities++};
+}
+
+void ThreadCommandBuffer::KillEntity(Entity entity)
+{
+    commands.push_back({COMMAND_KILL_ENTITY, entity, -1, 0, nullptr, GetCurrentEventOrder()});
+}
+
+void ThreadCommandBuffer::Apply(Registry& registry, const Command& command) const
+{
+    const Entity entity = command.deferredIndex != -1 ? createdEntities[command.deferredIndex] : command.entity;
+    if (!registry.IsAlive(entity))
+    {
+        return;
+    }
+    if (command.type == COMMAND_KILL_ENTITY)
+    {
+        registry.KillEntity(entity);
+    }
+    else
+    {
+        command.apply(registry, entity, componentData.data() + command.dataOffset);
+    }
+}
+
+void ThreadCommandBuffer::Playback(Registry& registry)
+{
+    createdEntities.resize(numDeferredEntities, Entity(0, 0, 0));
+    for (const auto& command: commands)
+    {
+        if (command.type == COMMAND_CREATE_ENTITY)
+        {
+            createdEntities[command.deferredIndex] = registry.CreateEntity();
+        }
+        else
+        {
+            Apply(registry, command);
+        }
+    }
+    Clear();
+}
+
+void ThreadCommandBuffer::PlaybackInOrder(Registry& registry, std::vector<ThreadCommandBuffer>& buffers)
+{
+    struct OrderedCommand
+    {
+        uint64_t order;
+        int bufferIndex;
+        int commandIndex;
+    };
+    std::vector<OrderedCommand> orderedCommands;
+    for (int i = 0; i < static_cast<int>(buffers.size()); i++)
+    {
+        buffers[i].createdEntities.resize(buffers[i].numDeferredEntities, Entity(0, 0, 0));
+        for (int j = 0; j < static_cast<int>(buffers[i].commands.size()); j++)
+        {
+            orderedCommands.push_back({buffers[i].commands[j].order, i, j});
+        }
+    }
+    if (orderedCommands.empty())
     {
-        RemoveEntityFromSystems(entity);
-        entityComponentSignatures[entity.GetId()].reset();
+        return;
+    }
+    // Stable, the commands of one order keep the order of their buffer
+    std::stable_sort(orderedCommands.begin(), orderedCommands.end(), [](const OrderedCommand& a, const OrderedCommand& b) { return a.order < b.order; });
 
-        // Make the entity id available to be reused
-        freeIds.push_back(entity.GetId());
+    // The ids are handed out in order too, and a command sorted before the creation of its
+    // entity still finds it
+    for (const auto& orderedCommand: orderedCommands)
+    {
+        ThreadCommandBuffer& buffer = buffers[orderedCommand.bufferIndex];
+        const Command& command = buffer.commands[orderedCommand.commandIndex];
+        if (command.type == COMMAND_CREATE_ENTITY)
+        {
+            buffer.createdEntities[command.deferredIndex] = registry.CreateEntity();
+        }
+    }
+    for (const auto& orderedCommand: orderedCommands)
+    {
+        const ThreadCommandBuffer& buffer = buffers[orderedCommand.bufferIndex];
+        const Command& command = buffer.commands[orderedCommand.commandIndex];
+        if (command.type != COMMAND_CREATE_ENTITY)
+        {
+            buffer.Apply(registry, command);
+        }
+    }
+    for (auto& buffer: buffers)
+    {
+        buffer.Clear();
     }
-    entitiesToBeKilled.clear();
+}
+
+void ThreadCommandBuffer::Clear()
+{
+    commands.clear();
+    componentData.clear();
+    numDeferredEntities = 0;
+}
+
+Registry::Registry(StorageMode storageMode): storageMode(storageMode), threadCommandBuffers(MAX_JOB_THREADS)
+{
+    // Claim a free slot in the registries table so entity handles can find their registry
+    for (unsigned int i = 0; i < MAX_REGISTRIES; i++)
+    {
+        Registry* expected = nullptr;
+        if (registries[i].compare_exchange_strong(expected, this))
+        {
+            registryIndex = i;
+            break;
+        }
+    }
+    if (registryIndex == -1)
+    {
+        FailEcsLimit("Too many registries, the maximum is " + std::to_string(MAX_REGISTRIES) + "!");
+    }
+
+    owningGroupPerComponent.fill(-1);
+
+    for (auto componentId: GetDuplicateComponentIds())
+    {
+        Logger::Err("Component id = " + std::to_string(componentId) + " is registered by more than one component type!");
+    }
+
+    if (storageMode == STORAGE_ARCHETYPE)
+    {
+        archetypeStorage = std::make_unique<ArchetypeStorage>();
+    }
+    Logger::Log("Registry constructor called!");
+}
+
+Registry::~Registry()
+{
+    if (registryIndex != -1)
+    {
+        registries[registryIndex].store(nullptr);
+    }
+    Logger::Log("Registry destructor called!");
+}
+
+int Registry::AllocateEntityId()
+{
+    int entityId;
+    if (static_cast<int>(freeIds.size()) <= MIN_FREE_ENTITY_IDS && (numEntities < static_cast<int>(MAX_ENTITIES) || freeIds.empty()))
+    {
+        if (numEntities >= static_cast<int>(MAX_ENTITIES))
+        {
+            FailEcsLimit("Cannot create more than " + std::to_string(MAX_ENTITIES) + " entities!");
+        }
+        entityId = numEntities++;
+        if (entityId >= static_cast<int>(entityComponentSignatures.size()))
+        {
+            entityComponentSignatures.resize(entityId + 1);
+            entitySystemSignatures.resize(entityId + 1);
+            ResizeChangeFlags(entityId + 1);
+        }
+        if (entityId >= static_cast<int>(entityVersions.size()))
+        {
+            entityVersions.resize(entityId + 1, 0);
+        }
+    }
+    else
+    {
+        // Reuse the id removed the longest ago
+        entityId = freeIds.front();
+        freeIds.pop_front();
+    }
+    return entityId;
+}
+
+void Registry::ResizeChangeFlags(int size)
+{
+    for (auto& changes: componentChanges)
+    {
+        if (changes)
+        {
+            changes->isChanged.resize(size, 0);
+        }
+    }
+}
+
+void Registry::CommitChanges()
+{
+    for (auto& changes: componentChanges)
+    {
+        if (!changes)
+        {
+            continue;
+        }
+        auto& changed = changes->history[changeVersion % CHANGE_HISTORY_LENGTH];
+        changed.clear();
+        auto& isChanged = changes->isChanged;
+        for (int entityId = 0; entityId < static_cast<int>(isChanged.size()); entityId++)
+        {
+            if (isChanged[entityId])
+            {
+                changed.push_back(GetEntity(entityId));
+                isChanged[entityId] = 0;
+            }
+        }
+    }
+    changeVersion++;
+}
+
+Entity Registry::CreateEntity()
+{
+    const int entityId = AllocateEntityId();
+    Entity entity = GetEntity(entityId);
+    commandBuffer.createdEntityIds.push_back(entityId);
+
+    LOGGER_DEBUG("Entity created with id = {}", entityId);
+    
+    return entity;
+}
+
+std::vector<Entity> Registry::Instantiate(const Prefab& prefab, int count)
+{
+    PROFILE_SCOPE("Registry::Instantiate");
+    std::vector<int> entityIds;
+    entityIds.reserve(count);
+
+    // Grow the per-entity arrays once for the ids past the end
+    const int numNewIds = std::max(0, count - std::max(0, static_cast<int>(freeIds.size()) - MIN_FREE_ENTITY_IDS));
+    if (numEntities + numNewIds > static_cast<int>(entityComponentSignatures.size()))
+    {
+        entityComponentSignatures.resize(numEntities + numNewIds);
+        entitySystemSignatures.resize(numEntities + numNewIds);
+        ResizeChangeFlags(numEntities + numNewIds);
+    }
+    for (int i = 0; i < count; i++)
+    {
+        entityIds.push_back(AllocateEntityId());
+    }
+
+    if (storageMode == STORAGE_ARCHETYPE)
+    {
+        for (const auto& component: prefab.components)
+        {
+            archetypeStorage->RegisterComponentType(component.componentId, component.typeInfo);
+        }
+        archetypeStorage->InsertEntities(entityIds, prefab.signature);
+    }
+    for (const auto& component: prefab.components)
+    {
+        component.instantiate(*this, component.component.get(), entityIds);
+    }
+
+    // The systems see the whole signature at once when the creations are processed
+    std::vector<Entity> entities;
+    entities.reserve(count);
+    for (auto entityId: entityIds)
+    {
+        entityComponentSignatures[entityId] = prefab.signature;
+        entities.push_back(GetEntity(entityId));
+    }
+    commandBuffer.createdEntityIds.insert(commandBuffer.createdEntityIds.end(), entityIds.begin(), entityIds.end());
+
+    LOGGER_DEBUG("{} entities instantiated from a prefab", count);
+    return entities;
+}
+
+void Registry::KillEntity(Entity entity)
+{
+    // Stale handles must not kill the entity that reused their id
+    if (!IsAlive(entity))
+    {
+        return;
+    }
+    commandBuffer.killedEntityIds.push_back(entity.GetId());
+}
+
+void Registry::TagEntity(Entity entity, const std::string& tag)
+{
+    if (!IsAlive(entity))
+    {
+        return;
+    }
+    RemoveEntityTag(entity);
+    auto previous = entityPerTag.find(tag);
+    if (previous != entityPerTag.end())
+    {
+        tagPerEntity.erase(previous->second.GetId());
+    }
+    entityPerTag.insert_or_assign(tag, entity);
+    tagPerEntity.emplace(entity.GetId(), tag);
+}
+
+bool Registry::EntityHasTag(Entity entity, const std::string& tag) const
+{
+    auto entityTag = tagPerEntity.find(entity.GetId());
+    return entityTag != tagPerEntity.end() && entityTag->second == tag && IsAlive(entity);
+}
+
+bool Registry::FindEntityByTag(const std::string& tag, Entity& entity) const
+{
+    auto taggedEntity = entityPerTag.find(tag);
+    if (taggedEntity == entityPerTag.end())
+    {
+        return false;
+    }
+    entity = taggedEntity->second;
+    return true;
+}
+
+void Registry::RemoveEntityTag(Entity entity)
+{
+    auto entityTag = tagPerEntity.find(entity.GetId());
+    if (entityTag == tagPerEntity.end() || !IsAlive(entity))
+    {
+        return;
+    }
+    entityPerTag.erase(entityTag->second);
+    tagPerEntity.erase(entityTag);
+}
+
+void Registry::GroupEntity(Entity entity, const std::string& group)
+{
+    if (!IsAlive(entity))
+    {
+        return;
+    }
+    RemoveEntityGroup(entity);
+    auto& entities = entitiesPerGroup[group];
+    groupPerEntity.emplace(entity.GetId(), GroupMembership{group, static_cast<int>(entities.size())});
+    entities.push_back(entity);
+}
+
+bool Registry::EntityBelongsToGroup(Entity entity, const std::string& group) const
+{
+    auto membership = groupPerEntity.find(entity.GetId());
+    return membership != groupPerEntity.end() && membership->second.group == group && IsAlive(entity);
+}
+
+const std::vector<Entity>& Registry::GetEntitiesByGroup(const std::string& group) const
+{
+    static const std::vector<Entity> noEntities;
+    auto entities = entitiesPerGroup.find(group);
+    return entities != entitiesPerGroup.end() ? entities->second : noEntities;
+}
+
+void Registry::RemoveEntityGroup(Entity entity)
+{
+    auto membership = groupPerEntity.find(entity.GetId());
+    if (membership == groupPerEntity.end() || !IsAlive(entity))
+    {
+        return;
+    }
+
+    // Swap the removed entity with the last one of the group so the removal is O(1)
+    auto group = entitiesPerGroup.find(membership->second.group);
+    auto& entities = group->second;
+    const Entity last = entities.back();
+    entities[membership->second.index] = last;
+    groupPerEntity[last.GetId()].index = membership->second.index;
+    entities.pop_back();
+    if (entities.empty())
+    {
+        entitiesPerGroup.erase(group);
+    }
+    groupPerEntity.erase(entity.GetId());
+}
+
+void Registry::SetEntityParent(Entity child, Entity parent, OrphanPolicy policy)
+{
+    if (!IsAlive(child) || !IsAlive(parent))
+    {
+        return;
+    }
+    // A cycle would keep its entities as each other's children forever
+    Entity ancestor = parent;
+    while (true)
+    {
+        if (ancestor == child)
+        {
+            Logger::Err("Entity id " + std::to_string(child.GetId()) + " can't be the child of its descendant " + std::to_string(parent.GetId()));
+            return;
+        }
+        auto link = parentPerEntity.find(ancestor.GetId());
+        if (link == parentPerEntity.end())
+        {
+            break;
+        }
+        ancestor = link->second.parent;
+    }
+    RemoveEntityParent(child);
+    auto& children = childrenPerEntity[parent.GetId()];
+    parentPerEntity.emplace(child.GetId(), ParentLink{parent, static_cast<int>(children.size()), policy});
+    children.push_back(child);
+}
+
+bool Registry::GetEntityParent(Entity child, Entity& parent) const
+{
+    auto link = parentPerEntity.find(child.GetId());
+    if (link == parentPerEntity.end() || !IsAlive(child))
+    {
+        return false;
+    }
+    parent = link->second.parent;
+    return true;
+}
+
+void Registry::RemoveEntityParent(Entity child)
+{
+    auto link = parentPerEntity.find(child.GetId());
+    if (link == parentPerEntity.end() || !IsAlive(child))
+    {
+        return;
+    }
+
+    // Swap the removed child with the last one of its parent so the removal is O(1)
+    auto children = childrenPerEntity.find(link->second.parent.GetId());
+    auto& entities = children->second;
+    const Entity last = entities.back();
+    entities[link->second.index] = last;
+    parentPerEntity.find(last.GetId())->second.index = link->second.index;
+    entities.pop_back();
+    if (entities.empty())
+    {
+        childrenPerEntity.erase(children);
+    }
+    parentPerEntity.erase(child.GetId());
+}
+
+const std::vector<Entity>& Registry::GetEntityChildren(Entity parent) const
+{
+    static const std::vector<Entity> noEntities;
+    auto children = childrenPerEntity.find(parent.GetId());
+    return children != childrenPerEntity.end() && IsAlive(parent) ? children->second : noEntities;
+}
+
+void Registry::PairEntities(Entity first, Entity second)
+{
+    if (!IsAlive(first) || !IsAlive(second) || first == second)
+    {
+        return;
+    }
+    RemoveEntityPair(first);
+    RemoveEntityPair(second);
+    pairPerEntity.emplace(first.GetId(), second);
+    pairPerEntity.emplace(second.GetId(), first);
+}
+
+bool Registry::GetEntityPair(Entity entity, Entity& pair) const
+{
+    auto link = pairPerEntity.find(entity.GetId());
+    if (link == pairPerEntity.end() || !IsAlive(entity))
+    {
+        return false;
+    }
+    pair = link->second;
+    return true;
+}
+
+void Registry::RemoveEntityPair(Entity entity)
+{
+    auto link = pairPerEntity.find(entity.GetId());
+    if (link == pairPerEntity.end() || !IsAlive(entity))
+    {
+        return;
+    }
+    pairPerEntity.erase(link->second.GetId());
+    pairPerEntity.erase(link);
+}
+
+void Registry::RemoveEntityRelationships(Entity entity)
+{
+    Entity grandparent = entity;
+    const bool hasGrandparent = GetEntityParent(entity, grandparent);
+    RemoveEntityParent(entity);
+
+    // The children to be killed with it are in the kill list already, they are only unlinked
+    auto children = childrenPerEntity.find(entity.GetId());
+    if (children != childrenPerEntity.end())
+    {
+        for (auto child: children->second)
+        {
+            auto link = parentPerEntity.find(child.GetId());
+            const OrphanPolicy policy = link->second.policy;
+            parentPerEntity.erase(link);
+            if (policy == ORPHAN_REPARENTED && hasGrandparent)
+            {
+                SetEntityParent(child, grandparent, policy);
+            }
+        }
+        childrenPerEntity.erase(entity.GetId());
+    }
+
+    RemoveEntityPair(entity);
+}
+
+void Registry::Clear()
+{
+    // The systems and queries go first, they don't see the entities leave one by one
+    systems.clear();
+    queries.clear();
+    componentObservers.clear();
+    observedComponents.reset();
+    owningGroups.clear();
+    owningGroupPerComponent.fill(-1);
+    ClearEntities();
+
+    Logger::Log("Registry cleared");
+}
+
+void Registry::ClearEntities()
+{
+    for (auto& pool: componentPools)
+    {
+        if (pool)
+        {
+            pool->Clear();
+        }
+    }
+    if (storageMode == STORAGE_ARCHETYPE)
+    {
+        archetypeStorage->Clear();
+    }
+    for (auto& group: owningGroups)
+    {
+        group.size = 0;
+    }
+
+    // The ids restart from 0, each one a version up from the entity that last had it
+    for (int entityId = 0; entityId < numEntities; entityId++)
+    {
+        entityVersions[entityId]++;
+    }
+    numEntities = 0;
+    freeIds.clear();
+    entityComponentSignatures.clear();
+    entitySystemSignatures.clear();
+    entitySystemPlanes.Clear();
+    commandBuffer.Clear();
+    processingCommandBuffer.Clear();
+    for (auto& threadCommands: threadCommandBuffers)
+    {
+        threadCommands.Clear();
+    }
+
+    for (auto& changes: componentChanges)
+    {
+        if (changes)
+        {
+            changes->isChanged.clear();
+            for (auto& commit: changes->history)
+            {
+                commit.clear();
+            }
+        }
+    }
+
+    entityPerTag.clear();
+    tagPerEntity.clear();
+    entitiesPerGroup.clear();
+    groupPerEntity.clear();
+    parentPerEntity.clear();
+    childrenPerEntity.clear();
+    pairPerEntity.clear();
+}
+
+bool Registry::WriteSnapshot(SnapshotWriter& writer, const std::vector<bool>* isEntityVisible) const
+{
+    if (storageMode == STORAGE_ARCHETYPE)
+    {
+        Logger::Err("Snapshots of the archetype storage are not supported!");
+        return false;
+    }
+
+    // Signatures as varints, most entities have a handful of the lowest component ids
+    writer.WriteVarint(numEntities);
+    for (int entityId = 0; entityId < numEntities; entityId++)
+    {
+        const bool isVisible = !isEntityVisible || (entityId < static_cast<int>(isEntityVisible->size()) && (*isEntityVisible)[entityId]);
+        writer.WriteVarint(isVisible ? entityComponentSignatures[entityId].to_ullong() : 0);
+    }
+    // The versions past the live ids are kept too, they stay stale for the old handles
+    writer.WriteVarint(entityVersions.size());
+    writer.WriteBytes(entityVersions.data(), entityVersions.size());
+    writer.WriteVarint(freeIds.size());
+    for (auto entityId: freeIds)
+    {
+        writer.WriteVarint(entityId);
+    }
+
+    int numPools = 0;
+    for (const auto& pool: componentPools)
+    {
+        if (pool && pool->GetNumComponents() > 0)
+        {
+            numPools++;
+        }
+    }
+    writer.WriteVarint(numPools);
+    for (int componentId = 0; componentId < static_cast<int>(componentPools.size()); componentId++)
+    {
+        if (componentPools[componentId] && componentPools[componentId]->GetNumComponents() > 0)
+        {
+            writer.WriteVarint(componentId);
+            componentPools[componentId]->WriteSnapshot(writer, isEntityVisible);
+        }
+    }
+
+    writer.WriteVarint(entityPerTag.size());
+    for (const auto& tag: entityPerTag)
+    {
+        writer.WriteString(tag.first);
+        writer.WriteVarint(tag.second.GetId());
+    }
+    writer.WriteVarint(entitiesPerGroup.size());
+    for (const auto& group: entitiesPerGroup)
+    {
+        writer.WriteString(group.first);
+        writer.WriteVarint(group.second.size());
+        for (auto entity: group.second)
+        {
+            writer.WriteVarint(entity.GetId());
+        }
+    }
+    // The children of each parent in their order, and each pair from both ends
+    writer.WriteVarint(childrenPerEntity.size());
+    for (const auto& children: childrenPerEntity)
+    {
+        writer.WriteVarint(children.first);
+        writer.WriteVarint(children.second.size());
+        for (auto child: children.second)
+        {
+            writer.WriteVarint(child.GetId());
+            writer.WriteVarint(parentPerEntity.find(child.GetId())->second.policy);
+        }
+    }
+    writer.WriteVarint(pairPerEntity.size());
+    for (const auto& pair: pairPerEntity)
+    {
+        writer.WriteVarint(pair.first);
+        writer.WriteVarint(pair.second.GetId());
+    }
+    return true;
+}
+
+bool Registry::ReadSnapshot(SnapshotReader& reader, const SnapshotRemap& remap)
+{
+    if (storageMode == STORAGE_ARCHETYPE)
+    {
+        Logger::Err("Snapshots of the archetype storage are not supported!");
+        return false;
+    }
+
+    // Every entity leaves its systems as if it was killed, then the state is replaced
+    for (int entityId = 0; entityId < numEntities; entityId++)
+    {
+        if (entitySystemSignatures[entityId].any())
+        {
+            RemoveEntityFromSystems(GetEntity(entityId));
+        }
+    }
+    ClearEntities();
+
+    auto fail = [this](const std::string& message)
+    {
+        Logger::Err("Cannot load the snapshot: " + message);
+        numEntities = std::min(numEntities, static_cast<int>(entityVersions.size()));
+        ClearEntities();
+        return false;
+    };
+    auto readEntityId = [this, &reader]()
+    {
+        const uint64_t entityId = reader.ReadVarint();
+        if (entityId >= static_cast<uint64_t>(numEntities))
+        {
+            reader.Fail();
+            return 0;
+        }
+        return static_cast<int>(entityId);
+    };
+
+    numEntities = reader.ReadCount(MAX_ENTITIES);
+    entityComponentSignatures.resize(numEntities);
+    entitySystemSignatures.resize(numEntities);
+    ResizeChangeFlags(numEntities);
+    for (int entityId = 0; entityId < numEntities; entityId++)
+    {
+        entityComponentSignatures[entityId] = Signature(reader.ReadVarint());
+    }
+    const int numVersions = reader.ReadCount(MAX_ENTITIES);
+    if (numVersions < numEntities)
+    {
+        reader.Fail();
+    }
+    entityVersions.resize(std::max(numVersions, static_cast<int>(entityVersions.size())), 0);
+    reader.ReadBytes(entityVersions.data(), numVersions);
+    const int numFreeIds = reader.ReadCount(numEntities);
+    freeIds.resize(numFreeIds);
+    // A free id is listed once and has no components, else it would be handed out twice or
+    // while its entity is still alive
+    std::vector<bool> isFree(numEntities, false);
+    for (auto& entityId: freeIds)
+    {
+        entityId = readEntityId();
+        if (reader.HasFailed() || isFree[entityId] || entityComponentSignatures[entityId].any())
+        {
+            reader.Fail();
+            break;
+        }
+        isFree[entityId] = true;
+    }
+    if (reader.HasFailed())
+    {
+        return fail("the entities are corrupt");
+    }
+
+    const int numPools = reader.ReadCount(MAX_COMPONENTS);
+    for (int i = 0; i < numPools; i++)
+    {
+        const int componentId = reader.ReadCount(MAX_COMPONENTS - 1);
+        if (reader.HasFailed())
+        {
+            return fail("the components are corrupt");
+        }
+        if (componentId >= static_cast<int>(componentPools.size()) || !componentPools[componentId])
+        {
+            return fail(std::string("there is no pool of ") + GetComponentName(componentId));
+        }
+        if (!componentPools[componentId]->ReadSnapshot(reader, remap))
+        {
+            return fail(std::string("the pool of ") + GetComponentName(componentId) + " doesn't match");
+        }
+    }
+    // The snapshot may come from the network, the signatures and the pools must agree before
+    // anything is looked up through them
+    for (int componentId = 0; componentId < static_cast<int>(MAX_COMPONENTS); componentId++)
+    {
+        const IPool* pool = componentId < static_cast<int>(componentPools.size()) ? componentPools[componentId].get() : nullptr;
+        if (pool)
+        {
+            for (auto entityId: pool->GetEntityIds())
+            {
+                if (entityId >= numEntities || !entityComponentSignatures[entityId].test(componentId))
+                {
+                    return fail(std::string("the pool of ") + GetComponentName(componentId) + " has components of other entities");
+                }
+            }
+        }
+        for (int entityId = 0; entityId < numEntities; entityId++)
+        {
+            if (entityComponentSignatures[entityId].test(componentId) && (!pool || pool->GetIndex(entityId) == -1))
+            {
+                return fail("entity " + std::to_string(entityId) + " has no component " + std::to_string(componentId) + " in the pools");
+            }
+        }
+    }
+    // The pools come back in the order they were written, the groups are packed again
+    for (auto& group: owningGroups)
+    {
+        BuildOwningGroup(group);
+    }
+
+    const int numTags = reader.ReadCount(MAX_ENTITIES);
+    for (int i = 0; i < numTags && !reader.HasFailed(); i++)
+    {
+        const std::string tag = reader.ReadString();
+        const int entityId = readEntityId();
+        // One tag per entity and one entity per tag
+        if (reader.HasFailed() || !entityPerTag.emplace(tag, GetEntity(entityId)).second || !tagPerEntity.emplace(entityId, tag).second)
+        {
+            reader.Fail();
+            break;
+        }
+    }
+    const int numGroups = reader.ReadCount(MAX_ENTITIES);
+    for (int i = 0; i < numGroups && !reader.HasFailed(); i++)
+    {
+        // Each group is listed once and each entity is in one group, at the index it has there
+        const std::string group = reader.ReadString();
+        if (entitiesPerGroup.count(group) > 0)
+        {
+            reader.Fail();
+            break;
+        }
+        auto& entities = entitiesPerGroup[group];
+        const int numGroupEntities = reader.ReadCount(numEntities);
+        entities.reserve(numGroupEntities);
+        for (int index = 0; index < numGroupEntities; index++)
+        {
+            const int entityId = readEntityId();
+            if (reader.HasFailed() || !groupPerEntity.emplace(entityId, GroupMembership{group, index}).second)
+            {
+                reader.Fail();
+                break;
+            }
+            entities.push_back(GetEntity(entityId));
+        }
+    }
+    if (reader.HasFailed())
+    {
+        return fail("the tags or groups are corrupt");
+    }
+
+    // Each child has one parent and its index in the children of that parent, like
+    // SetEntityParent keeps them
+    const int numParents = reader.ReadCount(MAX_ENTITIES);
+    for (int i = 0; i < numParents && !reader.HasFailed(); i++)
+    {
+        const Entity parent = GetEntity(readEntityId());
+        if (childrenPerEntity.count(parent.GetId()) > 0)
+        {
+            reader.Fail();
+            break;
+        }
+        auto& children = childrenPerEntity[parent.GetId()];
+        const int numChildren = reader.ReadCount(numEntities);
+        children.reserve(numChildren);
+        for (int index = 0; index < numChildren; index++)
+        {
+            const int entityId = readEntityId();
+            const OrphanPolicy policy = static_cast<OrphanPolicy>(reader.ReadCount(ORPHAN_KILLED));
+            if (reader.HasFailed() || entityId == parent.GetId() || !parentPerEntity.emplace(entityId, ParentLink{parent, index, policy}).second)
+            {
+                reader.Fail();
+                break;
+            }
+            children.push_back(GetEntity(entityId));
+        }
+    }
+    // No entity is its own ancestor, else the ancestor walk of SetEntityParent never ends.
+    // Each walk stops at an entity an earlier one reached the root from, so every entity is
+    // walked through once.
+    std::vector<int> walkPerEntity(numEntities, -1);
+    for (const auto& link: parentPerEntity)
+    {
+        const int walk = link.first;
+        int entityId = link.first;
+        while (walkPerEntity[entityId] == -1)
+        {
+            walkPerEntity[entityId] = walk;
+            auto parentLink = parentPerEntity.find(entityId);
+            if (parentLink == parentPerEntity.end())
+            {
+                break;
+            }
+            entityId = parentLink->second.parent.GetId();
+        }
+        // Back on an entity of this walk, the chain loops
+        if (walkPerEntity[entityId] == walk && parentPerEntity.count(entityId) > 0)
+        {
+            reader.Fail();
+            break;
+        }
+    }
+    const int numPaired = reader.ReadCount(MAX_ENTITIES);
+    for (int i = 0; i < numPaired && !reader.HasFailed(); i++)
+    {
+        const int entityId = readEntityId();
+        const int pairId = readEntityId();
+        if (reader.HasFailed() || entityId == pairId || !pairPerEntity.emplace(entityId, GetEntity(pairId)).second)
+        {
+            reader.Fail();
+            break;
+        }
+    }
+    // Both entities of a pair point at each other, as PairEntities leaves them
+    for (const auto& pair: pairPerEntity)
+    {
+        auto other = pairPerEntity.find(pair.second.GetId());
+        if (other == pairPerEntity.end() || other->second.GetId() != pair.first)
+        {
+            reader.Fail();
+            break;
+        }
+    }
+    if (reader.HasFailed())
+    {
+        return fail("the relationships are corrupt");
+    }
+
+    for (int entityId = 0; entityId < numEntities; entityId++)
+    {
+        if (entityComponentSignatures[entityId].any())
+        {
+            AddEntityToSystems(GetEntity(entityId));
+        }
+    }
+    return true;
+}
+
+void Registry::SortEntities(const std::vector<uint32_t>& entityKeys)
+{
+    PROFILE_SCOPE("Registry::SortEntities");
+    for (int componentId = 0; componentId < static_cast<int>(componentPools.size()); componentId++)
+    {
+        const auto& pool = componentPools[componentId];
+        if (!pool)
+        {
+            continue;
+        }
+        // The same entities are at the front of every pool of a group, the keys put them in
+        // the same order in each
+        const int groupIndex = owningGroupPerComponent[componentId];
+        const int groupSize = groupIndex != -1 ? owningGroups[groupIndex].size : 0;
+        pool->SortRange(0, groupSize, entityKeys);
+        pool->SortRange(groupSize, pool->GetNumComponents(), entityKeys);
+    }
+    if (storageMode == STORAGE_ARCHETYPE)
+    {
+        archetypeStorage->SortEntities(entityKeys);
+    }
+}
+
+void Registry::Compact()
+{
+    // Drop the free ids at the top of the id range, down to the highest id still in use
+    std::vector<bool> isFree(numEntities, false);
+    for (auto entityId: freeIds)
+    {
+        isFree[entityId] = true;
+    }
+    int newNumEntities = numEntities;
+    while (newNumEntities > 0 && isFree[newNumEntities - 1])
+    {
+        newNumEntities--;
+    }
+    if (newNumEntities == numEntities)
+    {
+        return;
+    }
+    freeIds.erase(std::remove_if(freeIds.begin(), freeIds.end(), [newNumEntities](int entityId) { return entityId >= newNumEntities; }), freeIds.end());
+    numEntities = newNumEntities;
+
+    // The versions are kept, so the handles to the dropped ids stay stale when the ids come back
+    entityComponentSignatures.resize(numEntities);
+    entityComponentSignatures.shrink_to_fit();
+    entitySystemSignatures.resize(numEntities);
+    entitySystemSignatures.shrink_to_fit();
+    entitySystemPlanes.Compact(numEntities);
+    ResizeChangeFlags(numEntities);
+    for (auto& pool: componentPools)
+    {
+        if (pool)
+        {
+            pool->Compact(numEntities);
+        }
+    }
+    if (storageMode == STORAGE_ARCHETYPE)
+    {
+        archetypeStorage->Compact(numEntities);
+    }
+    for (auto* group: {&systems, &queries})
+    {
+        for (auto& system: *group)
+        {
+            system.second->Compact(numEntities);
+        }
+    }
+
+    Logger::Log("Registry compacted to " + std::to_string(numEntities) + " entity ids");
+}
+
+int Registry::GetNumEntities() const
+{
+    return numEntities - freeIds.size();
+}
+
+const Signature& Registry::GetEntitySignature(int entityId) const
+{
+    static const Signature noComponents;
+    return entityId >= 0 && entityId < static_cast<int>(entityComponentSignatures.size()) ? entityComponentSignatures[entityId] : noComponents;
+}
+
+const void* Registry::GetComponentData(int componentId, Entity entity) const
+{
+    const int entityId = entity.GetId();
+    ECS_CHECK(entity.GetRegistryIndex() == registryIndex && entityId < static_cast<int>(entityComponentSignatures.size()), "Entity of another registry or past its entities");
+    ECS_CHECK(IsAlive(entity), "Stale entity handle, its entity was killed");
+    ECS_CHECK(componentId >= 0 && componentId < static_cast<int>(MAX_COMPONENTS) && entityComponentSignatures[entityId].test(componentId), "Entity without the component");
+    if (storageMode == STORAGE_ARCHETYPE)
+    {
+        return archetypeStorage->GetComponentData(entityId, componentId);
+    }
+    ECS_CHECK(componentId < static_cast<int>(componentPools.size()) && componentPools[componentId], "No pool for the component");
+    return componentPools[componentId]->GetData(entityId);
+}
+
+void* Registry::PatchComponentData(int componentId, Entity entity)
+{
+    void* data = const_cast<void*>(GetComponentData(componentId, entity));
+    MarkChanged(componentId, entity.GetId());
+    return data;
+}
+
+// xxHash64, the bytes read as little endian
+static const uint64_t XXHASH_PRIME_1 = 11400714785074694791ull;
+static const uint64_t XXHASH_PRIME_2 = 14029467366897019727ull;
+static const uint64_t XXHASH_PRIME_3 = 1609587929392839161ull;
+static const uint64_t XXHASH_PRIME_4 = 9650029242287828579ull;
+static const uint64_t XXHASH_PRIME_5 = 2870177450012600261ull;
+
+static uint64_t RotateLeft(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static uint64_t ReadUint64(const unsigned char* bytes)
+{
+    uint64_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+static uint32_t ReadUint32(const unsigned char* bytes)
+{
+    uint32_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+static uint64_t XXHashRound(uint64_t accumulator, uint64_t input)
+{
+    accumulator += input * XXHASH_PRIME_2;
+    return RotateLeft(accumulator, 31) * XXHASH_PRIME_1;
+}
+
+static uint64_t XXHashMerge(uint64_t hash, uint64_t accumulator)
+{
+    hash ^= XXHashRound(0, accumulator);
+    return hash * XXHASH_PRIME_1 + XXHASH_PRIME_4;
+}
+
+static uint64_t XXHash64(const void* data, size_t size, uint64_t seed)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    const unsigned char* end = bytes + size;
+    uint64_t hash;
+    if (size >= 32)
+    {
+        // 4 lanes of 8 bytes a stripe
+        uint64_t lanes[4] = {seed + XXHASH_PRIME_1 + XXHASH_PRIME_2, seed + XXHASH_PRIME_2, seed, seed - XXHASH_PRIME_1};
+        for (; bytes + 32 <= end; bytes += 32)
+        {
+            for (int lane = 0; lane < 4; lane++)
+            {
+                lanes[lane] = XXHashRound(lanes[lane], ReadUint64(bytes + lane * 8));
+            }
+        }
+        hash = RotateLeft(lanes[0], 1) + RotateLeft(lanes[1], 7) + RotateLeft(lanes[2], 12) + RotateLeft(lanes[3], 18);
+        for (int lane = 0; lane < 4; lane++)
+        {
+            hash = XXHashMerge(hash, lanes[lane]);
+        }
+    }
+    else
+    {
+        hash = seed + XXHASH_PRIME_5;
+    }
+    hash += size;
+    for (; bytes + 8 <= end; bytes += 8)
+    {
+        hash ^= XXHashRound(0, ReadUint64(bytes));
+        hash = RotateLeft(hash, 27) * XXHASH_PRIME_1 + XXHASH_PRIME_4;
+    }
+    if (bytes + 4 <= end)
+    {
+        hash ^= ReadUint32(bytes) * XXHASH_PRIME_1;
+        hash = RotateLeft(hash, 23) * XXHASH_PRIME_2 + XXHASH_PRIME_3;
+        bytes += 4;
+    }
+    for (; bytes < end; bytes++)
+    {
+        hash ^= *bytes * XXHASH_PRIME_5;
+        hash = RotateLeft(hash, 11) * XXHASH_PRIME_1;
+    }
+    hash ^= hash >> 33;
+    hash *= XXHASH_PRIME_2;
+    hash ^= hash >> 29;
+    hash *= XXHASH_PRIME_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+static void AppendBytes(std::vector<unsigned char>& buffer, const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    buffer.insert(buffer.end(), bytes, bytes + size);
+}
+
+// The bytes of the value only, not what follows the null of a text or the registry of an entity
+static void AppendField(std::vector<unsigned char>& buffer, const FieldInfo& field, const unsigned char* value)
+{
+    switch (field.type)
+    {
+    case FIELD_ASSET_HANDLE:
+        return;
+    case FIELD_BOOL:
+        buffer.push_back(*reinterpret_cast<const bool*>(value) ? 1 : 0);
+        return;
+    case FIELD_TEXT:
+    {
+        const void* end = std::memchr(value, '\0', field.size);
+        AppendBytes(buffer, value, end ? static_cast<const unsigned char*>(end) - value : field.size);
+        // Apart from the field that follows
+        buffer.push_back(0);
+        return;
+    }
+    case FIELD_ENTITY:
+    {
+        const Entity& entity = *reinterpret_cast<const Entity*>(value);
+        const int idAndVersion[2] = {entity.GetId(), entity.GetVersion()};
+        AppendBytes(buffer, idAndVersion, sizeof(idAndVersion));
+        return;
+    }
+    default:
+        AppendBytes(buffer, value, field.size);
+        return;
+    }
+}
+
+uint64_t Registry::ComputeChecksum(JobSystem& jobSystem) const
+{
+    return jobSystem.ParallelReduce(numEntities, CHECKSUM_ENTITIES_PER_GRAIN, static_cast<uint64_t>(0), [this](int begin, int end)
+    {
+        // The state of the chunk laid out in a row, hashed in one go
+        thread_local std::vector<unsigned char> buffer;
+        buffer.clear();
+        for (int entityId = begin; entityId < end; entityId++)
+        {
+            const Signature& signature = entityComponentSignatures[entityId];
+            if (signature.none())
+            {
+                continue;
+            }
+            const Entity entity = GetEntity(entityId);
+            const int idAndVersion[2] = {entityId, entity.GetVersion()};
+            AppendBytes(buffer, idAndVersion, sizeof(idAndVersion));
+            for (int componentId = 0; componentId < static_cast<int>(MAX_COMPONENTS); componentId++)
+            {
+                if (!signature.test(componentId))
+                {
+                    continue;
+                }
+                const ComponentReflection* reflection = GetComponentReflection(componentId);
+                if (reflection && reflection->isRenderOnly)
+                {
+                    continue;
+                }
+                buffer.push_back(static_cast<unsigned char>(componentId));
+                if (!reflection)
+                {
+                    continue;
+                }
+                const unsigned char* component = static_cast<const unsigned char*>(GetComponentData(componentId, entity));
+                if (reflection->isPlainBytes)
+                {
+                    AppendBytes(buffer, component, reflection->size);
+                    continue;
+                }
+                for (const auto& field: reflection->fields)
+                {
+                    AppendField(buffer, field, component + field.offset);
+                }
+            }
+        }
+        return XXHash64(buffer.data(), buffer.size(), static_cast<uint64_t>(begin));
+    },
+    CombineChecksums);
+}
+
+uint64_t CombineChecksums(uint64_t checksum, uint64_t nextChecksum)
+{
+    return (RotateLeft(checksum, 31) * XXHASH_PRIME_1) ^ nextChecksum;
+}
+
+void Registry::GetComponentStats(std::vector<ComponentStats>& stats) const
+{
+    std::vector<ComponentStats> statsById;
+    if (storageMode == STORAGE_ARCHETYPE)
+    {
+        archetypeStorage->AddComponentStats(statsById);
+    }
+    else
+    {
+        for (int componentId = 0; componentId < static_cast<int>(componentPools.size()); componentId++)
+        {
+            if (componentPools[componentId])
+            {
+                const IPool& pool = *componentPools[componentId];
+                statsById.resize(componentId + 1, {0, 0, 0, 0, 0, 0});
+                statsById[componentId] = {componentId, pool.GetNumComponents(), pool.GetMemoryUsage(), pool.GetCapacity(), pool.GetNumEntitySlots(), pool.GetUsedMemory()};
+            }
+        }
+    }
+
+    stats.clear();
+    for (const auto& componentStats: statsById)
+    {
+        if (componentStats.numBytes > 0)
+        {
+            stats.push_back(componentStats);
+        }
+    }
+}
+
+size_t Registry::GetMemoryUsage() const
+{
+    std::vector<ComponentStats> stats;
+    GetComponentStats(stats);
+    size_t numBytes = 0;
+    for (const auto& componentStats: stats)
+    {
+        numBytes += componentStats.numBytes;
+    }
+    numBytes += (entityComponentSignatures.capacity() + entitySystemSignatures.capacity()) * sizeof(Signature);
+    numBytes += entitySystemPlanes.GetMemoryUsage();
+    numBytes += entityVersions.capacity() * sizeof(uint8_t) + freeIds.size() * sizeof(int);
+    return numBytes;
+}
+
+void Registry::AddEntityToSystems(Entity entity)
+{
+    const auto entityId = entity.GetId();
+
+    const auto& entityComponentSignature = entityComponentSignatures[entityId];
+
+    for (auto* group: {&systems, &queries})
+    {
+        for (auto& system: *group)
+        {
+            if (!system.second->IsEnabled())
+            {
+                continue;
+            }
+            bool isInterested = system.second->IsInterestedIn(entityComponentSignature);
+            if(isInterested)
+            {
+                system.second->AddEntityToSystem(entity);
+            }
+        }
+    }
+    entitySystemPlanes.Update(entityId, entitySystemSignatures[entityId], entityComponentSignature);
+    entitySystemSignatures[entityId] = entityComponentSignature;
+}
+
+void Registry::RemoveEntityFromSystems(Entity entity)
+{
+    const auto& entitySystemSignature = entitySystemSignatures[entity.GetId()];
+
+    // Only the systems that matched the entity's signature can hold it
+    for (auto* group: {&systems, &queries})
+    {
+        for (auto& system: *group)
+        {
+            if (system.second->IsEnabled() && system.second->IsInterestedIn(entitySystemSignature))
+            {
+                system.second->RemoveEntityFromSystem(entity);
+            }
+        }
+    }
+    entitySystemPlanes.Update(entity.GetId(), entitySystemSignature, Signature());
+    entitySystemSignatures[entity.GetId()].reset();
+}
+
+void Registry::UpdateEntitySystems(Entity entity)
+{
+    const auto entityId = entity.GetId();
+    const auto& oldSignature = entitySystemSignatures[entityId];
+    const auto& newSignature = entityComponentSignatures[entityId];
+    if (oldSignature == newSignature)
+    {
+        return;
+    }
+
+    for (auto* group: {&systems, &queries})
+    {
+        for (auto& system: *group)
+        {
+            if (!system.second->IsEnabled())
+            {
+                continue;
+            }
+            const bool wasInterested = system.second->IsInterestedIn(oldSignature);
+            const bool isInterested = system.second->IsInterestedIn(newSignature);
+            if (isInterested && !wasInterested)
+            {
+                system.second->AddEntityToSystem(entity);
+            }
+            else if (wasInterested && !isInterested)
+            {
+                system.second->RemoveEntityFromSystem(entity);
+            }
+        }
+    }
+    entitySystemPlanes.Update(entityId, oldSignature, newSignature);
+    entitySystemSignatures[entityId] = newSignature;
+}
+
+void Registry::AddOwningGroup(const Signature& signature)
+{
+    OwningGroup group;
+    group.signature = signature;
+    group.size = 0;
+    for (int componentId = 0; componentId < static_cast<int>(MAX_COMPONENTS); componentId++)
+    {
+        if (!signature.test(componentId))
+        {
+            continue;
+        }
+        if (owningGroupPerComponent[componentId] != -1)
+        {
+            Logger::Err(std::string("The components of ") + GetComponentName(componentId) + " are already owned by a group");
+            return;
+        }
+        group.componentIds.push_back(componentId);
+    }
+    for (auto componentId: group.componentIds)
+    {
+        owningGroupPerComponent[componentId] = owningGroups.size();
+    }
+    owningGroups.push_back(std::move(group));
+    BuildOwningGroup(owningGroups.back());
+}
+
+void Registry::BuildOwningGroup(OwningGroup& group)
+{
+    group.size = 0;
+    // The components already there join in the order of their first pool
+    const std::vector<int> entityIds = componentPools[group.componentIds[0]]->GetEntityIds();
+    for (auto entityId: entityIds)
+    {
+        JoinOwningGroup(entityId, group.componentIds[0]);
+    }
+}
+
+void Registry::JoinOwningGroup(int entityId, int componentId)
+{
+    auto& group = owningGroups[owningGroupPerComponent[componentId]];
+    for (auto groupComponentId: group.componentIds)
+    {
+        if (componentPools[groupComponentId]->GetIndex(entityId) == -1)
+        {
+            return;
+        }
+    }
+    // Already packed, e.g. a component it had was set again
+    if (componentPools[group.componentIds[0]]->GetIndex(entityId) < group.size)
+    {
+        return;
+    }
+    for (auto groupComponentId: group.componentIds)
+    {
+        IPool& pool = *componentPools[groupComponentId];
+        pool.Swap(pool.GetIndex(entityId), group.size);
+    }
+    group.size++;
+}
+
+void Registry::LeaveOwningGroup(int entityId, int componentId)
+{
+    if (owningGroupPerComponent[componentId] == -1)
+    {
+        return;
+    }
+    auto& group = owningGroups[owningGroupPerComponent[componentId]];
+    const int index = componentPools[group.componentIds[0]]->GetIndex(entityId);
+    if (index == -1 || index >= group.size)
+    {
+        return;
+    }
+    // The last entity of the group takes its place, the entity is left right past the group
+    group.size--;
+    for (auto groupComponentId: group.componentIds)
+    {
+        IPool& pool = *componentPools[groupComponentId];
+        pool.Swap(pool.GetIndex(entityId), group.size);
+    }
+}
+
+void Registry::SetSystemEnabled(System& system, bool isEnabled)
+{
+    if (system.isEnabled == isEnabled)
+    {
+        return;
+    }
+    system.isEnabled = isEnabled;
+    if (!isEnabled)
+    {
+        while (!system.entities.empty())
+        {
+            system.RemoveEntityFromSystem(system.entities.back());
+        }
+        return;
+    }
+    // Matched as the other systems last saw the entities, the pending ones join on the next Update()
+    entitySystemPlanes.Each(system.GetComponentSignature(), system.GetExcludedSignature(), [this, &system](int entityId)
+    {
+        system.AddEntityToSystem(GetEntity(entityId));
+    });
+}
+
+void Registry::ObserveComponent(int componentId, ComponentObserver onAdded, ComponentObserver onRemoved)
+{
+    if (componentId >= static_cast<int>(componentObservers.size()))
+    {
+        componentObservers.resize(componentId + 1);
+    }
+    if (!componentObservers[componentId])
+    {
+        componentObservers[componentId] = std::make_unique<ComponentObservers>();
+    }
+    if (onAdded)
+    {
+        componentObservers[componentId]->onAdded.push_back(std::move(onAdded));
+    }
+    if (onRemoved)
+    {
+        componentObservers[componentId]->onRemoved.push_back(std::move(onRemoved));
+    }
+    observedComponents.set(componentId);
+}
+
+void Registry::GatherObservedChanges(Entity entity, const Signature& oldSignature, const Signature& newSignature)
+{
+    const Signature changed = (oldSignature ^ newSignature) & observedComponents;
+    if (changed.none())
+    {
+        return;
+    }
+    for (int componentId = 0; componentId < static_cast<int>(componentObservers.size()); componentId++)
+    {
+        if (!changed.test(componentId))
+        {
+            continue;
+        }
+        auto& observers = *componentObservers[componentId];
+        if (newSignature.test(componentId))
+        {
+            observers.addedEntities.push_back(entity);
+        }
+        else
+        {
+            observers.removedEntities.push_back(entity);
+        }
+    }
+}
+
+// The additions of every type first, an entity created and killed in the same update is
+// added before it is removed
+void Registry::NotifyObservers()
+{
+    if (observedComponents.none())
+    {
+        return;
+    }
+    for (auto& observers: componentObservers)
+    {
+        if (observers && !observers->addedEntities.empty())
+        {
+            for (auto& onAdded: observers->onAdded)
+            {
+                onAdded(observers->addedEntities);
+            }
+            observers->addedEntities.clear();
+        }
+    }
+    for (auto& observers: componentObservers)
+    {
+        if (observers && !observers->removedEntities.empty())
+        {
+            for (auto& onRemoved: observers->onRemoved)
+            {
+                onRemoved(observers->removedEntities);
+            }
+            observers->removedEntities.clear();
+        }
+    }
+}
+
+void Registry::Update()
+{
+    // The changes recorded on the other threads join the ones made here, in thread order
+    // unless they are played back in order
+    if (isThreadPlaybackOrdered)
+    {
+        ThreadCommandBuffer::PlaybackInOrder(*this, threadCommandBuffers);
+    }
+    for (auto& threadCommands: threadCommandBuffers)
+    {
+        if (!threadCommands.IsEmpty())
+        {
+            threadCommands.Playback(*this);
+        }
+    }
+
+    CommitChanges();
+
+    // Swap the buffers so the commands recorded from now on go into an empty one
+    std::swap(commandBuffer, processingCommandBuffer);
+    auto& commands = processingCommandBuffer;
+    commands.SortAndDeduplicate();
+
+    // Processing the entities that are waiting to be created to the active Systems
+    for (auto entityId: commands.createdEntityIds)
+    {
+        AddEntityToSystems(GetEntity(entityId));
+        GatherObservedChanges(GetEntity(entityId), Signature(), entityComponentSignatures[entityId]);
+        EventTrace::RecordEntityCreated(GetEntity(entityId).GetHandle());
+    }
+
+    // Processing the entities that gained or lost components since the last update
+    int previousEntityId = -1;
+    auto updateEntitySystems = [&](const ComponentCommand& command)
+    {
+        if (command.entityId != previousEntityId)
+        {
+            const Signature oldSignature = entitySystemSignatures[command.entityId];
+            UpdateEntitySystems(GetEntity(command.entityId));
+            GatherObservedChanges(GetEntity(command.entityId), oldSignature, entityComponentSignatures[command.entityId]);
+            previousEntityId = command.entityId;
+        }
+    };
+    for (const auto& command: commands.addedComponents)
+    {
+        updateEntitySystems(command);
+    }
+    previousEntityId = -1;
+    for (const auto& command: commands.removedComponents)
+    {
+        updateEntitySystems(command);
+    }
+
+    // The children killed with their parent die in this update too, and theirs in turn
+    const size_t numKilledByCommand = commands.killedEntityIds.size();
+    for (size_t i = 0; i < commands.killedEntityIds.size(); i++)
+    {
+        auto children = childrenPerEntity.find(commands.killedEntityIds[i]);
+        if (children == childrenPerEntity.end())
+        {
+            continue;
+        }
+        for (auto child: children->second)
+        {
+            if (parentPerEntity.find(child.GetId())->second.policy == ORPHAN_KILLED)
+            {
+                commands.killedEntityIds.push_back(child.GetId());
+            }
+        }
+    }
+    if (commands.killedEntityIds.size() > numKilledByCommand)
+    {
+        std::sort(commands.killedEntityIds.begin(), commands.killedEntityIds.end());
+        commands.killedEntityIds.erase(std::unique(commands.killedEntityIds.begin(), commands.killedEntityIds.end()), commands.killedEntityIds.end());
+    }
+
+    // The killed entities lose all their components, the observers are told while they
+    // still hold them
+    for (auto entityId: commands.killedEntityIds)
+    {
+        GatherObservedChanges(GetEntity(entityId), entitySystemSignatures[entityId], Signature());
+    }
+    NotifyObservers();
+
+    // Drop the data of removed components, unless the component was added back in the meantime
+    for (const auto& command: commands.removedComponents)
+    {
+        if (entityComponentSignatures[command.entityId].test(command.componentId))
+        {
+            continue;
+        }
+        if (storageMode == STORAGE_ARCHETYPE)
+        {
+            archetypeStorage->RemoveComponent(command.entityId, command.componentId);
+        }
+        else if (command.componentId < static_cast<int>(componentPools.size()) && componentPools[command.componentId])
+        {
+            LeaveOwningGroup(command.entityId, command.componentId);
+            componentPools[command.componentId]->RemoveEntityFromPool(command.entityId);
+        }
+    }
+
+    // Processing the entities that are waiting to be killed from the active Systems
+    for (auto entityId: commands.killedEntityIds)
+    {
+        EventTrace::RecordEntityKilled(GetEntity(entityId).GetHandle());
+        RemoveEntityFromSystems(GetEntity(entityId));
+        RemoveEntityTag(GetEntity(entityId));
+        RemoveEntityGroup(GetEntity(entityId));
+        RemoveEntityRelationships(GetEntity(entityId));
+
+        // Remove the entity from the component pools, only the ones of its signature hold it:
+        // a batch of kills costs the components of the entities, not all the pools each
+        if (storageMode == STORAGE_ARCHETYPE)
+        {
+            archetypeStorage->RemoveEntity(entityId);
+        }
+        else
+        {
+            const Signature& signature = entityComponentSignatures[entityId];
+            for (size_t componentId = 0; componentId < componentPools.size(); componentId++)
+            {
+                if (signature.test(componentId) && componentPools[componentId])
+                {
+                    LeaveOwningGroup(entityId, componentId);
+                    componentPools[componentId]->RemoveEntityFromPool(entityId);
+                }
+            }
+        }
+        entityComponentSignatures[entityId].reset();
+
+        // Bump the version so the handles to the killed entity become stale,
+        // then make the entity id available to be reused
+        entityVersions[entityId]++;
+        freeIds.push_back(entityId);
+    }
+
+    commands.Clear();
 }
@@ -2,349 +2,2250 @@
 #define ECS_H
 
 #include "../Logger/Logger.h"
+#include "Component.h"
+#include "Resource.h"
+#include "Reflection.h"
+#include "../Jobs/JobSystem.h"
+#include "../EventBus/EventOrder.h"
+#include "../Profiler/Profiler.h"
+#include "../Memory/BlockAllocator.h"
+#include "../Snapshot/SnapshotStream.h"
 #include <vector>
-#include <bitset>
-#include <set>
 #include <deque>
+#include <algorithm>
 #include <unordered_map>
 #include <typeindex>
 #include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <atomic>
+#include <functional>
+#include <array>
+#include <cstdint>
+#include <string>
 
-const unsigned int MAX_COMPONENTS = 32;
+// The debug build (-DENABLE_ECS_CHECKS, make's debug config) checks the handles, signatures
+// and indices the registry is given and aborts on the first one that is wrong, before it reads
+// a component the entity doesn't have or a pool that doesn't exist. Without it the checks and
+// their conditions are compiled out, the hot paths stay as they are.
+#ifdef ENABLE_ECS_CHECKS
+[[noreturn]] void FailEcsCheck(const char* condition, const char* message, const char* file, int line);
+#define ECS_CHECK(condition, message) ((condition) ? static_cast<void>(0) : FailEcsCheck(#condition, message, __FILE__, __LINE__))
+#else
+#define ECS_CHECK(condition, message) static_cast<void>(0)
+#endif
 
 /////////////////////////////////////////////////////////////////////////////////////////////
-// Signature
+// Entity
 /////////////////////////////////////////////////////////////////////////////////////////////
-// We use a bitset (1s and 0s) to keep track of which components an entity has,
-// and also helps keep track of which entities a system is interested in.
+// An entity is a 32-bit generational handle that packs the entity id (the index into the
+// pools and signatures), a version that is bumped every time the id is recycled, and the
+// slot of the registry that owns it. A stale handle keeps its old version, so
+// Registry::IsAlive() can tell it apart from the entity that reused its id.
 /////////////////////////////////////////////////////////////////////////////////////////////
-typedef std::bitset<MAX_COMPONENTS> Signature;
-
-struct IComponent
-{
-protected:
-    static int nextId;
-};
-
-// Used to assign a unique id to a component type
-template <typename TComponent>
-class Component : public IComponent
-{
-public:
-    // Returns the unique id of Component<T>
-    static int GetId()
-    {
-        static auto id = nextId++;
-        return id;
-    }
-};
+const unsigned int ENTITY_ID_BITS = 20;
+const unsigned int ENTITY_VERSION_BITS = 8;
+const unsigned int ENTITY_REGISTRY_BITS = 4;
+const unsigned int MAX_ENTITIES = 1 << ENTITY_ID_BITS;
+const unsigned int MAX_ENTITY_VERSIONS = 1 << ENTITY_VERSION_BITS;
+const unsigned int MAX_REGISTRIES = 1 << ENTITY_REGISTRY_BITS;
+// Killed ids wait in the free list until it holds more than this, so an id comes back at most
+// once every that many kills and its 8 bit version takes 256 times as many to wrap around
+const int MIN_FREE_ENTITY_IDS = 1024;
 
 class Entity
 {
 private:
-    int id;
+    uint32_t handle;
 
 public:
-    Entity(int id) : id(id){};
+    Entity(int id, int version, int registryIndex)
+        : handle(static_cast<uint32_t>(id) | (static_cast<uint32_t>(version) << ENTITY_ID_BITS) | (static_cast<uint32_t>(registryIndex) << (ENTITY_ID_BITS + ENTITY_VERSION_BITS))) {};
     Entity(const Entity &entity) = default;
     void Kill();
-    int GetId() const;
+    int GetId() const { return handle & (MAX_ENTITIES - 1); }
+    int GetVersion() const { return (handle >> ENTITY_ID_BITS) & (MAX_ENTITY_VERSIONS - 1); }
+    int GetRegistryIndex() const { return handle >> (ENTITY_ID_BITS + ENTITY_VERSION_BITS); }
+    uint32_t GetHandle() const { return handle; }
+
+    // Returns the entity's owner registry
+    class Registry* GetRegistry() const;
 
     Entity &operator=(const Entity &other) = default;
-    bool operator==(const Entity &other) const { return id == other.id; }
-    bool operator!=(const Entity &other) const { return id != other.id; }
-    bool operator>(const Entity &other) const { return id > other.id; }
-    bool operator<(const Entity &other) const { return id < other.id; }
+    bool operator==(const Entity &other) const { return handle == other.handle; }
+    bool operator!=(const Entity &other) const { return handle != other.handle; }
+    bool operator>(const Entity &other) const { return handle > other.handle; }
+    bool operator<(const Entity &other) const { return handle < other.handle; }
 
     template <typename TComponent, typename ...TArgs> void AddComponent(TArgs&& ...args);
     template <typename TComponent> void RemoveComponent();
     template <typename TComponent> bool HasComponent() const;
     template <typename TComponent> TComponent& GetComponent() const;
+    template <typename TComponent> TComponent& PatchComponent() const;
 
-    // Hold a pointer to the entity's owner registry
-    class Registry* registry;
+    // Tags and groups, see Registry
+    void Tag(const std::string& tag);
+    bool HasTag(const std::string& tag) const;
+    void Group(const std::string& group);
+    bool BelongsToGroup(const std::string& group) const;
 };
 
+static_assert(sizeof(Entity) == 4, "Entity handles must stay 32-bit");
+
+template <> struct FieldTypeOf<Entity> { static constexpr FieldType type = FIELD_ENTITY; };
+
 /////////////////////////////////////////////////////////////////////////////////////////////
 // System
 /////////////////////////////////////////////////////////////////////////////////////////////
 // The system processes entities that contain a specific signature
 /////////////////////////////////////////////////////////////////////////////////////////////
+// Below this many entities the cost of waking the workers outweighs the parallel speedup
+const int PARALLEL_EACH_MIN_ENTITIES = 10000;
+// Entity ids each chunk of Registry::ComputeChecksum hashes
+const int CHECKSUM_ENTITIES_PER_GRAIN = 1024;
+
 class System
 {
 private:
     Signature componentSignature;
+    // Entities with any of these components are left out, even when they match
+    Signature excludedSignature;
     std::vector<Entity> entities;
 
+    // Components the system reads and writes, used by the scheduler to find the systems
+    // that can run in parallel. Systems that don't declare their access run exclusively.
+    Signature readSignature;
+    Signature writeSignature;
+    ResourceSignature resourceReadSignature;
+    ResourceSignature resourceWriteSignature;
+    bool hasDeclaredAccess = false;
+    bool isExclusive = false;
+    bool recordsCommands = false;
+    // A disabled system holds no entities and isn't run by the scheduler, see Registry::SetSystemEnabled
+    bool isEnabled = true;
+
+    friend class Registry;
+
+    // [entity id] -> index of the entity in the entities vector, or -1 if it isn't in the system
+    std::vector<int> entityIdToIndex;
+
 public:
     System() = default;
-    ~System() = default;
+    virtual ~System() = default;
 
     void AddEntityToSystem(Entity entity);
     void RemoveEntityFromSystem(Entity entity);
-    std::vector<Entity> GetSystemEntities() const;
+    bool HasEntity(Entity entity) const;
+    void Compact(int numEntities);
+    const std::vector<Entity>& GetSystemEntities() const;
     const Signature &GetComponentSignature() const;
+    const Signature& GetExcludedSignature() const { return excludedSignature; }
+    // Whether an entity with the signature belongs in the system
+    bool IsInterestedIn(const Signature& entitySignature) const;
+
+    const Signature& GetReadSignature() const { return readSignature; }
+    const Signature& GetWriteSignature() const { return writeSignature; }
+    const ResourceSignature& GetResourceReadSignature() const { return resourceReadSignature; }
+    const ResourceSignature& GetResourceWriteSignature() const { return resourceWriteSignature; }
+    bool IsExclusive() const { return isExclusive || !hasDeclaredAccess; }
+    bool IsRecordingCommands() const { return recordsCommands; }
+    bool IsEnabled() const { return isEnabled; }
 
     // Defines the component type that entities must have to be considered by the system
     template <typename TComponent> void RequireComponent();
+    // Defines a component type that leaves the entities having it out of the system
+    template <typename TComponent> void ExcludeComponent();
+
+    // Calls func(entity) for every system entity, split across the job system workers once
+    // there are at least minParallelEntities of them. func must only touch its own entity,
+    // its structural changes go through Registry::GetThreadCommands. The events and commands
+    // it queues are ordered by entity, under the order of the system.
+    template <typename TFunc>
+    void ParallelEach(JobSystem& jobSystem, TFunc func, int grainSize = DEFAULT_GRAIN_SIZE, int minParallelEntities = PARALLEL_EACH_MIN_ENTITIES) const;
+
+    // Declare how the system accesses the components, on top of the required ones
+    template <typename TComponent> void ReadsComponent();
+    template <typename TComponent> void WritesComponent();
+    // The same for the resources of the registry
+    template <typename TResource> void ReadsResource();
+    template <typename TResource> void WritesResource();
+
+    // The system must not run alongside any other system (e.g. it adds components or emits events)
+    void RunsExclusively() { hasDeclaredAccess = true; isExclusive = true; }
+
+    // The system kills entities or removes components, which only records into the registry command buffer.
+    // The changes recorded through Registry::GetThreadCommands are per thread, they need no declaring.
+    void RecordsCommands() { recordsCommands = true; }
+
+    // Called when an entity starts or stops matching the system signature, during Registry::Update
+    virtual void OnEntityAdded(Entity entity) {}
+    virtual void OnEntityRemoved(Entity entity) {}
 };
 
+// Points the asset and entity fields of a component loaded from a snapshot at the handles
+// of this process and registry
+void RemapComponentHandles(const ComponentReflection& reflection, void* component, const SnapshotRemap& remap);
+
+// Folds a checksum into the one of what came before it, the order matters unlike a xor
+uint64_t CombineChecksums(uint64_t checksum, uint64_t nextChecksum);
+
 /////////////////////////////////////////////////////////////////////////////////////////////
 // Pool
 /////////////////////////////////////////////////////////////////////////////////////////////
-// A pool is just a vector (contiguous data) of objects of type T
+// A pool is a sparse set of objects of type T: the components are packed in dense pages of
+// a fixed size, and a sparse vector maps each entity id to its dense index. A full pool
+// allocates one more page instead of moving every component, so a component stays where it
+// is until it is removed or the last one is swapped into its place.
 /////////////////////////////////////////////////////////////////////////////////////////////
 class IPool
 {
+protected:
+    // [dense index] -> entity id that owns the component
+    std::vector<int> indexToEntityId;
+
 public:
     virtual ~IPool() {}
+    virtual void RemoveEntityFromPool(int entityId) = 0;
+    // Destroys every component, the memory is kept for the next ones
+    virtual void Clear() = 0;
+
+    // Releases the memory for entity ids at or above numEntities, none of which may still have a component
+    virtual void Compact(int numEntities) = 0;
+
+    virtual int GetNumComponents() const = 0;
+    // Components the dense data has room for
+    virtual int GetCapacity() const = 0;
+    // Entity ids the sparse array has a slot for, with or without a component
+    virtual int GetNumEntitySlots() const = 0;
+    // Bytes allocated by the pool, including the capacity not used yet
+    virtual size_t GetMemoryUsage() const = 0;
+    // Bytes the live components need, their data and their two indices
+    virtual size_t GetUsedMemory() const = 0;
+    // The component of the entity as bytes, see ECS/Reflection.h
+    virtual void* GetData(int entityId) = 0;
+    // Dense index of the component of the entity, -1 if it has none
+    virtual int GetIndex(int entityId) const = 0;
+    // Swaps two components in the dense data, see Registry::AddOwningGroup
+    virtual void Swap(int indexA, int indexB) = 0;
+    // Reorders the dense data in [begin, end) by the keys of the entities, see Registry::SortEntities
+    virtual void SortRange(int begin, int end, const std::vector<uint32_t>& entityKeys) = 0;
+
+    // The entity ids as varints and the dense data as it is. Reading replaces every component.
+    // Given [entity id] -> visible, only the components of the visible entities are written.
+    virtual void WriteSnapshot(SnapshotWriter& writer, const std::vector<bool>* isEntityVisible = nullptr) const = 0;
+    virtual bool ReadSnapshot(SnapshotReader& reader, const SnapshotRemap& remap) = 0;
+
+    // Entity ids of the live components, in dense order
+    const std::vector<int>& GetEntityIds() const
+    {
+        return indexToEntityId;
+    }
 };
 
+// By their key in entityKeys ([entity id] -> key), then by id, the ids past the keys last
+inline bool IsEntityKeyBefore(const std::vector<uint32_t>& entityKeys, int entityIdA, int entityIdB)
+{
+    const uint32_t keyA = entityIdA < static_cast<int>(entityKeys.size()) ? entityKeys[entityIdA] : UINT32_MAX;
+    const uint32_t keyB = entityIdB < static_cast<int>(entityKeys.size()) ? entityKeys[entityIdB] : UINT32_MAX;
+    return keyA != keyB ? keyA < keyB : entityIdA < entityIdB;
+}
+
+// Components a new pool has room for before it grows, see Registry::SetPoolReserve
+const int POOL_DEFAULT_RESERVE = 100;
+// The most bytes of components a page of a pool holds, at least one component
+const size_t POOL_PAGE_BYTES = 16 * 1024;
+
 template <typename T>
 class Pool : public IPool
 {
 private:
-    std::vector<T> data;
+    // A page holds a power of 2 of components, a dense index is split into its page and its
+    // slot with a shift and a mask
+    static constexpr int GetPageShift()
+    {
+        int shift = 0;
+        while ((sizeof(T) << (shift + 1)) <= POOL_PAGE_BYTES)
+        {
+            shift++;
+        }
+        return shift;
+    }
+    static constexpr int PAGE_SHIFT = GetPageShift();
+    static constexpr int PAGE_CAPACITY = 1 << PAGE_SHIFT;
+    static constexpr int PAGE_MASK = PAGE_CAPACITY - 1;
+
+    struct alignas(alignof(T)) Page
+    {
+        unsigned char bytes[PAGE_CAPACITY * sizeof(T)];
+    };
+
+    // Dense data, the components alive are the first numComponents slots
+    std::vector<std::unique_ptr<Page>> pages;
+    int numComponents = 0;
+
+    // [entity id] -> dense index of its component, or -1 if the entity has none
+    std::vector<int> entityIdToIndex;
+
+    T* GetSlot(int index) const
+    {
+        ECS_CHECK(index >= 0 && (index >> PAGE_SHIFT) < static_cast<int>(pages.size()), "Component index past the pages of the pool");
+        return reinterpret_cast<T*>(pages[index >> PAGE_SHIFT]->bytes) + (index & PAGE_MASK);
+    }
 
 public:
-    Pool(int size = 100)
+    Pool(int capacity = POOL_DEFAULT_RESERVE)
+    {
+        Reserve(capacity);
+    }
+    virtual ~Pool()
     {
-        data.reserve(size);
+        Clear();
     }
-    virtual ~Pool() = default;
 
     bool isEmpty() const
     {
-        return data.empty();
+        return numComponents == 0;
     }
 
     int GetSize() const
     {
-        return data.size();
+        return numComponents;
     }
 
-    void Resize(int n)
+    void Clear() override
     {
-        data.resize(n);
+        for (int index = 0; index < numComponents; index++)
+        {
+            GetSlot(index)->~T();
+        }
+        numComponents = 0;
+        indexToEntityId.clear();
+        entityIdToIndex.clear();
     }
 
-    void Clear()
+    bool Contains(int entityId) const
     {
-        data.clear();
+        return entityId < static_cast<int>(entityIdToIndex.size()) && entityIdToIndex[entityId] != -1;
     }
 
-    void Add(T object)
+    // Allocates the pages for the given number of components
+    void Reserve(int capacity)
     {
-        data.push_back(object);
+        while (static_cast<int>(pages.size()) * PAGE_CAPACITY < capacity)
+        {
+            pages.push_back(std::make_unique<Page>());
+        }
+        indexToEntityId.reserve(capacity);
     }
 
-    void Set(int index, T object)
+    // Constructs the component in place for the entity, or overwrites it if the entity already has one
+    template <typename ...TArgs>
+    T& Emplace(int entityId, TArgs&& ...args)
     {
-        data[index] = object;
+        if (Contains(entityId))
+        {
+            T& component = *GetSlot(entityIdToIndex[entityId]);
+            component = T(std::forward<TArgs>(args)...);
+            return component;
+        }
+        if (entityId >= static_cast<int>(entityIdToIndex.size()))
+        {
+            // Grow the sparse array geometrically so ids handed out one by one don't reallocate every time
+            const int newSize = std::max(entityId + 1, static_cast<int>(entityIdToIndex.size()) * 2);
+            entityIdToIndex.resize(newSize, -1);
+        }
+        if (numComponents == GetCapacity())
+        {
+            // The page allocations show up in the profiler captures
+            PROFILE_SCOPE("Pool growth");
+            pages.push_back(std::make_unique<Page>());
+        }
+        T* component = new (GetSlot(numComponents)) T(std::forward<TArgs>(args)...);
+        entityIdToIndex[entityId] = numComponents;
+        indexToEntityId.push_back(entityId);
+        numComponents++;
+        return *component;
     }
 
-    T &Get(int index)
+    // Adds the component to the entity, or overwrites it if the entity already has one
+    void Set(int entityId, const T& object)
     {
-        return static_cast<T &>(data[index]);
+        Emplace(entityId, object);
     }
 
-    T &operator[](unsigned int index)
+    // Adds a copy of the object to every entity, none of which may have the component yet.
+    // The sparse array grows once and the pages they need are allocated together.
+    void Fill(const std::vector<int>& entityIds, const T& object)
     {
-        return data[index];
+        if (entityIds.empty())
+        {
+            return;
+        }
+        const int maxEntityId = *std::max_element(entityIds.begin(), entityIds.end());
+        if (maxEntityId >= static_cast<int>(entityIdToIndex.size()))
+        {
+            const int newSize = std::max(maxEntityId + 1, static_cast<int>(entityIdToIndex.size()) * 2);
+            entityIdToIndex.resize(newSize, -1);
+        }
+        if (numComponents + static_cast<int>(entityIds.size()) > GetCapacity())
+        {
+            PROFILE_SCOPE("Pool growth");
+            Reserve(numComponents + entityIds.size());
+        }
+        indexToEntityId.insert(indexToEntityId.end(), entityIds.begin(), entityIds.end());
+        for (auto entityId: entityIds)
+        {
+            new (GetSlot(numComponents)) T(object);
+            entityIdToIndex[entityId] = numComponents;
+            numComponents++;
+        }
     }
-};
-
-/////////////////////////////////////////////////////////////////////////////////////////////
-// Registry
-/////////////////////////////////////////////////////////////////////////////////////////////
-// The Registry manages the creation and destruction of entities, as well as
-// adding systems and adding components to entities.
-/////////////////////////////////////////////////////////////////////////////////////////////
-class Registry
-{
-private:
-    // Keep track of how many entities were added to the scene
-    int numEntities = 0;
 
-    // Vector of component pools.
-    // each pool contains all the data for a certain component type
-    // [vector index = componentId], [pool index = entityId]
-    std::vector<std::shared_ptr<IPool>> componentPools;
+    // Copies objects[i] to entities[i], overwriting the component of an entity that has one.
+    // The sparse array grows once and the pages the new ones need are allocated together.
+    void Insert(const Entity* entities, const T* objects, int count)
+    {
+        if (count <= 0)
+        {
+            return;
+        }
+        int maxEntityId = 0;
+        for (int i = 0; i < count; i++)
+        {
+            maxEntityId = std::max(maxEntityId, entities[i].GetId());
+        }
+        if (maxEntityId >= static_cast<int>(entityIdToIndex.size()))
+        {
+            const int newSize = std::max(maxEntityId + 1, static_cast<int>(entityIdToIndex.size()) * 2);
+            entityIdToIndex.resize(newSize, -1);
+        }
+        if (numComponents + count > GetCapacity())
+        {
+            PROFILE_SCOPE("Pool growth");
+            Reserve(numComponents + count);
+        }
+        for (int i = 0; i < count; i++)
+        {
+            const int entityId = entities[i].GetId();
+            const int index = entityIdToIndex[entityId];
+            if (index != -1)
+            {
+                *GetSlot(index) = objects[i];
+                continue;
+            }
+            new (GetSlot(numComponents)) T(objects[i]);
+            entityIdToIndex[entityId] = numComponents;
+            indexToEntityId.push_back(entityId);
+            numComponents++;
+        }
+    }
 
-    // Vector of component signatures.
-    // The signature lets us know which components are turned "on" for an entity
-    // [vector index = entity id]
-    std::vector<Signature> entityComponentSignatures;
+    // Swap the removed component with the last one to keep the dense data packed
+    void Remove(int entityId)
+    {
+        const int indexOfRemoved = entityIdToIndex[entityId];
+        const int indexOfLast = numComponents - 1;
+        if (indexOfRemoved != indexOfLast)
+        {
+            const int entityIdOfLast = indexToEntityId[indexOfLast];
+            *GetSlot(indexOfRemoved) = std::move(*GetSlot(indexOfLast));
+            indexToEntityId[indexOfRemoved] = entityIdOfLast;
+            entityIdToIndex[entityIdOfLast] = indexOfRemoved;
+        }
+        GetSlot(indexOfLast)->~T();
+        numComponents--;
+        indexToEntityId.pop_back();
+        entityIdToIndex[entityId] = -1;
+    }
 
-    // Map of active systems [index = system typeid]
-    std::unordered_map<std::type_index, std::shared_ptr<System>> systems;
+    void RemoveEntityFromPool(int entityId) override
+    {
+        if (Contains(entityId))
+        {
+            Remove(entityId);
+        }
+    }
 
-    std::set<Entity> entitiesToBeAdded; // Entities awaiting creation in the next Registry Update()
-    std::set<Entity> entitiesToBeKilled; // Entities awaiting destruction in the next Registry Update()
+    void Compact(int numEntities) override
+    {
+        if (numEntities < static_cast<int>(entityIdToIndex.size()))
+        {
+            entityIdToIndex.resize(numEntities);
+            entityIdToIndex.shrink_to_fit();
+        }
+        // The pages past the last component are empty
+        pages.resize((numComponents + PAGE_MASK) >> PAGE_SHIFT);
+        pages.shrink_to_fit();
+        indexToEntityId.shrink_to_fit();
+    }
 
-    // List of free entity ids that were previously removec
-    std::deque<int> freeIds;
+    int GetNumComponents() const override
+    {
+        return numComponents;
+    }
 
-public:
-    Registry()
+    int GetCapacity() const override
     {
-        Logger::Log("Registry constructor called!");
+        return pages.size() * PAGE_CAPACITY;
     }
 
-    ~Registry()
+    int GetNumEntitySlots() const override
     {
-        Logger::Log("Registry destructor called!");
+        return entityIdToIndex.size();
     }
 
-    void Update();
+    size_t GetMemoryUsage() const override
+    {
+        return pages.size() * sizeof(Page) + (indexToEntityId.capacity() + entityIdToIndex.capacity()) * sizeof(int);
+    }
 
-    // Entity management
-    Entity CreateEntity();
-    void KillEntity(Entity entity);
+    size_t GetUsedMemory() const override
+    {
+        return numComponents * (sizeof(T) + 2 * sizeof(int));
+    }
 
-    // Component management
-    template <typename TComponent, typename ...TArgs> void AddComponent(Entity entity, TArgs&& ...args);
-    template <typename TComponent> void RemoveComponent(Entity entity);
-    template <typename TComponent> bool HasComponent(Entity entity) const;
-    template <typename TComponent> TComponent& GetComponent(Entity entity) const;
+    void* GetData(int entityId) override
+    {
+        return &Get(entityId);
+    }
 
-    // System management
-    template <typename TSystem, typename ...TArgs> void AddSystem(TArgs&& ...args);
-    template <typename TSystem> void RemoveSystem();
-    template <typename TSystem> bool HasSystem() const;
-    template <typename TSystem> TSystem& GetSystem() const;
+    int GetIndex(int entityId) const override
+    {
+        return Contains(entityId) ? entityIdToIndex[entityId] : -1;
+    }
 
-    // Checks the component signature of an entity and add the entity to the systems
-    // that are interested in it
-    void AddEntityToSystems(Entity entity);
-    void RemoveEntityFromSystems(Entity entity);
-};
+    void Swap(int indexA, int indexB) override
+    {
+        if (indexA == indexB)
+        {
+            return;
+        }
+        std::swap(*GetSlot(indexA), *GetSlot(indexB));
+        std::swap(indexToEntityId[indexA], indexToEntityId[indexB]);
+        entityIdToIndex[indexToEntityId[indexA]] = indexA;
+        entityIdToIndex[indexToEntityId[indexB]] = indexB;
+    }
 
-template <typename TComponent>
-void System::RequireComponent()
-{
-    const auto compontentId = Component<TComponent>::GetId();
-    componentSignature.set(compontentId);
-}
+    void SortRange(int begin, int end, const std::vector<uint32_t>& entityKeys) override
+    {
+        end = std::min(end, numComponents);
+        auto isBefore = [&entityKeys](int entityIdA, int entityIdB) { return IsEntityKeyBefore(entityKeys, entityIdA, entityIdB); };
+        if (end - begin < 2 || std::is_sorted(indexToEntityId.begin() + begin, indexToEntityId.begin() + end, isBefore))
+        {
+            return;
+        }
+        std::vector<int> sortedIds(indexToEntityId.begin() + begin, indexToEntityId.begin() + end);
+        std::sort(sortedIds.begin(), sortedIds.end(), isBefore);
+        // Every component is moved out once and back into its new slot
+        std::vector<T> sorted;
+        sorted.reserve(sortedIds.size());
+        for (auto entityId: sortedIds)
+        {
+            sorted.push_back(std::move(*GetSlot(entityIdToIndex[entityId])));
+        }
+        for (int i = 0; i < static_cast<int>(sortedIds.size()); i++)
+        {
+            *GetSlot(begin + i) = std::move(sorted[i]);
+            indexToEntityId[begin + i] = sortedIds[i];
+            entityIdToIndex[sortedIds[i]] = begin + i;
+        }
+    }
 
-template <typename TComponent, typename ...TArgs>
-void Registry::AddComponent(Entity entity, TArgs&& ...args)
-{
-    const auto componentId = Component<TComponent>::GetId();
-    const auto entityId = entity.GetId();
+    void WriteSnapshot(SnapshotWriter& writer, const std::vector<bool>* isEntityVisible = nullptr) const override
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Components are copied into the snapshots as they are, hold handles rather than pointers or strings");
+        // The size tells a snapshot saved before the component layout changed
+        writer.WriteVarint(sizeof(T));
+        if (isEntityVisible)
+        {
+            auto isVisible = [isEntityVisible](int entityId) { return entityId < static_cast<int>(isEntityVisible->size()) && (*isEntityVisible)[entityId]; };
+            writer.WriteVarint(std::count_if(indexToEntityId.begin(), indexToEntityId.end(), isVisible));
+            int previousEntityId = 0;
+            for (auto entityId: indexToEntityId)
+            {
+                if (isVisible(entityId))
+                {
+                    writer.WriteSignedVarint(entityId - previousEntityId);
+                    previousEntityId = entityId;
+                }
+            }
+            for (int index = 0; index < numComponents; index++)
+            {
+                if (isVisible(indexToEntityId[index]))
+                {
+                    writer.WriteBytes(GetSlot(index), sizeof(T));
+                }
+            }
+            return;
+        }
+        writer.WriteVarint(numComponents);
+        int previousEntityId = 0;
+        for (auto entityId: indexToEntityId)
+        {
+            writer.WriteSignedVarint(entityId - previousEntityId);
+            previousEntityId = entityId;
+        }
+        for (int index = 0; index < numComponents; index += PAGE_CAPACITY)
+        {
+            writer.WriteBytes(GetSlot(index), std::min(PAGE_CAPACITY, numComponents - index) * sizeof(T));
+        }
+    }
 
-    // If the component id is greater than the current size of the componentPools, the resize the vector
-    if (componentId >= static_cast<int>(componentPools.size()))
+    bool ReadSnapshot(SnapshotReader& reader, const SnapshotRemap& remap) override
     {
-        componentPools.resize(componentId + 1, nullptr);
+        Clear();
+        if (reader.ReadVarint() != sizeof(T))
+        {
+            return false;
+        }
+        const int numReadComponents = reader.ReadCount(MAX_ENTITIES);
+        indexToEntityId.resize(numReadComponents);
+        int entityId = 0;
+        int maxEntityId = -1;
+        for (int i = 0; i < numReadComponents; i++)
+        {
+            entityId += reader.ReadSignedVarint();
+            if (entityId < 0 || entityId >= static_cast<int>(MAX_ENTITIES))
+            {
+                reader.Fail();
+            }
+            if (reader.HasFailed())
+            {
+                Clear();
+                return false;
+            }
+            indexToEntityId[i] = entityId;
+            maxEntityId = std::max(maxEntityId, entityId);
+        }
+        if (reader.GetNumRemainingBytes() < numReadComponents * sizeof(T))
+        {
+            Clear();
+            return false;
+        }
+        entityIdToIndex.resize(maxEntityId + 1, -1);
+        for (int i = 0; i < numReadComponents; i++)
+        {
+            // An entity has a single component of each type
+            if (entityIdToIndex[indexToEntityId[i]] != -1)
+            {
+                Clear();
+                return false;
+            }
+            entityIdToIndex[indexToEntityId[i]] = i;
+        }
+        // Trivially copyable, the bytes read into the pages are the components
+        Reserve(numReadComponents);
+        for (int index = 0; index < numReadComponents; index += PAGE_CAPACITY)
+        {
+            reader.ReadBytes(GetSlot(index), std::min(PAGE_CAPACITY, numReadComponents - index) * sizeof(T));
+        }
+        numComponents = numReadComponents;
+        const ComponentReflection& reflection = ComponentReflectionOf<T>::Get();
+        if (reflection.hasHandles)
+        {
+            for (int index = 0; index < numReadComponents; index++)
+            {
+                RemapComponentHandles(reflection, GetSlot(index), remap);
+            }
+        }
+        return true;
     }
 
-    // If we still don't have a Pool for that component type
-    if (!componentPools[componentId])
+    // Stays valid as the pool grows
+    T &Get(int entityId)
     {
-        std::shared_ptr<Pool<TComponent>> newComponentPool = std::make_shared<Pool<TComponent>>();
-        componentPools[componentId] = newComponentPool;
+        ECS_CHECK(entityId >= 0 && entityId < static_cast<int>(entityIdToIndex.size()) && entityIdToIndex[entityId] != -1, "Entity without a component in the pool");
+        return *GetSlot(entityIdToIndex[entityId]);
     }
 
-    // Get the pool of component values for that component type
-    std::shared_ptr<Pool<TComponent>> componentPool = std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
+    // Returns the entity id that owns the component at the given dense index
+    int GetEntityId(int index) const
+    {
+        return indexToEntityId[index];
+    }
 
-    // If the entity id is greater than the current size of the component pool, then resize the pool
-    if (entityId >= componentPool->GetSize())
+    // Access by dense index, used to iterate only the live components
+    T &operator[](unsigned int index)
     {
-        componentPool->Resize(numEntities);
+        ECS_CHECK(index < static_cast<unsigned int>(numComponents), "Dense index past the components of the pool");
+        return *GetSlot(index);
     }
+};
 
-    // Create a new Component object of the type T, and forward the various parameters to the constructor
-    TComponent newComponent(std::forward<TArgs>(args)...);
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Archetype
+/////////////////////////////////////////////////////////////////////////////////////////////
+// An archetype groups all the entities that share the same signature. Their components
+// live in fixed-size chunks with one contiguous column per component type (SoA), so a
+// system can stream several components side by side without per-entity lookups.
+/////////////////////////////////////////////////////////////////////////////////////////////
+const unsigned int ARCHETYPE_CHUNK_SIZE = 16 * 1024;
 
-    // Add the new component to the component pool list, using the entity id as index
-    componentPool->Set(entityId, newComponent);
+enum StorageMode
+{
+    STORAGE_POOL,
+    STORAGE_ARCHETYPE
+};
 
-    // Finally, change the component signature of the entity and set the component id on the bitset to 1
-    entityComponentSignatures[entityId].set(componentId);
+// Define ECS_ARCHETYPE_STORAGE to make archetypes the default storage of every registry
+#ifdef ECS_ARCHETYPE_STORAGE
+const StorageMode DEFAULT_STORAGE_MODE = STORAGE_ARCHETYPE;
+#else
+const StorageMode DEFAULT_STORAGE_MODE = STORAGE_POOL;
+#endif
 
-    Logger::Log("Component id = " + std::to_string(componentId) + " was added to entity id " + std::to_string(entityId) + "!");
-}
+// Number and memory of the components of one type, whatever the storage
+struct ComponentStats
+{
+    int componentId;
+    int numComponents;
+    size_t numBytes;
+    // Components there is room for, the rows of the chunks with archetypes
+    int capacity;
+    // Of the sparse array of a pool, 0 with archetypes
+    int numEntitySlots;
+    // What the live components need of numBytes, the rest is waste
+    size_t numUsedBytes;
+};
 
-template <typename TComponent>
-void Registry::RemoveComponent(Entity entity)
+// Type-erased operations needed to move components between chunks
+struct ComponentTypeInfo
 {
-    const auto componentId = Component<TComponent>::GetId();
-    const auto entityId = entity.GetId();
+    size_t size = 0;
+    size_t alignment = 0;
+    void (*moveConstruct)(void* destination, void* source) = nullptr;
+    void (*destroy)(void* component) = nullptr;
 
-    entityComponentSignatures[entityId].set(componentId, false);
-    Logger::Log("Component id = " + std::to_string(componentId) + " was removed from entity id " + std::to_string(entityId) + "!");
-}
+    template <typename TComponent>
+    static ComponentTypeInfo Create()
+    {
+        ComponentTypeInfo info;
+        info.size = sizeof(TComponent);
+        info.alignment = alignof(TComponent);
+        info.moveConstruct = [](void* destination, void* source) { new (destination) TComponent(std::move(*static_cast<TComponent*>(source))); };
+        info.destroy = [](void* component) { static_cast<TComponent*>(component)->~TComponent(); };
+        return info;
+    }
+};
 
-template <typename TComponent>
-bool Registry::HasComponent(Entity entity) const
+struct ArchetypeChunk
 {
-    const auto componentId = Component<TComponent>::GetId();
-    const auto entiyId = entity.GetId();
+    alignas(64) unsigned char data[ARCHETYPE_CHUNK_SIZE];
+    int count = 0;
+};
 
-    return entityComponentSignatures[entiyId].test(componentId);
-}
+class Archetype;
 
-template <typename TComponent>
-TComponent& Registry::GetComponent(Entity entity) const
+struct EntityLocation
 {
-    const auto componentId = Component<TComponent>::GetId();
-    const auto entiyId = entity.GetId();
-    auto componentPool = std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
-
-    return componentPool->Get(entiyId);
-}
+    Archetype* archetype = nullptr;
+    int chunk = 0;
+    int row = 0;
+};
 
-template <typename TSystem, typename ...TArgs>
-void Registry::AddSystem(TArgs&& ...args)
+class Archetype
 {
-    std::shared_ptr<TSystem> newSystem = std::make_shared<TSystem>(std::forward<TArgs>(args)...);
-    systems.insert(std::make_pair(std::type_index(typeid(TSystem)), newSystem));
-}
+private:
+    Signature signature;
+    const std::vector<ComponentTypeInfo>& typeInfos;
 
-template <typename TSystem>
-void Registry::RemoveSystem()
+    // Component ids of this archetype, and the byte offset of their column inside a chunk
+    std::vector<int> componentIds;
+    int columnOffsets[MAX_COMPONENTS];
+
+    // Number of entities that fit in one chunk, the entity ids column is always at offset 0
+    int chunkCapacity = 0;
+    std::vector<std::unique_ptr<ArchetypeChunk>> chunks;
+
+public:
+    Archetype(const Signature& signature, const std::vector<ComponentTypeInfo>& typeInfos);
+    ~Archetype();
+
+    const Signature& GetSignature() const { return signature; }
+    const std::vector<int>& GetComponentIds() const { return componentIds; }
+    int GetChunkCapacity() const { return chunkCapacity; }
+    int GetNumChunks() const { return chunks.size(); }
+    ArchetypeChunk& GetChunk(int chunk) const { return *chunks[chunk]; }
+
+    int* GetEntityIds(ArchetypeChunk& chunk) const
+    {
+        return reinterpret_cast<int*>(chunk.data);
+    }
+
+    template <typename TComponent>
+    TComponent* GetColumn(ArchetypeChunk& chunk, int componentId) const
+    {
+        return reinterpret_cast<TComponent*>(chunk.data + columnOffsets[componentId]);
+    }
+
+    void* GetComponent(int chunk, int row, int componentId) const
+    {
+        ECS_CHECK(signature.test(componentId), "Component not in the archetype");
+        ECS_CHECK(chunk >= 0 && chunk < static_cast<int>(chunks.size()) && row >= 0 && row < chunkCapacity, "Row past the chunks of the archetype");
+        return chunks[chunk]->data + columnOffsets[componentId] + row * typeInfos[componentId].size;
+    }
+
+    // Reserves a row at the end of the last chunk, the components are left uninitialized
+    EntityLocation Allocate(int entityId);
+
+    // Destroys the components of a row and fills the hole with the last row.
+    // Returns the id of the entity that was moved into the hole, or -1 if none was.
+    int Free(int chunk, int row);
+};
+
+class ArchetypeStorage
 {
-    auto system = systems.find(std::type_index(typeid(TSystem)));
-    systems.erase(system);
-}
+private:
+    // [component id] -> operations to move/destroy that component type
+    std::vector<ComponentTypeInfo> typeInfos;
 
-template <typename TSystem> 
-bool Registry::HasSystem() const
+    PoolUnorderedMap<Signature, std::unique_ptr<Archetype>> archetypes;
+    std::vector<Archetype*> archetypeList;
+
+    // [entity id] -> archetype, chunk and row where its components are stored
+    std::vector<EntityLocation> entityLocations;
+
+    Archetype* GetOrCreateArchetype(const Signature& signature);
+
+    // Moves the entity to another archetype, carrying along the components they share
+    void MoveEntity(int entityId, Archetype* destination);
+
+public:
+    ArchetypeStorage() = default;
+    ~ArchetypeStorage() = default;
+
+    template <typename TComponent, typename ...TArgs> void AddComponent(int entityId, int componentId, TArgs&& ...args);
+    template <typename TComponent> TComponent& GetComponent(int entityId, int componentId) const;
+    void* GetComponentData(int entityId, int componentId) const;
+
+    // Bulk spawning: the component types are registered first, then the new entities get
+    // their rows in the archetype of the signature and every component is copied in
+    void RegisterComponentType(int componentId, const ComponentTypeInfo& typeInfo);
+    void InsertEntities(const std::vector<int>& entityIds, const Signature& signature);
+    template <typename TComponent> void FillComponent(const std::vector<int>& entityIds, int componentId, const TComponent& component);
+
+    void RemoveComponent(int entityId, int componentId);
+    void RemoveEntity(int entityId);
+    void Compact(int numEntities);
+    void Clear();
+    // Reorders the rows of every archetype by the keys of their entities, see Registry::SortEntities
+    void SortEntities(const std::vector<uint32_t>& entityKeys);
+
+    const std::vector<Archetype*>& GetArchetypes() const { return archetypeList; }
+
+    // Adds the components of every archetype to stats, indexed by component id. The chunk
+    // memory is split between the columns by size, the entity ids column is left out.
+    void AddComponentStats(std::vector<ComponentStats>& stats) const;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Prefab
+/////////////////////////////////////////////////////////////////////////////////////////////
+// A template entity: the components an entity is spawned with and their values, with the
+// signature worked out once. Registry::Instantiate stamps it onto a whole wave of entities,
+// each component type is copied into its storage in one pass.
+// Example: Prefab enemy;
+//     enemy.AddComponent<TransformComponent>().AddComponent<SpriteComponent>("tank-image", 32, 32, 1);
+//     for (auto entity: registry->Instantiate(enemy, 500)) { ... set the positions ... }
+/////////////////////////////////////////////////////////////////////////////////////////////
+class Registry;
+
+class Prefab
 {
-    return systems.find(std::type_index(typeid(TSystem))) != systems.end();
-}
+private:
+    struct PrefabComponent
+    {
+        int componentId;
+        ComponentTypeInfo typeInfo;
+        std::shared_ptr<void> component;
+        // Copies the component to every entity, in the storage of the registry
+        void (*instantiate)(Registry& registry, const void* component, const std::vector<int>& entityIds);
+    };
 
-template <typename TSystem>
-TSystem& Registry::GetSystem() const
+    Signature signature;
+    std::vector<PrefabComponent> components;
+
+    friend class Registry;
+
+public:
+    // Constructs the default value of the component, replacing the previous one of that type
+    template <typename TComponent, typename ...TArgs> Prefab& AddComponent(TArgs&& ...args);
+
+    const Signature& GetSignature() const { return signature; }
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Change tracking
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The components of a tracked type changed through PatchComponent, or added, are flagged
+// per entity. Each commit gathers the flagged entities into the history and clears the
+// flags, so the systems downstream only go over what changed since the commit they last saw.
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Commits kept for the systems that read the changes less often than every tick
+const uint32_t CHANGE_HISTORY_LENGTH = 16;
+
+struct ComponentChanges
 {
-    auto system = systems.find(std::type_index(typeid(TSystem)));
-    return *(std::static_pointer_cast<TSystem>(system->second));
-}
+    // [entity id] -> changed since the last commit, each entity only writes its own flag so
+    // the systems running in parallel over their own entities can patch
+    std::vector<uint8_t> isChanged;
+    // [commit % CHANGE_HISTORY_LENGTH] -> entities changed before that commit
+    std::array<std::vector<Entity>, CHANGE_HISTORY_LENGTH> history;
+};
 
-template <typename TComponent, typename ...TArgs>
-void Entity::AddComponent(TArgs&& ...args)
+// Given the entities that gained or lost a component type in one Registry::Update
+using ComponentObserver = std::function<void(const std::vector<Entity>& entities)>;
+
+struct ComponentObservers
 {
-    registry->AddComponent<TComponent>(*this, std::forward<TArgs>(args)...);
-}
+    std::vector<ComponentObserver> onAdded;
+    std::vector<ComponentObserver> onRemoved;
+    // Gathered during the update, then given to the observers in one batch
+    std::vector<Entity> addedEntities;
+    std::vector<Entity> removedEntities;
+};
 
-template <typename TComponent>
-void Entity::RemoveComponent()
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Command Buffer
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Structural changes (entity creation/destruction, component add/remove) are recorded in
+// flat vectors during the frame and applied in batch by Registry::Update(), where they are
+// sorted and deduplicated once. Recording only appends, so it is safe during system iteration.
+/////////////////////////////////////////////////////////////////////////////////////////////
+struct ComponentCommand
 {
-    registry->RemoveComponent<TComponent>(*this);
-}
+    int entityId;
+    int componentId;
 
-template <typename TComponent>
-bool Entity::HasComponent() const
+    bool operator==(const ComponentCommand& other) const { return entityId == other.entityId && componentId == other.componentId; }
+    bool operator<(const ComponentCommand& other) const { return entityId < other.entityId || (entityId == other.entityId && componentId < other.componentId); }
+};
+
+struct EntityCommandBuffer
 {
-    return registry->HasComponent<TComponent>(*this);
-}
+    std::vector<int> createdEntityIds;
+    std::vector<int> killedEntityIds;
+    std::vector<ComponentCommand> addedComponents;
+    std::vector<ComponentCommand> removedComponents;
 
-template <typename TComponent>
-TComponent& Entity::GetComponent() const
+    // Sorts every command list and removes the duplicates
+    void SortAndDeduplicate();
+    void Clear();
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Thread command buffer
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Structural changes made from the threads of the job system, e.g. by the systems running
+// in parallel. Each thread records into its own buffer (Registry::GetThreadCommands) with no
+// lock, and Registry::Update() plays the buffers back by thread index, each in the order it
+// was recorded, through the calls the simulation thread makes. Played back in order, the
+// commands of all the buffers are sorted by the event order they were recorded under
+// instead (see EventOrderScope), the same whatever thread ran what. The entities created in a
+// buffer only get an id then, until then they are the DeferredEntity CreateEntity returned.
+// The components are copied as bytes, they are trivially copyable like in the snapshots.
+/////////////////////////////////////////////////////////////////////////////////////////////
+struct DeferredEntity
+{
+    // Of the entities created in the buffer
+    int index;
+};
+
+class alignas(64) ThreadCommandBuffer
+{
+private:
+    enum CommandType
+    {
+        COMMAND_CREATE_ENTITY,
+        COMMAND_KILL_ENTITY,
+        COMMAND_APPLY_COMPONENT
+    };
+
+    struct Command
+    {
+        CommandType type;
+        Entity entity;
+        // Of an entity created in the buffer, -1 for one that existed
+        int deferredIndex;
+        // Of the added component, in the component data
+        size_t dataOffset;
+        // Adds the component from its bytes, or removes it
+        void (*apply)(Registry& registry, Entity entity, const void* component);
+        // The event order of the thread when it was recorded
+        uint64_t order;
+    };
+
+    std::vector<Command> commands;
+    std::vector<unsigned char> componentData;
+    int numDeferredEntities = 0;
+    // The deferred entities as they are created, during the playback
+    std::vector<Entity> createdEntities;
+
+    template <typename TComponent> static void AddRecordedComponent(Registry& registry, Entity entity, const void* component);
+    template <typename TComponent> static void RemoveRecordedComponent(Registry& registry, Entity entity, const void* component);
+    template <typename TComponent, typename ...TArgs> void RecordAddComponent(Entity entity, int deferredIndex, TArgs&& ...args);
+    // Of a command other than a creation
+    void Apply(Registry& registry, const Command& command) const;
+
+public:
+    ThreadCommandBuffer() = default;
+
+    DeferredEntity CreateEntity();
+    void KillEntity(Entity entity);
+    template <typename TComponent, typename ...TArgs> void AddComponent(Entity entity, TArgs&& ...args);
+    template <typename TComponent, typename ...TArgs> void AddComponent(DeferredEntity entity, TArgs&& ...args);
+    template <typename TComponent> void RemoveComponent(Entity entity);
+
+    bool IsEmpty() const { return commands.empty(); }
+    // The commands on an entity killed meanwhile are dropped
+    void Playback(Registry& registry);
+    // The commands of all the buffers sorted by their event order, the entities they create
+    // first, then the rest
+    static void PlaybackInOrder(Registry& registry, std::vector<ThreadCommandBuffer>& buffers);
+    void Clear();
+};
+
+template <typename ...TComponents> class ComponentView;
+
+// Terms of a query, see Query below
+template <typename ...TComponents> struct With {};
+template <typename ...TComponents> struct Without {};
+template <typename ...TComponents> struct Optional {};
+template <typename TWith, typename TWithout = Without<>, typename TOptional = Optional<>> class Query;
+
+// What becomes of a child when its parent is killed, see Registry::SetEntityParent
+enum OrphanPolicy
+{
+    // It loses its parent and lives on, e.g. a projectile in flight
+    ORPHAN_DETACHED,
+    // It goes to the parent of its parent, detached when there is none
+    ORPHAN_REPARENTED,
+    // It dies in the same update, e.g. a turret with its tank
+    ORPHAN_KILLED
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Component bit planes
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The entity signatures turned sideways: one bit per entity id for each component id, 64
+// entities to a word. A query ANDs the planes of its components a word at a time and only
+// visits the set bits, instead of testing the signature of every entity.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class ComponentBitPlanes
+{
+private:
+    // [component id] -> the bits of the entities with the component, up to the highest entity
+    // id that had it
+    std::vector<uint64_t> planes[MAX_COMPONENTS];
+    // The entities with any component, at least as long as every plane
+    std::vector<uint64_t> entityPlane;
+
+    static void SetBit(std::vector<uint64_t>& plane, int entityId, bool isSet);
+
+public:
+    // Only the bits that differ between the two signatures are written
+    void Update(int entityId, const Signature& oldSignature, const Signature& newSignature);
+    void Clear();
+    // Drops the words of the entity ids at or above numEntities, none of which has a component
+    void Compact(int numEntities);
+    size_t GetMemoryUsage() const;
+
+    // Invokes func(entityId) for every entity with all the required components and none of
+    // the excluded ones, in entity id order
+    template <typename TFunc> void Each(const Signature& required, const Signature& excluded, TFunc func) const;
+};
+
+template <typename TFunc>
+void ComponentBitPlanes::Each(const Signature& required, const Signature& excluded, TFunc func) const
+{
+    // The planes are looked up once, not for every word
+    const std::vector<uint64_t>* requiredPlanes[MAX_COMPONENTS];
+    const std::vector<uint64_t>* excludedPlanes[MAX_COMPONENTS];
+    int numRequired = 0;
+    int numExcluded = 0;
+    size_t numWords = entityPlane.size();
+    for (int componentId = 0; componentId < static_cast<int>(MAX_COMPONENTS); componentId++)
+    {
+        if (required.test(componentId))
+        {
+            requiredPlanes[numRequired++] = &planes[componentId];
+            // No entity past the end of a required plane matches
+            numWords = std::min(numWords, planes[componentId].size());
+        }
+        else if (excluded.test(componentId) && !planes[componentId].empty())
+        {
+            excludedPlanes[numExcluded++] = &planes[componentId];
+        }
+    }
+    for (size_t word = 0; word < numWords; word++)
+    {
+        uint64_t bits = entityPlane[word];
+        for (int i = 0; i < numRequired && bits; i++)
+        {
+            bits &= (*requiredPlanes[i])[word];
+        }
+        for (int i = 0; i < numExcluded && bits; i++)
+        {
+            bits &= word < excludedPlanes[i]->size() ? ~(*excludedPlanes[i])[word] : ~uint64_t(0);
+        }
+        while (bits)
+        {
+            func(static_cast<int>(word * 64 + __builtin_ctzll(bits)));
+            bits &= bits - 1;
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Registry
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The Registry manages the creation and destruction of entities, as well as
+// adding systems and adding components to entities.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class Registry
+{
+private:
+    template <typename ...TComponents> friend class ComponentView;
+
+    // Keep track of how many entities were added to the scene
+    int numEntities = 0;
+
+    // Where the components are stored (per-type pools or archetype chunks)
+    StorageMode storageMode;
+    int poolReserve = POOL_DEFAULT_RESERVE;
+
+    // Vector of component pools.
+    // each pool contains all the data for a certain component type
+    // [vector index = componentId], [pool index = entityId]
+    std::vector<std::shared_ptr<IPool>> componentPools;
+
+    // Archetype chunks, only used when the storage mode is STORAGE_ARCHETYPE
+    std::unique_ptr<ArchetypeStorage> archetypeStorage;
+
+    // Vector of component signatures.
+    // The signature lets us know which components are turned "on" for an entity
+    // [vector index = entity id]
+    std::vector<Signature> entityComponentSignatures;
+
+    // Map of active systems [index = system typeid]
+    // The pools, the systems and the map nodes come from the block allocator
+    PoolUnorderedMap<std::type_index, std::shared_ptr<System>> systems;
+
+    // Queries made so far, kept up to date like the systems [index = query typeid]
+    PoolUnorderedMap<std::type_index, std::shared_ptr<System>> queries;
+
+    // One tag per entity and one entity per tag, e.g. "player"
+    PoolUnorderedMap<std::string, Entity> entityPerTag;
+    PoolUnorderedMap<int, std::string> tagPerEntity;
+
+    // One group per entity, each group keeps its entities packed, e.g. "enemies"
+    struct GroupMembership
+    {
+        std::string group;
+        int index;
+    };
+    PoolUnorderedMap<std::string, std::vector<Entity>> entitiesPerGroup;
+    PoolUnorderedMap<int, GroupMembership> groupPerEntity;
+
+    // The relationships are kept on both ends, the parent of a child knows where the child
+    // is in its children, so a link comes and goes in O(1) and a kill costs its children
+    struct ParentLink
+    {
+        Entity parent;
+        int index;
+        OrphanPolicy policy;
+    };
+    PoolUnorderedMap<int, ParentLink> parentPerEntity;
+    PoolUnorderedMap<int, std::vector<Entity>> childrenPerEntity;
+    // Both entities of a pair point at each other
+    PoolUnorderedMap<int, Entity> pairPerEntity;
+
+    // The entities with all the components of a group have them at the front of the group's
+    // pools, in the same order, see AddOwningGroup
+    struct OwningGroup
+    {
+        Signature signature;
+        std::vector<int> componentIds;
+        // The entities at the front of the pools
+        int size;
+    };
+    std::vector<OwningGroup> owningGroups;
+    // [component id] -> index of the group that owns the component, -1 if none does
+    std::array<int, MAX_COMPONENTS> owningGroupPerComponent;
+
+    // Signature of each entity as the systems last saw it, so a signature change
+    // only touches the systems whose match result flipped
+    // [vector index = entity id]
+    std::vector<Signature> entitySystemSignatures;
+    // The same signatures as bit planes, kept in step with them, see GetQuery
+    ComponentBitPlanes entitySystemPlanes;
+
+    // Structural changes awaiting the next Registry Update(). Commands are recorded into one
+    // buffer while the other one is being applied, so recording never touches what is being processed.
+    EntityCommandBuffer commandBuffer;
+    EntityCommandBuffer processingCommandBuffer;
+    // [job system thread index] -> the commands recorded on that thread, played back first
+    std::vector<ThreadCommandBuffer> threadCommandBuffers;
+    // By event order rather than thread by thread, see ThreadCommandBuffer
+    bool isThreadPlaybackOrdered = false;
+
+    // Version of each entity id, bumped every time the id is killed
+    // [vector index = entity id]
+    std::vector<uint8_t> entityVersions;
+
+    // Queue of free entity ids that were previously removed. It is FIFO and only reused past
+    // MIN_FREE_ENTITY_IDS, a stale handle can't alias the next entity given its id.
+    std::deque<int> freeIds;
+
+    // [component id] -> changes of the tracked component types, nullptr if untracked
+    std::vector<std::unique_ptr<ComponentChanges>> componentChanges;
+    uint32_t changeVersion = 0;
+
+    // [resource id] -> the resource of the type, nullptr if it isn't set
+    std::array<std::shared_ptr<void>, MAX_RESOURCES> resources;
+    // [resource id] -> bumped every time the resource is set, patched or removed
+    std::array<uint32_t, MAX_RESOURCES> resourceVersions{};
+
+    // [component id] -> the observers of the type, nullptr if it has none
+    std::vector<std::unique_ptr<ComponentObservers>> componentObservers;
+    Signature observedComponents;
+
+    // Slot of this registry in the registries table, encoded in every entity handle it creates
+    int registryIndex = -1;
+    static std::atomic<Registry*> registries[MAX_REGISTRIES];
+
+    friend class Entity;
+    friend class Prefab;
+
+    // Takes a free id, or the next one, for a new entity without recording its creation. Aborts
+    // when all MAX_ENTITIES ids are in use, a larger id would spill into the version bits.
+    int AllocateEntityId();
+    // Unlinks a killed entity from its parent, children and pair, its children go as their
+    // policy says
+    void RemoveEntityRelationships(Entity entity);
+    void ResizeChangeFlags(int size);
+    void MarkChanged(int componentId, int entityId);
+    // Gathers the observed components the entity gained or lost between the signatures
+    void GatherObservedChanges(Entity entity, const Signature& oldSignature, const Signature& newSignature);
+    void NotifyObservers();
+    // Drops the entities, components, tags and groups, leaving the systems and queries as they are
+    void ClearEntities();
+
+    template <typename TComponent> static void InstantiateComponent(Registry& registry, const void* component, const std::vector<int>& entityIds);
+
+public:
+    Registry(StorageMode storageMode = DEFAULT_STORAGE_MODE);
+    ~Registry();
+
+    void Update();
+
+    StorageMode GetStorageMode() const { return storageMode; }
+    // Room of the pools created from now on, before they grow
+    void SetPoolReserve(int capacity) { poolReserve = std::max(0, capacity); }
+
+    // Entity management
+    Entity CreateEntity();
+    void KillEntity(Entity entity);
+    Entity GetEntity(int entityId) const;
+
+    // Creates count entities with the components of the prefab, they join their systems on
+    // the next Update() like any created entity
+    std::vector<Entity> Instantiate(const Prefab& prefab, int count);
+
+    // Returns false if the entity was killed, even if its id was reused since then
+    bool IsAlive(Entity entity) const;
+
+    // Destroys every entity, component, system, query, tag and group at once, without telling
+    // the systems about each entity. The pools keep their memory for the next level, the
+    // tracked component types stay tracked, and every handle given so far goes stale.
+    void Clear();
+
+    // Gives back the memory of the entity ids above the highest one still in use,
+    // shrinking the signatures, pools and systems after the entity count dropped
+    void Compact();
+
+    // Reorders the stored components by a key per entity ([entity id] -> key, the ids past
+    // the keys go last), e.g. where they are in the world, so the entities iterated one after
+    // the other are the ones close by. The owning groups keep their entities at the front of
+    // their pools, in the same order. Not during an iteration of the components.
+    void SortEntities(const std::vector<uint32_t>& entityKeys);
+
+    // Entities alive, and the components of each type that has any, for the debug overlay
+    int GetNumEntities() const;
+    // One past the highest entity id in use, the size of the per-entity arrays
+    int GetNumEntityIds() const { return numEntities; }
+    // The components of the entity with this id, none for a free id
+    const Signature& GetEntitySignature(int entityId) const;
+    void GetComponentStats(std::vector<ComponentStats>& stats) const;
+    // xxHash64 of the entities and the reflected fields of their components, the same on two
+    // runs that simulated the same, so a desync is caught on the tick it happens. Each chunk
+    // of entities is laid out in a buffer and hashed on a worker, the components with no
+    // padding as a block, and the chunks are combined in entity order. The asset handles and
+    // the render-only components are left out, the handles are only valid in the process
+    // that made them.
+    uint64_t ComputeChecksum(JobSystem& jobSystem) const;
+    // Bytes held by the components and the per-entity bookkeeping, for the memory budgets
+    size_t GetMemoryUsage() const;
+
+    // The entities, components, tags and groups, see Snapshot/Snapshot.h. Only the pool
+    // storage can be saved, and the pending commands are not, so Update() goes first.
+    // Given [entity id] -> visible, the other entities are saved alive but without components,
+    // e.g. for the entities out of a network client's area of interest.
+    bool WriteSnapshot(SnapshotWriter& writer, const std::vector<bool>* isEntityVisible = nullptr) const;
+    // Replaces every entity, the systems stay and see the entities leave and join them. The
+    // pools of the components in the snapshot must exist already, e.g. from a loaded level.
+    // On failure the registry is left without entities.
+    bool ReadSnapshot(SnapshotReader& reader, const SnapshotRemap& remap);
+    int GetRegistryIndex() const { return registryIndex; }
+
+    // Component management
+    template <typename TComponent, typename ...TArgs> void AddComponent(Entity entity, TArgs&& ...args);
+    template <typename TComponent> void Reserve(int capacity);
+    // Adds components[i] to entities[i] for the count of them, as AddComponent would one by
+    // one, but the pool is looked up once and grown once before the components are copied
+    template <typename TComponent> void InsertBulk(const Entity* entities, const TComponent* components, int count);
+    template <typename TComponent> void InsertBulk(const std::vector<Entity>& entities, const std::vector<TComponent>& components);
+    // Overwrites the component of each entity, which all have one, with the packed
+    // components[i] and flags it as changed, e.g. the state the network applies
+    template <typename TComponent> void PatchBulk(const Entity* entities, const TComponent* components, int count);
+    template <typename TComponent> void RemoveComponent(Entity entity);
+    template <typename TComponent> bool HasComponent(Entity entity) const;
+    template <typename TComponent> TComponent& GetComponent(Entity entity) const;
+    // For the structural changes made on the calling thread while the systems run in
+    // parallel, see ThreadCommandBuffer
+    ThreadCommandBuffer& GetThreadCommands() { return threadCommandBuffers[JobSystem::GetThreadIndex()]; }
+    // Plays the thread commands back sorted by their event order, the same on every run
+    // whatever thread recorded what
+    void SetOrderedThreadPlayback(bool isOrdered) { isThreadPlaybackOrdered = isOrdered; }
+    // The same as bytes, for the tools driven by the component reflection
+    const void* GetComponentData(int componentId, Entity entity) const;
+    void* PatchComponentData(int componentId, Entity entity);
+
+    // Change tracking, for the types tracked from the start of the level
+    template <typename TComponent> void TrackChanges();
+    // The component to write to, flagged as changed
+    template <typename TComponent> TComponent& PatchComponent(Entity entity);
+    // Flags a component written in place, e.g. through the chunk columns of a view
+    template <typename TComponent> void MarkComponentChanged(int entityId);
+    // Moves the changes flagged so far into the history, done by Update() and before the
+    // frame is rendered. No system may run meanwhile.
+    void CommitChanges();
+    uint32_t GetChangeVersion() const { return changeVersion; }
+    // Appends the entities whose component changed in the commits since the version, an
+    // entity changed in several commits is appended for each and may have been killed since.
+    // Returns false when the history doesn't go back that far, e.g. for an untracked type,
+    // and every component has to be taken as changed.
+    template <typename TComponent> bool GetChangedEntities(uint32_t sinceVersion, std::vector<Entity>& entities) const;
+
+    // Component observers, given on each Update() the entities that gained or lost the
+    // component since the last one, in one batch per type, after the systems saw them and
+    // before the data of the removed components is dropped, so it can still be read. A
+    // component removed and added back in between is not reported, and neither are the
+    // entities of a loaded snapshot. Either observer may be empty. They are dropped with the
+    // systems by Clear().
+    template <typename TComponent> void ObserveComponent(ComponentObserver onAdded, ComponentObserver onRemoved);
+    void ObserveComponent(int componentId, ComponentObserver onAdded, ComponentObserver onRemoved);
+
+    // Resource management, one value per resource type for the whole registry, instead of
+    // statics every world would share. Setting a resource that is already set assigns it in
+    // place. The resources stay when the registry is cleared.
+    template <typename TResource, typename ...TArgs> TResource& SetResource(TArgs&& ...args);
+    template <typename TResource> bool HasResource() const;
+    // The resource must have been set
+    template <typename TResource> TResource& GetResource() const;
+    // For writing, the resource counts as changed, see GetResourceVersion
+    template <typename TResource> TResource& PatchResource();
+    template <typename TResource> void RemoveResource();
+    // Changes whenever the resource is set, patched or removed
+    template <typename TResource> uint32_t GetResourceVersion() const;
+
+    // Returns a view over every entity that has all the given components
+    template <typename ...TComponents> ComponentView<TComponents...> View();
+
+    // Keeps the entities with all the components packed at the front of their pools, in the
+    // same order, so a view of exactly these components walks the pools side by side instead
+    // of looking each entity up. A component belongs to one group at most, and adding it to
+    // an entity or removing it costs a swap in each pool of the group. The archetypes already
+    // keep the components of an entity together, they have no groups.
+    template <typename ...TComponents> void AddOwningGroup();
+
+    // Tag management, a tag moves to the last entity given it. The tags and groups of an
+    // entity are dropped when it is killed, on the next Update().
+    void TagEntity(Entity entity, const std::string& tag);
+    bool EntityHasTag(Entity entity, const std::string& tag) const;
+    // Returns false if no entity has the tag
+    bool FindEntityByTag(const std::string& tag, Entity& entity) const;
+    void RemoveEntityTag(Entity entity);
+
+    // Group management, an entity joining a group leaves its previous one
+    void GroupEntity(Entity entity, const std::string& group);
+    bool EntityBelongsToGroup(Entity entity, const std::string& group) const;
+    // Empty for a group no entity belongs to
+    const std::vector<Entity>& GetEntitiesByGroup(const std::string& group) const;
+    void RemoveEntityGroup(Entity entity);
+
+    // Relationship management, one parent per child and one pair per entity, kept up to date
+    // on both ends by the registry. A killed parent leaves its children as their policy says
+    // and a killed entity leaves its pair, on the next Update() and in O(children), so no
+    // system scans for the children of the dead. A child leaves its previous parent, and an
+    // entity can't be the parent of its own ancestor.
+    void SetEntityParent(Entity child, Entity parent, OrphanPolicy policy = ORPHAN_DETACHED);
+    // Returns false if the entity has no parent
+    bool GetEntityParent(Entity child, Entity& parent) const;
+    void RemoveEntityParent(Entity child);
+    // Empty for an entity with no children
+    const std::vector<Entity>& GetEntityChildren(Entity parent) const;
+    // Each entity leaves its previous pair
+    void PairEntities(Entity first, Entity second);
+    // Returns false if the entity has no pair
+    bool GetEntityPair(Entity entity, Entity& pair) const;
+    void RemoveEntityPair(Entity entity);
+
+    // Returns the cached entities of the query, scanned for on the first call only. Must not
+    // be called while systems run in parallel, since the first call adds the query.
+    template <typename TWith, typename TWithout = Without<>, typename TOptional = Optional<>>
+    Query<TWith, TWithout, TOptional>& GetQuery();
+
+    // System management
+    template <typename TSystem, typename ...TArgs> void AddSystem(TArgs&& ...args);
+    template <typename TSystem> void RemoveSystem();
+    template <typename TSystem> bool HasSystem() const;
+    template <typename TSystem> TSystem& GetSystem() const;
+    // A disabled system lets go of its entities and the registry stops matching it, it costs
+    // nothing until it is enabled again and given the entities it matches then
+    template <typename TSystem> void SetSystemEnabled(bool isEnabled);
+    void SetSystemEnabled(System& system, bool isEnabled);
+
+    // Checks the component signature of an entity and add the entity to the systems
+    // that are interested in it
+    void AddEntityToSystems(Entity entity);
+    void RemoveEntityFromSystems(Entity entity);
+
+    // Adds or removes the entity only from the systems whose match changed with its new signature
+    void UpdateEntitySystems(Entity entity);
+
+    // The entity joins the group that owns the component once it has all its components, and
+    // leaves it before it loses one, nothing happens when no group owns the component
+    void JoinOwningGroup(int entityId, int componentId);
+    void LeaveOwningGroup(int entityId, int componentId);
+    void AddOwningGroup(const Signature& signature);
+    // Packs the entities of the group from scratch
+    void BuildOwningGroup(OwningGroup& group);
+
+private:
+    // Raw pointer to the pool of a component type, or nullptr if there is no pool yet
+    template <typename TComponent> Pool<TComponent>* GetPool() const;
+    template <typename TComponent> Pool<TComponent>* GetOrCreatePool();
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// View
+/////////////////////////////////////////////////////////////////////////////////////////////
+// A view iterates the entities that have all the given components and yields references
+// to the components in place, without copying any entity list.
+// Example: registry->View<TransformComponent, RigidBodyComponent>().Each(
+//     [](TransformComponent& transform, RigidBodyComponent& rigidBody) { ... });
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename ...TComponents>
+class ComponentView
+{
+private:
+    Registry* registry;
+
+public:
+    ComponentView(Registry* registry): registry(registry) {}
+
+    // Invokes func(components...) or func(entity, components...) for every matching entity
+    template <typename TFunc> void Each(TFunc func) const;
+
+    // Invokes func(entityIds, count, columns...) for every archetype chunk holding matching
+    // entities, so a kernel can run over the contiguous components. The rows whose components
+    // are pending removal are included, the archetypes with any excluded component are not.
+    // Returns false with the pool storage, which has no chunks.
+    template <typename TFunc> bool EachChunk(TFunc func, const Signature& excluded = Signature()) const;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Query
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The entities with all the With components and none of the Without ones. The registry
+// adds and removes them as their signatures change, like the entities of a system, so a
+// query costs a scan only the first time. Optional components are passed by pointer to
+// Each, nullptr when the entity doesn't have them.
+// Example: registry->GetQuery<With<TransformComponent, BoxColliderComponent>, Without<ProjectileComponent>>().Each(
+//     [](Entity entity, TransformComponent& transform, BoxColliderComponent& collider) { ... });
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename ...TWith, typename ...TWithout, typename ...TOptional>
+class Query<With<TWith...>, Without<TWithout...>, Optional<TOptional...>>: public System
+{
+public:
+    Query()
+    {
+        (RequireComponent<TWith>(), ...);
+        (ExcludeComponent<TWithout>(), ...);
+    }
+
+    const std::vector<Entity>& GetEntities() const { return GetSystemEntities(); }
+
+    // Invokes func(entity, with components..., optional components...) for every entity
+    template <typename TFunc>
+    void Each(TFunc func) const
+    {
+        for (auto entity: GetSystemEntities())
+        {
+            func(entity, entity.GetComponent<TWith>()..., (entity.HasComponent<TOptional>() ? &entity.GetComponent<TOptional>() : nullptr)...);
+        }
+    }
+};
+
+template <typename TComponent, typename ...TArgs>
+void ArchetypeStorage::AddComponent(int entityId, int componentId, TArgs&& ...args)
+{
+    if (componentId >= static_cast<int>(typeInfos.size()))
+    {
+        typeInfos.resize(componentId + 1);
+    }
+    if (typeInfos[componentId].size == 0)
+    {
+        typeInfos[componentId] = ComponentTypeInfo::Create<TComponent>();
+    }
+    if (entityId >= static_cast<int>(entityLocations.size()))
+    {
+        entityLocations.resize(entityId + 1);
+    }
+
+    const EntityLocation& location = entityLocations[entityId];
+    if (location.archetype && location.archetype->GetSignature().test(componentId))
+    {
+        // The entity already has the component, just overwrite it
+        GetComponent<TComponent>(entityId, componentId) = TComponent(std::forward<TArgs>(args)...);
+        return;
+    }
+
+    Signature signature = location.archetype ? location.archetype->GetSignature() : Signature();
+    signature.set(componentId);
+    MoveEntity(entityId, GetOrCreateArchetype(signature));
+
+    const EntityLocation& newLocation = entityLocations[entityId];
+    new (newLocation.archetype->GetComponent(newLocation.chunk, newLocation.row, componentId)) TComponent(std::forward<TArgs>(args)...);
+}
+
+template <typename TComponent>
+TComponent& ArchetypeStorage::GetComponent(int entityId, int componentId) const
+{
+    ECS_CHECK(entityId >= 0 && entityId < static_cast<int>(entityLocations.size()) && entityLocations[entityId].archetype, "Entity not in an archetype");
+    const EntityLocation& location = entityLocations[entityId];
+    return *static_cast<TComponent*>(location.archetype->GetComponent(location.chunk, location.row, componentId));
+}
+
+template <typename TComponent>
+void ArchetypeStorage::FillComponent(const std::vector<int>& entityIds, int componentId, const TComponent& component)
+{
+    for (auto entityId: entityIds)
+    {
+        const EntityLocation& location = entityLocations[entityId];
+        new (location.archetype->GetComponent(location.chunk, location.row, componentId)) TComponent(component);
+    }
+}
+
+template <typename TComponent>
+void System::RequireComponent()
+{
+    const auto compontentId = Component<TComponent>::GetId();
+    componentSignature.set(compontentId);
+}
+
+template <typename TComponent>
+void System::ExcludeComponent()
+{
+    excludedSignature.set(Component<TComponent>::GetId());
+}
+
+template <typename TComponent>
+void System::ReadsComponent()
+{
+    readSignature.set(Component<TComponent>::GetId());
+    hasDeclaredAccess = true;
+}
+
+template <typename TComponent>
+void System::WritesComponent()
+{
+    writeSignature.set(Component<TComponent>::GetId());
+    hasDeclaredAccess = true;
+}
+
+template <typename TResource>
+void System::ReadsResource()
+{
+    resourceReadSignature.set(Resource<TResource>::GetId());
+    hasDeclaredAccess = true;
+}
+
+template <typename TResource>
+void System::WritesResource()
+{
+    resourceWriteSignature.set(Resource<TResource>::GetId());
+    hasDeclaredAccess = true;
+}
+
+template <typename TFunc>
+void System::ParallelEach(JobSystem& jobSystem, TFunc func, int grainSize, int minParallelEntities) const
+{
+    // The same serial or parallel, so the order doesn't depend on the number of workers
+    const uint64_t systemOrder = GetCurrentEventOrder() & 0xFFFFFFFF00000000ull;
+    const int numEntities = entities.size();
+    if (numEntities < minParallelEntities || jobSystem.GetNumWorkers() == 0)
+    {
+        EventOrderScope scope(systemOrder);
+        for (auto entity: entities)
+        {
+            GetCurrentEventOrder() = systemOrder | (entity.GetId() + 1);
+            func(entity);
+        }
+        return;
+    }
+
+    jobSystem.ParallelFor(numEntities, grainSize, [this, &func, systemOrder](int begin, int end)
+    {
+        EventOrderScope scope(systemOrder);
+        for (int i = begin; i < end; i++)
+        {
+            GetCurrentEventOrder() = systemOrder | (entities[i].GetId() + 1);
+            func(entities[i]);
+        }
+    });
+}
+
+template <typename TComponent, typename ...TArgs>
+void Registry::AddComponent(Entity entity, TArgs&& ...args)
+{
+    const auto componentId = Component<TComponent>::GetId();
+    const auto entityId = entity.GetId();
+    ECS_CHECK(entity.GetRegistryIndex() == registryIndex && entityId < static_cast<int>(entityComponentSignatures.size()), "Entity of another registry or past its entities");
+    ECS_CHECK(IsAlive(entity), "Stale entity handle, its entity was killed");
+
+    if (storageMode == STORAGE_ARCHETYPE)
+    {
+        // Move the entity to the archetype of its new signature and construct the component in its chunk
+        archetypeStorage->AddComponent<TComponent>(entityId, componentId, std::forward<TArgs>(args)...);
+    }
+    else
+    {
+        // Construct the component in place in the pool, forwarding the various parameters to the constructor
+        GetOrCreatePool<TComponent>()->Emplace(entityId, std::forward<TArgs>(args)...);
+        if (owningGroupPerComponent[componentId] != -1)
+        {
+            JoinOwningGroup(entityId, componentId);
+        }
+    }
+
+    // Finally, change the component signature of the entity and set the component id on the bitset to 1
+    entityComponentSignatures[entityId].set(componentId);
+    commandBuffer.addedComponents.push_back({entityId, componentId});
+    MarkChanged(componentId, entityId);
+
+    LOGGER_DEBUG("Component id = {} was added to entity id {}!", componentId, entityId);
+}
+
+template <typename TComponent>
+void Registry::InstantiateComponent(Registry& registry, const void* component, const std::vector<int>& entityIds)
+{
+    const auto componentId = Component<TComponent>::GetId();
+    const TComponent& prefabComponent = *static_cast<const TComponent*>(component);
+    if (registry.storageMode == STORAGE_ARCHETYPE)
+    {
+        registry.archetypeStorage->FillComponent<TComponent>(entityIds, componentId, prefabComponent);
+    }
+    else
+    {
+        registry.GetOrCreatePool<TComponent>()->Fill(entityIds, prefabComponent);
+        if (registry.owningGroupPerComponent[componentId] != -1)
+        {
+            for (auto entityId: entityIds)
+            {
+                registry.JoinOwningGroup(entityId, componentId);
+            }
+        }
+    }
+    for (auto entityId: entityIds)
+    {
+        registry.MarkChanged(componentId, entityId);
+    }
+}
+
+template <typename TComponent, typename ...TArgs>
+Prefab& Prefab::AddComponent(TArgs&& ...args)
+{
+    const auto componentId = Component<TComponent>::GetId();
+    PrefabComponent prefabComponent = {componentId, ComponentTypeInfo::Create<TComponent>(),
+        std::make_shared<TComponent>(std::forward<TArgs>(args)...), &Registry::InstantiateComponent<TComponent>};
+    if (signature.test(componentId))
+    {
+        for (auto& component: components)
+        {
+            if (component.componentId == componentId)
+            {
+                component = std::move(prefabComponent);
+            }
+        }
+        return *this;
+    }
+    signature.set(componentId);
+    components.push_back(std::move(prefabComponent));
+    return *this;
+}
+
+template <typename TComponent>
+void Registry::RemoveComponent(Entity entity)
+{
+    const auto componentId = Component<TComponent>::GetId();
+    const auto entityId = entity.GetId();
+    ECS_CHECK(entity.GetRegistryIndex() == registryIndex && entityId < static_cast<int>(entityComponentSignatures.size()), "Entity of another registry or past its entities");
+    ECS_CHECK(IsAlive(entity), "Stale entity handle, its entity was killed");
+
+    // The component data is dropped in the next Update(), once the entity has left the systems that need it
+    entityComponentSignatures[entityId].set(componentId, false);
+    commandBuffer.removedComponents.push_back({entityId, componentId});
+
+    LOGGER_DEBUG("Component id = {} was removed from entity id {}!", componentId, entityId);
+}
+
+template <typename TComponent>
+void ThreadCommandBuffer::AddRecordedComponent(Registry& registry, Entity entity, const void* component)
+{
+    registry.AddComponent<TComponent>(entity, *static_cast<const TComponent*>(component));
+}
+
+template <typename TComponent>
+void ThreadCommandBuffer::RemoveRecordedComponent(Registry& registry, Entity entity, const void* component)
+{
+    registry.RemoveComponent<TComponent>(entity);
+}
+
+template <typename TComponent, typename ...TArgs>
+void ThreadCommandBuffer::RecordAddComponent(Entity entity, int deferredIndex, TArgs&& ...args)
+{
+    static_assert(std::is_trivially_copyable<TComponent>::value, "Components are recorded as bytes, hold handles rather than pointers or strings");
+    static_assert(alignof(TComponent) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "The component data is only aligned as new aligns it");
+    const size_t dataOffset = (componentData.size() + alignof(TComponent) - 1) / alignof(TComponent) * alignof(TComponent);
+    componentData.resize(dataOffset + sizeof(TComponent));
+    new (componentData.data() + dataOffset) TComponent(std::forward<TArgs>(args)...);
+    commands.push_back({COMMAND_APPLY_COMPONENT, entity, deferredIndex, dataOffset, &AddRecordedComponent<TComponent>, GetCurrentEventOrder()});
+}
+
+template <typename TComponent, typename ...TArgs>
+void ThreadCommandBuffer::AddComponent(Entity entity, TArgs&& ...args)
+{
+    RecordAddComponent<TComponent>(entity, -1, std::forward<TArgs>(args)...);
+}
+
+template <typename TComponent, typename ...TArgs>
+void ThreadCommandBuffer::AddComponent(DeferredEntity entity, TArgs&& ...args)
+{
+    RecordAddComponent<TComponent>(Entity(0, 0, 0), entity.index, std::forward<TArgs>(args)...);
+}
+
+template <typename TComponent>
+void ThreadCommandBuffer::RemoveComponent(Entity entity)
+{
+    commands.push_back({COMMAND_APPLY_COMPONENT, entity, -1, 0, &RemoveRecordedComponent<TComponent>, GetCurrentEventOrder()});
+}
+
+template <typename TComponent>
+bool Registry::HasComponent(Entity entity) const
+{
+    const auto componentId = Component<TComponent>::GetId();
+    const auto entiyId = entity.GetId();
+    ECS_CHECK(entity.GetRegistryIndex() == registryIndex && entiyId < static_cast<int>(entityComponentSignatures.size()), "Entity of another registry or past its entities");
+
+    return entityComponentSignatures[entiyId].test(componentId);
+}
+
+template <typename TComponent>
+TComponent& Registry::GetComponent(Entity entity) const
+{
+    const auto componentId = Component<TComponent>::GetId();
+    const auto entiyId = entity.GetId();
+    ECS_CHECK(entity.GetRegistryIndex() == registryIndex && entiyId < static_cast<int>(entityComponentSignatures.size()), "Entity of another registry or past its entities");
+    ECS_CHECK(IsAlive(entity), "Stale entity handle, its entity was killed");
+    ECS_CHECK(entityComponentSignatures[entiyId].test(componentId), "Entity without the component");
+
+    if (storageMode == STORAGE_ARCHETYPE)
+    {
+        return archetypeStorage->GetComponent<TComponent>(entiyId, componentId);
+    }
+
+    ECS_CHECK(GetPool<TComponent>(), "No pool for the component");
+    return GetPool<TComponent>()->Get(entiyId);
+}
+
+template <typename TComponent>
+void Registry::TrackChanges()
+{
+    const auto componentId = Component<TComponent>::GetId();
+    if (componentId >= static_cast<int>(componentChanges.size()))
+    {
+        componentChanges.resize(componentId + 1);
+    }
+    if (!componentChanges[componentId])
+    {
+        componentChanges[componentId] = std::make_unique<ComponentChanges>();
+        componentChanges[componentId]->isChanged.resize(entityComponentSignatures.size(), 0);
+    }
+}
+
+template <typename TResource, typename ...TArgs>
+TResource& Registry::SetResource(TArgs&& ...args)
+{
+    auto& resource = resources[Resource<TResource>::GetId()];
+    if (resource)
+    {
+        *static_cast<TResource*>(resource.get()) = TResource(std::forward<TArgs>(args)...);
+    }
+    else
+    {
+        resource = std::make_shared<TResource>(std::forward<TArgs>(args)...);
+    }
+    resourceVersions[Resource<TResource>::GetId()]++;
+    return *static_cast<TResource*>(resource.get());
+}
+
+template <typename TResource>
+bool Registry::HasResource() const
+{
+    return resources[Resource<TResource>::GetId()] != nullptr;
+}
+
+template <typename TResource>
+TResource& Registry::GetResource() const
+{
+    return *static_cast<TResource*>(resources[Resource<TResource>::GetId()].get());
+}
+
+template <typename TResource>
+TResource& Registry::PatchResource()
+{
+    resourceVersions[Resource<TResource>::GetId()]++;
+    return GetResource<TResource>();
+}
+
+template <typename TResource>
+void Registry::RemoveResource()
+{
+    resources[Resource<TResource>::GetId()].reset();
+    resourceVersions[Resource<TResource>::GetId()]++;
+}
+
+template <typename TResource>
+uint32_t Registry::GetResourceVersion() const
+{
+    return resourceVersions[Resource<TResource>::GetId()];
+}
+
+template <typename TComponent>
+void Registry::ObserveComponent(ComponentObserver onAdded, ComponentObserver onRemoved)
+{
+    ObserveComponent(Component<TComponent>::GetId(), std::move(onAdded), std::move(onRemoved));
+}
+
+template <typename TComponent>
+TComponent& Registry::PatchComponent(Entity entity)
+{
+    TComponent& component = GetComponent<TComponent>(entity);
+    MarkChanged(Component<TComponent>::GetId(), entity.GetId());
+    return component;
+}
+
+template <typename TComponent>
+void Registry::MarkComponentChanged(int entityId)
+{
+    MarkChanged(Component<TComponent>::GetId(), entityId);
+}
+
+inline void Registry::MarkChanged(int componentId, int entityId)
+{
+    if (componentId < static_cast<int>(componentChanges.size()) && componentChanges[componentId])
+    {
+        componentChanges[componentId]->isChanged[entityId] = 1;
+    }
+}
+
+template <typename TComponent>
+bool Registry::GetChangedEntities(uint32_t sinceVersion, std::vector<Entity>& entities) const
+{
+    const auto componentId = Component<TComponent>::GetId();
+    if (componentId >= static_cast<int>(componentChanges.size()) || !componentChanges[componentId] || changeVersion - sinceVersion > CHANGE_HISTORY_LENGTH)
+    {
+        return false;
+    }
+    const auto& history = componentChanges[componentId]->history;
+    for (uint32_t version = sinceVersion; version != changeVersion; version++)
+    {
+        const auto& changed = history[version % CHANGE_HISTORY_LENGTH];
+        entities.insert(entities.end(), changed.begin(), changed.end());
+    }
+    return true;
+}
+
+template <typename TComponent>
+Pool<TComponent>* Registry::GetPool() const
+{
+    const auto componentId = Component<TComponent>::GetId();
+    if (componentId >= static_cast<int>(componentPools.size()))
+    {
+        return nullptr;
+    }
+    return static_cast<Pool<TComponent>*>(componentPools[componentId].get());
+}
+
+template <typename TComponent>
+Pool<TComponent>* Registry::GetOrCreatePool()
+{
+    const auto componentId = Component<TComponent>::GetId();
+
+    // If the component id is greater than the current size of the componentPools, the resize the vector
+    if (componentId >= static_cast<int>(componentPools.size()))
+    {
+        componentPools.resize(componentId + 1, nullptr);
+    }
+
+    // If we still don't have a Pool for that component type
+    if (!componentPools[componentId])
+    {
+        componentPools[componentId] = std::allocate_shared<Pool<TComponent>>(PoolAllocator<Pool<TComponent>>(), poolReserve);
+    }
+    return static_cast<Pool<TComponent>*>(componentPools[componentId].get());
+}
+
+template <typename TComponent>
+void Registry::Reserve(int capacity)
+{
+    if (storageMode == STORAGE_POOL)
+    {
+        GetOrCreatePool<TComponent>()->Reserve(capacity);
+    }
+}
+
+template <typename TComponent>
+void Registry::InsertBulk(const Entity* entities, const TComponent* components, int count)
+{
+    const auto componentId = Component<TComponent>::GetId();
+    for (int i = 0; i < count; i++)
+    {
+        ECS_CHECK(entities[i].GetRegistryIndex() == registryIndex && entities[i].GetId() < static_cast<int>(entityComponentSignatures.size()), "Entity of another registry or past its entities");
+        ECS_CHECK(IsAlive(entities[i]), "Stale entity handle, its entity was killed");
+    }
+    if (storageMode == STORAGE_ARCHETYPE)
+    {
+        // Each entity moves to the archetype of its new signature on its own
+        for (int i = 0; i < count; i++)
+        {
+            archetypeStorage->AddComponent<TComponent>(entities[i].GetId(), componentId, components[i]);
+        }
+    }
+    else
+    {
+        GetOrCreatePool<TComponent>()->Insert(entities, components, count);
+        if (owningGroupPerComponent[componentId] != -1)
+        {
+            for (int i = 0; i < count; i++)
+            {
+                JoinOwningGroup(entities[i].GetId(), componentId);
+            }
+        }
+    }
+    commandBuffer.addedComponents.reserve(commandBuffer.addedComponents.size() + count);
+    for (int i = 0; i < count; i++)
+    {
+        const int entityId = entities[i].GetId();
+        entityComponentSignatures[entityId].set(componentId);
+        commandBuffer.addedComponents.push_back({entityId, componentId});
+        MarkChanged(componentId, entityId);
+    }
+
+    LOGGER_DEBUG("Component id = {} was added to {} entities!", componentId, count);
+}
+
+template <typename TComponent>
+void Registry::InsertBulk(const std::vector<Entity>& entities, const std::vector<TComponent>& components)
+{
+    InsertBulk<TComponent>(entities.data(), components.data(), static_cast<int>(std::min(entities.size(), components.size())));
+}
+
+template <typename TComponent>
+void Registry::PatchBulk(const Entity* entities, const TComponent* components, int count)
+{
+    const auto componentId = Component<TComponent>::GetId();
+    if (storageMode == STORAGE_ARCHETYPE)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            GetComponent<TComponent>(entities[i]) = components[i];
+            MarkChanged(componentId, entities[i].GetId());
+        }
+        return;
+    }
+    Pool<TComponent>* pool = GetPool<TComponent>();
+    ECS_CHECK(pool || count == 0, "No pool for the component");
+    for (int i = 0; i < count; i++)
+    {
+        const int entityId = entities[i].GetId();
+        ECS_CHECK(entities[i].GetRegistryIndex() == registryIndex && entityId < static_cast<int>(entityComponentSignatures.size()), "Entity of another registry or past its entities");
+        ECS_CHECK(IsAlive(entities[i]), "Stale entity handle, its entity was killed");
+        pool->Get(entityId) = components[i];
+        MarkChanged(componentId, entityId);
+    }
+}
+
+template <typename ...TComponents>
+ComponentView<TComponents...> Registry::View()
+{
+    return ComponentView<TComponents...>(this);
+}
+
+template <typename ...TComponents>
+void Registry::AddOwningGroup()
+{
+    static_assert(sizeof...(TComponents) >= 2, "An owning group packs two components or more");
+    if (storageMode == STORAGE_POOL)
+    {
+        (GetOrCreatePool<TComponents>(), ...);
+        AddOwningGroup(MakeSignature<TComponents...>());
+    }
+}
+
+template <typename ...TComponents>
+template <typename TFunc>
+void ComponentView<TComponents...>::Each(TFunc func) const
+{
+    const Signature signature = MakeSignature<TComponents...>();
+
+    auto invoke = [&func](Entity entity, TComponents& ...components)
+    {
+        if constexpr (std::is_invocable_v<TFunc, Entity, TComponents&...>)
+        {
+            func(entity, components...);
+        }
+        else
+        {
+            func(components...);
+        }
+    };
+
+    if (registry->storageMode == STORAGE_ARCHETYPE)
+    {
+        // Removed components keep their chunk until the next Update(), so only check
+        // the entity signatures when some removals are still pending
+        const bool hasPendingRemovals = !registry->commandBuffer.removedComponents.empty();
+
+        // Stream the chunk columns of every archetype that contains the components
+        for (auto archetype: registry->archetypeStorage->GetArchetypes())
+        {
+            if ((archetype->GetSignature() & signature) != signature)
+            {
+                continue;
+            }
+            for (int i = 0; i < archetype->GetNumChunks(); i++)
+            {
+                auto& chunk = archetype->GetChunk(i);
+                const int* entityIds = archetype->GetEntityIds(chunk);
+                auto columns = std::make_tuple(archetype->template GetColumn<TComponents>(chunk, Component<TComponents>::GetId())...);
+                for (int row = 0; row < chunk.count; row++)
+                {
+                    if (hasPendingRemovals && (registry->entityComponentSignatures[entityIds[row]] & signature) != signature)
+                    {
+                        continue;
+                    }
+                    invoke(registry->GetEntity(entityIds[row]), std::get<TComponents*>(columns)[row]...);
+                }
+            }
+        }
+        return;
+    }
+
+    // Resolve the pools once, and bail out if any of them doesn't exist yet
+    auto pools = std::make_tuple(registry->template GetPool<TComponents>()...);
+    const IPool* smallestPool = nullptr;
+    bool hasAllPools = true;
+    auto findSmallestPool = [&](const IPool* pool)
+    {
+        if (!pool)
+        {
+            hasAllPools = false;
+        }
+        else if (!smallestPool || pool->GetEntityIds().size() < smallestPool->GetEntityIds().size())
+        {
+            smallestPool = pool;
+        }
+    };
+    (findSmallestPool(std::get<Pool<TComponents>*>(pools)), ...);
+    if (!hasAllPools)
+    {
+        return;
+    }
+
+    // A group of exactly these components has them all at the same index of their pools
+    const int groupIndex = registry->owningGroupPerComponent[Component<std::tuple_element_t<0, std::tuple<TComponents...>>>::GetId()];
+    if (groupIndex != -1 && registry->owningGroups[groupIndex].signature == signature)
+    {
+        const bool hasPendingRemovals = !registry->commandBuffer.removedComponents.empty();
+        const auto& group = registry->owningGroups[groupIndex];
+        const auto& groupEntityIds = smallestPool->GetEntityIds();
+        for (int i = 0; i < group.size; i++)
+        {
+            const int entityId = groupEntityIds[i];
+            if (hasPendingRemovals && (registry->entityComponentSignatures[entityId] & signature) != signature)
+            {
+                continue;
+            }
+            invoke(registry->GetEntity(entityId), (*std::get<Pool<TComponents>*>(pools))[i]...);
+        }
+        return;
+    }
+
+    // Walk the dense entity ids of the smallest pool and check the other components by signature
+    const auto& entityIds = smallestPool->GetEntityIds();
+    const auto& entityComponentSignatures = registry->entityComponentSignatures;
+    for (size_t i = 0; i < entityIds.size(); i++)
+    {
+        const int entityId = entityIds[i];
+        if ((entityComponentSignatures[entityId] & signature) != signature)
+        {
+            continue;
+        }
+        invoke(registry->GetEntity(entityId), std::get<Pool<TComponents>*>(pools)->Get(entityId)...);
+    }
+}
+
+template <typename ...TComponents>
+template <typename TFunc>
+bool ComponentView<TComponents...>::EachChunk(TFunc func, const Signature& excluded) const
+{
+    if (registry->storageMode != STORAGE_ARCHETYPE)
+    {
+        return false;
+    }
+    const Signature signature = MakeSignature<TComponents...>();
+    for (auto archetype: registry->archetypeStorage->GetArchetypes())
+    {
+        if ((archetype->GetSignature() & signature) != signature || (archetype->GetSignature() & excluded).any())
+        {
+            continue;
+        }
+        for (int i = 0; i < archetype->GetNumChunks(); i++)
+        {
+            auto& chunk = archetype->GetChunk(i);
+            if (chunk.count > 0)
+            {
+                func(static_cast<const int*>(archetype->GetEntityIds(chunk)), chunk.count, archetype->template GetColumn<TComponents>(chunk, Component<TComponents>::GetId())...);
+            }
+        }
+    }
+    return true;
+}
+
+template <typename TSystem, typename ...TArgs>
+void Registry::AddSystem(TArgs&& ...args)
+{
+    std::shared_ptr<TSystem> newSystem = std::allocate_shared<TSystem>(PoolAllocator<TSystem>(), std::forward<TArgs>(args)...);
+    systems.insert(std::make_pair(std::type_index(typeid(TSystem)), newSystem));
+}
+
+template <typename TSystem>
+void Registry::RemoveSystem()
+{
+    auto system = systems.find(std::type_index(typeid(TSystem)));
+    systems.erase(system);
+}
+
+template <typename TSystem> 
+bool Registry::HasSystem() const
+{
+    return systems.find(std::type_index(typeid(TSystem))) != systems.end();
+}
+
+template <typename TSystem>
+TSystem& Registry::GetSystem() const
+{
+    auto system = systems.find(std::type_index(typeid(TSystem)));
+    return *(std::static_pointer_cast<TSystem>(system->second));
+}
+
+template <typename TSystem>
+void Registry::SetSystemEnabled(bool isEnabled)
+{
+    SetSystemEnabled(GetSystem<TSystem>(), isEnabled);
+}
+
+template <typename TWith, typename TWithout, typename TOptional>
+Query<TWith, TWithout, TOptional>& Registry::GetQuery()
+{
+    typedef Query<TWith, TWithout, TOptional> TQuery;
+    auto query = queries.find(std::type_index(typeid(TQuery)));
+    if (query != queries.end())
+    {
+        return *(std::static_pointer_cast<TQuery>(query->second));
+    }
+
+    // Match the entities as the systems last saw them, the pending ones join on the next Update()
+    std::shared_ptr<TQuery> newQuery = std::allocate_shared<TQuery>(PoolAllocator<TQuery>());
+    entitySystemPlanes.Each(newQuery->GetComponentSignature(), newQuery->GetExcludedSignature(), [this, &newQuery](int entityId)
+    {
+        newQuery->AddEntityToSystem(GetEntity(entityId));
+    });
+    queries.insert(std::make_pair(std::type_index(typeid(TQuery)), newQuery));
+    return *newQuery;
+}
+
+inline Registry* Entity::GetRegistry() const
+{
+    ECS_CHECK(Registry::registries[GetRegistryIndex()].load(std::memory_order_relaxed), "Entity of a registry that was destroyed");
+    return Registry::registries[GetRegistryIndex()].load(std::memory_order_relaxed);
+}
+
+inline Entity Registry::GetEntity(int entityId) const
+{
+    return Entity(entityId, entityVersions[entityId], registryIndex);
+}
+
+inline bool Registry::IsAlive(Entity entity) const
+{
+    const auto entityId = entity.GetId();
+    return entity.GetRegistryIndex() == registryIndex
+        && entityId < static_cast<int>(entityVersions.size())
+        && entityVersions[entityId] == entity.GetVersion();
+}
+
+template <typename TComponent, typename ...TArgs>
+void Entity::AddComponent(TArgs&& ...args)
+{
+    GetRegistry()->AddComponent<TComponent>(*this, std::forward<TArgs>(args)...);
+}
+
+template <typename TComponent>
+void Entity::RemoveComponent()
+{
+    GetRegistry()->RemoveComponent<TComponent>(*this);
+}
+
+template <typename TComponent>
+bool Entity::HasComponent() const
+{
+    return GetRegistry()->HasComponent<TComponent>(*this);
+}
+
+template <typename TComponent>
+TComponent& Entity::GetComponent() const
+{
+    return GetRegistry()->GetComponent<TComponent>(*this);
+}
+
+template <typename TComponent>
+TComponent& Entity::PatchComponent() const
 {
-    return registry->GetComponent<TComponent>(*this);
+    return GetRegistry()->PatchComponent<TComponent>(*this);
 }
 
 #endif
\ No newline at end of file
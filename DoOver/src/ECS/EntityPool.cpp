@@ -0,0 +1,59 @@
+#include "EntityPool.h"
+#include <algorithm>
+
+EntityPool::EntityPool(Registry& registry, EntityPrefab prefab, EntityPrefab park)
+    : registry(&registry), prefab(std::move(prefab)), park(std::move(park))
+{
+}
+
+Entity EntityPool::CreatePooledEntity()
+{
+    Entity entity = registry->CreateEntity();
+    prefab(entity);
+    numEntities++;
+    return entity;
+}
+
+void EntityPool::Prewarm(int numEntities)
+{
+    parkedEntities.reserve(parkedEntities.size() + numEntities);
+    for (int i = 0; i < numEntities; i++)
+    {
+        Entity entity = CreatePooledEntity();
+        park(entity);
+        parkedEntities.push_back(entity);
+    }
+}
+
+int EntityPool::PrewarmStep(int maxEntities)
+{
+    const int numToCreate = std::min(maxEntities, numOwedEntities);
+    if (numToCreate > 0)
+    {
+        Prewarm(numToCreate);
+        numOwedEntities -= numToCreate;
+    }
+    return numOwedEntities;
+}
+
+Entity EntityPool::Acquire()
+{
+    while (!parkedEntities.empty())
+    {
+        const Entity entity = parkedEntities.back();
+        parkedEntities.pop_back();
+        if (registry->IsAlive(entity))
+        {
+            return entity;
+        }
+        // Killed while parked, it isn't pooled anymore
+        numEntities--;
+    }
+    return CreatePooledEntity();
+}
+
+void EntityPool::Release(Entity entity)
+{
+    park(entity);
+    parkedEntities.push_back(entity);
+}
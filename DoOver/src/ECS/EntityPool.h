@@ -0,0 +1,54 @@
+#ifndef ENTITYPOOL_H
+#define ENTITYPOOL_H
+
+#include "ECS.h"
+#include <functional>
+#include <vector>
+
+// Entities a lazily prewarmed pool creates per step
+const int ENTITY_POOL_PREWARM_STEP = 32;
+
+// Adds the components of a pooled entity, or puts them back in their parked state
+using EntityPrefab = std::function<void(Entity entity)>;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Entity pool
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Recycles the entities of one kind instead of creating and killing them. The prefab adds
+// their components once, when they are created. A released entity is parked: its components
+// are set to values the systems skip over (no collision layer, no velocity, out of view)
+// but none is removed, so it stays in its systems and the registry has nothing to process.
+// An acquired entity keeps its parked values, the caller sets the ones it needs.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class EntityPool
+{
+private:
+    Registry* registry;
+    EntityPrefab prefab;
+    EntityPrefab park;
+    std::vector<Entity> parkedEntities;
+    int numEntities = 0;
+    // Still to be created by PrewarmStep
+    int numOwedEntities = 0;
+
+    Entity CreatePooledEntity();
+
+public:
+    EntityPool(Registry& registry, EntityPrefab prefab, EntityPrefab park);
+
+    // Creates parked entities up front, they join their systems on the next registry update
+    void Prewarm(int numEntities);
+    // The same entities, created a few at a time by PrewarmStep so loading doesn't wait for them
+    void PrewarmLazily(int numEntities) { numOwedEntities += numEntities; }
+    // Creates up to maxEntities of the ones owed, returns how many are still owed
+    int PrewarmStep(int maxEntities);
+
+    // Reuses a parked entity, or creates one from the prefab when they are all in use
+    Entity Acquire();
+    void Release(Entity entity);
+
+    int GetNumParked() const { return parkedEntities.size(); }
+    int GetNumActive() const { return numEntities - static_cast<int>(parkedEntities.size()); }
+};
+
+#endif
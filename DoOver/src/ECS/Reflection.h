@@ -0,0 +1,179 @@
+#ifndef REFLECTION_H
+#define REFLECTION_H
+
+#include "Component.h"
+#include "../AssetStore/AssetHandle.h"
+#include <glm/glm.hpp>
+#include <SDL2/SDL.h>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+enum FieldType
+{
+    FIELD_INT,
+    FIELD_UINT32,
+    FIELD_FLOAT,
+    FIELD_DOUBLE,
+    FIELD_BOOL,
+    FIELD_VEC2,
+    FIELD_RECT,
+    FIELD_COLOR,
+    // Stored as an int, named by the field's enum names when it has them
+    FIELD_ENUM,
+    // Chars up to a null, the field's size included
+    FIELD_TEXT,
+    // Handles only valid in the process that made them, remapped when a snapshot is loaded.
+    // An asset handle is an int, so its fields are declared with REFLECT_ASSET_FIELD.
+    FIELD_ASSET_HANDLE,
+    FIELD_ENTITY
+};
+
+// The field type of a C++ type, specialized for every type a component may hold
+template <typename TField, typename = void>
+struct FieldTypeOf
+{
+    static_assert(sizeof(TField) == 0, "Component field type is not reflected, add a FieldTypeOf specialization");
+};
+
+template <> struct FieldTypeOf<int> { static constexpr FieldType type = FIELD_INT; };
+template <> struct FieldTypeOf<uint32_t> { static constexpr FieldType type = FIELD_UINT32; };
+template <> struct FieldTypeOf<float> { static constexpr FieldType type = FIELD_FLOAT; };
+template <> struct FieldTypeOf<double> { static constexpr FieldType type = FIELD_DOUBLE; };
+template <> struct FieldTypeOf<bool> { static constexpr FieldType type = FIELD_BOOL; };
+template <> struct FieldTypeOf<glm::vec2> { static constexpr FieldType type = FIELD_VEC2; };
+template <> struct FieldTypeOf<SDL_Rect> { static constexpr FieldType type = FIELD_RECT; };
+template <> struct FieldTypeOf<SDL_Color> { static constexpr FieldType type = FIELD_COLOR; };
+template <size_t N> struct FieldTypeOf<char[N]> { static constexpr FieldType type = FIELD_TEXT; };
+
+template <typename TField>
+struct FieldTypeOf<TField, std::enable_if_t<std::is_enum<TField>::value>>
+{
+    static_assert(sizeof(TField) == sizeof(int), "Reflected enums are stored as ints");
+    static constexpr FieldType type = FIELD_ENUM;
+};
+
+struct FieldInfo
+{
+    const char* name;
+    // In bytes from the start of the component
+    size_t offset;
+    size_t size;
+    FieldType type;
+    // Set by the systems that own it, the tools show it but don't write it
+    bool isReadOnly;
+    // Of a FIELD_ENUM, indexed by value, a value past them is shown as a number
+    const char* const* enumNames;
+    int numEnumNames;
+};
+
+template <typename TField>
+FieldInfo MakeFieldInfo(const char* name, size_t offset, bool isReadOnly = false)
+{
+    return {name, offset, sizeof(TField), FieldTypeOf<TField>::type, isReadOnly, nullptr, 0};
+}
+
+template <typename TField>
+FieldInfo MakeAssetFieldInfo(const char* name, size_t offset)
+{
+    static_assert(std::is_same<TField, AssetHandle>::value, "Asset fields hold an AssetHandle");
+    return {name, offset, sizeof(TField), FIELD_ASSET_HANDLE, false, nullptr, 0};
+}
+
+template <typename TField, size_t N>
+FieldInfo MakeEnumFieldInfo(const char* name, size_t offset, const char* const (&enumNames)[N])
+{
+    static_assert(FieldTypeOf<TField>::type == FIELD_ENUM, "Enum names are given to enum fields");
+    return {name, offset, sizeof(TField), FIELD_ENUM, false, enumNames, static_cast<int>(N)};
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Component reflection
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The fields of a component type, declared once with REFLECT_COMPONENT right after its
+// REGISTER_COMPONENT, so the generic tools work on any component as bytes: the inspector
+// edits it field by field and the snapshots remap its handles. The fields are listed in the
+// order they are declared, and a component that can't be copied as bytes says so.
+/////////////////////////////////////////////////////////////////////////////////////////////
+struct ComponentReflection
+{
+    int componentId;
+    const char* name;
+    size_t size;
+    // Copied with memcpy, which the snapshots and the tools rely on
+    bool isTriviallyCopyable;
+    // Any asset or entity field, the loaded snapshots have nothing to remap without one
+    bool hasHandles;
+    // Its fields cover all its bytes with plain values (no padding, bool, text or handle), so
+    // two equal components have the same bytes
+    bool isPlainBytes;
+    // Only drawn, the simulation never reads it, so the world checksum leaves it out
+    bool isRenderOnly;
+    std::vector<FieldInfo> fields;
+};
+
+template <typename TComponent>
+ComponentReflection MakeComponentReflection(std::vector<FieldInfo> fields, bool isRenderOnly = false)
+{
+    ComponentReflection reflection;
+    reflection.componentId = Component<TComponent>::GetId();
+    reflection.name = ComponentTraits<TComponent>::name;
+    reflection.size = sizeof(TComponent);
+    reflection.isTriviallyCopyable = std::is_trivially_copyable<TComponent>::value;
+    reflection.hasHandles = false;
+    reflection.isRenderOnly = isRenderOnly;
+    size_t fieldsSize = 0;
+    bool hasPlainFields = true;
+    for (const auto& field: fields)
+    {
+        reflection.hasHandles |= field.type == FIELD_ASSET_HANDLE || field.type == FIELD_ENTITY;
+        hasPlainFields &= field.type != FIELD_ASSET_HANDLE && field.type != FIELD_ENTITY && field.type != FIELD_BOOL && field.type != FIELD_TEXT;
+        fieldsSize += field.size;
+    }
+    reflection.isPlainBytes = reflection.isTriviallyCopyable && hasPlainFields && fieldsSize == sizeof(TComponent);
+    reflection.fields = std::move(fields);
+    return reflection;
+}
+
+template <typename TComponent>
+struct ComponentReflectionOf
+{
+    static_assert(sizeof(TComponent) == 0, "Component type is not reflected, declare it with REFLECT_COMPONENT(Type, fields...)");
+};
+
+// Records the reflection of each component id, returns false if the id already had one
+bool RegisterComponentReflection(const ComponentReflection* reflection);
+// Null for an id no component type reflects
+const ComponentReflection* GetComponentReflection(int componentId);
+
+// The fields of REFLECT_COMPONENT, only valid inside it
+#define REFLECT_FIELD(FIELD) \
+    MakeFieldInfo<decltype(ReflectedComponent::FIELD)>(#FIELD, offsetof(ReflectedComponent, FIELD))
+#define REFLECT_READONLY_FIELD(FIELD) \
+    MakeFieldInfo<decltype(ReflectedComponent::FIELD)>(#FIELD, offsetof(ReflectedComponent, FIELD), true)
+#define REFLECT_ASSET_FIELD(FIELD) \
+    MakeAssetFieldInfo<decltype(ReflectedComponent::FIELD)>(#FIELD, offsetof(ReflectedComponent, FIELD))
+#define REFLECT_ENUM_FIELD(FIELD, NAMES) \
+    MakeEnumFieldInfo<decltype(ReflectedComponent::FIELD)>(#FIELD, offsetof(ReflectedComponent, FIELD), NAMES)
+
+#define REFLECT_COMPONENT_AS(TComponent, IS_RENDER_ONLY, ...) \
+    template <> \
+    struct ComponentReflectionOf<TComponent> \
+    { \
+        using ReflectedComponent = TComponent; \
+        static const ComponentReflection& Get() \
+        { \
+            static const ComponentReflection reflection = MakeComponentReflection<TComponent>({__VA_ARGS__}, IS_RENDER_ONLY); \
+            return reflection; \
+        } \
+    }; \
+    inline const bool TComponent##IsReflected = RegisterComponentReflection(&ComponentReflectionOf<TComponent>::Get());
+
+// e.g. REFLECT_COMPONENT(HealthComponent, REFLECT_FIELD(healthPercentage)), a tag component
+// lists no fields
+#define REFLECT_COMPONENT(TComponent, ...) REFLECT_COMPONENT_AS(TComponent, false, __VA_ARGS__)
+// Of a component only the rendering reads
+#define REFLECT_RENDER_COMPONENT(TComponent, ...) REFLECT_COMPONENT_AS(TComponent, true, __VA_ARGS__)
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef RESOURCE_H
+#define RESOURCE_H
+
+#include <bitset>
+
+const unsigned int MAX_RESOURCES = 32;
+
+// The resource types a system reads or writes, see System::ReadsResource
+typedef std::bitset<MAX_RESOURCES> ResourceSignature;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Resource
+/////////////////////////////////////////////////////////////////////////////////////////////
+// A resource is the one value of its type a registry holds for all its entities, e.g. the
+// bounds of the map or the time of the tick, set with Registry::SetResource and found in
+// O(1) by the systems. Every resource type declares a compile-time id with
+// REGISTER_RESOURCE, right after its definition, the same way the components do.
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename TResource>
+struct ResourceTraits
+{
+    static_assert(sizeof(TResource) == 0, "Resource type is not registered, declare it with REGISTER_RESOURCE(Type, id)");
+};
+
+#define REGISTER_RESOURCE(TResource, ID) \
+    template <> \
+    struct ResourceTraits<TResource> \
+    { \
+        static_assert(ID >= 0 && ID < static_cast<int>(MAX_RESOURCES), "Resource id is out of range"); \
+        static constexpr int id = ID; \
+    };
+
+// Used to get the unique id of a resource type
+template <typename TResource>
+class Resource
+{
+public:
+    static constexpr int GetId()
+    {
+        return ResourceTraits<TResource>::id;
+    }
+};
+
+#endif
@@ -3,8 +3,15 @@
 
 class Event
 {
+private:
+    bool isConsumed = false;
+
 public:
     Event() = default;
+
+    // Stops the event before the handlers with a lower priority
+    void Consume() { isConsumed = true; }
+    bool IsConsumed() const { return isConsumed; }
 };
 
-#endif
\ No newline at end of file
+#endif
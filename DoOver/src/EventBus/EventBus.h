@@ -3,107 +3,987 @@
 
 #include "../Logger/Logger.h"
 #include "Event.h"
-#include <map>
-#include <typeindex>
-#include <functional>
-#include <list>
+#include "EventOrder.h"
+#include "EventSite.h"
+#include "EventTap.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
 
-class IEventCallback 
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Event type
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Every event type gets a dense id the first time it is emitted or subscribed to, the bus
+// indexes its handler arrays with it instead of looking the type up in a map.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class IEventType
 {
-private:
-    virtual void Call(Event& e) = 0;
+protected:
+    static int Register(const char* typeName)
+    {
+        std::lock_guard<std::mutex> lock(GetNamesMutex());
+        auto& names = GetNames();
+        // Mangled by GCC and Clang (length then name), prefixed with "class " by MSVC
+        std::string name = typeName;
+        const size_t start = name.find_first_not_of("0123456789");
+        name = name.substr(start == std::string::npos ? 0 : start);
+        if (name.compare(0, 6, "class ") == 0)
+        {
+            name = name.substr(6);
+        }
+        names.push_back(name);
+        return names.size() - 1;
+    }
+
+    static std::vector<std::string>& GetNames()
+    {
+        static std::vector<std::string> names;
+        return names;
+    }
+
+    static std::mutex& GetNamesMutex()
+    {
+        static std::mutex namesMutex;
+        return namesMutex;
+    }
 
 public:
-    virtual ~IEventCallback() = default;
+    static std::string GetName(int typeId)
+    {
+        std::lock_guard<std::mutex> lock(GetNamesMutex());
+        return typeId < static_cast<int>(GetNames().size()) ? GetNames()[typeId] : "";
+    }
+};
 
-    void Execute(Event& e)
+template <typename TEvent>
+class EventType: public IEventType
+{
+public:
+    static int GetId()
     {
-        Call(e);
+        static const int id = Register(typeid(TEvent).name());
+        return id;
     }
 };
 
-template <typename TOwner, typename TEvent>
-class EventCallback: public IEventCallback
+// Event types that can be queued, queues are looked up without a lock so their table has a fixed size
+const int MAX_QUEUED_EVENT_TYPES = 64;
+// Threads that get their own queue buffer, the others share one behind a lock
+const int MAX_EVENT_QUEUE_THREADS = 32;
+// Bytes of the largest queued event, a queued event holds entity handles and ids, not copies
+// of the components, so a frame's hit lists stay packed in the queue buffers
+const size_t MAX_QUEUED_EVENT_SIZE = 32;
+
+// Dense index of the calling thread, handed out the first time it queues an event
+inline int GetEventQueueThreadIndex()
 {
-private:
-    typedef void (TOwner::*CallbackFunction)(TEvent&);
+    static std::atomic<int> nextThreadIndex = 0;
+    thread_local const int threadIndex = nextThreadIndex++;
+    return threadIndex;
+}
 
-    TOwner* ownerInstance;
-    CallbackFunction callbackFunction;
+// Handlers run from the highest priority down, in subscription order for equal priorities
+const int EVENT_PRIORITY_DEFAULT = 0;
+// Overlays that may consume input before the gameplay systems see it
+const int EVENT_PRIORITY_UI = 100;
 
-    virtual void Call(Event& e) override
+// Enough for a member function pointer of a class with single inheritance on every ABI we
+// build for, or a lambda capturing up to four pointers
+const size_t MAX_EVENT_CALLBACK_SIZE = 4 * sizeof(void*);
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Event handler
+/////////////////////////////////////////////////////////////////////////////////////////////
+// A subscriber stored by value: the owner and the member function to call on it, or a
+// lambda / free function kept in place, and a thunk that knows their types. No allocation,
+// no virtual call, handlers of the same event type sit next to each other.
+/////////////////////////////////////////////////////////////////////////////////////////////
+struct EventHandler
+{
+    void* ownerInstance = nullptr;
+    // Null once unsubscribed, the handler is removed before the next emit
+    void (*invoke)(const EventHandler& handler, Event& e) = nullptr;
+    alignas(void*) unsigned char callbackFunction[MAX_EVENT_CALLBACK_SIZE];
+    // Subscription slot of the bus that points back at this handler
+    int slot = -1;
+    int priority = EVENT_PRIORITY_DEFAULT;
+
+    template <typename TOwner, typename TEvent>
+    static void Invoke(const EventHandler& handler, Event& e)
     {
-        std::invoke(callbackFunction, ownerInstance, static_cast<TEvent&>(e));
+        // Copied out first, the callback may subscribe and move the handler array
+        void (TOwner::*callbackFunction)(TEvent&);
+        std::memcpy(&callbackFunction, handler.callbackFunction, sizeof(callbackFunction));
+        TOwner* ownerInstance = static_cast<TOwner*>(handler.ownerInstance);
+        (ownerInstance->*callbackFunction)(static_cast<TEvent&>(e));
     }
 
+    template <typename TCallback, typename TEvent>
+    static void InvokeCallback(const EventHandler& handler, Event& e)
+    {
+        // Copied out for the same reason, so a stateful lambda keeps its state behind a capture
+        alignas(TCallback) unsigned char callbackStorage[sizeof(TCallback)];
+        std::memcpy(callbackStorage, handler.callbackFunction, sizeof(TCallback));
+        (*reinterpret_cast<TCallback*>(callbackStorage))(static_cast<TEvent&>(e));
+    }
+};
+
+// Sampled emits of an event type from one site
+struct EventSiteSamples
+{
+    std::string site;
+    uint64_t numSamples;
+};
+
+struct HandlerList
+{
+    // Sorted by priority
+    std::vector<EventHandler> handlers;
+    // Subscribed while the event type was being emitted, inserted when the emit ends
+    std::vector<EventHandler> pendingHandlers;
+    // Nested emits of this event type, handlers are only moved when it is back to 0
+    int emitDepth = 0;
+    bool hasRemovedHandlers = false;
+    // Events emitted or dispatched from a queue since the bus was created
+    uint64_t numEmitted = 0;
+    // Events handed to the handlers, and the handlers called for them
+    uint64_t numDelivered = 0;
+    uint64_t numHandlerCalls = 0;
+    // Estimated from one delivery in EVENT_SAMPLE_INTERVAL, timed and counted for all of them
+    uint64_t handlerNanosecs = 0;
+    std::vector<EventSiteSamples> sites;
+
+    void AddSiteSample(const char* site)
+    {
+        const char* name = site ? site : "Unnamed";
+        for (auto& siteSamples: sites)
+        {
+            if (siteSamples.site == name)
+            {
+                siteSamples.numSamples++;
+                return;
+            }
+        }
+        sites.push_back({name, 1});
+    }
+};
+
+struct EventStats
+{
+    std::string name;
+    uint64_t numEmitted;
+    int numHandlers;
+    uint64_t numHandlerCalls;
+    // Estimated, see HandlerList
+    uint64_t handlerNanosecs;
+    // The most sampled first
+    std::vector<EventSiteSamples> sites;
+};
+
+class EventBus;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Event queue
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Queued events of one type, stored by value in one contiguous buffer per thread so the
+// emitters never contend, and handed to the handlers as a batch by DispatchQueuedEvents.
+// Dispatched in order, each event is queued with the event order of its thread and the
+// batch is sorted by it, whatever thread queued what.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class IEventQueue
+{
+public:
+    virtual ~IEventQueue() = default;
+    virtual void Dispatch(EventBus& eventBus) = 0;
+    virtual void Clear() = 0;
+    virtual size_t GetMemoryUsage() const = 0;
+};
+
+template <typename TEvent>
+class EventQueue: public IEventQueue
+{
+private:
+    std::array<std::vector<TEvent>, MAX_EVENT_QUEUE_THREADS> threadEvents;
+    std::vector<TEvent> sharedEvents;
+    std::mutex sharedEventsMutex;
+    // The sites of one event in EVENT_SAMPLE_INTERVAL, named by the bus when it dispatches
+    std::array<std::vector<const char*>, MAX_EVENT_QUEUE_THREADS> threadSites;
+    std::vector<const char*> sharedSites;
+    // [thread][i] -> event order of threadEvents[thread][i], only when dispatched in order
+    std::array<std::vector<uint64_t>, MAX_EVENT_QUEUE_THREADS> threadOrders;
+    std::vector<uint64_t> sharedOrders;
+
+    struct OrderedEvent
+    {
+        uint64_t order;
+        TEvent event;
+    };
+    // Reused by every ordered dispatch
+    std::vector<OrderedEvent> orderedEvents;
+
+    void DispatchOrdered(EventBus& eventBus, size_t typeId);
+
 public:
-    EventCallback(TOwner* ownerInstance, CallbackFunction callbackFunction)
+    virtual ~EventQueue() override = default;
+
+    template <typename ...TArgs>
+    void Push(bool isOrdered, TArgs&& ...args)
+    {
+        const int threadIndex = GetEventQueueThreadIndex();
+        // Sampled on the count of the thread's own buffer, no counter is shared between threads
+        if (threadIndex < MAX_EVENT_QUEUE_THREADS)
+        {
+            if (threadEvents[threadIndex].size() % EVENT_SAMPLE_INTERVAL == 0)
+            {
+                threadSites[threadIndex].push_back(GetCurrentEventSite());
+            }
+            threadEvents[threadIndex].emplace_back(std::forward<TArgs>(args)...);
+            if (isOrdered)
+            {
+                threadOrders[threadIndex].push_back(GetCurrentEventOrder());
+            }
+            return;
+        }
+        std::lock_guard<std::mutex> lock(sharedEventsMutex);
+        if (sharedEvents.size() % EVENT_SAMPLE_INTERVAL == 0)
+        {
+            sharedSites.push_back(GetCurrentEventSite());
+        }
+        sharedEvents.emplace_back(std::forward<TArgs>(args)...);
+        if (isOrdered)
+        {
+            sharedOrders.push_back(GetCurrentEventOrder());
+        }
+    }
+
+    // Defined after EventBus, it delivers through the bus handlers
+    virtual void Dispatch(EventBus& eventBus) override;
+
+    // Hands each buffer holding events to func(const TEvent* events, size_t count) as it is,
+    // one per thread that queued some, without consuming them
+    template <typename TFunc>
+    void ForEachBatch(TFunc&& func) const
+    {
+        for (const auto& events: threadEvents)
+        {
+            if (!events.empty())
+            {
+                func(events.data(), events.size());
+            }
+        }
+        if (!sharedEvents.empty())
+        {
+            func(sharedEvents.data(), sharedEvents.size());
+        }
+    }
+
+    virtual void Clear() override
+    {
+        for (auto& events: threadEvents)
+        {
+            events.clear();
+        }
+        sharedEvents.clear();
+        for (auto& sites: threadSites)
+        {
+            sites.clear();
+        }
+        sharedSites.clear();
+        for (auto& orders: threadOrders)
+        {
+            orders.clear();
+        }
+        sharedOrders.clear();
+    }
+
+    virtual size_t GetMemoryUsage() const override
     {
-        this->ownerInstance = ownerInstance;
-        this->callbackFunction = callbackFunction;
+        size_t numEvents = sharedEvents.capacity();
+        size_t numSites = sharedSites.capacity();
+        size_t numOrders = sharedOrders.capacity();
+        for (int i = 0; i < MAX_EVENT_QUEUE_THREADS; i++)
+        {
+            numEvents += threadEvents[i].capacity();
+            numSites += threadSites[i].capacity();
+            numOrders += threadOrders[i].capacity();
+        }
+        return numEvents * sizeof(TEvent) + numSites * sizeof(const char*) + numOrders * sizeof(uint64_t) + orderedEvents.capacity() * sizeof(OrderedEvent);
     }
+};
 
-    virtual ~EventCallback() override = default;
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Event subscription
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Returned by SubscribeToEvent, the handler stays registered as long as the subscription
+// lives, so a system that keeps it as a member is unsubscribed when it is destroyed.
+// Safe to destroy after the bus.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class EventSubscription
+{
+private:
+    std::weak_ptr<EventBus*> eventBus;
+    int slot = -1;
+    uint32_t generation = 0;
+
+    friend class EventBus;
+    EventSubscription(const std::shared_ptr<EventBus*>& eventBus, int slot, uint32_t generation)
+        : eventBus(eventBus), slot(slot), generation(generation) {}
+
+public:
+    EventSubscription() = default;
+    EventSubscription(const EventSubscription&) = delete;
+    EventSubscription& operator=(const EventSubscription&) = delete;
+    EventSubscription(EventSubscription&& other) noexcept;
+    EventSubscription& operator=(EventSubscription&& other) noexcept;
+    ~EventSubscription();
+
+    // Removes the handler from the bus, in constant time
+    void Unsubscribe();
+    bool IsSubscribed() const;
 };
 
-typedef std::list<std::unique_ptr<IEventCallback>> HandlerList;
 class EventBus
 {
 private:
-    std::map<std::type_index, std::unique_ptr<HandlerList>> subscribers;
+    struct SubscriptionSlot
+    {
+        int typeId = -1;
+        // Position of the handler in subscribers[typeId].handlers, or in pendingHandlers
+        int index = -1;
+        bool isPending = false;
+        // Bumped when the slot is freed, so stale subscriptions don't remove its next handler
+        uint32_t generation = 0;
+    };
+
+    // [event type id] -> handlers of that event type
+    std::vector<HandlerList> subscribers;
+    // [event type id] -> queued events of that type, created by the first QueueEvent
+    std::array<std::atomic<IEventQueue*>, MAX_QUEUED_EVENT_TYPES> queues = {};
+    std::vector<std::unique_ptr<IEventQueue>> ownedQueues;
+    std::mutex queuesMutex;
+    std::vector<SubscriptionSlot> slots;
+    std::vector<int> freeSlots;
+    // Subscriptions reach the bus through this, it expires with the bus
+    std::shared_ptr<EventBus*> self;
+    // The queued events are sorted by their event order before they are dispatched
+    bool isDispatchOrdered = false;
+    // Copies the selected events as they are emitted or queued, null when none is installed
+    EventTap* tap = nullptr;
+
+    friend class EventSubscription;
+    template <typename TEvent> friend class EventQueue;
+
+    bool IsSubscribed(int slot, uint32_t generation) const
+    {
+        return slot >= 0 && slot < static_cast<int>(slots.size()) && slots[slot].generation == generation && slots[slot].typeId >= 0;
+    }
+
+    void FreeSlot(int slot)
+    {
+        slots[slot].typeId = -1;
+        slots[slot].index = -1;
+        slots[slot].isPending = false;
+        slots[slot].generation++;
+        freeSlots.push_back(slot);
+    }
+
+    // Only marks the handler, so the order of the others is kept without moving them here
+    void Unsubscribe(int slot, uint32_t generation)
+    {
+        if (!IsSubscribed(slot, generation))
+        {
+            return;
+        }
+        HandlerList& handlerList = subscribers[slots[slot].typeId];
+        EventHandler& handler = slots[slot].isPending ? handlerList.pendingHandlers[slots[slot].index] : handlerList.handlers[slots[slot].index];
+        FreeSlot(slot);
+        handler.invoke = nullptr;
+        handler.slot = -1;
+        handlerList.hasRemovedHandlers = true;
+    }
+
+    EventSubscription AddHandler(int typeId, EventHandler& handler)
+    {
+        if (typeId >= static_cast<int>(subscribers.size()))
+        {
+            subscribers.resize(typeId + 1);
+        }
+
+        int slot;
+        if (freeSlots.empty())
+        {
+            slot = slots.size();
+            slots.emplace_back();
+        }
+        else
+        {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        slots[slot].typeId = typeId;
+        handler.slot = slot;
+
+        HandlerList& handlerList = subscribers[typeId];
+        if (handlerList.emitDepth > 0)
+        {
+            // Being iterated, inserting now would skip or repeat some of the handlers
+            slots[slot].index = handlerList.pendingHandlers.size();
+            slots[slot].isPending = true;
+            handlerList.pendingHandlers.push_back(handler);
+        }
+        else
+        {
+            InsertHandler(handlerList, handler);
+        }
+        return EventSubscription(self, slot, slots[slot].generation);
+    }
+
+    // After the handlers with the same or a higher priority
+    void InsertHandler(HandlerList& handlerList, const EventHandler& handler)
+    {
+        auto& handlers = handlerList.handlers;
+        size_t index = handlers.size();
+        while (index > 0 && handlers[index - 1].priority < handler.priority)
+        {
+            index--;
+        }
+        handlers.insert(handlers.begin() + index, handler);
+        for (size_t i = index; i < handlers.size(); i++)
+        {
+            slots[handlers[i].slot].index = i;
+            slots[handlers[i].slot].isPending = false;
+        }
+    }
+
+    void RemoveUnsubscribedHandlers(HandlerList& handlerList)
+    {
+        auto& handlers = handlerList.handlers;
+        size_t numKept = 0;
+        for (size_t i = 0; i < handlers.size(); i++)
+        {
+            if (handlers[i].invoke)
+            {
+                handlers[numKept] = handlers[i];
+                slots[handlers[numKept].slot].index = numKept;
+                numKept++;
+            }
+        }
+        handlers.resize(numKept);
+        handlerList.hasRemovedHandlers = false;
+    }
+
+    // Once the event type is no longer being emitted
+    void UpdateHandlers(HandlerList& handlerList)
+    {
+        if (handlerList.hasRemovedHandlers)
+        {
+            RemoveUnsubscribedHandlers(handlerList);
+        }
+        if (!handlerList.pendingHandlers.empty())
+        {
+            std::vector<EventHandler> pendingHandlers;
+            pendingHandlers.swap(handlerList.pendingHandlers);
+            for (const auto& handler: pendingHandlers)
+            {
+                if (handler.invoke)
+                {
+                    InsertHandler(handlerList, handler);
+                }
+            }
+        }
+    }
+
 public:
-    EventBus()
+    EventBus(): self(std::make_shared<EventBus*>(this))
     {
         Logger::Log("EventBus contructor called!");
     }
 
+    EventBus(const EventBus&) = delete;
+    EventBus& operator=(const EventBus&) = delete;
+
     ~EventBus()
     {
         Logger::Log("EventBus destructor called!");
     }
 
-    // Clears the subscriber list
+    // Clears the subscriber list, the handler arrays keep their capacity and the
+    // outstanding subscriptions become empty
     void Reset()
     {
-        subscribers.clear();
+        for (auto& handlerList: subscribers)
+        {
+            for (auto& handler: handlerList.handlers)
+            {
+                if (handler.invoke)
+                {
+                    FreeSlot(handler.slot);
+                    handler.invoke = nullptr;
+                    handler.slot = -1;
+                }
+            }
+            for (const auto& handler: handlerList.pendingHandlers)
+            {
+                if (handler.invoke)
+                {
+                    FreeSlot(handler.slot);
+                }
+            }
+            handlerList.pendingHandlers.clear();
+            if (handlerList.emitDepth > 0)
+            {
+                handlerList.hasRemovedHandlers = true;
+            }
+            else
+            {
+                handlerList.handlers.clear();
+            }
+        }
     }
 
     /////////////////////////////////////////////////////////////////////////////////////////////
     // Subscribe to an event type <T>
-    // In our implementation, a listener subscribes to an event
-    // Example: eventBus->SubscribeToEvent<CollisionEvent>(&Game::onCollision);
+    // In our implementation, a listener subscribes to an event until the returned
+    // subscription is destroyed or unsubscribed. Handlers with a higher priority run first
+    // and may Consume() the event to hide it from the others.
+    // Example: collisionSubscription = eventBus->SubscribeToEvent<CollisionEnterEvent>(this, &Game::onCollision);
     /////////////////////////////////////////////////////////////////////////////////////////////
     template <typename TEvent, typename TOwner>
-    void SubscribeToEvent (TOwner* ownerInstance, void (TOwner::*callbackFunction)(TEvent&))
+    [[nodiscard]] EventSubscription SubscribeToEvent(TOwner* ownerInstance, void (TOwner::*callbackFunction)(TEvent&), int priority = EVENT_PRIORITY_DEFAULT)
     {
-        if (!subscribers[typeid(TEvent)].get())
-        {
-            subscribers[typeid(TEvent)] = std::make_unique<HandlerList>();
-        }
-        auto subscriber = std::make_unique<EventCallback<TOwner, TEvent>>(ownerInstance, callbackFunction);
-        subscribers[typeid(TEvent)]->push_back(std::move(subscriber));
+        static_assert(sizeof(callbackFunction) <= MAX_EVENT_CALLBACK_SIZE, "Member function pointer does not fit in an EventHandler");
+
+        EventHandler handler;
+        handler.ownerInstance = ownerInstance;
+        handler.invoke = &EventHandler::Invoke<TOwner, TEvent>;
+        std::memcpy(handler.callbackFunction, &callbackFunction, sizeof(callbackFunction));
+        handler.priority = priority;
+        return AddHandler(EventType<TEvent>::GetId(), handler);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////
+    // Subscribe a lambda or a free function to an event type <T>
+    // The callback is stored inside the handler, so it has to be small and trivially copyable:
+    // capture pointers or references, not containers.
+    // Example: counterSubscription = eventBus->SubscribeToEvent<CollisionEnterEvent>([&numCollisions](CollisionEnterEvent&) { numCollisions++; });
+    /////////////////////////////////////////////////////////////////////////////////////////////
+    template <typename TEvent, typename TCallback>
+    [[nodiscard]] EventSubscription SubscribeToEvent(TCallback callback, int priority = EVENT_PRIORITY_DEFAULT)
+    {
+        static_assert(sizeof(TCallback) <= MAX_EVENT_CALLBACK_SIZE, "Callback captures too much to fit in an EventHandler");
+        static_assert(alignof(TCallback) <= alignof(void*), "Callback is over-aligned for an EventHandler");
+        static_assert(std::is_trivially_copyable<TCallback>::value, "Callback must be trivially copyable, capture pointers or references");
+
+        EventHandler handler;
+        handler.invoke = &EventHandler::InvokeCallback<TCallback, TEvent>;
+        std::memcpy(handler.callbackFunction, &callback, sizeof(TCallback));
+        handler.priority = priority;
+        return AddHandler(EventType<TEvent>::GetId(), handler);
     }
 
     /////////////////////////////////////////////////////////////////////////////////////////////
     // Emit an event type <T>
     // In our implementation, as soon as something emits an
-    // event we go ahead and execute all the listener callback functions
-    // Example: eventBus->EmitEvent<CollisionEvent>(player, enemy);
+    // event we go ahead and execute all the listener callback functions.
+    // The event is built once and passed to every handler, and not at all when nobody listens.
+    // Example: eventBus->EmitEvent<CollisionEnterEvent>(player, enemy);
     /////////////////////////////////////////////////////////////////////////////////////////////
     template <typename TEvent, typename ...TArgs>
     void EmitEvent(TArgs&& ...args)
     {
-        auto handlers = subscribers[typeid(TEvent)].get();
-        if (handlers)
+        const size_t typeId = EventType<TEvent>::GetId();
+        if (typeId >= subscribers.size())
+        {
+            subscribers.resize(typeId + 1);
+        }
+        if (subscribers[typeId].numEmitted++ % EVENT_SAMPLE_INTERVAL == 0)
+        {
+            subscribers[typeId].AddSiteSample(GetCurrentEventSite());
+        }
+        if (tap)
+        {
+            // Built for the tap even when nobody listens
+            TEvent event(std::forward<TArgs>(args)...);
+            tap->Record(static_cast<int>(typeId), event);
+            if (!subscribers[typeId].handlers.empty())
+            {
+                Deliver(typeId, event);
+            }
+            return;
+        }
+        if (subscribers[typeId].handlers.empty())
+        {
+            return;
+        }
+        TEvent event(std::forward<TArgs>(args)...);
+        Deliver(typeId, event);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////
+    // Queue an event type <T>
+    // The event is copied into a buffer of the calling thread and only reaches the handlers
+    // on the next DispatchQueuedEvents, so systems running in parallel can queue events
+    // without calling into each other. Queued events must be plain data.
+    // Example: eventBus->QueueEvent<CollisionEnterEvent>(player, enemy);
+    /////////////////////////////////////////////////////////////////////////////////////////////
+    template <typename TEvent, typename ...TArgs>
+    void QueueEvent(TArgs&& ...args)
+    {
+        static_assert(std::is_trivially_copyable<TEvent>::value, "Queued events are copied around as plain data");
+        static_assert(sizeof(TEvent) <= MAX_QUEUED_EVENT_SIZE, "Queued event too large, hold entity handles and ids rather than the data they name");
+
+        const int typeId = EventType<TEvent>::GetId();
+        if (typeId >= MAX_QUEUED_EVENT_TYPES)
+        {
+            Logger::Err("Too many queued event types, increase MAX_QUEUED_EVENT_TYPES");
+            return;
+        }
+        IEventQueue* queue = queues[typeId].load(std::memory_order_acquire);
+        if (!queue)
+        {
+            std::lock_guard<std::mutex> lock(queuesMutex);
+            queue = queues[typeId].load(std::memory_order_relaxed);
+            if (!queue)
+            {
+                ownedQueues.push_back(std::make_unique<EventQueue<TEvent>>());
+                queue = ownedQueues.back().get();
+                queues[typeId].store(queue, std::memory_order_release);
+            }
+        }
+        if (tap)
+        {
+            TEvent event(std::forward<TArgs>(args)...);
+            tap->Record(static_cast<int>(typeId), event);
+            static_cast<EventQueue<TEvent>*>(queue)->Push(isDispatchOrdered, event);
+            return;
+        }
+        static_cast<EventQueue<TEvent>*>(queue)->Push(isDispatchOrdered, std::forward<TArgs>(args)...);
+    }
+
+    // Copies the events of the types the tap selected from now on, null removes it. Set
+    // while nothing is emitted or queued, the bus doesn't own the tap.
+    void SetTap(EventTap* tap)
+    {
+        this->tap = tap;
+    }
+
+    EventTap* GetTap() const
+    {
+        return tap;
+    }
+
+    // Sorts the queued events of each type by their event order (see EventOrderScope) before
+    // they are dispatched, so the events the parallel systems queue reach the handlers in the
+    // same order on every run whatever the threads. Set while nothing is queued.
+    void SetOrderedDispatch(bool isOrdered)
+    {
+        isDispatchOrdered = isOrdered;
+    }
+
+    // Hands the queued events of every type to their handlers and empties the queues.
+    // Must not run while events are being queued. Events of one type keep the order they
+    // were queued in on each thread, the threads are drained one after the other, unless
+    // the dispatch is ordered.
+    void DispatchQueuedEvents()
+    {
+        for (auto& queue: queues)
+        {
+            IEventQueue* eventQueue = queue.load(std::memory_order_acquire);
+            if (eventQueue)
+            {
+                eventQueue->Dispatch(*this);
+            }
+        }
+    }
+
+    // Same, for the events of type <T> only
+    template <typename TEvent>
+    void DispatchQueuedEvents()
+    {
+        const int typeId = EventType<TEvent>::GetId();
+        IEventQueue* queue = typeId < MAX_QUEUED_EVENT_TYPES ? queues[typeId].load(std::memory_order_acquire) : nullptr;
+        if (queue)
+        {
+            queue->Dispatch(*this);
+        }
+    }
+
+    // Reads the events of type <T> queued so far in place, a contiguous buffer at a time
+    // (see EventQueue::ForEachBatch), e.g. to go over a frame's hits in one loop before they
+    // are dispatched. Not while events are being queued.
+    template <typename TEvent, typename TFunc>
+    void ForEachQueuedBatch(TFunc&& func) const
+    {
+        const int typeId = EventType<TEvent>::GetId();
+        IEventQueue* queue = typeId < MAX_QUEUED_EVENT_TYPES ? queues[typeId].load(std::memory_order_acquire) : nullptr;
+        if (queue)
+        {
+            static_cast<const EventQueue<TEvent>*>(queue)->ForEachBatch(std::forward<TFunc>(func));
+        }
+    }
+
+    // Counts and handler times of every event type emitted so far, for the debug overlay
+    void GetEventStats(std::vector<EventStats>& stats) const
+    {
+        stats.resize(subscribers.size());
+        for (int typeId = 0; typeId < static_cast<int>(subscribers.size()); typeId++)
+        {
+            const HandlerList& handlerList = subscribers[typeId];
+            int numHandlers = 0;
+            for (const auto& handler: handlerList.handlers)
+            {
+                numHandlers += handler.invoke ? 1 : 0;
+            }
+            EventStats& typeStats = stats[typeId];
+            if (typeStats.name.empty())
+            {
+                typeStats.name = IEventType::GetName(typeId);
+            }
+            typeStats.numEmitted = handlerList.numEmitted;
+            typeStats.numHandlers = numHandlers;
+            typeStats.numHandlerCalls = handlerList.numHandlerCalls;
+            typeStats.handlerNanosecs = handlerList.handlerNanosecs;
+            typeStats.sites = handlerList.sites;
+            std::sort(typeStats.sites.begin(), typeStats.sites.end(), [](const EventSiteSamples& a, const EventSiteSamples& b) { return a.numSamples > b.numSamples; });
+        }
+    }
+
+    // Without the allocations of GetEventStats, for what samples the counts every frame
+    int GetNumEventTypes() const
+    {
+        return static_cast<int>(subscribers.size());
+    }
+
+    // Emitted and queued since the start, of an event type below GetNumEventTypes
+    uint64_t GetNumEmitted(int typeId) const
+    {
+        return subscribers[typeId].numEmitted;
+    }
+
+    // Bytes held by the handlers and the event queues, for the memory budgets
+    size_t GetMemoryUsage() const
+    {
+        size_t numBytes = slots.capacity() * sizeof(SubscriptionSlot) + freeSlots.capacity() * sizeof(int);
+        for (const auto& handlerList: subscribers)
+        {
+            numBytes += (handlerList.handlers.capacity() + handlerList.pendingHandlers.capacity()) * sizeof(EventHandler);
+        }
+        for (const auto& queue: ownedQueues)
+        {
+            numBytes += queue->GetMemoryUsage();
+        }
+        return numBytes;
+    }
+
+    // Drops the queued events without delivering them, e.g. when a level is unloaded
+    void ClearQueuedEvents()
+    {
+        for (auto& queue: queues)
         {
-            for (auto it = handlers->begin(); it != handlers->end(); it++)
+            IEventQueue* eventQueue = queue.load(std::memory_order_acquire);
+            if (eventQueue)
             {
-                auto handler = it->get();
-                TEvent event(std::forward<TArgs>(args)...);
-                handler->Execute(event);
+                eventQueue->Clear();
             }
         }
     }
+
+private:
+    template <typename TEvent>
+    void Deliver(size_t typeId, TEvent& event)
+    {
+        if (subscribers[typeId].emitDepth == 0)
+        {
+            UpdateHandlers(subscribers[typeId]);
+        }
+        // Indexed, the handler array is only reordered once the outermost emit is done
+        const size_t numHandlers = subscribers[typeId].handlers.size();
+        const bool isTimed = subscribers[typeId].numDelivered++ % EVENT_SAMPLE_INTERVAL == 0;
+        const auto start = isTimed ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+        int numCalls = 0;
+        subscribers[typeId].emitDepth++;
+        for (size_t i = 0; i < numHandlers && !event.IsConsumed(); i++)
+        {
+            const EventHandler& handler = subscribers[typeId].handlers[i];
+            if (handler.invoke)
+            {
+                handler.invoke(handler, event);
+                numCalls++;
+            }
+        }
+        // Looked up again, a callback may have subscribed to a new event type
+        HandlerList& emittedList = subscribers[typeId];
+        emittedList.numHandlerCalls += numCalls;
+        if (isTimed)
+        {
+            emittedList.handlerNanosecs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() * EVENT_SAMPLE_INTERVAL;
+        }
+        emittedList.emitDepth--;
+        if (emittedList.emitDepth == 0)
+        {
+            UpdateHandlers(emittedList);
+        }
+    }
 };
 
-#endif
\ No newline at end of file
+template <typename TEvent>
+void EventQueue<TEvent>::Dispatch(EventBus& eventBus)
+{
+    const size_t typeId = EventType<TEvent>::GetId();
+    if (typeId >= eventBus.subscribers.size())
+    {
+        eventBus.subscribers.resize(typeId + 1);
+    }
+    // The sites are named now, the handlers may queue more events meanwhile
+    HandlerList& handlerList = eventBus.subscribers[typeId];
+    for (int i = 0; i < MAX_EVENT_QUEUE_THREADS; i++)
+    {
+        handlerList.numEmitted += threadEvents[i].size();
+        for (const char* site: threadSites[i])
+        {
+            handlerList.AddSiteSample(site);
+        }
+        threadSites[i].clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock(sharedEventsMutex);
+        handlerList.numEmitted += sharedEvents.size();
+        for (const char* site: sharedSites)
+        {
+            handlerList.AddSiteSample(site);
+        }
+        sharedSites.clear();
+    }
+
+    if (!eventBus.subscribers[typeId].handlers.empty() && eventBus.isDispatchOrdered)
+    {
+        DispatchOrdered(eventBus, typeId);
+        return;
+    }
+    if (!eventBus.subscribers[typeId].handlers.empty())
+    {
+        // Indexed, a handler may queue more events of this type, they are delivered on the next dispatch
+        for (auto& events: threadEvents)
+        {
+            const size_t numEvents = events.size();
+            for (size_t i = 0; i < numEvents; i++)
+            {
+                TEvent event = events[i];
+                eventBus.Deliver(typeId, event);
+            }
+            events.erase(events.begin(), events.begin() + numEvents);
+        }
+        std::vector<TEvent> events;
+        {
+            std::lock_guard<std::mutex> lock(sharedEventsMutex);
+            events.swap(sharedEvents);
+        }
+        for (auto& event: events)
+        {
+            eventBus.Deliver(typeId, event);
+        }
+        return;
+    }
+    Clear();
+}
+
+template <typename TEvent>
+void EventQueue<TEvent>::DispatchOrdered(EventBus& eventBus, size_t typeId)
+{
+    // Thread after thread, then sorted stably: the events of one order keep the order their
+    // thread queued them in
+    orderedEvents.clear();
+    for (int i = 0; i < MAX_EVENT_QUEUE_THREADS; i++)
+    {
+        for (size_t j = 0; j < threadEvents[i].size(); j++)
+        {
+            orderedEvents.push_back({j < threadOrders[i].size() ? threadOrders[i][j] : 0, threadEvents[i][j]});
+        }
+        threadEvents[i].clear();
+        threadOrders[i].clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock(sharedEventsMutex);
+        for (size_t j = 0; j < sharedEvents.size(); j++)
+        {
+            orderedEvents.push_back({j < sharedOrders.size() ? sharedOrders[j] : 0, sharedEvents[j]});
+        }
+        sharedEvents.clear();
+        sharedOrders.clear();
+    }
+    std::stable_sort(orderedEvents.begin(), orderedEvents.end(), [](const OrderedEvent& a, const OrderedEvent& b) { return a.order < b.order; });
+    // Swapped out, the handlers may queue and dispatch more events of this type meanwhile
+    std::vector<OrderedEvent> events;
+    events.swap(orderedEvents);
+    for (auto& orderedEvent: events)
+    {
+        eventBus.Deliver(typeId, orderedEvent.event);
+    }
+    events.clear();
+    orderedEvents.swap(events);
+}
+
+template <typename TEvent>
+void EventTap::ReplayEvent(EventBus& eventBus, const void* data)
+{
+    // Copied as bytes, the event type is trivially copyable
+    alignas(TEvent) unsigned char storage[sizeof(TEvent)];
+    std::memcpy(storage, data, sizeof(TEvent));
+    eventBus.EmitEvent<TEvent>(*reinterpret_cast<const TEvent*>(storage));
+}
+
+inline EventSubscription::EventSubscription(EventSubscription&& other) noexcept
+    : eventBus(std::move(other.eventBus)), slot(other.slot), generation(other.generation)
+{
+    other.slot = -1;
+}
+
+inline EventSubscription& EventSubscription::operator=(EventSubscription&& other) noexcept
+{
+    if (this != &other)
+    {
+        Unsubscribe();
+        eventBus = std::move(other.eventBus);
+        slot = other.slot;
+        generation = other.generation;
+        other.slot = -1;
+    }
+    return *this;
+}
+
+inline EventSubscription::~EventSubscription()
+{
+    Unsubscribe();
+}
+
+inline void EventSubscription::Unsubscribe()
+{
+    if (slot < 0)
+    {
+        return;
+    }
+    if (auto bus = eventBus.lock())
+    {
+        (*bus)->Unsubscribe(slot, generation);
+    }
+    eventBus.reset();
+    slot = -1;
+}
+
+inline bool EventSubscription::IsSubscribed() const
+{
+    auto bus = eventBus.lock();
+    return slot >= 0 && bus && (*bus)->IsSubscribed(slot, generation);
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef EVENTORDER_H
+#define EVENTORDER_H
+
+#include <cstdint>
+
+// What the events the calling thread queues are sorted by when the bus dispatches them in
+// order (see EventBus::SetOrderedDispatch): the place of the system in the frame in the high
+// 32 bits and 1 + the id of the entity it is on in the low ones, 0 outside the systems
+inline uint64_t& GetCurrentEventOrder()
+{
+    thread_local uint64_t order = 0;
+    return order;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Event order scope
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Sets the event order of the calling thread until the end of the scope, so the events
+// queued by the systems running in parallel come out in the same order whatever thread
+// queued them.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class EventOrderScope
+{
+private:
+    uint64_t previousOrder;
+
+public:
+    explicit EventOrderScope(uint64_t order): previousOrder(GetCurrentEventOrder())
+    {
+        GetCurrentEventOrder() = order;
+    }
+
+    ~EventOrderScope()
+    {
+        GetCurrentEventOrder() = previousOrder;
+    }
+
+    EventOrderScope(const EventOrderScope&) = delete;
+    EventOrderScope& operator=(const EventOrderScope&) = delete;
+};
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef EVENTSITE_H
+#define EVENTSITE_H
+
+// Every this many events of a type, the site that emitted it is recorded and the time its
+// handlers take is measured
+const int EVENT_SAMPLE_INTERVAL = 16;
+
+// What emits the events of the calling thread, e.g. the system the scheduler runs on it, null
+// when nothing was named
+inline const char*& GetCurrentEventSite()
+{
+    thread_local const char* site = nullptr;
+    return site;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Event site scope
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Names the emit site of the calling thread until the end of the scope, the sampled emits
+// of the event bus are attributed to it. The name must outlive the events queued meanwhile.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class EventSiteScope
+{
+private:
+    const char* previousSite;
+
+public:
+    explicit EventSiteScope(const char* site): previousSite(GetCurrentEventSite())
+    {
+        GetCurrentEventSite() = site;
+    }
+
+    ~EventSiteScope()
+    {
+        GetCurrentEventSite() = previousSite;
+    }
+
+    EventSiteScope(const EventSiteScope&) = delete;
+    EventSiteScope& operator=(const EventSiteScope&) = delete;
+};
+
+#endif
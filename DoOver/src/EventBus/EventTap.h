@@ -0,0 +1,145 @@
+#ifndef EVENTTAP_H
+#define EVENTTAP_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+class EventBus;
+template <typename TEvent> class EventType;
+
+// Events kept by default, the oldest ones are overwritten past it
+const int EVENT_TAP_DEFAULT_CAPACITY = 64 * 1024;
+// Bytes of the largest event a tap copies
+const size_t EVENT_TAP_MAX_EVENT_SIZE = 64;
+// Event type ids a tap can select
+const int MAX_EVENT_TAP_TYPES = 256;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Event tap
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Installed on an EventBus (EventBus::SetTap), copies the events of the selected types into
+// a ring as they are emitted or queued, from any thread: a writer claims a slot with one
+// atomic add and publishes it with its sequence number, nothing locks. When the ring is
+// full the oldest events are overwritten, so it holds the last moments before a spike.
+// Replay emits what the ring holds into another bus, oldest first, to reproduce a heavy
+// frame offline. Only plain events are copied, the entities they name are handles into a
+// registry the replayed handlers must still have.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class EventTap
+{
+private:
+    struct alignas(64) Slot
+    {
+        // Of the event in the slot plus one, 0 while it is being written
+        std::atomic<uint64_t> sequence{0};
+        int typeId = -1;
+        alignas(16) unsigned char data[EVENT_TAP_MAX_EVENT_SIZE];
+    };
+
+    using ReplayFunction = void (*)(EventBus& eventBus, const void* data);
+
+    std::unique_ptr<Slot[]> slots;
+    uint64_t capacity;
+    std::atomic<uint64_t> nextIndex{0};
+    // [event type id] -> emits a copied event of the type, null when the type isn't selected
+    std::array<ReplayFunction, MAX_EVENT_TAP_TYPES> replayFunctions = {};
+
+    // Defined after EventBus, it emits through the bus
+    template <typename TEvent> static void ReplayEvent(EventBus& eventBus, const void* data);
+
+public:
+    explicit EventTap(int capacity = EVENT_TAP_DEFAULT_CAPACITY)
+        : slots(new Slot[capacity]), capacity(static_cast<uint64_t>(capacity)) {}
+
+    EventTap(const EventTap&) = delete;
+    EventTap& operator=(const EventTap&) = delete;
+
+    // Before the tap is installed, the bus reads the selection without a lock
+    template <typename TEvent>
+    void Select()
+    {
+        static_assert(std::is_trivially_copyable<TEvent>::value, "Tapped events are copied as plain data");
+        static_assert(sizeof(TEvent) <= EVENT_TAP_MAX_EVENT_SIZE, "Event too large for a tap slot, increase EVENT_TAP_MAX_EVENT_SIZE");
+        const int typeId = EventType<TEvent>::GetId();
+        if (typeId < MAX_EVENT_TAP_TYPES)
+        {
+            replayFunctions[typeId] = &ReplayEvent<TEvent>;
+        }
+    }
+
+    bool IsSelected(int typeId) const
+    {
+        return typeId < MAX_EVENT_TAP_TYPES && replayFunctions[typeId];
+    }
+
+    // Called by the bus, for the selected types only
+    template <typename TEvent>
+    void Record(int typeId, const TEvent& event)
+    {
+        if constexpr (std::is_trivially_copyable<TEvent>::value && sizeof(TEvent) <= EVENT_TAP_MAX_EVENT_SIZE)
+        {
+            if (!IsSelected(typeId))
+            {
+                return;
+            }
+            const uint64_t index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+            Slot& slot = slots[index % capacity];
+            slot.sequence.store(0, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            slot.typeId = typeId;
+            std::memcpy(slot.data, &event, sizeof(TEvent));
+            slot.sequence.store(index + 1, std::memory_order_release);
+        }
+    }
+
+    // Emits the events the ring holds into the bus, oldest first, and returns how many.
+    // Not while events are being recorded, a slot still being written is skipped.
+    int Replay(EventBus& eventBus) const
+    {
+        const uint64_t end = nextIndex.load(std::memory_order_acquire);
+        const uint64_t begin = end > capacity ? end - capacity : 0;
+        int numReplayed = 0;
+        alignas(16) unsigned char data[EVENT_TAP_MAX_EVENT_SIZE];
+        for (uint64_t index = begin; index < end; index++)
+        {
+            const Slot& slot = slots[index % capacity];
+            if (slot.sequence.load(std::memory_order_acquire) != index + 1)
+            {
+                continue;
+            }
+            const int typeId = slot.typeId;
+            std::memcpy(data, slot.data, sizeof(data));
+            replayFunctions[typeId](eventBus, data);
+            numReplayed++;
+        }
+        return numReplayed;
+    }
+
+    void Clear()
+    {
+        nextIndex.store(0, std::memory_order_relaxed);
+        for (uint64_t i = 0; i < capacity; i++)
+        {
+            slots[i].sequence.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Since the last Clear, the overwritten ones included
+    uint64_t GetNumRecorded() const
+    {
+        return nextIndex.load(std::memory_order_relaxed);
+    }
+
+    uint64_t GetNumOverwritten() const
+    {
+        const uint64_t numRecorded = GetNumRecorded();
+        return numRecorded > capacity ? numRecorded - capacity : 0;
+    }
+};
+
+#endif
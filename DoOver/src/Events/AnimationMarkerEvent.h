@@ -0,0 +1,22 @@
+#ifndef ANIMATIONMARKEREVENT_H
+#define ANIMATIONMARKEREVENT_H
+
+#include "../ECS/ECS.h"
+#include "../EventBus/Event.h"
+#include "../EventBus/EventBus.h"
+#include <type_traits>
+
+// An animation started a frame with a marker, e.g. the frame a footstep lands on
+class AnimationMarkerEvent: public Event
+{
+public:
+    Entity entity;
+    int clip;
+    int frame;
+    int marker;
+    AnimationMarkerEvent(Entity entity, int clip, int frame, int marker): entity(entity), clip(clip), frame(frame), marker(marker) {}
+};
+
+static_assert(std::is_trivially_copyable<AnimationMarkerEvent>::value && sizeof(AnimationMarkerEvent) <= MAX_QUEUED_EVENT_SIZE, "AnimationMarkerEvent is queued as plain data");
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef COLLISIONENTEREVENT_H
+#define COLLISIONENTEREVENT_H
+
+#include "../ECS/ECS.h"
+#include "../EventBus/Event.h"
+#include "../EventBus/EventBus.h"
+#include <type_traits>
+
+// Two colliders started overlapping this frame
+class CollisionEnterEvent: public Event
+{
+public:
+    Entity a;
+    Entity b;
+    CollisionEnterEvent(Entity a, Entity b): a(a), b(b) {}
+};
+
+static_assert(std::is_trivially_copyable<CollisionEnterEvent>::value && sizeof(CollisionEnterEvent) <= MAX_QUEUED_EVENT_SIZE, "CollisionEnterEvent is queued as plain data");
+
+#endif
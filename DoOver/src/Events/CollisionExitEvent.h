@@ -0,0 +1,20 @@
+#ifndef COLLISIONEXITEVENT_H
+#define COLLISIONEXITEVENT_H
+
+#include "../ECS/ECS.h"
+#include "../EventBus/Event.h"
+#include "../EventBus/EventBus.h"
+#include <type_traits>
+
+// Two colliders stopped overlapping this frame, either entity may have been killed
+class CollisionExitEvent: public Event
+{
+public:
+    Entity a;
+    Entity b;
+    CollisionExitEvent(Entity a, Entity b): a(a), b(b) {}
+};
+
+static_assert(std::is_trivially_copyable<CollisionExitEvent>::value && sizeof(CollisionExitEvent) <= MAX_QUEUED_EVENT_SIZE, "CollisionExitEvent is queued as plain data");
+
+#endif
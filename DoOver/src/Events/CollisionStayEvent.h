@@ -0,0 +1,20 @@
+#ifndef COLLISIONSTAYEVENT_H
+#define COLLISIONSTAYEVENT_H
+
+#include "../ECS/ECS.h"
+#include "../EventBus/Event.h"
+#include "../EventBus/EventBus.h"
+#include <type_traits>
+
+// Two colliders are still overlapping, only emitted when the collision system is asked to
+class CollisionStayEvent: public Event
+{
+public:
+    Entity a;
+    Entity b;
+    CollisionStayEvent(Entity a, Entity b): a(a), b(b) {}
+};
+
+static_assert(std::is_trivially_copyable<CollisionStayEvent>::value && sizeof(CollisionStayEvent) <= MAX_QUEUED_EVENT_SIZE, "CollisionStayEvent is queued as plain data");
+
+#endif
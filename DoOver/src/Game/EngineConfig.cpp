@@ -0,0 +1,81 @@
+#include "EngineConfig.h"
+#include <sol/sol.hpp>
+#include <fstream>
+
+static bool GetLogLevel(const std::string& name, LogType& level)
+{
+    if (name == "trace") level = LOG_TRACE;
+    else if (name == "debug") level = LOG_DEBUG;
+    else if (name == "info") level = LOG_INFO;
+    else if (name == "warning") level = LOG_WARNING;
+    else if (name == "error") level = LOG_ERROR;
+    else return false;
+    return true;
+}
+
+bool EngineConfig::Load(const std::string& filePath, EngineConfig& config)
+{
+    if (!std::ifstream(filePath).good())
+    {
+        return false;
+    }
+
+    // The config only describes data, like the levels
+    sol::state lua;
+    lua.open_libraries(sol::lib::base, sol::lib::math);
+    sol::protected_function_result result = lua.safe_script_file(filePath, sol::script_pass_on_error);
+    if (!result.valid())
+    {
+        sol::error error = result;
+        Logger::Err("Error loading the engine config " + filePath + ": " + error.what());
+        return false;
+    }
+    sol::optional<sol::table> table = lua["Config"];
+    if (!table)
+    {
+        Logger::Err("The engine config " + filePath + " defines no Config table");
+        return false;
+    }
+
+    config.tickRate = table->get_or("tick_rate", config.tickRate);
+    config.numWorkers = table->get_or("workers", config.numWorkers);
+    config.isWorkerPinned = table->get_or("pin_workers", config.isWorkerPinned);
+    config.broadphaseCellSize = table->get_or("broadphase_cell_size", config.broadphaseCellSize);
+    config.isBroadphaseAutoTuned = table->get_or("broadphase_autotune", config.isBroadphaseAutoTuned);
+    config.spatialSortSeconds = table->get_or("spatial_sort_seconds", config.spatialSortSeconds);
+    config.poolReserve = table->get_or("pool_reserve", config.poolReserve);
+    config.textureStreamBudget = table->get_or("texture_stream_budget", config.textureStreamBudget);
+    config.targetFps = table->get_or("fps", config.targetFps);
+    config.isFullscreen = table->get_or("fullscreen", config.isFullscreen);
+    config.windowWidth = table->get_or("window_width", config.windowWidth);
+    config.windowHeight = table->get_or("window_height", config.windowHeight);
+    config.renderHeight = table->get_or("render_height", config.renderHeight);
+    config.isDynamicResolution = table->get_or("dynamic_resolution", config.isDynamicResolution);
+    config.isTilemapDirect = table->get_or("direct_tilemap", config.isTilemapDirect);
+    config.isFramePipelined = table->get_or("pipeline_frames", config.isFramePipelined);
+    config.isDeterministic = table->get_or("deterministic", config.isDeterministic);
+    config.flightRecorderFile = table->get_or("flight_recorder", config.flightRecorderFile);
+    if (sol::optional<std::string> logLevel = table->get<sol::optional<std::string>>("log_level"))
+    {
+        if (!GetLogLevel(*logLevel, config.logLevel))
+        {
+            Logger::Err("Unknown log level " + *logLevel + " in " + filePath);
+        }
+    }
+    if (sol::optional<std::string> renderer = table->get<sol::optional<std::string>>("renderer"))
+    {
+        if (!RenderBackend::FindType(*renderer, config.renderBackendType))
+        {
+            Logger::Err("Unknown renderer " + *renderer + " in " + filePath);
+        }
+    }
+    if (sol::optional<std::string> present = table->get<sol::optional<std::string>>("present"))
+    {
+        if (!FramePacer::FindPresentMode(*present, config.presentMode))
+        {
+            Logger::Err("Unknown present mode " + *present + " in " + filePath);
+        }
+    }
+    Logger::Log("Engine config loaded from " + filePath);
+    return true;
+}
@@ -0,0 +1,73 @@
+#ifndef ENGINECONFIG_H
+#define ENGINECONFIG_H
+
+#include "../AssetStore/AssetStore.h"
+#include "../Clock/FramePacer.h"
+#include "../ECS/ECS.h"
+#include "../Logger/Logger.h"
+#include "../Physics/Broadphase.h"
+#include "../Profiler/FlightRecorder.h"
+#include "../Renderer/RenderBackend.h"
+#include "../Renderer/ResolutionScaler.h"
+#include "../Systems/SpatialSortSystem.h"
+#include <string>
+
+// Read at startup when it exists, see the file for the knobs
+const std::string ENGINE_CONFIG_FILE = "./config.lua";
+// Of the window when it isn't fullscreen
+const int DEFAULT_WINDOW_WIDTH = 1280;
+const int DEFAULT_WINDOW_HEIGHT = 720;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Engine config
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The performance knobs tuned per machine, read from a Lua file defining a global Config
+// table. A knob the file leaves out keeps the default below, the command line flags
+// override the file.
+/////////////////////////////////////////////////////////////////////////////////////////////
+struct EngineConfig
+{
+    // 0 keeps SIMULATION_TICKS_PER_SECOND
+    int tickRate = 0;
+    // 0 keeps one core for the main thread, see JobSystem::DefaultNumWorkers
+    int numWorkers = 0;
+    // One core per worker, away from the main thread's, so they keep their caches
+    bool isWorkerPinned = false;
+    // Of the spatial hash of the moving colliders, in world pixels
+    int broadphaseCellSize = DEFAULT_CELL_SIZE;
+    // The cell size, or sweep and prune, follows the boxes seen at runtime
+    bool isBroadphaseAutoTuned = true;
+    // Seconds of simulation between two sorts of the components by position, 0 for none
+    double spatialSortSeconds = SPATIAL_SORT_DEFAULT_SECONDS;
+    // Components each pool has room for before it grows
+    int poolReserve = POOL_DEFAULT_RESERVE;
+    // Video memory of the streamed textures' whole images, in megabytes
+    int textureStreamBudget = DEFAULT_TEXTURE_STREAM_BUDGET_MB;
+    // Raised to the lowest level compiled in
+    LogType logLevel = LOG_TRACE;
+    RenderBackendType renderBackendType = RENDER_BACKEND_AUTO;
+    PresentMode presentMode = PRESENT_MODE_VSYNC;
+    int targetFps = DEFAULT_TARGET_FPS;
+    bool isFullscreen = true;
+    int windowWidth = DEFAULT_WINDOW_WIDTH;
+    int windowHeight = DEFAULT_WINDOW_HEIGHT;
+    // The frames of a taller window are drawn at this height, 0 for the window's
+    int renderHeight = DEFAULT_RENDER_HEIGHT;
+    bool isDynamicResolution = false;
+    // The tiles on screen drawn from the tileset in one batch, no chunk textures baked
+    bool isTilemapDirect = false;
+    // The simulation of the next frame runs while this one is submitted, which shows each
+    // frame one frame later
+    bool isFramePipelined = true;
+    // The parallel systems give the same results whatever the number of workers, and the
+    // recordings check each tick replays the same
+    bool isDeterministic = false;
+    // Written with the last frames on a crash, empty for none
+    std::string flightRecorderFile = FLIGHT_RECORDER_DEFAULT_FILE;
+
+    // Errors are logged, the knobs read before an error are kept. False when the file is
+    // missing or isn't valid.
+    static bool Load(const std::string& filePath, EngineConfig& config);
+};
+
+#endif
@@ -1,5 +1,9 @@
 #include "Game.h"
 #include "../Logger/Logger.h"
+#include "../Trace/EventTrace.h"
+#include "../Level/LevelLoader.h"
+#include "../Profiler/Profiler.h"
+#include "../Profiler/FlightRecorder.h"
 #include "../ECS/ECS.h"
 #include "../Components/TransformComponent.h"
 #include "../Components/RigidBodyComponent.h"
@@ -10,34 +14,141 @@
 #include "../Components/CameraFollowComponent.h"
 #include "../Components/ProjectileEmitterComponent.h"
 #include "../Components/HealthComponent.h"
+#include "../Components/HierarchyComponent.h"
+#include "../Components/TextLabelComponent.h"
+#include "../Events/KeyPressedEvent.h"
 #include "../Systems/MovementSystem.h"
+#include "../Systems/HierarchySystem.h"
 #include "../Systems/CameraMovementSystem.h"
 #include "../Systems/RenderSystem.h"
 #include "../Systems/AnimationSystem.h"
+#include "../Systems/ActivitySystem.h"
+#include "../Systems/InterestSystem.h"
 #include "../Systems/CollisonSystem.h"
 #include "../Systems/RenderColliderSystem.h"
+#include "../Systems/RenderTextSystem.h"
+#include "../Systems/RenderHealthBarSystem.h"
 #include "../Systems/DamageSystem.h"
+#include "../Systems/DeathSystem.h"
+#include "../Systems/CollisionResponseSystem.h"
 #include "../Systems/ProjectileEmitSystem.h"
 #include "../Systems/KeyboardControlSystem.h"
+#include "../Systems/DirectionalSpriteSystem.h"
+#include "../Systems/VisionSystem.h"
 #include "../Systems/ProjectileLifecycleSystem.h"
+#include "../Systems/ScriptSystem.h"
+#include "../Systems/NavigationSystem.h"
+#include "../Systems/FlowFieldSystem.h"
+#include "../Systems/AISystem.h"
+#include "../Systems/SpatialSortSystem.h"
+#include "../Resources/MapBoundsResource.h"
+#include "../Resources/TickTimeResource.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
+#include <SDL2/SDL_ttf.h>
 #include <glm/glm.hpp>
+#include <imgui/imgui.h>
+#include <imgui/imgui_sdl.h>
 #include <iostream>
+#include <algorithm>
+#include <chrono>
 #include <fstream>
+#include <iterator>
+#include <cmath>
+#include <cstring>
+
+struct Game::LevelPrefetch
+{
+	int level = 0;
+	LevelData levelData;
+	// [texture of the level] -> its decoded image, none headless
+	std::vector<SDL_Surface*> surfaces;
+	// [script of the level] -> its compiled chunk, empty when it didn't compile
+	std::vector<std::string> scriptChunks;
+};
+
+// The level file, or its cache next to it
+static std::string GetLevelFilePath(int level, const std::string& extension)
+{
+	return "./assets/levels/level" + std::to_string(level) + "." + extension;
+}
+
+// FNV-1a of what a navigation grid is built from
+static uint64_t HashNavigationSource(const char* mapData, size_t mapSize, const std::vector<TilemapTile>& blockedTiles, float cellSize)
+{
+	uint64_t hash = 14695981039346656037ull;
+	const auto hashBytes = [&hash](const void* data, size_t size)
+	{
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ static_cast<const uint8_t*>(data)[i]) * 1099511628211ull;
+		}
+	};
+	hashBytes(mapData, mapSize);
+	for (const auto& tile: blockedTiles)
+	{
+		hashBytes(&tile.col, sizeof(tile.col));
+		hashBytes(&tile.row, sizeof(tile.row));
+	}
+	hashBytes(&cellSize, sizeof(cellSize));
+	return hash;
+}
 
 int Game::windowWidth;
 int Game::windowHeight;
-int Game::mapWidth;
-int Game::mapHeight;
 
-Game::Game()
+Game::Game(bool isHeadless, int numWorkers, bool isWorkerPinned)
 {
+	startupReport = std::make_unique<StartupReport>();
 	isRunning = false;
 	isDebug = false;
+	isDebugBroadphase = false;
+	this->isHeadless = isHeadless;
+	if (isHeadless)
+	{
+		clock = std::make_unique<ManualClock>();
+	}
+	else
+	{
+		clock = std::make_unique<SystemClock>();
+	}
+	framePacer = std::make_unique<FramePacer>();
+	frameClock = std::make_unique<FrameClock>(1.0 / simulationTicksPerSecond);
+	timerWheel = std::make_unique<TimerWheel>();
 	registry = std::make_unique<Registry>();
+	// The renderer, the collisions and the hierarchy only go over the components that changed
+	registry->TrackChanges<TransformComponent>();
+	registry->TrackChanges<SpriteComponent>();
+	registry->TrackChanges<BoxColliderComponent>();
+	registry->TrackChanges<HierarchyComponent>();
+	registry->TrackChanges<TextLabelComponent>();
+	// The velocities written to sleeping bodies wake them up
+	registry->TrackChanges<RigidBodyComponent>();
 	assetStore = std::make_unique<AssetStore>();
+	audioEngine = std::make_unique<AudioEngine>(*assetStore);
+	scriptEngine = std::make_unique<ScriptEngine>();
 	eventBus = std::make_unique<EventBus>();
+	jobSystem = std::make_unique<JobSystem>(numWorkers > 0 ? numWorkers : JobSystem::DefaultNumWorkers(), isWorkerPinned);
+	scheduler = std::make_unique<Scheduler>(*jobSystem);
+	tilemap = std::make_unique<Tilemap>();
+	// Headless nothing draws the tiles, the simulation only needs the size of the map
+	tilemap->SetLayoutOnly(isHeadless);
+	pathfinder = std::make_unique<Pathfinder>(*jobSystem);
+	flowFieldTracker = std::make_unique<FlowFieldTracker>(*jobSystem);
+	particleSystem = std::make_unique<ParticleSystem>();
+	fogOfWar = std::make_unique<FogOfWar>();
+	parallaxLayers = std::make_unique<ParallaxLayers>();
+	resolutionScaler = std::make_unique<ResolutionScaler>();
+	frameCapture = std::make_unique<FrameCapture>();
+	logConsole = std::make_unique<LogConsole>();
+	performanceOverlay = std::make_unique<PerformanceOverlay>();
+	latencyTracker = std::make_unique<LatencyTracker>();
+	entityInspector = std::make_unique<EntityInspector>();
+	frameArena = std::make_unique<FrameArena>();
+	memoryTracker = std::make_unique<MemoryTracker>();
+	quickSaver = std::make_unique<SnapshotSaver>();
+	inputRecorder = std::make_unique<InputRecorder>();
+	inputState = std::make_unique<InputState>();
 	Logger::Log("Game constructor called!");
 }
 
@@ -48,15 +159,52 @@ Game::~Game()
 
 void Game::Initialize()
 {
-	if (SDL_Init(SDL_INIT_EVERYTHING) != 0)
+#ifdef ENABLE_PROFILER
+	Profiler::SetThreadName("Main");
+#endif
+	// Built by make pack, without it the loose asset files are loaded
+	assetStore->MountPack("./assets/assets.pak");
+	// The first level is read and decoded on the workers while SDL starts and the window opens
+	PrefetchLevel(1);
+	if (isHeadless)
 	{
-		Logger::Err("Error initializing SDL.");
+		// Only the timers and the events, the simulation needs no display
+		StartupReport::Scope scope(*startupReport, "SDL init");
+		if (SDL_Init(SDL_INIT_TIMER | SDL_INIT_EVENTS) != 0)
+		{
+			Logger::Err("Error initializing SDL.");
+			return;
+		}
+		windowWidth = HEADLESS_WINDOW_WIDTH;
+		windowHeight = HEADLESS_WINDOW_HEIGHT;
+		camera = {0, 0, windowWidth, windowHeight};
+		isRunning = true;
 		return;
 	}
+	// Only the subsystems the first frame needs, the gamepads start once it is shown and the
+	// haptics and sensors are never used
+	{
+		StartupReport::Scope scope(*startupReport, "SDL init");
+		if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_TIMER | SDL_INIT_EVENTS) != 0)
+		{
+			Logger::Err("Error initializing SDL.");
+			return;
+		}
+	}
+	{
+		StartupReport::Scope scope(*startupReport, "SDL_ttf init");
+		if (TTF_Init() != 0)
+		{
+			Logger::Err("Error initializing SDL_ttf.");
+			return;
+		}
+	}
+	double beginMillisecs = startupReport->GetMillisecs();
+	// Fullscreen covers the display at its own resolution
 	SDL_DisplayMode displayMode;
 	SDL_GetCurrentDisplayMode(0, &displayMode);
-	windowWidth = displayMode.w;
-	windowHeight = displayMode.h;
+	windowWidth = isFullscreen ? displayMode.w : windowedWidth;
+	windowHeight = isFullscreen ? displayMode.h : windowedHeight;
 	window = SDL_CreateWindow
 	(
 		NULL,
@@ -64,207 +212,1573 @@ void Game::Initialize()
 		SDL_WINDOWPOS_CENTERED,
 		windowWidth,
 		windowHeight,
-		SDL_WINDOW_BORDERLESS
+		isFullscreen ? SDL_WINDOW_BORDERLESS : 0
 	);
 	if (!window)
 	{
 		Logger::Err("Error creating SDL window.");
 		return;
 	}
-	renderer = SDL_CreateRenderer(window, -1, 0);
+	startupReport->AddPhase("Window", beginMillisecs);
+	beginMillisecs = startupReport->GetMillisecs();
+	renderer = RenderBackend::CreateRenderer(window, renderBackendType, framePacer->GetRendererFlags());
 	if (!renderer)
 	{
 		Logger::Err("Error creating SDL renderer.");
 		return;
 	}
-	// Initialize the camera view with the entire screen area
-	camera.x = 0;
-	camera.y = 0;
-	camera.w = windowWidth;
-	camera.h = windowHeight;
-	SDL_SetWindowFullscreen(window, SDL_WINDOW_FULLSCREEN);
+	framePacer->Apply(renderer);
+	startupReport->AddPhase("Renderer", beginMillisecs);
+	// Initialize the camera views with the entire screen area, or its halves, the camera
+	// movement sizes them to the zoom
+	viewports.clear();
+	if (isSplitScreen)
+	{
+		const int halfWidth = windowWidth / 2;
+		viewports.push_back({{0, 0, halfWidth, windowHeight}});
+		viewports.push_back({{halfWidth, 0, windowWidth - halfWidth, windowHeight}});
+	}
+	else
+	{
+		viewports.push_back({{0, 0, windowWidth, windowHeight}});
+	}
+	for (auto& viewport: viewports)
+	{
+		viewport.zoom = cameraZoom;
+		viewport.camera = {0.0f, 0.0f, viewport.screenRect.w / cameraZoom, viewport.screenRect.h / cameraZoom};
+	}
+	camera = GetCamerasBounds(viewports);
+	minimap = std::make_unique<Minimap>();
+	if (isFullscreen)
+	{
+		SDL_SetWindowFullscreen(window, SDL_WINDOW_FULLSCREEN);
+	}
+
+	// The debug GUI
+	beginMillisecs = startupReport->GetMillisecs();
+	ImGui::CreateContext();
+	ImGuiSDL::Initialize(renderer, windowWidth, windowHeight);
+	startupReport->AddPhase("Debug GUI", beginMillisecs);
+
+	// The game plays on without sound when there is no audio device
+	beginMillisecs = startupReport->GetMillisecs();
+	audioEngine->Open();
+	startupReport->AddPhase("Audio device", beginMillisecs);
+
+	if (isInputTimestamped && !inputReplay)
+	{
+		inputState->SetTimestamped(true);
+	}
 
 	isRunning = true;
 }
 
 void Game::ProcessInput()
 {
+	EventSiteScope site("ProcessInput");
 	SDL_Event sdlEvent;
 	while (SDL_PollEvent(&sdlEvent))
 	{
-		switch (sdlEvent.type)
+		// A replay only takes the input of the recording, closing the window still quits
+		if (inputReplay && sdlEvent.type != SDL_QUIT)
+		{
+			continue;
+		}
+		// The keys typed into the debug GUI never reach the gameplay, so they aren't recorded
+		const bool isTypedInGui = !isHeadless && isDebug && ImGui::GetIO().WantCaptureKeyboard && sdlEvent.type == SDL_KEYDOWN;
+		if (!isTypedInGui)
+		{
+			inputRecorder->Record(frameClock->GetTick(), sdlEvent);
+			const bool isPress = (sdlEvent.type == SDL_KEYDOWN && !sdlEvent.key.repeat) || sdlEvent.type == SDL_MOUSEBUTTONDOWN || sdlEvent.type == SDL_CONTROLLERBUTTONDOWN;
+			if (isPress)
+			{
+				latencyTracker->OnInput(sdlEvent.common.timestamp);
+			}
+		}
+		HandleEvent(sdlEvent);
+	}
+	inputRecorder->Flush();
+	PlayRecordedInput();
+	if (networkServer)
+	{
+		networkServer->ReceivePackets(*inputState, frameClock->GetTick());
+	}
+
+	if (isHeadless)
+	{
+		return;
+	}
+
+	// Feed the mouse to the debug GUI
+	ImGuiIO& io = ImGui::GetIO();
+	int mouseX, mouseY;
+	const int buttons = SDL_GetMouseState(&mouseX, &mouseY);
+	io.MousePos = ImVec2(mouseX, mouseY);
+	io.MouseDown[0] = buttons & SDL_BUTTON(SDL_BUTTON_LEFT);
+	io.MouseDown[1] = buttons & SDL_BUTTON(SDL_BUTTON_RIGHT);
+}
+
+void Game::PlayRecordedInput()
+{
+	SDL_Event sdlEvent;
+	while (inputReplay && inputReplay->PopEvent(frameClock->GetTick(), sdlEvent))
+	{
+		HandleEvent(sdlEvent);
+	}
+}
+
+void Game::HandleEvent(const SDL_Event& sdlEvent)
+{
+	switch (sdlEvent.type)
+	{
+	case SDL_MOUSEWHEEL:
+		if (!isHeadless)
+		{
+			ImGui::GetIO().MouseWheel += sdlEvent.wheel.y;
+		}
+		break;
+	case SDL_QUIT:
+		isRunning = false;
+		break;
+	case SDL_RENDER_TARGETS_RESET:
+	case SDL_RENDER_DEVICE_RESET:
+		// The content of the render target textures is lost
+		tilemap->Bake(renderer, assetStore);
+		minimap->Clear();
+		fogOfWar->ReleaseTexture();
+		resolutionScaler->ReleaseTexture();
+		break;
+	case INPUT_RECORD_ACTIONS:
+		inputState->SetActions(InputActions(static_cast<uint32_t>(sdlEvent.user.code)));
+		break;
+	case SDL_KEYDOWN:
+		if (sdlEvent.key.keysym.sym == SDLK_ESCAPE)
 		{
-		case SDL_QUIT:
 			isRunning = false;
-			break;
-		case SDL_KEYDOWN:
-			if (sdlEvent.key.keysym.sym == SDLK_ESCAPE)
+		}
+		if (sdlEvent.key.keysym.sym == SDLK_d)
+		{
+			isDebug = !isDebug;
+			registry->SetSystemEnabled<RenderColliderSystem>(isDebug);
+		}
+		if (sdlEvent.key.keysym.sym == SDLK_b && isDebug)
+		{
+			isDebugBroadphase = !isDebugBroadphase;
+		}
+		if (sdlEvent.key.keysym.sym == SDLK_EQUALS)
+		{
+			SetCameraZoom(cameraZoom * CAMERA_ZOOM_STEP);
+		}
+		if (sdlEvent.key.keysym.sym == SDLK_MINUS)
+		{
+			SetCameraZoom(cameraZoom / CAMERA_ZOOM_STEP);
+		}
+		if (sdlEvent.key.keysym.sym == SDLK_p)
+		{
+			frameClock->SetPaused(!frameClock->IsPaused());
+		}
+		// Restarts the level, the scenarios aren't levels. A replay loads it within the tick
+		// that handles the key, as the load it recorded ended before the next tick.
+		if (sdlEvent.key.keysym.sym == SDLK_F5 && scenarioName.empty() && !IsLoadingLevel())
+		{
+			if (inputReplay || isHeadless)
 			{
-				isRunning = false;
+				LoadLevel(loadedLevel);
 			}
-			if (sdlEvent.key.keysym.sym == SDLK_d)
+			else
 			{
-				isDebug = !isDebug;
+				LoadLevelAsync(loadedLevel);
 			}
-			eventBus->EmitEvent<KeyPressedEvent>(sdlEvent.key.keysym.sym);
-			break;
 		}
+		// Not of a level half loaded
+		if (sdlEvent.key.keysym.sym == SDLK_F6 && !IsLoadingLevel())
+		{
+			QuickSave();
+		}
+		if (sdlEvent.key.keysym.sym == SDLK_F7 && !IsLoadingLevel())
+		{
+			QuickLoad();
+		}
+		if (sdlEvent.key.keysym.sym == SDLK_F12)
+		{
+			frameCapture->RequestScreenshot();
+		}
+#ifdef ENABLE_PROFILER
+		if (sdlEvent.key.keysym.sym == SDLK_F9)
+		{
+			if (Profiler::IsCapturing())
+			{
+				Profiler::EndCapture(PROFILE_CAPTURE_FILE);
+			}
+			else
+			{
+				Profiler::BeginCapture();
+			}
+		}
+#endif
+		eventBus->EmitEvent<KeyPressedEvent>(sdlEvent.key.keysym.sym);
+		break;
 	}
 }
 
 
+void Game::PrefetchLevel(int level)
+{
+	// The job system only takes copyable jobs
+	auto promise = std::make_shared<std::promise<std::unique_ptr<LevelPrefetch>>>();
+	levelPrefetch = promise->get_future();
+	// The level file, until it tells how many more there are
+	numLevelFiles = 1;
+	numLevelFilesLoaded = 0;
+	jobSystem->Schedule([this, promise, level]()
+	{
+		auto prefetch = std::make_unique<LevelPrefetch>();
+		prefetch->level = level;
+		{
+			StartupReport::Scope scope(*startupReport, "Level file", true);
+			LevelLoader::Load(GetLevelFilePath(level, "lua"), GetLevelFilePath(level, "cache"), prefetch->levelData);
+		}
+		// The images and the scripts are spread over the workers together, nothing is drawn headless
+		StartupReport::Scope scope(*startupReport, "Textures and scripts", true);
+		const auto& textures = prefetch->levelData.textures;
+		const auto& scripts = prefetch->levelData.scripts;
+		const int numTextures = isHeadless ? 0 : textures.size();
+		prefetch->surfaces.resize(numTextures, nullptr);
+		prefetch->scriptChunks.resize(scripts.size());
+		numLevelFiles = 1 + numTextures + static_cast<int>(scripts.size());
+		numLevelFilesLoaded = 1;
+		jobSystem->ParallelFor(numTextures + scripts.size(), 1, [&](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				if (i < numTextures)
+				{
+					prefetch->surfaces[i] = assetStore->DecodeTexture(textures[i].filePath, textures[i].isDirectional);
+				}
+				else if (!ScriptEngine::CompileScript(scripts[i - numTextures].filePath, prefetch->scriptChunks[i - numTextures]))
+				{
+					prefetch->scriptChunks[i - numTextures].clear();
+				}
+				numLevelFilesLoaded++;
+			}
+		});
+		promise->set_value(std::move(prefetch));
+	});
+}
+
+std::unique_ptr<Game::LevelPrefetch> Game::TakeLevelPrefetch(int level)
+{
+	if (!levelPrefetch.valid())
+	{
+		return nullptr;
+	}
+	const double beginMillisecs = startupReport->GetMillisecs();
+	std::unique_ptr<LevelPrefetch> prefetch = levelPrefetch.get();
+	if (!startupReport->IsFinished())
+	{
+		startupReport->AddPhase("Wait for the workers", beginMillisecs);
+	}
+	if (prefetch->level != level)
+	{
+		for (SDL_Surface* surface: prefetch->surfaces)
+		{
+			SDL_FreeSurface(surface);
+		}
+		return nullptr;
+	}
+	return prefetch;
+}
+
 void Game::LoadLevel(int level)
 {
+	BeginLevelLoad(level);
+	ContinueLevelLoad(true);
+}
+
+void Game::LoadLevelAsync(int level)
+{
+	// The first level may be on the workers already
+	if (!levelPrefetch.valid())
+	{
+		PrefetchLevel(level);
+	}
+	BeginLevelLoad(level);
+}
+
+bool Game::IsLoadingLevel() const
+{
+	return levelLoadStage != LEVEL_LOAD_NONE;
+}
+
+void Game::BeginLevelLoad(int level)
+{
+	if (loadedLevel != 0)
+	{
+		UnloadLevel();
+	}
+	levelLoadStage = LEVEL_LOAD_FILES;
+	loadingLevel = level;
+	numLevelEntitiesCreated = 0;
+	levelLoadPerformanceCounter = SDL_GetPerformanceCounter();
+}
+
+bool Game::ContinueLevelLoad(bool isBlocking)
+{
+	if (levelLoadStage == LEVEL_LOAD_FILES)
+	{
+		if (!isBlocking && levelPrefetch.valid() && levelPrefetch.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			return false;
+		}
+		loadingLevelData = std::make_unique<LevelData>();
+		levelLoadStage = SetUpLevel(loadingLevel, *loadingLevelData) ? LEVEL_LOAD_ENTITIES : LEVEL_LOAD_NONE;
+	}
+	if (levelLoadStage == LEVEL_LOAD_ENTITIES)
+	{
+		// Their animations and emitters start at the current game time, which stands still
+		// until the level is loaded
+		const Uint64 sliceStart = SDL_GetPerformanceCounter();
+		const size_t numEntities = loadingLevelData->entities.size();
+		while (numLevelEntitiesCreated < numEntities)
+		{
+			const size_t numChunkEntities = std::min(numEntities - numLevelEntitiesCreated, static_cast<size_t>(LEVEL_LOAD_ENTITY_CHUNK));
+			LevelLoader::CreateEntities(*registry, *loadingLevelData, frameClock->GetMillisecs(), windowWidth, numLevelEntitiesCreated, numChunkEntities);
+			numLevelEntitiesCreated += numChunkEntities;
+			const double sliceMillisecs = (SDL_GetPerformanceCounter() - sliceStart) * 1000.0 / SDL_GetPerformanceFrequency();
+			if (!isBlocking && numLevelEntitiesCreated < numEntities && sliceMillisecs >= LEVEL_LOAD_BUDGET_MILLISECS)
+			{
+				return false;
+			}
+		}
+		levelLoadStage = LEVEL_LOAD_NONE;
+	}
+	loadingLevelData.reset();
+	LOGGER_INFO("Level {} loaded in {} ms", loadingLevel, (SDL_GetPerformanceCounter() - levelLoadPerformanceCounter) * 1000.0 / SDL_GetPerformanceFrequency());
+	return true;
+}
+
+float Game::GetLevelLoadProgress() const
+{
+	if (levelLoadStage == LEVEL_LOAD_ENTITIES)
+	{
+		const size_t numEntities = std::max(loadingLevelData->entities.size(), static_cast<size_t>(1));
+		return LEVEL_LOAD_FILES_SHARE + (1.0f - LEVEL_LOAD_FILES_SHARE) * numLevelEntitiesCreated / numEntities;
+	}
+	if (levelLoadStage == LEVEL_LOAD_FILES)
+	{
+		return LEVEL_LOAD_FILES_SHARE * numLevelFilesLoaded / std::max(numLevelFiles.load(), 1);
+	}
+	return 1.0f;
+}
+
+void Game::RecordLoadingScreen()
+{
+	frameCommands.Clear({21, 21, 21, 255});
+	frameCommands.SetViewport(nullptr);
+	const int barWidth = windowWidth / 2;
+	const int barHeight = 12;
+	const SDL_Rect barRect = {(windowWidth - barWidth) / 2, windowHeight / 2 - barHeight / 2, barWidth, barHeight};
+	std::vector<SDL_Rect> rects = {barRect};
+	frameCommands.AddRects(rects, {200, 200, 200, 255});
+	rects[0].w = static_cast<int>(barWidth * GetLevelLoadProgress());
+	frameCommands.AddFilledRects(rects, {200, 200, 200, 255});
+	isFramePending = true;
+}
+
+bool Game::SetUpLevel(int level, LevelData& levelData)
+{
+
+	// The events and the commands the systems queue in parallel come out in the same order
+	// whatever the threads
+	eventBus->SetOrderedDispatch(isDeterministic);
+	registry->SetOrderedThreadPlayback(isDeterministic);
+	allocationWarmupFrames = ALLOCATION_WARMUP_FRAMES;
+
 	// Add the system that need to be processed in our game
 	registry->AddSystem<MovementSystem>();
+	registry->AddSystem<HierarchySystem>();
 	registry->AddSystem<RenderSystem>();
+	registry->GetSystem<RenderSystem>().ObserveRigidBodies(*registry);
 	registry->AddSystem<AnimationSystem>();
 	registry->AddSystem<CollisionSystem>();
+	registry->GetSystem<CollisionSystem>().SetBroadphaseCellSize(broadphaseCellSize);
+	registry->GetSystem<CollisionSystem>().SetAutoTuneBroadphase(isBroadphaseAutoTuned);
+	registry->GetSystem<CollisionSystem>().SetOrdered(isDeterministic);
+	registry->GetSystem<CollisionSystem>().ObserveSleepingBodies(*registry);
+	// The collision system reads them together every tick
+	registry->AddOwningGroup<TransformComponent, BoxColliderComponent>();
 	registry->AddSystem<RenderColliderSystem>();
+	// Only drawn while debugging, it holds no entities until then
+	registry->SetSystemEnabled<RenderColliderSystem>(isDebug);
+	registry->AddSystem<RenderTextSystem>();
+	registry->AddSystem<RenderHealthBarSystem>();
 	registry->AddSystem<DamageSystem>();
+	registry->AddSystem<DeathSystem>();
+	registry->AddSystem<CollisionResponseSystem>();
 	registry->AddSystem<KeyboardControlSystem>();
+	registry->AddSystem<DirectionalSpriteSystem>();
+	registry->AddSystem<VisionSystem>();
 	registry->AddSystem<CameraMovementSystem>();
 	registry->AddSystem<ProjectileEmitSystem>();
 	registry->AddSystem<ProjectileLifecycleSystem>();
+	registry->AddSystem<ScriptSystem>();
+	registry->AddSystem<NavigationSystem>();
+	registry->AddSystem<FlowFieldSystem>();
+	registry->AddSystem<AISystem>();
+	if (spatialSortTicks > 0)
+	{
+		registry->AddSystem<SpatialSortSystem>();
+		nextSpatialSortTick = frameClock->GetTick() + spatialSortTicks;
+	}
+	// What each client is sent, only the server has clients
+	if (networkServer)
+	{
+		registry->AddSystem<InterestSystem>();
+	}
 
-	// Adding assets to the asset store
-	assetStore->AddTexture(renderer, "tank-image", "./assets/images/tank-panther-right.png");
-	assetStore->AddTexture(renderer, "truck-image", "./assets/images/truck-ford-right.png");
-	assetStore->AddTexture(renderer, "chopper-image", "./assets/images/chopper-spritesheet.png");
-	assetStore->AddTexture(renderer, "radar-image", "./assets/images/radar.png");
-	assetStore->AddTexture(renderer, "tilemap-image", "./assets/tilemaps/jungle.png");
-	assetStore->AddTexture(renderer, "bullet-image", "./assets/images/bullet.png");
-
-	
-	// Load the tilemap
-	int tileSize = 32;
-	double tileScale = 4.0;
-	int mapNumCols = 25;
-	int mapNumRows = 20;
-
-	std::fstream mapFile;
-	mapFile.open("./assets/tilemaps/jungle.map");
-
-	for (int y = 0; y < mapNumRows; y++)
-	{
-		for (int x = 0; x < mapNumCols; x++)
-		{
-			char ch;
-			mapFile.get(ch);
-			int srcRectY = std::atoi(&ch) * tileSize;
-			mapFile.get(ch);
-			int srcRectX = std::atoi(&ch) * tileSize;
-			mapFile.ignore();
-
-			Entity tile = registry->CreateEntity();
-			tile.AddComponent<TransformComponent>(glm::vec2(x * (tileScale * tileSize), y * (tileScale * tileSize)), glm::vec2(tileScale, tileScale), 0.0);
-			tile.AddComponent<SpriteComponent>("tilemap-image", tileSize, tileSize, 0, false, srcRectX, srcRectY);
-		}
-	}
-	mapFile.close();
-	mapWidth = mapNumCols * tileSize * tileScale;
-	mapHeight = mapNumRows * tileSize * tileScale;
-
-	// Create some entities
-	Entity chopper = registry->CreateEntity();
-	chopper.AddComponent<TransformComponent>(glm::vec2(10.0, 100.0), glm::vec2(1.0, 1.0), 0.0);
-	chopper.AddComponent<RigidBodyComponent>(glm::vec2(0.0, 0.0));
-	chopper.AddComponent<SpriteComponent>("chopper-image", 32, 32, 1);
-	chopper.AddComponent<AnimationComponent>(2, 15, true);
-	chopper.AddComponent<KeyboardControlledComponent>(glm::vec2(0, -80), glm::vec2(80, 0), glm::vec2(0, 80), glm::vec2(-80, 0));
-	chopper.AddComponent<CameraFollowComponent>();
-	chopper.AddComponent<HealthComponent>(100);
-
-	Entity radar = registry->CreateEntity();
-	radar.AddComponent<TransformComponent>(glm::vec2(windowWidth - 74, 10.0), glm::vec2(1.0, 1.0), 0.0);
-	radar.AddComponent<RigidBodyComponent>(glm::vec2(0.0, 0.0));
-	radar.AddComponent<SpriteComponent>("radar-image", 64, 64, 1, true);
-	radar.AddComponent<AnimationComponent>(8, 5, true);
-
-	Entity tank = registry->CreateEntity();
-	tank.AddComponent<TransformComponent>(glm::vec2(500.0, 10.0), glm::vec2(1.0, 1.0), 0.0);
-	tank.AddComponent<RigidBodyComponent>(glm::vec2(0.0, 0.0));
-	tank.AddComponent<SpriteComponent>("tank-image", 32, 32, 1);
-	tank.AddComponent<BoxColliderComponent>(32, 32);
-	tank.AddComponent<ProjectileEmitterComponent>(glm::vec2(100.0, 0.0), 5000, 3000, 0, false);
-	tank.AddComponent<HealthComponent>(100);
-
-	Entity truck = registry->CreateEntity();
-	truck.AddComponent<TransformComponent>(glm::vec2(10.0, 10.0), glm::vec2(1.0, 1.0), 0.0);
-	truck.AddComponent<RigidBodyComponent>(glm::vec2(0.0, 0.0));
-	truck.AddComponent<SpriteComponent>("truck-image", 32, 32, 2);
-	truck.AddComponent<BoxColliderComponent>(32, 32);
-	truck.AddComponent<ProjectileEmitterComponent>(glm::vec2(0.0, 100.0), 2000, 5000, 0, false);
-	truck.AddComponent<HealthComponent>(100);
-}
+	// The projectiles are recycled instead of created and killed on every shot
+	projectilePool = ProjectileEmitSystem::CreateProjectilePool(*registry);
+	wreckPool = DeathSystem::CreateWreckPool(*registry);
 
-void Game::Setup()
-{
-	LoadLevel(1);
-}
+	// Schedule the system updates, the ones with no conflicting component access run in parallel
+	scheduler->Clear();
+	// Headless there is no camera to be far from, everything stays awake
+	if (!isHeadless)
+	{
+		registry->AddSystem<ActivitySystem>();
+		scheduler->AddSystem("ActivitySystem", registry->GetSystem<ActivitySystem>(), [this]() { registry->GetSystem<ActivitySystem>().Update(camera); });
+	}
+	scheduler->AddSystem("KeyboardControlSystem", registry->GetSystem<KeyboardControlSystem>(), [this]() { registry->GetSystem<KeyboardControlSystem>().Update(*inputState); });
+	scheduler->AddSystem("MovementSystem", registry->GetSystem<MovementSystem>(), [this]() { registry->GetSystem<MovementSystem>().Update(*registry, jobSystem); });
+	// After the roots moved, and before anything reads where their children are
+	scheduler->AddSystem("HierarchySystem", registry->GetSystem<HierarchySystem>(), [this]() { registry->GetSystem<HierarchySystem>().Update(*registry, jobSystem, *frameArena); });
+	scheduler->AddSystem("AnimationSystem", registry->GetSystem<AnimationSystem>(), [this]() { registry->GetSystem<AnimationSystem>().Update(*frameClock, jobSystem, eventBus); });
+	scheduler->AddSystem("CollisionSystem", registry->GetSystem<CollisionSystem>(), [this]() { registry->GetSystem<CollisionSystem>().Update(*registry, eventBus); });
+	// The response to the pairs the collision system found, the hits before the pushes
+	scheduler->AddSystem("DamageSystem", registry->GetSystem<DamageSystem>(), [this]() { registry->GetSystem<DamageSystem>().Update(registry->GetSystem<CollisionSystem>().GetCollisions(), *projectilePool, registry->GetSystem<DeathSystem>()); });
+	scheduler->AddSystem("CollisionResponseSystem", registry->GetSystem<CollisionResponseSystem>(), [this]() { registry->GetSystem<CollisionResponseSystem>().Update(registry->GetSystem<CollisionSystem>().GetCollisions()); });
+	scheduler->AddSystem("ProjectileEmitSystem", registry->GetSystem<ProjectileEmitSystem>(), [this]() { registry->GetSystem<ProjectileEmitSystem>().Update(*frameClock, *timerWheel, *projectilePool, *audioEngine, registry->GetSystem<CollisionSystem>().GetBroadphase()); });
+	scheduler->AddSystem("ProjectileLifecycleSystem", registry->GetSystem<ProjectileLifecycleSystem>(), [this]() { registry->GetSystem<ProjectileLifecycleSystem>().Update(*timerWheel, *projectilePool); });
+	scheduler->AddSystem("ScriptSystem", registry->GetSystem<ScriptSystem>(), [this]() { registry->GetSystem<ScriptSystem>().Update(*scriptEngine, frameClock->GetDeltaTime()); });
+	// Before the navigation, which drives the enemies to the goals they chose
+	scheduler->AddSystem("AISystem", registry->GetSystem<AISystem>(), [this]() { registry->GetSystem<AISystem>().Update(*registry, registry->GetSystem<CollisionSystem>().GetQueries(), *jobSystem, aiThinkRate); });
+	scheduler->AddSystem("NavigationSystem", registry->GetSystem<NavigationSystem>(), [this]() { registry->GetSystem<NavigationSystem>().Update(*pathfinder, frameClock->GetDeltaTime()); });
+	scheduler->AddSystem("FlowFieldSystem", registry->GetSystem<FlowFieldSystem>(), [this]() { registry->GetSystem<FlowFieldSystem>().Update(*flowFieldTracker); });
+	// Once every system that steers the entities set their velocity
+	scheduler->AddSystem("DirectionalSpriteSystem", registry->GetSystem<DirectionalSpriteSystem>(), [this]() { registry->GetSystem<DirectionalSpriteSystem>().Update(); });
+	scheduler->AddSystem("VisionSystem", registry->GetSystem<VisionSystem>(), [this]() { registry->GetSystem<VisionSystem>().Update(*fogOfWar); });
+	// Last, once every damage of the tick was taken, the deaths are resolved together
+	scheduler->AddSystem("DeathSystem", registry->GetSystem<DeathSystem>(), [this]() { registry->GetSystem<DeathSystem>().Update(*wreckPool, *particleSystem); });
 
-void Game::Update()
-{
-    // If we are too fast, waste some time until we reach the MILLISECS_PER_FRAME
-    int timeToWait = MILLISECS_PER_FRAME - (SDL_GetTicks() - millisecsPreviousFrame);
-	    if (timeToWait > 0 && timeToWait <= MILLISECS_PER_FRAME) {
-        SDL_Delay(timeToWait);
-    }
+	// The level is described in Lua, its evaluated data is cached next to it. The first one
+	// was loaded on the workers already.
+	std::unique_ptr<LevelPrefetch> prefetch = TakeLevelPrefetch(level);
+	if (prefetch)
+	{
+		levelData = std::move(prefetch->levelData);
+	}
+	else
+	{
+		LevelLoader::Load(GetLevelFilePath(level, "lua"), GetLevelFilePath(level, "cache"), levelData);
+	}
 
-	// The difference in ticks since the last frame, converted to seconds
-	double deltaTime = (SDL_GetTicks() - millisecsPreviousFrame) / 1000.0;
+	// Adding assets to the asset store, under the scope of this level
+	const std::string levelScope = "level-" + std::to_string(level);
+	assetStore->BeginScope(levelScope);
 
-	// Store the current frame time
-	millisecsPreviousFrame = SDL_GetTicks();
+	// The images are decoded in the background and uploaded over the next frames.
+	// Nothing is drawn headless, the sprites keep their asset ids without the textures.
+	if (!isHeadless)
+	{
+		for (size_t i = 0; i < levelData.textures.size(); i++)
+		{
+			const auto& texture = levelData.textures[i];
+			if (prefetch)
+			{
+				assetStore->AddDecodedTexture(texture.assetId, texture.filePath, prefetch->surfaces[i], texture.isAtlased, texture.isDirectional, texture.isStreamed);
+			}
+			else
+			{
+				assetStore->LoadTextureAsync(*jobSystem, texture.assetId, texture.filePath, texture.isAtlased, texture.isDirectional, texture.isStreamed);
+			}
+		}
+		// A font is rasterized in one go, into its own atlas
+		for (const auto& font: levelData.fonts)
+		{
+			assetStore->AddFont(renderer, font.assetId, font.filePath, font.fontSize);
+		}
+	}
+	// The sounds are decoded to the format of the audio device, there are none without it
+	if (audioEngine->IsOpen())
+	{
+		for (const auto& sound: levelData.sounds)
+		{
+			assetStore->AddSound(sound.assetId, sound.filePath);
+		}
+		if (!levelData.musicFilePath.empty())
+		{
+			audioEngine->PlayMusic(levelData.musicFilePath);
+		}
+		else
+		{
+			audioEngine->StopMusic();
+		}
+	}
+
+	// The assets of the previous level go away, unless this level loaded them again
+	const bool isReload = loadedLevel == level;
+	if (loadedLevel != 0 && !isReload)
+	{
+		assetStore->ReleaseScope("level-" + std::to_string(loadedLevel));
+	}
+	loadedLevel = level;
+
+	if (!scenarioName.empty())
+	{
+		if (!Scenario::Load(scenarioName, scenarioSize, scenarioSeed, *registry, *tilemap))
+		{
+			Logger::Err("Unknown scenario " + scenarioName);
+			isRunning = false;
+		}
+		registry->SetResource<MapBoundsResource>(tilemap->GetWidth(), tilemap->GetHeight());
+		return false;
+	}
+
+	// The behaviours of the entities, loaded before the entities that run them
+	for (size_t i = 0; i < levelData.scripts.size(); i++)
+	{
+		const auto& script = levelData.scripts[i];
+		scriptEngine->LoadScript(script.scriptId, script.filePath, prefetch ? prefetch->scriptChunks[i] : "");
+	}
 
-	// Reset all event handleers for the current frame
-	eventBus->Reset();
+	// Drawn once their textures are uploaded
+	for (const auto& levelLayer: levelData.parallaxLayers)
+	{
+		ParallaxLayer layer;
+		layer.assetHandle = GetAssetHandle(levelLayer.textureAssetId);
+		layer.factor = levelLayer.factor;
+		layer.scrollVelocity = levelLayer.scrollVelocity;
+		layer.scale = levelLayer.scale;
+		layer.isForeground = levelLayer.isForeground;
+		parallaxLayers->AddLayer(layer);
+	}
 
-	// Perform the subscription of the events for all systems
-	registry->GetSystem<DamageSystem>().SubscribeToEvents(eventBus);
-	registry->GetSystem<KeyboardControlSystem>().SubscribeToEvents(eventBus);
+	// Load the tilemap, its size comes from the map file
+	const std::string mapFilePath = levelData.tilemap.mapFilePath;
+	const std::string tilesetAssetId = levelData.tilemap.tilesetAssetId;
+	const int tileSize = levelData.tilemap.tileSize;
+	const double tileScale = levelData.tilemap.tileScale;
 
-	// Update the registry to process the entities that are waiting to be created/deleted
-	registry->Update();
-	
-	// Inkove all the systems that need to update
-	registry->GetSystem<MovementSystem>().Update(deltaTime);
-	registry->GetSystem<AnimationSystem>().Update();
-	registry->GetSystem<CollisionSystem>().Update(eventBus);
-	registry->GetSystem<CameraMovementSystem>().Update(camera);
-	registry->GetSystem<ProjectileEmitSystem>().Update(registry);
-	registry->GetSystem<ProjectileLifecycleSystem>().Update();
+	// The tiles never change, bake them into a few textures instead of creating an entity per tile.
+	// The binary map built by make tilemaps is streamed around the camera instead of loaded,
+	// headless there is no camera to stream around and the whole map is loaded.
+	const std::string& streamFilePath = levelData.tilemap.streamFilePath;
+	const char* mapData;
+	size_t mapSize;
+	if (assetStore->GetPackedFile(mapFilePath, mapData, mapSize))
+	{
+		tilemap->LoadFromMemory(mapData, mapSize, tilesetAssetId, tileSize, tileScale);
+	}
+	else if (!isHeadless && !streamFilePath.empty() && std::ifstream(streamFilePath).good())
+	{
+		tilemap->Stream(streamFilePath, tilesetAssetId, tileSize, tileScale);
+	}
+	else
+	{
+		tilemap->Load(mapFilePath, tilesetAssetId, tileSize, tileScale);
+	}
+	const MapBoundsResource& mapBounds = registry->SetResource<MapBoundsResource>(tilemap->GetWidth(), tilemap->GetHeight());
+	AnimateTiles(levelData.tilemap);
+	BuildNavigationGrid(levelData.tilemap);
+	if (levelData.tilemap.hasFogOfWar)
+	{
+		fogOfWar->Reset(mapBounds.width, mapBounds.height, levelData.tilemap.tileSize * levelData.tilemap.tileScale);
+	}
+
+	// Edits to the map file are picked up from the file itself, even with a pack mounted. A
+	// reloaded level keeps the watch it had.
+	if (!tilemap->IsStreaming() && !isReload)
+	{
+		const LevelTilemap levelTilemap = levelData.tilemap;
+		assetStore->WatchFile(mapFilePath, [this, levelTilemap]()
+		{
+			tilemap->Load(levelTilemap.mapFilePath, levelTilemap.tilesetAssetId, levelTilemap.tileSize, levelTilemap.tileScale);
+			const MapBoundsResource& mapBounds = registry->SetResource<MapBoundsResource>(tilemap->GetWidth(), tilemap->GetHeight());
+			AnimateTiles(levelTilemap);
+			BuildNavigationGrid(levelTilemap);
+			// What was explored is forgotten, the map may have a new size
+			if (levelTilemap.hasFogOfWar)
+			{
+				fogOfWar->Reset(mapBounds.width, mapBounds.height, levelTilemap.tileSize * levelTilemap.tileScale);
+			}
+		});
+	}
 
+	// The entities are created by ContinueLevelLoad
+	return !levelData.entities.empty();
 }
 
-void Game::Render()
+void Game::UnloadLevel()
 {
-	SDL_SetRenderDrawColor(renderer, 21, 21, 21, 255);
-	SDL_RenderClear(renderer);
-
-	// Inkove all the systems that need to render
-	registry->GetSystem<RenderSystem>().Update(renderer, assetStore, camera);
-	if (isDebug)
+	// The scheduled updates, the entity pools and the behaviours point at the systems and
+	// entities about to go, then every entity goes at once instead of being killed one by one
+	scheduler->Clear();
+	projectilePool.reset();
+	wreckPool.reset();
+	scriptEngine->StopBehaviours();
+	// Nothing plays or is queued once it returns, the level's sounds can be released
+	audioEngine->StopAll();
+	registry->Clear();
+	timerWheel->Reset(frameClock->GetTick());
+	eventBus->ClearQueuedEvents();
+	particleSystem->Clear();
+	tilemap->Clear();
+	pathfinder->SetGrid(nullptr);
+	flowFieldTracker->SetGrid(nullptr);
+	fogOfWar->Clear();
+	parallaxLayers->Clear();
+	if (minimap)
 	{
-		registry->GetSystem<RenderColliderSystem>().Update(renderer, camera);
+		minimap->Clear();
 	}
-	SDL_RenderPresent(renderer);
+	// The cameras snap to the entities of the next level
+	for (auto& viewport: viewports)
+	{
+		viewport.isFollowing = false;
+	}
+	// The frame recorded before draws the textures about to be released
+	isFramePending = false;
+	Logger::Log("Level " + std::to_string(loadedLevel) + " unloaded");
 }
 
-void Game::Run()
+void Game::Setup()
 {
-	Setup();
-	while (isRunning)
+	EventTrace::Open(EVENT_TRACE_FILE);
+
+	particleSystem->SetRandomSeed(randomSeed);
+	scriptEngine->SetRandomSeed(randomSeed);
+	if (!inputRecordingFilePath.empty())
 	{
-		ProcessInput();
-		Update();
-		Render();
+		InputRecordingHeader header = {};
+		header.randomSeed = randomSeed;
+		header.ticksPerSecond = simulationTicksPerSecond;
+		std::strncpy(header.scenarioName, scenarioName.c_str(), INPUT_RECORDING_MAX_SCENARIO_NAME - 1);
+		header.scenarioSize = scenarioSize;
+		header.scenarioSeed = scenarioSeed;
+		header.flags = isDeterministic ? INPUT_RECORDING_DETERMINISTIC : 0;
+		inputRecorder->Open(inputRecordingFilePath, header);
+	}
+
+	// The debug GUI sees the keys first and keeps the ones it is typing from the gameplay systems
+	debugInputSubscription = eventBus->SubscribeToEvent<KeyPressedEvent>([this](KeyPressedEvent& event)
+	{
+		if (!isHeadless && isDebug && ImGui::GetIO().WantCaptureKeyboard)
+		{
+			event.Consume();
+		}
+	}, EVENT_PRIORITY_UI);
+
+	// The sparks are particles, not entities, so effects never churn the registry
+	collisionEffectSubscription = eventBus->SubscribeToEvent<CollisionEnterEvent>([this](CollisionEnterEvent& event)
+	{
+		EmitCollisionSparks(event.a);
+	});
+
+	// Headless or replayed, nothing is drawn meanwhile or the ticks must start on the level
+	if (isHeadless || inputReplay)
+	{
+		LoadLevel(1);
+	}
+	else
+	{
+		LoadLevelAsync(1);
 	}
 }
 
-void Game::Destroy()
+void Game::Update()
 {
-	SDL_DestroyRenderer(renderer);
-	SDL_DestroyWindow(window);
+	// If we are too fast, waste some time until the target frame time, a manual clock moves
+	// forward at once
+	framePacer->WaitForNextFrame(*clock, millisecsPreviousFrame);
+
+	// The difference in time since the last frame, converted to seconds
+	const double millisecsCurrentFrame = clock->GetMillisecs();
+	const double frameTime = (millisecsCurrentFrame - millisecsPreviousFrame) / 1000.0;
+	frameMillisecs = millisecsCurrentFrame - millisecsPreviousFrame;
+	performanceOverlay->AddFrameTime(frameMillisecs);
+
+	// Store the current frame time
+	millisecsPreviousFrame = millisecsCurrentFrame;
+	PROFILE_SCOPE("Update");
+
+	// Run as many fixed simulation ticks as the scaled elapsed time covers, a paused clock
+	// runs none. Fast forward gets more ticks per frame before the catch up limit kicks in.
+	frameClock->SetDeltaTime(1.0 / simulationTicksPerSecond);
+	const double deltaTime = frameClock->GetDeltaTime();
+	const int maxTicks = MAX_SIMULATION_TICKS_PER_FRAME * static_cast<int>(std::ceil(std::max(1.0, frameClock->GetTimeScale())));
+	simulationAccumulator += frameClock->Scale(frameTime);
+	int numTicks = 0;
+	while (simulationAccumulator >= deltaTime && numTicks < maxTicks)
+	{
+		if (maxSimulationTicks > 0 && frameClock->GetTick() >= maxSimulationTicks)
+		{
+			isRunning = false;
+			break;
+		}
+		EventTrace::SetTick(frameClock->GetTick());
+		PlayRecordedInput();
+		// The keyboard and the gamepad as they are on this tick, a replay sets the actions instead.
+		// The tick stands for the slice of the frame's time the accumulator still holds, the
+		// timestamped keys are taken up to the end of it.
+		if (!inputReplay && !isHeadless)
+		{
+			const double tickEndMillisecs = millisecsCurrentFrame - (simulationAccumulator - deltaTime) / frameClock->GetTimeScale() * 1000.0;
+			inputState->Poll(isDebug && ImGui::GetIO().WantCaptureKeyboard, tickEndMillisecs);
+		}
+		inputRecorder->RecordActions(frameClock->GetTick(), inputState->GetActions());
+		const Uint64 performanceCounterTick = scenarioReport || networkServer ? SDL_GetPerformanceCounter() : 0;
+
+		// The other worlds step meanwhile on their threads
+		for (auto& world: worlds)
+		{
+			world->GetFrameClock().SetDeltaTime(deltaTime);
+			world->StartStep();
+		}
+
+		// The pooled projectiles the level didn't wait for, a few per tick
+		if (projectilePool)
+		{
+			projectilePool->PrewarmStep(ENTITY_POOL_PREWARM_STEP);
+		}
+
+		// Update the registry to process the entities that are waiting to be created/deleted
+		{
+			PROFILE_SCOPE("Registry::Update");
+			registry->SetResource<TickTimeResource>(deltaTime, frameClock->GetTick());
+			registry->Update();
+		}
+
+		if (networkClient)
+		{
+			// The server runs the simulation, the client shows the last state it sent with its
+			// own chopper predicted ahead of it and the rest interpolated between the snapshots
+			const InputActions pressedActions = inputState->GetPressedActions();
+			for (int action = 0; action < INPUT_ACTION_COUNT; action++)
+			{
+				if (pressedActions[action])
+				{
+					networkClient->AddActionPress(static_cast<InputAction>(action));
+				}
+			}
+			networkPrediction->AddActionPresses(pressedActions, frameClock->GetTick());
+			const bool isSnapshotLoaded = networkClient->Update(*registry, camera, frameClock->GetTick());
+			networkPrediction->Update(*registry, *networkClient, isSnapshotLoaded, frameClock->GetTick(), deltaTime);
+			for (const auto& collision: networkPrediction->GetEnteredCollisions())
+			{
+				EmitCollisionSparks(collision.first);
+			}
+		}
+		else
+		{
+			// Bring the timers due this tick to the systems that scheduled them
+			timerWheel->Advance(frameClock->GetTick());
+			audioEngine->SetListener(camera);
+
+			// Inkove all the systems that need to update, the scheduler profiles each of them
+			scheduler->Run();
+			// The paths asked for this tick are searched on the workers until the next tick, so
+			// is the flow field once the player is in another cell
+			pathfinder->Update();
+			Entity flowFieldGoal(0, 0, 0);
+			if (registry->FindEntityByTag(FLOW_FIELD_GOAL_TAG, flowFieldGoal) && flowFieldGoal.HasComponent<TransformComponent>())
+			{
+				flowFieldTracker->SetGoal(flowFieldGoal.GetComponent<TransformComponent>().position);
+			}
+			else
+			{
+				flowFieldTracker->ClearGoal();
+			}
+			flowFieldTracker->Update();
+		}
+
+		// The particles die on the obstacles, they go through everything else
+		particleSystem->Update(deltaTime);
+		particleSystem->Collide(registry->GetSystem<CollisionSystem>().GetStaticColliders(), COLLISION_LAYER_DEFAULT, COLLISION_LAYER_OBSTACLE);
+
+		// Deliver the events the systems queued during this tick, as one batch per event type
+		{
+			PROFILE_SCOPE("Event dispatch");
+			EventSiteScope site("Event dispatch");
+			eventBus->DispatchQueuedEvents();
+		}
+
+		for (auto& world: worlds)
+		{
+			world->WaitForStep();
+		}
+
+		// The state the tick ended in, a replay goes on past a desync to report how many ticks differ
+		const bool isChecksumRecorded = isDeterministic && (inputRecorder->IsRecording() || inputReplay);
+		if (isHeadless || isChecksumRecorded)
+		{
+			PROFILE_SCOPE("Checksum");
+			tickChecksum = registry->ComputeChecksum(*jobSystem);
+			runChecksum = CombineChecksums(runChecksum, tickChecksum);
+			LOGGER_DEBUG("Tick {} checksum {}", frameClock->GetTick(), tickChecksum);
+			if (isChecksumRecorded)
+			{
+				inputRecorder->RecordChecksum(frameClock->GetTick(), tickChecksum);
+				if (inputReplay && !inputReplay->MatchesChecksum(frameClock->GetTick(), tickChecksum) && numDesyncedTicks++ == 0)
+				{
+					Logger::Err("The replay desynced from its recording on tick " + std::to_string(frameClock->GetTick()));
+				}
+			}
+		}
+
+		// The commands the systems recorded this tick go into the snapshots
+		if (networkServer && frameClock->GetTick() % NETWORK_SNAPSHOT_INTERVAL_TICKS == 0)
+		{
+			registry->Update();
+			// The transform changes of the ticks since the last snapshots are still in the history
+			auto& interestSystem = registry->GetSystem<InterestSystem>();
+			interestSystem.Update(*registry);
+			networkServer->SendSnapshots(*registry, interestSystem, frameClock->GetTick());
+		}
+
+		// The components back in the order of where their entities are, on the only tick of a
+		// frame so one already catching up isn't made later. Deterministic runs sort on the
+		// tick it is due, the order the systems see the entities in is the same on every run.
+		const bool isSortDue = spatialSortTicks > 0 && frameClock->GetTick() >= nextSpatialSortTick;
+		if (isSortDue && (isDeterministic || (numTicks == 0 && simulationAccumulator < 2.0 * deltaTime)))
+		{
+			registry->GetSystem<SpatialSortSystem>().Update(*registry);
+			nextSpatialSortTick = frameClock->GetTick() + spatialSortTicks;
+		}
+
+		inputState->EndTick();
+		latencyTracker->OnTick();
+		frameClock->Tick();
+		const double tickMillisecs = (SDL_GetPerformanceCounter() - performanceCounterTick) * 1000.0 / SDL_GetPerformanceFrequency();
+		if (scenarioReport)
+		{
+			scenarioReport->AddTick(tickMillisecs);
+		}
+		if (networkServer)
+		{
+			networkServer->EndTick(tickMillisecs);
+		}
+		simulationAccumulator -= deltaTime;
+		numTicks++;
+	}
+	if (numTicks == maxTicks)
+	{
+		simulationAccumulator = std::min(simulationAccumulator, deltaTime);
+	}
+
+	// Collect the garbage the scripts made, a little every frame
+	scriptEngine->CollectGarbage(SCRIPT_GC_BUDGET_MILLISECS);
+
+	TrackMemory();
+
+	// How far the rendered frame is between the last two ticks
+	interpolation = simulationAccumulator / deltaTime;
+}
+
+void Game::EmitCollisionSparks(Entity entity)
+{
+	if (!registry->IsAlive(entity))
+	{
+		return;
+	}
+	const auto& transform = entity.GetComponent<TransformComponent>();
+	const auto& collider = entity.GetComponent<BoxColliderComponent>();
+	const glm::vec2 center = transform.position + collider.offset + glm::vec2(collider.width, collider.height) * 0.5f;
+	particleSystem->EmitBurst(GetAssetHandle("bullet-image"), center, COLLISION_SPARK_COUNT, COLLISION_SPARK_SPEED, COLLISION_SPARK_LIFE_SECONDS, COLLISION_SPARK_SIZE);
+}
+
+World& Game::CreateWorld(const std::string& name, StorageMode storageMode)
+{
+	worlds.push_back(std::make_unique<World>(name, assetStore, jobSystem, frameClock->GetDeltaTime(), storageMode));
+	return *worlds.back();
+}
+
+void Game::SetSimulationTickRate(int ticksPerSecond)
+{
+	simulationTicksPerSecond = ticksPerSecond > 0 ? ticksPerSecond : SIMULATION_TICKS_PER_SECOND;
+}
+
+void Game::SetClock(std::unique_ptr<Clock> clock)
+{
+	if (clock)
+	{
+		this->clock = std::move(clock);
+	}
+}
+
+void Game::SetMaxSimulationTicks(uint32_t numTicks)
+{
+	maxSimulationTicks = numTicks;
+}
+
+void Game::SetTimeScale(double timeScale)
+{
+	frameClock->SetTimeScale(timeScale);
+}
+
+void Game::SetTimestampedInput(bool isTimestamped)
+{
+	isInputTimestamped = isTimestamped;
+}
+
+void Game::SetRenderBackend(RenderBackendType type)
+{
+	renderBackendType = type;
+}
+
+void Game::SetFramePacing(PresentMode presentMode, int targetFps)
+{
+	if (!isHeadless)
+	{
+		framePacer->Configure(presentMode, targetFps);
+	}
+}
+
+void Game::SetDeterministic(bool isDeterministic)
+{
+	this->isDeterministic = isDeterministic;
+}
+
+void Game::SetEventTap(int capacity)
+{
+	eventBus->SetTap(nullptr);
+	eventTap.reset();
+	if (capacity <= 0)
+	{
+		return;
+	}
+	eventTap = std::make_unique<EventTap>(capacity);
+	eventTap->Select<CollisionEnterEvent>();
+	eventTap->Select<CollisionStayEvent>();
+	eventTap->Select<CollisionExitEvent>();
+	eventTap->Select<AnimationMarkerEvent>();
+	eventBus->SetTap(eventTap.get());
+}
+
+void Game::SetFramePipelining(bool isPipelined)
+{
+	isFramePipelined = isPipelined;
+}
+
+void Game::SetSplitScreen(bool isSplitScreen)
+{
+	this->isSplitScreen = isSplitScreen;
+}
+
+void Game::SetCameraZoom(float zoom)
+{
+	cameraZoom = std::max(MIN_CAMERA_ZOOM, std::min(zoom, MAX_CAMERA_ZOOM));
+	for (auto& viewport: viewports)
+	{
+		viewport.zoom = cameraZoom;
+	}
+}
+
+void Game::SetAIThinkRate(float thinkRate)
+{
+	aiThinkRate = thinkRate;
+}
+
+void Game::SetBroadphaseCellSize(int cellSize)
+{
+	broadphaseCellSize = cellSize > 0 ? cellSize : DEFAULT_CELL_SIZE;
+}
+
+void Game::SetAutoTuneBroadphase(bool isAutoTuned)
+{
+	isBroadphaseAutoTuned = isAutoTuned;
+}
+
+void Game::SetSpatialSortInterval(double seconds)
+{
+	spatialSortTicks = seconds > 0.0 ? std::max(static_cast<uint32_t>(seconds * simulationTicksPerSecond), 1u) : 0;
+}
+
+void Game::SetPoolReserve(int capacity)
+{
+	registry->SetPoolReserve(capacity);
+}
+
+void Game::SetWindowMode(bool isFullscreen, int width, int height)
+{
+	this->isFullscreen = isFullscreen;
+	windowedWidth = width > 0 ? width : DEFAULT_WINDOW_WIDTH;
+	windowedHeight = height > 0 ? height : DEFAULT_WINDOW_HEIGHT;
+}
+
+void Game::SetRenderResolution(int renderHeight, bool isDynamic)
+{
+	resolutionScaler->Configure(renderHeight, isDynamic);
+}
+
+void Game::SetTextureStreamBudget(int megabytes)
+{
+	assetStore->SetTextureStreamBudget(static_cast<size_t>(std::max(megabytes, 0)) * 1024 * 1024);
+}
+
+void Game::SetTilemapDirect(bool isDirect)
+{
+	tilemap->SetDirect(isDirect);
+}
+
+void Game::SetFrameCapture(int interval)
+{
+	frameCapture->SetInterval(interval);
+}
+
+void Game::SetMemoryBudget(MemoryTag tag, size_t budgetBytes)
+{
+	memoryTracker->SetBudget(tag, budgetBytes);
+}
+
+void Game::SetAllocationBudget(int numAllocations)
+{
+	allocationBudget = numAllocations;
+	if (allocationBudget >= 0 && !AllocationTracker::IsEnabled())
+	{
+		Logger::War("The allocations are only counted in a build with ALLOCATIONS=1, the budget is never checked");
+	}
+}
+
+void Game::CheckAllocations()
+{
+	const AllocationCounts counts = AllocationTracker::EndFrame();
+	if (allocationBudget < 0 || !AllocationTracker::IsEnabled())
+	{
+		return;
+	}
+	if (allocationWarmupFrames > 0)
+	{
+		allocationWarmupFrames--;
+		return;
+	}
+	if (counts.numAllocations <= static_cast<uint64_t>(allocationBudget))
+	{
+		return;
+	}
+	numFramesOverAllocationBudget++;
+	if (numFramesOverAllocationBudget > ALLOCATION_REPORTED_FRAMES)
+	{
+		return;
+	}
+	LOGGER_ERROR("A frame made {} allocations ({} bytes), over its budget of {}", counts.numAllocations, counts.numBytes, allocationBudget);
+	// The scopes of the frame just ended, the outer ones include the ones nested in them
+	std::vector<ProfileStats> stats;
+	Profiler::GetStats(stats);
+	for (const auto& scopeStats: stats)
+	{
+		if (scopeStats.lastNumAllocations > 0)
+		{
+			LOGGER_ERROR("  {}: {} allocations ({} bytes)", scopeStats.name, scopeStats.lastNumAllocations, scopeStats.lastNumAllocatedBytes);
+		}
+	}
+}
+
+void Game::TrackMemory()
+{
+	memoryTracker->SetNumBytes(MEMORY_TAG_ECS, registry->GetMemoryUsage());
+	memoryTracker->SetNumBytes(MEMORY_TAG_TEXTURES, assetStore->GetNumTextureBytes());
+	memoryTracker->SetNumBytes(MEMORY_TAG_SCRIPTS, scriptEngine->GetStats().numBytesReserved);
+	memoryTracker->SetNumBytes(MEMORY_TAG_EVENTS, eventBus->GetMemoryUsage());
+	memoryTracker->SetNumBytes(MEMORY_TAG_LOGGER, Logger::GetMemoryUsage());
+}
+
+void Game::QuickSave()
+{
+	const Uint64 performanceCounterStart = SDL_GetPerformanceCounter();
+	// Apply the commands the systems recorded since the last tick, the snapshot doesn't hold them
+	registry->Update();
+	// Only the capture stalls the frame, the file is written by a worker
+	if (quickSaver->Save(*registry, *jobSystem, QUICKSAVE_FILE))
+	{
+		LOGGER_INFO("Quick saved {} entities, {} KB captured in {} ms", registry->GetNumEntities(), quickSaver->GetSize() / 1024,
+			(SDL_GetPerformanceCounter() - performanceCounterStart) * 1000.0 / SDL_GetPerformanceFrequency());
+	}
+}
+
+void Game::QuickLoad()
+{
+	const Uint64 performanceCounterStart = SDL_GetPerformanceCounter();
+	registry->Update();
+	if (quickSaver->Load(*registry, QUICKSAVE_FILE))
+	{
+		LOGGER_INFO("Quick loaded {} entities in {} ms", registry->GetNumEntities(),
+			(SDL_GetPerformanceCounter() - performanceCounterStart) * 1000.0 / SDL_GetPerformanceFrequency());
+	}
+}
+
+void Game::SetRandomSeed(uint32_t seed)
+{
+	randomSeed = seed;
+}
+
+void Game::RecordInput(const std::string& filePath)
+{
+	inputRecordingFilePath = filePath;
+}
+
+bool Game::ReplayInput(const std::string& filePath)
+{
+	inputReplay = std::make_unique<InputReplay>();
+	if (!inputReplay->Open(filePath))
+	{
+		inputReplay.reset();
+		return false;
+	}
+	const InputRecordingHeader& header = inputReplay->GetHeader();
+	randomSeed = header.randomSeed;
+	isDeterministic = (header.flags & INPUT_RECORDING_DETERMINISTIC) != 0;
+	SetSimulationTickRate(header.ticksPerSecond);
+	if (header.scenarioName[0] != '\0')
+	{
+		SetScenario(header.scenarioName, header.scenarioSize, header.scenarioSeed);
+	}
+	// Reports on the tick times like the scenarios, the same replay on two builds compares them
+	scenarioReport = std::make_unique<ScenarioReport>();
+	maxSimulationTicks = header.numTicks > 0 ? header.numTicks : inputReplay->GetLastTick() + 1;
+	return true;
+}
+
+bool Game::HostServer(uint16_t port)
+{
+	networkServer = std::make_unique<NetworkServer>();
+	if (!networkServer->Start(port, simulationTicksPerSecond))
+	{
+		networkServer.reset();
+		return false;
+	}
+	return true;
+}
+
+bool Game::JoinServer(const std::string& hostName, uint16_t port)
+{
+	networkClient = std::make_unique<NetworkClient>();
+	if (!networkClient->Connect(hostName, port, simulationTicksPerSecond))
+	{
+		networkClient.reset();
+		return false;
+	}
+	networkPrediction = std::make_unique<NetworkPrediction>();
+	return true;
+}
+
+void Game::SetScenario(const std::string& name, int size, uint32_t seed)
+{
+	scenarioName = name;
+	scenarioSize = size;
+	scenarioSeed = seed;
+	scenarioReport = std::make_unique<ScenarioReport>();
+}
+
+void Game::SetScenarioReportFile(const std::string& filePath)
+{
+	scenarioReportFilePath = filePath;
+}
+
+void Game::UploadAssets()
+{
+	// The tilemap is baked once its tileset is there and again when a changed file or another
+	// mip of it was swapped in. The frame drawn last was submitted, its textures may be evicted.
+	PROFILE_SCOPE("Asset uploads");
+	assetStore->UpdateTextureStreaming(*jobSystem);
+	assetStore->ProcessLoadedTextures(renderer, ASSET_UPLOAD_BUDGET_MILLISECS);
+	if (assetStore->ProcessHotReloads(renderer) > 0 || !tilemap->IsBaked() || tilemap->IsTilesetChanged(*assetStore))
+	{
+		tilemap->Bake(renderer, assetStore);
+	}
+}
+
+void Game::AnimateTiles(const LevelTilemap& levelTilemap)
+{
+	std::vector<TileAnimation> animations;
+	for (const auto& animatedTile: levelTilemap.animatedTiles)
+	{
+		animations.push_back({animatedTile.frames, animatedTile.frameSpeedRate});
+	}
+	tilemap->SetTileAnimations(animations);
+}
+
+void Game::BuildNavigationGrid(const LevelTilemap& levelTilemap)
+{
+	// The whole map even when the tilemap is streamed, a cell is a bit
+	const char* mapData;
+	size_t mapSize;
+	std::vector<char> fileData;
+	if (!assetStore->GetPackedFile(levelTilemap.mapFilePath, mapData, mapSize))
+	{
+		std::ifstream mapFile(levelTilemap.mapFilePath, std::ios::binary);
+		fileData.assign(std::istreambuf_iterator<char>(mapFile), std::istreambuf_iterator<char>());
+		mapData = fileData.data();
+		mapSize = fileData.size();
+	}
+
+	// Baked beside the map and mapped shared, the instances of a server box hold one copy of
+	// the grid between them. The first one to load the map, or a changed map, bakes it.
+	const float cellSize = static_cast<float>(levelTilemap.tileSize * levelTilemap.tileScale);
+	const uint64_t sourceHash = HashNavigationSource(mapData, mapSize, levelTilemap.blockedTiles, cellSize);
+	const std::string bakedFilePath = levelTilemap.mapFilePath + ".nav";
+	auto grid = std::make_shared<NavigationGrid>();
+	auto bakedFile = std::make_shared<MappedFile>();
+	if (!bakedFile->Open(bakedFilePath) || !grid->MapBaked(bakedFile, sourceHash))
+	{
+		TilemapData tilemapData;
+		ParseTilemap(mapData, mapSize, tilemapData);
+		grid->Build(tilemapData, levelTilemap.blockedTiles, cellSize);
+		// Mapped back once written, this instance shares it too. Unwritable, the grid is kept as built.
+		const std::vector<char> baked = grid->WriteBaked(sourceHash);
+		if (MappedFile::WriteFile(bakedFilePath, baked.data(), baked.size()) && bakedFile->Open(bakedFilePath))
+		{
+			grid->MapBaked(bakedFile, sourceHash);
+		}
+	}
+	// Clustered like the streamed chunks, a map of one chunk is searched directly
+	std::shared_ptr<NavigationHierarchy> hierarchy;
+	const int clusterSize = TILEMAP_CHUNK_SIZE / std::max(levelTilemap.tileSize, 1);
+	if (grid->GetNumCols() > clusterSize || grid->GetNumRows() > clusterSize)
+	{
+		hierarchy = std::make_shared<NavigationHierarchy>();
+		hierarchy->Build(*grid, clusterSize, *jobSystem);
+	}
+	pathfinder->SetGrid(grid, hierarchy);
+	flowFieldTracker->SetGrid(grid);
+	Logger::Log("Navigation grid of " + std::to_string(grid->GetNumCols()) + "x" + std::to_string(grid->GetNumRows()) + " cells, " + std::to_string(grid->GetWalkableCount()) + " walkable"
+		+ (grid->IsMapped() ? ", mapped from " + bakedFilePath : ""));
+	if (hierarchy)
+	{
+		Logger::Log("Navigation hierarchy of " + std::to_string(hierarchy->GetNumClusters()) + " clusters, " + std::to_string(hierarchy->GetNumNodes()) + " entrance nodes");
+	}
+}
+
+void Game::RecordFrame()
+{
+	PROFILE_SCOPE("Render");
+	frameCommands.Clear({21, 21, 21, 255});
+	latencyTracker->OnFrameRecorded();
+
+	// The changes of the last tick are only committed by the next Update, the renderer needs them now
+	registry->CommitChanges();
+
+	// Inkove all the systems that need to render
+	registry->GetSystem<CameraMovementSystem>().Update(*registry, viewports, interpolation, frameMillisecs / 1000.0);
+	camera = GetCamerasBounds(viewports);
+	{
+		PROFILE_SCOPE("Tilemap");
+		tilemap->UpdateStreaming(renderer, assetStore, *jobSystem, camera);
+		minimap->Update(renderer, *tilemap);
+		minimap->UpdateBlips(registry->GetSystem<CollisionSystem>().GetBroadphase(), frameClock->GetMillisecs() / 1000.0);
+		// Only when an observer changed cell since, the simulation is waited for
+		fogOfWar->Upload(renderer);
+	}
+	{
+		// The sprites under every camera are culled in a single pass
+		PROFILE_SCOPE("Culling");
+		registry->GetSystem<RenderSystem>().Update(*registry, assetStore, viewports, interpolation);
+		registry->GetSystem<RenderTextSystem>().Update(*registry);
+	}
+	for (int i = 0; i < static_cast<int>(viewports.size()); i++)
+	{
+		const Viewport& viewport = viewports[i];
+		frameCommands.SetViewport(&viewport.screenRect, viewport.zoom);
+		{
+			PROFILE_SCOPE("RenderSystem");
+			// Nothing is under the tilemap but the clear and the far layers, they are skipped when the tiles fill the view
+			const double time = frameClock->GetMillisecs() / 1000.0;
+			parallaxLayers->Render(frameCommands, *assetStore, viewport.camera, time, false);
+			const int firstTileCommand = frameCommands.GetNumCommands();
+			if (tilemap->Render(frameCommands, viewport.camera, time))
+			{
+				frameCommands.AddOpaqueLayer(firstTileCommand);
+			}
+			registry->GetSystem<RenderSystem>().Render(frameCommands, i);
+			particleSystem->Render(frameCommands, *assetStore, viewport.camera, frameClock->GetDeltaTime(), interpolation);
+			parallaxLayers->Render(frameCommands, *assetStore, viewport.camera, time, true);
+			fogOfWar->Render(frameCommands, viewport.camera);
+		}
+		{
+			// The overlay over the world: the health bars in one batch, then the labels
+			PROFILE_SCOPE("HUD");
+			registry->GetSystem<RenderHealthBarSystem>().Update(frameCommands, viewport.camera, interpolation);
+			registry->GetSystem<RenderTextSystem>().Render(frameCommands, *assetStore, viewport.camera, interpolation);
+		}
+		if (isDebug)
+		{
+			registry->GetSystem<RenderColliderSystem>().Update(frameCommands, viewport.camera, interpolation, isDebugBroadphase ? &registry->GetSystem<CollisionSystem>().GetBroadphase() : nullptr);
+		}
+	}
+	frameCommands.SetViewport(nullptr);
+	{
+		// The fixed widgets and the minimap over all the viewports
+		PROFILE_SCOPE("HUD");
+		registry->GetSystem<RenderSystem>().RenderWidgets(frameCommands);
+		registry->GetSystem<RenderTextSystem>().RenderFixed(frameCommands, *assetStore, windowWidth, windowHeight, interpolation);
+		minimap->Render(frameCommands, viewports, windowWidth, windowHeight);
+	}
+	if (isDebug)
+	{
+		PROFILE_SCOPE("Debug GUI");
+
+		// The draw data stays valid until the next frame is recorded
+		ImGui::GetIO().DeltaTime = static_cast<float>(std::max(frameMillisecs, 1.0) / 1000.0);
+		ImGui::NewFrame();
+		logConsole->Render(*frameArena);
+		entityInspector->Render(*registry);
+		const auto& renderSystem = registry->GetSystem<RenderSystem>();
+		performanceOverlay->Render(*registry, *scheduler, *jobSystem, *eventBus, {renderSystem.GetNumSprites(), renderSystem.GetNumDrawCalls(), particleSystem->GetNumParticles(), particleSystem->GetNumDrawCalls(), resolutionScaler->GetScale(windowHeight)}, registry->GetSystem<CollisionSystem>().GetBroadphaseStats(), scriptEngine->GetStats(), *frameArena, *memoryTracker, *latencyTracker);
+		ImGui::Render();
+		frameCommands.SetDebugGui(true);
+	}
+	isFramePending = true;
+}
+
+void Game::SubmitFrame()
+{
+	const Uint64 performanceCounterStart = SDL_GetPerformanceCounter();
+	{
+		PROFILE_SCOPE("Submit");
+		// The debug GUI stays at the window's resolution, over the stretched frame
+		const float resolutionScale = resolutionScaler->Begin(renderer, windowWidth, windowHeight);
+		frameCommands.Submit(renderer, resolutionScale);
+		resolutionScaler->End(renderer);
+	}
+	// Timed apart and left out of the frame time the resolution follows, the debug tools
+	// shouldn't change what they measure
+	Uint64 debugGuiTicks = 0;
+	if (frameCommands.HasDebugGui() && ImGui::GetDrawData()->TotalVtxCount > 0)
+	{
+		PROFILE_SCOPE("Debug GUI submit");
+		const Uint64 debugGuiStart = SDL_GetPerformanceCounter();
+		ImGuiSDL::Render(ImGui::GetDrawData());
+		debugGuiTicks = SDL_GetPerformanceCounter() - debugGuiStart;
+	}
+	{
+		// Only the read back, the images are written on the workers
+		PROFILE_SCOPE("Capture");
+		frameCapture->Capture(renderer, *jobSystem);
+	}
+	{
+		// Waits for the vertical sync when it is on, kept apart from the render time
+		PROFILE_SCOPE("Present");
+		SDL_RenderPresent(renderer);
+	}
+	latencyTracker->OnFramePresented(SDL_GetTicks());
+	isFramePending = false;
+
+	// SDL has no GPU timers, the driver's work shows in the submit and in the present that
+	// waits for it. A capped frame rate is the budget, else a frame at the default rate.
+	const double renderMillisecs = (SDL_GetPerformanceCounter() - performanceCounterStart - debugGuiTicks) * 1000.0 / SDL_GetPerformanceFrequency();
+	const double budgetMillisecs = framePacer->GetTargetFrameMillisecs();
+	resolutionScaler->AddFrameTime(renderMillisecs, budgetMillisecs > 0.0 ? budgetMillisecs : 1000.0 / DEFAULT_TARGET_FPS);
+}
+
+void Game::StartSimulation()
+{
+	if (!simulationThread.joinable())
+	{
+		simulationThread = std::thread(&Game::SimulationLoop, this);
+	}
+	{
+		std::unique_lock<std::mutex> lock(simulationMutex);
+		isSimulationRequested = true;
+	}
+	simulationChanged.notify_all();
+}
+
+void Game::WaitForSimulation()
+{
+	std::unique_lock<std::mutex> lock(simulationMutex);
+	simulationChanged.wait(lock, [this]() { return !isSimulationRequested; });
+}
+
+void Game::SimulationLoop()
+{
+#ifdef ENABLE_PROFILER
+	Profiler::SetThreadName("Simulation");
+#endif
+	std::unique_lock<std::mutex> lock(simulationMutex);
+	while (true)
+	{
+		simulationChanged.wait(lock, [this]() { return isSimulationRequested || isSimulationStopping; });
+		if (isSimulationStopping)
+		{
+			return;
+		}
+		lock.unlock();
+		Update();
+		lock.lock();
+		isSimulationRequested = false;
+		simulationChanged.notify_all();
+	}
+}
+
+void Game::Run()
+{
+	Setup();
+	millisecsPreviousFrame = clock->GetMillisecs();
+	const Uint64 performanceCounterStart = SDL_GetPerformanceCounter();
+	bool isFrameShown = false;
+	while (isRunning)
+	{
+		ProcessInput();
+		// The SDL calls the workers queued for the main thread
+		jobSystem->RunMainThreadJobs();
+		if (IsLoadingLevel())
+		{
+			// The simulation waits for the level, the window keeps showing how far it got
+			if (ContinueLevelLoad(false))
+			{
+				// The time spent loading isn't caught up
+				millisecsPreviousFrame = clock->GetMillisecs();
+			}
+			UploadAssets();
+			RecordLoadingScreen();
+			SubmitFrame();
+			isFrameShown = true;
+		}
+		else if (isHeadless)
+		{
+			Update();
+			// Nothing is drawn, the input counts as shown once simulated
+			latencyTracker->OnFrameRecorded();
+			latencyTracker->OnFramePresented(SDL_GetTicks());
+		}
+		else
+		{
+			// The frame recorded last is submitted while the simulation runs the next one. A
+			// replay handles its events in the simulation and may load a level meanwhile.
+			const bool isPipelined = isFramePipelined && isFramePending && !inputReplay;
+			if (isPipelined)
+			{
+				StartSimulation();
+			}
+			if (isFramePending)
+			{
+				SubmitFrame();
+				isFrameShown = true;
+			}
+			if (isPipelined)
+			{
+				WaitForSimulation();
+			}
+			else
+			{
+				Update();
+			}
+			UploadAssets();
+			RecordFrame();
+			if (!isFramePipelined)
+			{
+				// Shown in the frame its input came in
+				SubmitFrame();
+				isFrameShown = true;
+			}
+		}
+		// Once the first frame is out, the gamepads the player may only touch later start
+		if (!startupReport->IsFinished() && (isHeadless || isFrameShown))
+		{
+			if (!isHeadless)
+			{
+				StartupReport::Scope scope(*startupReport, "Gamepads");
+				SDL_InitSubSystem(SDL_INIT_GAMECONTROLLER);
+			}
+			startupReport->Finish();
+		}
+		PROFILE_END_FRAME();
+		if (scenarioReport)
+		{
+			scenarioReport->AddFrame();
+		}
+		FlightRecorder::RecordFrame(frameClock->GetTick(), frameMillisecs, static_cast<uint32_t>(inputState->GetActions().to_ulong()), *eventBus);
+		CheckAllocations();
+		frameArena->Reset();
+	}
+
+	inputRecorder->Close(frameClock->GetTick());
+	if (networkServer)
+	{
+		networkServer->Stop();
+	}
+	if (networkClient)
+	{
+		networkClient->Disconnect();
+	}
+
+	const double millisecs = (SDL_GetPerformanceCounter() - performanceCounterStart) * 1000.0 / SDL_GetPerformanceFrequency();
+	if (scenarioReport)
+	{
+		scenarioReport->Log(inputReplay ? "replay" : scenarioName, millisecs, registry->GetNumEntities());
+		if (!scenarioReportFilePath.empty() && !scenarioReport->WriteSamples(scenarioReportFilePath))
+		{
+			Logger::Err("Unable to write the scenario report " + scenarioReportFilePath);
+		}
+	}
+	if (inputReplay && inputReplay->HasChecksums())
+	{
+		if (numDesyncedTicks > 0)
+		{
+			Logger::Err("The replay differed from its recording on " + std::to_string(numDesyncedTicks) + " ticks");
+		}
+		else
+		{
+			Logger::Log("The replay matched its recording on every tick");
+		}
+	}
+	else if (isHeadless)
+	{
+		LOGGER_INFO("Simulated {} ticks in {} ms", frameClock->GetTick(), millisecs);
+	}
+	latencyTracker->LogReport();
+	if (numFramesOverAllocationBudget > 0)
+	{
+		LOGGER_ERROR("{} frames went over the allocation budget", numFramesOverAllocationBudget);
+	}
+	if (isHeadless)
+	{
+		LOGGER_INFO("Checksum {} of the last tick, {} of the run", tickChecksum, runChecksum);
+		memoryTracker->LogReport();
+	}
+}
+
+void Game::Destroy()
+{
+	if (simulationThread.joinable())
+	{
+		{
+			std::unique_lock<std::mutex> lock(simulationMutex);
+			isSimulationStopping = true;
+		}
+		simulationChanged.notify_all();
+		simulationThread.join();
+	}
+	if (Profiler::IsCapturing())
+	{
+		Profiler::EndCapture(PROFILE_CAPTURE_FILE);
+	}
+	Profiler::LogReport();
+	EventTrace::Close();
+	tilemap->Clear();
+	fogOfWar->Clear();
+	if (!isHeadless)
+	{
+		minimap->Clear();
+		resolutionScaler->ReleaseTexture();
+		inputState->SetTimestamped(false);
+		ImGuiSDL::Deinitialize();
+		ImGui::DestroyContext();
+		SDL_DestroyRenderer(renderer);
+		SDL_DestroyWindow(window);
+		TTF_Quit();
+	}
+	// The level prefetched for nothing, when the game quits before loading it
+	TakeLevelPrefetch(0);
+	audioEngine->Close();
 	SDL_Quit();
 }
@@ -2,43 +2,394 @@
 #define GAME_H
 
 #include "../ECS/ECS.h"
+#include "../ECS/EntityPool.h"
 #include "../AssetStore/AssetStore.h"
+#include "../Audio/AudioEngine.h"
 #include "../EventBus/EventBus.h"
+#include "../Jobs/JobSystem.h"
+#include "../Scheduler/Scheduler.h"
+#include "../Tilemap/Tilemap.h"
+#include "../Tilemap/Minimap.h"
+#include "../Tilemap/FogOfWar.h"
+#include "../Renderer/ParallaxLayers.h"
+#include "../Navigation/Pathfinder.h"
+#include "../Navigation/FlowField.h"
+#include "../Debug/LogConsole.h"
+#include "../Debug/PerformanceOverlay.h"
+#include "../Debug/EntityInspector.h"
+#include "../Clock/Clock.h"
+#include "../Clock/FrameClock.h"
+#include "../Clock/FramePacer.h"
+#include "../Clock/TimerWheel.h"
+#include "../Scenario/Scenario.h"
+#include "../Scripting/ScriptEngine.h"
+#include "../Particles/ParticleSystem.h"
+#include "../World/World.h"
+#include "../Memory/FrameArena.h"
+#include "../Memory/MemoryTracker.h"
+#include "../Memory/AllocationTracker.h"
+#include "../Snapshot/SnapshotSaver.h"
+#include "../Input/InputRecording.h"
+#include "../Input/InputState.h"
+#include "../Network/NetworkServer.h"
+#include "../Network/NetworkClient.h"
+#include "../Network/NetworkPrediction.h"
+#include "../Renderer/RenderBackend.h"
+#include "../Renderer/RenderCommandList.h"
+#include "../Renderer/Viewport.h"
+#include "../Renderer/ResolutionScaler.h"
+#include "../Renderer/FrameCapture.h"
+#include "../Profiler/LatencyTracker.h"
+#include "../Profiler/StartupReport.h"
+#include "EngineConfig.h"
 #include <SDL2/SDL.h>
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
 
-const int FPS = 60;
-const int MILLISECS_PER_FRAME = 1000 / FPS;
+struct LevelTilemap;
+struct LevelData;
+
+// The simulation runs at a fixed rate, independent from the rendering frame rate
+const int SIMULATION_TICKS_PER_SECOND = 120;
+// Ticks run at most per frame, after a long stall the simulation slows down instead of
+// spending the next frames catching up
+const int MAX_SIMULATION_TICKS_PER_FRAME = 8;
+
+// Time spent each frame uploading the textures decoded in the background
+const double ASSET_UPLOAD_BUDGET_MILLISECS = 2.0;
+// Time the Lua garbage collector may take each frame
+const double SCRIPT_GC_BUDGET_MILLISECS = 0.5;
+// Time a frame of the loading screen spends creating the level's entities, in chunks
+const double LEVEL_LOAD_BUDGET_MILLISECS = 8.0;
+const int LEVEL_LOAD_ENTITY_CHUNK = 256;
+// Of the loading bar, the files read and decoded on the workers, the entities take the rest
+const float LEVEL_LOAD_FILES_SHARE = 0.8f;
+
+// Where a level load is, see Game::LoadLevelAsync
+enum LevelLoadStage
+{
+	LEVEL_LOAD_NONE,
+	// Waiting for the workers to read the level file, decode its images and compile its scripts
+	LEVEL_LOAD_FILES,
+	// Creating its entities a slice per frame
+	LEVEL_LOAD_ENTITIES
+};
+
+// Sparks thrown where two colliders start touching
+const int COLLISION_SPARK_COUNT = 16;
+const float COLLISION_SPARK_SPEED = 120.0f;
+const float COLLISION_SPARK_LIFE_SECONDS = 0.4f;
+const float COLLISION_SPARK_SIZE = 3.0f;
+
+// The entity the flow field leads to
+const std::string FLOW_FIELD_GOAL_TAG = "player";
+
+// How many times per second each enemy thinks by default
+const float AI_DEFAULT_THINK_RATE = 10.0f;
+
+// Binary trace of the gameplay events, decoded by make tracedecoder
+const std::string EVENT_TRACE_FILE = "./eventtrace.bin";
+// Profiler capture toggled with F9, opens in chrome://tracing or ui.perfetto.dev
+const std::string PROFILE_CAPTURE_FILE = "./profile.json";
+// Quick save with F6 and quick load with F7, the last save is also kept in memory
+const std::string QUICKSAVE_FILE = "./quicksave.bin";
+
+// Seeds the randomness of the gameplay, so the input recordings replay the same game
+const uint32_t DEFAULT_RANDOM_SEED = 1;
+
+// The view a headless game simulates, there is no display to take the size from
+const int HEADLESS_WINDOW_WIDTH = 1280;
+const int HEADLESS_WINDOW_HEIGHT = 720;
+
+// The zoom is multiplied or divided by it on each press of + or -
+const float CAMERA_ZOOM_STEP = 1.25f;
 
 class Game
 {
 private:
 	bool isRunning;
 	bool isDebug;
-	int millisecsPreviousFrame = 0;
-	SDL_Window* window;
-	SDL_Renderer* renderer;
+	// Draws the cells of the broadphase under the colliders in the debug view
+	bool isDebugBroadphase;
+	bool isHeadless;
+	double millisecsPreviousFrame = 0.0;
+	// Of the last frame, for the debug GUI
+	double frameMillisecs = 0.0;
+	double simulationAccumulator = 0.0;
+	double interpolation = 1.0;
+	int simulationTicksPerSecond = SIMULATION_TICKS_PER_SECOND;
+	int loadedLevel = 0;
+	// The level being loaded over the frames, its data once the files are in
+	LevelLoadStage levelLoadStage = LEVEL_LOAD_NONE;
+	int loadingLevel = 0;
+	std::unique_ptr<LevelData> loadingLevelData;
+	size_t numLevelEntitiesCreated = 0;
+	Uint64 levelLoadPerformanceCounter = 0;
+	uint32_t maxSimulationTicks = 0;
+	bool isInputTimestamped = false;
+	// The parallel systems queue their events and commands in a fixed order, and the registry
+	// is checksummed after each tick of a recording or a replay
+	bool isDeterministic = false;
+	// Of the replay, where its checksums differed from the recording's
+	uint32_t numDesyncedTicks = 0;
+	// A headless run checksums every tick, and folds the checksums into one for the whole run
+	// so two builds compare with a single line of their logs
+	uint64_t tickChecksum = 0;
+	uint64_t runChecksum = 0;
+	// Allocations a frame may make once the level is warmed up, -1 when they aren't checked
+	int allocationBudget = -1;
+	int allocationWarmupFrames = ALLOCATION_WARMUP_FRAMES;
+	uint32_t numFramesOverAllocationBudget = 0;
+	RenderBackendType renderBackendType = RENDER_BACKEND_AUTO;
+	SDL_Window* window = nullptr;
+	SDL_Renderer* renderer = nullptr;
+	// The area all the viewports look at, what the streaming, the audio and the activity follow
 	SDL_Rect camera;
+	// Side by side halves of the window, each following its own entity
+	bool isSplitScreen = false;
+	float cameraZoom = 1.0f;
+	std::vector<Viewport> viewports;
+	// Thoughts per enemy per second
+	float aiThinkRate = AI_DEFAULT_THINK_RATE;
+	int broadphaseCellSize = DEFAULT_CELL_SIZE;
+	bool isBroadphaseAutoTuned = true;
+	// Ticks between two sorts of the components by position, 0 for none
+	uint32_t spatialSortTicks = 0;
+	uint32_t nextSpatialSortTick = 0;
+	// Borderless over the whole display, or a window of the size given
+	bool isFullscreen = true;
+	int windowedWidth = DEFAULT_WINDOW_WIDTH;
+	int windowedHeight = DEFAULT_WINDOW_HEIGHT;
 
+	// What the last frame draws, recorded once its simulation is done and submitted while the
+	// simulation of the next one runs
+	RenderCommandList frameCommands;
+	bool isFramePending = false;
+	// Else a frame is submitted as soon as it is recorded
+	bool isFramePipelined = true;
+	// The simulation runs there meanwhile, SDL only renders from the thread of the renderer
+	std::thread simulationThread;
+	std::mutex simulationMutex;
+	std::condition_variable simulationChanged;
+	bool isSimulationRequested = false;
+	bool isSimulationStopping = false;
+
+	std::unique_ptr<Clock> clock;
+	std::unique_ptr<FramePacer> framePacer;
+	std::unique_ptr<FrameClock> frameClock;
+	std::unique_ptr<TimerWheel> timerWheel;
 	std::unique_ptr<Registry> registry;
+	std::unique_ptr<EntityPool> projectilePool;
+	std::unique_ptr<EntityPool> wreckPool;
 	std::unique_ptr<AssetStore> assetStore;
+	std::unique_ptr<AudioEngine> audioEngine;
+	std::unique_ptr<ScriptEngine> scriptEngine;
 	std::unique_ptr<EventBus> eventBus;
+	// Copies the collision and animation events, only with --tapevents
+	std::unique_ptr<EventTap> eventTap;
+	std::unique_ptr<JobSystem> jobSystem;
+	std::unique_ptr<Scheduler> scheduler;
+	std::unique_ptr<Tilemap> tilemap;
+	std::unique_ptr<Minimap> minimap;
+	// Hides the map but around the entities with a vision, when the level asks for it
+	std::unique_ptr<FogOfWar> fogOfWar;
+	// The textures repeated behind and over the world
+	std::unique_ptr<ParallaxLayers> parallaxLayers;
+	// Draws the frames under the window's resolution and stretches them over it
+	std::unique_ptr<ResolutionScaler> resolutionScaler;
+	// The screenshots and the continuous capture, written on the workers
+	std::unique_ptr<FrameCapture> frameCapture;
+	// Finds the paths of the units on the workers, over the grid of the level's tilemap
+	std::unique_ptr<Pathfinder> pathfinder;
+	// The way to the player from anywhere on the grid, shared by the units rushing it
+	std::unique_ptr<FlowFieldTracker> flowFieldTracker;
+	std::unique_ptr<ParticleSystem> particleSystem;
+	std::unique_ptr<LogConsole> logConsole;
+	std::unique_ptr<PerformanceOverlay> performanceOverlay;
+	std::unique_ptr<EntityInspector> entityInspector;
+	// Scratch memory of the systems, taken back at the end of every frame
+	std::unique_ptr<FrameArena> frameArena;
+	std::unique_ptr<MemoryTracker> memoryTracker;
+	std::unique_ptr<SnapshotSaver> quickSaver;
+	uint32_t randomSeed = DEFAULT_RANDOM_SEED;
+	std::string inputRecordingFilePath;
+	std::unique_ptr<InputRecorder> inputRecorder;
+	// The actions held and pressed on the current tick, what the gameplay reads
+	std::unique_ptr<InputState> inputState;
+	// Set while the input of a recording is played instead of the player's
+	std::unique_ptr<InputReplay> inputReplay;
+	// Set on the server the clients connect to, or on a client, which only shows the server's state
+	std::unique_ptr<NetworkServer> networkServer;
+	std::unique_ptr<NetworkClient> networkClient;
+	std::unique_ptr<NetworkPrediction> networkPrediction;
+	// Simulations stepped alongside the game's, declared last so they go before what they share
+	std::vector<std::unique_ptr<World>> worlds;
+	EventSubscription debugInputSubscription;
+	EventSubscription collisionEffectSubscription;
+
+	// The level is replaced by a stress scenario when one is set
+	std::string scenarioName;
+	int scenarioSize = 0;
+	uint32_t scenarioSeed = SCENARIO_DEFAULT_SEED;
+	std::unique_ptr<ScenarioReport> scenarioReport;
+	// Where the samples of the report are written once the run is over, none when empty
+	std::string scenarioReportFilePath;
+
+	// Where the time to the first frame goes
+	std::unique_ptr<StartupReport> startupReport;
+	// From the live input to the frame showing it on screen
+	std::unique_ptr<LatencyTracker> latencyTracker;
+	// The first level, read, decoded and compiled on the workers while SDL starts
+	struct LevelPrefetch;
+	std::future<std::unique_ptr<LevelPrefetch>> levelPrefetch;
+	// Of the files of the prefetched level, counted by the workers as they are done
+	std::atomic<int> numLevelFiles{0};
+	std::atomic<int> numLevelFilesLoaded{0};
+
+	// Samples the memory held by each subsystem, once a frame
+	void TrackMemory();
+	// Checks the allocations of the frame against the budget, once the frame is over
+	void CheckAllocations();
+	void QuickSave();
+	void QuickLoad();
+	void HandleEvent(const SDL_Event& sdlEvent);
+	void EmitCollisionSparks(Entity entity);
+	// Handles the replayed events recorded before the current tick
+	void PlayRecordedInput();
+	// Runs Update() on the simulation thread, nothing else may touch the game's state until
+	// WaitForSimulation() returns
+	void StartSimulation();
+	void WaitForSimulation();
+	void SimulationLoop();
+	// The textures decoded since the last frame, and the ones hot reloaded
+	void UploadAssets();
+	// Loads the level on the workers, LoadLevel takes it if it is the level it loads
+	void PrefetchLevel(int level);
+	// The prefetched level if it is this one, nothing otherwise
+	std::unique_ptr<LevelPrefetch> TakeLevelPrefetch(int level);
+	// Unloads the current level and starts on this one, LoadLevel and LoadLevelAsync finish it
+	void BeginLevelLoad(int level);
+	// Adds the level's assets, map and scripts to the game, the entities aside, which are
+	// left in levelData. False when there are no entities to create.
+	bool SetUpLevel(int level, LevelData& levelData);
+	// Takes the load a step further, until the level is loaded when blocking, else for a
+	// frame's budget at most. True once the level is loaded.
+	bool ContinueLevelLoad(bool isBlocking);
+	// In [0, 1], of the load going on
+	float GetLevelLoadProgress() const;
+	// The progress bar drawn instead of the world while a level loads
+	void RecordLoadingScreen();
+	// Hands the level's animated tiles to the tilemap, once its map is loaded
+	void AnimateTiles(const LevelTilemap& levelTilemap);
+	// The walkable cells of the level's map, from the same file as the tilemap
+	void BuildNavigationGrid(const LevelTilemap& levelTilemap);
 
 public:
-	Game();
+	// A headless game has no window, renderer or debug GUI and only runs the simulation. The
+	// job system gets numWorkers threads, 0 for JobSystem::DefaultNumWorkers, pinned one per
+	// core when isWorkerPinned.
+	Game(bool isHeadless = false, int numWorkers = 0, bool isWorkerPinned = false);
 	~Game();
 	void Initialize();
 	void Run();
 	void Setup();
+	// Loading a level unloads the one loaded before
 	void LoadLevel(int level);
+	// Same, without stalling: the files are read and decoded on the workers and the entities
+	// are created a slice per frame, while Run draws a loading screen instead of updating
+	void LoadLevelAsync(int level);
+	bool IsLoadingLevel() const;
+	void UnloadLevel();
 	void ProcessInput();
 	void Update();
-	void Render();
+	void SetSimulationTickRate(int ticksPerSecond);
+	// Headless games default to a manual clock and run as fast as they can, a dedicated
+	// server that has to keep the pace sets a system clock
+	void SetClock(std::unique_ptr<Clock> clock);
+	// Stops the game after this many ticks, 0 runs until it quits
+	void SetMaxSimulationTicks(uint32_t numTicks);
+	// Above 1 the simulation fast forwards by running more ticks per frame
+	void SetTimeScale(double timeScale);
+	// Gives each tick the keys pressed in its own slice of the frame instead of the keyboard
+	// state at the time it runs, with a window only and not while replaying
+	void SetTimestampedInput(bool isTimestamped);
+	// The GPU driver rendering the window, another one is used when the platform lacks it
+	void SetRenderBackend(RenderBackendType type);
+	// With a window only, a headless game keeps the default pace its manual clock moves by
+	void SetFramePacing(PresentMode presentMode, int targetFps);
+	// Simulates the next frame while this one is submitted, for a frame of latency
+	void SetFramePipelining(bool isPipelined);
+	// Splits the window between two viewports, the second follows the entities given
+	// camera_follow = { viewport = 1 }
+	void SetSplitScreen(bool isSplitScreen);
+	// Window pixels per world pixel of every viewport, within MIN_CAMERA_ZOOM and MAX_CAMERA_ZOOM
+	void SetCameraZoom(float zoom);
+	// How many times per second each enemy thinks, 0 or less for every tick
+	void SetAIThinkRate(float thinkRate);
+	// Of the spatial hash the moving colliders are sorted into, in world pixels
+	void SetBroadphaseCellSize(int cellSize);
+	// Lets the collision system retune its broadphase as the colliders change, see BroadphaseTuner
+	void SetAutoTuneBroadphase(bool isAutoTuned);
+	// Seconds between two sorts of the components by where their entities are, see
+	// SpatialSortSystem. 0 or less never sorts them. After the tick rate is set.
+	void SetSpatialSortInterval(double seconds);
+	// Components the pools have room for before they grow, for the pools created from now on
+	void SetPoolReserve(int capacity);
+	// Fullscreen by default, set before Initialize
+	void SetWindowMode(bool isFullscreen, int width, int height);
+	// The height the frames are drawn at when the window is taller, 0 for the window's. The
+	// dynamic resolution draws less when the frames go over the frame time.
+	void SetRenderResolution(int renderHeight, bool isDynamic);
+	// The tilemap drawn tile by tile from its tileset in one batch, instead of from the chunk
+	// textures baked from it. Set before Initialize.
+	void SetTilemapDirect(bool isDirect);
+	// Captures every Nth frame submitted as a numbered PNG, 0 only on F12
+	void SetFrameCapture(int interval);
+	// Loads a scenario instead of the level and reports on it at the end of the run
+	void SetScenario(const std::string& name, int size, uint32_t seed);
+	// The tick and profiler scope samples of a scenario or a replay, see ScenarioReport::WriteSamples
+	void SetScenarioReportFile(const std::string& filePath);
+	// Seeds the particles and the scripts
+	void SetRandomSeed(uint32_t seed);
+	// The same simulation whatever the number of workers, checked tick by tick when the input
+	// is recorded and replayed. A replay takes the mode of its recording. Set before Initialize.
+	void SetDeterministic(bool isDeterministic);
+	// Copies the collision and animation events into a ring of the capacity, the overlay shows
+	// how many, 0 copies none
+	void SetEventTap(int capacity);
+	// Records the input of the session, with what it takes to replay it
+	void RecordInput(const std::string& filePath);
+	// Plays the input of a recording instead of the player's, with its seed, tick rate and
+	// scenario. The game stops at the tick the recording ended and reports the tick times.
+	bool ReplayInput(const std::string& filePath);
+	// Runs as the authoritative server of the clients that connect to the port
+	bool HostServer(uint16_t port);
+	// Shows the state of the server instead of simulating, only the local chopper is predicted,
+	// and sends it the keys pressed
+	bool JoinServer(const std::string& hostName, uint16_t port);
+	// Video memory the whole images of the streamed textures may take, the ones drawn
+	// longest ago go back to their low mip past it
+	void SetTextureStreamBudget(int megabytes);
+	// A warning is logged each time the memory of the tag goes over the budget
+	void SetMemoryBudget(MemoryTag tag, size_t budgetBytes);
+	// A frame allocating more than this many times once the level is warmed up fails the run,
+	// 0 for none at all. Only counted in a build that tracks the allocations.
+	void SetAllocationBudget(int numAllocations);
+	// Went over the allocation budget, the process exits with an error
+	bool HasFailed() const { return numFramesOverAllocationBudget > 0; }
+	// Adds a world stepped on its own thread every simulation tick, in parallel with the game's
+	World& CreateWorld(const std::string& name, StorageMode storageMode = DEFAULT_STORAGE_MODE);
+	// Records the frame from the state of the game, then submits it to the renderer
+	void RecordFrame();
+	void SubmitFrame();
 	void Destroy();
 
 	static int windowWidth;
 	static int windowHeight;
-	static int mapWidth;
-	static int mapHeight;
 
 };
 
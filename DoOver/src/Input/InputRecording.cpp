@@ -0,0 +1,188 @@
+#include "./InputRecording.h"
+#include "../Logger/Logger.h"
+#include <cstring>
+
+InputRecorder::~InputRecorder()
+{
+    if (file)
+    {
+        Close(0);
+    }
+}
+
+bool InputRecorder::Open(const std::string& filePath, const InputRecordingHeader& header)
+{
+    file = std::fopen(filePath.c_str(), "wb");
+    if (!file)
+    {
+        Logger::Err("Unable to open the input recording " + filePath);
+        return false;
+    }
+    this->header = header;
+    std::memcpy(this->header.magic, INPUT_RECORDING_MAGIC, sizeof(this->header.magic));
+    this->header.version = INPUT_RECORDING_VERSION;
+    this->header.numTicks = 0;
+    recordedActions.reset();
+    std::fwrite(&this->header, sizeof(this->header), 1, file);
+    Logger::Log("Recording the input to " + filePath);
+    return true;
+}
+
+void InputRecorder::Close(uint32_t numTicks)
+{
+    if (!file)
+    {
+        return;
+    }
+    header.numTicks = numTicks;
+    std::fseek(file, 0, SEEK_SET);
+    std::fwrite(&header, sizeof(header), 1, file);
+    std::fclose(file);
+    file = nullptr;
+}
+
+void InputRecorder::Record(uint32_t tick, const SDL_Event& sdlEvent)
+{
+    if (!file)
+    {
+        return;
+    }
+    InputRecord record = {};
+    record.tick = tick;
+    record.type = sdlEvent.type;
+    switch (sdlEvent.type)
+    {
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+        record.key = sdlEvent.key.keysym.sym;
+        record.mod = sdlEvent.key.keysym.mod;
+        record.repeat = sdlEvent.key.repeat;
+        break;
+    case SDL_MOUSEWHEEL:
+        record.wheelY = sdlEvent.wheel.y;
+        break;
+    case SDL_QUIT:
+        break;
+    default:
+        return;
+    }
+    std::fwrite(&record, sizeof(record), 1, file);
+}
+
+void InputRecorder::RecordActions(uint32_t tick, InputActions actions)
+{
+    if (!file || actions == recordedActions)
+    {
+        return;
+    }
+    recordedActions = actions;
+    InputRecord record = {};
+    record.tick = tick;
+    record.type = INPUT_RECORD_ACTIONS;
+    record.key = static_cast<int32_t>(actions.to_ulong());
+    std::fwrite(&record, sizeof(record), 1, file);
+}
+
+void InputRecorder::RecordChecksum(uint32_t tick, uint64_t checksum)
+{
+    if (!file)
+    {
+        return;
+    }
+    InputRecord record = {};
+    record.tick = tick;
+    record.type = INPUT_RECORD_CHECKSUM;
+    record.key = static_cast<int32_t>(checksum & 0xFFFFFFFF);
+    record.wheelY = static_cast<int32_t>(checksum >> 32);
+    std::fwrite(&record, sizeof(record), 1, file);
+}
+
+void InputRecorder::Flush()
+{
+    if (file)
+    {
+        std::fflush(file);
+    }
+}
+
+bool InputReplay::Open(const std::string& filePath)
+{
+    std::FILE* file = std::fopen(filePath.c_str(), "rb");
+    if (!file)
+    {
+        Logger::Err("Unable to open the input recording " + filePath);
+        return false;
+    }
+    const bool isRecording = std::fread(&header, sizeof(header), 1, file) == 1
+        && std::memcmp(header.magic, INPUT_RECORDING_MAGIC, sizeof(header.magic)) == 0
+        && header.version == INPUT_RECORDING_VERSION;
+    if (!isRecording)
+    {
+        Logger::Err(filePath + " is not an input recording of this version");
+        std::fclose(file);
+        return false;
+    }
+    header.scenarioName[INPUT_RECORDING_MAX_SCENARIO_NAME - 1] = '\0';
+    records.clear();
+    checksums.clear();
+    InputRecord record;
+    while (std::fread(&record, sizeof(record), 1, file) == 1)
+    {
+        if (record.type == INPUT_RECORD_CHECKSUM)
+        {
+            checksums.push_back(record);
+        }
+        else
+        {
+            records.push_back(record);
+        }
+    }
+    std::fclose(file);
+    nextRecord = 0;
+    nextChecksum = 0;
+    Logger::Log("Replaying " + std::to_string(records.size()) + " input events from " + filePath);
+    return true;
+}
+
+bool InputReplay::MatchesChecksum(uint32_t tick, uint64_t checksum)
+{
+    while (nextChecksum < checksums.size() && checksums[nextChecksum].tick < tick)
+    {
+        nextChecksum++;
+    }
+    if (nextChecksum == checksums.size() || checksums[nextChecksum].tick != tick)
+    {
+        return true;
+    }
+    const InputRecord& record = checksums[nextChecksum++];
+    const uint64_t recordedChecksum = static_cast<uint32_t>(record.key) | (static_cast<uint64_t>(static_cast<uint32_t>(record.wheelY)) << 32);
+    return recordedChecksum == checksum;
+}
+
+bool InputReplay::PopEvent(uint32_t tick, SDL_Event& sdlEvent)
+{
+    if (nextRecord == records.size() || records[nextRecord].tick > tick)
+    {
+        return false;
+    }
+    const InputRecord& record = records[nextRecord++];
+    std::memset(&sdlEvent, 0, sizeof(sdlEvent));
+    sdlEvent.type = record.type;
+    switch (record.type)
+    {
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+        sdlEvent.key.keysym.sym = record.key;
+        sdlEvent.key.keysym.mod = record.mod;
+        sdlEvent.key.repeat = record.repeat;
+        sdlEvent.key.state = record.type == SDL_KEYDOWN ? SDL_PRESSED : SDL_RELEASED;
+        break;
+    case SDL_MOUSEWHEEL:
+        sdlEvent.wheel.y = record.wheelY;
+        break;
+    case INPUT_RECORD_ACTIONS:
+        sdlEvent.user.code = record.key;
+        break;
+    }
+    return true;
+}
@@ -0,0 +1,116 @@
+#ifndef INPUTRECORDING_H
+#define INPUTRECORDING_H
+
+#include "InputState.h"
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Input recording
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The input of a session, each event stamped with the simulation tick it was handled
+// before, and the actions held each time they change (see InputState). The simulation runs at a fixed tick and from a fixed seed, so feeding the same
+// events before the same ticks replays the session exactly, headless and as fast as it can.
+// A replay reproduces a bug, and is the same workload on every build to compare timings:
+//   header | records
+// A recording made in deterministic mode also has the checksum of the registry after each
+// tick, the replay compares its own to it to find the first tick that went differently.
+// The records are written as they come so a crash keeps what led to it, the tick count in
+// the header is only filled in when the recording is closed.
+/////////////////////////////////////////////////////////////////////////////////////////////
+const char INPUT_RECORDING_MAGIC[4] = {'D', 'O', 'I', 'R'};
+const uint32_t INPUT_RECORDING_VERSION = 3;
+const int INPUT_RECORDING_MAX_SCENARIO_NAME = 32;
+// The type of the records of the actions held, replayed as user events with the actions in
+// the code
+const uint32_t INPUT_RECORD_ACTIONS = SDL_USEREVENT;
+// The type of the records of the checksums, the low half in the key and the high one in the
+// wheel, never replayed as events
+const uint32_t INPUT_RECORD_CHECKSUM = SDL_USEREVENT + 1;
+// Flags of the header
+const uint32_t INPUT_RECORDING_DETERMINISTIC = 1 << 0;
+
+struct InputRecordingHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t randomSeed;
+    uint32_t ticksPerSecond;
+    // Ticks run, 0 when the recording wasn't closed
+    uint32_t numTicks;
+    // The scenario played instead of the level, empty for none
+    char scenarioName[INPUT_RECORDING_MAX_SCENARIO_NAME];
+    int32_t scenarioSize;
+    uint32_t scenarioSeed;
+    uint32_t flags;
+};
+
+// The fields of the events that are recorded, the other event types are left out
+struct InputRecord
+{
+    uint32_t tick;
+    uint32_t type;
+    int32_t key;
+    uint16_t mod;
+    uint8_t repeat;
+    uint8_t reserved;
+    int32_t wheelY;
+};
+
+class InputRecorder
+{
+private:
+    std::FILE* file = nullptr;
+    InputRecordingHeader header;
+    InputActions recordedActions;
+
+public:
+    InputRecorder() = default;
+    ~InputRecorder();
+
+    bool Open(const std::string& filePath, const InputRecordingHeader& header);
+    // Writes the tick count into the header and closes the file
+    void Close(uint32_t numTicks);
+    bool IsRecording() const { return file != nullptr; }
+
+    // Records the keyboard, mouse wheel and quit events, the others are ignored
+    void Record(uint32_t tick, const SDL_Event& sdlEvent);
+    // Once a tick, only the changes are written
+    void RecordActions(uint32_t tick, InputActions actions);
+    // Of the registry once the tick ran, see Registry::ComputeChecksum
+    void RecordChecksum(uint32_t tick, uint64_t checksum);
+    // Done once a frame, so the records are on disk if the game crashes
+    void Flush();
+};
+
+class InputReplay
+{
+private:
+    InputRecordingHeader header;
+    std::vector<InputRecord> records;
+    size_t nextRecord = 0;
+    // Of the ticks, in order
+    std::vector<InputRecord> checksums;
+    size_t nextChecksum = 0;
+
+public:
+    InputReplay() = default;
+
+    bool Open(const std::string& filePath);
+    const InputRecordingHeader& GetHeader() const { return header; }
+
+    // Pops the next event recorded before the tick or an earlier one, false when there is none
+    bool PopEvent(uint32_t tick, SDL_Event& sdlEvent);
+    // The tick of the last record, for the recordings that weren't closed
+    uint32_t GetLastTick() const { return records.empty() ? 0 : records.back().tick; }
+    bool IsFinished() const { return nextRecord == records.size(); }
+    bool HasChecksums() const { return !checksums.empty(); }
+    // False when the checksum recorded for the tick is another one, true without one. The
+    // ticks are checked in order.
+    bool MatchesChecksum(uint32_t tick, uint64_t checksum);
+};
+
+#endif
@@ -0,0 +1,180 @@
+#include "./InputState.h"
+#include "../Logger/Logger.h"
+#include <algorithm>
+
+InputState::InputState()
+{
+    BindKey(INPUT_ACTION_MOVE_UP, SDL_SCANCODE_UP);
+    BindKey(INPUT_ACTION_MOVE_RIGHT, SDL_SCANCODE_RIGHT);
+    BindKey(INPUT_ACTION_MOVE_DOWN, SDL_SCANCODE_DOWN);
+    BindKey(INPUT_ACTION_MOVE_LEFT, SDL_SCANCODE_LEFT);
+    BindButton(INPUT_ACTION_MOVE_UP, SDL_CONTROLLER_BUTTON_DPAD_UP);
+    BindButton(INPUT_ACTION_MOVE_RIGHT, SDL_CONTROLLER_BUTTON_DPAD_RIGHT);
+    BindButton(INPUT_ACTION_MOVE_DOWN, SDL_CONTROLLER_BUTTON_DPAD_DOWN);
+    BindButton(INPUT_ACTION_MOVE_LEFT, SDL_CONTROLLER_BUTTON_DPAD_LEFT);
+    BindAxis(INPUT_ACTION_MOVE_UP, SDL_CONTROLLER_AXIS_LEFTY, -1);
+    BindAxis(INPUT_ACTION_MOVE_RIGHT, SDL_CONTROLLER_AXIS_LEFTX, 1);
+    BindAxis(INPUT_ACTION_MOVE_DOWN, SDL_CONTROLLER_AXIS_LEFTY, 1);
+    BindAxis(INPUT_ACTION_MOVE_LEFT, SDL_CONTROLLER_AXIS_LEFTX, -1);
+}
+
+InputState::~InputState()
+{
+    SetTimestamped(false);
+    if (gamepad)
+    {
+        SDL_GameControllerClose(gamepad);
+    }
+}
+
+void InputState::BindKey(InputAction action, SDL_Scancode scancode)
+{
+    bindings[action].scancodes.push_back(scancode);
+}
+
+void InputState::BindButton(InputAction action, SDL_GameControllerButton button)
+{
+    bindings[action].buttons.push_back(button);
+}
+
+void InputState::BindAxis(InputAction action, SDL_GameControllerAxis axis, int direction)
+{
+    bindings[action].axes.push_back({axis, direction});
+}
+
+void InputState::ClearBindings(InputAction action)
+{
+    bindings[action] = ActionBindings();
+}
+
+void InputState::UpdateGamepad()
+{
+    if (gamepad && SDL_GameControllerGetAttached(gamepad))
+    {
+        return;
+    }
+    if (gamepad)
+    {
+        LOGGER_INFO("Gamepad disconnected");
+        SDL_GameControllerClose(gamepad);
+        gamepad = nullptr;
+    }
+    for (int joystick = 0; joystick < SDL_NumJoysticks(); joystick++)
+    {
+        if (SDL_IsGameController(joystick) && (gamepad = SDL_GameControllerOpen(joystick)))
+        {
+            LOGGER_INFO("Gamepad connected: {}", SDL_GameControllerName(gamepad));
+            return;
+        }
+    }
+}
+
+void InputState::SetTimestamped(bool isTimestamped)
+{
+    if (isTimestamped == this->isTimestamped)
+    {
+        return;
+    }
+    this->isTimestamped = isTimestamped;
+    if (isTimestamped)
+    {
+        // What is already held has no event, it starts from the keyboard state
+        int numKeys;
+        const Uint8* keyboardState = SDL_GetKeyboardState(&numKeys);
+        numKeys = std::min(numKeys, static_cast<int>(SDL_NUM_SCANCODES));
+        timedKeysHeld.reset();
+        for (int scancode = 0; scancode < numKeys; scancode++)
+        {
+            timedKeysHeld[scancode] = keyboardState[scancode] != 0;
+        }
+        SDL_AddEventWatch(StampKeyEvent, this);
+    }
+    else
+    {
+        SDL_DelEventWatch(StampKeyEvent, this);
+        std::lock_guard<std::mutex> lock(timedKeysMutex);
+        timedKeys.clear();
+    }
+}
+
+int SDLCALL InputState::StampKeyEvent(void* userData, SDL_Event* sdlEvent)
+{
+    if ((sdlEvent->type != SDL_KEYDOWN && sdlEvent->type != SDL_KEYUP) || sdlEvent->key.repeat)
+    {
+        return 1;
+    }
+    InputState* inputState = static_cast<InputState*>(userData);
+    const double millisecs = SDL_GetPerformanceCounter() * 1000.0 / SDL_GetPerformanceFrequency();
+    std::lock_guard<std::mutex> lock(inputState->timedKeysMutex);
+    inputState->timedKeys.push_back({millisecs, static_cast<SDL_Scancode>(sdlEvent->key.keysym.scancode), sdlEvent->type == SDL_KEYDOWN});
+    return 1;
+}
+
+void InputState::ApplyTimedKeys(double tickEndMillisecs)
+{
+    std::lock_guard<std::mutex> lock(timedKeysMutex);
+    keys = timedKeysHeld;
+    size_t numApplied = 0;
+    for (; numApplied < timedKeys.size() && timedKeys[numApplied].millisecs <= tickEndMillisecs; numApplied++)
+    {
+        const TimedKey& timedKey = timedKeys[numApplied];
+        if (timedKey.scancode < 0 || timedKey.scancode >= SDL_NUM_SCANCODES)
+        {
+            continue;
+        }
+        timedKeysHeld[timedKey.scancode] = timedKey.isDown;
+        if (timedKey.isDown)
+        {
+            keys[timedKey.scancode] = true;
+        }
+    }
+    keys |= timedKeysHeld;
+    timedKeys.erase(timedKeys.begin(), timedKeys.begin() + numApplied);
+}
+
+void InputState::Poll(bool isKeyboardCaptured, double tickEndMillisecs)
+{
+    if (isTimestamped)
+    {
+        // The events of the frame wait are queued, and stamped, before the tick takes its own
+        SDL_PumpEvents();
+        ApplyTimedKeys(tickEndMillisecs);
+        if (isKeyboardCaptured)
+        {
+            keys.reset();
+        }
+    }
+    else
+    {
+        int numKeys;
+        const Uint8* keyboardState = SDL_GetKeyboardState(&numKeys);
+        keys.reset();
+        if (!isKeyboardCaptured)
+        {
+            numKeys = std::min(numKeys, static_cast<int>(SDL_NUM_SCANCODES));
+            for (int scancode = 0; scancode < numKeys; scancode++)
+            {
+                keys[scancode] = keyboardState[scancode] != 0;
+            }
+        }
+    }
+    UpdateGamepad();
+
+    for (int action = 0; action < INPUT_ACTION_COUNT; action++)
+    {
+        const ActionBindings& actionBindings = bindings[action];
+        bool isHeld = std::any_of(actionBindings.scancodes.begin(), actionBindings.scancodes.end(), [this](SDL_Scancode scancode) { return keys[scancode]; });
+        if (gamepad && !isHeld)
+        {
+            isHeld = std::any_of(actionBindings.buttons.begin(), actionBindings.buttons.end(), [this](SDL_GameControllerButton button) { return SDL_GameControllerGetButton(gamepad, button) != 0; })
+                || std::any_of(actionBindings.axes.begin(), actionBindings.axes.end(), [this](const AxisBinding& binding) { return SDL_GameControllerGetAxis(gamepad, binding.axis) * binding.direction > INPUT_AXIS_DEAD_ZONE; });
+        }
+        actions[action] = isHeld;
+    }
+}
+
+void InputState::EndTick()
+{
+    previousActions = actions;
+    pressedActions.reset();
+}
@@ -0,0 +1,114 @@
+#ifndef INPUTSTATE_H
+#define INPUTSTATE_H
+
+#include <SDL2/SDL.h>
+#include <bitset>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// What the gameplay does with the input, the keys and buttons are bound to these
+enum InputAction
+{
+    INPUT_ACTION_MOVE_UP,
+    INPUT_ACTION_MOVE_RIGHT,
+    INPUT_ACTION_MOVE_DOWN,
+    INPUT_ACTION_MOVE_LEFT,
+    INPUT_ACTION_COUNT
+};
+
+// [action] -> held, small enough to be recorded and sent as one integer
+typedef std::bitset<INPUT_ACTION_COUNT> InputActions;
+
+// How far a stick must be pushed to hold its action, of 32767
+const int INPUT_AXIS_DEAD_ZONE = 8000;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Input state
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The keyboard and the first gamepad, polled once per simulation tick. The systems read the
+// actions held, pressed and released on the tick instead of reacting to the key events, so
+// the auto-repeats and the keys of the debug GUI never reach them. Each action is bound to
+// any number of keys, gamepad buttons and stick directions.
+// The replays and the network clients set the actions directly, see SetActions and
+// PressActions, the simulation only ever sees actions.
+// Timestamped, the key events are stamped as SDL queues them and each tick only takes the
+// ones before its end, so a key lands on the tick it was pressed in whatever the frame rate,
+// and a tap shorter than a tick still holds its action for that tick.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class InputState
+{
+private:
+    struct AxisBinding
+    {
+        SDL_GameControllerAxis axis;
+        // -1 for the negative side of the axis, 1 for the positive one
+        int direction;
+    };
+
+    struct ActionBindings
+    {
+        std::vector<SDL_Scancode> scancodes;
+        std::vector<SDL_GameControllerButton> buttons;
+        std::vector<AxisBinding> axes;
+    };
+
+    struct TimedKey
+    {
+        // On the performance counter, like the system clock
+        double millisecs;
+        SDL_Scancode scancode;
+        bool isDown;
+    };
+
+    ActionBindings bindings[INPUT_ACTION_COUNT];
+    std::bitset<SDL_NUM_SCANCODES> keys;
+    bool isTimestamped = false;
+    // Filled by the event watch, on whichever thread SDL queues the events
+    std::mutex timedKeysMutex;
+    std::vector<TimedKey> timedKeys;
+    std::bitset<SDL_NUM_SCANCODES> timedKeysHeld;
+    InputActions actions;
+    InputActions previousActions;
+    // Pressed on the tick by the network clients, they don't hold anything
+    InputActions pressedActions;
+    SDL_GameController* gamepad = nullptr;
+
+    void UpdateGamepad();
+    // The key events up to the end of the tick, a key is held if it was at any point of it
+    void ApplyTimedKeys(double tickEndMillisecs);
+    static int SDLCALL StampKeyEvent(void* userData, SDL_Event* sdlEvent);
+
+public:
+    // Bound to the arrows, the directional pad and the left stick
+    InputState();
+    ~InputState();
+
+    void BindKey(InputAction action, SDL_Scancode scancode);
+    void BindButton(InputAction action, SDL_GameControllerButton button);
+    void BindAxis(InputAction action, SDL_GameControllerAxis axis, int direction);
+    void ClearBindings(InputAction action);
+
+    // Stamps the key events from now on, SDL must be initialized
+    void SetTimestamped(bool isTimestamped);
+    // Once a tick before the systems. The keyboard is left out while the debug GUI types.
+    // Timestamped, the keys are the ones of the events stamped up to the end of the tick.
+    void Poll(bool isKeyboardCaptured, double tickEndMillisecs = 0.0);
+    // Instead of polling, from a replay
+    void SetActions(InputActions actions) { this->actions = actions; }
+    // The actions pressed remotely, on the next tick only
+    void PressActions(InputActions actions) { pressedActions |= actions; }
+    // Once a tick after the systems, what is held becomes what was held
+    void EndTick();
+
+    bool IsKeyHeld(SDL_Scancode scancode) const { return keys[scancode]; }
+    bool IsHeld(InputAction action) const { return actions[action]; }
+    bool WasPressed(InputAction action) const { return GetPressedActions()[action]; }
+    bool WasReleased(InputAction action) const { return previousActions[action] && !actions[action]; }
+    InputActions GetActions() const { return actions; }
+    InputActions GetPressedActions() const { return (actions & ~previousActions) | pressedActions; }
+    bool HasGamepad() const { return gamepad != nullptr; }
+    bool IsTimestamped() const { return isTimestamped; }
+};
+
+#endif
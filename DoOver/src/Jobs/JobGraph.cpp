@@ -0,0 +1,80 @@
+#include "JobGraph.h"
+
+int JobGraph::AddJob(std::function<void()> job)
+{
+    auto node = std::make_unique<Node>();
+    node->job = std::move(job);
+    nodes.push_back(std::move(node));
+    return nodes.size() - 1;
+}
+
+void JobGraph::AddDependency(int jobIndex, int dependencyIndex)
+{
+    // Added in order, the graph can't have a cycle
+    if (dependencyIndex >= jobIndex)
+    {
+        return;
+    }
+    nodes[dependencyIndex]->dependents.push_back(jobIndex);
+    nodes[jobIndex]->numDependencies++;
+}
+
+void JobGraph::Clear()
+{
+    nodes.clear();
+}
+
+int JobGraph::GetNumJobs() const
+{
+    return nodes.size();
+}
+
+void JobGraph::RunNode(JobSystem& jobSystem, int nodeIndex)
+{
+    while (nodeIndex >= 0)
+    {
+        Node& node = *nodes[nodeIndex];
+        node.job();
+
+        int continuationIndex = -1;
+        for (auto dependent: node.dependents)
+        {
+            if (nodes[dependent]->numPendingDependencies.fetch_sub(1) != 1)
+            {
+                continue;
+            }
+            if (continuationIndex < 0)
+            {
+                continuationIndex = dependent;
+            }
+            else
+            {
+                jobSystem.Schedule([this, &jobSystem, dependent]() { RunNode(jobSystem, dependent); });
+            }
+        }
+        // After the release, the count still holds the dependents
+        counter.Done();
+        nodeIndex = continuationIndex;
+    }
+}
+
+void JobGraph::Run(JobSystem& jobSystem)
+{
+    if (nodes.empty())
+    {
+        return;
+    }
+    for (auto& node: nodes)
+    {
+        node->numPendingDependencies = node->numDependencies;
+    }
+    counter.Add(nodes.size());
+    for (int i = 0; i < static_cast<int>(nodes.size()); i++)
+    {
+        if (nodes[i]->numDependencies == 0)
+        {
+            jobSystem.Schedule([this, &jobSystem, i]() { RunNode(jobSystem, i); });
+        }
+    }
+    counter.Wait();
+}
@@ -0,0 +1,49 @@
+#ifndef JOBGRAPH_H
+#define JOBGRAPH_H
+
+#include "JobSystem.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Job graph
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Jobs that each run after the jobs they depend on, built once and run as often as needed,
+// e.g. the system updates of a frame. Every job counts down the dependencies it still waits
+// for, and the one that finishes last releases it: the first job released goes on in the
+// same thread as a continuation, without a trip through the queues, the others are
+// scheduled.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class JobGraph
+{
+private:
+    struct Node
+    {
+        std::function<void()> job;
+        std::vector<int> dependents;
+        int numDependencies = 0;
+        std::atomic<int> numPendingDependencies{0};
+    };
+
+    std::vector<std::unique_ptr<Node>> nodes;
+    JobCounter counter;
+
+    void RunNode(JobSystem& jobSystem, int nodeIndex);
+
+public:
+    JobGraph() = default;
+
+    // Returns the index the dependencies refer to it by
+    int AddJob(std::function<void()> job);
+    // The job runs once the dependency finished, the dependency was added first
+    void AddDependency(int jobIndex, int dependencyIndex);
+    void Clear();
+    int GetNumJobs() const;
+
+    // Runs every job once, respecting the dependencies, and waits for all of them
+    void Run(JobSystem& jobSystem);
+};
+
+#endif
@@ -0,0 +1,397 @@
+#include "JobSystem.h"
+#include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
+#include <algorithm>
+#include <chrono>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+static thread_local int threadIndex = 0;
+// The job system the worker thread belongs to
+static thread_local JobSystem* threadJobSystem = nullptr;
+
+void JobCounter::Done()
+{
+    // Only the last job takes the lock, the waiter may destroy the counter once it is 0
+    int current = count.load();
+    while (current > 1)
+    {
+        if (count.compare_exchange_weak(current, current - 1))
+        {
+            return;
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (count.fetch_sub(1) == 1)
+    {
+        finished.notify_all();
+    }
+}
+
+void JobCounter::Wait()
+{
+    for (int i = 0; i < JOB_IDLE_SPINS && !IsDone(); i++)
+    {
+        std::this_thread::yield();
+    }
+    // Even when it is done, the last job may still hold the lock
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this]() { return IsDone(); });
+}
+
+JobSystem::JobSystem(int numWorkers, bool isPinned): mainThreadId(std::this_thread::get_id())
+{
+#ifdef ENABLE_PROFILER
+    jobProfileId = Profiler::GetScopeId("Job");
+#endif
+    numWorkers = std::min(numWorkers, MAX_JOB_THREADS - 1);
+    for (int i = 0; i < numWorkers; i++)
+    {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    // Started once every worker exists, they steal from each other
+    const int numCores = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    for (int i = 0; i < numWorkers; i++)
+    {
+        workers[i]->thread = std::thread(&JobSystem::WorkerLoop, this, i);
+        if (isPinned)
+        {
+            // Core 0 is left to the main thread
+            PinThread(workers[i]->thread, (i + 1) % numCores);
+        }
+    }
+    Logger::Log("JobSystem constructor called with " + std::to_string(numWorkers) + " workers" + (isPinned ? " pinned to cores!" : "!"));
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        isRunning = false;
+    }
+    jobAvailable.notify_all();
+    for (auto& worker: workers)
+    {
+        worker->thread.join();
+    }
+    // The workers ran every queued job before they stopped, not the main thread's
+    Job* job;
+    while (mainThreadJobs.Pop(job))
+    {
+        delete job;
+    }
+    Logger::Log("JobSystem destructor called!");
+}
+
+void JobSystem::PinThread(std::thread& thread, int core)
+{
+#ifdef __linux__
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(core, &cpus);
+    if (pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus) != 0)
+    {
+        Logger::Err("Unable to pin a worker to core " + std::to_string(core));
+    }
+#else
+    Logger::Err("Pinning the workers to cores is only supported on Linux");
+#endif
+}
+
+int JobSystem::DefaultNumWorkers()
+{
+    const int numCores = std::thread::hardware_concurrency();
+    return numCores > 1 ? numCores - 1 : 0;
+}
+
+int JobSystem::GetNumWorkers() const
+{
+    return workers.size();
+}
+
+void JobSystem::GetWorkerStats(std::vector<JobWorkerStats>& stats) const
+{
+    stats.resize(workers.size());
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        const Worker& worker = *workers[i];
+        stats[i] = {worker.numJobs.load(std::memory_order_relaxed), worker.numStolen.load(std::memory_order_relaxed),
+            worker.numSleeps.load(std::memory_order_relaxed), worker.busyNanosecs.load(std::memory_order_relaxed)};
+    }
+}
+
+int JobSystem::GetThreadIndex()
+{
+    return threadIndex;
+}
+
+void JobSystem::Schedule(std::function<void()> func, JobCounter* counter)
+{
+    if (counter)
+    {
+        counter->Add(1);
+    }
+    Job* job = new Job{std::move(func), counter};
+    if (workers.empty())
+    {
+        RunJob(job, nullptr);
+        return;
+    }
+
+    // A worker keeps its jobs, the others steal them when they run out
+    bool isQueued = threadJobSystem == this && workers[threadIndex - 1]->jobs.Push(job);
+    isQueued = isQueued || sharedJobs.Push(job);
+    if (!isQueued)
+    {
+        RunJob(job, nullptr);
+        return;
+    }
+    numQueuedJobs.fetch_add(1);
+    if (numSleepingWorkers.load() > 0)
+    {
+        // Under the lock, so the worker can't miss it between its last look and its sleep
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        jobAvailable.notify_one();
+    }
+}
+
+void JobSystem::ScheduleOnMainThread(std::function<void()> func)
+{
+    Job* job = new Job{std::move(func), nullptr};
+    while (!mainThreadJobs.Push(job))
+    {
+        if (std::this_thread::get_id() == mainThreadId)
+        {
+            RunJob(job, nullptr);
+            return;
+        }
+        // The main thread empties it every frame
+        std::this_thread::yield();
+    }
+}
+
+void JobSystem::RunMainThreadJobs()
+{
+    Job* job;
+    while (mainThreadJobs.Pop(job))
+    {
+        RunJob(job, nullptr);
+    }
+}
+
+JobSystem::Job* JobSystem::TakeJob(int workerIndex)
+{
+    Worker& worker = *workers[workerIndex];
+    Job* job;
+    if (worker.jobs.Pop(job) || sharedJobs.Pop(job))
+    {
+        numQueuedJobs.fetch_sub(1);
+        return job;
+    }
+    const int numWorkers = workers.size();
+    for (int i = 1; i < numWorkers; i++)
+    {
+        if (workers[(workerIndex + i) % numWorkers]->jobs.Steal(job))
+        {
+            numQueuedJobs.fetch_sub(1);
+            worker.numStolen.fetch_add(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void JobSystem::RunJob(Job* job, Worker* worker)
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+    job->func();
+    const auto end = std::chrono::high_resolution_clock::now();
+#ifdef ENABLE_PROFILER
+    Profiler::AddSample(jobProfileId, start, end);
+#endif
+    if (worker)
+    {
+        worker->numJobs.fetch_add(1, std::memory_order_relaxed);
+        worker->busyNanosecs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(), std::memory_order_relaxed);
+    }
+    if (job->counter)
+    {
+        job->counter->Done();
+    }
+    delete job;
+}
+
+void JobSystem::WorkerLoop(int workerIndex)
+{
+    threadIndex = workerIndex + 1;
+    threadJobSystem = this;
+#ifdef ENABLE_PROFILER
+    Profiler::SetThreadName("Worker " + std::to_string(workerIndex));
+#endif
+    Worker& worker = *workers[workerIndex];
+    int numIdleSpins = 0;
+    while (true)
+    {
+        if (Job* job = TakeJob(workerIndex))
+        {
+            RunJob(job, &worker);
+            numIdleSpins = 0;
+            continue;
+        }
+        // Stops once nothing is left to run
+        if (!isRunning)
+        {
+            return;
+        }
+        if (++numIdleSpins < JOB_IDLE_SPINS)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        numIdleSpins = 0;
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        numSleepingWorkers.fetch_add(1);
+        worker.numSleeps.fetch_add(1, std::memory_order_relaxed);
+        jobAvailable.wait(lock, [this]() { return numQueuedJobs.load() > 0 || !isRunning; });
+        numSleepingWorkers.fetch_sub(1);
+    }
+}
+
+static uint64_t PackRange(int begin, int end)
+{
+    return (static_cast<uint64_t>(begin) << 32) | static_cast<uint32_t>(end);
+}
+
+static void UnpackRange(uint64_t range, int& begin, int& end)
+{
+    begin = static_cast<int>(range >> 32);
+    end = static_cast<int>(range & 0xFFFFFFFF);
+}
+
+bool JobSystem::PopFront(std::atomic<uint64_t>& range, int grainSize, int& begin, int& end)
+{
+    uint64_t current = range.load();
+    while (true)
+    {
+        int first, last;
+        UnpackRange(current, first, last);
+        if (first >= last)
+        {
+            return false;
+        }
+        const int split = std::min(first + grainSize, last);
+        if (range.compare_exchange_weak(current, PackRange(split, last)))
+        {
+            begin = first;
+            end = split;
+            return true;
+        }
+    }
+}
+
+bool JobSystem::StealBack(std::atomic<uint64_t>& range, int grainSize, int& begin, int& end)
+{
+    uint64_t current = range.load();
+    while (true)
+    {
+        int first, last;
+        UnpackRange(current, first, last);
+        if (first >= last)
+        {
+            return false;
+        }
+        // Take half of the remaining grains, but never less than one. The ranges start on a
+        // grain, so the chunks are the same whatever the number of workers.
+        const int numGrains = (last - first + grainSize - 1) / grainSize;
+        const int split = first + (numGrains - std::max(numGrains / 2, 1)) * grainSize;
+        if (range.compare_exchange_weak(current, PackRange(first, split)))
+        {
+            begin = split;
+            end = last;
+            return true;
+        }
+    }
+}
+
+void JobSystem::RunParallelFor(ParallelForState& state, int rangeIndex)
+{
+    auto& ownRange = state.ranges[rangeIndex];
+    int begin, end;
+    while (true)
+    {
+        // Drain our own range one grain at a time
+        while (PopFront(ownRange, state.grainSize, begin, end))
+        {
+            state.func(begin, end);
+            state.numPendingItems -= end - begin;
+        }
+
+        // Steal from the other ranges, the stolen work becomes our own range
+        bool hasStolen = false;
+        for (int i = 1; i < state.numRanges && !hasStolen; i++)
+        {
+            auto& victim = state.ranges[(rangeIndex + i) % state.numRanges];
+            if (StealBack(victim, state.grainSize, begin, end))
+            {
+                ownRange = PackRange(begin, end);
+                hasStolen = true;
+            }
+        }
+        if (!hasStolen)
+        {
+            return;
+        }
+    }
+}
+
+void JobSystem::ParallelFor(int count, int grainSize, std::function<void(int, int)> func)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+    grainSize = std::max(grainSize, 1);
+    if (workers.empty() || count <= grainSize)
+    {
+        // The same chunks as on the workers
+        for (int begin = 0; begin < count; begin += grainSize)
+        {
+            func(begin, std::min(begin + grainSize, count));
+        }
+        return;
+    }
+
+    // Never split the work in more ranges than grains
+    const int numGrains = (count + grainSize - 1) / grainSize;
+    const int numRanges = std::min(static_cast<int>(workers.size()) + 1, numGrains);
+
+    // The helpers may start after the caller returned, so they share ownership of the state
+    auto state = std::make_shared<ParallelForState>();
+    state->func = std::move(func);
+    state->ranges.reset(new std::atomic<uint64_t>[numRanges]);
+    state->numRanges = numRanges;
+    state->grainSize = grainSize;
+    state->numPendingItems = count;
+    for (int i = 0; i < numRanges; i++)
+    {
+        // On grain boundaries, the last range ends at the count
+        const int begin = static_cast<int64_t>(numGrains) * i / numRanges * grainSize;
+        const int end = std::min(static_cast<int>(static_cast<int64_t>(numGrains) * (i + 1) / numRanges * grainSize), count);
+        state->ranges[i] = PackRange(begin, end);
+    }
+
+    for (int i = 1; i < numRanges; i++)
+    {
+        Schedule([state, i]() { RunParallelFor(*state, i); });
+    }
+    RunParallelFor(*state, 0);
+
+    // Wait for the chunks still running on the workers
+    while (state->numPendingItems > 0)
+    {
+        std::this_thread::yield();
+    }
+}
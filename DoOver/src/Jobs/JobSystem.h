@@ -0,0 +1,185 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include "MPMCQueue.h"
+#include "WorkStealingDeque.h"
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+const int DEFAULT_GRAIN_SIZE = 1024;
+// The workers and the threads outside the job system, which all share index 0
+const int MAX_JOB_THREADS = 64;
+// Jobs the deque of a worker holds, the ones past it go to the shared queue
+const int JOB_DEQUE_CAPACITY = 4096;
+// Jobs the shared queue and the main thread queue hold, past it a job runs where it was
+// scheduled
+const int JOB_QUEUE_CAPACITY = 4096;
+// Times an idle worker looks for a job before it sleeps
+const int JOB_IDLE_SPINS = 64;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Job counter
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Counts the jobs scheduled with it that haven't finished, so a thread can wait for a batch
+// of them. The count is atomic, only the last job to finish takes the lock to wake the
+// waiters.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class JobCounter
+{
+private:
+    std::atomic<int> count{0};
+    std::mutex mutex;
+    std::condition_variable finished;
+
+public:
+    JobCounter() = default;
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    void Add(int numJobs) { count.fetch_add(numJobs); }
+    void Done();
+    bool IsDone() const { return count.load() == 0; }
+    // Yields for a while, then sleeps until the count is 0
+    void Wait();
+};
+
+// Of one worker, since the job system started
+struct JobWorkerStats
+{
+    uint64_t numJobs;
+    // Taken from another worker's deque
+    uint64_t numStolen;
+    uint64_t numSleeps;
+    uint64_t busyNanosecs;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Job System
+/////////////////////////////////////////////////////////////////////////////////////////////
+// A fixed pool of worker threads, optionally pinned one per core. Each worker has its own
+// work-stealing deque: the jobs it schedules go to its bottom and it runs them last in first
+// out, and the idle workers steal the oldest ones from the top. The threads outside the
+// pool schedule into a shared lock-free queue. None of it locks, a worker only takes the
+// lock to sleep when it found nothing to do for a while, and a job is only scheduled under
+// it when a worker sleeps. The SDL calls that must run on the main thread are queued on its
+// own lane, which the main thread runs once a frame.
+// With zero workers (single core machines) jobs simply run inline on the caller.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class JobSystem
+{
+private:
+    struct Job
+    {
+        std::function<void()> func;
+        JobCounter* counter;
+    };
+
+    // Apart on their cache lines, each one is written by its own worker
+    struct alignas(64) Worker
+    {
+        WorkStealingDeque<Job*> jobs{JOB_DEQUE_CAPACITY};
+        std::thread thread;
+        std::atomic<uint64_t> numJobs{0};
+        std::atomic<uint64_t> numStolen{0};
+        std::atomic<uint64_t> numSleeps{0};
+        std::atomic<uint64_t> busyNanosecs{0};
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    MPMCQueue<Job*> sharedJobs{JOB_QUEUE_CAPACITY};
+    MPMCQueue<Job*> mainThreadJobs{JOB_QUEUE_CAPACITY};
+    std::thread::id mainThreadId;
+
+    // Queued and not taken yet, the idle workers sleep while there are none
+    std::atomic<int> numQueuedJobs{0};
+    std::atomic<int> numSleepingWorkers{0};
+    std::mutex sleepMutex;
+    std::condition_variable jobAvailable;
+    std::atomic<bool> isRunning{true};
+    int jobProfileId = 0;
+
+    // Shared by the caller and the helper jobs of a ParallelFor. Each participant owns a
+    // range packed as [begin | end] in 64 bits: the owner pops grains from the front and
+    // the idle participants steal half of what is left from the back.
+    struct ParallelForState
+    {
+        std::function<void(int, int)> func;
+        std::unique_ptr<std::atomic<uint64_t>[]> ranges;
+        int numRanges;
+        int grainSize;
+        std::atomic<int> numPendingItems;
+    };
+
+    void WorkerLoop(int workerIndex);
+    // From its own deque first, then the shared queue, then the other workers' deques
+    Job* TakeJob(int workerIndex);
+    // Counted in the stats of the worker, when it runs on one
+    void RunJob(Job* job, Worker* worker);
+    static void PinThread(std::thread& thread, int core);
+    static void RunParallelFor(ParallelForState& state, int rangeIndex);
+    static bool PopFront(std::atomic<uint64_t>& range, int grainSize, int& begin, int& end);
+    static bool StealBack(std::atomic<uint64_t>& range, int grainSize, int& begin, int& end);
+
+public:
+    // By default keep one core for the main thread, which the pinned workers leave alone
+    JobSystem(int numWorkers = DefaultNumWorkers(), bool isPinned = false);
+    ~JobSystem();
+
+    // The counter, when given, counts the job until it finished
+    void Schedule(std::function<void()> job, JobCounter* counter = nullptr);
+
+    // Runs the job on the main thread, the one that made the job system, at its next
+    // RunMainThreadJobs
+    void ScheduleOnMainThread(std::function<void()> job);
+    // Main thread only, runs the jobs queued for it so far
+    void RunMainThreadJobs();
+
+    // Calls func(begin, end) over [0, count) in chunks of grainSize items, the calling thread
+    // takes part in the work and returns once every chunk is done. The chunks start on
+    // multiples of grainSize whatever the number of workers.
+    void ParallelFor(int count, int grainSize, std::function<void(int, int)> func);
+
+    // Reduces func(begin, end) of every chunk of grainSize items with combine, in the order of
+    // the chunks, so a sum of floats comes out the same whatever the number of workers
+    template <typename T, typename TFunc, typename TCombine>
+    T ParallelReduce(int count, int grainSize, T identity, TFunc func, TCombine combine);
+
+    int GetNumWorkers() const;
+    void GetWorkerStats(std::vector<JobWorkerStats>& stats) const;
+
+    // 1 + the worker index on a worker thread, 0 on any other thread, so the per-thread
+    // data is indexed without a lock
+    static int GetThreadIndex();
+
+    static int DefaultNumWorkers();
+};
+
+template <typename T, typename TFunc, typename TCombine>
+T JobSystem::ParallelReduce(int count, int grainSize, T identity, TFunc func, TCombine combine)
+{
+    grainSize = std::max(grainSize, 1);
+    const int numGrains = count > 0 ? (count + grainSize - 1) / grainSize : 0;
+    std::vector<T> partials(numGrains, identity);
+    ParallelFor(numGrains, 1, [&](int begin, int end)
+    {
+        for (int grain = begin; grain < end; grain++)
+        {
+            partials[grain] = func(grain * grainSize, std::min((grain + 1) * grainSize, count));
+        }
+    });
+    T result = identity;
+    for (const auto& partial: partials)
+    {
+        result = combine(result, partial);
+    }
+    return result;
+}
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef MPMCQUEUE_H
+#define MPMCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// MPMC queue
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Bounded queue any number of threads push to and pop from, first in first out (Vyukov's).
+// Each cell carries a sequence number telling whether it is free for the push of a lap or
+// holds the item of the pop of that lap, so a push or a pop is one compare-exchange on its
+// end of the ring and never waits for another thread. A push onto a full queue fails.
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+class MPMCQueue
+{
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T item;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> pushPosition{0};
+    alignas(64) std::atomic<size_t> popPosition{0};
+
+public:
+    // Rounded up to a power of 2
+    explicit MPMCQueue(int capacity)
+    {
+        size_t size = 1;
+        while (size < static_cast<size_t>(capacity))
+        {
+            size <<= 1;
+        }
+        cells.reset(new Cell[size]);
+        mask = size - 1;
+        for (size_t i = 0; i < size; i++)
+        {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool Push(T item)
+    {
+        size_t position = pushPosition.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true)
+        {
+            cell = &cells[position & mask];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0)
+            {
+                if (pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = pushPosition.load(std::memory_order_relaxed);
+            }
+        }
+        cell->item = std::move(item);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(T& item)
+    {
+        size_t position = popPosition.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true)
+        {
+            cell = &cells[position & mask];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+            if (difference == 0)
+            {
+                if (popPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = popPosition.load(std::memory_order_relaxed);
+            }
+        }
+        item = std::move(cell->item);
+        // Free for the push of the next lap
+        cell->sequence.store(position + mask + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+#endif
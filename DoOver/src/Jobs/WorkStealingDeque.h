@@ -0,0 +1,92 @@
+#ifndef WORKSTEALINGDEQUE_H
+#define WORKSTEALINGDEQUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Work-stealing deque
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The Chase-Lev deque of a worker, with the memory orders of Le et al. (2013). Its owner
+// pushes and pops at the bottom, the last job in first while its data is still in the
+// cache, and the other threads steal the oldest jobs from the top. Only a steal racing the
+// owner for the last job takes a compare-exchange, nothing ever locks. The capacity is fixed,
+// a push onto a full deque fails and the job goes elsewhere.
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+class WorkStealingDeque
+{
+private:
+    alignas(64) std::atomic<int64_t> top{0};
+    alignas(64) std::atomic<int64_t> bottom{0};
+    std::unique_ptr<std::atomic<T>[]> items;
+    int64_t mask;
+
+public:
+    // Rounded up to a power of 2
+    explicit WorkStealingDeque(int capacity)
+    {
+        int64_t size = 1;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        items.reset(new std::atomic<T>[size]);
+        mask = size - 1;
+    }
+
+    // Owner only
+    bool Push(T item)
+    {
+        const int64_t b = bottom.load(std::memory_order_relaxed);
+        const int64_t t = top.load(std::memory_order_acquire);
+        if (b - t > mask)
+        {
+            return false;
+        }
+        items[b & mask].store(item, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Owner only
+    bool Pop(T& item)
+    {
+        const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b)
+        {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        item = items[b & mask].load(std::memory_order_relaxed);
+        if (t < b)
+        {
+            return true;
+        }
+        // The last job, the thieves may be after it too
+        const bool isWon = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return isWon;
+    }
+
+    // Any thread, fails when the deque is empty or another thread took the job first
+    bool Steal(T& item)
+    {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b)
+        {
+            return false;
+        }
+        item = items[t & mask].load(std::memory_order_relaxed);
+        return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+};
+
+#endif
@@ -0,0 +1,821 @@
+#include "LevelLoader.h"
+#include "../Logger/Logger.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/RigidBodyComponent.h"
+#include "../Components/PhysicsMaterialComponent.h"
+#include "../Components/SpriteComponent.h"
+#include "../Components/AnimationComponent.h"
+#include "../Components/BoxColliderComponent.h"
+#include "../Components/KeyboardControlledComponent.h"
+#include "../Components/CameraFollowComponent.h"
+#include "../Components/ProjectileEmitterComponent.h"
+#include "../Components/HealthComponent.h"
+#include "../Components/ScriptComponent.h"
+#include "../Components/TextLabelComponent.h"
+#include "../Components/PathFollowComponent.h"
+#include "../Components/FlowFollowComponent.h"
+#include "../Components/AIComponent.h"
+#include "../Components/DeathEffectComponent.h"
+#include "../Components/DirectionalSpriteComponent.h"
+#include "../Components/VisionComponent.h"
+#include <sol/sol.hpp>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Lua tables
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+static glm::vec2 GetVec2(const sol::table& table, const char* key, glm::vec2 defaultValue)
+{
+    sol::optional<sol::table> vector = table.get<sol::optional<sol::table>>(key);
+    if (!vector)
+    {
+        return defaultValue;
+    }
+    return glm::vec2(vector->get_or("x", float(defaultValue.x)), vector->get_or("y", float(defaultValue.y)));
+}
+
+static uint32_t GetCollisionLayer(const std::string& name)
+{
+    if (name == "player") return COLLISION_LAYER_PLAYER;
+    if (name == "enemy") return COLLISION_LAYER_ENEMY;
+    if (name == "obstacle") return COLLISION_LAYER_OBSTACLE;
+    if (name == "friendly_projectile") return COLLISION_LAYER_FRIENDLY_PROJECTILE;
+    if (name == "enemy_projectile") return COLLISION_LAYER_ENEMY_PROJECTILE;
+    if (name != "default")
+    {
+        Logger::War("Unknown collision layer " + name + ", using the default one");
+    }
+    return COLLISION_LAYER_DEFAULT;
+}
+
+static SpriteDirection GetSpriteDirection(const std::string& name)
+{
+    if (name == "up") return SPRITE_DIRECTION_UP;
+    if (name == "down") return SPRITE_DIRECTION_DOWN;
+    if (name == "left") return SPRITE_DIRECTION_LEFT;
+    if (name != "right")
+    {
+        Logger::War("Unknown sprite direction " + name + ", using right");
+    }
+    return SPRITE_DIRECTION_RIGHT;
+}
+
+// The two digits of a tile in the map, its row then its column in the tileset
+static bool GetTilemapTile(const std::string& digits, TilemapTile& tile)
+{
+    if (digits.size() != 2 || digits[0] < '0' || digits[0] > '9' || digits[1] < '0' || digits[1] > '9')
+    {
+        return false;
+    }
+    tile = {static_cast<uint16_t>(digits[1] - '0'), static_cast<uint16_t>(digits[0] - '0')};
+    return true;
+}
+
+static void ReadEntity(const sol::table& entity, LevelEntity& levelEntity)
+{
+    LevelEntityValues& values = levelEntity.values;
+    levelEntity.tag = entity.get_or("tag", std::string(""));
+    levelEntity.group = entity.get_or("group", std::string(""));
+    sol::optional<sol::table> components = entity.get<sol::optional<sol::table>>("components");
+    if (!components)
+    {
+        return;
+    }
+
+    if (sol::optional<sol::table> transform = components->get<sol::optional<sol::table>>("transform"))
+    {
+        values.components |= LEVEL_COMPONENT_TRANSFORM;
+        values.position = GetVec2(*transform, "position", glm::vec2(0.0));
+        values.scale = GetVec2(*transform, "scale", glm::vec2(1.0));
+        values.rotation = transform->get_or("rotation", 0.0);
+        values.isAnchoredRight = transform->get_or("anchor_right", false);
+    }
+    if (sol::optional<sol::table> rigidBody = components->get<sol::optional<sol::table>>("rigidbody"))
+    {
+        values.components |= LEVEL_COMPONENT_RIGID_BODY;
+        values.velocity = GetVec2(*rigidBody, "velocity", glm::vec2(0.0));
+    }
+    if (sol::optional<sol::table> physicsMaterial = components->get<sol::optional<sol::table>>("physics_material"))
+    {
+        values.components |= LEVEL_COMPONENT_PHYSICS_MATERIAL;
+        values.acceleration = GetVec2(*physicsMaterial, "acceleration", glm::vec2(0.0));
+        values.damping = physicsMaterial->get_or("damping", 0.0f);
+        values.maxSpeed = physicsMaterial->get_or("max_speed", 0.0f);
+    }
+    if (sol::optional<sol::table> sprite = components->get<sol::optional<sol::table>>("sprite"))
+    {
+        values.components |= LEVEL_COMPONENT_SPRITE;
+        levelEntity.spriteAssetId = sprite->get_or("texture_asset_id", std::string(""));
+        values.spriteWidth = sprite->get_or("width", 0);
+        values.spriteHeight = sprite->get_or("height", 0);
+        values.zIndex = sprite->get_or("z_index", 0);
+        values.isFixed = sprite->get_or("fixed", false);
+        values.spriteFlip = (sprite->get_or("flip_x", false) ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE) | (sprite->get_or("flip_y", false) ? SDL_FLIP_VERTICAL : SDL_FLIP_NONE);
+    }
+    if (sol::optional<sol::table> directionalSprite = components->get<sol::optional<sol::table>>("directional_sprite"))
+    {
+        values.components |= LEVEL_COMPONENT_DIRECTIONAL_SPRITE;
+        values.spriteDirection = GetSpriteDirection(directionalSprite->get_or("direction", std::string("right")));
+    }
+    if (sol::optional<sol::table> animation = components->get<sol::optional<sol::table>>("animation"))
+    {
+        values.components |= LEVEL_COMPONENT_ANIMATION;
+        values.numFrames = animation->get_or("num_frames", 1);
+        values.frameSpeedRate = animation->get_or("speed_rate", 1);
+        values.isLoop = animation->get_or("loop", true);
+    }
+    if (sol::optional<sol::table> boxCollider = components->get<sol::optional<sol::table>>("boxcollider"))
+    {
+        values.components |= LEVEL_COMPONENT_BOX_COLLIDER;
+        values.colliderWidth = boxCollider->get_or("width", 0);
+        values.colliderHeight = boxCollider->get_or("height", 0);
+        values.colliderOffset = GetVec2(*boxCollider, "offset", glm::vec2(0.0));
+        values.colliderLayer = GetCollisionLayer(boxCollider->get_or("layer", std::string("default")));
+        values.colliderMask = COLLISION_MASK_ALL;
+        if (sol::optional<sol::table> mask = boxCollider->get<sol::optional<sol::table>>("mask"))
+        {
+            values.colliderMask = 0;
+            for (size_t i = 1; i <= mask->size(); i++)
+            {
+                values.colliderMask |= GetCollisionLayer(mask->get_or(i, std::string("default")));
+            }
+        }
+        values.isStatic = boxCollider->get_or("static", false);
+        values.isContinuous = boxCollider->get_or("continuous", false);
+        values.isTrigger = boxCollider->get_or("trigger", false);
+    }
+    if (sol::optional<sol::table> keyboardController = components->get<sol::optional<sol::table>>("keyboard_controller"))
+    {
+        values.components |= LEVEL_COMPONENT_KEYBOARD_CONTROLLED;
+        values.upVelocity = GetVec2(*keyboardController, "up_velocity", glm::vec2(0.0));
+        values.rightVelocity = GetVec2(*keyboardController, "right_velocity", glm::vec2(0.0));
+        values.downVelocity = GetVec2(*keyboardController, "down_velocity", glm::vec2(0.0));
+        values.leftVelocity = GetVec2(*keyboardController, "left_velocity", glm::vec2(0.0));
+    }
+    if (sol::optional<sol::table> cameraFollow = components->get<sol::optional<sol::table>>("camera_follow"))
+    {
+        values.components |= LEVEL_COMPONENT_CAMERA_FOLLOW;
+        values.cameraViewport = cameraFollow->get_or("viewport", 0);
+        values.cameraDamping = cameraFollow->get_or("damping", 0.0f);
+    }
+    if (sol::optional<sol::table> projectileEmitter = components->get<sol::optional<sol::table>>("projectile_emitter"))
+    {
+        values.components |= LEVEL_COMPONENT_PROJECTILE_EMITTER;
+        values.projectileVelocity = GetVec2(*projectileEmitter, "projectile_velocity", glm::vec2(0.0));
+        values.repeatFrequency = projectileEmitter->get_or("repeat_frequency", 0);
+        values.projectileDuration = projectileEmitter->get_or("projectile_duration", 10000);
+        values.hitPercentDamage = projectileEmitter->get_or("hit_percentage_damage", 10);
+        values.isFriendly = projectileEmitter->get_or("friendly", false);
+        values.projectileTargetRange = projectileEmitter->get_or("target_range", 0.0f);
+        levelEntity.emitterSoundAssetId = projectileEmitter->get_or("sound_asset_id", std::string(""));
+    }
+    if (sol::optional<sol::table> health = components->get<sol::optional<sol::table>>("health"))
+    {
+        values.components |= LEVEL_COMPONENT_HEALTH;
+        values.healthPercentage = health->get_or("health_percentage", 100);
+        values.deathBurstCount = health->get_or("death_burst", 0);
+        levelEntity.wreckAssetId = health->get_or("wreck_asset_id", std::string(""));
+    }
+    if (sol::optional<sol::table> script = components->get<sol::optional<sol::table>>("script"))
+    {
+        values.components |= LEVEL_COMPONENT_SCRIPT;
+        levelEntity.scriptId = script->get_or("script_id", std::string(""));
+    }
+    if (sol::optional<sol::table> label = components->get<sol::optional<sol::table>>("label"))
+    {
+        values.components |= LEVEL_COMPONENT_TEXT_LABEL;
+        levelEntity.labelText = label->get_or("text", std::string(""));
+        levelEntity.labelFontAssetId = label->get_or("font_asset_id", std::string(""));
+        values.labelColor = {255, 255, 255, 255};
+        if (sol::optional<sol::table> color = label->get<sol::optional<sol::table>>("color"))
+        {
+            values.labelColor.r = color->get_or("r", 255);
+            values.labelColor.g = color->get_or("g", 255);
+            values.labelColor.b = color->get_or("b", 255);
+            values.labelColor.a = color->get_or("a", 255);
+        }
+        values.labelOffset = GetVec2(*label, "offset", glm::vec2(0.0));
+        values.labelScale = label->get_or("scale", 1.0f);
+        values.isLabelFixed = label->get_or("fixed", false);
+    }
+    if (sol::optional<sol::table> pathFollow = components->get<sol::optional<sol::table>>("path_follow"))
+    {
+        values.components |= LEVEL_COMPONENT_PATH_FOLLOW;
+        values.pathGoal = GetVec2(*pathFollow, "goal", glm::vec2(0.0));
+        values.pathSpeed = pathFollow->get_or("speed", 0.0f);
+    }
+    if (sol::optional<sol::table> flowFollow = components->get<sol::optional<sol::table>>("flow_follow"))
+    {
+        values.components |= LEVEL_COMPONENT_FLOW_FOLLOW;
+        values.flowSpeed = flowFollow->get_or("speed", 0.0f);
+    }
+    if (sol::optional<sol::table> ai = components->get<sol::optional<sol::table>>("ai"))
+    {
+        values.components |= LEVEL_COMPONENT_AI;
+        values.aiSightRange = ai->get_or("sight_range", 0.0f);
+        values.aiAttackRange = ai->get_or("attack_range", 0.0f);
+    }
+    if (sol::optional<sol::table> vision = components->get<sol::optional<sol::table>>("vision"))
+    {
+        values.components |= LEVEL_COMPONENT_VISION;
+        values.visionRadius = vision->get_or("radius", 0.0f);
+    }
+}
+
+bool LevelLoader::LoadFromLua(const std::string& source, const std::string& chunkName, LevelData& levelData)
+{
+    levelData = LevelData();
+
+    // The level only describes data, it gets a state of its own with the basic libraries
+    sol::state lua;
+    lua.open_libraries(sol::lib::base, sol::lib::math, sol::lib::string, sol::lib::table);
+    sol::protected_function_result result = lua.safe_script(source, sol::script_pass_on_error, chunkName);
+    if (!result.valid())
+    {
+        sol::error error = result;
+        Logger::Err("Error loading level " + chunkName + ": " + error.what());
+        return false;
+    }
+    sol::optional<sol::table> level = lua.get<sol::optional<sol::table>>("Level");
+    if (!level)
+    {
+        Logger::Err("Level " + chunkName + " defines no Level table");
+        return false;
+    }
+
+    if (sol::optional<sol::table> assets = level->get<sol::optional<sol::table>>("assets"))
+    {
+        for (size_t i = 1; i <= assets->size(); i++)
+        {
+            sol::table asset = (*assets)[i];
+            const std::string type = asset.get_or("type", std::string(""));
+            const std::string assetId = asset.get_or("id", std::string(""));
+            const std::string filePath = asset.get_or("file", std::string(""));
+            if (type == "texture")
+            {
+                levelData.textures.push_back({assetId, filePath, asset.get_or("atlas", false), asset.get_or("directional", false), asset.get_or("stream", false)});
+            }
+            else if (type == "sound")
+            {
+                levelData.sounds.push_back({assetId, filePath});
+            }
+            else if (type == "font")
+            {
+                levelData.fonts.push_back({assetId, filePath, asset.get_or("font_size", 14)});
+            }
+            else if (type == "script")
+            {
+                levelData.scripts.push_back({assetId, filePath});
+            }
+            else
+            {
+                Logger::War("Unknown asset type " + type + " in level " + chunkName);
+            }
+        }
+    }
+
+    levelData.musicFilePath = level->get_or("music_file", std::string(""));
+
+    if (sol::optional<sol::table> tilemap = level->get<sol::optional<sol::table>>("tilemap"))
+    {
+        levelData.tilemap.mapFilePath = tilemap->get_or("map_file", std::string(""));
+        levelData.tilemap.streamFilePath = tilemap->get_or("stream_file", std::string(""));
+        levelData.tilemap.tilesetAssetId = tilemap->get_or("texture_asset_id", std::string(""));
+        levelData.tilemap.tileSize = tilemap->get_or("tile_size", 32);
+        levelData.tilemap.tileScale = tilemap->get_or("scale", 1.0);
+        levelData.tilemap.hasFogOfWar = tilemap->get_or("fog_of_war", false);
+        if (sol::optional<sol::table> blockedTiles = tilemap->get<sol::optional<sol::table>>("blocked_tiles"))
+        {
+            for (size_t i = 1; i <= blockedTiles->size(); i++)
+            {
+                const std::string digits = blockedTiles->get_or(i, std::string(""));
+                TilemapTile tile;
+                if (!GetTilemapTile(digits, tile))
+                {
+                    Logger::War("Blocked tile " + digits + " in level " + chunkName + " isn't two digits, row and column");
+                    continue;
+                }
+                levelData.tilemap.blockedTiles.push_back(tile);
+            }
+        }
+        if (sol::optional<sol::table> animatedTiles = tilemap->get<sol::optional<sol::table>>("animated_tiles"))
+        {
+            for (size_t i = 1; i <= animatedTiles->size(); i++)
+            {
+                sol::table animatedTile = (*animatedTiles)[i];
+                LevelTileAnimation animation;
+                animation.frameSpeedRate = animatedTile.get_or("speed_rate", 1);
+                sol::optional<sol::table> frames = animatedTile.get<sol::optional<sol::table>>("frames");
+                for (size_t j = 1; frames && j <= frames->size(); j++)
+                {
+                    const std::string digits = frames->get_or(j, std::string(""));
+                    TilemapTile tile;
+                    if (!GetTilemapTile(digits, tile))
+                    {
+                        Logger::War("Animated tile frame " + digits + " in level " + chunkName + " isn't two digits, row and column");
+                        continue;
+                    }
+                    animation.frames.push_back(tile);
+                }
+                if (!animation.frames.empty())
+                {
+                    levelData.tilemap.animatedTiles.push_back(animation);
+                }
+            }
+        }
+    }
+
+    if (sol::optional<sol::table> parallax = level->get<sol::optional<sol::table>>("parallax"))
+    {
+        for (size_t i = 1; i <= parallax->size(); i++)
+        {
+            sol::table layer = (*parallax)[i];
+            LevelParallaxLayer levelLayer;
+            levelLayer.textureAssetId = layer.get_or("texture_asset_id", std::string(""));
+            levelLayer.factor = layer.get_or("factor", 1.0f);
+            levelLayer.scrollVelocity = GetVec2(layer, "scroll", glm::vec2(0.0));
+            levelLayer.scale = layer.get_or("scale", 1.0f);
+            levelLayer.isForeground = layer.get_or("foreground", false);
+            levelData.parallaxLayers.push_back(levelLayer);
+        }
+    }
+
+    if (sol::optional<sol::table> entities = level->get<sol::optional<sol::table>>("entities"))
+    {
+        levelData.entities.resize(entities->size());
+        for (size_t i = 1; i <= entities->size(); i++)
+        {
+            LevelEntity& levelEntity = levelData.entities[i - 1];
+            // Zeroed with the padding, the values go to the cache byte for byte
+            std::memset(&levelEntity.values, 0, sizeof(levelEntity.values));
+            ReadEntity((*entities)[i], levelEntity);
+        }
+    }
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Cache
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The header, then each section as a count followed by its records. Strings are a uint32
+// length and the characters, the entity values are copied raw.
+/////////////////////////////////////////////////////////////////////////////////////////////
+struct LevelCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceHash;
+    uint32_t entityValuesSize;
+};
+
+// FNV-1a
+static uint64_t HashSource(const std::string& source)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (const char c: source)
+    {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+template <typename T>
+static void WriteValue(std::vector<char>& cache, const T& value)
+{
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    cache.insert(cache.end(), bytes, bytes + sizeof(T));
+}
+
+static void WriteString(std::vector<char>& cache, const std::string& value)
+{
+    WriteValue(cache, static_cast<uint32_t>(value.size()));
+    cache.insert(cache.end(), value.begin(), value.end());
+}
+
+class CacheReader
+{
+private:
+    const std::vector<char>& cache;
+    size_t offset = 0;
+    bool isValid = true;
+
+public:
+    CacheReader(const std::vector<char>& cache): cache(cache) {}
+
+    bool IsValid() const { return isValid; }
+
+    template <typename T>
+    T Read()
+    {
+        T value;
+        std::memset(&value, 0, sizeof(T));
+        if (offset + sizeof(T) > cache.size())
+        {
+            isValid = false;
+            return value;
+        }
+        std::memcpy(&value, &cache[offset], sizeof(T));
+        offset += sizeof(T);
+        return value;
+    }
+
+    std::string ReadString()
+    {
+        const uint32_t size = Read<uint32_t>();
+        if (!isValid || offset + size > cache.size())
+        {
+            isValid = false;
+            return "";
+        }
+        std::string value(&cache[offset], size);
+        offset += size;
+        return value;
+    }
+
+    // A count can't be larger than the bytes left, a corrupted one fails instead of allocating
+    uint32_t ReadCount()
+    {
+        const uint32_t count = Read<uint32_t>();
+        if (count > cache.size() - offset)
+        {
+            isValid = false;
+            return 0;
+        }
+        return count;
+    }
+};
+
+std::vector<char> LevelLoader::WriteCache(const LevelData& levelData, uint64_t sourceHash)
+{
+    std::vector<char> cache;
+    LevelCacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, LEVEL_CACHE_MAGIC, sizeof(header.magic));
+    header.version = LEVEL_CACHE_VERSION;
+    header.sourceHash = sourceHash;
+    header.entityValuesSize = sizeof(LevelEntityValues);
+    WriteValue(cache, header);
+
+    WriteValue(cache, static_cast<uint32_t>(levelData.textures.size()));
+    for (const auto& texture: levelData.textures)
+    {
+        WriteString(cache, texture.assetId);
+        WriteString(cache, texture.filePath);
+        WriteValue(cache, static_cast<uint8_t>(texture.isAtlased));
+        WriteValue(cache, static_cast<uint8_t>(texture.isDirectional));
+        WriteValue(cache, static_cast<uint8_t>(texture.isStreamed));
+    }
+    WriteValue(cache, static_cast<uint32_t>(levelData.sounds.size()));
+    for (const auto& sound: levelData.sounds)
+    {
+        WriteString(cache, sound.assetId);
+        WriteString(cache, sound.filePath);
+    }
+    WriteValue(cache, static_cast<uint32_t>(levelData.fonts.size()));
+    for (const auto& font: levelData.fonts)
+    {
+        WriteString(cache, font.assetId);
+        WriteString(cache, font.filePath);
+        WriteValue(cache, static_cast<int32_t>(font.fontSize));
+    }
+    WriteValue(cache, static_cast<uint32_t>(levelData.scripts.size()));
+    for (const auto& script: levelData.scripts)
+    {
+        WriteString(cache, script.scriptId);
+        WriteString(cache, script.filePath);
+    }
+    WriteString(cache, levelData.musicFilePath);
+    WriteString(cache, levelData.tilemap.mapFilePath);
+    WriteString(cache, levelData.tilemap.streamFilePath);
+    WriteString(cache, levelData.tilemap.tilesetAssetId);
+    WriteValue(cache, static_cast<int32_t>(levelData.tilemap.tileSize));
+    WriteValue(cache, levelData.tilemap.tileScale);
+    WriteValue(cache, static_cast<uint32_t>(levelData.tilemap.animatedTiles.size()));
+    for (const auto& animation: levelData.tilemap.animatedTiles)
+    {
+        WriteValue(cache, static_cast<int32_t>(animation.frameSpeedRate));
+        WriteValue(cache, static_cast<uint32_t>(animation.frames.size()));
+        for (const auto& frame: animation.frames)
+        {
+            WriteValue(cache, frame);
+        }
+    }
+    WriteValue(cache, static_cast<uint8_t>(levelData.tilemap.hasFogOfWar));
+    WriteValue(cache, static_cast<uint32_t>(levelData.tilemap.blockedTiles.size()));
+    for (const auto& tile: levelData.tilemap.blockedTiles)
+    {
+        WriteValue(cache, tile);
+    }
+    WriteValue(cache, static_cast<uint32_t>(levelData.parallaxLayers.size()));
+    for (const auto& layer: levelData.parallaxLayers)
+    {
+        WriteString(cache, layer.textureAssetId);
+        WriteValue(cache, layer.factor);
+        WriteValue(cache, layer.scrollVelocity);
+        WriteValue(cache, layer.scale);
+        WriteValue(cache, static_cast<uint8_t>(layer.isForeground));
+    }
+    WriteValue(cache, static_cast<uint32_t>(levelData.entities.size()));
+    for (const auto& entity: levelData.entities)
+    {
+        WriteValue(cache, entity.values);
+        WriteString(cache, entity.spriteAssetId);
+        WriteString(cache, entity.scriptId);
+        WriteString(cache, entity.emitterSoundAssetId);
+        WriteString(cache, entity.wreckAssetId);
+        WriteString(cache, entity.labelText);
+        WriteString(cache, entity.labelFontAssetId);
+        WriteString(cache, entity.tag);
+        WriteString(cache, entity.group);
+    }
+    return cache;
+}
+
+bool LevelLoader::ReadCache(const std::vector<char>& cache, uint64_t sourceHash, LevelData& levelData)
+{
+    levelData = LevelData();
+    CacheReader reader(cache);
+    const LevelCacheHeader header = reader.Read<LevelCacheHeader>();
+    // The values are copied raw, a cache written by a build with another layout is stale as well
+    if (!reader.IsValid() || std::memcmp(header.magic, LEVEL_CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != LEVEL_CACHE_VERSION ||
+        header.sourceHash != sourceHash || header.entityValuesSize != sizeof(LevelEntityValues))
+    {
+        return false;
+    }
+
+    levelData.textures.resize(reader.ReadCount());
+    for (auto& texture: levelData.textures)
+    {
+        texture.assetId = reader.ReadString();
+        texture.filePath = reader.ReadString();
+        texture.isAtlased = reader.Read<uint8_t>() != 0;
+        texture.isDirectional = reader.Read<uint8_t>() != 0;
+        texture.isStreamed = reader.Read<uint8_t>() != 0;
+    }
+    levelData.sounds.resize(reader.ReadCount());
+    for (auto& sound: levelData.sounds)
+    {
+        sound.assetId = reader.ReadString();
+        sound.filePath = reader.ReadString();
+    }
+    levelData.fonts.resize(reader.ReadCount());
+    for (auto& font: levelData.fonts)
+    {
+        font.assetId = reader.ReadString();
+        font.filePath = reader.ReadString();
+        font.fontSize = reader.Read<int32_t>();
+    }
+    levelData.scripts.resize(reader.ReadCount());
+    for (auto& script: levelData.scripts)
+    {
+        script.scriptId = reader.ReadString();
+        script.filePath = reader.ReadString();
+    }
+    levelData.musicFilePath = reader.ReadString();
+    levelData.tilemap.mapFilePath = reader.ReadString();
+    levelData.tilemap.streamFilePath = reader.ReadString();
+    levelData.tilemap.tilesetAssetId = reader.ReadString();
+    levelData.tilemap.tileSize = reader.Read<int32_t>();
+    levelData.tilemap.tileScale = reader.Read<double>();
+    levelData.tilemap.animatedTiles.resize(reader.ReadCount());
+    for (auto& animation: levelData.tilemap.animatedTiles)
+    {
+        animation.frameSpeedRate = reader.Read<int32_t>();
+        animation.frames.resize(reader.ReadCount());
+        for (auto& frame: animation.frames)
+        {
+            frame = reader.Read<TilemapTile>();
+        }
+    }
+    levelData.tilemap.hasFogOfWar = reader.Read<uint8_t>() != 0;
+    levelData.tilemap.blockedTiles.resize(reader.ReadCount());
+    for (auto& tile: levelData.tilemap.blockedTiles)
+    {
+        tile = reader.Read<TilemapTile>();
+    }
+    levelData.parallaxLayers.resize(reader.ReadCount());
+    for (auto& layer: levelData.parallaxLayers)
+    {
+        layer.textureAssetId = reader.ReadString();
+        layer.factor = reader.Read<float>();
+        layer.scrollVelocity = reader.Read<glm::vec2>();
+        layer.scale = reader.Read<float>();
+        layer.isForeground = reader.Read<uint8_t>() != 0;
+    }
+    levelData.entities.resize(reader.ReadCount());
+    for (auto& entity: levelData.entities)
+    {
+        entity.values = reader.Read<LevelEntityValues>();
+        entity.spriteAssetId = reader.ReadString();
+        entity.scriptId = reader.ReadString();
+        entity.emitterSoundAssetId = reader.ReadString();
+        entity.wreckAssetId = reader.ReadString();
+        entity.labelText = reader.ReadString();
+        entity.labelFontAssetId = reader.ReadString();
+        entity.tag = reader.ReadString();
+        entity.group = reader.ReadString();
+    }
+
+    if (!reader.IsValid())
+    {
+        levelData = LevelData();
+        return false;
+    }
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Level loader
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LevelLoader::Load(const std::string& levelFilePath, const std::string& cacheFilePath, LevelData& levelData)
+{
+    std::ifstream levelFile(levelFilePath, std::ios::binary);
+    if (!levelFile)
+    {
+        Logger::Err("Unable to open the level " + levelFilePath);
+        levelData = LevelData();
+        return false;
+    }
+    const std::string source((std::istreambuf_iterator<char>(levelFile)), std::istreambuf_iterator<char>());
+    const uint64_t sourceHash = HashSource(source);
+
+    std::ifstream cacheFile(cacheFilePath, std::ios::binary);
+    if (cacheFile)
+    {
+        const std::vector<char> cache((std::istreambuf_iterator<char>(cacheFile)), std::istreambuf_iterator<char>());
+        if (ReadCache(cache, sourceHash, levelData))
+        {
+            Logger::Log("Level " + levelFilePath + " loaded from its cache");
+            return true;
+        }
+    }
+
+    if (!LoadFromLua(source, levelFilePath, levelData))
+    {
+        levelData = LevelData();
+        return false;
+    }
+    const std::vector<char> cache = WriteCache(levelData, sourceHash);
+    std::ofstream(cacheFilePath, std::ios::binary).write(cache.data(), cache.size());
+    Logger::Log("Level " + levelFilePath + " evaluated and cached to " + cacheFilePath);
+    return true;
+}
+
+// The components of one type for the entities of a level, added with a single InsertBulk
+template <typename TComponent>
+struct LevelComponents
+{
+    std::vector<Entity> entities;
+    std::vector<TComponent> components;
+
+    template <typename ...TArgs>
+    void Add(Entity entity, TArgs&& ...args)
+    {
+        entities.push_back(entity);
+        components.emplace_back(std::forward<TArgs>(args)...);
+    }
+
+    void Insert(Registry& registry)
+    {
+        registry.InsertBulk<TComponent>(entities, components);
+    }
+};
+
+void LevelLoader::CreateEntities(Registry& registry, const LevelData& levelData, double startTime, int windowWidth)
+{
+    CreateEntities(registry, levelData, startTime, windowWidth, 0, levelData.entities.size());
+}
+
+void LevelLoader::CreateEntities(Registry& registry, const LevelData& levelData, double startTime, int windowWidth, size_t firstEntity, size_t numEntities)
+{
+    // Gathered per type, then each type is added in one go
+    LevelComponents<TransformComponent> transforms;
+    LevelComponents<RigidBodyComponent> rigidBodies;
+    LevelComponents<PhysicsMaterialComponent> physicsMaterials;
+    LevelComponents<SpriteComponent> sprites;
+    LevelComponents<DirectionalSpriteComponent> directionalSprites;
+    LevelComponents<AnimationComponent> animations;
+    LevelComponents<BoxColliderComponent> boxColliders;
+    LevelComponents<KeyboardControlledComponent> keyboardControls;
+    LevelComponents<CameraFollowComponent> cameraFollows;
+    LevelComponents<ProjectileEmitterComponent> projectileEmitters;
+    LevelComponents<HealthComponent> healths;
+    LevelComponents<DeathEffectComponent> deathEffects;
+    LevelComponents<ScriptComponent> scripts;
+    LevelComponents<TextLabelComponent> textLabels;
+    LevelComponents<PathFollowComponent> pathFollows;
+    LevelComponents<FlowFollowComponent> flowFollows;
+    LevelComponents<AIComponent> ais;
+    LevelComponents<VisionComponent> visions;
+    const size_t endEntity = std::min(firstEntity + numEntities, levelData.entities.size());
+    for (size_t i = firstEntity; i < endEntity; i++)
+    {
+        const LevelEntity& levelEntity = levelData.entities[i];
+        const LevelEntityValues& values = levelEntity.values;
+        Entity entity = registry.CreateEntity();
+        if (values.components & LEVEL_COMPONENT_TRANSFORM)
+        {
+            const glm::vec2 position(values.isAnchoredRight ? windowWidth + values.position.x : values.position.x, values.position.y);
+            transforms.Add(entity, position, values.scale, static_cast<float>(values.rotation));
+        }
+        if (values.components & LEVEL_COMPONENT_RIGID_BODY)
+        {
+            rigidBodies.Add(entity, values.velocity);
+        }
+        if (values.components & LEVEL_COMPONENT_PHYSICS_MATERIAL)
+        {
+            physicsMaterials.Add(entity, values.acceleration, values.damping, values.maxSpeed);
+        }
+        if (values.components & LEVEL_COMPONENT_SPRITE)
+        {
+            sprites.Add(entity, levelEntity.spriteAssetId, values.spriteWidth, values.spriteHeight, values.zIndex, values.isFixed, 0, 0, static_cast<SDL_RendererFlip>(values.spriteFlip));
+        }
+        if (values.components & LEVEL_COMPONENT_DIRECTIONAL_SPRITE)
+        {
+            directionalSprites.Add(entity, static_cast<SpriteDirection>(values.spriteDirection));
+        }
+        if (values.components & LEVEL_COMPONENT_ANIMATION)
+        {
+            animations.Add(entity, values.numFrames, values.frameSpeedRate, values.isLoop, startTime);
+        }
+        if (values.components & LEVEL_COMPONENT_BOX_COLLIDER)
+        {
+            boxColliders.Add(entity, values.colliderWidth, values.colliderHeight, values.colliderOffset, values.colliderLayer, values.colliderMask, values.isStatic, values.isContinuous, values.isTrigger);
+        }
+        if (values.components & LEVEL_COMPONENT_KEYBOARD_CONTROLLED)
+        {
+            keyboardControls.Add(entity, values.upVelocity, values.rightVelocity, values.downVelocity, values.leftVelocity);
+        }
+        if (values.components & LEVEL_COMPONENT_CAMERA_FOLLOW)
+        {
+            cameraFollows.Add(entity, values.cameraViewport, values.cameraDamping);
+        }
+        if (values.components & LEVEL_COMPONENT_PROJECTILE_EMITTER)
+        {
+            projectileEmitters.Add(entity, values.projectileVelocity, values.repeatFrequency, values.projectileDuration, values.hitPercentDamage, values.isFriendly, startTime, levelEntity.emitterSoundAssetId, values.projectileTargetRange);
+        }
+        if (values.components & LEVEL_COMPONENT_HEALTH)
+        {
+            healths.Add(entity, values.healthPercentage);
+            if (values.deathBurstCount > 0 || !levelEntity.wreckAssetId.empty())
+            {
+                deathEffects.Add(entity, levelEntity.wreckAssetId, values.deathBurstCount);
+            }
+        }
+        if (values.components & LEVEL_COMPONENT_SCRIPT)
+        {
+            scripts.Add(entity, levelEntity.scriptId);
+        }
+        if (values.components & LEVEL_COMPONENT_TEXT_LABEL)
+        {
+            textLabels.Add(entity, levelEntity.labelText, levelEntity.labelFontAssetId, values.labelColor, values.labelOffset, values.labelScale, values.isLabelFixed);
+        }
+        if (values.components & LEVEL_COMPONENT_PATH_FOLLOW)
+        {
+            pathFollows.Add(entity, values.pathGoal, values.pathSpeed);
+        }
+        if (values.components & LEVEL_COMPONENT_FLOW_FOLLOW)
+        {
+            flowFollows.Add(entity, values.flowSpeed);
+        }
+        if (values.components & LEVEL_COMPONENT_AI)
+        {
+            ais.Add(entity, values.aiSightRange, values.aiAttackRange, values.position);
+        }
+        if (values.components & LEVEL_COMPONENT_VISION)
+        {
+            visions.Add(entity, values.visionRadius);
+        }
+        if (!levelEntity.tag.empty())
+        {
+            entity.Tag(levelEntity.tag);
+        }
+        if (!levelEntity.group.empty())
+        {
+            entity.Group(levelEntity.group);
+        }
+    }
+    transforms.Insert(registry);
+    rigidBodies.Insert(registry);
+    physicsMaterials.Insert(registry);
+    sprites.Insert(registry);
+    directionalSprites.Insert(registry);
+    animations.Insert(registry);
+    boxColliders.Insert(registry);
+    keyboardControls.Insert(registry);
+    cameraFollows.Insert(registry);
+    projectileEmitters.Insert(registry);
+    healths.Insert(registry);
+    deathEffects.Insert(registry);
+    scripts.Insert(registry);
+    textLabels.Insert(registry);
+    pathFollows.Insert(registry);
+    flowFollows.Insert(registry);
+    ais.Insert(registry);
+    visions.Insert(registry);
+}
@@ -0,0 +1,230 @@
+#ifndef LEVELLOADER_H
+#define LEVELLOADER_H
+
+#include "../ECS/ECS.h"
+#include "../Tilemap/TilemapFormat.h"
+#include <SDL2/SDL.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Level data
+/////////////////////////////////////////////////////////////////////////////////////////////
+// A level as the Lua file describes it: the assets to load, the tilemap and the entities
+// with their components. Only the plain values are kept, so it can be cached as it is.
+/////////////////////////////////////////////////////////////////////////////////////////////
+struct LevelTexture
+{
+    std::string assetId;
+    std::string filePath;
+    bool isAtlased;
+    // Loaded from one file per direction, see TEXTURE_DIRECTION_PLACEHOLDER
+    bool isDirectional;
+    // Only a low mip resident until it is drawn, see AssetStore::UseTexture
+    bool isStreamed;
+};
+
+struct LevelSound
+{
+    std::string assetId;
+    std::string filePath;
+};
+
+struct LevelFont
+{
+    std::string assetId;
+    std::string filePath;
+    int fontSize;
+};
+
+struct LevelScript
+{
+    std::string scriptId;
+    std::string filePath;
+};
+
+// Frames as the tiles of the map (e.g. "21"), the map tiles showing the first one animate
+struct LevelTileAnimation
+{
+    std::vector<TilemapTile> frames;
+    int frameSpeedRate = 1;
+};
+
+struct LevelTilemap
+{
+    std::string mapFilePath;
+    // The binary map streamed around the camera when it exists, see make tilemaps
+    std::string streamFilePath;
+    std::string tilesetAssetId;
+    int tileSize = 32;
+    double tileScale = 1.0;
+    // The tiles the ground units can't drive on, the two digits of the map (e.g. "21")
+    std::vector<TilemapTile> blockedTiles;
+    std::vector<LevelTileAnimation> animatedTiles;
+    // The map is hidden but around the entities with a vision
+    bool hasFogOfWar = false;
+};
+
+// A texture repeated behind or over the world, see ParallaxLayer
+struct LevelParallaxLayer
+{
+    std::string textureAssetId;
+    float factor = 1.0f;
+    glm::vec2 scrollVelocity = glm::vec2(0.0f);
+    float scale = 1.0f;
+    bool isForeground = false;
+};
+
+// Which components a level entity has
+enum LevelComponentFlags
+{
+    LEVEL_COMPONENT_TRANSFORM = 1 << 0,
+    LEVEL_COMPONENT_RIGID_BODY = 1 << 1,
+    LEVEL_COMPONENT_SPRITE = 1 << 2,
+    LEVEL_COMPONENT_ANIMATION = 1 << 3,
+    LEVEL_COMPONENT_BOX_COLLIDER = 1 << 4,
+    LEVEL_COMPONENT_KEYBOARD_CONTROLLED = 1 << 5,
+    LEVEL_COMPONENT_CAMERA_FOLLOW = 1 << 6,
+    LEVEL_COMPONENT_PROJECTILE_EMITTER = 1 << 7,
+    LEVEL_COMPONENT_HEALTH = 1 << 8,
+    LEVEL_COMPONENT_SCRIPT = 1 << 9,
+    LEVEL_COMPONENT_TEXT_LABEL = 1 << 10,
+    LEVEL_COMPONENT_PATH_FOLLOW = 1 << 11,
+    LEVEL_COMPONENT_FLOW_FOLLOW = 1 << 12,
+    LEVEL_COMPONENT_AI = 1 << 13,
+    LEVEL_COMPONENT_DIRECTIONAL_SPRITE = 1 << 14,
+    LEVEL_COMPONENT_VISION = 1 << 15,
+    LEVEL_COMPONENT_PHYSICS_MATERIAL = 1 << 16
+};
+
+// The values of the components of a level entity, copied to the cache as they are
+struct LevelEntityValues
+{
+    uint32_t components;
+
+    glm::vec2 position;
+    glm::vec2 scale;
+    double rotation;
+    // The position x is measured from the right edge of the window
+    bool isAnchoredRight;
+
+    glm::vec2 velocity;
+    glm::vec2 acceleration;
+    float damping;
+    float maxSpeed;
+
+    int spriteWidth;
+    int spriteHeight;
+    int zIndex;
+    bool isFixed;
+    int spriteFlip;
+    int spriteDirection;
+
+    int numFrames;
+    int frameSpeedRate;
+    bool isLoop;
+
+    int colliderWidth;
+    int colliderHeight;
+    glm::vec2 colliderOffset;
+    uint32_t colliderLayer;
+    uint32_t colliderMask;
+    bool isStatic;
+    bool isContinuous;
+    bool isTrigger;
+
+    glm::vec2 upVelocity;
+    glm::vec2 rightVelocity;
+    glm::vec2 downVelocity;
+    glm::vec2 leftVelocity;
+
+    glm::vec2 projectileVelocity;
+    int repeatFrequency;
+    int projectileDuration;
+    int hitPercentDamage;
+    bool isFriendly;
+    float projectileTargetRange;
+
+    int healthPercentage;
+    int deathBurstCount;
+
+    int cameraViewport;
+    float cameraDamping;
+
+    glm::vec2 pathGoal;
+    float pathSpeed;
+
+    float flowSpeed;
+
+    float aiSightRange;
+    float aiAttackRange;
+
+    float visionRadius;
+
+    SDL_Color labelColor;
+    glm::vec2 labelOffset;
+    float labelScale;
+    bool isLabelFixed;
+};
+
+struct LevelEntity
+{
+    LevelEntityValues values;
+    std::string spriteAssetId;
+    std::string scriptId;
+    std::string emitterSoundAssetId;
+    // Empty when the entity leaves no wreck
+    std::string wreckAssetId;
+    std::string labelText;
+    std::string labelFontAssetId;
+    // Empty when the entity has none
+    std::string tag;
+    std::string group;
+};
+
+struct LevelData
+{
+    std::vector<LevelTexture> textures;
+    std::vector<LevelSound> sounds;
+    std::vector<LevelFont> fonts;
+    // Streamed while the level plays, none when empty
+    std::string musicFilePath;
+    std::vector<LevelScript> scripts;
+    LevelTilemap tilemap;
+    // Back to front
+    std::vector<LevelParallaxLayer> parallaxLayers;
+    std::vector<LevelEntity> entities;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Level loader
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Levels are Lua files defining a global Level table (see assets/levels/level1.lua). The
+// evaluated level is written to a binary cache next to it, a later load whose Lua file
+// hashes the same reads the cache and never starts the interpreter.
+/////////////////////////////////////////////////////////////////////////////////////////////
+const char LEVEL_CACHE_MAGIC[4] = {'D', 'L', 'V', 'C'};
+const uint32_t LEVEL_CACHE_VERSION = 21;
+
+class LevelLoader
+{
+public:
+    // Errors are logged, a level that fails to load leaves levelData empty
+    static bool Load(const std::string& levelFilePath, const std::string& cacheFilePath, LevelData& levelData);
+
+    // Evaluates the Lua file, without the cache
+    static bool LoadFromLua(const std::string& source, const std::string& chunkName, LevelData& levelData);
+
+    static std::vector<char> WriteCache(const LevelData& levelData, uint64_t sourceHash);
+    // Fails when the cache is for another source or version
+    static bool ReadCache(const std::vector<char>& cache, uint64_t sourceHash, LevelData& levelData);
+
+    // Adds the entities of the level to the registry, their animations and emitters start at startTime
+    static void CreateEntities(Registry& registry, const LevelData& levelData, double startTime, int windowWidth);
+    // Only numEntities of them from firstEntity on, a level loaded over several frames
+    static void CreateEntities(Registry& registry, const LevelData& levelData, double startTime, int windowWidth, size_t firstEntity, size_t numEntities);
+};
+
+#endif
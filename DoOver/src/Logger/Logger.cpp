@@ -1,42 +1,450 @@
 #include "Logger.h"
 #include <iostream>
+#include <fstream>
 #include <string>
 #include <chrono>
 #include <ctime>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
 
-std::vector<LogEntry> Logger::messages;
+// Runtime level, below the compiled one everything is already gone
+static std::atomic<int> logLevel{LOG_COMPILED_LEVEL};
 
-std::string CurrentDateTimeToString()
+std::string Logger::FormatTime(int64_t millisecs)
 {
-	std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+	std::time_t time = static_cast<std::time_t>(millisecs / 1000);
 	std::string output(30, '\0');
-	std::strftime(&output[0], output.size(), "%d-%b-%Y %H:%M:%S", std::localtime(&now));
+	output.resize(std::strftime(&output[0], output.size(), "%d-%b-%Y %H:%M:%S", std::localtime(&time)));
 	return output;
 }
 
-void Logger::Log(const std::string& message)
+// Replaces the {} placeholders of the format with the arguments
+static std::string FormatMessage(const char* format, const LogArgument* arguments, int numArguments, const std::string& strings)
 {
-	LogEntry logEntry;
-	logEntry.type = LOG_INFO;
-	logEntry.message = "LOG: [" + CurrentDateTimeToString() + "]: " + message;
-	std::cout << "\x1B[32m" << logEntry.message << "\033[0m" << std::endl;
-	messages.push_back(logEntry);
+	std::string message;
+	int argument = 0;
+	for (const char* ch = format; *ch; ch++)
+	{
+		if ((ch[0] == '{' && ch[1] == '{') || (ch[0] == '}' && ch[1] == '}'))
+		{
+			message += *ch++;
+			continue;
+		}
+		if (ch[0] != '{' || ch[1] != '}')
+		{
+			message += *ch;
+			continue;
+		}
+		ch++;
+		if (argument == numArguments)
+		{
+			message += "{}";
+			continue;
+		}
+
+		const LogArgument& value = arguments[argument++];
+		switch (value.type)
+		{
+			case LogArgument::SIGNED:
+				message += std::to_string(value.signedValue);
+				break;
+			case LogArgument::UNSIGNED:
+				message += std::to_string(value.unsignedValue);
+				break;
+			case LogArgument::FLOATING:
+				message += std::to_string(value.floatingValue);
+				break;
+			case LogArgument::STRING:
+				message.append(strings, value.string.offset, value.string.length);
+				break;
+		}
+	}
+	return message;
+}
+
+static const char* GetLogPrefix(LogType type)
+{
+	switch (type)
+	{
+		case LOG_TRACE: return "TRC";
+		case LOG_DEBUG: return "DBG";
+		case LOG_INFO: return "LOG";
+		case LOG_WARNING: return "WAR";
+		case LOG_ERROR: return "ERR";
+	}
+	return "LOG";
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Log history
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Fixed ring of records, only the writer thread adds to it. The formats are interned by
+// their address, as they are string literals.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class LogHistory
+{
+private:
+	std::vector<LogRecord> records;
+	int first = 0;
+	int size = 0;
+	std::unordered_map<const char*, uint32_t> formatIds;
+	std::vector<const char*> formats;
+	std::ofstream spillFile;
+	// Change of the record strings capacity since the history was filled with empty records
+	size_t numStringBytes = 0;
+
+public:
+	std::mutex mutex;
+
+	LogHistory(): records(LOG_HISTORY_CAPACITY) {}
+
+	// Writer thread only, the table only changes under the lock
+	uint32_t InternFormat(const char* format)
+	{
+		auto formatId = formatIds.find(format);
+		if (formatId != formatIds.end())
+		{
+			return formatId->second;
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		formatIds.emplace(format, formats.size());
+		formats.push_back(format);
+		return formats.size() - 1;
+	}
+
+	const char* GetFormat(uint32_t formatId) const
+	{
+		return formats[formatId];
+	}
+
+	void Add(LogRecord&& record)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		LogRecord& slot = records[(first + size) % LOG_HISTORY_CAPACITY];
+		if (size == LOG_HISTORY_CAPACITY)
+		{
+			if (spillFile.is_open())
+			{
+				spillFile << GetLogPrefix(slot.type) << ": [" << Logger::FormatTime(slot.millisecs) << "]: " << FormatMessage(GetFormat(slot.formatId), slot.arguments, slot.numArguments, slot.strings) << '\n';
+			}
+			first = (first + 1) % LOG_HISTORY_CAPACITY;
+			size--;
+		}
+		numStringBytes -= slot.strings.capacity();
+		slot = std::move(record);
+		numStringBytes += slot.strings.capacity();
+		size++;
+	}
+
+	// Called with the lock held
+	size_t GetMemoryUsage() const
+	{
+		return records.capacity() * sizeof(LogRecord) + numStringBytes + formats.capacity() * sizeof(const char*);
+	}
+
+	// Called with the lock held
+	int GetSize() const
+	{
+		return size;
+	}
+
+	const LogRecord& GetRecord(int index) const
+	{
+		return records[(first + index) % LOG_HISTORY_CAPACITY];
+	}
+
+	bool SetSpillFile(const std::string& filePath)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		spillFile.close();
+		spillFile.clear();
+		if (filePath.empty())
+		{
+			return true;
+		}
+		spillFile.open(filePath, std::ios::app);
+		return spillFile.is_open();
+	}
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Log queue
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Bounded multi-producer single-consumer ring: each slot has a sequence number telling
+// whether it is free for the producer at that position, or filled for the consumer.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class LogQueue
+{
+private:
+	struct Slot
+	{
+		std::atomic<uint64_t> sequence;
+		LogType type;
+		int64_t millisecs;
+		const char* format;
+		LogArgument arguments[LOG_MAX_ARGUMENTS];
+		int numArguments;
+		std::string strings;
+	};
+
+	std::unique_ptr<Slot[]> slots;
+	alignas(64) std::atomic<uint64_t> enqueuePosition{0};
+	alignas(64) uint64_t dequeuePosition = 0;
+	alignas(64) std::atomic<uint64_t> numWritten{0};
+	std::atomic<bool> isRunning{true};
+	std::thread writer;
+
+	bool Pop(LogRecord& record, const char*& format)
+	{
+		Slot& slot = slots[dequeuePosition & (LOG_QUEUE_CAPACITY - 1)];
+		if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1)
+		{
+			return false;
+		}
+		record.type = slot.type;
+		record.millisecs = slot.millisecs;
+		record.numArguments = slot.numArguments;
+		for (int i = 0; i < slot.numArguments; i++)
+		{
+			record.arguments[i] = slot.arguments[i];
+		}
+		record.strings = std::move(slot.strings);
+		format = slot.format;
+		slot.sequence.store(dequeuePosition + LOG_QUEUE_CAPACITY, std::memory_order_release);
+		dequeuePosition++;
+		return true;
+	}
+
+	void Write()
+	{
+		LogRecord record;
+		const char* format;
+		while (true)
+		{
+			// Write everything queued, and flush once the queue is empty
+			bool hasWritten = false;
+			while (Pop(record, format))
+			{
+				record.formatId = history.InternFormat(format);
+				const std::string message = FormatMessage(format, record.arguments, record.numArguments, record.strings);
+				const std::string line = std::string(GetLogPrefix(record.type)) + ": [" + Logger::FormatTime(record.millisecs) + "]: " + message;
+				switch (record.type)
+				{
+					case LOG_TRACE:
+						std::cout << "\x1B[90m" << line << "\033[0m" << '\n';
+						break;
+					case LOG_DEBUG:
+						std::cout << "\x1B[36m" << line << "\033[0m" << '\n';
+						break;
+					case LOG_INFO:
+						std::cout << "\x1B[32m" << line << "\033[0m" << '\n';
+						break;
+					case LOG_WARNING:
+						std::cerr << "\x1B[33m" << line << "\033[0m" << '\n';
+						break;
+					case LOG_ERROR:
+						std::cerr << "\x1B[91m" << line << "\033[0m" << '\n';
+						break;
+				}
+				history.Add(std::move(record));
+				record = LogRecord();
+				numWritten.fetch_add(1, std::memory_order_release);
+				hasWritten = true;
+			}
+			if (hasWritten)
+			{
+				std::cout.flush();
+				std::cerr.flush();
+			}
+
+			if (!isRunning.load(std::memory_order_acquire) && numWritten.load() == enqueuePosition.load())
+			{
+				return;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+
+public:
+	LogHistory history;
+
+	static size_t GetSlotsMemoryUsage()
+	{
+		return LOG_QUEUE_CAPACITY * sizeof(Slot);
+	}
+
+	LogQueue(): slots(new Slot[LOG_QUEUE_CAPACITY])
+	{
+		for (uint64_t i = 0; i < LOG_QUEUE_CAPACITY; i++)
+		{
+			slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+		writer = std::thread(&LogQueue::Write, this);
+	}
+
+	~LogQueue()
+	{
+		isRunning.store(false, std::memory_order_release);
+		writer.join();
+	}
+
+	void Push(LogType type, const char* format, const LogArgument* arguments, int numArguments, std::string&& strings)
+	{
+		const int64_t millisecs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+		uint64_t position = enqueuePosition.load(std::memory_order_relaxed);
+		Slot* slot;
+		while (true)
+		{
+			slot = &slots[position & (LOG_QUEUE_CAPACITY - 1)];
+			const int64_t difference = static_cast<int64_t>(slot->sequence.load(std::memory_order_acquire)) - static_cast<int64_t>(position);
+			if (difference == 0)
+			{
+				if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (difference < 0)
+			{
+				// Full, the messages are never dropped so wait for the writer
+				std::this_thread::yield();
+				position = enqueuePosition.load(std::memory_order_relaxed);
+			}
+			else
+			{
+				position = enqueuePosition.load(std::memory_order_relaxed);
+			}
+		}
+
+		slot->type = type;
+		slot->millisecs = millisecs;
+		slot->format = format;
+		for (int i = 0; i < numArguments; i++)
+		{
+			slot->arguments[i] = arguments[i];
+		}
+		slot->numArguments = numArguments;
+		slot->strings = std::move(strings);
+		slot->sequence.store(position + 1, std::memory_order_release);
+	}
+
+	void Flush()
+	{
+		const uint64_t position = enqueuePosition.load();
+		while (numWritten.load(std::memory_order_acquire) < position)
+		{
+			std::this_thread::yield();
+		}
+	}
+};
+
+// Created on the first message, the writer drains the queue when it is destroyed at exit
+static LogQueue& GetLogQueue()
+{
+	static LogQueue logQueue;
+	return logQueue;
+}
+
+// Plain messages are a "{}" format with the message as its argument
+static void PushMessage(LogType type, std::string&& message)
+{
+	LogArgument argument;
+	argument.type = LogArgument::STRING;
+	argument.string.offset = 0;
+	argument.string.length = message.size();
+	GetLogQueue().Push(type, "{}", &argument, 1, std::move(message));
+}
+
+void Logger::Log(std::string message)
+{
+	if (IsEnabled(LOG_INFO))
+	{
+		PushMessage(LOG_INFO, std::move(message));
+	}
+}
+
+void Logger::War(std::string message)
+{
+	if (IsEnabled(LOG_WARNING))
+	{
+		PushMessage(LOG_WARNING, std::move(message));
+	}
+}
+
+void Logger::Err(std::string message)
+{
+	if (IsEnabled(LOG_ERROR))
+	{
+		PushMessage(LOG_ERROR, std::move(message));
+	}
+}
+
+void Logger::Push(LogType type, const char* format, const LogArgument* arguments, int numArguments, std::string&& strings)
+{
+	GetLogQueue().Push(type, format, arguments, numArguments, std::move(strings));
+}
+
+void Logger::AddStringArgument(LogArgument* arguments, int& numArguments, std::string& strings, const char* value, size_t length)
+{
+	arguments[numArguments].type = LogArgument::STRING;
+	arguments[numArguments].string.offset = strings.size();
+	arguments[numArguments].string.length = length;
+	strings.append(value, length);
+	numArguments++;
+}
+
+void Logger::SetLevel(LogType level)
+{
+	logLevel.store(level < LOG_COMPILED_LEVEL ? LOG_COMPILED_LEVEL : level, std::memory_order_relaxed);
+}
+
+bool Logger::IsEnabled(LogType level)
+{
+	return level >= logLevel.load(std::memory_order_relaxed);
+}
+
+void Logger::Flush()
+{
+	GetLogQueue().Flush();
+}
+
+int Logger::GetHistorySize()
+{
+	LogHistory& history = GetLogQueue().history;
+	std::lock_guard<std::mutex> lock(history.mutex);
+	return history.GetSize();
+}
+
+void Logger::VisitHistory(int first, int count, const std::function<void(const LogRecord& record)>& visitor)
+{
+	LogHistory& history = GetLogQueue().history;
+	std::lock_guard<std::mutex> lock(history.mutex);
+	const int last = std::min(first + count, history.GetSize());
+	for (int i = std::max(first, 0); i < last; i++)
+	{
+		visitor(history.GetRecord(i));
+	}
+}
+
+std::string Logger::FormatRecord(const LogRecord& record)
+{
+	return FormatMessage(GetLogQueue().history.GetFormat(record.formatId), record.arguments, record.numArguments, record.strings);
 }
 
-void Logger::War(const std::string& message)
+size_t Logger::GetMemoryUsage()
 {
-	LogEntry logEntry;
-	logEntry.type = LOG_WARNING;
-	logEntry.message = "WAR: [" + CurrentDateTimeToString() + "]: " + message;
-	std::cerr << "\x1B[33m" << logEntry.message << "\033[0m" << std::endl;
-	messages.push_back(logEntry);
+	LogHistory& history = GetLogQueue().history;
+	std::lock_guard<std::mutex> lock(history.mutex);
+	return LogQueue::GetSlotsMemoryUsage() + history.GetMemoryUsage();
 }
 
-void Logger::Err(const std::string& message)
+bool Logger::SetSpillFile(const std::string& filePath)
 {
-	LogEntry logEntry;
-	logEntry.type = LOG_ERROR;
-	logEntry.message = "ERR: [" + CurrentDateTimeToString() + "]: " + message;
-	std::cerr << "\x1B[91m" << logEntry.message << "\033[0m" << std::endl;
-	messages.push_back(logEntry);
+	return GetLogQueue().history.SetSpillFile(filePath);
 }
@@ -3,27 +3,190 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
+#include <type_traits>
+#include <functional>
+
+// Messages waiting for the writer thread, must be a power of two
+const int LOG_QUEUE_CAPACITY = 8192;
+// Arguments a single formatted message can carry
+const int LOG_MAX_ARGUMENTS = 8;
+// Records kept in memory, the older ones go to the spill file if there is one
+const int LOG_HISTORY_CAPACITY = 4096;
 
 enum LogType
 {
+	LOG_TRACE,
+	LOG_DEBUG,
 	LOG_INFO,
 	LOG_WARNING,
 	LOG_ERROR
 };
 
-struct LogEntry
+// Lowest level compiled in, the macros below the level compile to nothing. Trace and debug
+// messages are removed from release builds (NDEBUG).
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO 2
+#ifndef LOG_COMPILED_LEVEL
+#ifdef NDEBUG
+#define LOG_COMPILED_LEVEL LOG_LEVEL_INFO
+#else
+#define LOG_COMPILED_LEVEL LOG_LEVEL_TRACE
+#endif
+#endif
+
+// A formatting argument, strings are copied into the message buffer of the queue slot
+struct LogArgument
+{
+	enum Type
+	{
+		SIGNED,
+		UNSIGNED,
+		FLOATING,
+		STRING
+	};
+	Type type;
+	union
+	{
+		int64_t signedValue;
+		uint64_t unsignedValue;
+		double floatingValue;
+		struct
+		{
+			uint32_t offset;
+			uint32_t length;
+		} string;
+	};
+};
+
+// A message as it is kept in the history, formatted only when it is displayed
+struct LogRecord
 {
-	LogType type;
-	std::string message;
+	LogType type = LOG_INFO;
+	int64_t millisecs = 0;
+	uint32_t formatId = 0;
+	int numArguments = 0;
+	LogArgument arguments[LOG_MAX_ARGUMENTS];
+	std::string strings;
 };
 
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Logger
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Log, War and Err only move the message into a lock-free queue, a background thread adds
+// the timestamp and writes it out. That thread also keeps the last LOG_HISTORY_CAPACITY
+// records in a ring, read in place by VisitHistory (e.g. the debug console).
+//
+// The LOGGER_* macros take a format string literal with {} placeholders and its arguments:
+//   LOGGER_DEBUG("Component id = {} was added to entity id {}", componentId, entityId);
+// The arguments are only evaluated when the level is enabled, and they are formatted by
+// the writer thread. Write {{ and }} for literal braces.
+/////////////////////////////////////////////////////////////////////////////////////////////
 class Logger
 {
+private:
+	static void Push(LogType type, const char* format, const LogArgument* arguments, int numArguments, std::string&& strings);
+
+	template <typename T>
+	static void AddArgument(LogArgument* arguments, int& numArguments, std::string& strings, const T& value);
+	static void AddStringArgument(LogArgument* arguments, int& numArguments, std::string& strings, const char* value, size_t length);
+
 public:
-	static std::vector<LogEntry> messages;
-	static void Log(const std::string& message);
-	static void War(const std::string& message);
-	static void Err(const std::string& message);
+	static void Log(std::string message);
+	static void War(std::string message);
+	static void Err(std::string message);
+
+	// Messages below the level are skipped at runtime
+	static void SetLevel(LogType level);
+	static bool IsEnabled(LogType level);
+
+	// Used by the LOGGER_* macros, format must be a string literal (it is read later)
+	template <typename ...TArgs>
+	static void Write(LogType type, const char* format, const TArgs& ...args);
+
+	// Blocks until everything logged so far is written
+	static void Flush();
+
+	// Calls visitor on count records from first, the oldest is 0. The history is locked
+	// meanwhile, so the records are not copied and FormatRecord can be used on them.
+	static int GetHistorySize();
+	static void VisitHistory(int first, int count, const std::function<void(const LogRecord& record)>& visitor);
+	static std::string FormatRecord(const LogRecord& record);
+	static std::string FormatTime(int64_t millisecs);
+
+	// Records pushed out of the history are appended to the file, an empty path stops it
+	static bool SetSpillFile(const std::string& filePath);
+
+	// Bytes held by the queue and the history, for the memory budgets
+	static size_t GetMemoryUsage();
 };
 
-#endif
\ No newline at end of file
+#define LOGGER_WRITE(type, ...) do { if (Logger::IsEnabled(type)) { Logger::Write(type, __VA_ARGS__); } } while (0)
+
+#if LOG_COMPILED_LEVEL <= LOG_LEVEL_TRACE
+#define LOGGER_TRACE(...) LOGGER_WRITE(LOG_TRACE, __VA_ARGS__)
+#else
+#define LOGGER_TRACE(...) do {} while (0)
+#endif
+
+#if LOG_COMPILED_LEVEL <= LOG_LEVEL_DEBUG
+#define LOGGER_DEBUG(...) LOGGER_WRITE(LOG_DEBUG, __VA_ARGS__)
+#else
+#define LOGGER_DEBUG(...) do {} while (0)
+#endif
+
+#define LOGGER_INFO(...) LOGGER_WRITE(LOG_INFO, __VA_ARGS__)
+#define LOGGER_WARNING(...) LOGGER_WRITE(LOG_WARNING, __VA_ARGS__)
+#define LOGGER_ERROR(...) LOGGER_WRITE(LOG_ERROR, __VA_ARGS__)
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Logger templates
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+void Logger::AddArgument(LogArgument* arguments, int& numArguments, std::string& strings, const T& value)
+{
+	if (numArguments == LOG_MAX_ARGUMENTS)
+	{
+		return;
+	}
+	if constexpr (std::is_same<T, std::string>::value)
+	{
+		AddStringArgument(arguments, numArguments, strings, value.data(), value.size());
+	}
+	else if constexpr (std::is_convertible<T, const char*>::value)
+	{
+		const char* string = value;
+		AddStringArgument(arguments, numArguments, strings, string, std::char_traits<char>::length(string));
+	}
+	else if constexpr (std::is_floating_point<T>::value)
+	{
+		arguments[numArguments].type = LogArgument::FLOATING;
+		arguments[numArguments++].floatingValue = value;
+	}
+	else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value)
+	{
+		arguments[numArguments].type = LogArgument::SIGNED;
+		arguments[numArguments++].signedValue = value;
+	}
+	else
+	{
+		static_assert(std::is_integral<T>::value || std::is_enum<T>::value, "Logger arguments are numbers or strings");
+		arguments[numArguments].type = LogArgument::UNSIGNED;
+		arguments[numArguments++].unsignedValue = static_cast<uint64_t>(value);
+	}
+}
+
+template <typename ...TArgs>
+void Logger::Write(LogType type, const char* format, const TArgs& ...args)
+{
+	static_assert(sizeof...(TArgs) <= LOG_MAX_ARGUMENTS, "Too many arguments for a log message");
+	LogArgument arguments[LOG_MAX_ARGUMENTS > 0 ? LOG_MAX_ARGUMENTS : 1];
+	int numArguments = 0;
+	std::string strings;
+	(AddArgument(arguments, numArguments, strings, args), ...);
+	Push(type, format, arguments, numArguments, std::move(strings));
+}
+
+#endif
@@ -1,12 +1,314 @@
 #include "./Game/Game.h"
+#include "./Game/EngineConfig.h"
+#include <cstdlib>
+#include <cstring>
 
 int main(int argc, char* argv[])
 {
-    Game game;
+    // --headless runs the simulation without a window, as fast as it can,
+    // --realtime keeps it at the wall clock pace, --ticks N stops it after N ticks and
+    // --timescale S runs the game S times faster.
+    // --scenario NAME runs a stress scenario headless for SCENARIO_DEFAULT_TICKS, unless
+    // --ticks or --windowed is given, --size and --seed change the scenario load.
+    // --report FILE writes the tick times of a scenario or a replay to FILE, and the time of
+    // every profiler scope per frame in a build with the profiler, for tools/PerfGate.cpp.
+    // --budget TAG=MB warns when the memory of a subsystem (ecs, textures, scripts, events,
+    // logger) goes over MB megabytes, it can be given once per subsystem.
+    // --record FILE records the input of the session, --replay FILE plays it back headless,
+    // unless --windowed is given, and reports the tick times. --randomseed N seeds the game.
+    // --server PORT runs headless at the wall clock pace, unless --windowed is given, as the
+    // server of the clients started with --connect HOST[:PORT].
+    // --timedinput gives each tick the keys pressed during its own slice of the frame.
+    // --deterministic orders what the parallel systems do the same whatever the threads and
+    // checksums each tick of a recording, its replay reports the ticks that differ.
+    // --renderer NAME renders with the opengl, opengles, direct3d, metal or software backend.
+    // --present MODE presents with vsync, adaptive vsync or uncapped, --fps N caps the frame
+    // rate at N, 0 leaves it to the vsync.
+    // --nopipeline submits each frame as soon as it is recorded, instead of while the next
+    // one is simulated, a frame less of latency for less of a frame rate.
+    // --renderheight H draws the frames at H lines and stretches them over a taller window,
+    // 0 at the window's, --dynamicres lowers the resolution while the frames are too slow.
+    // --splitscreen splits the window between two viewports, each following its own entity,
+    // --zoom Z starts the cameras zoomed Z times in.
+    // --capture N writes every Nth frame presented as capture-NNNNNN.png, F12 takes a
+    // screenshot whatever it is.
+    // --allocbudget N fails the run when a frame makes more than N allocations once the level
+    // is warmed up, 0 for none at all, in a build made with ALLOCATIONS=1.
+    // --airate HZ makes each enemy think HZ times per second, 0 every tick.
+    // --tapevents copies the last collision and animation events into a ring tools replay.
+    // --config FILE reads the engine config from FILE instead of ./config.lua, the flags
+    // above override what it sets.
+    std::string configFilePath = ENGINE_CONFIG_FILE;
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--config") == 0)
+        {
+            configFilePath = argv[i + 1];
+        }
+    }
+    EngineConfig config;
+    if (!EngineConfig::Load(configFilePath, config) && configFilePath != ENGINE_CONFIG_FILE)
+    {
+        Logger::Err("Unable to read the engine config " + configFilePath);
+    }
+    Logger::SetLevel(config.logLevel);
+    if (!config.flightRecorderFile.empty())
+    {
+        FlightRecorder::Install(config.flightRecorderFile);
+    }
+
+    bool isHeadless = false;
+    bool isRealtime = false;
+    uint32_t maxSimulationTicks = 0;
+    double timeScale = 1.0;
+    std::string scenarioName;
+    std::string reportFilePath;
+    int scenarioSize = 0;
+    uint32_t scenarioSeed = SCENARIO_DEFAULT_SEED;
+    bool isWindowed = false;
+    std::string recordFilePath;
+    std::string replayFilePath;
+    uint32_t randomSeed = DEFAULT_RANDOM_SEED;
+    bool isInputTimestamped = false;
+    RenderBackendType renderBackendType = config.renderBackendType;
+    PresentMode presentMode = config.presentMode;
+    int targetFps = config.targetFps;
+    int renderHeight = config.renderHeight;
+    bool isDynamicResolution = config.isDynamicResolution;
+    bool isFramePipelined = config.isFramePipelined;
+    bool isDeterministic = config.isDeterministic;
+    bool isSplitScreen = false;
+    float cameraZoom = 1.0f;
+    float aiThinkRate = AI_DEFAULT_THINK_RATE;
+    bool isEventTapped = false;
+    int captureInterval = 0;
+    int allocationBudget = -1;
+    int serverPort = 0;
+    std::string serverHostName;
+    uint16_t serverHostPort = NETWORK_DEFAULT_PORT;
+    std::vector<std::pair<MemoryTag, size_t>> memoryBudgets;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--config") == 0 && i + 1 < argc)
+        {
+            i++;
+        }
+        else if (std::strcmp(argv[i], "--headless") == 0)
+        {
+            isHeadless = true;
+        }
+        else if (std::strcmp(argv[i], "--realtime") == 0)
+        {
+            isRealtime = true;
+        }
+        else if (std::strcmp(argv[i], "--ticks") == 0 && i + 1 < argc)
+        {
+            maxSimulationTicks = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--timescale") == 0 && i + 1 < argc)
+        {
+            timeScale = std::strtod(argv[++i], nullptr);
+        }
+        else if (std::strcmp(argv[i], "--scenario") == 0 && i + 1 < argc)
+        {
+            scenarioName = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--report") == 0 && i + 1 < argc)
+        {
+            reportFilePath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+        {
+            scenarioSize = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            scenarioSeed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--windowed") == 0)
+        {
+            isWindowed = true;
+        }
+        else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+        {
+            recordFilePath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+        {
+            replayFilePath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--randomseed") == 0 && i + 1 < argc)
+        {
+            randomSeed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--timedinput") == 0)
+        {
+            isInputTimestamped = true;
+        }
+        else if (std::strcmp(argv[i], "--renderer") == 0 && i + 1 < argc)
+        {
+            if (!RenderBackend::FindType(argv[++i], renderBackendType))
+            {
+                Logger::Err(std::string("Unknown renderer ") + argv[i]);
+            }
+        }
+        else if (std::strcmp(argv[i], "--present") == 0 && i + 1 < argc)
+        {
+            if (!FramePacer::FindPresentMode(argv[++i], presentMode))
+            {
+                Logger::Err(std::string("Unknown present mode ") + argv[i]);
+            }
+        }
+        else if (std::strcmp(argv[i], "--fps") == 0 && i + 1 < argc)
+        {
+            targetFps = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--deterministic") == 0)
+        {
+            isDeterministic = true;
+        }
+        else if (std::strcmp(argv[i], "--nopipeline") == 0)
+        {
+            isFramePipelined = false;
+        }
+        else if (std::strcmp(argv[i], "--renderheight") == 0 && i + 1 < argc)
+        {
+            renderHeight = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--dynamicres") == 0)
+        {
+            isDynamicResolution = true;
+        }
+        else if (std::strcmp(argv[i], "--splitscreen") == 0)
+        {
+            isSplitScreen = true;
+        }
+        else if (std::strcmp(argv[i], "--zoom") == 0 && i + 1 < argc)
+        {
+            cameraZoom = std::strtof(argv[++i], nullptr);
+        }
+        else if (std::strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+        {
+            captureInterval = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--allocbudget") == 0 && i + 1 < argc)
+        {
+            allocationBudget = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--airate") == 0 && i + 1 < argc)
+        {
+            aiThinkRate = std::strtof(argv[++i], nullptr);
+        }
+        else if (std::strcmp(argv[i], "--tapevents") == 0)
+        {
+            isEventTapped = true;
+        }
+        else if (std::strcmp(argv[i], "--server") == 0 && i + 1 < argc)
+        {
+            serverPort = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--connect") == 0 && i + 1 < argc)
+        {
+            serverHostName = argv[++i];
+            const size_t separator = serverHostName.find(':');
+            if (separator != std::string::npos)
+            {
+                serverHostPort = std::atoi(serverHostName.c_str() + separator + 1);
+                serverHostName.resize(separator);
+            }
+        }
+        else if (std::strcmp(argv[i], "--budget") == 0 && i + 1 < argc)
+        {
+            const std::string budget = argv[++i];
+            const size_t separator = budget.find('=');
+            MemoryTag tag;
+            if (separator == std::string::npos || !MemoryTracker::FindTag(budget.substr(0, separator), tag))
+            {
+                Logger::Err("Unknown memory budget " + budget);
+                continue;
+            }
+            memoryBudgets.push_back({tag, static_cast<size_t>(std::strtod(budget.c_str() + separator + 1, nullptr) * 1024 * 1024)});
+        }
+    }
+    if (!replayFilePath.empty())
+    {
+        isHeadless = !isWindowed;
+    }
+    // A dedicated server keeps the pace of its clients
+    if (serverPort > 0)
+    {
+        isHeadless = !isWindowed;
+        isRealtime = true;
+    }
+    if (!scenarioName.empty())
+    {
+        isHeadless = !isWindowed;
+        if (maxSimulationTicks == 0 && isHeadless)
+        {
+            maxSimulationTicks = SCENARIO_DEFAULT_TICKS;
+        }
+    }
+
+    Game game(isHeadless, config.numWorkers, config.isWorkerPinned);
+    game.SetSimulationTickRate(config.tickRate);
+    game.SetBroadphaseCellSize(config.broadphaseCellSize);
+    game.SetAutoTuneBroadphase(config.isBroadphaseAutoTuned);
+    game.SetSpatialSortInterval(config.spatialSortSeconds);
+    game.SetPoolReserve(config.poolReserve);
+    game.SetTextureStreamBudget(config.textureStreamBudget);
+    game.SetWindowMode(config.isFullscreen, config.windowWidth, config.windowHeight);
+    if (isRealtime)
+    {
+        game.SetClock(std::make_unique<SystemClock>());
+    }
+    game.SetMaxSimulationTicks(maxSimulationTicks);
+    game.SetTimeScale(timeScale);
+    game.SetTimestampedInput(isInputTimestamped);
+    game.SetRenderBackend(renderBackendType);
+    game.SetFramePacing(presentMode, targetFps);
+    game.SetFramePipelining(isFramePipelined);
+    game.SetRenderResolution(renderHeight, isDynamicResolution);
+    game.SetTilemapDirect(config.isTilemapDirect);
+    game.SetFrameCapture(captureInterval);
+    game.SetAllocationBudget(allocationBudget);
+    game.SetSplitScreen(isSplitScreen);
+    game.SetCameraZoom(cameraZoom);
+    game.SetAIThinkRate(aiThinkRate);
+    game.SetEventTap(isEventTapped ? EVENT_TAP_DEFAULT_CAPACITY : 0);
+    for (const auto& memoryBudget: memoryBudgets)
+    {
+        game.SetMemoryBudget(memoryBudget.first, memoryBudget.second);
+    }
+    if (!scenarioName.empty())
+    {
+        game.SetScenario(scenarioName, scenarioSize, scenarioSeed);
+    }
+    game.SetScenarioReportFile(reportFilePath);
+    game.SetRandomSeed(randomSeed);
+    game.SetDeterministic(isDeterministic);
+    if (!recordFilePath.empty())
+    {
+        game.RecordInput(recordFilePath);
+    }
+    // The recording brings its own seed, tick rate and scenario
+    if (!replayFilePath.empty() && !game.ReplayInput(replayFilePath))
+    {
+        return 1;
+    }
+
+    if (serverPort > 0 && !game.HostServer(serverPort))
+    {
+        return 1;
+    }
+    if (!serverHostName.empty() && !game.JoinServer(serverHostName, serverHostPort))
+    {
+        return 1;
+    }
 
     game.Initialize();
     game.Run();
+    const bool isFailed = game.HasFailed();
     game.Destroy();
 
-    return 0;
+    return isFailed ? 1 : 0;
 }
@@ -0,0 +1,98 @@
+#include "AllocationTracker.h"
+#include <cstdlib>
+#include <new>
+
+std::atomic<uint64_t> AllocationTracker::numFrameAllocations{0};
+std::atomic<uint64_t> AllocationTracker::numFrameBytes{0};
+
+// Constant initialized, operator new may run before any constructor
+static thread_local AllocationCounts threadCounts;
+
+void AllocationTracker::AddAllocation(size_t numBytes)
+{
+    numFrameAllocations.fetch_add(1, std::memory_order_relaxed);
+    numFrameBytes.fetch_add(numBytes, std::memory_order_relaxed);
+    threadCounts.numAllocations++;
+    threadCounts.numBytes += numBytes;
+}
+
+AllocationCounts AllocationTracker::GetThreadCounts()
+{
+    return threadCounts;
+}
+
+AllocationCounts AllocationTracker::EndFrame()
+{
+    AllocationCounts counts;
+    counts.numAllocations = numFrameAllocations.exchange(0, std::memory_order_relaxed);
+    counts.numBytes = numFrameBytes.exchange(0, std::memory_order_relaxed);
+    return counts;
+}
+
+#ifdef ENABLE_ALLOCATION_TRACKER
+// Every other form of new and delete comes down to these
+static void* Allocate(size_t numBytes)
+{
+    AllocationTracker::AddAllocation(numBytes);
+    return std::malloc(numBytes > 0 ? numBytes : 1);
+}
+
+static void* AllocateAligned(size_t numBytes, std::align_val_t alignment)
+{
+    AllocationTracker::AddAllocation(numBytes);
+    const size_t alignmentBytes = static_cast<size_t>(alignment);
+    // aligned_alloc takes a multiple of the alignment
+    return std::aligned_alloc(alignmentBytes, (numBytes + alignmentBytes - 1) / alignmentBytes * alignmentBytes);
+}
+
+void* operator new(size_t numBytes)
+{
+    void* pointer = Allocate(numBytes);
+    if (!pointer)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new[](size_t numBytes)
+{
+    return operator new(numBytes);
+}
+
+void* operator new(size_t numBytes, const std::nothrow_t&) noexcept
+{
+    return Allocate(numBytes);
+}
+
+void* operator new[](size_t numBytes, const std::nothrow_t&) noexcept
+{
+    return Allocate(numBytes);
+}
+
+void* operator new(size_t numBytes, std::align_val_t alignment)
+{
+    void* pointer = AllocateAligned(numBytes, alignment);
+    if (!pointer)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new[](size_t numBytes, std::align_val_t alignment)
+{
+    return operator new(numBytes, alignment);
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept { std::free(pointer); }
+#endif
@@ -0,0 +1,54 @@
+#ifndef ALLOCATIONTRACKER_H
+#define ALLOCATIONTRACKER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Frames after a level is loaded before its allocations are checked against the budget, the
+// pools and the buffers grow to their size meanwhile
+const int ALLOCATION_WARMUP_FRAMES = 120;
+// Frames over the budget logged with the scopes that allocated, the ones after are counted
+const int ALLOCATION_REPORTED_FRAMES = 5;
+
+struct AllocationCounts
+{
+    uint64_t numAllocations = 0;
+    uint64_t numBytes = 0;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Allocation tracker
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Counts the heap allocations made with operator new, per frame and per thread. Only a
+// build with -DENABLE_ALLOCATION_TRACKER (make ALLOCATIONS=1) replaces the global operator
+// new and delete to count them, the counts stay at 0 in the others. The counts of a thread
+// only grow, so what a profiler scope allocated is the difference between its two ends.
+// The memory freed isn't counted, it is the allocations on the hot paths that are after,
+// the memory held is the memory tracker's.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class AllocationTracker
+{
+private:
+    static std::atomic<uint64_t> numFrameAllocations;
+    static std::atomic<uint64_t> numFrameBytes;
+
+public:
+    // From operator new, on any thread
+    static void AddAllocation(size_t numBytes);
+    // Of the calling thread since it started
+    static AllocationCounts GetThreadCounts();
+    // Of the frame since the last call, once a frame on the main thread
+    static AllocationCounts EndFrame();
+
+    static constexpr bool IsEnabled()
+    {
+#ifdef ENABLE_ALLOCATION_TRACKER
+        return true;
+#else
+        return false;
+#endif
+    }
+};
+
+#endif
@@ -0,0 +1,82 @@
+#include "BlockAllocator.h"
+#include <new>
+
+std::array<BlockAllocator::SizeClass, BLOCK_ALLOCATOR_NUM_SIZE_CLASSES>& BlockAllocator::GetSizeClasses()
+{
+    static auto* sizeClasses = new std::array<SizeClass, BLOCK_ALLOCATOR_NUM_SIZE_CLASSES>();
+    return *sizeClasses;
+}
+
+int BlockAllocator::GetSizeClass(size_t size)
+{
+    int sizeClass = 0;
+    while (sizeClass < BLOCK_ALLOCATOR_NUM_SIZE_CLASSES && GetBlockSize(sizeClass) < size)
+    {
+        sizeClass++;
+    }
+    return sizeClass < BLOCK_ALLOCATOR_NUM_SIZE_CLASSES ? sizeClass : -1;
+}
+
+void* BlockAllocator::Allocate(size_t size)
+{
+    const int sizeClass = GetSizeClass(size);
+    if (sizeClass == -1)
+    {
+        return ::operator new(size);
+    }
+    SizeClass& pool = GetSizeClasses()[sizeClass];
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    if (!pool.freeList)
+    {
+        // Carve a new page into blocks of this class, the blocks keep the 16 byte alignment of new
+        char* page = new char[BLOCK_ALLOCATOR_PAGE_SIZE];
+        pool.pages.emplace_back(page);
+        const size_t blockSize = GetBlockSize(sizeClass);
+        for (size_t offset = BLOCK_ALLOCATOR_PAGE_SIZE; offset >= blockSize; offset -= blockSize)
+        {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(page + offset - blockSize);
+            block->next = pool.freeList;
+            pool.freeList = block;
+        }
+    }
+    FreeBlock* block = pool.freeList;
+    pool.freeList = block->next;
+    pool.numBlocksInUse++;
+    if (pool.numBlocksInUse > pool.peakNumBlocksInUse)
+    {
+        pool.peakNumBlocksInUse = pool.numBlocksInUse;
+    }
+    return block;
+}
+
+void BlockAllocator::Free(void* block, size_t size)
+{
+    if (!block)
+    {
+        return;
+    }
+    const int sizeClass = GetSizeClass(size);
+    if (sizeClass == -1)
+    {
+        ::operator delete(block);
+        return;
+    }
+    SizeClass& pool = GetSizeClasses()[sizeClass];
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    FreeBlock* freeBlock = static_cast<FreeBlock*>(block);
+    freeBlock->next = pool.freeList;
+    pool.freeList = freeBlock;
+    pool.numBlocksInUse--;
+}
+
+void BlockAllocator::GetStats(std::vector<BlockAllocatorStats>& stats)
+{
+    stats.clear();
+    auto& sizeClasses = GetSizeClasses();
+    for (int sizeClass = 0; sizeClass < BLOCK_ALLOCATOR_NUM_SIZE_CLASSES; sizeClass++)
+    {
+        SizeClass& pool = sizeClasses[sizeClass];
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        stats.push_back({GetBlockSize(sizeClass), pool.numBlocksInUse, pool.peakNumBlocksInUse, static_cast<int>(pool.pages.size())});
+    }
+}
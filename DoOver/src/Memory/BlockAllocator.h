@@ -0,0 +1,96 @@
+#ifndef BLOCKALLOCATOR_H
+#define BLOCKALLOCATOR_H
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Blocks of 16 to 2048 bytes come from the pools, larger ones from new
+const int BLOCK_ALLOCATOR_NUM_SIZE_CLASSES = 8;
+const size_t BLOCK_ALLOCATOR_MIN_BLOCK_SIZE = 16;
+const size_t BLOCK_ALLOCATOR_PAGE_SIZE = 64 * 1024;
+
+struct BlockAllocatorStats
+{
+    size_t blockSize;
+    int numBlocksInUse;
+    int peakNumBlocksInUse;
+    int numPages;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Block allocator
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Engine-wide size-class pools, like the script allocator's, for the small objects the
+// engine keeps around: the component pools, the systems and queries, and the nodes of the
+// registry maps. They are served from free lists carved out of 64 KB pages, so they sit
+// next to each other instead of being scattered over the heap. The pages are never given
+// back. Thread safe, each size class has its own lock.
+// PoolAllocator<T> plugs it into the standard containers and std::allocate_shared.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class BlockAllocator
+{
+private:
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    struct SizeClass
+    {
+        std::mutex mutex;
+        FreeBlock* freeList = nullptr;
+        std::vector<std::unique_ptr<char[]>> pages;
+        int numBlocksInUse = 0;
+        int peakNumBlocksInUse = 0;
+    };
+
+    // Never destroyed, the objects of static lifetime may free their blocks at exit
+    static std::array<SizeClass, BLOCK_ALLOCATOR_NUM_SIZE_CLASSES>& GetSizeClasses();
+
+    // -1 for the sizes served by new
+    static int GetSizeClass(size_t size);
+    static size_t GetBlockSize(int sizeClass) { return BLOCK_ALLOCATOR_MIN_BLOCK_SIZE << sizeClass; }
+
+public:
+    static void* Allocate(size_t size);
+    // size is the one given to Allocate
+    static void Free(void* block, size_t size);
+
+    // One entry per size class, for the performance overlay
+    static void GetStats(std::vector<BlockAllocatorStats>& stats);
+};
+
+template <typename T>
+class PoolAllocator
+{
+public:
+    typedef T value_type;
+
+    PoolAllocator() = default;
+    template <typename U> PoolAllocator(const PoolAllocator<U>&) {}
+
+    T* allocate(size_t n)
+    {
+        static_assert(alignof(T) <= BLOCK_ALLOCATOR_MIN_BLOCK_SIZE, "The blocks are only aligned to 16 bytes");
+        return static_cast<T*>(BlockAllocator::Allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, size_t n)
+    {
+        BlockAllocator::Free(pointer, n * sizeof(T));
+    }
+
+    template <typename U> bool operator==(const PoolAllocator<U>&) const { return true; }
+    template <typename U> bool operator!=(const PoolAllocator<U>&) const { return false; }
+};
+
+// An unordered_map with its nodes (and small bucket arrays) in the block allocator
+template <typename TKey, typename TValue, typename THash = std::hash<TKey>>
+using PoolUnorderedMap = std::unordered_map<TKey, TValue, THash, std::equal_to<TKey>, PoolAllocator<std::pair<const TKey, TValue>>>;
+
+#endif
@@ -0,0 +1,63 @@
+#include "FrameArena.h"
+#include "../Logger/Logger.h"
+#include <cstdint>
+#include <string>
+
+FrameArena::FrameArena(size_t capacity): block(new std::byte[capacity]), capacity(capacity), offset(0)
+{
+    Logger::Log("FrameArena constructor called!");
+}
+
+FrameArena::~FrameArena()
+{
+    Logger::Log("FrameArena destructor called!");
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment)
+{
+    const uintptr_t base = reinterpret_cast<uintptr_t>(block.get());
+    size_t current = offset.load(std::memory_order_relaxed);
+    while (true)
+    {
+        const size_t begin = ((base + current + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1)) - base;
+        const size_t end = begin + bytes;
+        if (end > capacity)
+        {
+            break;
+        }
+        // Another thread moved the offset first, the allocation is aligned again from there
+        if (offset.compare_exchange_weak(current, end, std::memory_order_relaxed))
+        {
+            return block.get() + begin;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(overflowMutex);
+    numOverflowBytes += bytes + alignment;
+    return overflow.allocate(bytes, alignment);
+}
+
+size_t FrameArena::GetNumUsedBytes() const
+{
+    const size_t used = offset.load(std::memory_order_relaxed);
+    return used < capacity ? used : capacity;
+}
+
+void FrameArena::Reset()
+{
+    const size_t usedBytes = GetNumUsedBytes() + numOverflowBytes;
+    if (usedBytes > peakUsedBytes)
+    {
+        peakUsedBytes = usedBytes;
+    }
+    if (numOverflowBytes > 0)
+    {
+        // The next frames like this one fit in the block, with some room for more
+        overflow.release();
+        numOverflowBytes = 0;
+        capacity = usedBytes + usedBytes / 2;
+        block.reset(new std::byte[capacity]);
+        Logger::War("Frame arena grown to " + std::to_string(capacity) + " bytes");
+    }
+    offset.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,56 @@
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+
+// The arena starts with a megabyte, it grows at a reset to what the busiest frame needed
+const size_t FRAME_ARENA_DEFAULT_CAPACITY = 1 << 20;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Frame arena
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Memory for the temporaries of a frame, e.g. the scratch containers of the systems, given
+// out by moving an offset forward in one block and taken back all at once when the frame
+// ends. It is a std::pmr::memory_resource, so a std::pmr::vector or std::pmr::string made
+// with it allocates nothing from the heap, and freeing one does nothing.
+// Systems running in parallel allocate from it at the same time. What doesn't fit in the
+// block comes from the heap until the next reset, which makes the block large enough.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class FrameArena: public std::pmr::memory_resource
+{
+private:
+    std::unique_ptr<std::byte[]> block;
+    size_t capacity;
+    std::atomic<size_t> offset;
+
+    // The allocations past the end of the block
+    std::mutex overflowMutex;
+    std::pmr::monotonic_buffer_resource overflow;
+    size_t numOverflowBytes = 0;
+
+    size_t peakUsedBytes = 0;
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+public:
+    explicit FrameArena(size_t capacity = FRAME_ARENA_DEFAULT_CAPACITY);
+    ~FrameArena();
+
+    // Takes back everything given out since the last reset, nothing allocated from the arena
+    // may still be in use
+    void Reset();
+
+    size_t GetCapacity() const { return capacity; }
+    size_t GetNumUsedBytes() const;
+    // The most a frame used so far
+    size_t GetPeakUsedBytes() const { return peakUsedBytes; }
+};
+
+#endif
@@ -0,0 +1,130 @@
+#include "MappedFile.h"
+#include <cstdio>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <process.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const std::string& filePath)
+{
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    fileHandle = file;
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(file, &fileSize);
+    HANDLE mapping = fileSize.QuadPart > 0 ? CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+    if (!mapping)
+    {
+        Close();
+        return false;
+    }
+    mappingHandle = mapping;
+    size = static_cast<size_t>(fileSize.QuadPart);
+    data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+    fileDescriptor = open(filePath.c_str(), O_RDONLY);
+    if (fileDescriptor < 0)
+    {
+        return false;
+    }
+    struct stat fileStat;
+    fstat(fileDescriptor, &fileStat);
+    size = static_cast<size_t>(fileStat.st_size);
+    // Shared, the pages are the ones of the file cache whichever process maps them
+    void* mapped = size > 0 ? mmap(NULL, size, PROT_READ, MAP_SHARED, fileDescriptor, 0) : MAP_FAILED;
+    data = mapped != MAP_FAILED ? static_cast<const uint8_t*>(mapped) : nullptr;
+#endif
+
+    if (!data)
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+    if (data)
+    {
+        UnmapViewOfFile(data);
+    }
+    if (mappingHandle)
+    {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle)
+    {
+        CloseHandle(fileHandle);
+    }
+#else
+    if (data)
+    {
+        munmap(const_cast<uint8_t*>(data), size);
+    }
+    if (fileDescriptor >= 0)
+    {
+        close(fileDescriptor);
+    }
+#endif
+
+    data = nullptr;
+    size = 0;
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+    fileDescriptor = -1;
+}
+
+bool MappedFile::WriteFile(const std::string& filePath, const void* data, size_t size)
+{
+    // Each process has its own, two instances baking the same file don't write into each other
+#ifdef _WIN32
+    const std::string tempFilePath = filePath + "." + std::to_string(_getpid()) + ".tmp";
+#else
+    const std::string tempFilePath = filePath + "." + std::to_string(getpid()) + ".tmp";
+#endif
+    std::FILE* file = std::fopen(tempFilePath.c_str(), "wb");
+    if (!file)
+    {
+        return false;
+    }
+    const bool isWritten = std::fwrite(data, 1, size, file) == size;
+    std::fclose(file);
+    if (!isWritten)
+    {
+        std::remove(tempFilePath.c_str());
+        return false;
+    }
+    if (std::rename(tempFilePath.c_str(), filePath.c_str()) == 0)
+    {
+        return true;
+    }
+    // Windows doesn't rename over an existing file
+    std::remove(filePath.c_str());
+    if (std::rename(tempFilePath.c_str(), filePath.c_str()) == 0)
+    {
+        return true;
+    }
+    std::remove(tempFilePath.c_str());
+    return false;
+}
@@ -0,0 +1,47 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Mapped file
+/////////////////////////////////////////////////////////////////////////////////////////////
+// A whole file mapped read-only and shared. Every process mapping the same file reads the
+// same pages of the system's file cache, so the game instances of a server box hold one
+// copy of the asset pack and the baked level data between them instead of one each. The
+// pages are only read in as they are touched, and nothing is ever written through them.
+// WriteFile replaces a file so that a process mapping it meanwhile never sees it half
+// written.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class MappedFile
+{
+private:
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+    int fileDescriptor = -1;
+
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Returns false when the file is missing or empty, nothing is logged
+    bool Open(const std::string& filePath);
+    void Close();
+    bool IsOpen() const { return data != nullptr; }
+
+    // Page aligned
+    const uint8_t* GetData() const { return data; }
+    size_t GetSize() const { return size; }
+
+    // Written beside the file under a name of this process, then renamed over it
+    static bool WriteFile(const std::string& filePath, const void* data, size_t size);
+};
+
+#endif
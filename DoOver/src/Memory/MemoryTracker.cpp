@@ -0,0 +1,67 @@
+#include "MemoryTracker.h"
+#include "../Logger/Logger.h"
+
+void MemoryTracker::SetNumBytes(MemoryTag tag, size_t numBytes)
+{
+    MemoryTagStats& stats = tags[tag];
+    stats.numBytes = numBytes;
+    if (numBytes > stats.peakNumBytes)
+    {
+        stats.peakNumBytes = numBytes;
+    }
+    const bool isOverBudget = stats.budgetBytes > 0 && numBytes > stats.budgetBytes;
+    if (isOverBudget && !stats.isOverBudget)
+    {
+        LOGGER_WARNING("{} memory is over budget: {} KB of {} KB", GetTagName(tag), numBytes / 1024, stats.budgetBytes / 1024);
+    }
+    stats.isOverBudget = isOverBudget;
+}
+
+void MemoryTracker::SetBudget(MemoryTag tag, size_t budgetBytes)
+{
+    tags[tag].budgetBytes = budgetBytes;
+    tags[tag].isOverBudget = false;
+}
+
+void MemoryTracker::LogReport() const
+{
+    for (int tag = 0; tag < NUM_MEMORY_TAGS; tag++)
+    {
+        const MemoryTagStats& stats = tags[tag];
+        if (stats.budgetBytes > 0)
+        {
+            LOGGER_INFO("Memory {}: {} KB, peak {} KB, budget {} KB", GetTagName(static_cast<MemoryTag>(tag)), stats.numBytes / 1024,
+                stats.peakNumBytes / 1024, stats.budgetBytes / 1024);
+        }
+        else
+        {
+            LOGGER_INFO("Memory {}: {} KB, peak {} KB", GetTagName(static_cast<MemoryTag>(tag)), stats.numBytes / 1024, stats.peakNumBytes / 1024);
+        }
+    }
+}
+
+const char* MemoryTracker::GetTagName(MemoryTag tag)
+{
+    switch (tag)
+    {
+        case MEMORY_TAG_ECS: return "ecs";
+        case MEMORY_TAG_TEXTURES: return "textures";
+        case MEMORY_TAG_SCRIPTS: return "scripts";
+        case MEMORY_TAG_EVENTS: return "events";
+        case MEMORY_TAG_LOGGER: return "logger";
+        default: return "unknown";
+    }
+}
+
+bool MemoryTracker::FindTag(const std::string& name, MemoryTag& tag)
+{
+    for (int i = 0; i < NUM_MEMORY_TAGS; i++)
+    {
+        if (name == GetTagName(static_cast<MemoryTag>(i)))
+        {
+            tag = static_cast<MemoryTag>(i);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,56 @@
+#ifndef MEMORYTRACKER_H
+#define MEMORYTRACKER_H
+
+#include <array>
+#include <cstddef>
+#include <string>
+
+// What the memory is used for
+enum MemoryTag
+{
+    MEMORY_TAG_ECS,
+    MEMORY_TAG_TEXTURES,
+    MEMORY_TAG_SCRIPTS,
+    MEMORY_TAG_EVENTS,
+    MEMORY_TAG_LOGGER,
+    NUM_MEMORY_TAGS
+};
+
+struct MemoryTagStats
+{
+    size_t numBytes = 0;
+    size_t peakNumBytes = 0;
+    // 0 when there is no budget
+    size_t budgetBytes = 0;
+    bool isOverBudget = false;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Memory tracker
+/////////////////////////////////////////////////////////////////////////////////////////////
+// How much memory each subsystem holds, sampled from the subsystems (e.g. once a frame)
+// rather than counted on every allocation. The textures are estimated from their size and
+// pixel format, as their memory belongs to the driver. Each tag keeps its high-water mark,
+// and a tag with a budget warns once each time it goes over it.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class MemoryTracker
+{
+private:
+    std::array<MemoryTagStats, NUM_MEMORY_TAGS> tags;
+
+public:
+    MemoryTracker() = default;
+
+    void SetNumBytes(MemoryTag tag, size_t numBytes);
+    void SetBudget(MemoryTag tag, size_t budgetBytes);
+    const MemoryTagStats& GetStats(MemoryTag tag) const { return tags[tag]; }
+
+    // Every tag with its current, peak and budget bytes
+    void LogReport() const;
+
+    static const char* GetTagName(MemoryTag tag);
+    // The tag of a name given by GetTagName, false when there is none
+    static bool FindTag(const std::string& name, MemoryTag& tag);
+};
+
+#endif
@@ -0,0 +1,214 @@
+#include "FlowField.h"
+#include "../Profiler/Profiler.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+// [direction] -> offset to the neighbor, the 4 sides first
+static const int NEIGHBOR_COLS[8] = {1, 0, -1, 0, 1, -1, -1, 1};
+static const int NEIGHBOR_ROWS[8] = {0, 1, 0, -1, 1, 1, -1, -1};
+static const float DIAGONAL_COST = 1.41421356f;
+static const float INFINITE_COST = std::numeric_limits<float>::infinity();
+
+// [direction] -> the unit vector to the neighbor
+static const glm::vec2 DIRECTIONS[9] =
+{
+    glm::vec2(1, 0), glm::vec2(0, 1), glm::vec2(-1, 0), glm::vec2(0, -1),
+    glm::normalize(glm::vec2(1, 1)), glm::normalize(glm::vec2(-1, 1)), glm::normalize(glm::vec2(-1, -1)), glm::normalize(glm::vec2(1, -1)),
+    glm::vec2(0, 0)
+};
+
+// Diagonals only between two open cells, the units don't clip the corners
+static bool CanStep(const NavigationGrid& grid, int col, int row, int direction)
+{
+    const int dx = NEIGHBOR_COLS[direction];
+    const int dy = NEIGHBOR_ROWS[direction];
+    if (!grid.IsWalkable(col + dx, row + dy))
+    {
+        return false;
+    }
+    return direction < 4 || (grid.IsWalkable(col + dx, row) && grid.IsWalkable(col, row + dy));
+}
+
+void FlowField::Build(const NavigationGrid& grid, int goalCell)
+{
+    PROFILE_SCOPE("Flow field build");
+    numCols = grid.GetNumCols();
+    numRows = grid.GetNumRows();
+    cellSize = grid.GetCellSize();
+    this->goalCell = goalCell;
+    costs.assign(grid.GetNumCells(), INFINITE_COST);
+    directions.assign(grid.GetNumCells(), FLOW_FIELD_NO_DIRECTION);
+    if (goalCell < 0 || goalCell >= grid.GetNumCells())
+    {
+        return;
+    }
+
+    // Dijkstra from the goal, the steps are symmetric so the cost from the goal is the cost to it.
+    // The goal may be blocked, e.g. a helicopter over the water, the units go to its shore.
+    const auto isWorse = std::greater<std::pair<float, int>>();
+    open.clear();
+    costs[goalCell] = 0.0f;
+    open.push_back({0.0f, goalCell});
+    while (!open.empty())
+    {
+        std::pop_heap(open.begin(), open.end(), isWorse);
+        const auto [cost, cell] = open.back();
+        open.pop_back();
+        if (cost > costs[cell])
+        {
+            continue;
+        }
+        const int col = cell % numCols;
+        const int row = cell / numCols;
+        for (int direction = 0; direction < 8; direction++)
+        {
+            if (!CanStep(grid, col, row, direction))
+            {
+                continue;
+            }
+            const int neighbor = (row + NEIGHBOR_ROWS[direction]) * numCols + col + NEIGHBOR_COLS[direction];
+            const float neighborCost = cost + (direction < 4 ? 1.0f : DIAGONAL_COST);
+            if (neighborCost < costs[neighbor])
+            {
+                costs[neighbor] = neighborCost;
+                open.push_back({neighborCost, neighbor});
+                std::push_heap(open.begin(), open.end(), isWorse);
+            }
+        }
+    }
+
+    // Each cell points at its cheapest neighbor. The blocked cells too, a unit pushed into one
+    // drives back out of it.
+    for (int row = 0; row < numRows; row++)
+    {
+        for (int col = 0; col < numCols; col++)
+        {
+            const int cell = row * numCols + col;
+            if (cell == goalCell)
+            {
+                continue;
+            }
+            const bool isWalkable = grid.IsWalkable(col, row);
+            float bestCost = isWalkable ? costs[cell] : INFINITE_COST;
+            for (int direction = 0; direction < 8; direction++)
+            {
+                if (isWalkable ? !CanStep(grid, col, row, direction) : !grid.IsWalkable(col + NEIGHBOR_COLS[direction], row + NEIGHBOR_ROWS[direction]))
+                {
+                    continue;
+                }
+                const float neighborCost = costs[(row + NEIGHBOR_ROWS[direction]) * numCols + col + NEIGHBOR_COLS[direction]];
+                if (neighborCost < bestCost)
+                {
+                    bestCost = neighborCost;
+                    directions[cell] = direction;
+                }
+            }
+        }
+    }
+}
+
+int FlowField::GetCell(glm::vec2 position) const
+{
+    const int col = std::max(0, std::min(numCols - 1, static_cast<int>(position.x / cellSize)));
+    const int row = std::max(0, std::min(numRows - 1, static_cast<int>(position.y / cellSize)));
+    return row * numCols + col;
+}
+
+glm::vec2 FlowField::GetDirection(glm::vec2 position) const
+{
+    if (directions.empty())
+    {
+        return glm::vec2(0);
+    }
+    return DIRECTIONS[directions[GetCell(position)]];
+}
+
+float FlowField::GetCost(glm::vec2 position) const
+{
+    if (costs.empty())
+    {
+        return INFINITE_COST;
+    }
+    return costs[GetCell(position)];
+}
+
+FlowFieldTracker::FlowFieldTracker(JobSystem& jobSystem): jobSystem(jobSystem)
+{
+}
+
+FlowFieldTracker::~FlowFieldTracker()
+{
+    Clear();
+}
+
+void FlowFieldTracker::SetGrid(std::shared_ptr<const NavigationGrid> grid)
+{
+    Clear();
+    this->grid = grid;
+}
+
+void FlowFieldTracker::SetGoal(glm::vec2 goal)
+{
+    this->goal = goal;
+    hasGoal = true;
+}
+
+void FlowFieldTracker::ClearGoal()
+{
+    hasGoal = false;
+}
+
+void FlowFieldTracker::Update()
+{
+    CollectBuild();
+    if (!hasGoal || !grid || grid->IsEmpty())
+    {
+        return;
+    }
+    const int cell = grid->GetCell(goal);
+    if (cell == goalCell)
+    {
+        return;
+    }
+
+    goalCell = cell;
+    build = std::make_shared<Build>();
+    build->grid = grid;
+    build->field = spareField ? spareField : std::make_shared<FlowField>();
+    build->goalCell = cell;
+    spareField.reset();
+    numBuilds++;
+    std::shared_ptr<Build> jobBuild = build;
+    jobSystem.Schedule([jobBuild]()
+    {
+        jobBuild->field->Build(*jobBuild->grid, jobBuild->goalCell);
+        std::lock_guard<std::mutex> lock(jobBuild->mutex);
+        jobBuild->isDone = true;
+        jobBuild->done.notify_all();
+    });
+}
+
+void FlowFieldTracker::CollectBuild()
+{
+    if (!build)
+    {
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(build->mutex);
+        build->done.wait(lock, [this]() { return build->isDone; });
+    }
+    spareField = field;
+    field = build->field;
+    build.reset();
+}
+
+void FlowFieldTracker::Clear()
+{
+    CollectBuild();
+    field.reset();
+    spareField.reset();
+    goalCell = -1;
+    hasGoal = false;
+}
@@ -0,0 +1,106 @@
+#ifndef FLOWFIELD_H
+#define FLOWFIELD_H
+
+#include "NavigationGrid.h"
+#include "../Jobs/JobSystem.h"
+#include <glm/glm.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// The direction of a cell that has none: the goal, and the cells that can't reach it
+const uint8_t FLOW_FIELD_NO_DIRECTION = 8;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Flow field
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The way to a goal from every cell of the navigation grid, for the units that all go to the
+// same place: one Dijkstra pass from the goal gives each cell its cost to the goal, and each
+// cell points at its cheapest neighbor. A unit then reads its direction from its cell instead
+// of searching a path of its own, however many of them there are.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class FlowField
+{
+private:
+    int numCols = 0;
+    int numRows = 0;
+    float cellSize = 1.0f;
+    int goalCell = -1;
+    // [cell] -> cost to the goal in cells, infinite when it can't be reached
+    std::vector<float> costs;
+    // [cell] -> index of the neighbor to go to, FLOW_FIELD_NO_DIRECTION for none
+    std::vector<uint8_t> directions;
+    // Reused by the builds, (cost, cell) as a min-heap
+    std::vector<std::pair<float, int>> open;
+
+public:
+    FlowField() = default;
+
+    void Build(const NavigationGrid& grid, int goalCell);
+
+    bool IsEmpty() const { return directions.empty(); }
+    int GetGoalCell() const { return goalCell; }
+    // Unit length, or zero in the goal cell and where the goal can't be reached from
+    glm::vec2 GetDirection(glm::vec2 position) const;
+    float GetCost(glm::vec2 position) const;
+    int GetCell(glm::vec2 position) const;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Flow field tracker
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Keeps a flow field towards a goal that moves, e.g. the player. The field is only built
+// again when the goal gets into another cell, on the job system while the tick goes on: an
+// Update swaps in the field the previous Update started, so the units switch to the new
+// field on the same tick whatever the workers' timing.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class FlowFieldTracker
+{
+private:
+    // Shared with the job building it
+    struct Build
+    {
+        std::shared_ptr<const NavigationGrid> grid;
+        std::shared_ptr<FlowField> field;
+        int goalCell;
+        std::mutex mutex;
+        std::condition_variable done;
+        bool isDone = false;
+    };
+
+    JobSystem& jobSystem;
+    std::shared_ptr<const NavigationGrid> grid;
+    std::shared_ptr<FlowField> field;
+    std::shared_ptr<Build> build;
+    // The field built before it, reused by the next build so it doesn't allocate
+    std::shared_ptr<FlowField> spareField;
+    glm::vec2 goal = glm::vec2(0);
+    int goalCell = -1;
+    bool hasGoal = false;
+    int numBuilds = 0;
+
+    void CollectBuild();
+
+public:
+    FlowFieldTracker(JobSystem& jobSystem);
+    ~FlowFieldTracker();
+
+    // The field of the previous grid is dropped
+    void SetGrid(std::shared_ptr<const NavigationGrid> grid);
+    // The field is built again by the next Update when the goal is in another cell
+    void SetGoal(glm::vec2 goal);
+    void ClearGoal();
+
+    // Swaps in the field built since the last Update, and starts a build when the goal cell changed
+    void Update();
+    void Clear();
+
+    // Null until the first build is collected and without a goal
+    const FlowField* GetField() const { return hasGoal ? field.get() : nullptr; }
+    glm::vec2 GetGoal() const { return goal; }
+    int GetNumBuilds() const { return numBuilds; }
+};
+
+#endif
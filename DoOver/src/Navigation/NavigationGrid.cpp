@@ -0,0 +1,122 @@
+#include "NavigationGrid.h"
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+
+void NavigationGrid::Build(const TilemapData& tilemap, const std::vector<TilemapTile>& blockedTiles, float cellSize)
+{
+    numCols = tilemap.numCols;
+    numRows = tilemap.numRows;
+    this->cellSize = cellSize > 0.0f ? cellSize : 1.0f;
+    bakedFile.reset();
+    walkableBits.assign((numCols * numRows + 63) / 64, 0);
+    bits = walkableBits.data();
+    numWords = walkableBits.size();
+
+    for (int row = 0; row < numRows; row++)
+    {
+        for (int col = 0; col < numCols; col++)
+        {
+            const TilemapTile& tile = tilemap.tiles[row * numCols + col];
+            const bool isBlocked = std::any_of(blockedTiles.begin(), blockedTiles.end(), [&tile](const TilemapTile& blockedTile)
+            {
+                return blockedTile.col == tile.col && blockedTile.row == tile.row;
+            });
+            SetWalkable(col, row, !isBlocked);
+        }
+    }
+}
+
+void NavigationGrid::Clear()
+{
+    numCols = 0;
+    numRows = 0;
+    walkableBits.clear();
+    walkableBits.shrink_to_fit();
+    bakedFile.reset();
+    bits = nullptr;
+    numWords = 0;
+}
+
+std::vector<char> NavigationGrid::WriteBaked(uint64_t sourceHash) const
+{
+    NavigationGridHeader header = {};
+    std::memcpy(header.magic, NAVIGATION_GRID_MAGIC, sizeof(header.magic));
+    header.version = NAVIGATION_GRID_VERSION;
+    header.numCols = numCols;
+    header.numRows = numRows;
+    header.cellSize = cellSize;
+    header.sourceHash = sourceHash;
+    std::vector<char> baked(sizeof(header) + numWords * sizeof(uint64_t));
+    std::memcpy(baked.data(), &header, sizeof(header));
+    if (numWords > 0)
+    {
+        std::memcpy(baked.data() + sizeof(header), bits, numWords * sizeof(uint64_t));
+    }
+    return baked;
+}
+
+bool NavigationGrid::MapBaked(const std::shared_ptr<MappedFile>& file, uint64_t sourceHash)
+{
+    if (!file || file->GetSize() < sizeof(NavigationGridHeader))
+    {
+        return false;
+    }
+    NavigationGridHeader header;
+    std::memcpy(&header, file->GetData(), sizeof(header));
+    const size_t bakedWords = (static_cast<size_t>(header.numCols) * header.numRows + 63) / 64;
+    if (std::memcmp(header.magic, NAVIGATION_GRID_MAGIC, sizeof(header.magic)) != 0 || header.version != NAVIGATION_GRID_VERSION
+        || header.sourceHash != sourceHash || file->GetSize() != sizeof(header) + bakedWords * sizeof(uint64_t))
+    {
+        return false;
+    }
+    numCols = header.numCols;
+    numRows = header.numRows;
+    cellSize = header.cellSize > 0.0f ? header.cellSize : 1.0f;
+    walkableBits.clear();
+    walkableBits.shrink_to_fit();
+    bakedFile = file;
+    bits = reinterpret_cast<const uint64_t*>(file->GetData() + sizeof(header));
+    numWords = bakedWords;
+    return true;
+}
+
+void NavigationGrid::SetWalkable(int col, int row, bool isWalkable)
+{
+    if (!IsInside(col, row))
+    {
+        return;
+    }
+    // Copied out of the mapping on the first change, the other instances keep reading it as baked
+    if (bakedFile)
+    {
+        walkableBits.assign(bits, bits + numWords);
+        bits = walkableBits.data();
+        bakedFile.reset();
+    }
+    const int cell = row * numCols + col;
+    const uint64_t bit = uint64_t(1) << (cell & 63);
+    walkableBits[cell >> 6] = isWalkable ? walkableBits[cell >> 6] | bit : walkableBits[cell >> 6] & ~bit;
+}
+
+int NavigationGrid::GetCell(glm::vec2 position) const
+{
+    const int col = std::max(0, std::min(numCols - 1, static_cast<int>(position.x / cellSize)));
+    const int row = std::max(0, std::min(numRows - 1, static_cast<int>(position.y / cellSize)));
+    return row * numCols + col;
+}
+
+glm::vec2 NavigationGrid::GetCellCenter(int cell) const
+{
+    return glm::vec2((cell % numCols + 0.5f) * cellSize, (cell / numCols + 0.5f) * cellSize);
+}
+
+int NavigationGrid::GetWalkableCount() const
+{
+    int count = 0;
+    for (size_t i = 0; i < numWords; i++)
+    {
+        count += std::bitset<64>(bits[i]).count();
+    }
+    return count;
+}
@@ -0,0 +1,113 @@
+#ifndef NAVIGATIONGRID_H
+#define NAVIGATIONGRID_H
+
+#include "../Tilemap/TilemapFormat.h"
+#include "../Memory/MappedFile.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+const char NAVIGATION_GRID_MAGIC[4] = {'D', 'N', 'V', 'G'};
+const uint32_t NAVIGATION_GRID_VERSION = 1;
+
+// Followed by the walkable bits, 8 byte aligned so they are read from the mapping as they are
+struct NavigationGridHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t numCols;
+    uint32_t numRows;
+    float cellSize;
+    uint32_t reserved;
+    // Of what the grid was built from, a baked grid of another map isn't mapped
+    uint64_t sourceHash;
+};
+
+// A rectangle of cells, the last column and row included
+struct GridBounds
+{
+    int minCol;
+    int minRow;
+    int maxCol;
+    int maxRow;
+
+    bool Contains(int col, int row) const
+    {
+        return col >= minCol && row >= minRow && col <= maxCol && row <= maxRow;
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Navigation grid
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Where the ground units can drive: one cell per tile of the map, blocked when its tile is
+// one of the blocked tiles of the level (e.g. the water). The cells are one bit each, packed
+// in 64 bit words, so the grid of a large map stays small enough to search from the cache.
+// A grid written by WriteBaked is mapped back by MapBaked and its bits are read from the
+// shared mapping, the game instances of a machine hold a single copy of it. The first
+// SetWalkable copies them, the mapping is never written.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class NavigationGrid
+{
+private:
+    int numCols = 0;
+    int numRows = 0;
+    // Size of a cell in world pixels
+    float cellSize = 1.0f;
+    // [cell / 64] >> (cell % 64) -> whether the cell is walkable, either walkableBits or the
+    // mapped baked grid
+    const uint64_t* bits = nullptr;
+    size_t numWords = 0;
+    std::vector<uint64_t> walkableBits;
+    std::shared_ptr<MappedFile> bakedFile;
+
+public:
+    NavigationGrid() = default;
+    // The bits may point into the grid itself
+    NavigationGrid(const NavigationGrid&) = delete;
+    NavigationGrid& operator=(const NavigationGrid&) = delete;
+
+    // cellSize is the size of a tile in the world, its size in the tileset times the scale
+    void Build(const TilemapData& tilemap, const std::vector<TilemapTile>& blockedTiles, float cellSize);
+    void Clear();
+
+    // The header and the bits of a built grid
+    std::vector<char> WriteBaked(uint64_t sourceHash) const;
+    // Reads the bits from the mapped file from now on, false when it holds another grid
+    bool MapBaked(const std::shared_ptr<MappedFile>& file, uint64_t sourceHash);
+    bool IsMapped() const { return bakedFile != nullptr; }
+
+    bool IsEmpty() const { return numWords == 0; }
+    int GetNumCols() const { return numCols; }
+    int GetNumRows() const { return numRows; }
+    int GetNumCells() const { return numCols * numRows; }
+    float GetCellSize() const { return cellSize; }
+
+    bool IsInside(int col, int row) const
+    {
+        return col >= 0 && row >= 0 && col < numCols && row < numRows;
+    }
+
+    // Outside the grid is blocked
+    bool IsWalkable(int col, int row) const
+    {
+        if (!IsInside(col, row))
+        {
+            return false;
+        }
+        const int cell = row * numCols + col;
+        return (bits[cell >> 6] >> (cell & 63)) & 1;
+    }
+
+    void SetWalkable(int col, int row, bool isWalkable);
+
+    GridBounds GetBounds() const { return {0, 0, numCols - 1, numRows - 1}; }
+    // The cell a world position is in, clamped to the grid
+    int GetCell(glm::vec2 position) const;
+    // The center of a cell in the world
+    glm::vec2 GetCellCenter(int cell) const;
+    int GetWalkableCount() const;
+};
+
+#endif
@@ -0,0 +1,335 @@
+#include "NavigationHierarchy.h"
+#include "../Profiler/Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+static const float DIAGONAL_COST = 1.41421356f;
+
+// Octile distance, the exact cost on an empty 8-connected grid
+static float GetHeuristic(int cell, int goalCell, int numCols)
+{
+    const float dx = std::abs(cell % numCols - goalCell % numCols);
+    const float dy = std::abs(cell / numCols - goalCell / numCols);
+    return std::max(dx, dy) + (DIAGONAL_COST - 1.0f) * std::min(dx, dy);
+}
+
+void NavigationHierarchy::Build(const NavigationGrid& grid, int clusterSize, JobSystem& jobSystem)
+{
+    PROFILE_SCOPE("Navigation hierarchy");
+    Clear();
+    if (grid.IsEmpty() || clusterSize <= 0)
+    {
+        return;
+    }
+    this->clusterSize = clusterSize;
+    numClusterCols = (grid.GetNumCols() + clusterSize - 1) / clusterSize;
+    numClusterRows = (grid.GetNumRows() + clusterSize - 1) / clusterSize;
+    clusterNodes.resize(numClusterCols * numClusterRows);
+
+    FindEntrances(grid);
+    // A cluster only adds edges to its own nodes, the clusters are linked side by side
+    jobSystem.ParallelFor(clusterNodes.size(), 1, [this, &grid](int begin, int end)
+    {
+        for (int cluster = begin; cluster < end; cluster++)
+        {
+            LinkClusterNodes(grid, cluster);
+        }
+    });
+}
+
+void NavigationHierarchy::Clear()
+{
+    clusterSize = 0;
+    numClusterCols = 0;
+    numClusterRows = 0;
+    nodeCells.clear();
+    nodeEdges.clear();
+    clusterNodes.clear();
+    cellNodes.clear();
+}
+
+int NavigationHierarchy::AddNode(int cell, int cluster)
+{
+    const auto node = cellNodes.find(cell);
+    if (node != cellNodes.end())
+    {
+        return node->second;
+    }
+    const int newNode = nodeCells.size();
+    nodeCells.push_back(cell);
+    nodeEdges.emplace_back();
+    clusterNodes[cluster].push_back(newNode);
+    cellNodes[cell] = newNode;
+    return newNode;
+}
+
+void NavigationHierarchy::AddEntrance(int cellA, int clusterA, int cellB, int clusterB)
+{
+    const int nodeA = AddNode(cellA, clusterA);
+    const int nodeB = AddNode(cellB, clusterB);
+    nodeEdges[nodeA].push_back({nodeB, 1.0f});
+    nodeEdges[nodeB].push_back({nodeA, 1.0f});
+}
+
+void NavigationHierarchy::FindEntrances(const NavigationGrid& grid)
+{
+    const int numCols = grid.GetNumCols();
+    const int numRows = grid.GetNumRows();
+
+    // Along a border of length cells, across(i) gives the cells on both sides at i
+    const auto addEntrances = [this](int length, const std::function<std::pair<int, int>(int)>& across, const std::function<bool(int)>& isOpen, int clusterA, int clusterB)
+    {
+        int runStart = -1;
+        for (int i = 0; i <= length; i++)
+        {
+            if (i < length && isOpen(i))
+            {
+                runStart = runStart < 0 ? i : runStart;
+                continue;
+            }
+            if (runStart < 0)
+            {
+                continue;
+            }
+            const int runEnd = i - 1;
+            if (runEnd - runStart + 1 <= NAVIGATION_MAX_SINGLE_ENTRANCE)
+            {
+                const auto [cellA, cellB] = across((runStart + runEnd) / 2);
+                AddEntrance(cellA, clusterA, cellB, clusterB);
+            }
+            else
+            {
+                const auto [firstA, firstB] = across(runStart);
+                const auto [lastA, lastB] = across(runEnd);
+                AddEntrance(firstA, clusterA, firstB, clusterB);
+                AddEntrance(lastA, clusterA, lastB, clusterB);
+            }
+            runStart = -1;
+        }
+    };
+
+    for (int clusterRow = 0; clusterRow < numClusterRows; clusterRow++)
+    {
+        for (int clusterCol = 0; clusterCol < numClusterCols; clusterCol++)
+        {
+            const int cluster = clusterRow * numClusterCols + clusterCol;
+            const int minCol = clusterCol * clusterSize;
+            const int minRow = clusterRow * clusterSize;
+            // The border with the cluster on the right
+            if (clusterCol + 1 < numClusterCols)
+            {
+                const int col = minCol + clusterSize - 1;
+                const int length = std::min(clusterSize, numRows - minRow);
+                addEntrances(length,
+                    [col, minRow, numCols](int i) { return std::make_pair((minRow + i) * numCols + col, (minRow + i) * numCols + col + 1); },
+                    [&grid, col, minRow](int i) { return grid.IsWalkable(col, minRow + i) && grid.IsWalkable(col + 1, minRow + i); },
+                    cluster, cluster + 1);
+            }
+            // The border with the cluster below
+            if (clusterRow + 1 < numClusterRows)
+            {
+                const int row = minRow + clusterSize - 1;
+                const int length = std::min(clusterSize, numCols - minCol);
+                addEntrances(length,
+                    [row, minCol, numCols](int i) { return std::make_pair(row * numCols + minCol + i, (row + 1) * numCols + minCol + i); },
+                    [&grid, row, minCol](int i) { return grid.IsWalkable(minCol + i, row) && grid.IsWalkable(minCol + i, row + 1); },
+                    cluster, cluster + numClusterCols);
+            }
+        }
+    }
+}
+
+void NavigationHierarchy::LinkClusterNodes(const NavigationGrid& grid, int cluster)
+{
+    const GridBounds bounds = GetClusterBounds(grid, cluster);
+    const int boundsCols = bounds.maxCol - bounds.minCol + 1;
+    const int numCols = grid.GetNumCols();
+    const std::vector<int>& nodes = clusterNodes[cluster];
+    std::vector<float> costs;
+    for (int node: nodes)
+    {
+        SearchBounds(grid, nodeCells[node], bounds, costs);
+        for (int otherNode: nodes)
+        {
+            const int otherCell = nodeCells[otherNode];
+            const float cost = costs[(otherCell / numCols - bounds.minRow) * boundsCols + otherCell % numCols - bounds.minCol];
+            if (otherNode != node && cost >= 0.0f)
+            {
+                nodeEdges[node].push_back({otherNode, cost});
+            }
+        }
+    }
+}
+
+int NavigationHierarchy::GetCluster(const NavigationGrid& grid, int cell) const
+{
+    const int col = cell % grid.GetNumCols();
+    const int row = cell / grid.GetNumCols();
+    return (row / clusterSize) * numClusterCols + col / clusterSize;
+}
+
+GridBounds NavigationHierarchy::GetClusterBounds(const NavigationGrid& grid, int cluster) const
+{
+    const int minCol = (cluster % numClusterCols) * clusterSize;
+    const int minRow = (cluster / numClusterCols) * clusterSize;
+    return {minCol, minRow, std::min(minCol + clusterSize, grid.GetNumCols()) - 1, std::min(minRow + clusterSize, grid.GetNumRows()) - 1};
+}
+
+void NavigationHierarchy::SearchBounds(const NavigationGrid& grid, int sourceCell, const GridBounds& bounds, std::vector<float>& costs)
+{
+    const int numCols = grid.GetNumCols();
+    const int boundsCols = bounds.maxCol - bounds.minCol + 1;
+    const int boundsRows = bounds.maxRow - bounds.minRow + 1;
+    costs.assign(boundsCols * boundsRows, -1.0f);
+
+    // (cost, cell of the bounds), a min-heap
+    std::vector<std::pair<float, int>> open;
+    const auto isWorse = std::greater<std::pair<float, int>>();
+    // The source may be blocked, like the start of a search
+    const int source = (sourceCell / numCols - bounds.minRow) * boundsCols + sourceCell % numCols - bounds.minCol;
+    costs[source] = 0.0f;
+    open.push_back({0.0f, source});
+
+    while (!open.empty())
+    {
+        std::pop_heap(open.begin(), open.end(), isWorse);
+        const auto [cost, cell] = open.back();
+        open.pop_back();
+        if (cost > costs[cell])
+        {
+            continue;
+        }
+        const int col = bounds.minCol + cell % boundsCols;
+        const int row = bounds.minRow + cell / boundsCols;
+        for (int dy = -1; dy <= 1; dy++)
+        {
+            for (int dx = -1; dx <= 1; dx++)
+            {
+                if ((dx == 0 && dy == 0) || !bounds.Contains(col + dx, row + dy) || !grid.IsWalkable(col + dx, row + dy))
+                {
+                    continue;
+                }
+                // The same moves as the pathfinder, the costs are the ones its refinement finds
+                const bool isDiagonal = dx != 0 && dy != 0;
+                if (isDiagonal && (!grid.IsWalkable(col + dx, row) || !grid.IsWalkable(col, row + dy)))
+                {
+                    continue;
+                }
+                const int neighbor = cell + dy * boundsCols + dx;
+                const float neighborCost = cost + (isDiagonal ? DIAGONAL_COST : 1.0f);
+                if (costs[neighbor] >= 0.0f && costs[neighbor] <= neighborCost)
+                {
+                    continue;
+                }
+                costs[neighbor] = neighborCost;
+                open.push_back({neighborCost, neighbor});
+                std::push_heap(open.begin(), open.end(), isWorse);
+            }
+        }
+    }
+}
+
+bool NavigationHierarchy::FindAbstractPath(const NavigationGrid& grid, int startCell, int goalCell, std::vector<int>& cells) const
+{
+    const int numCols = grid.GetNumCols();
+    const int numNodes = nodeCells.size();
+    // The start and the goal join the graph for this search only
+    const int startNode = numNodes;
+    const int goalNode = numNodes + 1;
+    const int startCluster = GetCluster(grid, startCell);
+    const int goalCluster = GetCluster(grid, goalCell);
+
+    const auto getLinks = [this, &grid, numCols](int cell, int cluster)
+    {
+        const GridBounds bounds = GetClusterBounds(grid, cluster);
+        const int boundsCols = bounds.maxCol - bounds.minCol + 1;
+        std::vector<float> costs;
+        SearchBounds(grid, cell, bounds, costs);
+        std::vector<Edge> links;
+        for (int node: clusterNodes[cluster])
+        {
+            const int nodeCell = nodeCells[node];
+            const float cost = costs[(nodeCell / numCols - bounds.minRow) * boundsCols + nodeCell % numCols - bounds.minCol];
+            if (cost >= 0.0f)
+            {
+                links.push_back({node, cost});
+            }
+        }
+        return links;
+    };
+    const std::vector<Edge> startLinks = getLinks(startCell, startCluster);
+    // The moves are symmetric, the costs from the goal are the costs to it
+    const std::vector<Edge> goalLinks = getLinks(goalCell, goalCluster);
+    if (startLinks.empty() || goalLinks.empty())
+    {
+        return false;
+    }
+
+    std::vector<float> costs(numNodes + 2, std::numeric_limits<float>::max());
+    std::vector<int> parents(numNodes + 2, -1);
+    std::vector<std::pair<float, int>> open;
+    const auto isWorse = std::greater<std::pair<float, int>>();
+    const auto getCell = [this, startNode, startCell, goalCell](int node)
+    {
+        return node < startNode ? nodeCells[node] : node == startNode ? startCell : goalCell;
+    };
+    const auto relax = [&](int node, int neighbor, float neighborCost)
+    {
+        if (costs[neighbor] <= neighborCost)
+        {
+            return;
+        }
+        costs[neighbor] = neighborCost;
+        parents[neighbor] = node;
+        open.push_back({neighborCost + GetHeuristic(getCell(neighbor), goalCell, numCols), neighbor});
+        std::push_heap(open.begin(), open.end(), isWorse);
+    };
+
+    costs[startNode] = 0.0f;
+    open.push_back({GetHeuristic(startCell, goalCell, numCols), startNode});
+    bool isFound = false;
+    while (!open.empty())
+    {
+        std::pop_heap(open.begin(), open.end(), isWorse);
+        const auto [estimate, node] = open.back();
+        open.pop_back();
+        const float cost = costs[node];
+        if (estimate > cost + GetHeuristic(getCell(node), goalCell, numCols) + 1e-4f)
+        {
+            continue;
+        }
+        if (node == goalNode)
+        {
+            isFound = true;
+            break;
+        }
+        for (const Edge& edge: node == startNode ? startLinks : nodeEdges[node])
+        {
+            relax(node, edge.node, cost + edge.cost);
+        }
+        if (node != startNode && GetCluster(grid, nodeCells[node]) == goalCluster)
+        {
+            for (const Edge& link: goalLinks)
+            {
+                if (link.node == node)
+                {
+                    relax(node, goalNode, cost + link.cost);
+                }
+            }
+        }
+    }
+    if (!isFound)
+    {
+        return false;
+    }
+
+    cells.clear();
+    for (int node = goalNode; node != -1; node = parents[node])
+    {
+        cells.push_back(getCell(node));
+    }
+    std::reverse(cells.begin(), cells.end());
+    return true;
+}
@@ -0,0 +1,70 @@
+#ifndef NAVIGATIONHIERARCHY_H
+#define NAVIGATIONHIERARCHY_H
+
+#include "NavigationGrid.h"
+#include "../Jobs/JobSystem.h"
+#include <unordered_map>
+#include <vector>
+
+// Entrances up to this long cross in their middle, the longer ones at both ends
+const int NAVIGATION_MAX_SINGLE_ENTRANCE = 6;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Navigation hierarchy
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The abstract graph of HPA*: the grid is cut into square clusters, the size of the chunks
+// the tilemap streams, and the open stretches along the border of two clusters are their
+// entrances. A node is a cell next to a border, it is linked to its twin across the border
+// and to the nodes of its cluster it can reach inside it, with the cost of the way there.
+// A long search runs over these few nodes, then each leg is refined by a search bounded
+// to one or two clusters, so its cost follows the distance in clusters, not in cells.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class NavigationHierarchy
+{
+private:
+    struct Edge
+    {
+        int node;
+        float cost;
+    };
+
+    int clusterSize = 0;
+    int numClusterCols = 0;
+    int numClusterRows = 0;
+    // [node] -> its cell, its edges
+    std::vector<int> nodeCells;
+    std::vector<std::vector<Edge>> nodeEdges;
+    // [cluster] -> its nodes
+    std::vector<std::vector<int>> clusterNodes;
+    // [cell] -> its node, for the cells that are one
+    std::unordered_map<int, int> cellNodes;
+
+    int AddNode(int cell, int cluster);
+    void AddEntrance(int cellA, int clusterA, int cellB, int clusterB);
+    void FindEntrances(const NavigationGrid& grid);
+    void LinkClusterNodes(const NavigationGrid& grid, int cluster);
+
+public:
+    NavigationHierarchy() = default;
+
+    // The clusters' links are found on the job system, one cluster per chunk of work
+    void Build(const NavigationGrid& grid, int clusterSize, JobSystem& jobSystem);
+    void Clear();
+
+    bool IsEmpty() const { return clusterNodes.empty(); }
+    int GetClusterSize() const { return clusterSize; }
+    int GetNumClusters() const { return clusterNodes.size(); }
+    int GetNumNodes() const { return nodeCells.size(); }
+    int GetCluster(const NavigationGrid& grid, int cell) const;
+    GridBounds GetClusterBounds(const NavigationGrid& grid, int cluster) const;
+
+    // The cells the path goes through, the start, the entrances, then the goal, false when
+    // the goal can't be reached. Only meant for cells of different clusters.
+    bool FindAbstractPath(const NavigationGrid& grid, int startCell, int goalCell, std::vector<int>& cells) const;
+
+    // Dijkstra from a cell inside the bounds, [cell of the bounds, row by row] -> its cost,
+    // negative when it can't be reached
+    static void SearchBounds(const NavigationGrid& grid, int sourceCell, const GridBounds& bounds, std::vector<float>& costs);
+};
+
+#endif
@@ -0,0 +1,366 @@
+#include "Pathfinder.h"
+#include "../Profiler/Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+// Reused by the searches of a thread, the costs of a search are only valid where the stamp
+// is the search's
+struct SearchScratch
+{
+    std::vector<float> costs;
+    std::vector<int> parents;
+    std::vector<uint32_t> stamps;
+    uint32_t stamp = 0;
+    // (estimated total cost, cell), a min-heap
+    std::vector<std::pair<float, int>> open;
+};
+
+static const float DIAGONAL_COST = 1.41421356f;
+
+// Octile distance, the exact cost on an empty 8-connected grid
+static float GetHeuristic(int col, int row, int goalCol, int goalRow)
+{
+    const float dx = std::abs(col - goalCol);
+    const float dy = std::abs(row - goalRow);
+    return std::max(dx, dy) + (DIAGONAL_COST - 1.0f) * std::min(dx, dy);
+}
+
+Pathfinder::Pathfinder(JobSystem& jobSystem): jobSystem(jobSystem)
+{
+}
+
+Pathfinder::~Pathfinder()
+{
+    Clear();
+}
+
+uint64_t Pathfinder::GetCacheKey(int startCell, int goalCell)
+{
+    return (static_cast<uint64_t>(startCell) << 32) | static_cast<uint32_t>(goalCell);
+}
+
+void Pathfinder::SetGrid(std::shared_ptr<const NavigationGrid> grid, std::shared_ptr<const NavigationHierarchy> hierarchy)
+{
+    Clear();
+    this->grid = grid;
+    this->hierarchy = hierarchy;
+}
+
+PathRequestId Pathfinder::RequestPath(glm::vec2 start, glm::vec2 goal)
+{
+    if (!grid || grid->IsEmpty())
+    {
+        return INVALID_PATH_REQUEST;
+    }
+    const PathRequestId id = nextRequestId++;
+    const Request request = {id, grid->GetCell(start), grid->GetCell(goal)};
+    stats.numRequests++;
+
+    const auto cachedPath = cache.find(GetCacheKey(request.startCell, request.goalCell));
+    if (cachedPath != cache.end())
+    {
+        stats.numCacheHits++;
+        SetResult(id, cachedPath->second);
+        return id;
+    }
+    results[id] = {PATH_STATUS_PENDING, nullptr};
+    queuedRequests.push_back(request);
+    return id;
+}
+
+PathStatus Pathfinder::TakePath(PathRequestId id, Path& path)
+{
+    const auto result = results.find(id);
+    if (result == results.end())
+    {
+        return PATH_STATUS_NOT_FOUND;
+    }
+    const PathStatus status = result->second.status;
+    if (status == PATH_STATUS_FOUND)
+    {
+        path = *result->second.path;
+    }
+    if (status != PATH_STATUS_PENDING)
+    {
+        results.erase(result);
+    }
+    return status;
+}
+
+void Pathfinder::CancelRequest(PathRequestId id)
+{
+    // A queued or running search still completes, its path goes to the cache alone
+    results.erase(id);
+}
+
+void Pathfinder::Update()
+{
+    PROFILE_SCOPE("Pathfinder");
+    CollectBatch();
+    if (queuedRequests.empty())
+    {
+        return;
+    }
+
+    batch = std::make_shared<Batch>();
+    batch->grid = grid;
+    batch->hierarchy = hierarchy;
+    while (!queuedRequests.empty() && static_cast<int>(batch->requests.size()) < PATHFINDER_REQUESTS_PER_TICK)
+    {
+        const Request request = queuedRequests.front();
+        queuedRequests.pop_front();
+        if (results.find(request.id) == results.end())
+        {
+            continue;
+        }
+        // A search of the same cells collected since it was queued
+        const auto cachedPath = cache.find(GetCacheKey(request.startCell, request.goalCell));
+        if (cachedPath != cache.end())
+        {
+            stats.numCacheHits++;
+            SetResult(request.id, cachedPath->second);
+            continue;
+        }
+        batch->requests.push_back(request);
+    }
+    stats.numSearches += batch->requests.size();
+    batch->paths.resize(batch->requests.size());
+
+    const int numRequests = batch->requests.size();
+    const int numJobs = (numRequests + PATHFINDER_REQUESTS_PER_JOB - 1) / PATHFINDER_REQUESTS_PER_JOB;
+    batch->numPendingJobs = numJobs;
+    for (int job = 0; job < numJobs; job++)
+    {
+        const int begin = job * PATHFINDER_REQUESTS_PER_JOB;
+        const int end = std::min(numRequests, begin + PATHFINDER_REQUESTS_PER_JOB);
+        std::shared_ptr<Batch> jobBatch = batch;
+        jobSystem.Schedule([jobBatch, begin, end]()
+        {
+            PROFILE_SCOPE("Path search");
+            for (int i = begin; i < end; i++)
+            {
+                const Request& request = jobBatch->requests[i];
+                jobBatch->paths[i] = FindPath(*jobBatch->grid, request.startCell, request.goalCell, jobBatch->hierarchy.get());
+            }
+            std::lock_guard<std::mutex> lock(jobBatch->mutex);
+            if (--jobBatch->numPendingJobs == 0)
+            {
+                jobBatch->jobsDone.notify_all();
+            }
+        });
+    }
+}
+
+void Pathfinder::CollectBatch()
+{
+    if (!batch)
+    {
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(batch->mutex);
+        batch->jobsDone.wait(lock, [this]() { return batch->numPendingJobs == 0; });
+    }
+    // In the order of the requests, the same requests give the same cache
+    for (size_t i = 0; i < batch->requests.size(); i++)
+    {
+        const Request& request = batch->requests[i];
+        AddToCache(GetCacheKey(request.startCell, request.goalCell), batch->paths[i]);
+        if (results.find(request.id) != results.end())
+        {
+            SetResult(request.id, batch->paths[i]);
+        }
+    }
+    batch.reset();
+}
+
+void Pathfinder::AddToCache(uint64_t key, std::shared_ptr<const Path> path)
+{
+    if (cache.size() >= PATHFINDER_CACHE_CAPACITY)
+    {
+        cache.clear();
+    }
+    cache[key] = path;
+}
+
+void Pathfinder::SetResult(PathRequestId id, const std::shared_ptr<const Path>& path)
+{
+    results[id] = {path ? PATH_STATUS_FOUND : PATH_STATUS_NOT_FOUND, path};
+}
+
+void Pathfinder::Clear()
+{
+    CollectBatch();
+    queuedRequests.clear();
+    results.clear();
+    cache.clear();
+    stats = {};
+}
+
+std::shared_ptr<const Path> Pathfinder::FindPath(const NavigationGrid& grid, int startCell, int goalCell, const NavigationHierarchy* hierarchy)
+{
+    const int numCols = grid.GetNumCols();
+    if (!grid.IsWalkable(goalCell % numCols, goalCell / numCols))
+    {
+        return nullptr;
+    }
+
+    std::vector<int> cells = {startCell};
+    if (!hierarchy || hierarchy->IsEmpty())
+    {
+        if (!SearchCells(grid, startCell, goalCell, grid.GetBounds(), cells))
+        {
+            return nullptr;
+        }
+    }
+    else if (hierarchy->GetCluster(grid, startCell) == hierarchy->GetCluster(grid, goalCell))
+    {
+        // The way around through the other clusters is the rare case
+        if (!SearchCells(grid, startCell, goalCell, hierarchy->GetClusterBounds(grid, hierarchy->GetCluster(grid, startCell)), cells) &&
+            !SearchCells(grid, startCell, goalCell, grid.GetBounds(), cells))
+        {
+            return nullptr;
+        }
+    }
+    else
+    {
+        std::vector<int> abstractCells;
+        if (!hierarchy->FindAbstractPath(grid, startCell, goalCell, abstractCells))
+        {
+            return nullptr;
+        }
+        // A leg is inside a cluster, or the step across a border between two
+        for (size_t i = 1; i < abstractCells.size(); i++)
+        {
+            const GridBounds boundsA = hierarchy->GetClusterBounds(grid, hierarchy->GetCluster(grid, abstractCells[i - 1]));
+            const GridBounds boundsB = hierarchy->GetClusterBounds(grid, hierarchy->GetCluster(grid, abstractCells[i]));
+            const GridBounds bounds = {std::min(boundsA.minCol, boundsB.minCol), std::min(boundsA.minRow, boundsB.minRow), std::max(boundsA.maxCol, boundsB.maxCol), std::max(boundsA.maxRow, boundsB.maxRow)};
+            if (!SearchCells(grid, abstractCells[i - 1], abstractCells[i], bounds, cells))
+            {
+                return nullptr;
+            }
+        }
+    }
+
+    // Back from the goal, keeping the cells where the direction changes
+    auto path = std::make_shared<Path>();
+    path->push_back(grid.GetCellCenter(goalCell));
+    int direction = 0;
+    for (size_t i = cells.size() - 1; i > 0; i--)
+    {
+        if (direction != 0 && cells[i] - cells[i - 1] != direction)
+        {
+            path->push_back(grid.GetCellCenter(cells[i]));
+        }
+        direction = cells[i] - cells[i - 1];
+    }
+    std::reverse(path->begin(), path->end());
+    return path;
+}
+
+bool Pathfinder::SearchCells(const NavigationGrid& grid, int startCell, int goalCell, const GridBounds& bounds, std::vector<int>& cells)
+{
+    if (startCell == goalCell)
+    {
+        return true;
+    }
+    const int numCols = grid.GetNumCols();
+    const int goalCol = goalCell % numCols;
+    const int goalRow = goalCell / numCols;
+
+    thread_local SearchScratch scratch;
+    if (static_cast<int>(scratch.stamps.size()) < grid.GetNumCells())
+    {
+        scratch.costs.resize(grid.GetNumCells());
+        scratch.parents.resize(grid.GetNumCells());
+        scratch.stamps.assign(grid.GetNumCells(), 0);
+        scratch.stamp = 0;
+    }
+    // On wrap around the old stamps could pass for the new search's
+    if (++scratch.stamp == 0)
+    {
+        std::fill(scratch.stamps.begin(), scratch.stamps.end(), 0);
+        scratch.stamp = 1;
+    }
+    const uint32_t stamp = scratch.stamp;
+    auto& open = scratch.open;
+    open.clear();
+    const auto isWorse = std::greater<std::pair<float, int>>();
+
+    // The start may be blocked, e.g. a unit pushed into the water, it drives out of it
+    scratch.stamps[startCell] = stamp;
+    scratch.costs[startCell] = 0.0f;
+    scratch.parents[startCell] = -1;
+    open.push_back({GetHeuristic(startCell % numCols, startCell / numCols, goalCol, goalRow), startCell});
+
+    int numExpansions = 0;
+    bool isFound = false;
+    while (!open.empty() && numExpansions < PATHFINDER_MAX_EXPANSIONS)
+    {
+        std::pop_heap(open.begin(), open.end(), isWorse);
+        const auto [estimate, cell] = open.back();
+        open.pop_back();
+        const int col = cell % numCols;
+        const int row = cell / numCols;
+        const float cost = scratch.costs[cell];
+        // Stale, the cell was reached cheaper since it was pushed
+        if (estimate > cost + GetHeuristic(col, row, goalCol, goalRow) + 1e-4f)
+        {
+            continue;
+        }
+        if (cell == goalCell)
+        {
+            isFound = true;
+            break;
+        }
+        numExpansions++;
+
+        for (int dy = -1; dy <= 1; dy++)
+        {
+            for (int dx = -1; dx <= 1; dx++)
+            {
+                if ((dx == 0 && dy == 0) || !bounds.Contains(col + dx, row + dy) || !grid.IsWalkable(col + dx, row + dy))
+                {
+                    continue;
+                }
+                // Diagonals only between two open cells, the units don't clip the corners
+                const bool isDiagonal = dx != 0 && dy != 0;
+                if (isDiagonal && (!grid.IsWalkable(col + dx, row) || !grid.IsWalkable(col, row + dy)))
+                {
+                    continue;
+                }
+                const int neighbor = (row + dy) * numCols + col + dx;
+                const float neighborCost = cost + (isDiagonal ? DIAGONAL_COST : 1.0f);
+                if (scratch.stamps[neighbor] == stamp && scratch.costs[neighbor] <= neighborCost)
+                {
+                    continue;
+                }
+                scratch.stamps[neighbor] = stamp;
+                scratch.costs[neighbor] = neighborCost;
+                scratch.parents[neighbor] = cell;
+                open.push_back({neighborCost + GetHeuristic(col + dx, row + dy, goalCol, goalRow), neighbor});
+                std::push_heap(open.begin(), open.end(), isWorse);
+            }
+        }
+    }
+    if (!isFound)
+    {
+        return false;
+    }
+
+    const size_t firstCell = cells.size();
+    for (int cell = goalCell; scratch.parents[cell] != -1; cell = scratch.parents[cell])
+    {
+        cells.push_back(cell);
+    }
+    std::reverse(cells.begin() + firstCell, cells.end());
+    return true;
+}
+
+PathfinderStats Pathfinder::GetStats() const
+{
+    PathfinderStats stats = this->stats;
+    stats.numQueued = queuedRequests.size();
+    return stats;
+}
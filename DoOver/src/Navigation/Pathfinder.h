@@ -0,0 +1,135 @@
+#ifndef PATHFINDER_H
+#define PATHFINDER_H
+
+#include "NavigationGrid.h"
+#include "NavigationHierarchy.h"
+#include "../Jobs/JobSystem.h"
+#include <glm/glm.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+typedef int PathRequestId;
+const PathRequestId INVALID_PATH_REQUEST = -1;
+
+// Searches started per tick, the requests past it wait for the next ticks
+const int PATHFINDER_REQUESTS_PER_TICK = 32;
+// Searches per job, a few per job so the small searches don't cost a job each
+const int PATHFINDER_REQUESTS_PER_JOB = 4;
+// Cells a search expands before it gives up, the bound on the cost of an unreachable goal
+const int PATHFINDER_MAX_EXPANSIONS = 1 << 16;
+// Paths kept by (start cell, goal cell), the cache is emptied when it fills up
+const size_t PATHFINDER_CACHE_CAPACITY = 1024;
+
+enum PathStatus
+{
+    PATH_STATUS_PENDING,
+    PATH_STATUS_FOUND,
+    PATH_STATUS_NOT_FOUND
+};
+
+// The waypoints in world pixels, the centers of the cells where the path turns, up to the
+// cell of the goal. The cell the path starts from isn't in it.
+typedef std::vector<glm::vec2> Path;
+
+struct PathfinderStats
+{
+    int numRequests;
+    int numCacheHits;
+    int numSearches;
+    int numQueued;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Pathfinder
+/////////////////////////////////////////////////////////////////////////////////////////////
+// A* over the navigation grid, 8-connected without cutting the corners of the blocked cells.
+// The requests are answered from a cache of the paths by (start cell, goal cell) when they
+// can, the others are searched on the job system: every Update collects the searches the
+// previous Update started, then starts up to PATHFINDER_REQUESTS_PER_TICK more. A request is
+// thus always answered at the same tick, whatever the workers' timing, and replays find the
+// same paths at the same time.
+// With a hierarchy, the searches between clusters go through its entrances and each leg is
+// searched inside its clusters only.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class Pathfinder
+{
+private:
+    struct Request
+    {
+        PathRequestId id;
+        int startCell;
+        int goalCell;
+    };
+
+    // Shared with the jobs searching it
+    struct Batch
+    {
+        std::shared_ptr<const NavigationGrid> grid;
+        std::shared_ptr<const NavigationHierarchy> hierarchy;
+        std::vector<Request> requests;
+        // [request] -> the path, null when there is none
+        std::vector<std::shared_ptr<const Path>> paths;
+        std::mutex mutex;
+        std::condition_variable jobsDone;
+        int numPendingJobs = 0;
+    };
+
+    struct Result
+    {
+        PathStatus status;
+        std::shared_ptr<const Path> path;
+    };
+
+    JobSystem& jobSystem;
+    std::shared_ptr<const NavigationGrid> grid;
+    std::shared_ptr<const NavigationHierarchy> hierarchy;
+    PathRequestId nextRequestId = 0;
+    std::deque<Request> queuedRequests;
+    std::shared_ptr<Batch> batch;
+    // [start cell << 32 | goal cell] -> the path, null when there is none
+    std::unordered_map<uint64_t, std::shared_ptr<const Path>> cache;
+    // [request] -> its result, pending until the search is collected
+    std::unordered_map<PathRequestId, Result> results;
+    PathfinderStats stats = {};
+
+    static uint64_t GetCacheKey(int startCell, int goalCell);
+    void CollectBatch();
+    void AddToCache(uint64_t key, std::shared_ptr<const Path> path);
+    void SetResult(PathRequestId id, const std::shared_ptr<const Path>& path);
+
+    // A* inside the bounds, appends the cells after the start up to the goal
+    static bool SearchCells(const NavigationGrid& grid, int startCell, int goalCell, const GridBounds& bounds, std::vector<int>& cells);
+
+public:
+    Pathfinder(JobSystem& jobSystem);
+    ~Pathfinder();
+
+    // The cached paths and the requests go with the previous grid. The hierarchy is optional,
+    // it must be built from the grid.
+    void SetGrid(std::shared_ptr<const NavigationGrid> grid, std::shared_ptr<const NavigationHierarchy> hierarchy = nullptr);
+    const NavigationGrid* GetGrid() const { return grid.get(); }
+
+    // Answered at once from the cache, or by a later Update
+    PathRequestId RequestPath(glm::vec2 start, glm::vec2 goal);
+    // Copies the path once found, the request is forgotten unless it is still pending
+    PathStatus TakePath(PathRequestId id, Path& path);
+    void CancelRequest(PathRequestId id);
+
+    // Collects the searches started by the last Update and starts the next ones, once per tick
+    void Update();
+    // Waits for the searches and forgets every request and cached path
+    void Clear();
+
+    // The search itself, null when the goal can't be reached
+    static std::shared_ptr<const Path> FindPath(const NavigationGrid& grid, int startCell, int goalCell, const NavigationHierarchy* hierarchy = nullptr);
+
+    PathfinderStats GetStats() const;
+};
+
+#endif
@@ -0,0 +1,239 @@
+#include "./NetworkClient.h"
+#include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
+#include <algorithm>
+#include <cstring>
+
+bool NetworkClient::Connect(const std::string& hostName, uint16_t port, int ticksPerSecond)
+{
+    if (!NetworkAddress::Resolve(hostName, port, serverAddress) || !socket.Open(0))
+    {
+        return false;
+    }
+    this->ticksPerSecond = ticksPerSecond;
+    receiveBuffer.resize(NETWORK_MAX_PACKET_SIZE);
+    snapshots.resize(NETWORK_SNAPSHOT_HISTORY);
+    snapshotSequences.assign(NETWORK_SNAPSHOT_HISTORY, 0);
+    LOGGER_INFO("Connecting to {}", serverAddress.ToString());
+    return true;
+}
+
+void NetworkClient::Disconnect()
+{
+    if (!socket.IsOpen())
+    {
+        return;
+    }
+    packet.clear();
+    SnapshotWriter writer(packet);
+    writer.WriteBytes(NETWORK_PROTOCOL_ID, sizeof(NETWORK_PROTOCOL_ID));
+    writer.WriteVarint(NETWORK_PACKET_DISCONNECT);
+    Send();
+    socket.Close();
+    isConnected = false;
+}
+
+void NetworkClient::AddActionPress(InputAction action)
+{
+    if (static_cast<int>(pendingPresses.size()) == NETWORK_MAX_PENDING_PRESSES)
+    {
+        pendingPresses.erase(pendingPresses.begin());
+        firstPressSequence++;
+    }
+    pendingPresses.push_back(action);
+}
+
+void NetworkClient::AckPresses(uint32_t pressSequence)
+{
+    if (pressSequence < firstPressSequence)
+    {
+        return;
+    }
+    const size_t numAcked = std::min(static_cast<size_t>(pressSequence - firstPressSequence + 1), pendingPresses.size());
+    pendingPresses.erase(pendingPresses.begin(), pendingPresses.begin() + numAcked);
+    firstPressSequence += numAcked;
+}
+
+void NetworkClient::Send()
+{
+    if (socket.Send(serverAddress, packet.data(), packet.size()))
+    {
+        numBytesSent += packet.size();
+    }
+}
+
+void NetworkClient::ReceiveSnapshotFragment(SnapshotReader& reader)
+{
+    const uint32_t sequence = reader.ReadVarint();
+    const uint32_t baselineSequence = reader.ReadVarint();
+    const uint32_t tick = reader.ReadVarint();
+    const uint32_t pressSequence = reader.ReadVarint();
+    const uint32_t inputTick = reader.ReadVarint();
+    const int fragment = reader.ReadCount(NETWORK_MAX_FRAGMENTS - 1);
+    const int numFragments = reader.ReadCount(NETWORK_MAX_FRAGMENTS);
+    const size_t fragmentSize = reader.GetNumRemainingBytes();
+    if (reader.HasFailed() || fragment >= numFragments || fragmentSize > static_cast<size_t>(NETWORK_FRAGMENT_SIZE) || sequence <= latestSequence)
+    {
+        return;
+    }
+    AckPresses(pressSequence);
+
+    if (sequence != assemblySequence)
+    {
+        if (sequence < assemblySequence)
+        {
+            return;
+        }
+        assemblySequence = sequence;
+        assemblyBaselineSequence = baselineSequence;
+        assemblyInputTick = inputTick;
+        numAssemblyFragments = numFragments;
+        numReceivedFragments = 0;
+        isFragmentReceived.assign(numFragments, false);
+        assemblyData.assign(numFragments * NETWORK_FRAGMENT_SIZE, 0);
+    }
+    if (numFragments != numAssemblyFragments || isFragmentReceived[fragment])
+    {
+        return;
+    }
+    // Only the last fragment may be short, it gives the size of the whole
+    if (fragment == numFragments - 1)
+    {
+        assemblyData.resize(fragment * NETWORK_FRAGMENT_SIZE + fragmentSize);
+    }
+    else if (fragmentSize != static_cast<size_t>(NETWORK_FRAGMENT_SIZE))
+    {
+        return;
+    }
+    reader.ReadBytes(assemblyData.data() + fragment * NETWORK_FRAGMENT_SIZE, fragmentSize);
+    isFragmentReceived[fragment] = true;
+    if (++numReceivedFragments < numFragments)
+    {
+        return;
+    }
+
+    Snapshot& snapshot = snapshots[sequence % NETWORK_SNAPSHOT_HISTORY];
+    if (assemblyBaselineSequence == 0)
+    {
+        // Kept as the baseline of later deltas, a corrupt one is dropped here
+        Snapshot received;
+        received.SetData(assemblyData.data(), assemblyData.size());
+        if (!received.IsValid())
+        {
+            return;
+        }
+        snapshot = std::move(received);
+    }
+    else
+    {
+        const int baselineSlot = assemblyBaselineSequence % NETWORK_SNAPSHOT_HISTORY;
+        if (snapshotSequences[baselineSlot] != assemblyBaselineSequence)
+        {
+            return;
+        }
+        SnapshotDelta delta;
+        delta.SetData(assemblyData.data(), assemblyData.size());
+        Snapshot decoded;
+        if (!delta.Decode(snapshots[baselineSlot], decoded))
+        {
+            return;
+        }
+        snapshot = std::move(decoded);
+    }
+    snapshotSequences[sequence % NETWORK_SNAPSHOT_HISTORY] = sequence;
+    latestSequence = sequence;
+    serverTick = tick;
+    ackedInputTick = assemblyInputTick;
+    hasNewSnapshot = true;
+}
+
+bool NetworkClient::Update(Registry& registry, const SDL_Rect& view, uint32_t tick)
+{
+    PROFILE_SCOPE("NetworkClient::Update");
+    if (!socket.IsOpen())
+    {
+        return false;
+    }
+
+    NetworkAddress address;
+    size_t size;
+    while ((size = socket.Receive(address, receiveBuffer.data(), receiveBuffer.size())) > 0)
+    {
+        numBytesReceived += size;
+        SnapshotReader reader(receiveBuffer.data(), size);
+        char protocolId[sizeof(NETWORK_PROTOCOL_ID)];
+        if (address != serverAddress || !reader.ReadBytes(protocolId, sizeof(protocolId)) || std::memcmp(protocolId, NETWORK_PROTOCOL_ID, sizeof(protocolId)) != 0)
+        {
+            continue;
+        }
+        lastReceivedTick = tick;
+        switch (reader.ReadVarint())
+        {
+        case NETWORK_PACKET_ACCEPT:
+            if (!isConnected)
+            {
+                clientId = reader.ReadVarint();
+                serverTicksPerSecond = reader.ReadVarint();
+                isConnected = !reader.HasFailed();
+                LOGGER_INFO("Connected to {} as client {}", serverAddress.ToString(), clientId);
+            }
+            break;
+        case NETWORK_PACKET_SNAPSHOT:
+            if (isConnected)
+            {
+                ReceiveSnapshotFragment(reader);
+            }
+            break;
+        case NETWORK_PACKET_DISCONNECT:
+            LOGGER_INFO("The server closed the connection");
+            socket.Close();
+            isConnected = false;
+            return false;
+        }
+    }
+
+    // The snapshots are only ever replaced whole, the state in between doesn't exist here
+    bool isLoaded = false;
+    if (hasNewSnapshot)
+    {
+        hasNewSnapshot = false;
+        isLoaded = snapshots[latestSequence % NETWORK_SNAPSHOT_HISTORY].Load(registry);
+    }
+
+    packet.clear();
+    SnapshotWriter writer(packet);
+    writer.WriteBytes(NETWORK_PROTOCOL_ID, sizeof(NETWORK_PROTOCOL_ID));
+    if (!isConnected)
+    {
+        if (lastConnectTick == 0 || tick - lastConnectTick >= NETWORK_CONNECT_RETRY_SECONDS * ticksPerSecond)
+        {
+            lastConnectTick = std::max(tick, 1u);
+            lastReceivedTick = tick;
+            writer.WriteVarint(NETWORK_PACKET_CONNECT);
+            Send();
+        }
+        return isLoaded;
+    }
+    if (tick - lastReceivedTick > NETWORK_TIMEOUT_SECONDS * ticksPerSecond)
+    {
+        LOGGER_INFO("The connection to {} timed out", serverAddress.ToString());
+        socket.Close();
+        isConnected = false;
+        return isLoaded;
+    }
+    writer.WriteVarint(NETWORK_PACKET_INPUT);
+    writer.WriteVarint(tick);
+    writer.WriteVarint(latestSequence);
+    writer.WriteSignedVarint(view.x);
+    writer.WriteSignedVarint(view.y);
+    writer.WriteVarint(view.w);
+    writer.WriteVarint(view.h);
+    writer.WriteVarint(firstPressSequence);
+    writer.WriteVarint(pendingPresses.size());
+    for (auto action: pendingPresses)
+    {
+        writer.WriteVarint(action);
+    }
+    Send();
+    return isLoaded;
+}
@@ -0,0 +1,88 @@
+#ifndef NETWORKCLIENT_H
+#define NETWORKCLIENT_H
+
+#include "NetworkProtocol.h"
+#include "NetworkSocket.h"
+#include "../ECS/ECS.h"
+#include "../Snapshot/Snapshot.h"
+#include "../Input/InputState.h"
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Network client
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Connects to a server, see NetworkProtocol.h, and mirrors its state: the registry is
+// replaced with the last snapshot received, the client doesn't run the simulation itself
+// beyond the prediction of its own entities (see NetworkPrediction). The actions pressed are
+// sent to the server, along with the view the server culls against.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class NetworkClient
+{
+private:
+    NetworkSocket socket;
+    NetworkAddress serverAddress;
+    bool isConnected = false;
+    int clientId = 0;
+    // The client's own tick rate, for the timeouts
+    int ticksPerSecond = 0;
+    int serverTicksPerSecond = 0;
+    uint32_t lastReceivedTick = 0;
+    uint32_t lastConnectTick = 0;
+
+    // The fragments of the snapshot being received, a newer one drops it
+    uint32_t assemblySequence = 0;
+    uint32_t assemblyBaselineSequence = 0;
+    uint32_t assemblyInputTick = 0;
+    int numAssemblyFragments = 0;
+    int numReceivedFragments = 0;
+    std::vector<bool> isFragmentReceived;
+    std::vector<uint8_t> assemblyData;
+
+    // [sequence % NETWORK_SNAPSHOT_HISTORY] -> snapshot received, the baselines of the deltas
+    std::vector<Snapshot> snapshots;
+    std::vector<uint32_t> snapshotSequences;
+    uint32_t latestSequence = 0;
+    uint32_t serverTick = 0;
+    uint32_t ackedInputTick = 0;
+    bool hasNewSnapshot = false;
+
+    // Presses not acked by the server yet, the first one has the sequence firstPressSequence
+    std::vector<InputAction> pendingPresses;
+    uint32_t firstPressSequence = 1;
+
+    std::vector<uint8_t> packet;
+    std::vector<uint8_t> receiveBuffer;
+    uint64_t numBytesSent = 0;
+    uint64_t numBytesReceived = 0;
+
+    void Send();
+    void ReceiveSnapshotFragment(SnapshotReader& reader);
+    void AckPresses(uint32_t pressSequence);
+
+public:
+    NetworkClient() = default;
+
+    bool Connect(const std::string& hostName, uint16_t port, int ticksPerSecond);
+    void Disconnect();
+    bool IsConnected() const { return isConnected; }
+
+    // Sent to the server with the next input
+    void AddActionPress(InputAction action);
+
+    // Once a tick: receives the packets, loads the last complete snapshot into the registry
+    // and sends the input with the view. Returns true when a snapshot was loaded.
+    bool Update(Registry& registry, const SDL_Rect& view, uint32_t tick);
+
+    // The tick of the server the registry shows
+    uint32_t GetServerTick() const { return serverTick; }
+    // The tick of the last input of this client the registry shows the effects of
+    uint32_t GetAckedInputTick() const { return ackedInputTick; }
+    int GetServerTicksPerSecond() const { return serverTicksPerSecond; }
+    uint64_t GetNumBytesSent() const { return numBytesSent; }
+    uint64_t GetNumBytesReceived() const { return numBytesReceived; }
+};
+
+#endif
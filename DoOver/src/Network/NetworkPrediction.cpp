@@ -0,0 +1,215 @@
+#include "./NetworkPrediction.h"
+#include "../Profiler/Profiler.h"
+#include "../Components/TransformComponent.h"
+#include "../Systems/MovementSystem.h"
+#include "../Systems/CollisonSystem.h"
+#include "../Systems/KeyboardControlSystem.h"
+#include <algorithm>
+#include <cmath>
+
+NetworkPrediction::NetworkPrediction()
+{
+    frames.resize(NETWORK_INTERPOLATION_FRAMES);
+}
+
+void NetworkPrediction::AddActionPresses(InputActions actions, uint32_t tick)
+{
+    if (actions.any())
+    {
+        presses.push_back({tick, actions});
+    }
+}
+
+void NetworkPrediction::AddFrame(Registry& registry, uint32_t serverTick)
+{
+    // A server restarted goes back in time, the frames of the old one are dropped
+    if (numFrames > 0 && serverTick <= frames[newestFrame].serverTick)
+    {
+        numFrames = 0;
+    }
+    newestFrame = (newestFrame + 1) % NETWORK_INTERPOLATION_FRAMES;
+    numFrames = std::min(numFrames + 1, NETWORK_INTERPOLATION_FRAMES);
+    InterpolationFrame& frame = frames[newestFrame];
+    frame.serverTick = serverTick;
+    frame.isEntityPresent.assign(registry.GetNumEntityIds(), false);
+    frame.handles.resize(registry.GetNumEntityIds());
+    frame.positions.resize(registry.GetNumEntityIds());
+    registry.View<TransformComponent>().Each([&frame](Entity entity, TransformComponent& transform)
+    {
+        frame.isEntityPresent[entity.GetId()] = true;
+        frame.handles[entity.GetId()] = entity.GetHandle();
+        frame.positions[entity.GetId()] = transform.position;
+    });
+}
+
+void NetworkPrediction::Step(Registry& registry, uint32_t tick, double deltaTime)
+{
+    for (const auto& press: presses)
+    {
+        if (press.tick != tick)
+        {
+            continue;
+        }
+        for (auto entity: predictedEntities)
+        {
+            for (int action = 0; action < INPUT_ACTION_COUNT; action++)
+            {
+                if (press.actions[action])
+                {
+                    KeyboardControlSystem::ApplyAction(entity, static_cast<InputAction>(action));
+                }
+            }
+        }
+    }
+    registry.GetSystem<MovementSystem>().Update(predictedEntities, deltaTime);
+
+    // A contact is new when the predicted entity wasn't touching on the last tick shown,
+    // the ticks re-simulated report the ones the correction brought
+    auto& collisionSystem = registry.GetSystem<CollisionSystem>();
+    predictedCollisions.clear();
+    for (auto entity: predictedEntities)
+    {
+        if (!collisionSystem.HasEntity(entity))
+        {
+            continue;
+        }
+        contacts.clear();
+        collisionSystem.FindCollisions(entity, contacts);
+        for (auto other: contacts)
+        {
+            const std::pair<Entity, Entity> collision(entity, other);
+            predictedCollisions.push_back(collision);
+            if (std::find(previousCollisions.begin(), previousCollisions.end(), collision) == previousCollisions.end()
+                && std::find(enteredCollisions.begin(), enteredCollisions.end(), collision) == enteredCollisions.end())
+            {
+                enteredCollisions.push_back(collision);
+            }
+        }
+    }
+}
+
+bool NetworkPrediction::FindFrames(double serverTick, int& from, int& to, float& alpha) const
+{
+    if (numFrames == 0)
+    {
+        return false;
+    }
+    from = newestFrame;
+    to = newestFrame;
+    alpha = 0.0f;
+    if (serverTick >= frames[newestFrame].serverTick)
+    {
+        return true;
+    }
+    for (int i = 1; i < numFrames; i++)
+    {
+        from = (newestFrame - i + NETWORK_INTERPOLATION_FRAMES) % NETWORK_INTERPOLATION_FRAMES;
+        if (frames[from].serverTick <= serverTick)
+        {
+            alpha = static_cast<float>((serverTick - frames[from].serverTick) / (frames[to].serverTick - frames[from].serverTick));
+            return true;
+        }
+        to = from;
+    }
+    // Older than the whole buffer, the oldest frame is held
+    from = to;
+    return true;
+}
+
+void NetworkPrediction::Interpolate(Registry& registry, double serverTicksPerTick)
+{
+    if (numFrames == 0)
+    {
+        return;
+    }
+
+    // The clock runs at the server's rate and is pulled gently towards the delay behind the
+    // newest snapshot, so the jitter of their arrival doesn't show. Too far off, it jumps.
+    const double targetTick = static_cast<double>(frames[newestFrame].serverTick) - NETWORK_INTERPOLATION_DELAY_TICKS;
+    renderTick += serverTicksPerTick;
+    if (std::abs(targetTick - renderTick) > NETWORK_INTERPOLATION_DELAY_TICKS)
+    {
+        renderTick = targetTick;
+    }
+    else
+    {
+        renderTick += (targetTick - renderTick) * NETWORK_INTERPOLATION_CORRECTION;
+    }
+
+    // The previous position too, the render system blends the two with the frame's fraction
+    int from, to, previousFrom, previousTo;
+    float alpha, previousAlpha;
+    FindFrames(renderTick, from, to, alpha);
+    FindFrames(renderTick - serverTicksPerTick, previousFrom, previousTo, previousAlpha);
+    auto sample = [this](Entity entity, int from, int to, float alpha, glm::vec2& position)
+    {
+        const int entityId = entity.GetId();
+        auto isInFrame = [entityId, entity](const InterpolationFrame& frame)
+        {
+            return entityId < static_cast<int>(frame.isEntityPresent.size()) && frame.isEntityPresent[entityId] && frame.handles[entityId] == entity.GetHandle();
+        };
+        const bool isInFrom = isInFrame(frames[from]);
+        const bool isInTo = isInFrame(frames[to]);
+        if (isInFrom && isInTo)
+        {
+            position = glm::mix(frames[from].positions[entityId], frames[to].positions[entityId], alpha);
+        }
+        else if (isInFrom || isInTo)
+        {
+            position = frames[isInTo ? to : from].positions[entityId];
+        }
+    };
+    registry.View<TransformComponent>().Each([&](Entity entity, TransformComponent& transform)
+    {
+        if (entity.HasComponent<KeyboardControlledComponent>())
+        {
+            return;
+        }
+        sample(entity, previousFrom, previousTo, previousAlpha, transform.previousPosition);
+        sample(entity, from, to, alpha, transform.position);
+    });
+}
+
+void NetworkPrediction::Update(Registry& registry, const NetworkClient& client, bool isSnapshotLoaded, uint32_t tick, double deltaTime)
+{
+    PROFILE_SCOPE("NetworkPrediction::Update");
+    enteredCollisions.clear();
+
+    // The keyboard controlled entities that move, the client only ever moves its own chopper
+    predictedEntities.clear();
+    const auto& movementSystem = registry.GetSystem<MovementSystem>();
+    for (auto entity: registry.GetSystem<KeyboardControlSystem>().GetSystemEntities())
+    {
+        if (movementSystem.HasEntity(entity))
+        {
+            predictedEntities.push_back(entity);
+        }
+    }
+
+    // The snapshot has the effects of the presses up to the last input the server got, the
+    // ones pressed since are replayed on the ticks they were pressed
+    uint32_t firstTick = tick;
+    if (isSnapshotLoaded)
+    {
+        AddFrame(registry, client.GetServerTick());
+        const uint32_t ackedInputTick = client.GetAckedInputTick();
+        presses.erase(std::remove_if(presses.begin(), presses.end(), [ackedInputTick](const PredictedPress& press) { return press.tick <= ackedInputTick; }), presses.end());
+        const uint32_t oldestTick = tick >= static_cast<uint32_t>(NETWORK_MAX_PREDICTION_TICKS) ? tick - NETWORK_MAX_PREDICTION_TICKS + 1 : 0;
+        firstTick = std::min(std::max(ackedInputTick + 1, oldestTick), tick);
+        numReplayedTicks = tick - firstTick;
+    }
+    if (!predictedEntities.empty())
+    {
+        registry.GetSystem<CollisionSystem>().UpdateStaticColliders(registry);
+        for (uint32_t stepTick = firstTick; stepTick <= tick; stepTick++)
+        {
+            Step(registry, stepTick, deltaTime);
+        }
+        previousCollisions = predictedCollisions;
+    }
+
+    // Without an ack for that long, the presses are past what a correction replays
+    presses.erase(std::remove_if(presses.begin(), presses.end(), [tick](const PredictedPress& press) { return press.tick + NETWORK_MAX_PREDICTION_TICKS <= tick; }), presses.end());
+
+    Interpolate(registry, client.GetServerTicksPerSecond() * deltaTime);
+}
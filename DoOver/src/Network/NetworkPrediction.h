@@ -0,0 +1,83 @@
+#ifndef NETWORKPREDICTION_H
+#define NETWORKPREDICTION_H
+
+#include "NetworkProtocol.h"
+#include "NetworkClient.h"
+#include "../ECS/ECS.h"
+#include "../Input/InputState.h"
+#include <SDL2/SDL.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Network prediction
+/////////////////////////////////////////////////////////////////////////////////////////////
+// What a network client shows between the snapshots. The local entities (the keyboard
+// controlled ones) are predicted: the actions move them on the tick they are pressed, and each
+// snapshot loaded puts them back where the server had them after the last input it got,
+// then re-runs the movement and the collisions of those entities alone over the ticks the
+// server hasn't seen yet. The remote entities are interpolated between the snapshots kept
+// in a jitter buffer, a little in the past so a late snapshot doesn't stall them.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class NetworkPrediction
+{
+private:
+    struct PredictedPress
+    {
+        uint32_t tick;
+        InputActions actions;
+    };
+
+    // The positions of a snapshot, by entity id
+    struct InterpolationFrame
+    {
+        uint32_t serverTick = 0;
+        std::vector<bool> isEntityPresent;
+        std::vector<uint32_t> handles;
+        std::vector<glm::vec2> positions;
+    };
+
+    // Actions pressed on the ticks the server may not have seen yet, oldest first
+    std::vector<PredictedPress> presses;
+    std::vector<Entity> predictedEntities;
+    std::vector<Entity> contacts;
+    // The contacts of the predicted entities on the last tick, and the new ones since
+    std::vector<std::pair<Entity, Entity>> predictedCollisions;
+    std::vector<std::pair<Entity, Entity>> previousCollisions;
+    std::vector<std::pair<Entity, Entity>> enteredCollisions;
+    int numReplayedTicks = 0;
+
+    // Ring of the last snapshots, newestFrame is the one loaded last
+    std::vector<InterpolationFrame> frames;
+    int numFrames = 0;
+    int newestFrame = -1;
+    // The server tick the remote entities are shown at
+    double renderTick = 0.0;
+
+    void AddFrame(Registry& registry, uint32_t serverTick);
+    void Step(Registry& registry, uint32_t tick, double deltaTime);
+    // The two frames around the server tick and how far it is between them, false when the
+    // buffer is empty. Past the newest frame, both are the newest one.
+    bool FindFrames(double serverTick, int& from, int& to, float& alpha) const;
+    void Interpolate(Registry& registry, double ticksPerServerTick);
+
+public:
+    NetworkPrediction();
+
+    // The actions pressed on the tick, before the update of that tick
+    void AddActionPresses(InputActions actions, uint32_t tick);
+
+    // Once a tick after NetworkClient::Update, with what it returned. Steps the predicted
+    // entities, from the snapshot of the server when one was loaded, and interpolates the
+    // others.
+    void Update(Registry& registry, const NetworkClient& client, bool isSnapshotLoaded, uint32_t tick, double deltaTime);
+
+    // The predicted entities started colliding with these since the last update
+    const std::vector<std::pair<Entity, Entity>>& GetEnteredCollisions() const { return enteredCollisions; }
+    // Re-simulated on the last snapshot loaded
+    int GetNumReplayedTicks() const { return numReplayedTicks; }
+};
+
+#endif
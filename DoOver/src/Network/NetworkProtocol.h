@@ -0,0 +1,69 @@
+#ifndef NETWORKPROTOCOL_H
+#define NETWORKPROTOCOL_H
+
+#include <cstdint>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Network protocol
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The server runs the simulation, the clients send their input and show the state the
+// server sends back. Every datagram starts with the protocol id and the packet type, the
+// rest is written with the snapshot streams:
+//   CONNECT     client -> server, resent until accepted
+//   ACCEPT      server -> client | client id | ticks per second
+//   INPUT       client -> server | client tick | acked snapshot | view x, y, width, height |
+//               first press sequence | actions pressed (see InputAction). Each tick, the
+//               presses are resent until the server acks them.
+//   SNAPSHOT    server -> client | sequence | baseline sequence, 0 for a full snapshot |
+//               tick | acked press sequence | client tick of the last input | fragment index |
+//               fragment count | fragment
+//   DISCONNECT  either way
+// A snapshot is a delta against the last one the client acked, split into fragments that
+// fit a datagram. A lost fragment loses its snapshot, the next one goes against an older
+// baseline until the client acks again.
+/////////////////////////////////////////////////////////////////////////////////////////////
+const char NETWORK_PROTOCOL_ID[4] = {'D', 'O', 'N', 'P'};
+
+enum NetworkPacketType: uint8_t
+{
+    NETWORK_PACKET_CONNECT = 1,
+    NETWORK_PACKET_ACCEPT,
+    NETWORK_PACKET_INPUT,
+    NETWORK_PACKET_SNAPSHOT,
+    NETWORK_PACKET_DISCONNECT
+};
+
+const uint16_t NETWORK_DEFAULT_PORT = 27015;
+// Bytes of snapshot per datagram, under the usual MTU with the headers
+const int NETWORK_FRAGMENT_SIZE = 1024;
+const int NETWORK_MAX_FRAGMENTS = 1024;
+const int NETWORK_MAX_PACKET_SIZE = 1500;
+const int NETWORK_MAX_CLIENTS = 64;
+// Snapshots kept per client as the baselines of the next deltas
+const int NETWORK_SNAPSHOT_HISTORY = 32;
+// A snapshot every few ticks, 30 per second at the default tick rate
+const int NETWORK_SNAPSHOT_INTERVAL_TICKS = 4;
+// Presses resent per input packet, the older ones are dropped if the server never acks them
+const int NETWORK_MAX_PENDING_PRESSES = 32;
+const double NETWORK_TIMEOUT_SECONDS = 5.0;
+const double NETWORK_CONNECT_RETRY_SECONDS = 0.5;
+const double NETWORK_STATS_INTERVAL_SECONDS = 5.0;
+// The remote entities are shown this many server ticks in the past, between two snapshots
+// even when one of them is late or lost
+const int NETWORK_INTERPOLATION_DELAY_TICKS = 3 * NETWORK_SNAPSHOT_INTERVAL_TICKS;
+const int NETWORK_INTERPOLATION_FRAMES = 16;
+// Fraction of the drift from the snapshots the interpolation clock makes up each tick
+const double NETWORK_INTERPOLATION_CORRECTION = 0.05;
+// Client ticks re-simulated at most when a snapshot corrects the prediction
+const int NETWORK_MAX_PREDICTION_TICKS = 60;
+
+// The part of the world a client shows, the server only sends what is in or near it
+struct NetworkView
+{
+    int32_t x = 0;
+    int32_t y = 0;
+    int32_t width = 0;
+    int32_t height = 0;
+};
+
+#endif
@@ -0,0 +1,272 @@
+#include "./NetworkServer.h"
+#include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cstring>
+
+bool NetworkServer::Start(uint16_t port, int ticksPerSecond)
+{
+    if (!socket.Open(port))
+    {
+        return false;
+    }
+    this->ticksPerSecond = ticksPerSecond;
+    receiveBuffer.resize(NETWORK_MAX_PACKET_SIZE);
+    LOGGER_INFO("Server listening on port {}", port);
+    return true;
+}
+
+void NetworkServer::Stop()
+{
+    if (!socket.IsOpen())
+    {
+        return;
+    }
+    for (const auto& client: clients)
+    {
+        packet.clear();
+        SnapshotWriter writer(packet);
+        writer.WriteBytes(NETWORK_PROTOCOL_ID, sizeof(NETWORK_PROTOCOL_ID));
+        writer.WriteVarint(NETWORK_PACKET_DISCONNECT);
+        Send(client.address);
+    }
+    clients.clear();
+    socket.Close();
+}
+
+NetworkServer::ClientConnection* NetworkServer::FindClient(const NetworkAddress& address)
+{
+    for (auto& client: clients)
+    {
+        if (client.address == address)
+        {
+            return &client;
+        }
+    }
+    return nullptr;
+}
+
+void NetworkServer::Send(const NetworkAddress& address)
+{
+    if (socket.Send(address, packet.data(), packet.size()))
+    {
+        stats.numBytesSent += packet.size();
+    }
+}
+
+void NetworkServer::ReceivePackets(InputState& inputState, uint32_t tick)
+{
+    PROFILE_SCOPE("NetworkServer::ReceivePackets");
+    NetworkAddress address;
+    size_t size;
+    while ((size = socket.Receive(address, receiveBuffer.data(), receiveBuffer.size())) > 0)
+    {
+        stats.numBytesReceived += size;
+        SnapshotReader reader(receiveBuffer.data(), size);
+        char protocolId[sizeof(NETWORK_PROTOCOL_ID)];
+        if (!reader.ReadBytes(protocolId, sizeof(protocolId)) || std::memcmp(protocolId, NETWORK_PROTOCOL_ID, sizeof(protocolId)) != 0)
+        {
+            continue;
+        }
+        const uint64_t type = reader.ReadVarint();
+        ClientConnection* client = FindClient(address);
+
+        if (type == NETWORK_PACKET_CONNECT)
+        {
+            if (!client)
+            {
+                if (static_cast<int>(clients.size()) == NETWORK_MAX_CLIENTS)
+                {
+                    continue;
+                }
+                clients.emplace_back();
+                client = &clients.back();
+                client->address = address;
+                client->clientId = nextClientId++;
+                if (freeObserverIds.empty())
+                {
+                    client->observerId = clients.size() - 1;
+                }
+                else
+                {
+                    client->observerId = freeObserverIds.back();
+                    freeObserverIds.pop_back();
+                }
+                client->sentSnapshots.resize(NETWORK_SNAPSHOT_HISTORY);
+                client->sentSequences.assign(NETWORK_SNAPSHOT_HISTORY, 0);
+                LOGGER_INFO("Client {} connected from {}", client->clientId, address.ToString());
+            }
+            // Accepted again if the first answer was lost
+            client->lastReceivedTick = tick;
+            packet.clear();
+            SnapshotWriter writer(packet);
+            writer.WriteBytes(NETWORK_PROTOCOL_ID, sizeof(NETWORK_PROTOCOL_ID));
+            writer.WriteVarint(NETWORK_PACKET_ACCEPT);
+            writer.WriteVarint(client->clientId);
+            writer.WriteVarint(ticksPerSecond);
+            Send(address);
+            continue;
+        }
+        if (!client)
+        {
+            continue;
+        }
+        if (type == NETWORK_PACKET_DISCONNECT)
+        {
+            LOGGER_INFO("Client {} disconnected", client->clientId);
+            RemoveClient(*client);
+            clients.erase(clients.begin() + (client - clients.data()));
+            continue;
+        }
+        if (type != NETWORK_PACKET_INPUT)
+        {
+            continue;
+        }
+
+        const uint32_t inputTick = reader.ReadVarint();
+        const uint32_t ackedSequence = reader.ReadVarint();
+        NetworkView view;
+        view.x = reader.ReadSignedVarint();
+        view.y = reader.ReadSignedVarint();
+        view.width = reader.ReadCount(UINT16_MAX);
+        view.height = reader.ReadCount(UINT16_MAX);
+        uint32_t pressSequence = reader.ReadVarint();
+        const int numPresses = reader.ReadCount(NETWORK_MAX_PENDING_PRESSES);
+        if (reader.HasFailed())
+        {
+            continue;
+        }
+        client->lastReceivedTick = tick;
+        // The packets may come out of order, an older ack doesn't replace a newer one
+        if (ackedSequence > client->ackedSequence && ackedSequence < client->nextSequence)
+        {
+            client->ackedSequence = ackedSequence;
+        }
+        if (inputTick > client->lastInputTick)
+        {
+            client->lastInputTick = inputTick;
+            client->view = view;
+        }
+        // The presses were resent until acked, the ones handled already are skipped
+        for (int i = 0; i < numPresses; i++, pressSequence++)
+        {
+            const int action = reader.ReadCount(INPUT_ACTION_COUNT - 1);
+            if (reader.HasFailed())
+            {
+                break;
+            }
+            if (pressSequence > client->lastPressSequence)
+            {
+                client->lastPressSequence = pressSequence;
+                inputState.PressActions(InputActions().set(action));
+            }
+        }
+    }
+
+    const uint32_t timeoutTicks = NETWORK_TIMEOUT_SECONDS * ticksPerSecond;
+    clients.erase(std::remove_if(clients.begin(), clients.end(), [this, tick, timeoutTicks](const ClientConnection& client)
+    {
+        if (tick - client.lastReceivedTick <= timeoutTicks)
+        {
+            return false;
+        }
+        LOGGER_INFO("Client {} timed out", client.clientId);
+        RemoveClient(client);
+        return true;
+    }), clients.end());
+}
+
+void NetworkServer::RemoveClient(const ClientConnection& client)
+{
+    freeObserverIds.push_back(client.observerId);
+    removedObserverIds.push_back(client.observerId);
+}
+
+void NetworkServer::SendSnapshots(Registry& registry, InterestSystem& interestSystem, uint32_t tick)
+{
+    PROFILE_SCOPE("NetworkServer::SendSnapshots");
+    const Uint64 performanceCounterStart = SDL_GetPerformanceCounter();
+    for (auto observerId: removedObserverIds)
+    {
+        interestSystem.RemoveObserver(observerId);
+    }
+    removedObserverIds.clear();
+    for (auto& client: clients)
+    {
+        SendSnapshot(registry, interestSystem, client, tick);
+    }
+    stats.encodeMillisecs += (SDL_GetPerformanceCounter() - performanceCounterStart) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+void NetworkServer::SendSnapshot(Registry& registry, InterestSystem& interestSystem, ClientConnection& client, uint32_t tick)
+{
+    interestSystem.SetObserverView(client.observerId, {client.view.x, client.view.y, client.view.width, client.view.height});
+    stats.numInterestChanges += interestSystem.GetEnteredEntities(client.observerId).size() + interestSystem.GetLeftEntities(client.observerId).size();
+    interestSystem.ClearObserverChanges(client.observerId);
+    Snapshot snapshot;
+    if (!snapshot.Save(registry, &interestSystem.GetVisibleEntities(client.observerId)))
+    {
+        return;
+    }
+
+    // Against the last snapshot the client acked, in full when it is too old or there is none.
+    // The snapshot about to replace a baseline in the history is never the acked one.
+    const uint32_t sequence = client.nextSequence++;
+    const uint32_t baselineSequence = client.ackedSequence;
+    const int baselineSlot = baselineSequence % NETWORK_SNAPSHOT_HISTORY;
+    SnapshotDelta delta;
+    const bool hasBaseline = baselineSequence != 0 && sequence - baselineSequence < static_cast<uint32_t>(NETWORK_SNAPSHOT_HISTORY)
+        && client.sentSequences[baselineSlot] == baselineSequence;
+    const bool isDelta = hasBaseline && delta.Encode(client.sentSnapshots[baselineSlot], snapshot);
+    const std::vector<uint8_t>& payload = isDelta ? delta.GetData() : snapshot.GetData();
+    const int numFragments = (payload.size() + NETWORK_FRAGMENT_SIZE - 1) / NETWORK_FRAGMENT_SIZE;
+    if (numFragments > NETWORK_MAX_FRAGMENTS)
+    {
+        LOGGER_ERROR("The snapshot of client {} is too large to send, {} bytes", client.clientId, payload.size());
+        return;
+    }
+    stats.numSnapshots++;
+    stats.numSnapshotBytes += payload.size();
+    stats.numFullSnapshotBytes += snapshot.GetSize();
+
+    for (int fragment = 0; fragment < numFragments; fragment++)
+    {
+        const size_t offset = fragment * NETWORK_FRAGMENT_SIZE;
+        const size_t fragmentSize = std::min(payload.size() - offset, static_cast<size_t>(NETWORK_FRAGMENT_SIZE));
+        packet.clear();
+        SnapshotWriter writer(packet);
+        writer.WriteBytes(NETWORK_PROTOCOL_ID, sizeof(NETWORK_PROTOCOL_ID));
+        writer.WriteVarint(NETWORK_PACKET_SNAPSHOT);
+        writer.WriteVarint(sequence);
+        writer.WriteVarint(isDelta ? baselineSequence : 0);
+        writer.WriteVarint(tick);
+        writer.WriteVarint(client.lastPressSequence);
+        writer.WriteVarint(client.lastInputTick);
+        writer.WriteVarint(fragment);
+        writer.WriteVarint(numFragments);
+        writer.WriteBytes(payload.data() + offset, fragmentSize);
+        Send(client.address);
+    }
+
+    const int slot = sequence % NETWORK_SNAPSHOT_HISTORY;
+    client.sentSnapshots[slot] = std::move(snapshot);
+    client.sentSequences[slot] = sequence;
+}
+
+void NetworkServer::EndTick(double tickMillisecs)
+{
+    stats.tickMillisecs += tickMillisecs;
+    stats.numTicks++;
+    if (stats.numTicks < NETWORK_STATS_INTERVAL_SECONDS * ticksPerSecond)
+    {
+        return;
+    }
+    const double seconds = static_cast<double>(stats.numTicks) / ticksPerSecond;
+    const int numSnapshots = std::max(stats.numSnapshots, 1);
+    LOGGER_INFO("Server: {} clients, {} KB/s out, {} KB/s in, {} bytes per snapshot ({} in full), {} interest changes, {} ms encoding and {} ms per tick",
+        clients.size(), stats.numBytesSent / 1024.0 / seconds, stats.numBytesReceived / 1024.0 / seconds,
+        stats.numSnapshotBytes / numSnapshots, stats.numFullSnapshotBytes / numSnapshots, stats.numInterestChanges,
+        stats.encodeMillisecs / stats.numTicks, stats.tickMillisecs / stats.numTicks);
+    stats = NetworkServerStats();
+}
@@ -0,0 +1,95 @@
+#ifndef NETWORKSERVER_H
+#define NETWORKSERVER_H
+
+#include "NetworkProtocol.h"
+#include "NetworkSocket.h"
+#include "../ECS/ECS.h"
+#include "../Input/InputState.h"
+#include "../Snapshot/Snapshot.h"
+#include "../Systems/InterestSystem.h"
+#include <cstdint>
+#include <vector>
+
+// Counted since the last report, see NetworkServer::EndTick
+struct NetworkServerStats
+{
+    uint64_t numBytesSent = 0;
+    uint64_t numBytesReceived = 0;
+    int numSnapshots = 0;
+    // The snapshots as sent, and as they would be in full without the deltas
+    uint64_t numSnapshotBytes = 0;
+    uint64_t numFullSnapshotBytes = 0;
+    // Entities that entered or left the clients' areas of interest
+    uint64_t numInterestChanges = 0;
+    double encodeMillisecs = 0.0;
+    double tickMillisecs = 0.0;
+    int numTicks = 0;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Network server
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Runs next to the authoritative simulation, see NetworkProtocol.h. The actions the
+// clients press are pressed on the game's input state for the next tick, and every few ticks each
+// client gets the entities in its area of interest (see InterestSystem) as a delta against
+// the last snapshot it acknowledged.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class NetworkServer
+{
+private:
+    struct ClientConnection
+    {
+        NetworkAddress address;
+        int clientId = 0;
+        // Slot of the client in the interest system, reused after it leaves
+        int observerId = 0;
+        uint32_t lastReceivedTick = 0;
+        NetworkView view;
+        uint32_t nextSequence = 1;
+        uint32_t ackedSequence = 0;
+        uint32_t lastPressSequence = 0;
+        // Client tick of the last input, the prediction of the client re-simulates from it
+        uint32_t lastInputTick = 0;
+        // [sequence % NETWORK_SNAPSHOT_HISTORY] -> snapshot sent, the baselines of the deltas
+        std::vector<Snapshot> sentSnapshots;
+        std::vector<uint32_t> sentSequences;
+    };
+
+    NetworkSocket socket;
+    std::vector<ClientConnection> clients;
+    int nextClientId = 1;
+    // The observers of the clients gone, removed from the interest system with the next snapshots
+    std::vector<int> freeObserverIds;
+    std::vector<int> removedObserverIds;
+    int ticksPerSecond = 0;
+    NetworkServerStats stats;
+    std::vector<uint8_t> packet;
+    std::vector<uint8_t> receiveBuffer;
+
+    ClientConnection* FindClient(const NetworkAddress& address);
+    void RemoveClient(const ClientConnection& client);
+    void Send(const NetworkAddress& address);
+    void SendSnapshot(Registry& registry, InterestSystem& interestSystem, ClientConnection& client, uint32_t tick);
+
+public:
+    NetworkServer() = default;
+
+    bool Start(uint16_t port, int ticksPerSecond);
+    // Tells the clients the server is going away
+    void Stop();
+    bool IsRunning() const { return socket.IsOpen(); }
+
+    // Handles the connections and the inputs received since the last call, the clients
+    // silent for too long are dropped
+    void ReceivePackets(InputState& inputState, uint32_t tick);
+    // Sends each client the entities in its area of interest, the commands of the registry
+    // must all be applied. The entities without a position are never sent.
+    void SendSnapshots(Registry& registry, InterestSystem& interestSystem, uint32_t tick);
+    // Counts the time the tick took and logs the bandwidth and the tick times now and then
+    void EndTick(double tickMillisecs);
+
+    int GetNumClients() const { return clients.size(); }
+    const NetworkServerStats& GetStats() const { return stats; }
+};
+
+#endif
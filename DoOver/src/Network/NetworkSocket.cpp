@@ -0,0 +1,97 @@
+#include "./NetworkSocket.h"
+#include "../Logger/Logger.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstring>
+
+std::string NetworkAddress::ToString() const
+{
+    return std::to_string((host >> 24) & 0xFF) + "." + std::to_string((host >> 16) & 0xFF) + "." + std::to_string((host >> 8) & 0xFF) + "."
+        + std::to_string(host & 0xFF) + ":" + std::to_string(port);
+}
+
+bool NetworkAddress::Resolve(const std::string& hostName, uint16_t port, NetworkAddress& address)
+{
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(hostName.c_str(), nullptr, &hints, &result) != 0 || !result)
+    {
+        Logger::Err("Unable to resolve " + hostName);
+        return false;
+    }
+    address.host = ntohl(reinterpret_cast<const sockaddr_in*>(result->ai_addr)->sin_addr.s_addr);
+    address.port = port;
+    freeaddrinfo(result);
+    return true;
+}
+
+NetworkSocket::~NetworkSocket()
+{
+    Close();
+}
+
+bool NetworkSocket::Open(uint16_t port)
+{
+    Close();
+    socketHandle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (socketHandle == -1)
+    {
+        Logger::Err("Unable to create a socket");
+        return false;
+    }
+    sockaddr_in bindAddress = {};
+    bindAddress.sin_family = AF_INET;
+    bindAddress.sin_addr.s_addr = htonl(INADDR_ANY);
+    bindAddress.sin_port = htons(port);
+    if (bind(socketHandle, reinterpret_cast<const sockaddr*>(&bindAddress), sizeof(bindAddress)) != 0)
+    {
+        Logger::Err("Unable to bind the port " + std::to_string(port));
+        Close();
+        return false;
+    }
+    if (fcntl(socketHandle, F_SETFL, fcntl(socketHandle, F_GETFL, 0) | O_NONBLOCK) != 0)
+    {
+        Logger::Err("Unable to make the socket non-blocking");
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void NetworkSocket::Close()
+{
+    if (socketHandle != -1)
+    {
+        close(socketHandle);
+        socketHandle = -1;
+    }
+}
+
+bool NetworkSocket::Send(const NetworkAddress& address, const void* data, size_t size)
+{
+    sockaddr_in toAddress = {};
+    toAddress.sin_family = AF_INET;
+    toAddress.sin_addr.s_addr = htonl(address.host);
+    toAddress.sin_port = htons(address.port);
+    return sendto(socketHandle, data, size, 0, reinterpret_cast<const sockaddr*>(&toAddress), sizeof(toAddress)) == static_cast<ssize_t>(size);
+}
+
+size_t NetworkSocket::Receive(NetworkAddress& address, void* data, size_t maxSize)
+{
+    sockaddr_in fromAddress = {};
+    socklen_t fromLength = sizeof(fromAddress);
+    const ssize_t size = recvfrom(socketHandle, data, maxSize, 0, reinterpret_cast<sockaddr*>(&fromAddress), &fromLength);
+    if (size <= 0)
+    {
+        return 0;
+    }
+    address.host = ntohl(fromAddress.sin_addr.s_addr);
+    address.port = ntohs(fromAddress.sin_port);
+    return size;
+}
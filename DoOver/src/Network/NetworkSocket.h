@@ -0,0 +1,49 @@
+#ifndef NETWORKSOCKET_H
+#define NETWORKSOCKET_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Network socket
+/////////////////////////////////////////////////////////////////////////////////////////////
+// A non-blocking UDP socket over the BSD sockets. The game loop polls it once a frame, a
+// receive with nothing waiting returns at once.
+/////////////////////////////////////////////////////////////////////////////////////////////
+struct NetworkAddress
+{
+    // IPv4 address and port, in host byte order
+    uint32_t host = 0;
+    uint16_t port = 0;
+
+    bool operator ==(const NetworkAddress& other) const { return host == other.host && port == other.port; }
+    bool operator !=(const NetworkAddress& other) const { return !(*this == other); }
+    std::string ToString() const;
+
+    // Resolves a host name or dotted address
+    static bool Resolve(const std::string& hostName, uint16_t port, NetworkAddress& address);
+};
+
+class NetworkSocket
+{
+private:
+    int socketHandle = -1;
+
+public:
+    NetworkSocket() = default;
+    ~NetworkSocket();
+    NetworkSocket(const NetworkSocket&) = delete;
+    NetworkSocket& operator =(const NetworkSocket&) = delete;
+
+    // Port 0 binds any free port, e.g. for a client
+    bool Open(uint16_t port);
+    void Close();
+    bool IsOpen() const { return socketHandle != -1; }
+
+    bool Send(const NetworkAddress& address, const void* data, size_t size);
+    // The size of the datagram received, 0 when none is waiting
+    size_t Receive(NetworkAddress& address, void* data, size_t maxSize);
+};
+
+#endif
@@ -0,0 +1,203 @@
+#include "ParticleSystem.h"
+#include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#endif
+
+void ParticleBuffer::Add(glm::vec2 position, glm::vec2 velocity, float lifeSeconds, float particleSize)
+{
+    positionX.push_back(position.x);
+    positionY.push_back(position.y);
+    velocityX.push_back(velocity.x);
+    velocityY.push_back(velocity.y);
+    life.push_back(lifeSeconds);
+    size.push_back(particleSize);
+}
+
+void ParticleBuffer::Remove(int index)
+{
+    for (auto* column: {&positionX, &positionY, &velocityX, &velocityY, &life, &size})
+    {
+        (*column)[index] = column->back();
+        column->pop_back();
+    }
+}
+
+void ParticleBuffer::Clear()
+{
+    for (auto* column: {&positionX, &positionY, &velocityX, &velocityY, &life, &size})
+    {
+        column->clear();
+    }
+}
+
+ParticleSystem::ParticleSystem()
+{
+    Logger::Log("ParticleSystem constructor called!");
+}
+
+ParticleSystem::~ParticleSystem()
+{
+    Logger::Log("ParticleSystem destructor called!");
+}
+
+float ParticleSystem::Random()
+{
+    // xorshift32, the effects replay the same in deterministic runs
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return (randomState >> 8) * (1.0f / 16777216.0f);
+}
+
+bool ParticleSystem::Emit(AssetHandle assetHandle, glm::vec2 position, glm::vec2 velocity, float lifeSeconds, float size)
+{
+    if (numParticles >= MAX_PARTICLES || assetHandle < 0)
+    {
+        return false;
+    }
+    if (assetHandle >= static_cast<int>(buffers.size()))
+    {
+        buffers.resize(assetHandle + 1);
+    }
+    buffers[assetHandle].Add(position, velocity, lifeSeconds, size);
+    numParticles++;
+    return true;
+}
+
+void ParticleSystem::EmitBurst(AssetHandle assetHandle, glm::vec2 position, int count, float maxSpeed, float lifeSeconds, float size)
+{
+    for (int i = 0; i < count; i++)
+    {
+        const float angle = Random() * 6.2831853f;
+        const float speed = maxSpeed * (0.25f + 0.75f * Random());
+        if (!Emit(assetHandle, position, glm::vec2(std::cos(angle), std::sin(angle)) * speed, lifeSeconds * (0.5f + 0.5f * Random()), size))
+        {
+            return;
+        }
+    }
+}
+
+void ParticleSystem::Update(double deltaTime)
+{
+    PROFILE_SCOPE("Particles");
+    const float dt = static_cast<float>(deltaTime);
+    for (auto& buffer: buffers)
+    {
+        float* positionX = buffer.positionX.data();
+        float* positionY = buffer.positionY.data();
+        const float* velocityX = buffer.velocityX.data();
+        const float* velocityY = buffer.velocityY.data();
+        float* life = buffer.life.data();
+        const int size = buffer.GetSize();
+        int i = 0;
+
+#if defined(__AVX__)
+        const __m256 dt8 = _mm256_set1_ps(dt);
+        for (; i + 8 <= size; i += 8)
+        {
+            _mm256_storeu_ps(&positionX[i], _mm256_add_ps(_mm256_loadu_ps(&positionX[i]), _mm256_mul_ps(_mm256_loadu_ps(&velocityX[i]), dt8)));
+            _mm256_storeu_ps(&positionY[i], _mm256_add_ps(_mm256_loadu_ps(&positionY[i]), _mm256_mul_ps(_mm256_loadu_ps(&velocityY[i]), dt8)));
+            _mm256_storeu_ps(&life[i], _mm256_sub_ps(_mm256_loadu_ps(&life[i]), dt8));
+        }
+#elif defined(__SSE__) || defined(_M_X64)
+        const __m128 dt4 = _mm_set1_ps(dt);
+        for (; i + 4 <= size; i += 4)
+        {
+            _mm_storeu_ps(&positionX[i], _mm_add_ps(_mm_loadu_ps(&positionX[i]), _mm_mul_ps(_mm_loadu_ps(&velocityX[i]), dt4)));
+            _mm_storeu_ps(&positionY[i], _mm_add_ps(_mm_loadu_ps(&positionY[i]), _mm_mul_ps(_mm_loadu_ps(&velocityY[i]), dt4)));
+            _mm_storeu_ps(&life[i], _mm_sub_ps(_mm_loadu_ps(&life[i]), dt4));
+        }
+#endif
+
+        // Remaining particles (or every particle without SIMD support)
+        for (; i < size; i++)
+        {
+            positionX[i] += velocityX[i] * dt;
+            positionY[i] += velocityY[i] * dt;
+            life[i] -= dt;
+        }
+
+        // Swap the expired particles out, walking backwards so the swapped in ones were already checked
+        for (int j = size - 1; j >= 0; j--)
+        {
+            if (buffer.life[j] <= 0.0f)
+            {
+                buffer.Remove(j);
+                numParticles--;
+            }
+        }
+    }
+}
+
+void ParticleSystem::Collide(const StaticColliderGrid& colliders, uint32_t layer, uint32_t mask)
+{
+    PROFILE_SCOPE("Particle collisions");
+    if (colliders.GetSize() == 0)
+    {
+        return;
+    }
+    for (auto& buffer: buffers)
+    {
+        for (int i = 0; i < buffer.GetSize(); i++)
+        {
+            const float half = buffer.size[i] / 2;
+            const AABB box(buffer.positionX[i] - half, buffer.positionY[i] - half, buffer.positionX[i] + half, buffer.positionY[i] + half);
+            colliderIndices.clear();
+            colliders.Query(box, layer, mask, colliderIndices);
+            if (!colliderIndices.empty())
+            {
+                buffer.life[i] = 0.0f;
+            }
+        }
+    }
+}
+
+void ParticleSystem::Render(RenderCommandList& commandList, const AssetStore& assetStore, const SDL_FRect& camera, double deltaTime, double interpolation)
+{
+    PROFILE_SCOPE("Particles render");
+    // The particles move in a straight line, step them back to where they were in between the ticks
+    const float rewind = static_cast<float>((interpolation - 1.0) * deltaTime);
+    spriteBatch.Begin(commandList);
+    for (int assetHandle = 0; assetHandle < static_cast<int>(buffers.size()); assetHandle++)
+    {
+        const auto& buffer = buffers[assetHandle];
+        if (buffer.GetSize() == 0)
+        {
+            continue;
+        }
+        const auto& region = assetStore.GetTextureRegion(assetHandle);
+        const SDL_Rect srcRect = region.GetSrcRect();
+        assetStore.UseTexture(assetHandle);
+        for (int i = 0; i < buffer.GetSize(); i++)
+        {
+            const float size = buffer.size[i];
+            const SDL_FRect dstRect =
+            {
+                buffer.positionX[i] + buffer.velocityX[i] * rewind - size / 2 - camera.x,
+                buffer.positionY[i] + buffer.velocityY[i] * rewind - size / 2 - camera.y,
+                size,
+                size
+            };
+            if (dstRect.x + size > 0 && dstRect.x < camera.w && dstRect.y + size > 0 && dstRect.y < camera.h)
+            {
+                spriteBatch.Draw(region.texture, srcRect, dstRect, 0.0f);
+            }
+        }
+    }
+    spriteBatch.End();
+}
+
+void ParticleSystem::Clear()
+{
+    for (auto& buffer: buffers)
+    {
+        buffer.Clear();
+    }
+    numParticles = 0;
+}
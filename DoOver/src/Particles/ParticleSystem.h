@@ -0,0 +1,84 @@
+#ifndef PARTICLESYSTEM_H
+#define PARTICLESYSTEM_H
+
+#include "../AssetStore/AssetStore.h"
+#include "../AssetStore/AssetHandle.h"
+#include "../Physics/StaticColliderGrid.h"
+#include "../Renderer/SpriteBatch.h"
+#include <SDL2/SDL.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+// Particles alive at once across every texture, emitting past it fails
+const int MAX_PARTICLES = 200000;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Particle buffer
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The particles of one texture as structure of arrays of floats, so the update runs on 8
+// (AVX) or 4 (SSE) particles per instruction. Dead particles are swapped with the last one.
+/////////////////////////////////////////////////////////////////////////////////////////////
+struct ParticleBuffer
+{
+    std::vector<float> positionX, positionY;
+    std::vector<float> velocityX, velocityY;
+    // Seconds left to live
+    std::vector<float> life;
+    std::vector<float> size;
+
+    int GetSize() const { return life.size(); }
+    void Add(glm::vec2 position, glm::vec2 velocity, float lifeSeconds, float particleSize);
+    void Remove(int index);
+    void Clear();
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Particle system
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Bullets and effects that don't need to be entities: no components, no systems, no
+// registry bookkeeping. A particle moves in a straight line until its life runs out or it
+// hits a collider, and is drawn as a square of its texture. The buffers are kept per
+// texture so each one renders with a single draw call.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class ParticleSystem
+{
+private:
+    // [asset handle] -> particles drawn with that texture
+    std::vector<ParticleBuffer> buffers;
+    int numParticles = 0;
+    uint32_t randomState = 1;
+
+    SpriteBatch spriteBatch;
+    std::vector<int> colliderIndices;
+
+    float Random();
+
+public:
+    ParticleSystem();
+    ~ParticleSystem();
+
+    // The bursts spray the same way from the same seed
+    void SetRandomSeed(uint32_t seed) { randomState = seed != 0 ? seed : 1; }
+
+    // Returns false when MAX_PARTICLES are already alive
+    bool Emit(AssetHandle assetHandle, glm::vec2 position, glm::vec2 velocity, float lifeSeconds, float size);
+    // Sprays particles in every direction at up to maxSpeed, with lives of up to lifeSeconds
+    void EmitBurst(AssetHandle assetHandle, glm::vec2 position, int count, float maxSpeed, float lifeSeconds, float size);
+
+    // Moves the particles and removes the ones that expired
+    void Update(double deltaTime);
+
+    // Expires the particles inside a collider whose layers collide with the given ones, they
+    // are removed by the next Update
+    void Collide(const StaticColliderGrid& colliders, uint32_t layer, uint32_t mask);
+
+    // interpolation is how far the frame is between the last two simulation ticks ([0, 1])
+    void Render(RenderCommandList& commandList, const AssetStore& assetStore, const SDL_FRect& camera, double deltaTime, double interpolation);
+
+    void Clear();
+    int GetNumParticles() const { return numParticles; }
+    int GetNumDrawCalls() const { return spriteBatch.GetNumDrawCalls(); }
+};
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef AABB_H
+#define AABB_H
+
+// Axis aligned bounding box in world coordinates
+struct AABB
+{
+    float minX;
+    float minY;
+    float maxX;
+    float maxY;
+
+    AABB(float minX = 0, float minY = 0, float maxX = 0, float maxY = 0)
+    {
+        this->minX = minX;
+        this->minY = minY;
+        this->maxX = maxX;
+        this->maxY = maxY;
+    }
+
+    bool Overlaps(const AABB& other) const
+    {
+        return minX < other.maxX && maxX > other.minX && minY < other.maxY && maxY > other.minY;
+    }
+};
+
+// Squared distance from a point to the closest point of the box, 0 inside it
+inline float DistanceSquared(const AABB& box, float x, float y)
+{
+    const float dx = x < box.minX ? box.minX - x : (x > box.maxX ? x - box.maxX : 0.0f);
+    const float dy = y < box.minY ? box.minY - y : (y > box.maxY ? y - box.maxY : 0.0f);
+    return dx * dx + dy * dy;
+}
+
+// Segment from start to start + delta against the box (slab test). On hit, fraction is where
+// along the segment it enters the box, in [0, 1], with the normal of the side it enters by
+// (0 when the segment starts inside).
+inline bool RaycastAABB(const AABB& box, float startX, float startY, float deltaX, float deltaY, float& fraction, float& normalX, float& normalY)
+{
+    const float start[2] = {startX, startY};
+    const float delta[2] = {deltaX, deltaY};
+    const float boxMin[2] = {box.minX, box.minY};
+    const float boxMax[2] = {box.maxX, box.maxY};
+
+    float enter = 0.0f;
+    float exit = 1.0f;
+    int enterAxis = -1;
+    float enterSign = 0.0f;
+    for (int axis = 0; axis < 2; axis++)
+    {
+        if (delta[axis] == 0.0f)
+        {
+            if (start[axis] < boxMin[axis] || start[axis] > boxMax[axis])
+            {
+                return false;
+            }
+            continue;
+        }
+        float axisEnter = (boxMin[axis] - start[axis]) / delta[axis];
+        float axisExit = (boxMax[axis] - start[axis]) / delta[axis];
+        float sign = -1.0f;
+        if (axisEnter > axisExit)
+        {
+            const float swap = axisEnter;
+            axisEnter = axisExit;
+            axisExit = swap;
+            sign = 1.0f;
+        }
+        if (axisEnter > enter)
+        {
+            enter = axisEnter;
+            enterAxis = axis;
+            enterSign = sign;
+        }
+        exit = axisExit < exit ? axisExit : exit;
+        if (enter > exit)
+        {
+            return false;
+        }
+    }
+    fraction = enter;
+    normalX = enterAxis == 0 ? enterSign : 0.0f;
+    normalY = enterAxis == 1 ? enterSign : 0.0f;
+    return true;
+}
+
+// Box enclosing both boxes, e.g. the area swept by a box between two frames
+inline AABB Union(const AABB& a, const AABB& b)
+{
+    return AABB(a.minX < b.minX ? a.minX : b.minX, a.minY < b.minY ? a.minY : b.minY, a.maxX > b.maxX ? a.maxX : b.maxX, a.maxY > b.maxY ? a.maxY : b.maxY);
+}
+
+// Continuous test of two boxes moving linearly from their previous to their current
+// position over the frame. On hit, timeOfImpact is the fraction of the frame in [0, 1]
+// when they start touching (0 if they already overlapped).
+inline bool SweepAABB(const AABB& aPrevious, const AABB& aCurrent, const AABB& bPrevious, const AABB& bCurrent, float& timeOfImpact)
+{
+    // Move a relative to b, which stays at its previous position
+    const float motion[2] = {
+        (aCurrent.minX - aPrevious.minX) - (bCurrent.minX - bPrevious.minX),
+        (aCurrent.minY - aPrevious.minY) - (bCurrent.minY - bPrevious.minY)
+    };
+    const float aMin[2] = {aPrevious.minX, aPrevious.minY};
+    const float aMax[2] = {aPrevious.maxX, aPrevious.maxY};
+    const float bMin[2] = {bPrevious.minX, bPrevious.minY};
+    const float bMax[2] = {bPrevious.maxX, bPrevious.maxY};
+
+    float enter = -1.0f;
+    float exit = 1.0f;
+    for (int axis = 0; axis < 2; axis++)
+    {
+        if (motion[axis] == 0.0f)
+        {
+            if (aMin[axis] >= bMax[axis] || aMax[axis] <= bMin[axis])
+            {
+                return false;
+            }
+            continue;
+        }
+        float axisEnter = (bMin[axis] - aMax[axis]) / motion[axis];
+        float axisExit = (bMax[axis] - aMin[axis]) / motion[axis];
+        if (axisEnter > axisExit)
+        {
+            const float swap = axisEnter;
+            axisEnter = axisExit;
+            axisExit = swap;
+        }
+        enter = axisEnter > enter ? axisEnter : enter;
+        exit = axisExit < exit ? axisExit : exit;
+    }
+
+    if (enter >= exit || exit <= 0.0f || enter > 1.0f)
+    {
+        return false;
+    }
+    timeOfImpact = enter > 0.0f ? enter : 0.0f;
+    return true;
+}
+
+#endif
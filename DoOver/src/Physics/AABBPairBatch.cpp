@@ -0,0 +1,79 @@
+#include "AABBPairBatch.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#endif
+
+void AABBPairBatch::Clear()
+{
+    aMinX.clear(); aMinY.clear(); aMaxX.clear(); aMaxY.clear();
+    bMinX.clear(); bMinY.clear(); bMaxX.clear(); bMaxY.clear();
+}
+
+void AABBPairBatch::Reserve(int numPairs)
+{
+    for (auto* column: {&aMinX, &aMinY, &aMaxX, &aMaxY, &bMinX, &bMinY, &bMaxX, &bMaxY})
+    {
+        column->reserve(numPairs);
+    }
+}
+
+void AABBPairBatch::Add(const AABB& a, const AABB& b)
+{
+    aMinX.push_back(a.minX); aMinY.push_back(a.minY); aMaxX.push_back(a.maxX); aMaxY.push_back(a.maxY);
+    bMinX.push_back(b.minX); bMinY.push_back(b.minY); bMaxX.push_back(b.maxX); bMaxY.push_back(b.maxY);
+}
+
+int AABBPairBatch::GetSize() const
+{
+    return aMinX.size();
+}
+
+void AABBPairBatch::FindOverlaps(std::vector<int>& overlapIndices) const
+{
+    const int numPairs = GetSize();
+    int i = 0;
+
+#if defined(__AVX__)
+    for (; i + 8 <= numPairs; i += 8)
+    {
+        const __m256 x0 = _mm256_cmp_ps(_mm256_loadu_ps(&aMinX[i]), _mm256_loadu_ps(&bMaxX[i]), _CMP_LT_OQ);
+        const __m256 x1 = _mm256_cmp_ps(_mm256_loadu_ps(&aMaxX[i]), _mm256_loadu_ps(&bMinX[i]), _CMP_GT_OQ);
+        const __m256 y0 = _mm256_cmp_ps(_mm256_loadu_ps(&aMinY[i]), _mm256_loadu_ps(&bMaxY[i]), _CMP_LT_OQ);
+        const __m256 y1 = _mm256_cmp_ps(_mm256_loadu_ps(&aMaxY[i]), _mm256_loadu_ps(&bMinY[i]), _CMP_GT_OQ);
+        int bits = _mm256_movemask_ps(_mm256_and_ps(_mm256_and_ps(x0, x1), _mm256_and_ps(y0, y1)));
+        while (bits)
+        {
+            overlapIndices.push_back(i + __builtin_ctz(bits));
+            bits &= bits - 1;
+        }
+    }
+#elif defined(__SSE__) || defined(_M_X64)
+    for (; i + 4 <= numPairs; i += 4)
+    {
+        const __m128 x0 = _mm_cmplt_ps(_mm_loadu_ps(&aMinX[i]), _mm_loadu_ps(&bMaxX[i]));
+        const __m128 x1 = _mm_cmpgt_ps(_mm_loadu_ps(&aMaxX[i]), _mm_loadu_ps(&bMinX[i]));
+        const __m128 y0 = _mm_cmplt_ps(_mm_loadu_ps(&aMinY[i]), _mm_loadu_ps(&bMaxY[i]));
+        const __m128 y1 = _mm_cmpgt_ps(_mm_loadu_ps(&aMaxY[i]), _mm_loadu_ps(&bMinY[i]));
+        const int bits = _mm_movemask_ps(_mm_and_ps(_mm_and_ps(x0, x1), _mm_and_ps(y0, y1)));
+        for (int lane = 0; lane < 4; lane++)
+        {
+            if (bits & (1 << lane))
+            {
+                overlapIndices.push_back(i + lane);
+            }
+        }
+    }
+#endif
+
+    // Remaining pairs (or every pair without SIMD support)
+    for (; i < numPairs; i++)
+    {
+        if (aMinX[i] < bMaxX[i] && aMaxX[i] > bMinX[i] && aMinY[i] < bMaxY[i] && aMaxY[i] > bMinY[i])
+        {
+            overlapIndices.push_back(i);
+        }
+    }
+}
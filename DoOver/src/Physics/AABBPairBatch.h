@@ -0,0 +1,31 @@
+#ifndef AABBPAIRBATCH_H
+#define AABBPAIRBATCH_H
+
+#include "AABB.h"
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// AABB Pair Batch
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Narrowphase for the broadphase candidates: the pairs are stored as structure of arrays
+// of floats so the overlap test runs on 8 (AVX) or 4 (SSE) pairs per instruction.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class AABBPairBatch
+{
+private:
+    std::vector<float> aMinX, aMinY, aMaxX, aMaxY;
+    std::vector<float> bMinX, bMinY, bMaxX, bMaxY;
+
+public:
+    AABBPairBatch() = default;
+
+    void Clear();
+    void Reserve(int numPairs);
+    void Add(const AABB& a, const AABB& b);
+    int GetSize() const;
+
+    // Appends the index of every pair that overlaps, in increasing order
+    void FindOverlaps(std::vector<int>& overlapIndices) const;
+};
+
+#endif
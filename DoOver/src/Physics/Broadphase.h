@@ -0,0 +1,105 @@
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+
+#include "../ECS/ECS.h"
+#include "AABB.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+const int DEFAULT_CELL_SIZE = 64;
+
+enum BroadphaseMode
+{
+    BROADPHASE_SPATIAL_HASH,
+    BROADPHASE_SWEEP_AND_PRUNE
+};
+
+// A box found around a point
+struct BroadphaseHit
+{
+    Entity entity = Entity(0, 0, 0);
+    AABB box;
+    // From the point to the closest point of the box
+    float distanceSquared = 0.0f;
+};
+
+// The first box a segment runs into
+struct RaycastHit
+{
+    Entity entity = Entity(0, 0, 0);
+    // Along the segment in [0, 1], where it enters the box
+    float fraction = 1.0f;
+    glm::vec2 point = glm::vec2(0);
+    // Of the side of the box it enters by, 0 when the segment starts inside
+    glm::vec2 normal = glm::vec2(0);
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Broadphase
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Finds the pairs of boxes that may overlap. The structure persists between frames:
+// every entity still in the broadphase must be updated between BeginFrame and EndFrame,
+// and EndFrame removes the ones that weren't (killed or no longer in the system). A sleeping
+// entity keeps its box without the updates, until it is woken up or removed.
+// The boxes it holds can also be searched around a point, e.g. for the targets of a turret,
+// in a box or along a segment, without going through every entity. The box and segment
+// queries only read the structure, the workers can run them side by side.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class IBroadphase
+{
+protected:
+    // Rejects the pair by layer before any geometric test
+    static bool LayersCollide(uint32_t aLayer, uint32_t aMask, uint32_t bLayer, uint32_t bMask)
+    {
+        return (aLayer & bMask) && (bLayer & aMask);
+    }
+
+public:
+    virtual ~IBroadphase() = default;
+
+    virtual void BeginFrame() = 0;
+    virtual void Update(Entity entity, const AABB& box, uint32_t layer, uint32_t mask) = 0;
+    virtual void EndFrame() = 0;
+
+    // Of an entity in the broadphase, its next Update wakes it up
+    virtual void SetSleeping(Entity entity, bool isSleeping) = 0;
+
+    virtual void Remove(Entity entity) = 0;
+    virtual void Clear() = 0;
+
+    // Appends the candidate pairs, each pair is reported once
+    virtual void QueryPairs(std::vector<std::pair<Entity, Entity>>& pairs) const = 0;
+
+    // Appends the boxes on one of the layers given that are within the radius of the point
+    virtual void QueryRadius(glm::vec2 point, float radius, uint32_t layers, std::vector<BroadphaseHit>& hits) const = 0;
+
+    // Appends the k nearest of them, the nearest first
+    virtual void QueryNearest(glm::vec2 point, float radius, uint32_t layers, int k, std::vector<BroadphaseHit>& hits) const
+    {
+        const size_t firstHit = hits.size();
+        QueryRadius(point, radius, layers, hits);
+        const size_t numHits = std::min(hits.size() - firstHit, static_cast<size_t>(std::max(k, 0)));
+        std::partial_sort(hits.begin() + firstHit, hits.begin() + firstHit + numHits, hits.end(), [](const BroadphaseHit& a, const BroadphaseHit& b)
+        {
+            return a.distanceSquared < b.distanceSquared;
+        });
+        hits.resize(firstHit + numHits);
+    }
+
+    // Appends the boxes on one of the layers given that overlap the box
+    virtual void QueryBox(const AABB& box, uint32_t layers, std::vector<Entity>& entities) const = 0;
+
+    // The nearest box on one of the layers given the segment runs into, false when none
+    virtual bool Raycast(glm::vec2 start, glm::vec2 end, uint32_t layers, RaycastHit& hit) const = 0;
+
+    // Appends the occupied cells of the structure, for the debug view. None by default.
+    virtual void GetDebugCells(std::vector<AABB>& cells) const {}
+
+    // Of the structure, for the statistics. 0 when it has no cells.
+    virtual int GetNumCells() const { return 0; }
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include "BroadphaseTuner.h"
+#include <algorithm>
+#include <cmath>
+
+int BroadphaseTuner::RoundUpToPowerOfTwo(float size)
+{
+    int cellSize = BROADPHASE_MIN_CELL_SIZE;
+    while (cellSize < size && cellSize < BROADPHASE_MAX_CELL_SIZE)
+    {
+        cellSize *= 2;
+    }
+    return cellSize;
+}
+
+bool BroadphaseTuner::BeginFrame(BroadphaseMode mode, int cellSize)
+{
+    isSampling = frame++ % BROADPHASE_TUNING_INTERVAL == 0;
+    if (isSampling)
+    {
+        stats.mode = mode;
+        stats.cellSize = cellSize;
+        sizes.clear();
+        numCellEntries = 0;
+    }
+    return isSampling;
+}
+
+void BroadphaseTuner::SampleBox(const AABB& box)
+{
+    sizes.push_back(std::max(box.maxX - box.minX, box.maxY - box.minY));
+    // The cells the grid would insert it in with the current cell size
+    const float cellSize = static_cast<float>(stats.cellSize);
+    const int64_t numColumns = static_cast<int64_t>(std::floor(box.maxX / cellSize)) - static_cast<int64_t>(std::floor(box.minX / cellSize)) + 1;
+    const int64_t numRows = static_cast<int64_t>(std::floor(box.maxY / cellSize)) - static_cast<int64_t>(std::floor(box.minY / cellSize)) + 1;
+    numCellEntries += static_cast<uint64_t>(numColumns * numRows);
+}
+
+bool BroadphaseTuner::EndFrame(int numCandidatePairs, int numOverlaps, int numCells, BroadphaseMode& mode, int& cellSize)
+{
+    if (!isSampling)
+    {
+        return false;
+    }
+    isSampling = false;
+
+    stats.numBoxes = static_cast<int>(sizes.size());
+    stats.numCandidatePairs = numCandidatePairs;
+    stats.numOverlaps = numOverlaps;
+    if (sizes.empty())
+    {
+        stats.minSize = stats.medianSize = stats.p90Size = stats.maxSize = 0.0f;
+        stats.cellsPerBox = stats.boxesPerCell = 0.0f;
+        numConfirmations = 0;
+        return false;
+    }
+    std::sort(sizes.begin(), sizes.end());
+    const float p10Size = sizes[sizes.size() / 10];
+    stats.minSize = sizes.front();
+    stats.medianSize = sizes[sizes.size() / 2];
+    stats.p90Size = sizes[sizes.size() * 9 / 10];
+    stats.maxSize = sizes.back();
+    stats.cellsPerBox = static_cast<float>(numCellEntries) / stats.numBoxes;
+    stats.boxesPerCell = stats.mode == BROADPHASE_SPATIAL_HASH && numCells > 0 ? static_cast<float>(numCellEntries) / numCells : 0.0f;
+    if (stats.numBoxes < BROADPHASE_MIN_TUNED_BOXES)
+    {
+        numConfirmations = 0;
+        return false;
+    }
+
+    // What the statistics call for
+    BroadphaseMode wantedMode = BROADPHASE_SPATIAL_HASH;
+    int wantedCellSize = stats.cellSize;
+    if (stats.p90Size > BROADPHASE_MAX_SIZE_SPREAD * std::max(p10Size, 1.0f))
+    {
+        wantedMode = BROADPHASE_SWEEP_AND_PRUNE;
+    }
+    else
+    {
+        // Any power of two between the common and the large boxes will do, the current one is
+        // only halved when its cells are crowded with pairs that don't touch
+        const int smallestCellSize = RoundUpToPowerOfTwo(stats.medianSize);
+        const int largestCellSize = RoundUpToPowerOfTwo(stats.p90Size);
+        const bool isCrowded = numCandidatePairs > BROADPHASE_MAX_TESTS_PER_OVERLAP * std::max(numOverlaps, 1);
+        if (stats.mode != BROADPHASE_SPATIAL_HASH || stats.cellSize < smallestCellSize || stats.cellSize > largestCellSize)
+        {
+            wantedCellSize = largestCellSize;
+        }
+        else if (isCrowded && stats.cellSize / 2 >= smallestCellSize)
+        {
+            wantedCellSize = stats.cellSize / 2;
+        }
+    }
+
+    const bool isCurrent = wantedMode == stats.mode && (wantedMode == BROADPHASE_SWEEP_AND_PRUNE || wantedCellSize == stats.cellSize);
+    if (isCurrent)
+    {
+        numConfirmations = 0;
+        return false;
+    }
+    if (numConfirmations > 0 && wantedMode == pendingMode && wantedCellSize == pendingCellSize)
+    {
+        numConfirmations++;
+    }
+    else
+    {
+        pendingMode = wantedMode;
+        pendingCellSize = wantedCellSize;
+        numConfirmations = 1;
+    }
+    if (numConfirmations < BROADPHASE_TUNING_CONFIRMATIONS)
+    {
+        return false;
+    }
+    numConfirmations = 0;
+    stats.numRetunes++;
+    mode = wantedMode;
+    cellSize = wantedCellSize;
+    return true;
+}
+
+const BroadphaseStats& BroadphaseTuner::GetStats() const
+{
+    return stats;
+}
@@ -0,0 +1,87 @@
+#ifndef BROADPHASETUNER_H
+#define BROADPHASETUNER_H
+
+#include "Broadphase.h"
+#include "AABB.h"
+#include <cstdint>
+#include <vector>
+
+// Frames between two looks at the statistics, the boxes are only sampled on those frames
+const int BROADPHASE_TUNING_INTERVAL = 120;
+// Looks in a row that must want the same change before it is made, so a passing crowd of
+// bullets doesn't rebuild the broadphase back and forth
+const int BROADPHASE_TUNING_CONFIRMATIONS = 2;
+// Fewer dynamic boxes than this aren't worth tuning for
+const int BROADPHASE_MIN_TUNED_BOXES = 32;
+const int BROADPHASE_MIN_CELL_SIZE = 16;
+const int BROADPHASE_MAX_CELL_SIZE = 1024;
+// Largest to smallest box sizes (90th to 10th percentile) past which no one cell size fits
+// and sweep and prune takes over
+const float BROADPHASE_MAX_SIZE_SPREAD = 8.0f;
+// Candidate pairs per overlap past which the cells hold too many boxes that don't touch
+const float BROADPHASE_MAX_TESTS_PER_OVERLAP = 8.0f;
+
+// What the tuner saw on its last look
+struct BroadphaseStats
+{
+    BroadphaseMode mode = BROADPHASE_SPATIAL_HASH;
+    int cellSize = DEFAULT_CELL_SIZE;
+    int numBoxes = 0;
+    // Largest side of the boxes, in world pixels
+    float minSize = 0.0f;
+    float medianSize = 0.0f;
+    float p90Size = 0.0f;
+    float maxSize = 0.0f;
+    int numCandidatePairs = 0;
+    int numOverlaps = 0;
+    // Of the grid: cells a box is inserted in and boxes per occupied cell
+    float cellsPerBox = 0.0f;
+    float boxesPerCell = 0.0f;
+    // Changes of cell size or mode made so far
+    int numRetunes = 0;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Broadphase tuner
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Picks the broadphase of the collision system from what it holds at runtime. Every
+// BROADPHASE_TUNING_INTERVAL frames it samples the size of every dynamic box, the candidate
+// pairs and how many of them overlapped. The cell size follows the large boxes (a power of
+// two covering the 90th percentile, so most boxes sit in 4 cells or fewer), halved when the
+// cells are crowded with pairs that don't touch. When the sizes spread too widely for one
+// cell size (tiny bullets among 128px tiles), sweep and prune replaces the grid. A change is
+// only made once BROADPHASE_TUNING_CONFIRMATIONS looks in a row want it.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class BroadphaseTuner
+{
+private:
+    int frame = 0;
+    bool isSampling = false;
+    std::vector<float> sizes;
+    uint64_t numCellEntries = 0;
+    BroadphaseStats stats;
+
+    // The change the last looks wanted, and how many in a row
+    BroadphaseMode pendingMode = BROADPHASE_SPATIAL_HASH;
+    int pendingCellSize = DEFAULT_CELL_SIZE;
+    int numConfirmations = 0;
+
+    static int RoundUpToPowerOfTwo(float size);
+
+public:
+    BroadphaseTuner() = default;
+
+    // Before the boxes are updated, true when this frame is sampled
+    bool BeginFrame(BroadphaseMode mode, int cellSize);
+
+    // Every dynamic box of a sampled frame
+    void SampleBox(const AABB& box);
+
+    // After the narrowphase of a sampled frame. Returns true, with the broadphase to switch
+    // to, when it should change.
+    bool EndFrame(int numCandidatePairs, int numOverlaps, int numCells, BroadphaseMode& mode, int& cellSize);
+
+    const BroadphaseStats& GetStats() const;
+};
+
+#endif
@@ -0,0 +1,51 @@
+#include "CollisionPairCache.h"
+
+uint64_t CollisionPairCache::GetPairKey(Entity a, Entity b)
+{
+    // The pair is unordered, the handles include the version so recycled ids are new pairs
+    const uint64_t first = a.GetHandle() < b.GetHandle() ? a.GetHandle() : b.GetHandle();
+    const uint64_t second = a.GetHandle() < b.GetHandle() ? b.GetHandle() : a.GetHandle();
+    return (first << 32) | second;
+}
+
+void CollisionPairCache::Update(const std::vector<std::pair<Entity, Entity>>& collisions, std::vector<std::pair<Entity, Entity>>& entered, std::vector<std::pair<Entity, Entity>>& stayed, std::vector<std::pair<Entity, Entity>>& exited)
+{
+    frame++;
+    for (const auto& collision: collisions)
+    {
+        auto result = contacts.insert({GetPairKey(collision.first, collision.second), Contact{collision.first, collision.second, frame}});
+        auto& contact = result.first->second;
+        if (result.second)
+        {
+            entered.push_back(collision);
+        }
+        else if (contact.frame != frame)
+        {
+            contact.frame = frame;
+            stayed.push_back(collision);
+        }
+    }
+
+    for (auto it = contacts.begin(); it != contacts.end();)
+    {
+        if (it->second.frame != frame)
+        {
+            exited.emplace_back(it->second.a, it->second.b);
+            it = contacts.erase(it);
+        }
+        else
+        {
+            it++;
+        }
+    }
+}
+
+void CollisionPairCache::Clear()
+{
+    contacts.clear();
+}
+
+int CollisionPairCache::GetSize() const
+{
+    return contacts.size();
+}
@@ -0,0 +1,42 @@
+#ifndef COLLISIONPAIRCACHE_H
+#define COLLISIONPAIRCACHE_H
+
+#include "../ECS/ECS.h"
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <cstdint>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Collision Pair Cache
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Remembers the pairs that were overlapping on the last frame, so the collision system
+// only reports the contacts that started or ended instead of every overlap every frame
+/////////////////////////////////////////////////////////////////////////////////////////////
+class CollisionPairCache
+{
+private:
+    struct Contact
+    {
+        Entity a;
+        Entity b;
+        int frame;
+    };
+
+    // [hash of the pair handles] -> contact
+    std::unordered_map<uint64_t, Contact> contacts;
+    int frame = 0;
+
+    static uint64_t GetPairKey(Entity a, Entity b);
+
+public:
+    CollisionPairCache() = default;
+
+    // Splits this frame collisions in the ones that started and the ones that were already
+    // there, and appends the contacts of the last frame that ended
+    void Update(const std::vector<std::pair<Entity, Entity>>& collisions, std::vector<std::pair<Entity, Entity>>& entered, std::vector<std::pair<Entity, Entity>>& stayed, std::vector<std::pair<Entity, Entity>>& exited);
+    void Clear();
+    int GetSize() const;
+};
+
+#endif
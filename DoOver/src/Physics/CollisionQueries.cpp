@@ -0,0 +1,68 @@
+#include "CollisionQueries.h"
+#include "../Profiler/Profiler.h"
+
+CollisionQueries::CollisionQueries(const IBroadphase& broadphase, const StaticColliderGrid& staticColliders): broadphase(broadphase), staticColliders(staticColliders)
+{
+}
+
+bool CollisionQueries::Segment(glm::vec2 start, glm::vec2 end, uint32_t layers, RaycastHit& hit) const
+{
+    RaycastHit staticHit;
+    RaycastHit dynamicHit;
+    const bool isStaticHit = staticColliders.Raycast(start, end, layers, staticHit);
+    // Only the moving colliders before the static hit are of interest
+    const bool isDynamicHit = broadphase.Raycast(start, isStaticHit ? staticHit.point : end, layers, dynamicHit);
+    if (isDynamicHit)
+    {
+        // Along the shortened segment, back to the whole one
+        dynamicHit.fraction *= isStaticHit ? staticHit.fraction : 1.0f;
+        hit = dynamicHit;
+        return true;
+    }
+    if (isStaticHit)
+    {
+        hit = staticHit;
+        return true;
+    }
+    return false;
+}
+
+bool CollisionQueries::Raycast(glm::vec2 origin, glm::vec2 direction, float maxDistance, uint32_t layers, RaycastHit& hit) const
+{
+    const float length = glm::length(direction);
+    if (length == 0.0f)
+    {
+        return false;
+    }
+    return Segment(origin, origin + direction / length * maxDistance, layers, hit);
+}
+
+bool CollisionQueries::HasLineOfSight(glm::vec2 from, glm::vec2 to, uint32_t blockingLayers) const
+{
+    RaycastHit hit;
+    return !Segment(from, to, blockingLayers, hit);
+}
+
+void CollisionQueries::Overlap(const AABB& box, uint32_t layers, std::vector<Entity>& entities) const
+{
+    std::vector<int> staticIndices;
+    staticColliders.QueryLayers(box, layers, staticIndices);
+    for (int index: staticIndices)
+    {
+        entities.push_back(staticColliders.GetCollider(index).entity);
+    }
+    broadphase.QueryBox(box, layers, entities);
+}
+
+void CollisionQueries::SegmentBatch(const std::vector<RaycastQuery>& queries, std::vector<RaycastResult>& results, JobSystem& jobSystem) const
+{
+    PROFILE_SCOPE("Raycast batch");
+    results.resize(queries.size());
+    jobSystem.ParallelFor(queries.size(), COLLISION_QUERY_RAYS_PER_CHUNK, [this, &queries, &results](int begin, int end)
+    {
+        for (int i = begin; i < end; i++)
+        {
+            results[i].isHit = Segment(queries[i].start, queries[i].end, queries[i].layers, results[i].hit);
+        }
+    });
+}
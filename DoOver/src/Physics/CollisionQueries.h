@@ -0,0 +1,56 @@
+#ifndef COLLISIONQUERIES_H
+#define COLLISIONQUERIES_H
+
+#include "Broadphase.h"
+#include "StaticColliderGrid.h"
+#include "../Jobs/JobSystem.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+// Segments per chunk of a batch, a segment walks a few cells so it takes a few of them
+const int COLLISION_QUERY_RAYS_PER_CHUNK = 16;
+
+struct RaycastQuery
+{
+    glm::vec2 start;
+    glm::vec2 end;
+    uint32_t layers;
+};
+
+struct RaycastResult
+{
+    bool isHit;
+    RaycastHit hit;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Collision queries
+/////////////////////////////////////////////////////////////////////////////////////////////
+// What gameplay and AI ask of the collision world without a collider of their own: the
+// raycasts, line of sight and overlaps go through both the broadphase of the moving colliders
+// and the grid of the static ones, the nearest hit of the two wins. Only reads them, so the
+// batches of segments run side by side on the workers. Valid until the next collision update.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class CollisionQueries
+{
+private:
+    const IBroadphase& broadphase;
+    const StaticColliderGrid& staticColliders;
+
+public:
+    CollisionQueries(const IBroadphase& broadphase, const StaticColliderGrid& staticColliders);
+
+    // The first collider on one of the layers from start to end, false when none
+    bool Segment(glm::vec2 start, glm::vec2 end, uint32_t layers, RaycastHit& hit) const;
+    // The same from an origin along a direction, which needn't be normalized
+    bool Raycast(glm::vec2 origin, glm::vec2 direction, float maxDistance, uint32_t layers, RaycastHit& hit) const;
+    // Whether nothing on the blocking layers is between the two points
+    bool HasLineOfSight(glm::vec2 from, glm::vec2 to, uint32_t blockingLayers) const;
+    // Appends the colliders on one of the layers that overlap the box
+    void Overlap(const AABB& box, uint32_t layers, std::vector<Entity>& entities) const;
+
+    // results[i] is the segment of queries[i], searched on the workers and the calling thread
+    void SegmentBatch(const std::vector<RaycastQuery>& queries, std::vector<RaycastResult>& results, JobSystem& jobSystem) const;
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef GRIDTRAVERSAL_H
+#define GRIDTRAVERSAL_H
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+// Visits the cells of a uniform grid a segment goes through, from start to end, in order
+// (the DDA of Amanatides and Woo). visit(col, row, exitFraction) is told where along the
+// segment it leaves the cell, in [0, 1], and returns false to stop there, e.g. once a hit
+// nearer than exitFraction was found in the cells visited.
+template <typename TVisit>
+void TraverseGrid(glm::vec2 start, glm::vec2 end, float originX, float originY, float cellSize, TVisit visit)
+{
+    const float infinity = std::numeric_limits<float>::infinity();
+    const glm::vec2 delta = end - start;
+    int col = static_cast<int>(std::floor((start.x - originX) / cellSize));
+    int row = static_cast<int>(std::floor((start.y - originY) / cellSize));
+    const int endCol = static_cast<int>(std::floor((end.x - originX) / cellSize));
+    const int endRow = static_cast<int>(std::floor((end.y - originY) / cellSize));
+
+    const int stepCol = delta.x > 0.0f ? 1 : -1;
+    const int stepRow = delta.y > 0.0f ? 1 : -1;
+    // Fraction of the segment to cross a whole cell, and to reach the next column and row
+    const float fractionPerCol = delta.x != 0.0f ? cellSize / std::abs(delta.x) : infinity;
+    const float fractionPerRow = delta.y != 0.0f ? cellSize / std::abs(delta.y) : infinity;
+    float nextColFraction = delta.x != 0.0f ? (originX + (col + (stepCol > 0 ? 1 : 0)) * cellSize - start.x) / delta.x : infinity;
+    float nextRowFraction = delta.y != 0.0f ? (originY + (row + (stepRow > 0 ? 1 : 0)) * cellSize - start.y) / delta.y : infinity;
+
+    // One step per column and row crossed, the float error can't make it run away
+    const int numCells = std::abs(endCol - col) + std::abs(endRow - row) + 1;
+    for (int i = 0; i < numCells; i++)
+    {
+        const float exitFraction = std::min(std::min(nextColFraction, nextRowFraction), 1.0f);
+        if (!visit(col, row, exitFraction))
+        {
+            return;
+        }
+        if (nextColFraction < nextRowFraction)
+        {
+            col += stepCol;
+            nextColFraction += fractionPerCol;
+        }
+        else
+        {
+            row += stepRow;
+            nextRowFraction += fractionPerRow;
+        }
+    }
+}
+
+#endif
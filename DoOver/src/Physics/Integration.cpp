@@ -0,0 +1,183 @@
+#include "Integration.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define INTEGRATION_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// The AVX2 kernel is compiled for AVX2 whatever the flags of the build, it only runs once
+// the CPU reported it. MSVC allows the intrinsics anywhere.
+#if defined(INTEGRATION_X86) && defined(__GNUC__)
+#define INTEGRATION_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define INTEGRATION_TARGET_AVX2
+#endif
+
+static_assert(offsetof(TransformComponent, position) == 0 && offsetof(TransformComponent, previousPosition) == 8,
+    "The kernels store the position and the previous position as one 128-bit lane");
+static_assert(sizeof(RigidBodyComponent) == 8, "The kernels load the velocities of consecutive rigid bodies at once");
+
+static void IntegrateScalar(TransformComponent* transforms, const RigidBodyComponent* rigidBodies, int count, float step)
+{
+    for (int i = 0; i < count; i++)
+    {
+        transforms[i].previousPosition = transforms[i].position;
+        transforms[i].position += rigidBodies[i].velocity * step;
+    }
+}
+
+#ifdef INTEGRATION_X86
+static void IntegrateSse2(TransformComponent* transforms, const RigidBodyComponent* rigidBodies, int count, float step)
+{
+    const __m128 steps = _mm_set1_ps(step);
+    for (int i = 0; i < count; i++)
+    {
+        float* transform = &transforms[i].position.x;
+        // [x, y, previous x, previous y] and [vx, vy, 0, 0]
+        const __m128 positions = _mm_load_ps(transform);
+        const __m128 velocity = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(&rigidBodies[i].velocity.x)));
+        const __m128 moved = _mm_add_ps(positions, _mm_mul_ps(velocity, steps));
+        _mm_store_ps(transform, _mm_movelh_ps(moved, positions));
+    }
+}
+
+INTEGRATION_TARGET_AVX2 static void IntegrateAvx2(TransformComponent* transforms, const RigidBodyComponent* rigidBodies, int count, float step)
+{
+    const __m256 steps = _mm256_set1_ps(step);
+    // Spreads the velocities of two entities to the bottom of each 128-bit half
+    const __m256i spreadVelocities = _mm256_setr_epi32(0, 1, 0, 1, 2, 3, 2, 3);
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        // Two entities per register, one in each half
+        for (int pair = i; pair < i + 8; pair += 2)
+        {
+            float* first = &transforms[pair].position.x;
+            float* second = &transforms[pair + 1].position.x;
+            const __m256 positions = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_load_ps(first)), _mm_load_ps(second), 1);
+            const __m256 velocities = _mm256_permutevar8x32_ps(_mm256_castps128_ps256(_mm_loadu_ps(&rigidBodies[pair].velocity.x)), spreadVelocities);
+            const __m256 moved = _mm256_add_ps(positions, _mm256_mul_ps(velocities, steps));
+            const __m256 stored = _mm256_shuffle_ps(moved, positions, _MM_SHUFFLE(1, 0, 1, 0));
+            _mm_store_ps(first, _mm256_castps256_ps128(stored));
+            _mm_store_ps(second, _mm256_extractf128_ps(stored, 1));
+        }
+    }
+    IntegrateSse2(transforms + i, rigidBodies + i, count - i, step);
+}
+
+static bool HasAvx2()
+{
+#if defined(__GNUC__)
+    return __builtin_cpu_supports("avx2");
+#else
+    // The CPU has to support AVX2 and the OS has to save the upper halves of the registers
+    int info[4];
+    __cpuid(info, 1);
+    const bool hasOsAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return hasOsAvx && (info[1] & (1 << 5));
+#endif
+}
+#endif
+
+void Integration::IntegratePositions(TransformComponent* transforms, const RigidBodyComponent* rigidBodies, int count, float step)
+{
+    static const IntegrationKernel kernel = GetKernel();
+    IntegratePositions(kernel, transforms, rigidBodies, count, step);
+}
+
+void Integration::IntegratePositions(IntegrationKernel kernel, TransformComponent* transforms, const RigidBodyComponent* rigidBodies, int count, float step)
+{
+    switch (kernel)
+    {
+#ifdef INTEGRATION_X86
+        case INTEGRATION_KERNEL_AVX2:
+            IntegrateAvx2(transforms, rigidBodies, count, step);
+            break;
+        case INTEGRATION_KERNEL_SSE2:
+            IntegrateSse2(transforms, rigidBodies, count, step);
+            break;
+#endif
+        default:
+            IntegrateScalar(transforms, rigidBodies, count, step);
+            break;
+    }
+}
+
+void Integration::IntegrateBody(TransformComponent& transform, RigidBodyComponent& rigidBody, const PhysicsMaterialComponent& material, float step)
+{
+    const int numSubsteps = GetNumSubsteps(rigidBody, material, step);
+    const float substep = step / numSubsteps;
+    transform.previousPosition = transform.position;
+    for (int i = 0; i < numSubsteps; i++)
+    {
+        // The damping is implicit, it never flips the velocity however large the step
+        glm::vec2 velocity = (rigidBody.velocity + material.acceleration * substep) / (1.0f + material.damping * substep);
+        const float speed = glm::length(velocity);
+        if (material.maxSpeed > 0.0f && speed > material.maxSpeed)
+        {
+            velocity *= material.maxSpeed / speed;
+        }
+        rigidBody.velocity = velocity;
+        transform.position += velocity * substep;
+    }
+}
+
+int Integration::GetNumSubsteps(const RigidBodyComponent& rigidBody, const PhysicsMaterialComponent& material, float step)
+{
+    // Without forces the velocity is constant, one step is exact
+    if (material.acceleration == glm::vec2(0) && material.damping == 0.0f)
+    {
+        return 1;
+    }
+    // As far as the body could go, the acceleration taken over the whole step
+    const float distance = (glm::length(rigidBody.velocity) + glm::length(material.acceleration) * step) * step;
+    return std::min(std::max(static_cast<int>(std::ceil(distance / PHYSICS_SUBSTEP_DISTANCE)), 1), PHYSICS_MAX_SUBSTEPS);
+}
+
+IntegrationKernel Integration::GetKernel()
+{
+    for (int kernel = NUM_INTEGRATION_KERNELS - 1; kernel > INTEGRATION_KERNEL_SCALAR; kernel--)
+    {
+        if (IsKernelSupported(static_cast<IntegrationKernel>(kernel)))
+        {
+            return static_cast<IntegrationKernel>(kernel);
+        }
+    }
+    return INTEGRATION_KERNEL_SCALAR;
+}
+
+bool Integration::IsKernelSupported(IntegrationKernel kernel)
+{
+    switch (kernel)
+    {
+        case INTEGRATION_KERNEL_SCALAR:
+            return true;
+#ifdef INTEGRATION_X86
+        // SSE2 is part of every x86-64 CPU
+        case INTEGRATION_KERNEL_SSE2:
+            return true;
+        case INTEGRATION_KERNEL_AVX2:
+            return HasAvx2();
+#endif
+        default:
+            return false;
+    }
+}
+
+const char* Integration::GetKernelName(IntegrationKernel kernel)
+{
+    switch (kernel)
+    {
+        case INTEGRATION_KERNEL_SCALAR: return "scalar";
+        case INTEGRATION_KERNEL_SSE2: return "sse2";
+        case INTEGRATION_KERNEL_AVX2: return "avx2";
+        default: return "unknown";
+    }
+}
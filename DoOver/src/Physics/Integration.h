@@ -0,0 +1,48 @@
+#ifndef INTEGRATION_H
+#define INTEGRATION_H
+
+#include "../Components/TransformComponent.h"
+#include "../Components/RigidBodyComponent.h"
+#include "../Components/PhysicsMaterialComponent.h"
+
+// Farthest a body with forces moves in one substep, in world pixels
+const float PHYSICS_SUBSTEP_DISTANCE = 8.0f;
+const int PHYSICS_MAX_SUBSTEPS = 8;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Integration
+/////////////////////////////////////////////////////////////////////////////////////////////
+// position += velocity * step over contiguous transforms and rigid bodies, the previous
+// position takes the old one. The transforms are 16-byte aligned with the position next to
+// the previous position, so one 128-bit lane holds both. The AVX2 kernel integrates 8
+// entities per iteration, the SSE2 one a single entity per instruction. The widest kernel
+// the CPU supports is picked at the first call, so one binary runs everywhere.
+// The bodies with a physics material go through the scalar semi-implicit Euler instead.
+/////////////////////////////////////////////////////////////////////////////////////////////
+enum IntegrationKernel
+{
+    INTEGRATION_KERNEL_SCALAR,
+    INTEGRATION_KERNEL_SSE2,
+    INTEGRATION_KERNEL_AVX2,
+    NUM_INTEGRATION_KERNELS
+};
+
+class Integration
+{
+public:
+    static void IntegratePositions(TransformComponent* transforms, const RigidBodyComponent* rigidBodies, int count, float step);
+    // Runs a given kernel, for the benchmarks. It must be supported.
+    static void IntegratePositions(IntegrationKernel kernel, TransformComponent* transforms, const RigidBodyComponent* rigidBodies, int count, float step);
+
+    // Semi-implicit Euler: the velocity takes the acceleration and the damping, then moves the
+    // position. A body with forces that would move farther than PHYSICS_SUBSTEP_DISTANCE is
+    // integrated in as many substeps, the slow ones and the ones without forces in one.
+    static void IntegrateBody(TransformComponent& transform, RigidBodyComponent& rigidBody, const PhysicsMaterialComponent& material, float step);
+    static int GetNumSubsteps(const RigidBodyComponent& rigidBody, const PhysicsMaterialComponent& material, float step);
+
+    static IntegrationKernel GetKernel();
+    static bool IsKernelSupported(IntegrationKernel kernel);
+    static const char* GetKernelName(IntegrationKernel kernel);
+};
+
+#endif
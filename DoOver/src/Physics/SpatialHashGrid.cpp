@@ -0,0 +1,360 @@
+#include "SpatialHashGrid.h"
+#include "GridTraversal.h"
+#include <cmath>
+#include <algorithm>
+
+SpatialHashGrid::SpatialHashGrid(int cellSize)
+{
+    this->cellSize = std::max(cellSize, 1);
+}
+
+uint64_t SpatialHashGrid::GetCellKey(int x, int y)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+}
+
+SpatialHashGrid::CellRange SpatialHashGrid::GetCellRange(const AABB& box) const
+{
+    CellRange range;
+    range.minX = static_cast<int>(std::floor(box.minX / cellSize));
+    range.minY = static_cast<int>(std::floor(box.minY / cellSize));
+    range.maxX = static_cast<int>(std::floor(box.maxX / cellSize));
+    range.maxY = static_cast<int>(std::floor(box.maxY / cellSize));
+    return range;
+}
+
+void SpatialHashGrid::InsertIntoCells(Entity entity, const CellRange& range)
+{
+    for (int y = range.minY; y <= range.maxY; y++)
+    {
+        for (int x = range.minX; x <= range.maxX; x++)
+        {
+            auto& cell = cells[GetCellKey(x, y)];
+            cell.x = x;
+            cell.y = y;
+            cell.entities.push_back(entity);
+        }
+    }
+}
+
+void SpatialHashGrid::RemoveFromCells(Entity entity, const CellRange& range)
+{
+    for (int y = range.minY; y <= range.maxY; y++)
+    {
+        for (int x = range.minX; x <= range.maxX; x++)
+        {
+            auto cell = cells.find(GetCellKey(x, y));
+            if (cell == cells.end())
+            {
+                continue;
+            }
+            auto& entities = cell->second.entities;
+            auto it = std::find(entities.begin(), entities.end(), entity);
+            if (it != entities.end())
+            {
+                *it = entities.back();
+                entities.pop_back();
+            }
+            if (entities.empty())
+            {
+                cells.erase(cell);
+            }
+        }
+    }
+}
+
+void SpatialHashGrid::BeginFrame()
+{
+    frame++;
+}
+
+void SpatialHashGrid::Update(Entity entity, const AABB& box, uint32_t layer, uint32_t mask)
+{
+    const int entityId = entity.GetId();
+    if (entityId >= static_cast<int>(proxies.size()))
+    {
+        proxies.resize(entityId + 1);
+    }
+
+    auto& proxy = proxies[entityId];
+    const auto range = GetCellRange(box);
+    proxy.box = box;
+    proxy.layer = layer;
+    proxy.mask = mask;
+    proxy.frame = frame;
+    proxy.isSleeping = false;
+
+    // A recycled id holds the cells of the killed entity, start over
+    if (proxy.isInserted && proxy.entity != entity)
+    {
+        RemoveFromCells(proxy.entity, proxy.range);
+        proxy.isInserted = false;
+    }
+
+    if (!proxy.isInserted)
+    {
+        InsertIntoCells(entity, range);
+        proxy.entity = entity;
+        proxy.range = range;
+        proxy.isInserted = true;
+        insertedIds.push_back(entityId);
+    }
+    else if (!(proxy.range == range))
+    {
+        RemoveFromCells(entity, proxy.range);
+        InsertIntoCells(entity, range);
+        proxy.range = range;
+    }
+}
+
+void SpatialHashGrid::EndFrame()
+{
+    for (size_t i = 0; i < insertedIds.size();)
+    {
+        auto& proxy = proxies[insertedIds[i]];
+        if (!proxy.isInserted || (proxy.frame != frame && !proxy.isSleeping))
+        {
+            if (proxy.isInserted)
+            {
+                RemoveFromCells(proxy.entity, proxy.range);
+                proxy.isInserted = false;
+            }
+            insertedIds[i] = insertedIds.back();
+            insertedIds.pop_back();
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+void SpatialHashGrid::SetSleeping(Entity entity, bool isSleeping)
+{
+    const int entityId = entity.GetId();
+    if (entityId < static_cast<int>(proxies.size()) && proxies[entityId].isInserted && proxies[entityId].entity == entity)
+    {
+        proxies[entityId].isSleeping = isSleeping;
+    }
+}
+
+void SpatialHashGrid::Remove(Entity entity)
+{
+    const int entityId = entity.GetId();
+    if (entityId >= static_cast<int>(proxies.size()))
+    {
+        return;
+    }
+    auto& proxy = proxies[entityId];
+    if (proxy.isInserted && proxy.entity == entity)
+    {
+        // The id is dropped from insertedIds on the next EndFrame
+        RemoveFromCells(proxy.entity, proxy.range);
+        proxy.isInserted = false;
+    }
+}
+
+void SpatialHashGrid::Clear()
+{
+    cells.clear();
+    proxies.clear();
+    insertedIds.clear();
+}
+
+void SpatialHashGrid::QueryPairs(std::vector<std::pair<Entity, Entity>>& pairs) const
+{
+    for (const auto& keyValue: cells)
+    {
+        const auto& cell = keyValue.second;
+        const auto& entities = cell.entities;
+        for (size_t i = 0; i < entities.size(); i++)
+        {
+            const auto& a = proxies[entities[i].GetId()];
+            for (size_t j = i + 1; j < entities.size(); j++)
+            {
+                const auto& b = proxies[entities[j].GetId()];
+                if (!LayersCollide(a.layer, a.mask, b.layer, b.mask))
+                {
+                    continue;
+                }
+
+                // Pairs sharing several cells are only reported by the first cell they share
+                if (std::max(a.range.minX, b.range.minX) != cell.x || std::max(a.range.minY, b.range.minY) != cell.y)
+                {
+                    continue;
+                }
+                pairs.emplace_back(entities[i], entities[j]);
+            }
+        }
+    }
+}
+
+uint32_t SpatialHashGrid::NextQueryStamp() const
+{
+    queryStamps.resize(proxies.size(), 0);
+    // On wrap around the old stamps could pass for the new query's
+    if (++queryStamp == 0)
+    {
+        std::fill(queryStamps.begin(), queryStamps.end(), 0);
+        queryStamp = 1;
+    }
+    return queryStamp;
+}
+
+void SpatialHashGrid::QueryCell(int x, int y, glm::vec2 point, float radiusSquared, uint32_t layers, std::vector<BroadphaseHit>& hits) const
+{
+    const auto cell = cells.find(GetCellKey(x, y));
+    if (cell == cells.end())
+    {
+        return;
+    }
+    for (const auto& entity: cell->second.entities)
+    {
+        const int entityId = entity.GetId();
+        const auto& proxy = proxies[entityId];
+        if (queryStamps[entityId] == queryStamp || !(proxy.layer & layers))
+        {
+            continue;
+        }
+        queryStamps[entityId] = queryStamp;
+        const float distanceSquared = DistanceSquared(proxy.box, point.x, point.y);
+        if (distanceSquared <= radiusSquared)
+        {
+            hits.push_back({entity, proxy.box, distanceSquared});
+        }
+    }
+}
+
+void SpatialHashGrid::QueryRadius(glm::vec2 point, float radius, uint32_t layers, std::vector<BroadphaseHit>& hits) const
+{
+    NextQueryStamp();
+    const CellRange range = GetCellRange(AABB(point.x - radius, point.y - radius, point.x + radius, point.y + radius));
+    for (int y = range.minY; y <= range.maxY; y++)
+    {
+        for (int x = range.minX; x <= range.maxX; x++)
+        {
+            QueryCell(x, y, point, radius * radius, layers, hits);
+        }
+    }
+}
+
+void SpatialHashGrid::QueryNearest(glm::vec2 point, float radius, uint32_t layers, int k, std::vector<BroadphaseHit>& hits) const
+{
+    if (k <= 0)
+    {
+        return;
+    }
+    NextQueryStamp();
+    const auto isNearer = [](const BroadphaseHit& a, const BroadphaseHit& b) { return a.distanceSquared < b.distanceSquared; };
+    const size_t firstHit = hits.size();
+    const int centerX = static_cast<int>(std::floor(point.x / cellSize));
+    const int centerY = static_cast<int>(std::floor(point.y / cellSize));
+    const int maxRing = static_cast<int>(std::ceil(radius / cellSize));
+    // The boxes of the rings searched, the k nearest kept at the front
+    float radiusSquared = radius * radius;
+    for (int ring = 0; ring <= maxRing; ring++)
+    {
+        // A whole ring of cells lies between the point's cell and this ring
+        const float ringDistance = std::max(ring - 1, 0) * static_cast<float>(cellSize);
+        if (ringDistance * ringDistance > radiusSquared)
+        {
+            break;
+        }
+        for (int y = centerY - ring; y <= centerY + ring; y++)
+        {
+            // Only the border of the square, the inside was searched by the previous rings
+            const int step = (y == centerY - ring || y == centerY + ring) ? 1 : std::max(2 * ring, 1);
+            for (int x = centerX - ring; x <= centerX + ring; x += step)
+            {
+                QueryCell(x, y, point, radiusSquared, layers, hits);
+            }
+        }
+        // Once k are found the radius shrinks to the kth, the farther boxes can't make it
+        if (hits.size() - firstHit >= static_cast<size_t>(k))
+        {
+            std::nth_element(hits.begin() + firstHit, hits.begin() + firstHit + k - 1, hits.end(), isNearer);
+            hits.resize(firstHit + k);
+            radiusSquared = hits.back().distanceSquared;
+        }
+    }
+    std::sort(hits.begin() + firstHit, hits.end(), isNearer);
+}
+
+void SpatialHashGrid::QueryBox(const AABB& box, uint32_t layers, std::vector<Entity>& entities) const
+{
+    const CellRange range = GetCellRange(box);
+    for (int y = range.minY; y <= range.maxY; y++)
+    {
+        for (int x = range.minX; x <= range.maxX; x++)
+        {
+            const auto cell = cells.find(GetCellKey(x, y));
+            if (cell == cells.end())
+            {
+                continue;
+            }
+            for (const auto& entity: cell->second.entities)
+            {
+                const auto& proxy = proxies[entity.GetId()];
+                // A box over several cells is reported by the first cell it shares with the query
+                if (std::max(proxy.range.minX, range.minX) != x || std::max(proxy.range.minY, range.minY) != y)
+                {
+                    continue;
+                }
+                if ((proxy.layer & layers) && box.Overlaps(proxy.box))
+                {
+                    entities.push_back(entity);
+                }
+            }
+        }
+    }
+}
+
+bool SpatialHashGrid::Raycast(glm::vec2 start, glm::vec2 end, uint32_t layers, RaycastHit& hit) const
+{
+    const glm::vec2 delta = end - start;
+    // Past the end of the segment until a box is hit
+    hit.fraction = 2.0f;
+    TraverseGrid(start, end, 0.0f, 0.0f, static_cast<float>(cellSize), [&](int x, int y, float exitFraction)
+    {
+        const auto cell = cells.find(GetCellKey(x, y));
+        if (cell != cells.end())
+        {
+            // A box over several cells may be tested again, it gives the same hit
+            for (const auto& entity: cell->second.entities)
+            {
+                const auto& proxy = proxies[entity.GetId()];
+                float fraction;
+                glm::vec2 normal;
+                if ((proxy.layer & layers) && RaycastAABB(proxy.box, start.x, start.y, delta.x, delta.y, fraction, normal.x, normal.y) && fraction < hit.fraction)
+                {
+                    hit = {entity, fraction, start + delta * fraction, normal};
+                }
+            }
+        }
+        // The cells that follow are all farther than a hit inside this one
+        return hit.fraction > exitFraction;
+    });
+    return hit.fraction <= 1.0f;
+}
+
+void SpatialHashGrid::GetDebugCells(std::vector<AABB>& cells) const
+{
+    for (const auto& entry: this->cells)
+    {
+        const Cell& cell = entry.second;
+        if (!cell.entities.empty())
+        {
+            cells.push_back(AABB(cell.x * cellSize, cell.y * cellSize, (cell.x + 1) * cellSize, (cell.y + 1) * cellSize));
+        }
+    }
+}
+
+int SpatialHashGrid::GetCellSize() const
+{
+    return cellSize;
+}
+
+int SpatialHashGrid::GetNumCells() const
+{
+    return cells.size();
+}
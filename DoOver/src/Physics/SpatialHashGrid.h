@@ -0,0 +1,92 @@
+#ifndef SPATIALHASHGRID_H
+#define SPATIALHASHGRID_H
+
+#include "../ECS/ECS.h"
+#include "Broadphase.h"
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <cstdint>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Spatial Hash Grid
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Broadphase that buckets the entities into the uniform grid cells their box overlaps.
+// The grid persists between frames: an entity is only moved to other cells when its box
+// crosses a cell boundary, and only the entities sharing a cell become candidate pairs.
+// The nearest boxes to a point are searched ring of cells by ring of cells outwards, until
+// the next ring is farther than the k found so far. A segment walks the cells it crosses in
+// order and stops at the first cell past the nearest hit.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class SpatialHashGrid: public IBroadphase
+{
+private:
+    struct CellRange
+    {
+        int minX, minY, maxX, maxY;
+        bool operator ==(const CellRange& other) const { return minX == other.minX && minY == other.minY && maxX == other.maxX && maxY == other.maxY; }
+    };
+
+    struct Cell
+    {
+        int x;
+        int y;
+        std::vector<Entity> entities;
+    };
+
+    // Per entity id: the cells the entity is inserted in and the last frame it was updated
+    struct Proxy
+    {
+        Entity entity = Entity(0, 0, 0);
+        CellRange range;
+        AABB box;
+        uint32_t layer = 0;
+        uint32_t mask = 0;
+        int frame = -1;
+        bool isInserted = false;
+        // Kept without the updates
+        bool isSleeping = false;
+    };
+
+    int cellSize;
+    int frame = 0;
+    std::unordered_map<uint64_t, Cell> cells;
+    std::vector<Proxy> proxies;
+    std::vector<int> insertedIds;
+    // A box over several cells is taken once per query, the queries stamp the proxies they
+    // took. Not meant to be queried from several threads at a time.
+    mutable std::vector<uint32_t> queryStamps;
+    mutable uint32_t queryStamp = 0;
+
+    static uint64_t GetCellKey(int x, int y);
+    CellRange GetCellRange(const AABB& box) const;
+    void InsertIntoCells(Entity entity, const CellRange& range);
+    void RemoveFromCells(Entity entity, const CellRange& range);
+    uint32_t NextQueryStamp() const;
+    // Appends the boxes of one cell that are in reach and not yet taken by the query
+    void QueryCell(int x, int y, glm::vec2 point, float radiusSquared, uint32_t layers, std::vector<BroadphaseHit>& hits) const;
+
+public:
+    SpatialHashGrid(int cellSize = DEFAULT_CELL_SIZE);
+
+    void BeginFrame() override;
+    void Update(Entity entity, const AABB& box, uint32_t layer, uint32_t mask) override;
+    void EndFrame() override;
+    void SetSleeping(Entity entity, bool isSleeping) override;
+
+    void Remove(Entity entity) override;
+    void Clear() override;
+
+    // Appends the pairs sharing at least one cell
+    void QueryPairs(std::vector<std::pair<Entity, Entity>>& pairs) const override;
+    void QueryRadius(glm::vec2 point, float radius, uint32_t layers, std::vector<BroadphaseHit>& hits) const override;
+    void QueryNearest(glm::vec2 point, float radius, uint32_t layers, int k, std::vector<BroadphaseHit>& hits) const override;
+    void QueryBox(const AABB& box, uint32_t layers, std::vector<Entity>& entities) const override;
+    bool Raycast(glm::vec2 start, glm::vec2 end, uint32_t layers, RaycastHit& hit) const override;
+    void GetDebugCells(std::vector<AABB>& cells) const override;
+
+    int GetCellSize() const;
+    int GetNumCells() const override;
+};
+
+#endif
@@ -0,0 +1,190 @@
+#include "StaticColliderGrid.h"
+#include "GridTraversal.h"
+#include <cmath>
+#include <algorithm>
+
+StaticColliderGrid::StaticColliderGrid(int cellSize)
+{
+    this->cellSize = std::max(cellSize, 1);
+}
+
+bool StaticColliderGrid::GetCellRange(const AABB& box, int& minCol, int& minRow, int& maxCol, int& maxRow) const
+{
+    minCol = std::max(static_cast<int>(std::floor((box.minX - originX) / cellSize)), 0);
+    minRow = std::max(static_cast<int>(std::floor((box.minY - originY) / cellSize)), 0);
+    maxCol = std::min(static_cast<int>(std::floor((box.maxX - originX) / cellSize)), numCols - 1);
+    maxRow = std::min(static_cast<int>(std::floor((box.maxY - originY) / cellSize)), numRows - 1);
+    return minCol <= maxCol && minRow <= maxRow;
+}
+
+void StaticColliderGrid::Build(std::vector<StaticCollider> colliders)
+{
+    Clear();
+    this->colliders = std::move(colliders);
+    if (this->colliders.empty())
+    {
+        return;
+    }
+
+    AABB bounds = this->colliders[0].box;
+    for (const auto& collider: this->colliders)
+    {
+        bounds.minX = std::min(bounds.minX, collider.box.minX);
+        bounds.minY = std::min(bounds.minY, collider.box.minY);
+        bounds.maxX = std::max(bounds.maxX, collider.box.maxX);
+        bounds.maxY = std::max(bounds.maxY, collider.box.maxY);
+    }
+    originX = bounds.minX;
+    originY = bounds.minY;
+    numCols = static_cast<int>((bounds.maxX - bounds.minX) / cellSize) + 1;
+    numRows = static_cast<int>((bounds.maxY - bounds.minY) / cellSize) + 1;
+
+    // Count the colliders per cell, then place them (counting sort)
+    cellStarts.assign(numCols * numRows + 1, 0);
+    int minCol, minRow, maxCol, maxRow;
+    for (const auto& collider: this->colliders)
+    {
+        GetCellRange(collider.box, minCol, minRow, maxCol, maxRow);
+        for (int row = minRow; row <= maxRow; row++)
+        {
+            for (int col = minCol; col <= maxCol; col++)
+            {
+                cellStarts[row * numCols + col + 1]++;
+            }
+        }
+    }
+    for (size_t i = 1; i < cellStarts.size(); i++)
+    {
+        cellStarts[i] += cellStarts[i - 1];
+    }
+
+    cellColliders.resize(cellStarts.back());
+    std::vector<int> cellFill(cellStarts.begin(), cellStarts.end() - 1);
+    for (int i = 0; i < static_cast<int>(this->colliders.size()); i++)
+    {
+        GetCellRange(this->colliders[i].box, minCol, minRow, maxCol, maxRow);
+        for (int row = minRow; row <= maxRow; row++)
+        {
+            for (int col = minCol; col <= maxCol; col++)
+            {
+                cellColliders[cellFill[row * numCols + col]++] = i;
+            }
+        }
+    }
+    queryStamps.assign(this->colliders.size(), 0);
+}
+
+void StaticColliderGrid::Clear()
+{
+    colliders.clear();
+    cellStarts.clear();
+    cellColliders.clear();
+    queryStamps.clear();
+    numCols = 0;
+    numRows = 0;
+}
+
+int StaticColliderGrid::GetSize() const
+{
+    return colliders.size();
+}
+
+void StaticColliderGrid::Query(const AABB& box, uint32_t layer, uint32_t mask, std::vector<int>& colliderIndices) const
+{
+    int minCol, minRow, maxCol, maxRow;
+    if (colliders.empty() || !GetCellRange(box, minCol, minRow, maxCol, maxRow))
+    {
+        return;
+    }
+
+    queryStamp++;
+    for (int row = minRow; row <= maxRow; row++)
+    {
+        for (int col = minCol; col <= maxCol; col++)
+        {
+            const int cell = row * numCols + col;
+            for (int i = cellStarts[cell]; i < cellStarts[cell + 1]; i++)
+            {
+                const int index = cellColliders[i];
+                if (queryStamps[index] == queryStamp)
+                {
+                    continue;
+                }
+                queryStamps[index] = queryStamp;
+
+                const auto& collider = colliders[index];
+                if ((layer & collider.mask) && (collider.layer & mask) && box.Overlaps(collider.box))
+                {
+                    colliderIndices.push_back(index);
+                }
+            }
+        }
+    }
+}
+
+const StaticCollider& StaticColliderGrid::GetCollider(int index) const
+{
+    return colliders[index];
+}
+
+void StaticColliderGrid::QueryLayers(const AABB& box, uint32_t layers, std::vector<int>& colliderIndices) const
+{
+    int minCol, minRow, maxCol, maxRow;
+    if (colliders.empty() || !GetCellRange(box, minCol, minRow, maxCol, maxRow))
+    {
+        return;
+    }
+    for (int row = minRow; row <= maxRow; row++)
+    {
+        for (int col = minCol; col <= maxCol; col++)
+        {
+            const int cell = row * numCols + col;
+            for (int i = cellStarts[cell]; i < cellStarts[cell + 1]; i++)
+            {
+                const int index = cellColliders[i];
+                const auto& collider = colliders[index];
+                // A collider over several cells is reported by the first cell it shares with the query
+                int colliderMinCol, colliderMinRow, colliderMaxCol, colliderMaxRow;
+                GetCellRange(collider.box, colliderMinCol, colliderMinRow, colliderMaxCol, colliderMaxRow);
+                if (std::max(colliderMinCol, minCol) != col || std::max(colliderMinRow, minRow) != row)
+                {
+                    continue;
+                }
+                if ((collider.layer & layers) && box.Overlaps(collider.box))
+                {
+                    colliderIndices.push_back(index);
+                }
+            }
+        }
+    }
+}
+
+bool StaticColliderGrid::Raycast(glm::vec2 start, glm::vec2 end, uint32_t layers, RaycastHit& hit) const
+{
+    const glm::vec2 delta = end - start;
+    // Past the end of the segment until a collider is hit
+    hit.fraction = 2.0f;
+    if (colliders.empty())
+    {
+        return false;
+    }
+    TraverseGrid(start, end, originX, originY, static_cast<float>(cellSize), [&](int col, int row, float exitFraction)
+    {
+        if (col >= 0 && row >= 0 && col < numCols && row < numRows)
+        {
+            const int cell = row * numCols + col;
+            for (int i = cellStarts[cell]; i < cellStarts[cell + 1]; i++)
+            {
+                const auto& collider = colliders[cellColliders[i]];
+                float fraction;
+                glm::vec2 normal;
+                if ((collider.layer & layers) && RaycastAABB(collider.box, start.x, start.y, delta.x, delta.y, fraction, normal.x, normal.y) && fraction < hit.fraction)
+                {
+                    hit = {collider.entity, fraction, start + delta * fraction, normal};
+                }
+            }
+        }
+        return hit.fraction > exitFraction;
+    });
+    return hit.fraction <= 1.0f;
+}
@@ -0,0 +1,63 @@
+#ifndef STATICCOLLIDERGRID_H
+#define STATICCOLLIDERGRID_H
+
+#include "../ECS/ECS.h"
+#include "Broadphase.h"
+#include <vector>
+#include <cstdint>
+
+struct StaticCollider
+{
+    Entity entity;
+    AABB box;
+    uint32_t layer;
+    uint32_t mask;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Static Collider Grid
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Uniform grid of the colliders that never move, built once over their bounds. The cells
+// are packed in a single array (each cell is a range of collider indices), so the queries
+// of the dynamic boxes don't allocate nor chase pointers. The segments walk the cells they
+// cross in order and stop at the first cell past the nearest hit.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class StaticColliderGrid
+{
+private:
+    std::vector<StaticCollider> colliders;
+
+    float originX = 0;
+    float originY = 0;
+    int cellSize;
+    int numCols = 0;
+    int numRows = 0;
+
+    // [cell] -> first index in cellColliders, the cell ends where the next one starts
+    std::vector<int> cellStarts;
+    std::vector<int> cellColliders;
+
+    // Last query that reported each collider, so colliders spanning cells are reported once
+    mutable std::vector<int> queryStamps;
+    mutable int queryStamp = 0;
+
+    bool GetCellRange(const AABB& box, int& minCol, int& minRow, int& maxCol, int& maxRow) const;
+
+public:
+    StaticColliderGrid(int cellSize = DEFAULT_CELL_SIZE);
+
+    void Build(std::vector<StaticCollider> colliders);
+    void Clear();
+    int GetSize() const;
+
+    // Appends the index of the colliders overlapping the box whose layers collide with the given ones
+    void Query(const AABB& box, uint32_t layer, uint32_t mask, std::vector<int>& colliderIndices) const;
+    // Like Query against the layers only, without the stamps, so the workers can run it side by side
+    void QueryLayers(const AABB& box, uint32_t layers, std::vector<int>& colliderIndices) const;
+    // The nearest collider on one of the layers given the segment runs into, false when none.
+    // Only reads the grid too.
+    bool Raycast(glm::vec2 start, glm::vec2 end, uint32_t layers, RaycastHit& hit) const;
+    const StaticCollider& GetCollider(int index) const;
+};
+
+#endif
@@ -0,0 +1,197 @@
+#include "SweepAndPrune.h"
+#include <algorithm>
+
+bool SweepAndPrune::IsBefore(const Endpoint& a, const Endpoint& b)
+{
+    // On ties close the boxes before opening new ones, touching boxes don't overlap
+    return a.value < b.value || (a.value == b.value && !a.isMin && b.isMin);
+}
+
+void SweepAndPrune::BeginFrame()
+{
+    frame++;
+}
+
+void SweepAndPrune::Update(Entity entity, const AABB& box, uint32_t layer, uint32_t mask)
+{
+    const int entityId = entity.GetId();
+    if (entityId >= static_cast<int>(proxies.size()))
+    {
+        proxies.resize(entityId + 1);
+    }
+
+    auto& proxy = proxies[entityId];
+    proxy.entity = entity;
+    proxy.box = box;
+    proxy.layer = layer;
+    proxy.mask = mask;
+    proxy.frame = frame;
+    proxy.isSleeping = false;
+
+    if (!proxy.isInserted)
+    {
+        // New endpoints go to the back, the sort at EndFrame moves them in place
+        endpoints.push_back({box.minX, entityId, true});
+        endpoints.push_back({box.maxX, entityId, false});
+        proxy.isInserted = true;
+    }
+}
+
+void SweepAndPrune::EndFrame()
+{
+    // Drop the endpoints of the entities that weren't updated this frame, unless they sleep
+    for (auto& endpoint: endpoints)
+    {
+        auto& proxy = proxies[endpoint.entityId];
+        if (proxy.frame != frame && !proxy.isSleeping)
+        {
+            proxy.isInserted = false;
+            hasRemovedProxies = true;
+        }
+    }
+    if (hasRemovedProxies)
+    {
+        endpoints.erase(std::remove_if(endpoints.begin(), endpoints.end(), [this](const Endpoint& endpoint) { return !proxies[endpoint.entityId].isInserted; }), endpoints.end());
+        hasRemovedProxies = false;
+    }
+
+    // Refresh the endpoints and restore the order, insertion sort is linear on nearly sorted lists
+    for (auto& endpoint: endpoints)
+    {
+        const auto& box = proxies[endpoint.entityId].box;
+        endpoint.value = endpoint.isMin ? box.minX : box.maxX;
+    }
+    for (size_t i = 1; i < endpoints.size(); i++)
+    {
+        const Endpoint endpoint = endpoints[i];
+        size_t j = i;
+        while (j > 0 && IsBefore(endpoint, endpoints[j - 1]))
+        {
+            endpoints[j] = endpoints[j - 1];
+            j--;
+        }
+        endpoints[j] = endpoint;
+    }
+}
+
+void SweepAndPrune::Remove(Entity entity)
+{
+    const int entityId = entity.GetId();
+    if (entityId >= static_cast<int>(proxies.size()) || proxies[entityId].entity != entity)
+    {
+        return;
+    }
+    // The endpoints are dropped on the next EndFrame
+    proxies[entityId].frame = -1;
+    proxies[entityId].isSleeping = false;
+}
+
+void SweepAndPrune::SetSleeping(Entity entity, bool isSleeping)
+{
+    const int entityId = entity.GetId();
+    if (entityId < static_cast<int>(proxies.size()) && proxies[entityId].isInserted && proxies[entityId].entity == entity)
+    {
+        proxies[entityId].isSleeping = isSleeping;
+    }
+}
+
+void SweepAndPrune::Clear()
+{
+    endpoints.clear();
+    proxies.clear();
+    hasRemovedProxies = false;
+}
+
+void SweepAndPrune::QueryPairs(std::vector<std::pair<Entity, Entity>>& pairs) const
+{
+    activeIds.clear();
+    for (const auto& endpoint: endpoints)
+    {
+        if (!endpoint.isMin)
+        {
+            auto it = std::find(activeIds.begin(), activeIds.end(), endpoint.entityId);
+            if (it != activeIds.end())
+            {
+                *it = activeIds.back();
+                activeIds.pop_back();
+            }
+            continue;
+        }
+
+        // Every open box overlaps the new one on x, test the layers and the y axis
+        const auto& proxy = proxies[endpoint.entityId];
+        for (auto activeId: activeIds)
+        {
+            const auto& other = proxies[activeId];
+            if (LayersCollide(proxy.layer, proxy.mask, other.layer, other.mask) && proxy.box.Overlaps(other.box))
+            {
+                pairs.emplace_back(other.entity, proxy.entity);
+            }
+        }
+        activeIds.push_back(endpoint.entityId);
+    }
+}
+
+void SweepAndPrune::QueryRadius(glm::vec2 point, float radius, uint32_t layers, std::vector<BroadphaseHit>& hits) const
+{
+    const float radiusSquared = radius * radius;
+    for (const auto& endpoint: endpoints)
+    {
+        // Sorted by their left edge, the boxes that follow are all out of reach
+        if (endpoint.value > point.x + radius)
+        {
+            break;
+        }
+        const auto& proxy = proxies[endpoint.entityId];
+        if (!endpoint.isMin || !(proxy.layer & layers))
+        {
+            continue;
+        }
+        const float distanceSquared = DistanceSquared(proxy.box, point.x, point.y);
+        if (distanceSquared <= radiusSquared)
+        {
+            hits.push_back({proxy.entity, proxy.box, distanceSquared});
+        }
+    }
+}
+
+void SweepAndPrune::QueryBox(const AABB& box, uint32_t layers, std::vector<Entity>& entities) const
+{
+    for (const auto& endpoint: endpoints)
+    {
+        if (endpoint.value > box.maxX)
+        {
+            break;
+        }
+        const auto& proxy = proxies[endpoint.entityId];
+        if (endpoint.isMin && (proxy.layer & layers) && box.Overlaps(proxy.box))
+        {
+            entities.push_back(proxy.entity);
+        }
+    }
+}
+
+bool SweepAndPrune::Raycast(glm::vec2 start, glm::vec2 end, uint32_t layers, RaycastHit& hit) const
+{
+    const glm::vec2 delta = end - start;
+    const float maxX = std::max(start.x, end.x);
+    // Past the end of the segment until a box is hit
+    hit.fraction = 2.0f;
+    for (const auto& endpoint: endpoints)
+    {
+        // Past the segment, or going right past the hit found so far
+        const float reachX = delta.x >= 0.0f ? start.x + delta.x * std::min(hit.fraction, 1.0f) : maxX;
+        if (endpoint.value > reachX)
+        {
+            break;
+        }
+        const auto& proxy = proxies[endpoint.entityId];
+        float fraction;
+        glm::vec2 normal;
+        if (endpoint.isMin && (proxy.layer & layers) && RaycastAABB(proxy.box, start.x, start.y, delta.x, delta.y, fraction, normal.x, normal.y) && fraction < hit.fraction)
+        {
+            hit = {proxy.entity, fraction, start + delta * fraction, normal};
+        }
+    }
+    return hit.fraction <= 1.0f;
+}
@@ -0,0 +1,69 @@
+#ifndef SWEEPANDPRUNE_H
+#define SWEEPANDPRUNE_H
+
+#include "../ECS/ECS.h"
+#include "Broadphase.h"
+#include <vector>
+#include <utility>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Sweep And Prune
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Broadphase that keeps the x-axis endpoints of every box in a persistent sorted list.
+// The boxes barely move between frames, so the insertion sort that restores the order is
+// close to O(n), and the sweep over the list only tests the boxes overlapping on x.
+// It doesn't depend on a cell size, which makes it a better fit when box sizes vary a lot.
+// A query stops at the first box starting past the right of the area it looks at.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class SweepAndPrune: public IBroadphase
+{
+private:
+    struct Endpoint
+    {
+        float value;
+        int entityId;
+        bool isMin;
+    };
+
+    // Per entity id: its current box and the last frame it was updated
+    struct Proxy
+    {
+        Entity entity = Entity(0, 0, 0);
+        AABB box;
+        uint32_t layer = 0;
+        uint32_t mask = 0;
+        int frame = -1;
+        bool isInserted = false;
+        // Kept without the updates
+        bool isSleeping = false;
+    };
+
+    int frame = 0;
+    std::vector<Endpoint> endpoints;
+    std::vector<Proxy> proxies;
+    bool hasRemovedProxies = false;
+
+    // Scratch list of the boxes open during the sweep
+    mutable std::vector<int> activeIds;
+
+    static bool IsBefore(const Endpoint& a, const Endpoint& b);
+
+public:
+    SweepAndPrune() = default;
+
+    void BeginFrame() override;
+    void Update(Entity entity, const AABB& box, uint32_t layer, uint32_t mask) override;
+    void EndFrame() override;
+    void SetSleeping(Entity entity, bool isSleeping) override;
+
+    void Remove(Entity entity) override;
+    void Clear() override;
+
+    // Appends the pairs overlapping on both axes
+    void QueryPairs(std::vector<std::pair<Entity, Entity>>& pairs) const override;
+    void QueryRadius(glm::vec2 point, float radius, uint32_t layers, std::vector<BroadphaseHit>& hits) const override;
+    void QueryBox(const AABB& box, uint32_t layers, std::vector<Entity>& entities) const override;
+    bool Raycast(glm::vec2 start, glm::vec2 end, uint32_t layers, RaycastHit& hit) const override;
+};
+
+#endif
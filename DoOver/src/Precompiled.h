@@ -0,0 +1,22 @@
+#ifndef PRECOMPILED_H
+#define PRECOMPILED_H
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Precompiled header
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The heavy headers most translation units pull in, compiled once per build config by the
+// Makefile and included ahead of every source file. Only headers that hardly ever change
+// belong here, touching this file rebuilds everything.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include <SDL2/SDL.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#endif
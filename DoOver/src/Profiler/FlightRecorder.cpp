@@ -0,0 +1,228 @@
+#include "FlightRecorder.h"
+#include "Profiler.h"
+#include "../EventBus/EventBus.h"
+#include <algorithm>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+std::array<FlightRecorder::Frame, FLIGHT_RECORDER_FRAMES> FlightRecorder::frames;
+volatile uint32_t FlightRecorder::numFrames = 0;
+char FlightRecorder::scopeNames[FLIGHT_RECORDER_MAX_SCOPES][FLIGHT_RECORDER_NAME_SIZE];
+char FlightRecorder::eventNames[FLIGHT_RECORDER_MAX_EVENT_TYPES][FLIGHT_RECORDER_NAME_SIZE];
+int FlightRecorder::numScopes = 0;
+int FlightRecorder::numEventTypes = 0;
+uint64_t FlightRecorder::previousNumEvents[FLIGHT_RECORDER_MAX_EVENT_TYPES];
+char FlightRecorder::filePath[256];
+bool FlightRecorder::isInstalled = false;
+
+// Set by the first crash, a crash while writing the file doesn't write it again
+static volatile std::sig_atomic_t isCrashing = 0;
+
+// Formats a line at a time into its own buffer and writes it with the plain system calls,
+// which a signal handler may make
+class CrashFileWriter
+{
+private:
+    int file;
+    char buffer[4096];
+    size_t size = 0;
+
+public:
+    explicit CrashFileWriter(const char* filePath)
+    {
+#ifdef _WIN32
+        file = _open(filePath, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, 0644);
+#else
+        file = open(filePath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+    }
+
+    ~CrashFileWriter()
+    {
+        Flush();
+        if (file >= 0)
+        {
+#ifdef _WIN32
+            _close(file);
+#else
+            close(file);
+#endif
+        }
+    }
+
+    bool IsOpen() const { return file >= 0; }
+
+    void Append(const char* text)
+    {
+        for (; *text; text++)
+        {
+            if (size == sizeof(buffer))
+            {
+                Flush();
+            }
+            buffer[size++] = *text;
+        }
+    }
+
+    void AppendNumber(uint32_t number)
+    {
+        char digits[16];
+        int numDigits = 0;
+        do
+        {
+            digits[numDigits++] = '0' + number % 10;
+            number /= 10;
+        }
+        while (number > 0);
+        char text[16];
+        for (int i = 0; i < numDigits; i++)
+        {
+            text[i] = digits[numDigits - 1 - i];
+        }
+        text[numDigits] = '\0';
+        Append(text);
+    }
+
+    void Flush()
+    {
+        if (file >= 0 && size > 0)
+        {
+#ifdef _WIN32
+            _write(file, buffer, static_cast<unsigned int>(size));
+#else
+            // Best effort, there is nothing to do with an error in a crash
+            const ssize_t numWritten = write(file, buffer, size);
+            (void)numWritten;
+#endif
+        }
+        size = 0;
+    }
+};
+
+void FlightRecorder::CopyName(char (&name)[FLIGHT_RECORDER_NAME_SIZE], const std::string& source)
+{
+    std::strncpy(name, source.c_str(), FLIGHT_RECORDER_NAME_SIZE - 1);
+    name[FLIGHT_RECORDER_NAME_SIZE - 1] = '\0';
+    // A comma would shift the columns of the CSV
+    std::replace(name, name + FLIGHT_RECORDER_NAME_SIZE, ',', ' ');
+}
+
+void FlightRecorder::OnCrash(int signal)
+{
+    if (!isCrashing)
+    {
+        isCrashing = 1;
+        Dump(filePath);
+    }
+    // Dies as it would have without the handler
+    std::signal(signal, SIG_DFL);
+    std::raise(signal);
+}
+
+void FlightRecorder::Install(const std::string& filePath)
+{
+    std::strncpy(FlightRecorder::filePath, filePath.c_str(), sizeof(FlightRecorder::filePath) - 1);
+    FlightRecorder::filePath[sizeof(FlightRecorder::filePath) - 1] = '\0';
+    isInstalled = true;
+    for (int signal: {SIGSEGV, SIGABRT, SIGFPE, SIGILL})
+    {
+        std::signal(signal, &FlightRecorder::OnCrash);
+    }
+#ifdef SIGBUS
+    std::signal(SIGBUS, &FlightRecorder::OnCrash);
+#endif
+}
+
+void FlightRecorder::RecordFrame(uint32_t tick, double frameMillisecs, uint32_t inputActions, const EventBus& eventBus)
+{
+    if (!isInstalled)
+    {
+        return;
+    }
+    const uint32_t index = numFrames;
+    Frame& frame = frames[index % FLIGHT_RECORDER_FRAMES];
+    frame.frame = index;
+    frame.tick = tick;
+    frame.frameMicrosecs = static_cast<uint32_t>(std::max(frameMillisecs, 0.0) * 1000.0);
+    frame.inputActions = inputActions;
+
+    const int profilerScopes = std::min(Profiler::GetNumScopes(), FLIGHT_RECORDER_MAX_SCOPES);
+    for (; numScopes < profilerScopes; numScopes++)
+    {
+        CopyName(scopeNames[numScopes], Profiler::GetScopeName(numScopes));
+    }
+    for (int i = 0; i < numScopes; i++)
+    {
+        frame.scopeMicrosecs[i] = static_cast<uint32_t>(Profiler::GetLastFrameMillisecs(i) * 1000.0f);
+    }
+
+    const int busEventTypes = std::min(eventBus.GetNumEventTypes(), FLIGHT_RECORDER_MAX_EVENT_TYPES);
+    for (; numEventTypes < busEventTypes; numEventTypes++)
+    {
+        CopyName(eventNames[numEventTypes], IEventType::GetName(numEventTypes));
+        previousNumEvents[numEventTypes] = 0;
+    }
+    for (int i = 0; i < numEventTypes; i++)
+    {
+        const uint64_t numEmitted = eventBus.GetNumEmitted(i);
+        frame.numEvents[i] = static_cast<uint32_t>(numEmitted - previousNumEvents[i]);
+        previousNumEvents[i] = numEmitted;
+    }
+    // Counted once it is complete, the crash handler never reads a frame half written
+    numFrames = index + 1;
+}
+
+bool FlightRecorder::Dump(const char* filePath)
+{
+    CrashFileWriter writer(filePath);
+    if (!writer.IsOpen())
+    {
+        return false;
+    }
+    writer.Append("frame,tick,frame_us,input");
+    for (int i = 0; i < numScopes; i++)
+    {
+        writer.Append(",");
+        writer.Append(scopeNames[i]);
+        writer.Append("_us");
+    }
+    for (int i = 0; i < numEventTypes; i++)
+    {
+        writer.Append(",");
+        writer.Append(eventNames[i]);
+    }
+    writer.Append("\n");
+
+    const uint32_t end = numFrames;
+    const uint32_t begin = end > FLIGHT_RECORDER_FRAMES ? end - FLIGHT_RECORDER_FRAMES : 0;
+    for (uint32_t index = begin; index < end; index++)
+    {
+        const Frame& frame = frames[index % FLIGHT_RECORDER_FRAMES];
+        writer.AppendNumber(frame.frame);
+        writer.Append(",");
+        writer.AppendNumber(frame.tick);
+        writer.Append(",");
+        writer.AppendNumber(frame.frameMicrosecs);
+        writer.Append(",");
+        writer.AppendNumber(frame.inputActions);
+        for (int i = 0; i < numScopes; i++)
+        {
+            writer.Append(",");
+            writer.AppendNumber(frame.scopeMicrosecs[i]);
+        }
+        for (int i = 0; i < numEventTypes; i++)
+        {
+            writer.Append(",");
+            writer.AppendNumber(frame.numEvents[i]);
+        }
+        writer.Append("\n");
+    }
+    return true;
+}
@@ -0,0 +1,69 @@
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+// Frames kept, 10 seconds at 60 FPS
+const int FLIGHT_RECORDER_FRAMES = 600;
+// Profiler scopes and event types recorded per frame, the ones past them are left out
+const int FLIGHT_RECORDER_MAX_SCOPES = 32;
+const int FLIGHT_RECORDER_MAX_EVENT_TYPES = 16;
+const int FLIGHT_RECORDER_NAME_SIZE = 40;
+const std::string FLIGHT_RECORDER_DEFAULT_FILE = "./flightrecorder.csv";
+
+class EventBus;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Flight recorder
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Keeps the last FLIGHT_RECORDER_FRAMES frames in a ring allocated once: the frame and tick,
+// the frame time, the input actions held, the time of each profiler scope and the events of
+// each type emitted. A crash (segfault, abort, illegal instruction, floating point error)
+// writes the ring to a CSV before the process dies, oldest frame first, so the frames that
+// led up to it aren't lost. The handler only formats into a stack buffer and writes the
+// file, it allocates nothing and takes no lock. Dump writes it any time, e.g. on a hitch.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class FlightRecorder
+{
+private:
+    struct Frame
+    {
+        uint32_t frame;
+        uint32_t tick;
+        uint32_t frameMicrosecs;
+        uint32_t inputActions;
+        uint32_t scopeMicrosecs[FLIGHT_RECORDER_MAX_SCOPES];
+        uint32_t numEvents[FLIGHT_RECORDER_MAX_EVENT_TYPES];
+    };
+
+    static std::array<Frame, FLIGHT_RECORDER_FRAMES> frames;
+    // Frames recorded so far, the last one is complete before it is counted
+    static volatile uint32_t numFrames;
+    // Copied as they appear, the crash handler only reads plain chars
+    static char scopeNames[FLIGHT_RECORDER_MAX_SCOPES][FLIGHT_RECORDER_NAME_SIZE];
+    static char eventNames[FLIGHT_RECORDER_MAX_EVENT_TYPES][FLIGHT_RECORDER_NAME_SIZE];
+    static int numScopes;
+    static int numEventTypes;
+    // Event totals of the previous frame, the frames keep the difference
+    static uint64_t previousNumEvents[FLIGHT_RECORDER_MAX_EVENT_TYPES];
+    static char filePath[256];
+    static bool isInstalled;
+
+    static void CopyName(char (&name)[FLIGHT_RECORDER_NAME_SIZE], const std::string& source);
+    static void OnCrash(int signal);
+
+public:
+    // Handles the crash signals from now on, the ring is written to the file
+    static void Install(const std::string& filePath);
+
+    // Once per frame on the main thread, after the profiler ended it. Does nothing until
+    // Install.
+    static void RecordFrame(uint32_t tick, double frameMillisecs, uint32_t inputActions, const EventBus& eventBus);
+
+    // Writes the frames in the ring, safe from a signal handler
+    static bool Dump(const char* filePath);
+};
+
+#endif
@@ -0,0 +1,87 @@
+#include "LatencyTracker.h"
+#include "../Logger/Logger.h"
+#include <algorithm>
+
+void LatencyTracker::OnInput(uint32_t eventTicks)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    // The oldest input waiting is the one the latency is measured from
+    if (pendingTicks == 0)
+    {
+        pendingTicks = std::max(eventTicks, 1u);
+    }
+}
+
+void LatencyTracker::OnTick()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pendingTicks != 0 && simulatedTicks == 0)
+    {
+        simulatedTicks = pendingTicks;
+        pendingTicks = 0;
+    }
+}
+
+void LatencyTracker::OnFrameRecorded()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (simulatedTicks != 0 && recordedTicks == 0)
+    {
+        recordedTicks = simulatedTicks;
+        simulatedTicks = 0;
+    }
+}
+
+void LatencyTracker::OnFramePresented(uint32_t presentTicks)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (recordedTicks == 0)
+    {
+        return;
+    }
+    // Wraps after 49 days like the SDL ticks, the difference stays right
+    const uint32_t millisecs = presentTicks - recordedTicks;
+    recordedTicks = 0;
+    buckets[std::min(millisecs / LATENCY_BUCKET_MILLISECS, static_cast<uint32_t>(LATENCY_NUM_BUCKETS - 1))]++;
+    numSamples++;
+    maxMillisecs = std::max(maxMillisecs, millisecs);
+}
+
+LatencyStats LatencyTracker::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    LatencyStats stats = {numSamples, 0, 0, 0, static_cast<int>(maxMillisecs)};
+    const uint64_t p50Count = (numSamples * 50 + 99) / 100;
+    const uint64_t p95Count = (numSamples * 95 + 99) / 100;
+    const uint64_t p99Count = (numSamples * 99 + 99) / 100;
+    uint64_t count = 0;
+    for (int i = 0; i < LATENCY_NUM_BUCKETS && count < p99Count; i++)
+    {
+        const uint64_t previousCount = count;
+        count += buckets[i];
+        const int bucketEnd = std::min((i + 1) * LATENCY_BUCKET_MILLISECS, stats.maxMillisecs);
+        if (previousCount < p50Count && count >= p50Count)
+        {
+            stats.p50Millisecs = bucketEnd;
+        }
+        if (previousCount < p95Count && count >= p95Count)
+        {
+            stats.p95Millisecs = bucketEnd;
+        }
+        if (count >= p99Count)
+        {
+            stats.p99Millisecs = bucketEnd;
+        }
+    }
+    return stats;
+}
+
+void LatencyTracker::LogReport() const
+{
+    const LatencyStats stats = GetStats();
+    if (stats.numSamples == 0)
+    {
+        return;
+    }
+    LOGGER_INFO("Input latency over {} inputs: p50 {} ms, p95 {} ms, p99 {} ms, max {} ms", stats.numSamples, stats.p50Millisecs, stats.p95Millisecs, stats.p99Millisecs, stats.maxMillisecs);
+}
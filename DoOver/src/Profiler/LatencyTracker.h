@@ -0,0 +1,60 @@
+#ifndef LATENCYTRACKER_H
+#define LATENCYTRACKER_H
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+
+// Of the latency histogram, the last bucket takes everything past it
+const int LATENCY_BUCKET_MILLISECS = 2;
+const int LATENCY_NUM_BUCKETS = 100;
+
+struct LatencyStats
+{
+    uint64_t numSamples;
+    // Rounded up to the end of their bucket
+    int p50Millisecs;
+    int p95Millisecs;
+    int p99Millisecs;
+    int maxMillisecs;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Latency tracker
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Input to photon latency: the oldest input not yet acted on is followed through the stages
+// of the frame pipeline, from the event SDL stamped to the first tick that simulated it, the
+// frame recorded after that tick, and the present of that frame, where the latency goes into
+// a histogram. The input coming in meanwhile waits for the next frame, so each frame reflects
+// at most one sample, that of its oldest input. With the frames pipelined the present comes
+// a frame after the recording, which the latency shows. All in SDL ticks (milliseconds), the
+// stages may be called from the simulation thread and the main thread.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class LatencyTracker
+{
+private:
+    // The SDL ticks of the input at each stage, 0 for none
+    uint32_t pendingTicks = 0;
+    uint32_t simulatedTicks = 0;
+    uint32_t recordedTicks = 0;
+    std::array<uint64_t, LATENCY_NUM_BUCKETS> buckets = {};
+    uint64_t numSamples = 0;
+    uint32_t maxMillisecs = 0;
+    mutable std::mutex mutex;
+
+public:
+    // A live key, button or mouse press, the SDL timestamp of its event
+    void OnInput(uint32_t eventTicks);
+    // A simulation tick ran, on the input polled before it
+    void OnTick();
+    // A frame was recorded from the state of the simulation
+    void OnFrameRecorded();
+    // The frame recorded last is on screen
+    void OnFramePresented(uint32_t presentTicks);
+
+    LatencyStats GetStats() const;
+    // Logs the percentiles, when any input was measured
+    void LogReport() const;
+};
+
+#endif
@@ -0,0 +1,268 @@
+#include "Profiler.h"
+#include "../Logger/Logger.h"
+#include <algorithm>
+#include <fstream>
+
+std::array<Profiler::Scope, PROFILER_MAX_SCOPES> Profiler::scopes;
+std::atomic<int> Profiler::numScopes = 0;
+std::mutex Profiler::scopesMutex;
+int Profiler::numFrames = 0;
+std::atomic<bool> Profiler::isCapturing = false;
+std::atomic<int64_t> Profiler::captureStartNanosecs = 0;
+ProfileTime Profiler::lastFrameEnd;
+std::vector<std::unique_ptr<Profiler::ThreadCapture>> Profiler::threadCaptures;
+std::mutex Profiler::threadCapturesMutex;
+
+int Profiler::GetScopeId(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(scopesMutex);
+    const int count = numScopes.load();
+    for (int i = 0; i < count; i++)
+    {
+        if (scopes[i].name == name)
+        {
+            return i;
+        }
+    }
+    if (count == PROFILER_MAX_SCOPES)
+    {
+        Logger::War("Too many profiler scopes, " + name + " is counted in " + scopes[count - 1].name);
+        return count - 1;
+    }
+    scopes[count].name = name;
+    numScopes.store(count + 1);
+    return count;
+}
+
+void Profiler::AddSample(int scopeId, ProfileTime start, ProfileTime end)
+{
+    auto& scope = scopes[scopeId];
+    scope.nanosecs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(), std::memory_order_relaxed);
+    scope.numCalls.fetch_add(1, std::memory_order_relaxed);
+    if (isCapturing.load(std::memory_order_acquire))
+    {
+        AddCaptureEvent(scopeId, start, end);
+    }
+}
+
+void Profiler::AddAllocations(int scopeId, const AllocationCounts& counts)
+{
+    auto& scope = scopes[scopeId];
+    scope.numAllocations.fetch_add(counts.numAllocations, std::memory_order_relaxed);
+    scope.numAllocatedBytes.fetch_add(counts.numBytes, std::memory_order_relaxed);
+}
+
+Profiler::ThreadCapture& Profiler::GetThreadCapture()
+{
+    thread_local ThreadCapture* threadCapture = nullptr;
+    if (!threadCapture)
+    {
+        std::lock_guard<std::mutex> lock(threadCapturesMutex);
+        threadCaptures.push_back(std::make_unique<ThreadCapture>());
+        threadCapture = threadCaptures.back().get();
+        threadCapture->threadIndex = threadCaptures.size() - 1;
+        threadCapture->threadName = "Thread " + std::to_string(threadCapture->threadIndex);
+    }
+    return *threadCapture;
+}
+
+void Profiler::AddCaptureEvent(int scopeId, ProfileTime start, ProfileTime end)
+{
+    auto& threadCapture = GetThreadCapture();
+    // Only contended while the capture is written
+    std::lock_guard<std::mutex> lock(threadCapture.mutex);
+    if (threadCapture.events.size() >= static_cast<size_t>(PROFILER_MAX_CAPTURE_EVENTS))
+    {
+        threadCapture.numDroppedEvents++;
+        return;
+    }
+    const int64_t startNanosecs = std::chrono::duration_cast<std::chrono::nanoseconds>(start.time_since_epoch()).count() - captureStartNanosecs.load(std::memory_order_relaxed);
+    const int64_t durationNanosecs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    threadCapture.events.push_back({scopeId, startNanosecs, durationNanosecs});
+}
+
+void Profiler::SetThreadName(const std::string& name)
+{
+    auto& threadCapture = GetThreadCapture();
+    std::lock_guard<std::mutex> lock(threadCapture.mutex);
+    threadCapture.threadName = name;
+}
+
+void Profiler::BeginCapture()
+{
+    if (isCapturing.load())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(threadCapturesMutex);
+        for (auto& threadCapture: threadCaptures)
+        {
+            std::lock_guard<std::mutex> threadLock(threadCapture->mutex);
+            threadCapture->events.clear();
+            threadCapture->numDroppedEvents = 0;
+        }
+    }
+    lastFrameEnd = std::chrono::high_resolution_clock::now();
+    captureStartNanosecs.store(std::chrono::duration_cast<std::chrono::nanoseconds>(lastFrameEnd.time_since_epoch()).count());
+    isCapturing.store(true);
+    Logger::Log("Profiler capture started");
+}
+
+bool Profiler::IsCapturing()
+{
+    return isCapturing.load();
+}
+
+static std::string EscapeJson(const std::string& text)
+{
+    std::string escaped;
+    for (char c: text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+bool Profiler::EndCapture(const std::string& filePath)
+{
+    isCapturing.store(false);
+
+    std::ofstream file(filePath);
+    if (!file.is_open())
+    {
+        Logger::Err("Unable to write the profiler capture " + filePath);
+        return false;
+    }
+
+    std::vector<std::string> scopeNames;
+    {
+        std::lock_guard<std::mutex> lock(scopesMutex);
+        for (int i = 0; i < numScopes.load(); i++)
+        {
+            scopeNames.push_back(EscapeJson(scopes[i].name));
+        }
+    }
+
+    // Complete events ("X") in microseconds, one track per thread
+    int numEvents = 0;
+    int numDroppedEvents = 0;
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    std::lock_guard<std::mutex> lock(threadCapturesMutex);
+    bool isFirstEvent = true;
+    for (auto& threadCapture: threadCaptures)
+    {
+        std::lock_guard<std::mutex> threadLock(threadCapture->mutex);
+        file << (isFirstEvent ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << threadCapture->threadIndex
+             << ", \"args\": {\"name\": \"" << EscapeJson(threadCapture->threadName) << "\"}}";
+        isFirstEvent = false;
+        for (const auto& event: threadCapture->events)
+        {
+            file << ",\n{\"name\": \"" << scopeNames[event.scopeId] << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << threadCapture->threadIndex
+                 << ", \"ts\": " << event.startNanosecs / 1000.0 << ", \"dur\": " << event.durationNanosecs / 1000.0 << "}";
+        }
+        numEvents += threadCapture->events.size();
+        numDroppedEvents += threadCapture->numDroppedEvents;
+        threadCapture->events.clear();
+        threadCapture->events.shrink_to_fit();
+    }
+    file << "\n]}\n";
+
+    Logger::Log("Profiler capture of " + std::to_string(numEvents) + " samples written to " + filePath);
+    if (numDroppedEvents > 0)
+    {
+        Logger::War(std::to_string(numDroppedEvents) + " samples were dropped from the capture, it ran for too long");
+    }
+    return true;
+}
+
+void Profiler::EndFrame()
+{
+    const int frame = numFrames % PROFILER_HISTORY_FRAMES;
+    const int count = numScopes.load();
+    for (int i = 0; i < count; i++)
+    {
+        auto& scope = scopes[i];
+        scope.history[frame] = scope.nanosecs.exchange(0, std::memory_order_relaxed) / 1000000.0f;
+        scope.lastNumCalls = scope.numCalls.exchange(0, std::memory_order_relaxed);
+        scope.lastNumAllocations = scope.numAllocations.exchange(0, std::memory_order_relaxed);
+        scope.lastNumAllocatedBytes = scope.numAllocatedBytes.exchange(0, std::memory_order_relaxed);
+    }
+    numFrames++;
+
+    // The frames get their own samples in the captures, to line the spikes up with
+    if (isCapturing.load())
+    {
+        static const int frameScopeId = GetScopeId("Frame");
+        const ProfileTime frameEnd = std::chrono::high_resolution_clock::now();
+        AddCaptureEvent(frameScopeId, lastFrameEnd, frameEnd);
+        lastFrameEnd = frameEnd;
+    }
+}
+
+int Profiler::GetNumScopes()
+{
+    return numScopes.load();
+}
+
+const std::string& Profiler::GetScopeName(int scopeId)
+{
+    return scopes[scopeId].name;
+}
+
+float Profiler::GetLastFrameMillisecs(int scopeId)
+{
+    return numFrames > 0 ? scopes[scopeId].history[(numFrames - 1) % PROFILER_HISTORY_FRAMES] : 0.0f;
+}
+
+void Profiler::GetStats(std::vector<ProfileStats>& stats)
+{
+    stats.clear();
+    const int numHistoryFrames = std::min(numFrames, PROFILER_HISTORY_FRAMES);
+    if (numHistoryFrames == 0)
+    {
+        return;
+    }
+    const int lastFrame = (numFrames - 1) % PROFILER_HISTORY_FRAMES;
+
+    std::vector<float> sorted(numHistoryFrames);
+    const int count = numScopes.load();
+    for (int i = 0; i < count; i++)
+    {
+        const auto& scope = scopes[i];
+        std::copy(scope.history.begin(), scope.history.begin() + numHistoryFrames, sorted.begin());
+        std::sort(sorted.begin(), sorted.end());
+        const auto percentile = [&sorted](double p) { return sorted[std::min<int>(sorted.size() - 1, p * sorted.size())]; };
+
+        ProfileStats scopeStats;
+        scopeStats.name = scope.name;
+        scopeStats.p50Millisecs = percentile(0.50);
+        scopeStats.p95Millisecs = percentile(0.95);
+        scopeStats.p99Millisecs = percentile(0.99);
+        scopeStats.maxMillisecs = sorted.back();
+        scopeStats.lastMillisecs = scope.history[lastFrame];
+        scopeStats.lastNumCalls = scope.lastNumCalls;
+        scopeStats.lastNumAllocations = scope.lastNumAllocations;
+        scopeStats.lastNumAllocatedBytes = scope.lastNumAllocatedBytes;
+        stats.push_back(scopeStats);
+    }
+}
+
+void Profiler::LogReport()
+{
+    std::vector<ProfileStats> stats;
+    GetStats(stats);
+    if (stats.empty())
+    {
+        return;
+    }
+    LOGGER_INFO("Profile of the last {} frames (ms per frame)", std::min(numFrames, PROFILER_HISTORY_FRAMES));
+    for (const auto& scopeStats: stats)
+    {
+        LOGGER_INFO("  {}: p50 {} p95 {} p99 {} max {}", scopeStats.name, scopeStats.p50Millisecs, scopeStats.p95Millisecs, scopeStats.p99Millisecs, scopeStats.maxMillisecs);
+    }
+}
@@ -0,0 +1,172 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "../Memory/AllocationTracker.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// The profiler is compiled in unless NDEBUG is defined (make release), build with
+// -DENABLE_PROFILER to profile a release build
+#ifndef NDEBUG
+#ifndef ENABLE_PROFILER
+#define ENABLE_PROFILER
+#endif
+#endif
+
+// Distinct scope names that can be profiled
+const int PROFILER_MAX_SCOPES = 128;
+// Frames kept for the percentiles, 4 seconds at 60 FPS
+const int PROFILER_HISTORY_FRAMES = 240;
+// Samples kept per thread during a capture, the ones after that are dropped
+const int PROFILER_MAX_CAPTURE_EVENTS = 1 << 20;
+
+typedef std::chrono::high_resolution_clock::time_point ProfileTime;
+
+struct ProfileStats
+{
+    std::string name;
+    // Time spent in the scope per frame, over the frames in the history
+    double p50Millisecs;
+    double p95Millisecs;
+    double p99Millisecs;
+    double maxMillisecs;
+    double lastMillisecs;
+    int lastNumCalls;
+    // Made in the scope and the ones nested in it the last frame, 0 unless the allocations
+    // are tracked
+    uint64_t lastNumAllocations;
+    uint64_t lastNumAllocatedBytes;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Profiler
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Adds up the time spent in each named scope during a frame, from any thread, and keeps
+// the totals of the last PROFILER_HISTORY_FRAMES frames to compute percentiles from.
+// Use the PROFILE_* macros, they compile to nothing when the profiler is disabled.
+//
+// Between BeginCapture and EndCapture every sample is also recorded with its thread and
+// start time, and written as a Chrome trace (chrome://tracing, Perfetto, Speedscope).
+/////////////////////////////////////////////////////////////////////////////////////////////
+class Profiler
+{
+private:
+    struct Scope
+    {
+        std::string name;
+        // Current frame, added to by any thread
+        std::atomic<int64_t> nanosecs{0};
+        std::atomic<int> numCalls{0};
+        std::atomic<uint64_t> numAllocations{0};
+        std::atomic<uint64_t> numAllocatedBytes{0};
+        // [frame % PROFILER_HISTORY_FRAMES] -> time spent in the scope that frame
+        std::array<float, PROFILER_HISTORY_FRAMES> history = {};
+        int lastNumCalls = 0;
+        uint64_t lastNumAllocations = 0;
+        uint64_t lastNumAllocatedBytes = 0;
+    };
+
+    struct CaptureEvent
+    {
+        int scopeId;
+        // Relative to the start of the capture
+        int64_t startNanosecs;
+        int64_t durationNanosecs;
+    };
+
+    // Owned by the profiler, so the samples of a thread outlive it until they are written
+    struct ThreadCapture
+    {
+        std::string threadName;
+        int threadIndex;
+        std::mutex mutex;
+        std::vector<CaptureEvent> events;
+        int numDroppedEvents = 0;
+    };
+
+    static std::array<Scope, PROFILER_MAX_SCOPES> scopes;
+    static std::atomic<int> numScopes;
+    static std::mutex scopesMutex;
+    static int numFrames;
+
+    static std::atomic<bool> isCapturing;
+    // Nanosecs since the clock epoch, read by the threads adding samples
+    static std::atomic<int64_t> captureStartNanosecs;
+    static ProfileTime lastFrameEnd;
+    static std::vector<std::unique_ptr<ThreadCapture>> threadCaptures;
+    static std::mutex threadCapturesMutex;
+
+    static ThreadCapture& GetThreadCapture();
+    static void AddCaptureEvent(int scopeId, ProfileTime start, ProfileTime end);
+
+public:
+    // Returns the id of the scope with this name, registering it the first time
+    static int GetScopeId(const std::string& name);
+    static void AddSample(int scopeId, ProfileTime start, ProfileTime end);
+    static void AddAllocations(int scopeId, const AllocationCounts& counts);
+
+    // Moves the totals of the frame into the history, called once per frame on the main thread
+    static void EndFrame();
+
+    // Percentiles of every scope over the history, in registration order
+    static void GetStats(std::vector<ProfileStats>& stats);
+    // Of the scopes in registration order, without the allocations of GetStats
+    static int GetNumScopes();
+    static const std::string& GetScopeName(int scopeId);
+    // Time spent in the scope the frame EndFrame ended last
+    static float GetLastFrameMillisecs(int scopeId);
+    static void LogReport();
+
+    // Names the calling thread in the captures
+    static void SetThreadName(const std::string& name);
+    static void BeginCapture();
+    // Writes the samples since BeginCapture to a Chrome trace_event JSON file
+    static bool EndCapture(const std::string& filePath);
+    static bool IsCapturing();
+};
+
+class ProfileScope
+{
+private:
+    int scopeId;
+    ProfileTime start;
+#ifdef ENABLE_ALLOCATION_TRACKER
+    AllocationCounts startAllocations = AllocationTracker::GetThreadCounts();
+#endif
+
+public:
+    ProfileScope(int scopeId): scopeId(scopeId), start(std::chrono::high_resolution_clock::now()) {}
+    ~ProfileScope()
+    {
+        Profiler::AddSample(scopeId, start, std::chrono::high_resolution_clock::now());
+#ifdef ENABLE_ALLOCATION_TRACKER
+        const AllocationCounts endAllocations = AllocationTracker::GetThreadCounts();
+        if (endAllocations.numAllocations != startAllocations.numAllocations)
+        {
+            Profiler::AddAllocations(scopeId, {endAllocations.numAllocations - startAllocations.numAllocations, endAllocations.numBytes - startAllocations.numBytes});
+        }
+#endif
+    }
+};
+
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INNER(a, b)
+
+#ifdef ENABLE_PROFILER
+// Times the rest of the enclosing block, the name is looked up once per call site
+#define PROFILE_SCOPE(name) \
+    static const int PROFILER_CONCAT(profileScopeId, __LINE__) = Profiler::GetScopeId(name); \
+    ProfileScope PROFILER_CONCAT(profileScope, __LINE__)(PROFILER_CONCAT(profileScopeId, __LINE__))
+#define PROFILE_END_FRAME() Profiler::EndFrame()
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_END_FRAME()
+#endif
+
+#endif
@@ -0,0 +1,53 @@
+#include "StartupReport.h"
+#include "../Logger/Logger.h"
+#include <algorithm>
+#include <cstdio>
+
+StartupReport::Scope::Scope(StartupReport& report, const std::string& name, bool isBackground)
+    : report(report), name(name), beginMillisecs(report.GetMillisecs()), isBackground(isBackground)
+{
+}
+
+StartupReport::Scope::~Scope()
+{
+    report.AddPhase(name, beginMillisecs, isBackground);
+}
+
+StartupReport::StartupReport()
+    : start(std::chrono::steady_clock::now())
+{
+}
+
+double StartupReport::GetMillisecs() const
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void StartupReport::AddPhase(const std::string& name, double beginMillisecs, bool isBackground)
+{
+    const double endMillisecs = GetMillisecs();
+    std::lock_guard<std::mutex> lock(mutex);
+    phases.push_back({name, beginMillisecs, endMillisecs - beginMillisecs, isBackground});
+}
+
+void StartupReport::Finish()
+{
+    if (isFinished)
+    {
+        return;
+    }
+    isFinished = true;
+    const double totalMillisecs = GetMillisecs();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::stable_sort(phases.begin(), phases.end(), [](const Phase& a, const Phase& b) { return a.beginMillisecs < b.beginMillisecs; });
+    Logger::Log("Startup report, the workers' phases overlap the main thread's:");
+    char line[160];
+    for (const auto& phase: phases)
+    {
+        std::snprintf(line, sizeof(line), "  %-32s %-8s at %8.1f ms  %8.1f ms", phase.name.c_str(), phase.isBackground ? "workers" : "main", phase.beginMillisecs, phase.millisecs);
+        Logger::Log(line);
+    }
+    std::snprintf(line, sizeof(line), "  %-32s %8.1f ms", "First frame", totalMillisecs);
+    Logger::Log(line);
+}
@@ -0,0 +1,59 @@
+#ifndef STARTUPREPORT_H
+#define STARTUPREPORT_H
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Startup report
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Where the time to the first frame goes. The phases are timed from the creation of the
+// report: the ones of the main thread follow each other, the ones of the workers overlap
+// them. Logged once at the first frame, in release builds as well, to compare cold starts.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class StartupReport
+{
+private:
+    struct Phase
+    {
+        std::string name;
+        double beginMillisecs;
+        double millisecs;
+        bool isBackground;
+    };
+
+    std::chrono::steady_clock::time_point start;
+    std::mutex mutex;
+    std::vector<Phase> phases;
+    bool isFinished = false;
+
+public:
+    // Times a phase until the end of the scope, from any thread
+    class Scope
+    {
+    private:
+        StartupReport& report;
+        std::string name;
+        double beginMillisecs;
+        bool isBackground;
+
+    public:
+        Scope(StartupReport& report, const std::string& name, bool isBackground = false);
+        ~Scope();
+    };
+
+    StartupReport();
+
+    // Since the report was created
+    double GetMillisecs() const;
+    // From beginMillisecs to now
+    void AddPhase(const std::string& name, double beginMillisecs, bool isBackground = false);
+
+    // Logs the phases in the order they began, the total is the time to the first frame
+    void Finish();
+    bool IsFinished() const { return isFinished; }
+};
+
+#endif
@@ -0,0 +1,70 @@
+#include "FrameCapture.h"
+#include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
+#include <SDL2/SDL_image.h>
+#include <cstdio>
+
+void FrameCapture::RequestScreenshot()
+{
+    isScreenshotRequested = true;
+}
+
+void FrameCapture::SetInterval(int interval)
+{
+    this->interval = interval > 0 ? interval : 0;
+}
+
+void FrameCapture::Capture(SDL_Renderer* renderer, JobSystem& jobSystem)
+{
+    numFrames++;
+    const bool isContinuous = interval > 0 && numFrames % interval == 0;
+    if (!isScreenshotRequested && !isContinuous)
+    {
+        return;
+    }
+    const bool isScreenshot = isScreenshotRequested;
+    isScreenshotRequested = false;
+    if (numPendingWrites->load() >= FRAME_CAPTURE_MAX_PENDING)
+    {
+        numDropped++;
+        if (isScreenshot)
+        {
+            Logger::War("Screenshot dropped, the captures before it are still being written");
+        }
+        return;
+    }
+
+    // The numbers of the sequence follow each other, whatever the interval
+    char number[16];
+    std::snprintf(number, sizeof(number), "%06d", isScreenshot ? ++numScreenshots : ++numCaptures);
+    const std::string filePath = (isScreenshot ? SCREENSHOT_FILE_PREFIX : FRAME_CAPTURE_FILE_PREFIX) + number + ".png";
+
+    // The read waits for the GPU to finish the frame, the only part on the main thread
+    int width = 0;
+    int height = 0;
+    SDL_GetRendererOutputSize(renderer, &width, &height);
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
+    if (!surface || SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_RGBA32, surface->pixels, surface->pitch) != 0)
+    {
+        Logger::Err("Unable to read the frame back: " + std::string(SDL_GetError()));
+        SDL_FreeSurface(surface);
+        return;
+    }
+
+    const std::shared_ptr<std::atomic<int>> pendingWrites = numPendingWrites;
+    pendingWrites->fetch_add(1);
+    jobSystem.Schedule([surface, filePath, pendingWrites]()
+    {
+        PROFILE_SCOPE("Frame capture write");
+        if (IMG_SavePNG(surface, filePath.c_str()) != 0)
+        {
+            Logger::Err("Unable to write the capture " + filePath + ": " + IMG_GetError());
+        }
+        SDL_FreeSurface(surface);
+        pendingWrites->fetch_sub(1);
+    });
+    if (isScreenshot)
+    {
+        Logger::Log("Screenshot saved to " + filePath);
+    }
+}
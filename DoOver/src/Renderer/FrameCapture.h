@@ -0,0 +1,52 @@
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include "../Jobs/JobSystem.h"
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <memory>
+#include <string>
+
+// Captures still being written, a frame captured past them is dropped rather than waited for
+const int FRAME_CAPTURE_MAX_PENDING = 4;
+// Followed by the number of the capture and .png
+const std::string SCREENSHOT_FILE_PREFIX = "./screenshot-";
+const std::string FRAME_CAPTURE_FILE_PREFIX = "./capture-";
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Frame capture
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Reads a frame back from the renderer once it is submitted, before it is presented, and
+// compresses and writes it as a PNG on the job system, so the main thread only pays for the
+// read. A screenshot is taken on request, the continuous capture takes every Nth frame as a
+// numbered image sequence (e.g. ffmpeg -i capture-%06d.png turns it into a video).
+/////////////////////////////////////////////////////////////////////////////////////////////
+class FrameCapture
+{
+private:
+    bool isScreenshotRequested = false;
+    int interval = 0;
+    int numFrames = 0;
+    int numScreenshots = 0;
+    int numCaptures = 0;
+    int numDropped = 0;
+    // Shared with the jobs writing, which may still run after the capture is gone
+    std::shared_ptr<std::atomic<int>> numPendingWrites = std::make_shared<std::atomic<int>>(0);
+
+public:
+    FrameCapture() = default;
+
+    // Of the next frame submitted
+    void RequestScreenshot();
+    // Every interval frames, 0 stops
+    void SetInterval(int interval);
+
+    // After the frame is submitted and before it is presented, the back buffer is undefined
+    // after that
+    void Capture(SDL_Renderer* renderer, JobSystem& jobSystem);
+
+    // Captures skipped because the ones before were still being written
+    int GetNumDropped() const { return numDropped; }
+};
+
+#endif
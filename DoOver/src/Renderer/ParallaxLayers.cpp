@@ -0,0 +1,42 @@
+#include "ParallaxLayers.h"
+#include <cmath>
+
+void ParallaxLayers::Render(RenderCommandList& commandList, const AssetStore& assetStore, const SDL_FRect& camera, double time, bool isForeground)
+{
+    spriteBatch.Begin(commandList);
+    for (const auto& layer: layers)
+    {
+        if (layer.isForeground != isForeground)
+        {
+            continue;
+        }
+        const auto& region = assetStore.GetTextureRegion(layer.assetHandle);
+        if (region.texture && region.rect.w > 0 && region.rect.h > 0 && layer.scale > 0.0f)
+        {
+            assetStore.UseTexture(layer.assetHandle);
+            RenderLayer(layer, region, camera, time);
+        }
+        // Each layer is its own draw, even when two of them share a texture
+        spriteBatch.Flush();
+    }
+    spriteBatch.End();
+}
+
+void ParallaxLayers::RenderLayer(const ParallaxLayer& layer, const TextureRegion& region, const SDL_FRect& camera, double time)
+{
+    const float width = region.rect.w * layer.scale;
+    const float height = region.rect.h * layer.scale;
+    const SDL_Rect srcRect = region.GetSrcRect();
+    // Where the layer is under the camera, wrapped to a single copy of the texture
+    const double offsetX = camera.x * layer.factor - layer.scrollVelocity.x * time;
+    const double offsetY = camera.y * layer.factor - layer.scrollVelocity.y * time;
+    const float startX = -static_cast<float>(offsetX - std::floor(offsetX / width) * width);
+    const float startY = -static_cast<float>(offsetY - std::floor(offsetY / height) * height);
+    for (float y = startY; y < camera.h; y += height)
+    {
+        for (float x = startX; x < camera.w; x += width)
+        {
+            spriteBatch.Draw(region.texture, srcRect, {x, y, width, height}, 0.0f);
+        }
+    }
+}
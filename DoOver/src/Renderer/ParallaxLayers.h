@@ -0,0 +1,53 @@
+#ifndef PARALLAXLAYERS_H
+#define PARALLAXLAYERS_H
+
+#include "RenderCommandList.h"
+#include "SpriteBatch.h"
+#include "../AssetStore/AssetStore.h"
+#include <SDL2/SDL.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+struct ParallaxLayer
+{
+    AssetHandle assetHandle = INVALID_ASSET_HANDLE;
+    // How much of the camera's movement the layer follows: 0 stays put, 1 moves with the
+    // world, the distant layers are in between and the layers over the world above 1
+    float factor = 1.0f;
+    // Drift on its own, in world pixels per second, e.g. the clouds
+    glm::vec2 scrollVelocity = glm::vec2(0.0f);
+    float scale = 1.0f;
+    // Over the world instead of under the tilemap
+    bool isForeground = false;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Parallax layers
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Textures repeated endlessly behind or over the world, scrolling at their own pace. They
+// are not entities: a layer is a texture of the asset store, the copies of it that cover the
+// camera are one batch, so a layer is one draw whatever its size. The copies only wrap the
+// texture coordinates of their own rectangle, an atlased texture repeats as well as a
+// texture loaded on its own.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class ParallaxLayers
+{
+private:
+    // Back to front
+    std::vector<ParallaxLayer> layers;
+    SpriteBatch spriteBatch;
+
+    void RenderLayer(const ParallaxLayer& layer, const TextureRegion& region, const SDL_FRect& camera, double time);
+
+public:
+    ParallaxLayers() = default;
+
+    void AddLayer(const ParallaxLayer& layer) { layers.push_back(layer); }
+    void Clear() { layers.clear(); }
+    int GetNumLayers() const { return layers.size(); }
+
+    // The layers under the world or over it, time in seconds moves the scrolling ones
+    void Render(RenderCommandList& commandList, const AssetStore& assetStore, const SDL_FRect& camera, double time, bool isForeground);
+};
+
+#endif
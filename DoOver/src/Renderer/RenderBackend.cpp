@@ -0,0 +1,115 @@
+#include "RenderBackend.h"
+#include "../Logger/Logger.h"
+#include <cstring>
+
+// The SDL render drivers of each backend, by preference
+static const char* const OPENGL_DRIVERS[] = {"opengl", nullptr};
+static const char* const OPENGLES_DRIVERS[] = {"opengles2", nullptr};
+static const char* const DIRECT3D_DRIVERS[] = {"direct3d11", "direct3d12", "direct3d", nullptr};
+static const char* const METAL_DRIVERS[] = {"metal", nullptr};
+static const char* const NO_DRIVERS[] = {nullptr};
+
+static const char* const* GetDriverNames(RenderBackendType type)
+{
+    switch (type)
+    {
+    case RENDER_BACKEND_OPENGL:
+        return OPENGL_DRIVERS;
+    case RENDER_BACKEND_OPENGLES:
+        return OPENGLES_DRIVERS;
+    case RENDER_BACKEND_DIRECT3D:
+        return DIRECT3D_DRIVERS;
+    case RENDER_BACKEND_METAL:
+        return METAL_DRIVERS;
+    default:
+        return NO_DRIVERS;
+    }
+}
+
+// The index of the first driver of the backend the platform has, -1 when none
+static int FindDriverIndex(RenderBackendType type)
+{
+    for (const char* const* name = GetDriverNames(type); *name; name++)
+    {
+        for (int i = 0; i < SDL_GetNumRenderDrivers(); i++)
+        {
+            SDL_RendererInfo info;
+            if (SDL_GetRenderDriverInfo(i, &info) == 0 && std::strcmp(info.name, *name) == 0)
+            {
+                return i;
+            }
+        }
+    }
+    return -1;
+}
+
+bool RenderBackend::FindType(const std::string& name, RenderBackendType& type)
+{
+    for (int i = RENDER_BACKEND_AUTO; i <= RENDER_BACKEND_SOFTWARE; i++)
+    {
+        if (name == GetName(static_cast<RenderBackendType>(i)))
+        {
+            type = static_cast<RenderBackendType>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* RenderBackend::GetName(RenderBackendType type)
+{
+    switch (type)
+    {
+    case RENDER_BACKEND_OPENGL:
+        return "opengl";
+    case RENDER_BACKEND_OPENGLES:
+        return "opengles";
+    case RENDER_BACKEND_DIRECT3D:
+        return "direct3d";
+    case RENDER_BACKEND_METAL:
+        return "metal";
+    case RENDER_BACKEND_SOFTWARE:
+        return "software";
+    default:
+        return "auto";
+    }
+}
+
+SDL_Renderer* RenderBackend::CreateRenderer(SDL_Window* window, RenderBackendType type, Uint32 flags)
+{
+    // Set before the renderer is created, otherwise only the drivers picked by SDL batch
+    SDL_SetHint(SDL_HINT_RENDER_BATCHING, "1");
+
+    SDL_Renderer* renderer = nullptr;
+    if (type != RENDER_BACKEND_AUTO && type != RENDER_BACKEND_SOFTWARE)
+    {
+        const int driverIndex = FindDriverIndex(type);
+        if (driverIndex != -1)
+        {
+            renderer = SDL_CreateRenderer(window, driverIndex, SDL_RENDERER_ACCELERATED | flags);
+        }
+        if (!renderer)
+        {
+            Logger::War(std::string("The ") + GetName(type) + " render backend isn't available, using another one");
+        }
+    }
+    if (!renderer && type != RENDER_BACKEND_SOFTWARE)
+    {
+        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | flags);
+    }
+    if (!renderer)
+    {
+        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE | flags);
+    }
+    if (!renderer)
+    {
+        return nullptr;
+    }
+
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(renderer, &info) == 0)
+    {
+        LOGGER_INFO("Rendering with {} ({}), textures up to {}x{}", info.name, (info.flags & SDL_RENDERER_ACCELERATED) ? "accelerated" : "software", info.max_texture_width, info.max_texture_height);
+    }
+    return renderer;
+}
@@ -0,0 +1,38 @@
+#ifndef RENDERBACKEND_H
+#define RENDERBACKEND_H
+
+#include <SDL2/SDL.h>
+#include <string>
+
+enum RenderBackendType
+{
+    // The first GPU driver the platform has
+    RENDER_BACKEND_AUTO,
+    RENDER_BACKEND_OPENGL,
+    RENDER_BACKEND_OPENGLES,
+    RENDER_BACKEND_DIRECT3D,
+    RENDER_BACKEND_METAL,
+    RENDER_BACKEND_SOFTWARE
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Render backend
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Creates the SDL renderer on the GPU driver asked for, or the first accelerated one, and
+// falls back to the software renderer when none works. The textures, the sprite batches and
+// the debug GUI all go through SDL_Renderer, so the GPU drivers are SDL's: with batching on
+// they stream every frame's geometry into their own vertex buffers and submit it at once.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class RenderBackend
+{
+public:
+    // From the names of the command line (e.g. "opengl"), false when unknown
+    static bool FindType(const std::string& name, RenderBackendType& type);
+    static const char* GetName(RenderBackendType type);
+
+    // The flags are added to the accelerated ones, e.g. SDL_RENDERER_PRESENTVSYNC. Null when
+    // not even the software renderer could be created.
+    static SDL_Renderer* CreateRenderer(SDL_Window* window, RenderBackendType type, Uint32 flags = 0);
+};
+
+#endif
@@ -0,0 +1,223 @@
+#include "RenderCommandList.h"
+#include <cmath>
+
+const float DEGREES_TO_RADIANS = 3.14159265358979323846f / 180.0f;
+
+// Rounded outwards, the neighbouring viewports still meet
+static SDL_Rect ScaleRect(const SDL_Rect& rect, float scale)
+{
+    const int left = static_cast<int>(std::floor(rect.x * scale));
+    const int top = static_cast<int>(std::floor(rect.y * scale));
+    const int right = static_cast<int>(std::ceil((rect.x + rect.w) * scale));
+    const int bottom = static_cast<int>(std::ceil((rect.y + rect.h) * scale));
+    return {left, top, right - left, bottom - top};
+}
+
+void RenderCommandList::Clear(SDL_Color clearColor)
+{
+    commands.clear();
+    instances.clear();
+    rects.clear();
+    this->clearColor = clearColor;
+    hasDebugGui = false;
+    firstViewportCommand = 0;
+    currentViewport = {0, 0, 0, 0};
+    isViewportCovered = false;
+    coveredArea = 0;
+    isWindowCovered = false;
+    numHiddenCommands = 0;
+}
+
+void RenderCommandList::AddInstances(SDL_Texture* texture, const std::vector<SpriteInstance>& instances)
+{
+    RenderCommand command = {};
+    command.type = RENDER_COMMAND_INSTANCES;
+    command.texture = texture;
+    command.first = this->instances.size();
+    command.count = instances.size();
+    this->instances.insert(this->instances.end(), instances.begin(), instances.end());
+    commands.push_back(command);
+}
+
+void RenderCommandList::AddCopy(SDL_Texture* texture, const SDL_FRect& dstRect)
+{
+    RenderCommand command = {};
+    command.type = RENDER_COMMAND_COPY;
+    command.texture = texture;
+    command.dstRect = dstRect;
+    commands.push_back(command);
+}
+
+void RenderCommandList::AddRects(const std::vector<SDL_Rect>& rects, SDL_Color color)
+{
+    AddRects(RENDER_COMMAND_RECTS, rects, color);
+}
+
+void RenderCommandList::AddFilledRects(const std::vector<SDL_Rect>& rects, SDL_Color color)
+{
+    AddRects(RENDER_COMMAND_FILLED_RECTS, rects, color);
+}
+
+void RenderCommandList::AddRects(RenderCommandType type, const std::vector<SDL_Rect>& rects, SDL_Color color)
+{
+    if (rects.empty())
+    {
+        return;
+    }
+    RenderCommand command = {};
+    command.type = type;
+    command.color = color;
+    command.first = this->rects.size();
+    command.count = rects.size();
+    this->rects.insert(this->rects.end(), rects.begin(), rects.end());
+    commands.push_back(command);
+}
+
+void RenderCommandList::SetViewport(const SDL_Rect* viewport, float scale)
+{
+    RenderCommand command = {};
+    command.type = RENDER_COMMAND_VIEWPORT;
+    command.scale = scale;
+    if (viewport)
+    {
+        command.viewport = *viewport;
+    }
+    commands.push_back(command);
+    firstViewportCommand = commands.size();
+    currentViewport = command.viewport;
+    isViewportCovered = false;
+}
+
+void RenderCommandList::AddOpaqueLayer(int firstCommand)
+{
+    for (int i = firstViewportCommand; i < firstCommand && i < static_cast<int>(commands.size()); i++)
+    {
+        // The viewport changes stay, the renderer state must follow the recording
+        if (commands[i].type != RENDER_COMMAND_VIEWPORT && !commands[i].isHidden)
+        {
+            commands[i].isHidden = true;
+            numHiddenCommands++;
+        }
+    }
+    firstViewportCommand = commands.size();
+    // Covered once, whatever the number of layers over it
+    if (isViewportCovered)
+    {
+        return;
+    }
+    isViewportCovered = true;
+    if (currentViewport.w <= 0)
+    {
+        isWindowCovered = true;
+        return;
+    }
+    coveredArea += static_cast<long long>(currentViewport.w) * currentViewport.h;
+}
+
+void RenderCommandList::Submit(SDL_Renderer* renderer, float resolutionScale) const
+{
+    // Cleared unless the opaque layers fill the window, then every pixel is drawn over anyway
+    int outputWidth = 0;
+    int outputHeight = 0;
+    SDL_GetRendererOutputSize(renderer, &outputWidth, &outputHeight);
+    if (!isWindowCovered && coveredArea < static_cast<long long>(outputWidth) * outputHeight)
+    {
+        SDL_SetRenderDrawColor(renderer, clearColor.r, clearColor.g, clearColor.b, clearColor.a);
+        SDL_RenderClear(renderer);
+    }
+    // The whole window is the corner of the target it is drawn in
+    const SDL_Rect windowRect = {0, 0, static_cast<int>(std::ceil(outputWidth * resolutionScale)), static_cast<int>(std::ceil(outputHeight * resolutionScale))};
+    SDL_RenderSetScale(renderer, 1.0f, 1.0f);
+    SDL_RenderSetViewport(renderer, resolutionScale < 1.0f ? &windowRect : NULL);
+    SDL_RenderSetScale(renderer, resolutionScale, resolutionScale);
+    for (const auto& command: commands)
+    {
+        if (command.isHidden)
+        {
+            continue;
+        }
+        switch (command.type)
+        {
+        case RENDER_COMMAND_INSTANCES:
+            SubmitInstances(renderer, command);
+            break;
+        case RENDER_COMMAND_COPY:
+            SDL_RenderCopyF(renderer, command.texture, NULL, &command.dstRect);
+            break;
+        case RENDER_COMMAND_RECTS:
+            SDL_SetRenderDrawColor(renderer, command.color.r, command.color.g, command.color.b, command.color.a);
+            SDL_RenderDrawRects(renderer, rects.data() + command.first, command.count);
+            break;
+        case RENDER_COMMAND_FILLED_RECTS:
+            SDL_SetRenderDrawColor(renderer, command.color.r, command.color.g, command.color.b, command.color.a);
+            SDL_RenderFillRects(renderer, rects.data() + command.first, command.count);
+            break;
+        case RENDER_COMMAND_VIEWPORT:
+        {
+            // The viewport is given in the current scale, set it in target pixels first
+            SDL_RenderSetScale(renderer, 1.0f, 1.0f);
+            if (command.viewport.w <= 0)
+            {
+                SDL_RenderSetViewport(renderer, resolutionScale < 1.0f ? &windowRect : NULL);
+            }
+            else
+            {
+                const SDL_Rect viewport = ScaleRect(command.viewport, resolutionScale);
+                SDL_RenderSetViewport(renderer, &viewport);
+            }
+            SDL_RenderSetScale(renderer, command.scale * resolutionScale, command.scale * resolutionScale);
+            break;
+        }
+        }
+    }
+    // The debug GUI draws over the whole window
+    SDL_RenderSetScale(renderer, 1.0f, 1.0f);
+    SDL_RenderSetViewport(renderer, NULL);
+}
+
+void RenderCommandList::SubmitInstances(SDL_Renderer* renderer, const RenderCommand& command) const
+{
+    quadVertices.resize(command.count * 4);
+    for (int i = 0; i < command.count; i++)
+    {
+        const SpriteInstance& instance = instances[command.first + i];
+        const SDL_FRect& dstRect = instance.dstRect;
+        float positionsX[4] = {dstRect.x, dstRect.x + dstRect.w, dstRect.x + dstRect.w, dstRect.x};
+        float positionsY[4] = {dstRect.y, dstRect.y, dstRect.y + dstRect.h, dstRect.y + dstRect.h};
+        // Most sprites aren't rotated, their corners are the ones of the rectangle
+        if (instance.rotation != 0.0f)
+        {
+            // Corners relative to the center, rotated clockwise (screen y points down)
+            const float halfW = dstRect.w / 2;
+            const float halfH = dstRect.h / 2;
+            const float centerX = dstRect.x + halfW;
+            const float centerY = dstRect.y + halfH;
+            const float cosAngle = std::cos(instance.rotation * DEGREES_TO_RADIANS);
+            const float sinAngle = std::sin(instance.rotation * DEGREES_TO_RADIANS);
+            const float cornersX[4] = {-halfW, halfW, halfW, -halfW};
+            const float cornersY[4] = {-halfH, -halfH, halfH, halfH};
+            for (int corner = 0; corner < 4; corner++)
+            {
+                positionsX[corner] = centerX + cornersX[corner] * cosAngle - cornersY[corner] * sinAngle;
+                positionsY[corner] = centerY + cornersX[corner] * sinAngle + cornersY[corner] * cosAngle;
+            }
+        }
+        const float cornersU[4] = {instance.u0, instance.u1, instance.u1, instance.u0};
+        const float cornersV[4] = {instance.v0, instance.v0, instance.v1, instance.v1};
+        SDL_Vertex* vertices = &quadVertices[i * 4];
+        for (int corner = 0; corner < 4; corner++)
+        {
+            vertices[corner].position = {positionsX[corner], positionsY[corner]};
+            vertices[corner].color = instance.color;
+            vertices[corner].tex_coord = {cornersU[corner], cornersV[corner]};
+        }
+    }
+    for (int quad = quadIndices.size() / 6; quad < command.count; quad++)
+    {
+        for (int index: {0, 1, 2, 0, 2, 3})
+        {
+            quadIndices.push_back(quad * 4 + index);
+        }
+    }
+    SDL_RenderGeometry(renderer, command.texture, quadVertices.data(), command.count * 4, quadIndices.data(), command.count * 6);
+}
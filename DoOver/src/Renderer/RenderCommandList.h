@@ -0,0 +1,116 @@
+#ifndef RENDERCOMMANDLIST_H
+#define RENDERCOMMANDLIST_H
+
+#include <SDL2/SDL.h>
+#include <vector>
+
+enum RenderCommandType
+{
+    // Quads of one texture, or none, drawn as one geometry
+    RENDER_COMMAND_INSTANCES,
+    // A whole texture into a rectangle
+    RENDER_COMMAND_COPY,
+    // Outlines of one color
+    RENDER_COMMAND_RECTS,
+    // Solid rectangles of one color
+    RENDER_COMMAND_FILLED_RECTS,
+    // What follows is drawn into a rectangle of the window, or the whole window, scaled
+    RENDER_COMMAND_VIEWPORT
+};
+
+// A textured quad as it is recorded, its corners are only worked out when it is submitted
+struct SpriteInstance
+{
+    // Before the rotation, in degrees clockwise around its center like SDL_RenderCopyEx
+    SDL_FRect dstRect;
+    float rotation;
+    // Texture coordinates of the top left and bottom right corners, swapped to flip it
+    float u0;
+    float v0;
+    float u1;
+    float v1;
+    // Multiplies the texels
+    SDL_Color color;
+};
+
+struct RenderCommand
+{
+    RenderCommandType type;
+    SDL_Texture* texture;
+    SDL_Color color;
+    // Into the instances of the list, or its rectangles
+    int first;
+    int count;
+    SDL_FRect dstRect;
+    // Empty for the whole window
+    SDL_Rect viewport;
+    float scale;
+    // Under an opaque layer filling its viewport, it isn't submitted
+    bool isHidden;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Render command list
+/////////////////////////////////////////////////////////////////////////////////////////////
+// What a frame draws, recorded from the components by the render systems and submitted to
+// the renderer later without them, so the simulation can go on with the next frame while
+// this one is submitted. The textures are only referenced, they must outlive the submission.
+// A layer known to be opaque and to fill its viewport (e.g. the tilemap) hides what was
+// recorded before it there, and once such layers fill the whole window the clear is skipped
+// too: nothing is drawn that would only be drawn over, which saves the fill rate.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class RenderCommandList
+{
+private:
+    std::vector<RenderCommand> commands;
+    std::vector<SpriteInstance> instances;
+    std::vector<SDL_Rect> rects;
+    // The corners of the instances of a command, expanded as it is submitted. The indices of
+    // the quads are the same whatever they draw, they only grow with the most drawn at once.
+    mutable std::vector<SDL_Vertex> quadVertices;
+    mutable std::vector<int> quadIndices;
+    SDL_Color clearColor = {0, 0, 0, 255};
+    // Where the commands of the current viewport start, its area and whether it is covered
+    int firstViewportCommand = 0;
+    SDL_Rect currentViewport = {0, 0, 0, 0};
+    bool isViewportCovered = false;
+    // Window pixels filled by opaque layers, a layer over the whole window fills it all
+    long long coveredArea = 0;
+    bool isWindowCovered = false;
+    int numHiddenCommands = 0;
+    // The debug GUI's draw data is drawn after the commands
+    bool hasDebugGui = false;
+
+    void AddRects(RenderCommandType type, const std::vector<SDL_Rect>& rects, SDL_Color color);
+    void SubmitInstances(SDL_Renderer* renderer, const RenderCommand& command) const;
+
+public:
+    RenderCommandList() = default;
+
+    // Keeps the capacity, the lists are recorded again every frame
+    void Clear(SDL_Color clearColor);
+
+    void AddInstances(SDL_Texture* texture, const std::vector<SpriteInstance>& instances);
+    void AddCopy(SDL_Texture* texture, const SDL_FRect& dstRect);
+    void AddRects(const std::vector<SDL_Rect>& rects, SDL_Color color);
+    void AddFilledRects(const std::vector<SDL_Rect>& rects, SDL_Color color);
+    // Null for the whole window. The coordinates that follow are multiplied by the scale,
+    // floats land between the window pixels.
+    void SetViewport(const SDL_Rect* viewport, float scale = 1.0f);
+    // The commands from firstCommand on are opaque and fill the current viewport, the ones
+    // recorded before them in it are hidden. The viewports mustn't overlap.
+    void AddOpaqueLayer(int firstCommand);
+    void SetDebugGui(bool hasDebugGui) { this->hasDebugGui = hasDebugGui; }
+
+    // Clears the target and draws the commands in the order they were added. Under a
+    // resolution scale of 1 the target is that much smaller than the window, the viewports
+    // and their scales are multiplied by it.
+    void Submit(SDL_Renderer* renderer, float resolutionScale = 1.0f) const;
+
+    bool HasDebugGui() const { return hasDebugGui; }
+    int GetNumCommands() const { return commands.size(); }
+    // Of the frame recorded
+    int GetNumHiddenCommands() const { return numHiddenCommands; }
+};
+
+#endif
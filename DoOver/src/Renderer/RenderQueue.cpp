@@ -0,0 +1,67 @@
+#include "RenderQueue.h"
+#include "../Components/SpriteComponent.h"
+#include <algorithm>
+
+void RenderQueue::MarkDirty()
+{
+    isDirty = true;
+}
+
+bool RenderQueue::IsDirty() const
+{
+    return isDirty;
+}
+
+void RenderQueue::Rebuild(const std::vector<Entity>& entities)
+{
+    // Bucket the entities by layer (counting sort, so the order inside a layer is kept)
+    std::vector<int> layerStarts(MAX_SPRITE_LAYERS + 1, 0);
+    int maxEntityId = -1;
+    for (auto entity: entities)
+    {
+        const int layer = std::clamp(entity.GetComponent<SpriteComponent>().zIndex, 0, MAX_SPRITE_LAYERS - 1);
+        layerStarts[layer + 1]++;
+        maxEntityId = std::max(maxEntityId, entity.GetId());
+    }
+    for (int i = 1; i <= MAX_SPRITE_LAYERS; i++)
+    {
+        layerStarts[i] += layerStarts[i - 1];
+    }
+
+    std::vector<Entity> ordered(entities.size(), Entity(0, 0, 0));
+    std::vector<int> layerFill(layerStarts.begin(), layerStarts.end() - 1);
+    entityIdToLayer.assign(maxEntityId + 1, -1);
+    for (auto entity: entities)
+    {
+        const int zIndex = entity.GetComponent<SpriteComponent>().zIndex;
+        const int layer = std::clamp(zIndex, 0, MAX_SPRITE_LAYERS - 1);
+        ordered[layerFill[layer]++] = entity;
+        entityIdToLayer[entity.GetId()] = zIndex;
+    }
+
+    // Group each layer by asset
+    for (int layer = 0; layer < MAX_SPRITE_LAYERS; layer++)
+    {
+        std::stable_sort(ordered.begin() + layerStarts[layer], ordered.begin() + layerStarts[layer + 1], [](Entity a, Entity b)
+        {
+            return a.GetComponent<SpriteComponent>().assetHandle < b.GetComponent<SpriteComponent>().assetHandle;
+        });
+    }
+
+    entityIdToDrawOrder.assign(maxEntityId + 1, 0);
+    for (int i = 0; i < static_cast<int>(ordered.size()); i++)
+    {
+        entityIdToDrawOrder[ordered[i].GetId()] = i;
+    }
+    isDirty = false;
+}
+
+int RenderQueue::GetDrawOrder(int entityId) const
+{
+    return entityIdToDrawOrder[entityId];
+}
+
+bool RenderQueue::IsInLayer(Entity entity, int layer) const
+{
+    return entity.GetId() < static_cast<int>(entityIdToLayer.size()) && entityIdToLayer[entity.GetId()] == layer;
+}
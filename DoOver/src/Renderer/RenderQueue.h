@@ -0,0 +1,72 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include "../ECS/ECS.h"
+#include <vector>
+#include <cstdint>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Render Queue
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Persistent draw order of the sprites: bucketed by layer (SpriteComponent::zIndex) and,
+// inside a layer, grouped by asset so the batches stay large. The order is only rebuilt
+// when a sprite is added, removed or changes layer, every frame just radix sorts the
+// visible sprites by their draw order, which is linear.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class RenderQueue
+{
+private:
+    // [entity id] -> rank of the entity in the draw order, and the layer it was ranked with
+    std::vector<int> entityIdToDrawOrder;
+    std::vector<int> entityIdToLayer;
+    bool isDirty = true;
+
+public:
+    RenderQueue() = default;
+
+    void MarkDirty();
+    bool IsDirty() const;
+
+    // Ranks every entity (with a sprite) by layer then asset
+    void Rebuild(const std::vector<Entity>& entities);
+
+    int GetDrawOrder(int entityId) const;
+
+    // Whether the entity is still ranked with the given layer
+    bool IsInLayer(Entity entity, int layer) const;
+
+    // Stable LSD radix sort of the items by their drawOrder member, scratch is reused between frames
+    template <typename T>
+    static void SortByDrawOrder(std::vector<T>& items, std::vector<T>& scratch);
+};
+
+template <typename T>
+void RenderQueue::SortByDrawOrder(std::vector<T>& items, std::vector<T>& scratch)
+{
+    uint32_t maxDrawOrder = 0;
+    for (const auto& item: items)
+    {
+        maxDrawOrder = static_cast<uint32_t>(item.drawOrder) > maxDrawOrder ? item.drawOrder : maxDrawOrder;
+    }
+
+    scratch.resize(items.size());
+    for (int shift = 0; shift < 32 && (maxDrawOrder >> shift) != 0; shift += 8)
+    {
+        int counts[257] = {0};
+        for (const auto& item: items)
+        {
+            counts[((item.drawOrder >> shift) & 0xFF) + 1]++;
+        }
+        for (int i = 1; i < 257; i++)
+        {
+            counts[i] += counts[i - 1];
+        }
+        for (const auto& item: items)
+        {
+            scratch[counts[(item.drawOrder >> shift) & 0xFF]++] = item;
+        }
+        items.swap(scratch);
+    }
+}
+
+#endif
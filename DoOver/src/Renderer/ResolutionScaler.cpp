@@ -0,0 +1,103 @@
+#include "ResolutionScaler.h"
+#include "../Logger/Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+ResolutionScaler::~ResolutionScaler()
+{
+    ReleaseTexture();
+}
+
+void ResolutionScaler::Configure(int renderHeight, bool isDynamic)
+{
+    this->renderHeight = std::max(renderHeight, 0);
+    this->isDynamic = isDynamic;
+    dynamicScale = 1.0f;
+    numFramesOverBudget = 0;
+    numFramesUnderBudget = 0;
+    ReleaseTexture();
+}
+
+float ResolutionScaler::GetScale(int windowHeight) const
+{
+    const float renderScale = renderHeight > 0 && renderHeight < windowHeight ? static_cast<float>(renderHeight) / windowHeight : 1.0f;
+    return renderScale * dynamicScale;
+}
+
+float ResolutionScaler::Begin(SDL_Renderer* renderer, int windowWidth, int windowHeight)
+{
+    drawnRect = {0, 0, 0, 0};
+    const float scale = GetScale(windowHeight);
+    if (scale >= 1.0f)
+    {
+        return 1.0f;
+    }
+
+    // Sized for the render resolution, the dynamic scale only draws less of it
+    const float renderScale = scale / dynamicScale;
+    const int width = static_cast<int>(std::ceil(windowWidth * renderScale));
+    const int height = static_cast<int>(std::ceil(windowHeight * renderScale));
+    if (target && (targetWidth != width || targetHeight != height))
+    {
+        ReleaseTexture();
+    }
+    if (!target)
+    {
+        target = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, width, height);
+        if (!target)
+        {
+            Logger::Err(std::string("Unable to create the render target: ") + SDL_GetError());
+            return 1.0f;
+        }
+        SDL_SetTextureScaleMode(target, SDL_ScaleModeLinear);
+        targetWidth = width;
+        targetHeight = height;
+    }
+    drawnRect = {0, 0, std::min(static_cast<int>(std::ceil(windowWidth * scale)), width), std::min(static_cast<int>(std::ceil(windowHeight * scale)), height)};
+    SDL_SetRenderTarget(renderer, target);
+    return scale;
+}
+
+void ResolutionScaler::End(SDL_Renderer* renderer)
+{
+    if (drawnRect.w <= 0)
+    {
+        return;
+    }
+    SDL_SetRenderTarget(renderer, NULL);
+    SDL_RenderSetScale(renderer, 1.0f, 1.0f);
+    SDL_RenderSetViewport(renderer, NULL);
+    SDL_RenderCopy(renderer, target, &drawnRect, NULL);
+}
+
+void ResolutionScaler::AddFrameTime(double renderMillisecs, double budgetMillisecs)
+{
+    if (!isDynamic || budgetMillisecs <= 0.0)
+    {
+        return;
+    }
+    numFramesOverBudget = renderMillisecs > budgetMillisecs ? numFramesOverBudget + 1 : 0;
+    numFramesUnderBudget = renderMillisecs < budgetMillisecs * RESOLUTION_HEADROOM ? numFramesUnderBudget + 1 : 0;
+    if (numFramesOverBudget >= RESOLUTION_FRAMES_TO_DROP && dynamicScale > RESOLUTION_MIN_SCALE)
+    {
+        // Snapped to the steps, the float sums would leave the full scale a hair under 1
+        dynamicScale = std::max(std::round(dynamicScale / RESOLUTION_SCALE_STEP - 1.0f) * RESOLUTION_SCALE_STEP, RESOLUTION_MIN_SCALE);
+        numFramesOverBudget = 0;
+        LOGGER_DEBUG("Dynamic resolution down to {}", dynamicScale);
+    }
+    else if (numFramesUnderBudget >= RESOLUTION_FRAMES_TO_RAISE && dynamicScale < 1.0f)
+    {
+        dynamicScale = std::min(std::round(dynamicScale / RESOLUTION_SCALE_STEP + 1.0f) * RESOLUTION_SCALE_STEP, 1.0f);
+        numFramesUnderBudget = 0;
+        LOGGER_DEBUG("Dynamic resolution up to {}", dynamicScale);
+    }
+}
+
+void ResolutionScaler::ReleaseTexture()
+{
+    SDL_DestroyTexture(target);
+    target = nullptr;
+    targetWidth = 0;
+    targetHeight = 0;
+}
@@ -0,0 +1,67 @@
+#ifndef RESOLUTIONSCALER_H
+#define RESOLUTIONSCALER_H
+
+#include <SDL2/SDL.h>
+
+// The frames of a taller window are drawn at this height and stretched, 0 for the window's own
+const int DEFAULT_RENDER_HEIGHT = 1080;
+// The dynamic scale stays between this and 1
+const float RESOLUTION_MIN_SCALE = 0.5f;
+const float RESOLUTION_SCALE_STEP = 0.1f;
+// Frames in a row over the budget before the scale drops, and under the headroom before
+// it comes back up, slower so it doesn't go up and down every other frame
+const int RESOLUTION_FRAMES_TO_DROP = 8;
+const int RESOLUTION_FRAMES_TO_RAISE = 120;
+// Of the budget, a frame faster than this could afford more pixels
+const double RESOLUTION_HEADROOM = 0.75;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Resolution scaler
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Decouples the pixels drawn from the pixels of the window. The frame is drawn into the
+// corner of a render target at the render resolution, then stretched over the window with
+// linear filtering, so a 4K display fills a quarter of its pixels at the default 1080 lines.
+// The dynamic scale shrinks the corner drawn when the frames take longer than the budget to
+// render and grows it back when they have room to spare, the target is never recreated.
+// At full scale the frame is drawn to the window directly, with no copy.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class ResolutionScaler
+{
+private:
+    int renderHeight = DEFAULT_RENDER_HEIGHT;
+    bool isDynamic = false;
+    float dynamicScale = 1.0f;
+    int numFramesOverBudget = 0;
+    int numFramesUnderBudget = 0;
+    // At the render resolution, the frames at the dynamic scale take a corner of it
+    SDL_Texture* target = nullptr;
+    int targetWidth = 0;
+    int targetHeight = 0;
+    // Of the frame begun, 0 when it is drawn to the window
+    SDL_Rect drawnRect = {0, 0, 0, 0};
+
+public:
+    ResolutionScaler() = default;
+    ~ResolutionScaler();
+
+    // 0 draws at the height of the window, the dynamic scale only goes under it
+    void Configure(int renderHeight, bool isDynamic);
+
+    // Of the window's pixels drawn, the render resolution times the dynamic scale
+    float GetScale(int windowHeight) const;
+    float GetDynamicScale() const { return dynamicScale; }
+
+    // Draws to the target when the scale is under 1, returns the scale the frame's commands
+    // are submitted at
+    float Begin(SDL_Renderer* renderer, int windowWidth, int windowHeight);
+    // Stretches what Begin drew over the window, which is the target again after it
+    void End(SDL_Renderer* renderer);
+
+    // The time the frame took to render, against the time it had
+    void AddFrameTime(double renderMillisecs, double budgetMillisecs);
+
+    // The content of the target is lost with the renderer's, it is created again
+    void ReleaseTexture();
+};
+
+#endif
@@ -0,0 +1,84 @@
+#include "SpriteBatch.h"
+#include <utility>
+
+void SpriteBatch::Begin(RenderCommandList& commandList)
+{
+    this->commandList = &commandList;
+    texture = nullptr;
+    instances.clear();
+    numDrawCalls = 0;
+    numSprites = 0;
+}
+
+void SpriteBatch::Draw(SDL_Texture* texture, const SDL_Rect& srcRect, const SDL_FRect& dstRect, float rotation, SDL_Color color, SDL_RendererFlip flip)
+{
+    if (!texture)
+    {
+        return;
+    }
+    if (texture != this->texture)
+    {
+        Flush();
+        this->texture = texture;
+        SDL_QueryTexture(texture, NULL, NULL, &textureSize.x, &textureSize.y);
+    }
+
+    numSprites++;
+
+    SpriteInstance instance;
+    instance.dstRect = dstRect;
+    instance.rotation = rotation;
+    instance.u0 = static_cast<float>(srcRect.x) / textureSize.x;
+    instance.v0 = static_cast<float>(srcRect.y) / textureSize.y;
+    instance.u1 = static_cast<float>(srcRect.x + srcRect.w) / textureSize.x;
+    instance.v1 = static_cast<float>(srcRect.y + srcRect.h) / textureSize.y;
+    if (flip & SDL_FLIP_HORIZONTAL)
+    {
+        std::swap(instance.u0, instance.u1);
+    }
+    if (flip & SDL_FLIP_VERTICAL)
+    {
+        std::swap(instance.v0, instance.v1);
+    }
+    instance.color = color;
+    instances.push_back(instance);
+}
+
+void SpriteBatch::DrawRect(const SDL_FRect& dstRect, SDL_Color color)
+{
+    if (texture)
+    {
+        Flush();
+        texture = nullptr;
+    }
+
+    numSprites++;
+    instances.push_back({dstRect, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, color});
+}
+
+void SpriteBatch::Flush()
+{
+    if (instances.empty())
+    {
+        return;
+    }
+    commandList->AddInstances(texture, instances);
+    numDrawCalls++;
+    instances.clear();
+}
+
+void SpriteBatch::End()
+{
+    Flush();
+    texture = nullptr;
+}
+
+int SpriteBatch::GetNumDrawCalls() const
+{
+    return numDrawCalls;
+}
+
+int SpriteBatch::GetNumSprites() const
+{
+    return numSprites;
+}
@@ -0,0 +1,49 @@
+#ifndef SPRITEBATCH_H
+#define SPRITEBATCH_H
+
+#include "RenderCommandList.h"
+#include <SDL2/SDL.h>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Sprite Batch
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Collects textured quads and records all the consecutive quads sharing a texture as a
+// single command, one SDL_RenderGeometry call once submitted. Callers sort the sprites by (layer, texture) so there is
+// one draw call per texture per layer instead of one per sprite. A quad is recorded as one
+// instance, its corners are only worked out by the submit, off the recording.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class SpriteBatch
+{
+private:
+    RenderCommandList* commandList = nullptr;
+    SDL_Texture* texture = nullptr;
+    std::vector<SpriteInstance> instances;
+    int numDrawCalls = 0;
+    int numSprites = 0;
+
+    // Size of the current texture in pixels, to turn the source rectangles into texture coordinates
+    SDL_Point textureSize = {1, 1};
+
+public:
+    SpriteBatch() = default;
+
+    void Begin(RenderCommandList& commandList);
+
+    // Queues a sprite, rotated in degrees around the center of dstRect like SDL_RenderCopyEx.
+    // The color multiplies the texels, e.g. to tint the white glyphs of a font. The flip swaps
+    // the texture coordinates, so mirrored and rotated sprites batch with the others.
+    void Draw(SDL_Texture* texture, const SDL_Rect& srcRect, const SDL_FRect& dstRect, float rotation, SDL_Color color = {255, 255, 255, 255}, SDL_RendererFlip flip = SDL_FLIP_NONE);
+    // Queues a rectangle filled with the color, the untextured quads batch together as well
+    void DrawRect(const SDL_FRect& dstRect, SDL_Color color);
+
+    // Records the queued quads, the batch is also flushed when the texture changes
+    void Flush();
+    void End();
+
+    int GetNumDrawCalls() const;
+    // Sprites drawn since Begin
+    int GetNumSprites() const;
+};
+
+#endif
@@ -0,0 +1,108 @@
+#include "SpriteCullBatch.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#endif
+
+void SpriteCullBatch::Clear()
+{
+    for (auto* column: {&x, &y, &width, &height, &margin})
+    {
+        column->clear();
+    }
+}
+
+void SpriteCullBatch::Reserve(int numSprites)
+{
+    for (auto* column: {&x, &y, &width, &height, &margin, &dstX, &dstY})
+    {
+        column->reserve(numSprites);
+    }
+}
+
+void SpriteCullBatch::Add(const glm::vec2& position, float width, float height, float rotation)
+{
+    x.push_back(position.x);
+    y.push_back(position.y);
+    this->width.push_back(width);
+    this->height.push_back(height);
+    margin.push_back(rotation == 0.0f ? 0.0f : 0.5f * (width > height ? width : height));
+}
+
+int SpriteCullBatch::GetSize() const
+{
+    return x.size();
+}
+
+void SpriteCullBatch::Cull(const SDL_FRect& camera, std::vector<int>& visibleIndices)
+{
+    const int numSprites = GetSize();
+    dstX.resize(numSprites);
+    dstY.resize(numSprites);
+    int i = 0;
+
+#if defined(__AVX__)
+    const __m256 cameraX = _mm256_set1_ps(camera.x);
+    const __m256 cameraY = _mm256_set1_ps(camera.y);
+    const __m256 cameraW = _mm256_set1_ps(camera.w);
+    const __m256 cameraH = _mm256_set1_ps(camera.h);
+    const __m256 zero = _mm256_setzero_ps();
+    for (; i + 8 <= numSprites; i += 8)
+    {
+        const __m256 left = _mm256_sub_ps(_mm256_loadu_ps(&x[i]), cameraX);
+        const __m256 top = _mm256_sub_ps(_mm256_loadu_ps(&y[i]), cameraY);
+        const __m256 spriteMargin = _mm256_loadu_ps(&margin[i]);
+        _mm256_storeu_ps(&dstX[i], left);
+        _mm256_storeu_ps(&dstY[i], top);
+        const __m256 x0 = _mm256_cmp_ps(_mm256_add_ps(_mm256_add_ps(left, _mm256_loadu_ps(&width[i])), spriteMargin), zero, _CMP_GT_OQ);
+        const __m256 x1 = _mm256_cmp_ps(_mm256_sub_ps(left, spriteMargin), cameraW, _CMP_LT_OQ);
+        const __m256 y0 = _mm256_cmp_ps(_mm256_add_ps(_mm256_add_ps(top, _mm256_loadu_ps(&height[i])), spriteMargin), zero, _CMP_GT_OQ);
+        const __m256 y1 = _mm256_cmp_ps(_mm256_sub_ps(top, spriteMargin), cameraH, _CMP_LT_OQ);
+        int bits = _mm256_movemask_ps(_mm256_and_ps(_mm256_and_ps(x0, x1), _mm256_and_ps(y0, y1)));
+        while (bits)
+        {
+            visibleIndices.push_back(i + __builtin_ctz(bits));
+            bits &= bits - 1;
+        }
+    }
+#elif defined(__SSE__) || defined(_M_X64)
+    const __m128 cameraX = _mm_set1_ps(camera.x);
+    const __m128 cameraY = _mm_set1_ps(camera.y);
+    const __m128 cameraW = _mm_set1_ps(camera.w);
+    const __m128 cameraH = _mm_set1_ps(camera.h);
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= numSprites; i += 4)
+    {
+        const __m128 left = _mm_sub_ps(_mm_loadu_ps(&x[i]), cameraX);
+        const __m128 top = _mm_sub_ps(_mm_loadu_ps(&y[i]), cameraY);
+        const __m128 spriteMargin = _mm_loadu_ps(&margin[i]);
+        _mm_storeu_ps(&dstX[i], left);
+        _mm_storeu_ps(&dstY[i], top);
+        const __m128 x0 = _mm_cmpgt_ps(_mm_add_ps(_mm_add_ps(left, _mm_loadu_ps(&width[i])), spriteMargin), zero);
+        const __m128 x1 = _mm_cmplt_ps(_mm_sub_ps(left, spriteMargin), cameraW);
+        const __m128 y0 = _mm_cmpgt_ps(_mm_add_ps(_mm_add_ps(top, _mm_loadu_ps(&height[i])), spriteMargin), zero);
+        const __m128 y1 = _mm_cmplt_ps(_mm_sub_ps(top, spriteMargin), cameraH);
+        const int bits = _mm_movemask_ps(_mm_and_ps(_mm_and_ps(x0, x1), _mm_and_ps(y0, y1)));
+        for (int lane = 0; lane < 4; lane++)
+        {
+            if (bits & (1 << lane))
+            {
+                visibleIndices.push_back(i + lane);
+            }
+        }
+    }
+#endif
+
+    // Remaining sprites (or every sprite without SIMD support)
+    for (; i < numSprites; i++)
+    {
+        dstX[i] = x[i] - camera.x;
+        dstY[i] = y[i] - camera.y;
+        if (dstX[i] + width[i] + margin[i] > 0 && dstX[i] - margin[i] < camera.w && dstY[i] + height[i] + margin[i] > 0 && dstY[i] - margin[i] < camera.h)
+        {
+            visibleIndices.push_back(i);
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef SPRITECULLBATCH_H
+#define SPRITECULLBATCH_H
+
+#include <SDL2/SDL.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Sprite Cull Batch
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The sprites of a frame as structure of arrays of floats, placed relative to a camera and
+// culled against it 8 (AVX) or 4 (SSE) sprites per instruction. The sprites are added once
+// and culled against every viewport.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class SpriteCullBatch
+{
+private:
+    std::vector<float> x, y, width, height;
+    // A rotated sprite may go past its rectangle by up to half its diagonal
+    std::vector<float> margin;
+    // Relative to the camera of the last Cull
+    std::vector<float> dstX, dstY;
+
+public:
+    SpriteCullBatch() = default;
+
+    void Clear();
+    void Reserve(int numSprites);
+    // Its top left corner in the world, the sprites are indexed in the order they are added
+    void Add(const glm::vec2& position, float width, float height, float rotation);
+    int GetSize() const;
+
+    // Places every sprite relative to the camera and appends the index of every one on the
+    // screen, in increasing order
+    void Cull(const SDL_FRect& camera, std::vector<int>& visibleIndices);
+    // Where the last Cull placed the sprite
+    SDL_FRect GetDstRect(int index) const
+    {
+        return {dstX[index], dstY[index], width[index], height[index]};
+    }
+};
+
+#endif
@@ -0,0 +1,17 @@
+#include "TextRenderer.h"
+
+void TextRenderer::DrawQuads(SpriteBatch& spriteBatch, const FontAtlas& font, const std::vector<GlyphQuad>& quads, float x, float y, float scale, SDL_Color color)
+{
+    for (const auto& quad: quads)
+    {
+        const SDL_FRect dstRect = {x + quad.dstRect.x * scale, y + quad.dstRect.y * scale, quad.dstRect.w * scale, quad.dstRect.h * scale};
+        spriteBatch.Draw(font.texture, quad.srcRect, dstRect, 0.0f, color);
+    }
+}
+
+void TextRenderer::DrawText(SpriteBatch& spriteBatch, const FontAtlas& font, const std::string& text, float x, float y, float scale, SDL_Color color)
+{
+    quads.clear();
+    font.Layout(text, quads);
+    DrawQuads(spriteBatch, font, quads, x, y, scale, color);
+}
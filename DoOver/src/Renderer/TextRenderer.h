@@ -0,0 +1,30 @@
+#ifndef TEXTRENDERER_H
+#define TEXTRENDERER_H
+
+#include "SpriteBatch.h"
+#include "../AssetStore/FontAtlas.h"
+#include <string>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Text Renderer
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Draws text as quads of its font atlas through the sprite batch, so all the text in one
+// font is a single draw call and nothing is rasterized per string. Text that doesn't change
+// keeps its laid out quads and only draws them, see FontAtlas::Layout.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class TextRenderer
+{
+private:
+    std::vector<GlyphQuad> quads;
+
+public:
+    TextRenderer() = default;
+
+    // The quads with the top left of the text at (x, y), in screen pixels
+    static void DrawQuads(SpriteBatch& spriteBatch, const FontAtlas& font, const std::vector<GlyphQuad>& quads, float x, float y, float scale = 1.0f, SDL_Color color = {255, 255, 255, 255});
+    // Lays the text out again, for the text that changes every frame
+    void DrawText(SpriteBatch& spriteBatch, const FontAtlas& font, const std::string& text, float x, float y, float scale = 1.0f, SDL_Color color = {255, 255, 255, 255});
+};
+
+#endif
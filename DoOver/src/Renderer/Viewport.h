@@ -0,0 +1,53 @@
+#ifndef VIEWPORT_H
+#define VIEWPORT_H
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Split-screen views at most, each followed by its own entity
+const int MAX_VIEWPORTS = 4;
+
+// Window pixels per world pixel, out of these the view gets too large or too blocky
+const float MIN_CAMERA_ZOOM = 0.25f;
+const float MAX_CAMERA_ZOOM = 4.0f;
+
+// A view of the world drawn into a rectangle of the window
+struct Viewport
+{
+    // In window pixels
+    SDL_Rect screenRect;
+    // In world pixels, the screen rectangle divided by the zoom. Not rounded, so the camera
+    // moves smoothly and the sprites are placed between the pixels.
+    SDL_FRect camera;
+    // Window pixels per world pixel, the renderer scales what the viewport draws by it
+    float zoom = 1.0f;
+    // Set once the camera is on its entity, it only eases towards it from then on
+    bool isFollowing = false;
+};
+
+// The smallest rectangle of whole pixels the cameras of all the viewports fit in
+inline SDL_Rect GetCamerasBounds(const std::vector<Viewport>& viewports)
+{
+    if (viewports.empty())
+    {
+        return {0, 0, 0, 0};
+    }
+    float minX = viewports[0].camera.x;
+    float minY = viewports[0].camera.y;
+    float maxX = viewports[0].camera.x + viewports[0].camera.w;
+    float maxY = viewports[0].camera.y + viewports[0].camera.h;
+    for (const auto& viewport: viewports)
+    {
+        minX = std::min(minX, viewport.camera.x);
+        minY = std::min(minY, viewport.camera.y);
+        maxX = std::max(maxX, viewport.camera.x + viewport.camera.w);
+        maxY = std::max(maxY, viewport.camera.y + viewport.camera.h);
+    }
+    const int x = static_cast<int>(std::floor(minX));
+    const int y = static_cast<int>(std::floor(minY));
+    return {x, y, static_cast<int>(std::ceil(maxX)) - x, static_cast<int>(std::ceil(maxY)) - y};
+}
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef MAPBOUNDSRESOURCE_H
+#define MAPBOUNDSRESOURCE_H
+
+#include "../ECS/Resource.h"
+
+// The size of the map of the level in pixels, 0 before a map is loaded
+struct MapBoundsResource
+{
+    int width;
+    int height;
+
+    MapBoundsResource(int width = 0, int height = 0)
+    {
+        this->width = width;
+        this->height = height;
+    }
+};
+
+REGISTER_RESOURCE(MapBoundsResource, 0)
+
+#endif
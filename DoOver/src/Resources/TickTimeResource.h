@@ -0,0 +1,23 @@
+#ifndef TICKTIMERESOURCE_H
+#define TICKTIMERESOURCE_H
+
+#include "../ECS/Resource.h"
+#include <cstdint>
+
+// The simulation tick being run, set before the systems of the tick
+struct TickTimeResource
+{
+    // Seconds the tick steps, the same on every tick of a frame clock
+    double deltaTime;
+    uint32_t tick;
+
+    TickTimeResource(double deltaTime = 0.0, uint32_t tick = 0)
+    {
+        this->deltaTime = deltaTime;
+        this->tick = tick;
+    }
+};
+
+REGISTER_RESOURCE(TickTimeResource, 1)
+
+#endif
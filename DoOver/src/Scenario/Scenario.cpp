@@ -0,0 +1,229 @@
+#include "Scenario.h"
+#include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/RigidBodyComponent.h"
+#include "../Components/SpriteComponent.h"
+#include "../Components/DirectionalSpriteComponent.h"
+#include "../Components/BoxColliderComponent.h"
+#include "../Components/ProjectileEmitterComponent.h"
+#include "../Components/HealthComponent.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+const int SCENARIO_TILE_SIZE = 32;
+const double SCENARIO_TILE_SCALE = 4.0;
+
+// The standard distributions differ between the standard libraries, the numbers are taken
+// straight from the engine, which is the same everywhere
+static float RandomRange(std::mt19937& random, float min, float max)
+{
+    return min + (max - min) * static_cast<float>(random() / 4294967296.0);
+}
+
+// A map of random jungle tiles, in the text format of the .map files
+static void LoadRandomMap(Tilemap& tilemap, int numCols, int numRows, std::mt19937& random)
+{
+    std::string mapData;
+    mapData.reserve(static_cast<size_t>(numCols) * numRows * 3);
+    for (int row = 0; row < numRows; row++)
+    {
+        for (int col = 0; col < numCols; col++)
+        {
+            const uint32_t tile = random();
+            mapData += static_cast<char>('0' + tile % 3);
+            mapData += static_cast<char>('0' + (tile >> 8) % 10);
+            mapData += col + 1 < numCols ? ',' : '\n';
+        }
+    }
+    tilemap.LoadFromMemory(mapData.data(), mapData.size(), "tilemap-image", SCENARIO_TILE_SIZE, SCENARIO_TILE_SCALE);
+}
+
+// The entities are spawned from a prefab in one go, then spread around
+static void CreateMovers(Registry& registry, int numMovers, int mapWidth, int mapHeight, std::mt19937& random)
+{
+    Prefab moverPrefab;
+    moverPrefab.AddComponent<TransformComponent>(glm::vec2(0), glm::vec2(1.0, 1.0), 0.0)
+        .AddComponent<RigidBodyComponent>()
+        .AddComponent<SpriteComponent>("truck-image", 32, 32, 2)
+        .AddComponent<DirectionalSpriteComponent>()
+        .AddComponent<BoxColliderComponent>(32, 32);
+    for (auto mover: registry.Instantiate(moverPrefab, numMovers))
+    {
+        auto& transform = mover.GetComponent<TransformComponent>();
+        transform.position = glm::vec2(RandomRange(random, 0, mapWidth), RandomRange(random, 0, mapHeight));
+        transform.previousPosition = transform.position;
+        mover.GetComponent<RigidBodyComponent>().velocity = glm::vec2(RandomRange(random, -100, 100), RandomRange(random, -100, 100));
+    }
+}
+
+// Two armies of tanks spread over the map, firing at each other continuously
+static void CreateTanks(Registry& registry, int numTanks, int mapWidth, int mapHeight, std::mt19937& random)
+{
+    Prefab tankPrefab;
+    tankPrefab.AddComponent<TransformComponent>(glm::vec2(0), glm::vec2(1.0, 1.0), 0.0)
+        .AddComponent<RigidBodyComponent>(glm::vec2(0.0, 0.0))
+        .AddComponent<SpriteComponent>("tank-image", 32, 32, 1)
+        .AddComponent<DirectionalSpriteComponent>()
+        .AddComponent<BoxColliderComponent>(32, 32, glm::vec2(0), COLLISION_LAYER_ENEMY)
+        .AddComponent<ProjectileEmitterComponent>(glm::vec2(0), 0, 2000, 10, false)
+        .AddComponent<HealthComponent>(100);
+    const std::vector<Entity> tanks = registry.Instantiate(tankPrefab, numTanks);
+    for (int i = 0; i < numTanks; i++)
+    {
+        const bool isFriendly = i % 2 == 0;
+        const float angle = RandomRange(random, 0.0f, 6.2831853f);
+        const int repeatFrequency = static_cast<int>(RandomRange(random, 100, 500));
+
+        auto& transform = tanks[i].GetComponent<TransformComponent>();
+        transform.position = glm::vec2(RandomRange(random, 0, mapWidth), RandomRange(random, 0, mapHeight));
+        transform.previousPosition = transform.position;
+        tanks[i].GetComponent<BoxColliderComponent>().layer = isFriendly ? COLLISION_LAYER_PLAYER : COLLISION_LAYER_ENEMY;
+        auto& projectileEmitter = tanks[i].GetComponent<ProjectileEmitterComponent>();
+        projectileEmitter.projectileVelocity = glm::vec2(std::cos(angle), std::sin(angle)) * 150.0f;
+        projectileEmitter.repeatFrequency = repeatFrequency;
+        projectileEmitter.isFriendly = isFriendly;
+    }
+}
+
+const std::vector<ScenarioInfo>& Scenario::GetScenarios()
+{
+    static const std::vector<ScenarioInfo> scenarios =
+    {
+        {"tanks", "tanks firing continuously at the other side on a 200x200 map", 1000},
+        {"movers", "moving colliders crossing a 200x200 map", 20000},
+        {"tilemap", "a map of size x size tiles crossed by 1000 moving colliders", 1000}
+    };
+    return scenarios;
+}
+
+bool Scenario::Load(const std::string& name, int size, uint32_t seed, Registry& registry, Tilemap& tilemap)
+{
+    const auto& scenarios = GetScenarios();
+    const auto scenario = std::find_if(scenarios.begin(), scenarios.end(), [&name](const ScenarioInfo& info) { return info.name == name; });
+    if (scenario == scenarios.end())
+    {
+        return false;
+    }
+    if (size <= 0)
+    {
+        size = scenario->defaultSize;
+    }
+
+    std::mt19937 random(seed);
+    const int mapSize = name == "tilemap" ? size : 200;
+    LoadRandomMap(tilemap, mapSize, mapSize, random);
+    const int mapWidth = tilemap.GetWidth();
+    const int mapHeight = tilemap.GetHeight();
+
+    if (name == "tanks")
+    {
+        CreateTanks(registry, size, mapWidth, mapHeight, random);
+    }
+    else if (name == "movers")
+    {
+        CreateMovers(registry, size, mapWidth, mapHeight, random);
+    }
+    else
+    {
+        CreateMovers(registry, 1000, mapWidth, mapHeight, random);
+    }
+    LOGGER_INFO("Scenario {} loaded with size {} and seed {}: {}", name, size, seed, scenario->description);
+    return true;
+}
+
+void ScenarioReport::AddTick(double millisecs)
+{
+    tickMillisecs.push_back(millisecs);
+}
+
+void ScenarioReport::AddFrame()
+{
+    const int numScopes = Profiler::GetNumScopes();
+    if (static_cast<int>(scopeMillisecs.size()) < numScopes)
+    {
+        scopeMillisecs.resize(numScopes);
+    }
+    for (int i = 0; i < numScopes; i++)
+    {
+        scopeMillisecs[i].push_back(Profiler::GetLastFrameMillisecs(i));
+    }
+}
+
+bool ScenarioReport::WriteSamples(const std::string& filePath) const
+{
+    std::ofstream file(filePath);
+    if (!file)
+    {
+        return false;
+    }
+    file << "metric,millisecs\n";
+    for (double millisecs: tickMillisecs)
+    {
+        file << "tick," << millisecs << "\n";
+    }
+    for (size_t i = 0; i < scopeMillisecs.size(); i++)
+    {
+        // A comma would shift the columns of the CSV
+        std::string name = Profiler::GetScopeName(i);
+        std::replace(name.begin(), name.end(), ',', ' ');
+        for (float millisecs: scopeMillisecs[i])
+        {
+            file << name << "," << millisecs << "\n";
+        }
+    }
+    return static_cast<bool>(file);
+}
+
+void ScenarioReport::Log(const std::string& scenarioName, double wallMillisecs, int numEntities) const
+{
+    if (tickMillisecs.empty())
+    {
+        Logger::War("Scenario " + scenarioName + " ran no ticks");
+        return;
+    }
+    std::vector<double> sorted = tickMillisecs;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&sorted](double fraction) { return sorted[static_cast<size_t>(fraction * (sorted.size() - 1))]; };
+
+    LOGGER_INFO("Scenario {}: {} ticks in {} ms, {} ticks/s, {} entities left", scenarioName, sorted.size(), wallMillisecs, sorted.size() * 1000.0 / wallMillisecs, numEntities);
+    LOGGER_INFO("  tick time (ms): p50 {} p95 {} p99 {} max {}", percentile(0.5), percentile(0.95), percentile(0.99), sorted.back());
+    LOGGER_INFO("  peak memory: {} MB", GetPeakMemoryUsage() / (1024.0 * 1024.0));
+}
+
+size_t ScenarioReport::GetPeakMemoryUsage()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+#ifdef __APPLE__
+    return usage.ru_maxrss;
+#else
+    // Linux reports kilobytes
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
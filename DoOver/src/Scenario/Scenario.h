@@ -0,0 +1,67 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include "../ECS/ECS.h"
+#include "../Tilemap/Tilemap.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Scenarios
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Stress loads replacing the level, meant to run headless for a fixed number of ticks.
+// A scenario is filled from its seed only, so two runs with the same seed, size and tick
+// count simulate the same game and their reports can be compared.
+/////////////////////////////////////////////////////////////////////////////////////////////
+const uint32_t SCENARIO_DEFAULT_SEED = 1;
+const uint32_t SCENARIO_DEFAULT_TICKS = 3600;
+
+struct ScenarioInfo
+{
+    std::string name;
+    std::string description;
+    int defaultSize;
+};
+
+class Scenario
+{
+public:
+    // Creates the entities and the map of a scenario, a size of 0 takes its default size.
+    // Returns false if there is no scenario with this name.
+    static bool Load(const std::string& name, int size, uint32_t seed, Registry& registry, Tilemap& tilemap);
+    static const std::vector<ScenarioInfo>& GetScenarios();
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Scenario report
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Collects the time of every simulation tick of a run and logs the throughput, the tick
+// time distribution and the peak memory of the process once it is over. With the profiler
+// compiled in, the time of every profiler scope is kept per frame as well, the breakdown
+// per system. WriteSamples writes them all for tools/PerfGate.cpp to compare between
+// builds.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class ScenarioReport
+{
+private:
+    std::vector<double> tickMillisecs;
+    // [profiler scope id] -> its time in each frame since the scope was first seen
+    std::vector<std::vector<float>> scopeMillisecs;
+
+public:
+    ScenarioReport() = default;
+
+    void AddTick(double millisecs);
+    // After the profiler ended the frame
+    void AddFrame();
+    void Log(const std::string& scenarioName, double wallMillisecs, int numEntities) const;
+    // CSV of metric,millisecs, one line per sample: the ticks as "tick", the frames of each
+    // profiler scope under its name
+    bool WriteSamples(const std::string& filePath) const;
+
+    // Peak resident memory of the process in bytes, 0 when the platform can't tell
+    static size_t GetPeakMemoryUsage();
+};
+
+#endif
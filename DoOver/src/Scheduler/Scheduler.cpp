@@ -0,0 +1,145 @@
+#include "Scheduler.h"
+#include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
+#include "../EventBus/EventOrder.h"
+#include "../EventBus/EventSite.h"
+#include <chrono>
+
+Scheduler::Scheduler(JobSystem& jobSystem): jobSystem(jobSystem)
+{
+    Logger::Log("Scheduler constructor called!");
+}
+
+Scheduler::~Scheduler()
+{
+    Logger::Log("Scheduler destructor called!");
+}
+
+bool Scheduler::Conflicts(const System& a, const System& b)
+{
+    if (a.IsExclusive() || b.IsExclusive())
+    {
+        return true;
+    }
+    // Two systems recording commands would race on the registry command buffer
+    if (a.IsRecordingCommands() && b.IsRecordingCommands())
+    {
+        return true;
+    }
+    const auto aAccess = a.GetReadSignature() | a.GetWriteSignature();
+    const auto bAccess = b.GetReadSignature() | b.GetWriteSignature();
+    if ((a.GetWriteSignature() & bAccess).any() || (b.GetWriteSignature() & aAccess).any())
+    {
+        return true;
+    }
+    const auto aResourceAccess = a.GetResourceReadSignature() | a.GetResourceWriteSignature();
+    const auto bResourceAccess = b.GetResourceReadSignature() | b.GetResourceWriteSignature();
+    return (a.GetResourceWriteSignature() & bResourceAccess).any() || (b.GetResourceWriteSignature() & aResourceAccess).any();
+}
+
+void Scheduler::AddSystem(const std::string& name, const System& system, std::function<void()> update, RunCondition runCondition)
+{
+    Task task;
+    task.name = name;
+#ifdef ENABLE_PROFILER
+    task.profileId = Profiler::GetScopeId(name);
+#endif
+    task.system = &system;
+    task.update = std::move(update);
+    task.runCondition = std::move(runCondition);
+    tasks.push_back(std::move(task));
+    const int taskIndex = tasks.size() - 1;
+    graph.AddJob([this, taskIndex]() { RunTask(taskIndex); });
+
+    // Depend on every earlier system that conflicts, so the original order is kept between them
+    for (int i = 0; i < taskIndex; i++)
+    {
+        if (Conflicts(*tasks[i].system, system))
+        {
+            graph.AddDependency(taskIndex, i);
+        }
+    }
+
+    timings.resize(tasks.size());
+    timings.back().name = name;
+}
+
+void Scheduler::Clear()
+{
+    tasks.clear();
+    graph.Clear();
+    timings.clear();
+}
+
+void Scheduler::RunTask(int taskIndex)
+{
+    auto& task = tasks[taskIndex];
+    if (task.isSkipped)
+    {
+        timings[taskIndex].startMillisecs = 0.0;
+        timings[taskIndex].millisecs = 0.0;
+        return;
+    }
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    {
+        // The events the system emits are sampled under its name, and ordered after the ones
+        // of the systems added before it
+        EventSiteScope site(task.name.c_str());
+        EventOrderScope order(static_cast<uint64_t>(taskIndex + 1) << 32);
+        task.update();
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    // Each task only writes its own timing slot
+    timings[taskIndex].startMillisecs = std::chrono::duration<double, std::milli>(start - frameStart).count();
+    timings[taskIndex].millisecs = std::chrono::duration<double, std::milli>(end - start).count();
+#ifdef ENABLE_PROFILER
+    Profiler::AddSample(task.profileId, start, end);
+#endif
+}
+
+void Scheduler::Run()
+{
+    if (tasks.empty())
+    {
+        return;
+    }
+    // The conditions are asked in order before any system runs, so they may keep state
+    for (auto& task: tasks)
+    {
+        task.isSkipped = !task.system->IsEnabled() || (task.runCondition && !task.runCondition());
+    }
+    frameStart = std::chrono::high_resolution_clock::now();
+    graph.Run(jobSystem);
+    frameMillisecs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - frameStart).count();
+}
+
+const std::vector<SystemTiming>& Scheduler::GetTimings() const
+{
+    return timings;
+}
+
+RunCondition Scheduler::EveryTicks(int numTicks)
+{
+    return [numTicks, numSkippedTicks = 0]() mutable
+    {
+        if (numSkippedTicks > 0)
+        {
+            numSkippedTicks--;
+            return false;
+        }
+        numSkippedTicks = numTicks - 1;
+        return true;
+    };
+}
+
+double Scheduler::GetParallelism() const
+{
+    double systemsMillisecs = 0.0;
+    for (const auto& timing: timings)
+    {
+        systemsMillisecs += timing.millisecs;
+    }
+    return frameMillisecs > 0.0 ? systemsMillisecs / frameMillisecs : 1.0;
+}
@@ -0,0 +1,94 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "../ECS/ECS.h"
+#include "../Jobs/JobSystem.h"
+#include "../Jobs/JobGraph.h"
+#include <string>
+#include <vector>
+#include <functional>
+#include <chrono>
+
+// Whether a system runs this tick, asked once per Run on the thread that calls it
+typedef std::function<bool()> RunCondition;
+
+struct SystemTiming
+{
+    std::string name;
+    double startMillisecs; // Relative to the start of the frame
+    double millisecs;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Scheduler
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Runs the system updates of a frame as a dependency graph. A system depends on every
+// system added before it whose component access conflicts with its own (one writes what
+// the other reads or writes), and the systems that don't conflict run in parallel on the
+// job system workers, as the jobs of a job graph. A system that is disabled, or whose run
+// condition says no, is skipped for the tick and only its empty job is left in the graph.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class Scheduler
+{
+private:
+    struct Task
+    {
+        std::string name;
+        int profileId = 0;
+        const System* system;
+        std::function<void()> update;
+        RunCondition runCondition;
+        bool isSkipped = false;
+    };
+
+    JobSystem& jobSystem;
+    std::vector<Task> tasks;
+    // One job per task, at the same index
+    JobGraph graph;
+
+    std::vector<SystemTiming> timings;
+    std::chrono::high_resolution_clock::time_point frameStart;
+    double frameMillisecs = 0.0;
+
+    static bool Conflicts(const System& a, const System& b);
+    void RunTask(int taskIndex);
+
+public:
+    Scheduler(JobSystem& jobSystem);
+    ~Scheduler();
+
+    // Adds a system update to the graph, update invokes the system with its frame arguments.
+    // Without a run condition it runs on every tick it is enabled.
+    void AddSystem(const std::string& name, const System& system, std::function<void()> update, RunCondition runCondition = nullptr);
+    void Clear();
+
+    // Runs every system once, respecting the dependencies, and waits for all of them
+    void Run();
+
+    // Per-system timings of the last Run()
+    const std::vector<SystemTiming>& GetTimings() const;
+
+    // Sum of the system times over the wall time of the last Run(), 1.0 means fully serial
+    double GetParallelism() const;
+
+    // Runs on the first tick, then once every numTicks ticks
+    static RunCondition EveryTicks(int numTicks);
+    // Runs on the first tick and on the ticks the resource changed since the system last ran
+    template <typename TResource>
+    static RunCondition WhenResourceChanged(const Registry& registry);
+};
+
+template <typename TResource>
+RunCondition Scheduler::WhenResourceChanged(const Registry& registry)
+{
+    return [&registry, hasRun = false, version = uint32_t(0)]() mutable
+    {
+        const uint32_t newVersion = registry.GetResourceVersion<TResource>();
+        const bool isChanged = !hasRun || newVersion != version;
+        hasRun = true;
+        version = newVersion;
+        return isChanged;
+    };
+}
+
+#endif
@@ -0,0 +1,116 @@
+#include "ScriptAllocator.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+int ScriptAllocator::GetSizeClass(size_t size)
+{
+    int sizeClass = 0;
+    while (sizeClass < SCRIPT_ALLOCATOR_NUM_SIZE_CLASSES && GetBlockSize(sizeClass) < size)
+    {
+        sizeClass++;
+    }
+    return sizeClass < SCRIPT_ALLOCATOR_NUM_SIZE_CLASSES ? sizeClass : -1;
+}
+
+void* ScriptAllocator::AllocateBlock(int sizeClass)
+{
+    if (!freeLists[sizeClass])
+    {
+        // Carve a new page into blocks of this class, the blocks keep the 16 byte alignment of new
+        char* page = new (std::nothrow) char[SCRIPT_ALLOCATOR_PAGE_SIZE];
+        if (!page)
+        {
+            return nullptr;
+        }
+        pages.emplace_back(page);
+        const size_t blockSize = GetBlockSize(sizeClass);
+        for (size_t offset = SCRIPT_ALLOCATOR_PAGE_SIZE; offset >= blockSize; offset -= blockSize)
+        {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(page + offset - blockSize);
+            block->next = freeLists[sizeClass];
+            freeLists[sizeClass] = block;
+        }
+    }
+    FreeBlock* block = freeLists[sizeClass];
+    freeLists[sizeClass] = block->next;
+    return block;
+}
+
+void ScriptAllocator::ReleaseBlock(void* block, int sizeClass)
+{
+    FreeBlock* freeBlock = static_cast<FreeBlock*>(block);
+    freeBlock->next = freeLists[sizeClass];
+    freeLists[sizeClass] = freeBlock;
+}
+
+void* ScriptAllocator::Reallocate(void* block, size_t oldSize, size_t newSize)
+{
+    if (!block)
+    {
+        oldSize = 0;
+    }
+    const int oldClass = block ? GetSizeClass(oldSize) : -1;
+
+    if (newSize == 0)
+    {
+        if (block)
+        {
+            if (oldClass >= 0)
+            {
+                ReleaseBlock(block, oldClass);
+            }
+            else
+            {
+                std::free(block);
+                numLargeBytes -= oldSize;
+            }
+            numBytesInUse -= oldSize;
+        }
+        return nullptr;
+    }
+
+    const int newClass = GetSizeClass(newSize);
+    void* newBlock;
+    if (block && oldClass == newClass && newClass >= 0)
+    {
+        // Still fits in its block
+        newBlock = block;
+    }
+    else if (block && oldClass < 0 && newClass < 0)
+    {
+        newBlock = std::realloc(block, newSize);
+        if (!newBlock)
+        {
+            return nullptr;
+        }
+        numLargeBytes += newSize - oldSize;
+    }
+    else
+    {
+        newBlock = newClass >= 0 ? AllocateBlock(newClass) : std::malloc(newSize);
+        if (!newBlock)
+        {
+            // Lua keeps the old block when the allocation fails
+            return nullptr;
+        }
+        if (newClass < 0)
+        {
+            numLargeBytes += newSize;
+        }
+        if (block)
+        {
+            std::memcpy(newBlock, block, std::min(oldSize, newSize));
+            Reallocate(block, oldSize, 0);
+        }
+        oldSize = 0;
+    }
+    numBytesInUse += newSize - oldSize;
+    return newBlock;
+}
+
+void* ScriptAllocator::LuaAllocate(void* allocator, void* block, size_t oldSize, size_t newSize)
+{
+    return static_cast<ScriptAllocator*>(allocator)->Reallocate(block, oldSize, newSize);
+}
@@ -0,0 +1,58 @@
+#ifndef SCRIPTALLOCATOR_H
+#define SCRIPTALLOCATOR_H
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Blocks of 16 to 2048 bytes come from the pools, larger ones from malloc
+const int SCRIPT_ALLOCATOR_NUM_SIZE_CLASSES = 8;
+const size_t SCRIPT_ALLOCATOR_MIN_BLOCK_SIZE = 16;
+const size_t SCRIPT_ALLOCATOR_PAGE_SIZE = 64 * 1024;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Script allocator
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The lua_Alloc of the script engine. Lua allocates and frees lots of small objects (strings,
+// tables, closures), a size-class pool serves them from free lists carved out of 64 KB pages
+// instead of going through malloc each time. The pages are kept until the allocator goes
+// away. Not thread safe, like the Lua state using it.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class ScriptAllocator
+{
+private:
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    std::array<FreeBlock*, SCRIPT_ALLOCATOR_NUM_SIZE_CLASSES> freeLists = {};
+    std::vector<std::unique_ptr<char[]>> pages;
+    size_t numBytesInUse = 0;
+    size_t numLargeBytes = 0;
+
+    // -1 for the sizes served by malloc
+    static int GetSizeClass(size_t size);
+    static size_t GetBlockSize(int sizeClass) { return SCRIPT_ALLOCATOR_MIN_BLOCK_SIZE << sizeClass; }
+
+    void* AllocateBlock(int sizeClass);
+    void ReleaseBlock(void* block, int sizeClass);
+
+public:
+    ScriptAllocator() = default;
+    ScriptAllocator(const ScriptAllocator&) = delete;
+    ScriptAllocator& operator=(const ScriptAllocator&) = delete;
+
+    // Follows lua_Alloc: frees when newSize is 0, oldSize is not a size when block is null
+    void* Reallocate(void* block, size_t oldSize, size_t newSize);
+    // Passed to lua_newstate with the allocator as its user data
+    static void* LuaAllocate(void* allocator, void* block, size_t oldSize, size_t newSize);
+
+    // Bytes Lua asked for and still holds
+    size_t GetNumBytesInUse() const { return numBytesInUse; }
+    // Bytes taken from the system, the pool pages and the large blocks
+    size_t GetNumBytesReserved() const { return pages.size() * SCRIPT_ALLOCATOR_PAGE_SIZE + numLargeBytes; }
+};
+
+#endif
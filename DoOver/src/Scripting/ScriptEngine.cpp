@@ -0,0 +1,361 @@
+#include "ScriptEngine.h"
+#include "ScriptAllocator.h"
+#include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
+#include <sol/sol.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <tuple>
+
+// A behaviour coroutine runs on its own Lua thread, kept referenced so the collector leaves it alone
+struct Behaviour
+{
+    sol::thread thread;
+    sol::coroutine coroutine;
+    // Passed to every resume, its address must not change while the coroutine holds it
+    std::unique_ptr<ScriptEntity> entity;
+    // Bumped when the id is reused, so the wake ups of a stopped behaviour are skipped
+    uint32_t generation = 0;
+    bool isRunning = false;
+};
+
+struct BehaviourWakeup
+{
+    uint64_t tick;
+    int behaviourId;
+    uint32_t generation;
+
+    // Ties resume in id order, so runs replay the same
+    bool operator>(const BehaviourWakeup& other) const
+    {
+        return tick != other.tick ? tick > other.tick : behaviourId > other.behaviourId;
+    }
+};
+
+struct ScriptEngine::State
+{
+    // Declared before the Lua state, which frees its memory through it when it closes
+    ScriptAllocator allocator;
+    sol::state lua{sol::default_at_panic, &ScriptAllocator::LuaAllocate, &allocator};
+    // [script handle] -> update function of the script, invalid if there is none
+    std::vector<sol::protected_function> updates;
+    // [script handle] -> behaviour function of the script, invalid if there is none
+    std::vector<sol::protected_function> behaviourFunctions;
+
+    // [behaviour id] -> behaviour
+    std::vector<Behaviour> behaviours;
+    std::vector<int> freeBehaviourIds;
+    std::priority_queue<BehaviourWakeup, std::vector<BehaviourWakeup>, std::greater<BehaviourWakeup>> wakeups;
+    uint64_t tick = 0;
+    int numBehaviours = 0;
+    int numResumed = 0;
+
+    // Live bytes at the end of the last collector cycle
+    size_t numBytesAfterCycle = 0;
+    double gcMillisecs = 0.0;
+    int numGcCycles = 0;
+};
+
+// The accessors check the index themselves, sol runs without its safety checks
+static bool IsInBatch(const ScriptBatch& batch, int index)
+{
+    return index >= 1 && index <= batch.GetSize();
+}
+
+ScriptEngine::ScriptEngine()
+{
+    state = std::make_unique<State>();
+    lua_gc(state->lua.lua_state(), LUA_GCSTOP, 0);
+    state->lua.open_libraries(sol::lib::base, sol::lib::coroutine, sol::lib::math, sol::lib::string, sol::lib::table);
+    // Suspends a behaviour for the given number of seconds, 0 resumes it on the next tick
+    state->lua.script("function wait(seconds) return coroutine.yield(seconds or 0) end");
+
+    state->lua.new_usertype<ScriptBatch>("ScriptBatch",
+        sol::no_constructor,
+        "size", &ScriptBatch::GetSize,
+        "entity", [](const ScriptBatch& batch, int index)
+        {
+            return IsInBatch(batch, index) ? batch.entityIds[index - 1] : -1;
+        },
+        "position", [](const ScriptBatch& batch, int index)
+        {
+            if (!IsInBatch(batch, index))
+            {
+                return std::make_tuple(0.0f, 0.0f);
+            }
+            const glm::vec2& position = batch.transforms[index - 1]->position;
+            return std::make_tuple(position.x, position.y);
+        },
+        "set_position", [](ScriptBatch& batch, int index, float x, float y)
+        {
+            if (IsInBatch(batch, index))
+            {
+                batch.transforms[index - 1]->position = glm::vec2(x, y);
+            }
+        },
+        "rotation", [](const ScriptBatch& batch, int index)
+        {
+            return IsInBatch(batch, index) ? batch.transforms[index - 1]->rotation : 0.0f;
+        },
+        "set_rotation", [](ScriptBatch& batch, int index, double rotation)
+        {
+            if (IsInBatch(batch, index))
+            {
+                batch.transforms[index - 1]->rotation = static_cast<float>(rotation);
+            }
+        },
+        "velocity", [](const ScriptBatch& batch, int index)
+        {
+            if (!IsInBatch(batch, index))
+            {
+                return std::make_tuple(0.0f, 0.0f);
+            }
+            const glm::vec2& velocity = batch.rigidBodies[index - 1]->velocity;
+            return std::make_tuple(velocity.x, velocity.y);
+        },
+        "set_velocity", [](ScriptBatch& batch, int index, float x, float y)
+        {
+            if (IsInBatch(batch, index))
+            {
+                batch.rigidBodies[index - 1]->velocity = glm::vec2(x, y);
+            }
+        }
+    );
+    state->lua.new_usertype<ScriptEntity>("ScriptEntity",
+        sol::no_constructor,
+        "id", [](const ScriptEntity& entity) { return entity.entityId; },
+        "position", [](const ScriptEntity& entity)
+        {
+            return std::make_tuple(entity.transform->position.x, entity.transform->position.y);
+        },
+        "set_position", [](ScriptEntity& entity, float x, float y)
+        {
+            entity.transform->position = glm::vec2(x, y);
+        },
+        "rotation", [](const ScriptEntity& entity) { return entity.transform->rotation; },
+        "set_rotation", [](ScriptEntity& entity, double rotation)
+        {
+            entity.transform->rotation = static_cast<float>(rotation);
+        },
+        "velocity", [](const ScriptEntity& entity)
+        {
+            return std::make_tuple(entity.rigidBody->velocity.x, entity.rigidBody->velocity.y);
+        },
+        "set_velocity", [](ScriptEntity& entity, float x, float y)
+        {
+            entity.rigidBody->velocity = glm::vec2(x, y);
+        }
+    );
+    Logger::Log("ScriptEngine constructor called!");
+}
+
+ScriptEngine::~ScriptEngine()
+{
+    Logger::Log("ScriptEngine destructor called!");
+}
+
+bool ScriptEngine::CompileScript(const std::string& filePath, std::string& chunk)
+{
+    PROFILE_SCOPE("Script compile");
+    sol::state lua;
+    sol::load_result loaded = lua.load_file(filePath);
+    if (!loaded.valid())
+    {
+        sol::error error = loaded;
+        Logger::Err("Error compiling script " + filePath + ": " + error.what());
+        return false;
+    }
+    const sol::bytecode bytecode = loaded.get<sol::protected_function>().dump();
+    chunk.assign(bytecode.as_string_view());
+    return true;
+}
+
+bool ScriptEngine::LoadScript(const std::string& scriptId, const std::string& filePath, const std::string& chunk)
+{
+    sol::environment environment(state->lua, sol::create, state->lua.globals());
+    sol::protected_function_result result = chunk.empty()
+        ? state->lua.safe_script_file(filePath, environment, sol::script_pass_on_error)
+        : state->lua.safe_script(chunk, environment, sol::script_pass_on_error, "@" + filePath);
+    if (!result.valid())
+    {
+        sol::error error = result;
+        Logger::Err("Error loading script " + filePath + ": " + error.what());
+        return false;
+    }
+    sol::protected_function update = environment["update"];
+    sol::protected_function behaviour = environment["behaviour"];
+    if (!update.valid() && !behaviour.valid())
+    {
+        Logger::Err("Script " + filePath + " has no update or behaviour function");
+        return false;
+    }
+
+    const AssetHandle scriptHandle = GetAssetHandle(scriptId);
+    if (scriptHandle >= static_cast<int>(state->updates.size()))
+    {
+        state->updates.resize(scriptHandle + 1);
+        state->behaviourFunctions.resize(scriptHandle + 1);
+    }
+    state->updates[scriptHandle] = update;
+    state->behaviourFunctions[scriptHandle] = behaviour;
+    Logger::Log("Script " + scriptId + " loaded from " + filePath);
+    return true;
+}
+
+bool ScriptEngine::HasScript(AssetHandle scriptHandle) const
+{
+    return scriptHandle >= 0 && scriptHandle < static_cast<int>(state->updates.size()) && state->updates[scriptHandle].valid();
+}
+
+void ScriptEngine::RunUpdate(AssetHandle scriptHandle, ScriptBatch& batch, double deltaTime)
+{
+    if (!HasScript(scriptHandle))
+    {
+        return;
+    }
+    sol::protected_function_result result = state->updates[scriptHandle](&batch, deltaTime);
+    if (!result.valid())
+    {
+        sol::error error = result;
+        Logger::Err("Script " + GetAssetId(scriptHandle) + " disabled after an error: " + error.what());
+        state->updates[scriptHandle] = sol::protected_function();
+    }
+}
+
+bool ScriptEngine::HasBehaviour(AssetHandle scriptHandle) const
+{
+    return scriptHandle >= 0 && scriptHandle < static_cast<int>(state->behaviourFunctions.size()) && state->behaviourFunctions[scriptHandle].valid();
+}
+
+int ScriptEngine::StartBehaviour(AssetHandle scriptHandle, int entityId)
+{
+    if (!HasBehaviour(scriptHandle))
+    {
+        return -1;
+    }
+    int behaviourId;
+    if (state->freeBehaviourIds.empty())
+    {
+        behaviourId = state->behaviours.size();
+        state->behaviours.emplace_back();
+        state->behaviours.back().entity = std::make_unique<ScriptEntity>();
+    }
+    else
+    {
+        behaviourId = state->freeBehaviourIds.back();
+        state->freeBehaviourIds.pop_back();
+    }
+    Behaviour& behaviour = state->behaviours[behaviourId];
+    behaviour.thread = sol::thread::create(state->lua.lua_state());
+    behaviour.coroutine = sol::coroutine(behaviour.thread.state(), state->behaviourFunctions[scriptHandle]);
+    *behaviour.entity = ScriptEntity();
+    behaviour.entity->entityId = entityId;
+    behaviour.isRunning = true;
+    state->wakeups.push({state->tick + 1, behaviourId, behaviour.generation});
+    state->numBehaviours++;
+    return behaviourId;
+}
+
+void ScriptEngine::StopBehaviour(int behaviourId)
+{
+    if (behaviourId < 0 || behaviourId >= static_cast<int>(state->behaviours.size()) || !state->behaviours[behaviourId].isRunning)
+    {
+        return;
+    }
+    Behaviour& behaviour = state->behaviours[behaviourId];
+    behaviour.coroutine = sol::coroutine();
+    behaviour.thread = sol::thread();
+    behaviour.generation++;
+    behaviour.isRunning = false;
+    state->freeBehaviourIds.push_back(behaviourId);
+    state->numBehaviours--;
+}
+
+void ScriptEngine::StopBehaviours()
+{
+    for (int behaviourId = 0; behaviourId < static_cast<int>(state->behaviours.size()); behaviourId++)
+    {
+        StopBehaviour(behaviourId);
+    }
+    state->wakeups = decltype(state->wakeups)();
+}
+
+void ScriptEngine::RunBehaviours(double deltaTime, const ScriptEntityBinder& bind)
+{
+    state->tick++;
+    state->numResumed = 0;
+    while (!state->wakeups.empty() && state->wakeups.top().tick <= state->tick)
+    {
+        const BehaviourWakeup wakeup = state->wakeups.top();
+        state->wakeups.pop();
+        Behaviour& behaviour = state->behaviours[wakeup.behaviourId];
+        if (!behaviour.isRunning || behaviour.generation != wakeup.generation)
+        {
+            continue;
+        }
+        if (!bind(wakeup.behaviourId, *behaviour.entity))
+        {
+            StopBehaviour(wakeup.behaviourId);
+            continue;
+        }
+
+        state->numResumed++;
+        sol::protected_function_result result = behaviour.coroutine(behaviour.entity.get());
+        if (!result.valid())
+        {
+            sol::error error = result;
+            Logger::Err("Behaviour of entity " + std::to_string(behaviour.entity->entityId) + " stopped after an error: " + error.what());
+            StopBehaviour(wakeup.behaviourId);
+            continue;
+        }
+        if (result.status() != sol::call_status::yielded)
+        {
+            // The behaviour returned
+            StopBehaviour(wakeup.behaviourId);
+            continue;
+        }
+
+        // A wait always lasts at least until the next tick
+        const double seconds = result.get_type() == sol::type::number ? result.get<double>() : 0.0;
+        const uint64_t numTicks = static_cast<uint64_t>(std::max(1.0, std::ceil(seconds / deltaTime - 1e-9)));
+        state->wakeups.push({state->tick + numTicks, wakeup.behaviourId, wakeup.generation});
+    }
+}
+
+void ScriptEngine::SetRandomSeed(uint32_t seed)
+{
+    state->lua["math"]["randomseed"](seed);
+}
+
+void ScriptEngine::CollectGarbage(double budgetMillisecs)
+{
+    PROFILE_SCOPE("Script GC");
+    lua_State* luaState = state->lua.lua_state();
+    const auto start = std::chrono::steady_clock::now();
+    const size_t maxBytes = std::max(static_cast<size_t>(state->numBytesAfterCycle * SCRIPT_GC_MAX_GROWTH), SCRIPT_GC_MIN_HEAP_BYTES);
+    const bool isOverBudget = state->allocator.GetNumBytesInUse() > maxBytes;
+
+    double millisecs = 0.0;
+    while (isOverBudget || millisecs < budgetMillisecs)
+    {
+        // Returns 1 when the step ended a cycle
+        if (lua_gc(luaState, LUA_GCSTEP, SCRIPT_GC_STEP_KB))
+        {
+            state->numBytesAfterCycle = state->allocator.GetNumBytesInUse();
+            state->numGcCycles++;
+            millisecs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            break;
+        }
+        millisecs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    state->gcMillisecs = millisecs;
+}
+
+ScriptStats ScriptEngine::GetStats() const
+{
+    return {state->allocator.GetNumBytesInUse(), state->allocator.GetNumBytesReserved(), state->gcMillisecs, state->numGcCycles,
+        state->numBehaviours, state->numResumed};
+}
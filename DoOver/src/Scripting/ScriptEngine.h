@@ -0,0 +1,150 @@
+#ifndef SCRIPTENGINE_H
+#define SCRIPTENGINE_H
+
+#include "../AssetStore/AssetHandle.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/RigidBodyComponent.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Script batch
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Every entity running the same script, handed to the script in a single call. The script
+// reads and writes the components in place through the batch, indexed from 1 like a Lua array:
+//
+//     function update(batch, deltaTime)
+//         for i = 1, batch:size() do
+//             local vx, vy = batch:velocity(i)
+//             batch:set_velocity(i, -vx, vy)
+//         end
+//     end
+/////////////////////////////////////////////////////////////////////////////////////////////
+struct ScriptBatch
+{
+    std::vector<int> entityIds;
+    std::vector<TransformComponent*> transforms;
+    std::vector<RigidBodyComponent*> rigidBodies;
+
+    void Clear()
+    {
+        entityIds.clear();
+        transforms.clear();
+        rigidBodies.clear();
+    }
+
+    void Add(int entityId, TransformComponent& transform, RigidBodyComponent& rigidBody)
+    {
+        entityIds.push_back(entityId);
+        transforms.push_back(&transform);
+        rigidBodies.push_back(&rigidBody);
+    }
+
+    int GetSize() const
+    {
+        return static_cast<int>(entityIds.size());
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Script entity
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The entity a behaviour runs for. Behaviours are coroutines that wait between their steps,
+// the component pointers are bound again before every resume since the pools may have moved:
+//
+//     function behaviour(entity)
+//         while true do
+//             entity:set_velocity(40, 0)
+//             wait(2.5)
+//             entity:set_velocity(0, 0)
+//             wait(3)
+//         end
+//     end
+/////////////////////////////////////////////////////////////////////////////////////////////
+struct ScriptEntity
+{
+    int entityId = -1;
+    TransformComponent* transform = nullptr;
+    RigidBodyComponent* rigidBody = nullptr;
+};
+
+// Binds the entity of a behaviour before it resumes, false when the entity is gone
+using ScriptEntityBinder = std::function<bool(int behaviourId, ScriptEntity& entity)>;
+
+// Memory and collector numbers of the Lua state, for the performance overlay
+struct ScriptStats
+{
+    size_t numBytesInUse;
+    size_t numBytesReserved;
+    // Time the collector took in the last CollectGarbage call
+    double gcMillisecs;
+    int numGcCycles;
+    int numBehaviours;
+    // Behaviours resumed in the last RunBehaviours call
+    int numResumed;
+};
+
+// The collector finishes its cycle outside the budget when the memory grew past this factor of
+// what was live after the previous cycle, so a tight budget can't let the heap grow unbounded
+const double SCRIPT_GC_MAX_GROWTH = 2.0;
+const size_t SCRIPT_GC_MIN_HEAP_BYTES = 1024 * 1024;
+// Work asked of the collector per step, in KB as lua_gc counts it
+const int SCRIPT_GC_STEP_KB = 16;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Script engine
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Owns the Lua state, sol2 stays inside ScriptEngine.cpp so the rest of the engine doesn't
+// compile it. Each script runs in its own environment and defines update(batch, deltaTime).
+// The Lua state is not thread safe, only one system may call into it.
+// Besides update, a script can define behaviour(entity), started as one coroutine per entity.
+// The waiting coroutines sit in a min-heap of wake up ticks, a tick only touches the ones due.
+// Its memory comes from a ScriptAllocator, the automatic collector is off and the game runs
+// it in small steps with CollectGarbage, once per frame and within a time budget.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class ScriptEngine
+{
+private:
+    struct State;
+    std::unique_ptr<State> state;
+
+public:
+    ScriptEngine();
+    ~ScriptEngine();
+
+    // Runs a script file under a script id, returns false if it fails or defines neither an
+    // update nor a behaviour function. A chunk compiled by CompileScript is run instead of
+    // the file, when given.
+    bool LoadScript(const std::string& scriptId, const std::string& filePath, const std::string& chunk = "");
+    // Compiles the file to a chunk LoadScript runs, in a Lua state of its own so any thread can
+    static bool CompileScript(const std::string& filePath, std::string& chunk);
+    bool HasScript(AssetHandle scriptHandle) const;
+
+    // Calls the update function of a script once for the whole batch. A script that raises an
+    // error is logged and disabled.
+    void RunUpdate(AssetHandle scriptHandle, ScriptBatch& batch, double deltaTime);
+
+    bool HasBehaviour(AssetHandle scriptHandle) const;
+    // Starts the behaviour of the script as a coroutine that first resumes on the next
+    // RunBehaviours, returns the behaviour id or -1 if the script has no behaviour
+    int StartBehaviour(AssetHandle scriptHandle, int entityId);
+    void StopBehaviour(int behaviourId);
+    // Stops every behaviour, when the level their entities were in goes away
+    void StopBehaviours();
+    // Advances one tick and resumes the behaviours whose wait ended. A finished behaviour or
+    // one that raised an error is stopped.
+    void RunBehaviours(double deltaTime, const ScriptEntityBinder& bind);
+
+    // Seeds math.random, so the scripts make the same choices from the same seed
+    void SetRandomSeed(uint32_t seed);
+
+    // Runs collector steps until the budget is spent or a cycle ends
+    void CollectGarbage(double budgetMillisecs);
+    ScriptStats GetStats() const;
+};
+
+#endif
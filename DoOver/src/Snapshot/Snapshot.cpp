@@ -0,0 +1,595 @@
+#include "./Snapshot.h"
+#include "../Logger/Logger.h"
+#include <cstdio>
+#include <cstring>
+
+bool Snapshot::Save(const Registry& registry, const std::vector<bool>* isEntityVisible)
+{
+    data.clear();
+    SnapshotHeader header;
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.entityIdBits = ENTITY_ID_BITS;
+    header.maxComponents = MAX_COMPONENTS;
+    SnapshotWriter writer(data);
+    writer.WriteBytes(&header, sizeof(header));
+
+    // Every asset id interned so far, the handles saved in the components index this table
+    const int numAssetHandles = GetNumAssetHandles();
+    writer.WriteVarint(numAssetHandles);
+    for (AssetHandle assetHandle = 0; assetHandle < numAssetHandles; assetHandle++)
+    {
+        writer.WriteString(GetAssetId(assetHandle));
+    }
+
+    if (!registry.WriteSnapshot(writer, isEntityVisible))
+    {
+        data.clear();
+        return false;
+    }
+    return true;
+}
+
+bool Snapshot::Load(Registry& registry) const
+{
+    SnapshotReader reader(data.data(), data.size());
+    SnapshotHeader header;
+    if (!reader.ReadBytes(&header, sizeof(header)) || std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0)
+    {
+        Logger::Err("Not a snapshot");
+        return false;
+    }
+    if (header.version != SNAPSHOT_VERSION || header.entityIdBits != ENTITY_ID_BITS || header.maxComponents != MAX_COMPONENTS)
+    {
+        Logger::Err("The snapshot was saved by another version of the game");
+        return false;
+    }
+
+    SnapshotRemap remap;
+    remap.registryIndex = registry.GetRegistryIndex();
+    remap.assetHandles.resize(reader.ReadCount(reader.GetNumRemainingBytes()));
+    for (auto& assetHandle: remap.assetHandles)
+    {
+        assetHandle = GetAssetHandle(reader.ReadString());
+    }
+    if (reader.HasFailed())
+    {
+        Logger::Err("The asset ids of the snapshot are corrupt");
+        return false;
+    }
+    return registry.ReadSnapshot(reader, remap);
+}
+
+bool Snapshot::WriteFile(const std::string& filePath) const
+{
+    // Beside the file, which is only replaced once the snapshot is whole
+    const std::string tempFilePath = filePath + ".tmp";
+    std::FILE* file = std::fopen(tempFilePath.c_str(), "wb");
+    if (!file)
+    {
+        Logger::Err("Unable to write the snapshot " + filePath);
+        return false;
+    }
+    const bool isWritten = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    std::fclose(file);
+    if (!isWritten)
+    {
+        std::remove(tempFilePath.c_str());
+        Logger::Err("Unable to write the snapshot " + filePath);
+        return false;
+    }
+    if (std::rename(tempFilePath.c_str(), filePath.c_str()) == 0)
+    {
+        return true;
+    }
+    // Windows doesn't rename over an existing file
+    std::remove(filePath.c_str());
+    return std::rename(tempFilePath.c_str(), filePath.c_str()) == 0;
+}
+
+bool Snapshot::ReadFile(const std::string& filePath)
+{
+    std::FILE* file = std::fopen(filePath.c_str(), "rb");
+    if (!file)
+    {
+        Logger::Err("Unable to open the snapshot " + filePath);
+        return false;
+    }
+    std::fseek(file, 0, SEEK_END);
+    const long size = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    data.resize(size > 0 ? size : 0);
+    const bool isRead = std::fread(data.data(), 1, data.size(), file) == data.size();
+    std::fclose(file);
+    if (!isRead)
+    {
+        data.clear();
+    }
+    return isRead;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Snapshot image
+/////////////////////////////////////////////////////////////////////////////////////////////
+// A snapshot split into its sections, as Registry::WriteSnapshot lays them out, so two
+// snapshots can be compared section by section
+/////////////////////////////////////////////////////////////////////////////////////////////
+struct SnapshotPoolImage
+{
+    int componentId = 0;
+    int componentSize = 0;
+    std::vector<int> entityIds;
+    std::vector<uint8_t> components;
+};
+
+struct SnapshotImage
+{
+    std::vector<std::string> assetIds;
+    std::vector<uint64_t> signatures;
+    std::vector<uint8_t> versions;
+    std::vector<int> freeIds;
+    std::vector<SnapshotPoolImage> pools;
+    // The tags and groups, kept as they are
+    std::vector<uint8_t> tail;
+};
+
+// The dense order of a pool is not sorted, but each entity is in it at most once
+static bool AreEntityIdsValid(const std::vector<int>& entityIds, size_t numEntities)
+{
+    std::vector<bool> isListed(numEntities, false);
+    for (auto entityId: entityIds)
+    {
+        if (entityId < 0 || entityId >= static_cast<int>(numEntities) || isListed[entityId])
+        {
+            return false;
+        }
+        isListed[entityId] = true;
+    }
+    return true;
+}
+
+static bool ReadSnapshotImage(const std::vector<uint8_t>& data, SnapshotImage& image)
+{
+    SnapshotReader reader(data.data(), data.size());
+    SnapshotHeader header;
+    if (!reader.ReadBytes(&header, sizeof(header)) || std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 || header.version != SNAPSHOT_VERSION)
+    {
+        return false;
+    }
+    image.assetIds.resize(reader.ReadCount(reader.GetNumRemainingBytes()));
+    for (auto& assetId: image.assetIds)
+    {
+        assetId = reader.ReadString();
+    }
+    image.signatures.resize(reader.ReadCount(MAX_ENTITIES));
+    for (auto& signature: image.signatures)
+    {
+        signature = reader.ReadVarint();
+    }
+    image.versions.resize(reader.ReadCount(MAX_ENTITIES));
+    reader.ReadBytes(image.versions.data(), image.versions.size());
+    image.freeIds.resize(reader.ReadCount(MAX_ENTITIES));
+    for (auto& entityId: image.freeIds)
+    {
+        entityId = reader.ReadVarint();
+    }
+    image.pools.resize(reader.ReadCount(MAX_COMPONENTS));
+    for (auto& pool: image.pools)
+    {
+        pool.componentId = reader.ReadCount(MAX_COMPONENTS - 1);
+        pool.componentSize = reader.ReadCount(ARCHETYPE_CHUNK_SIZE);
+        pool.entityIds.resize(reader.ReadCount(MAX_ENTITIES));
+        int entityId = 0;
+        for (auto& poolEntityId: pool.entityIds)
+        {
+            entityId += reader.ReadSignedVarint();
+            poolEntityId = entityId;
+        }
+        const size_t numBytes = pool.entityIds.size() * pool.componentSize;
+        if (reader.HasFailed() || !AreEntityIdsValid(pool.entityIds, image.signatures.size()) || numBytes > reader.GetNumRemainingBytes())
+        {
+            return false;
+        }
+        pool.components.resize(numBytes);
+        reader.ReadBytes(pool.components.data(), numBytes);
+    }
+    image.tail.resize(reader.GetNumRemainingBytes());
+    reader.ReadBytes(image.tail.data(), image.tail.size());
+    return !reader.HasFailed();
+}
+
+bool Snapshot::IsValid() const
+{
+    SnapshotImage image;
+    return ReadSnapshotImage(data, image);
+}
+
+static void WriteSnapshotImage(const SnapshotImage& image, std::vector<uint8_t>& data)
+{
+    data.clear();
+    SnapshotHeader header;
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.entityIdBits = ENTITY_ID_BITS;
+    header.maxComponents = MAX_COMPONENTS;
+    SnapshotWriter writer(data);
+    writer.WriteBytes(&header, sizeof(header));
+    writer.WriteVarint(image.assetIds.size());
+    for (const auto& assetId: image.assetIds)
+    {
+        writer.WriteString(assetId);
+    }
+    writer.WriteVarint(image.signatures.size());
+    for (auto signature: image.signatures)
+    {
+        writer.WriteVarint(signature);
+    }
+    writer.WriteVarint(image.versions.size());
+    writer.WriteBytes(image.versions.data(), image.versions.size());
+    writer.WriteVarint(image.freeIds.size());
+    for (auto entityId: image.freeIds)
+    {
+        writer.WriteVarint(entityId);
+    }
+    writer.WriteVarint(image.pools.size());
+    for (const auto& pool: image.pools)
+    {
+        writer.WriteVarint(pool.componentId);
+        writer.WriteVarint(pool.componentSize);
+        writer.WriteVarint(pool.entityIds.size());
+        int previousEntityId = 0;
+        for (auto entityId: pool.entityIds)
+        {
+            writer.WriteSignedVarint(entityId - previousEntityId);
+            previousEntityId = entityId;
+        }
+        writer.WriteBytes(pool.components.data(), pool.components.size());
+    }
+    writer.WriteBytes(image.tail.data(), image.tail.size());
+}
+
+// The values that differ from the baseline's, as (index gap, value) pairs. The values past
+// the end of the baseline are compared with 0.
+template <typename TValue>
+static void WriteChangedValues(SnapshotWriter& writer, const std::vector<TValue>& baseline, const std::vector<TValue>& values)
+{
+    std::vector<int> changedIndices;
+    for (int index = 0; index < static_cast<int>(values.size()); index++)
+    {
+        const TValue baselineValue = index < static_cast<int>(baseline.size()) ? baseline[index] : 0;
+        if (values[index] != baselineValue)
+        {
+            changedIndices.push_back(index);
+        }
+    }
+    writer.WriteVarint(values.size());
+    writer.WriteVarint(changedIndices.size());
+    int previousIndex = 0;
+    for (auto index: changedIndices)
+    {
+        writer.WriteVarint(index - previousIndex);
+        writer.WriteVarint(values[index]);
+        previousIndex = index;
+    }
+}
+
+template <typename TValue>
+static void ReadChangedValues(SnapshotReader& reader, const std::vector<TValue>& baseline, std::vector<TValue>& values)
+{
+    values.assign(reader.ReadCount(MAX_ENTITIES), 0);
+    std::copy(baseline.begin(), baseline.begin() + std::min(baseline.size(), values.size()), values.begin());
+    const int numChanged = reader.ReadCount(values.size());
+    size_t index = 0;
+    for (int i = 0; i < numChanged; i++)
+    {
+        index += reader.ReadVarint();
+        const TValue value = static_cast<TValue>(reader.ReadVarint());
+        if (index >= values.size())
+        {
+            reader.Fail();
+            return;
+        }
+        values[index] = value;
+    }
+}
+
+bool SnapshotDelta::Encode(const Snapshot& baseline, const Snapshot& snapshot)
+{
+    data.clear();
+    SnapshotImage baselineImage;
+    SnapshotImage image;
+    if (!ReadSnapshotImage(baseline.GetData(), baselineImage) || !ReadSnapshotImage(snapshot.GetData(), image))
+    {
+        Logger::Err("Cannot encode the delta of a corrupt snapshot");
+        return false;
+    }
+
+    SnapshotDeltaHeader header;
+    std::memcpy(header.magic, SNAPSHOT_DELTA_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_DELTA_VERSION;
+    header.baselineSize = baseline.GetSize();
+    SnapshotWriter writer(data);
+    writer.WriteBytes(&header, sizeof(header));
+
+    // The asset ids are only ever appended, so usually the baseline's are a prefix
+    size_t numKeptAssetIds = 0;
+    while (numKeptAssetIds < image.assetIds.size() && numKeptAssetIds < baselineImage.assetIds.size()
+        && image.assetIds[numKeptAssetIds] == baselineImage.assetIds[numKeptAssetIds])
+    {
+        numKeptAssetIds++;
+    }
+    writer.WriteVarint(numKeptAssetIds);
+    writer.WriteVarint(image.assetIds.size() - numKeptAssetIds);
+    for (size_t i = numKeptAssetIds; i < image.assetIds.size(); i++)
+    {
+        writer.WriteString(image.assetIds[i]);
+    }
+
+    WriteChangedValues(writer, baselineImage.signatures, image.signatures);
+    WriteChangedValues(writer, baselineImage.versions, image.versions);
+    writer.WriteVarint(image.freeIds.size());
+    for (auto entityId: image.freeIds)
+    {
+        writer.WriteVarint(entityId);
+    }
+
+    std::vector<const SnapshotPoolImage*> baselinePools(MAX_COMPONENTS, nullptr);
+    for (const auto& pool: baselineImage.pools)
+    {
+        if (pool.componentId >= 0 && pool.componentId < static_cast<int>(MAX_COMPONENTS))
+        {
+            baselinePools[pool.componentId] = &pool;
+        }
+    }
+    std::vector<int> baselineIndices;
+    std::vector<uint8_t> zeros;
+    std::vector<uint8_t> xorBytes;
+    writer.WriteVarint(image.pools.size());
+    for (const auto& pool: image.pools)
+    {
+        if (pool.componentSize > static_cast<int>(SNAPSHOT_DELTA_MAX_COMPONENT_SIZE))
+        {
+            Logger::Err(std::string("Components of ") + GetComponentName(pool.componentId) + " are too large for the snapshot deltas");
+            data.clear();
+            return false;
+        }
+        writer.WriteVarint(pool.componentId);
+        writer.WriteVarint(pool.componentSize);
+        const SnapshotPoolImage* baselinePool = baselinePools[pool.componentId];
+        if (baselinePool && baselinePool->componentSize != pool.componentSize)
+        {
+            baselinePool = nullptr;
+        }
+
+        // The dense order as the entity ids that moved, a removal only moves the last one
+        static const std::vector<int> noEntityIds;
+        WriteChangedValues(writer, baselinePool ? baselinePool->entityIds : noEntityIds, pool.entityIds);
+
+        // [entity id] -> dense index of its component in the baseline, -1 if it had none
+        baselineIndices.assign(image.signatures.size(), -1);
+        if (baselinePool)
+        {
+            for (int index = 0; index < static_cast<int>(baselinePool->entityIds.size()); index++)
+            {
+                if (baselinePool->entityIds[index] < static_cast<int>(baselineIndices.size()))
+                {
+                    baselineIndices[baselinePool->entityIds[index]] = index;
+                }
+            }
+        }
+
+        // A component new since the baseline is XORed with zeros
+        const size_t componentSize = pool.componentSize;
+        const size_t maskSize = (componentSize + 7) / 8;
+        zeros.assign(componentSize, 0);
+        xorBytes.clear();
+        SnapshotWriter changedWriter(xorBytes);
+        int numChanged = 0;
+        int previousIndex = 0;
+        for (int index = 0; index < static_cast<int>(pool.entityIds.size()); index++)
+        {
+            const uint8_t* component = pool.components.data() + index * componentSize;
+            const int entityId = pool.entityIds[index];
+            const int baselineIndex = entityId < static_cast<int>(baselineIndices.size()) ? baselineIndices[entityId] : -1;
+            const uint8_t* baselineComponent = baselineIndex == -1 ? zeros.data() : baselinePool->components.data() + baselineIndex * componentSize;
+            if (std::memcmp(component, baselineComponent, componentSize) == 0)
+            {
+                continue;
+            }
+            uint8_t mask[SNAPSHOT_DELTA_MAX_COMPONENT_SIZE / 8] = {};
+            uint8_t changedBytes[SNAPSHOT_DELTA_MAX_COMPONENT_SIZE];
+            int numChangedBytes = 0;
+            for (size_t byte = 0; byte < componentSize; byte++)
+            {
+                const uint8_t difference = component[byte] ^ baselineComponent[byte];
+                if (difference)
+                {
+                    mask[byte / 8] |= 1 << (byte % 8);
+                    changedBytes[numChangedBytes++] = difference;
+                }
+            }
+            changedWriter.WriteVarint(index - previousIndex);
+            changedWriter.WriteBytes(mask, maskSize);
+            changedWriter.WriteBytes(changedBytes, numChangedBytes);
+            previousIndex = index;
+            numChanged++;
+        }
+        writer.WriteVarint(numChanged);
+        writer.WriteBytes(xorBytes.data(), xorBytes.size());
+    }
+
+    writer.WriteVarint(image.tail.size());
+    writer.WriteBytes(image.tail.data(), image.tail.size());
+    return true;
+}
+
+bool SnapshotDelta::Decode(const Snapshot& baseline, Snapshot& snapshot) const
+{
+    SnapshotReader reader(data.data(), data.size());
+    SnapshotDeltaHeader header;
+    if (!reader.ReadBytes(&header, sizeof(header)) || std::memcmp(header.magic, SNAPSHOT_DELTA_MAGIC, sizeof(header.magic)) != 0
+        || header.version != SNAPSHOT_DELTA_VERSION)
+    {
+        Logger::Err("Not a snapshot delta");
+        return false;
+    }
+    SnapshotImage baselineImage;
+    if (header.baselineSize != baseline.GetSize() || !ReadSnapshotImage(baseline.GetData(), baselineImage))
+    {
+        Logger::Err("The snapshot delta was encoded against another baseline");
+        return false;
+    }
+
+    SnapshotImage image;
+    const size_t numKeptAssetIds = reader.ReadCount(baselineImage.assetIds.size());
+    image.assetIds.assign(baselineImage.assetIds.begin(), baselineImage.assetIds.begin() + numKeptAssetIds);
+    image.assetIds.resize(numKeptAssetIds + reader.ReadCount(reader.GetNumRemainingBytes()));
+    for (size_t i = numKeptAssetIds; i < image.assetIds.size(); i++)
+    {
+        image.assetIds[i] = reader.ReadString();
+    }
+
+    ReadChangedValues(reader, baselineImage.signatures, image.signatures);
+    ReadChangedValues(reader, baselineImage.versions, image.versions);
+    image.freeIds.resize(reader.ReadCount(image.signatures.size()));
+    for (auto& entityId: image.freeIds)
+    {
+        entityId = reader.ReadVarint();
+    }
+
+    std::vector<const SnapshotPoolImage*> baselinePools(MAX_COMPONENTS, nullptr);
+    for (const auto& pool: baselineImage.pools)
+    {
+        if (pool.componentId >= 0 && pool.componentId < static_cast<int>(MAX_COMPONENTS))
+        {
+            baselinePools[pool.componentId] = &pool;
+        }
+    }
+    std::vector<int> baselineIndices;
+    image.pools.resize(reader.ReadCount(MAX_COMPONENTS));
+    for (auto& pool: image.pools)
+    {
+        pool.componentId = reader.ReadCount(MAX_COMPONENTS - 1);
+        pool.componentSize = reader.ReadCount(SNAPSHOT_DELTA_MAX_COMPONENT_SIZE);
+        const SnapshotPoolImage* baselinePool = baselinePools[pool.componentId];
+        if (baselinePool && baselinePool->componentSize != pool.componentSize)
+        {
+            baselinePool = nullptr;
+        }
+        static const std::vector<int> noEntityIds;
+        ReadChangedValues(reader, baselinePool ? baselinePool->entityIds : noEntityIds, pool.entityIds);
+        if (!AreEntityIdsValid(pool.entityIds, image.signatures.size()))
+        {
+            reader.Fail();
+        }
+        if (reader.HasFailed())
+        {
+            break;
+        }
+
+        // Start from the baseline components of the same entities, zeros for the new ones
+        const size_t componentSize = pool.componentSize;
+        pool.components.assign(pool.entityIds.size() * componentSize, 0);
+        baselineIndices.assign(image.signatures.size(), -1);
+        if (baselinePool)
+        {
+            for (int index = 0; index < static_cast<int>(baselinePool->entityIds.size()); index++)
+            {
+                if (baselinePool->entityIds[index] < static_cast<int>(baselineIndices.size()))
+                {
+                    baselineIndices[baselinePool->entityIds[index]] = index;
+                }
+            }
+            for (int index = 0; index < static_cast<int>(pool.entityIds.size()); index++)
+            {
+                const int baselineIndex = baselineIndices[pool.entityIds[index]];
+                if (baselineIndex != -1)
+                {
+                    std::memcpy(pool.components.data() + index * componentSize, baselinePool->components.data() + baselineIndex * componentSize, componentSize);
+                }
+            }
+        }
+
+        const size_t maskSize = (componentSize + 7) / 8;
+        const int numChanged = reader.ReadCount(pool.entityIds.size());
+        size_t index = 0;
+        for (int i = 0; i < numChanged && !reader.HasFailed(); i++)
+        {
+            index += reader.ReadVarint();
+            uint8_t mask[SNAPSHOT_DELTA_MAX_COMPONENT_SIZE / 8];
+            if (index >= pool.entityIds.size() || !reader.ReadBytes(mask, maskSize))
+            {
+                reader.Fail();
+                break;
+            }
+            uint8_t* component = pool.components.data() + index * componentSize;
+            for (size_t byte = 0; byte < componentSize; byte++)
+            {
+                if (mask[byte / 8] & (1 << (byte % 8)))
+                {
+                    uint8_t difference = 0;
+                    reader.ReadBytes(&difference, 1);
+                    component[byte] ^= difference;
+                }
+            }
+        }
+    }
+
+    image.tail.resize(reader.ReadCount(reader.GetNumRemainingBytes()));
+    reader.ReadBytes(image.tail.data(), image.tail.size());
+    if (reader.HasFailed())
+    {
+        Logger::Err("The snapshot delta is corrupt");
+        return false;
+    }
+    std::vector<uint8_t> snapshotData;
+    WriteSnapshotImage(image, snapshotData);
+    snapshot.SetData(snapshotData.data(), snapshotData.size());
+    return true;
+}
+
+bool SnapshotTimeline::AddFrame(const Registry& registry)
+{
+    Snapshot snapshot;
+    if (!snapshot.Save(registry))
+    {
+        return false;
+    }
+    if (deltas.size() % keyframeInterval == 0)
+    {
+        numBytes += snapshot.GetSize();
+        keyframes.push_back(std::move(snapshot));
+        deltas.emplace_back();
+        return true;
+    }
+    SnapshotDelta delta;
+    if (!delta.Encode(keyframes.back(), snapshot))
+    {
+        return false;
+    }
+    numBytes += delta.GetSize();
+    deltas.push_back(std::move(delta));
+    return true;
+}
+
+bool SnapshotTimeline::LoadFrame(int frame, Registry& registry) const
+{
+    if (frame < 0 || frame >= GetNumFrames())
+    {
+        return false;
+    }
+    const Snapshot& keyframe = keyframes[frame / keyframeInterval];
+    if (deltas[frame].IsEmpty())
+    {
+        return keyframe.Load(registry);
+    }
+    Snapshot snapshot;
+    return deltas[frame].Decode(keyframe, snapshot) && snapshot.Load(registry);
+}
+
+void SnapshotTimeline::Clear()
+{
+    keyframes.clear();
+    deltas.clear();
+    numBytes = 0;
+}
@@ -0,0 +1,132 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "SnapshotStream.h"
+#include "../ECS/ECS.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Snapshot
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The whole state of a registry in one compact buffer, for quick save and quick load:
+//   header | asset ids | entity signatures, versions and free ids | pools | tags | groups |
+//   relationships
+// The dense data of every pool is copied as it is, the entity ids and signatures are
+// varints. The asset handles of the components are only valid in the process that saved
+// them, so the asset ids they stand for are saved along and resolved again on load.
+// The state outside the registry (timers, scripts, particles) is not part of it.
+/////////////////////////////////////////////////////////////////////////////////////////////
+const char SNAPSHOT_MAGIC[4] = {'D', 'O', 'S', 'N'};
+const uint32_t SNAPSHOT_VERSION = 2;
+
+struct SnapshotHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t entityIdBits;
+    uint32_t maxComponents;
+};
+
+class Snapshot
+{
+private:
+    std::vector<uint8_t> data;
+
+public:
+    Snapshot() = default;
+
+    // Replaces the snapshot with the state of the registry, whose commands must all be
+    // applied (see Registry::Update). Given [entity id] -> visible, only the components of the
+    // visible entities are saved.
+    bool Save(const Registry& registry, const std::vector<bool>* isEntityVisible = nullptr);
+    // Replaces the entities of the registry with the ones of the snapshot
+    bool Load(Registry& registry) const;
+
+    // Through a temporary file beside it, a crash while writing keeps the previous one
+    bool WriteFile(const std::string& filePath) const;
+    bool ReadFile(const std::string& filePath);
+
+    bool IsEmpty() const { return data.empty(); }
+    // Whether the header and the pools parse, e.g. before keeping a snapshot received over
+    // the network as the baseline of the deltas that follow
+    bool IsValid() const;
+    size_t GetSize() const { return data.size(); }
+    // The bytes, e.g. to send them over the network
+    const std::vector<uint8_t>& GetData() const { return data; }
+    void SetData(const uint8_t* bytes, size_t size) { data.assign(bytes, bytes + size); }
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Snapshot delta
+/////////////////////////////////////////////////////////////////////////////////////////////
+// What changed from a baseline snapshot to a later one, a fraction of a full snapshot when
+// most entities don't change between the two. Each component is XORed with the baseline's
+// of the same entity and only the nonzero bytes are written, after a bitmask of where they
+// go. The signatures, versions and dense pool orders are written as the entries that changed.
+// Decoding with the same baseline gives back the exact snapshot that was encoded, so the
+// replays and the network state sync can keep a baseline now and then and send the deltas
+// against it.
+/////////////////////////////////////////////////////////////////////////////////////////////
+const char SNAPSHOT_DELTA_MAGIC[4] = {'D', 'O', 'D', 'L'};
+const uint32_t SNAPSHOT_DELTA_VERSION = 1;
+// Larger components can't be encoded, their byte masks would get long
+const unsigned int SNAPSHOT_DELTA_MAX_COMPONENT_SIZE = 512;
+
+struct SnapshotDeltaHeader
+{
+    char magic[4];
+    uint32_t version;
+    // Tells a delta decoded against another baseline than its own
+    uint64_t baselineSize;
+};
+
+class SnapshotDelta
+{
+private:
+    std::vector<uint8_t> data;
+
+public:
+    SnapshotDelta() = default;
+
+    bool Encode(const Snapshot& baseline, const Snapshot& snapshot);
+    bool Decode(const Snapshot& baseline, Snapshot& snapshot) const;
+
+    bool IsEmpty() const { return data.empty(); }
+    size_t GetSize() const { return data.size(); }
+    const std::vector<uint8_t>& GetData() const { return data; }
+    void SetData(const uint8_t* bytes, size_t size) { data.assign(bytes, bytes + size); }
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Snapshot timeline
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The states of a registry over time, e.g. once a tick for a replay. Every keyframeInterval
+// frames a full snapshot is kept, the frames between are deltas against the last one, so any
+// frame loads from one keyframe and one delta.
+/////////////////////////////////////////////////////////////////////////////////////////////
+const int SNAPSHOT_TIMELINE_KEYFRAME_INTERVAL = 120;
+
+class SnapshotTimeline
+{
+private:
+    int keyframeInterval;
+    std::vector<Snapshot> keyframes;
+    // [frame] -> delta against its keyframe, empty for the keyframes themselves
+    std::vector<SnapshotDelta> deltas;
+    size_t numBytes = 0;
+
+public:
+    SnapshotTimeline(int keyframeInterval = SNAPSHOT_TIMELINE_KEYFRAME_INTERVAL): keyframeInterval(keyframeInterval) {}
+
+    bool AddFrame(const Registry& registry);
+    bool LoadFrame(int frame, Registry& registry) const;
+    void Clear();
+
+    int GetNumFrames() const { return deltas.size(); }
+    // Bytes of the keyframes and deltas
+    size_t GetSize() const { return numBytes; }
+};
+
+#endif
@@ -0,0 +1,48 @@
+#include "SnapshotSaver.h"
+#include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
+
+SnapshotSaver::~SnapshotSaver()
+{
+    Wait();
+}
+
+bool SnapshotSaver::Save(const Registry& registry, JobSystem& jobSystem, const std::string& filePath)
+{
+    if (IsWriting())
+    {
+        Logger::War("The last save is still being written, " + filePath + " not saved");
+        return false;
+    }
+    const int captureIndex = currentIndex == 0 ? 1 : 0;
+    {
+        PROFILE_SCOPE("SnapshotCapture");
+        if (!snapshots[captureIndex].Save(registry))
+        {
+            return false;
+        }
+    }
+    currentIndex = captureIndex;
+
+    // Only read by the job until it is done, the next capture goes into the other snapshot
+    const Snapshot* snapshot = &snapshots[captureIndex];
+    jobSystem.Schedule([this, snapshot, filePath]()
+    {
+        PROFILE_SCOPE("SnapshotWrite");
+        isWriteFailed.store(!snapshot->WriteFile(filePath));
+    }, &writing);
+    return true;
+}
+
+bool SnapshotSaver::Load(Registry& registry, const std::string& filePath)
+{
+    if (currentIndex < 0)
+    {
+        if (!snapshots[0].ReadFile(filePath))
+        {
+            return false;
+        }
+        currentIndex = 0;
+    }
+    return snapshots[currentIndex].Load(registry);
+}
@@ -0,0 +1,46 @@
+#ifndef SNAPSHOTSAVER_H
+#define SNAPSHOTSAVER_H
+
+#include "Snapshot.h"
+#include "../Jobs/JobSystem.h"
+#include <atomic>
+#include <string>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Snapshot saver
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Saves without stalling the frame: the registry is captured on the calling thread at a tick
+// boundary, which copies the dense pool data as it is into a buffer kept from the last save,
+// and a job writes the file on a worker meanwhile. Two buffers take turns, so a capture
+// never touches the snapshot a job is writing, and a failed capture leaves the last good one
+// in place for Load. A save while the previous one is still being written is skipped.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class SnapshotSaver
+{
+private:
+    Snapshot snapshots[2];
+    // The last snapshot captured whole, -1 before the first
+    int currentIndex = -1;
+    JobCounter writing;
+    std::atomic<bool> isWriteFailed{false};
+
+public:
+    SnapshotSaver() = default;
+    // Waits for the file being written
+    ~SnapshotSaver();
+
+    // Captures the registry, whose commands must all be applied, and writes it to the file in
+    // the background. False if nothing was captured.
+    bool Save(const Registry& registry, JobSystem& jobSystem, const std::string& filePath);
+    // Loads the last snapshot captured, or the file when none was
+    bool Load(Registry& registry, const std::string& filePath);
+
+    bool IsWriting() const { return !writing.IsDone(); }
+    // Of the last write that finished
+    bool HasWriteFailed() const { return isWriteFailed.load(); }
+    void Wait() { writing.Wait(); }
+    // Of the last snapshot captured, 0 before the first
+    size_t GetSize() const { return currentIndex >= 0 ? snapshots[currentIndex].GetSize() : 0; }
+};
+
+#endif
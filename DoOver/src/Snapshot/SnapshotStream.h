@@ -0,0 +1,155 @@
+#ifndef SNAPSHOTSTREAM_H
+#define SNAPSHOTSTREAM_H
+
+#include "../AssetStore/AssetHandle.h"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Snapshot streams
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The bytes of a snapshot, see Snapshot.h. Trivially copyable blocks (e.g. the dense data of
+// a pool) are copied as they are, the sparse values (ids, counts, signatures) are LEB128
+// varints so the small ones take a single byte. The reader never reads past the end of the
+// buffer, it fails instead and stays failed.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class SnapshotWriter
+{
+private:
+    std::vector<uint8_t>& buffer;
+
+public:
+    SnapshotWriter(std::vector<uint8_t>& buffer): buffer(buffer) {}
+
+    void WriteVarint(uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            buffer.push_back(static_cast<uint8_t>(value) | 0x80);
+            value >>= 7;
+        }
+        buffer.push_back(static_cast<uint8_t>(value));
+    }
+
+    // Zigzag encoded, so the small negative values stay short too
+    void WriteSignedVarint(int64_t value)
+    {
+        WriteVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+
+    void WriteBytes(const void* data, size_t size)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        buffer.insert(buffer.end(), bytes, bytes + size);
+    }
+
+    void WriteString(const std::string& value)
+    {
+        WriteVarint(value.size());
+        WriteBytes(value.data(), value.size());
+    }
+
+    size_t GetSize() const { return buffer.size(); }
+};
+
+class SnapshotReader
+{
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t position = 0;
+    bool hasFailed = false;
+
+public:
+    SnapshotReader(const uint8_t* data, size_t size): data(data), size(size) {}
+
+    uint64_t ReadVarint()
+    {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64 && position < size; shift += 7)
+        {
+            const uint8_t byte = data[position++];
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+            {
+                return value;
+            }
+        }
+        hasFailed = true;
+        return 0;
+    }
+
+    int64_t ReadSignedVarint()
+    {
+        const uint64_t value = ReadVarint();
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    bool ReadBytes(void* destination, size_t count)
+    {
+        if (hasFailed || count > size - position)
+        {
+            hasFailed = true;
+            return false;
+        }
+        std::memcpy(destination, data + position, count);
+        position += count;
+        return true;
+    }
+
+    std::string ReadString()
+    {
+        const uint64_t length = ReadVarint();
+        if (hasFailed || length > size - position)
+        {
+            hasFailed = true;
+            return "";
+        }
+        std::string value(reinterpret_cast<const char*>(data + position), length);
+        position += length;
+        return value;
+    }
+
+    // A count read from the snapshot, failing above the maximum so a corrupt snapshot can't
+    // make the loader allocate gigabytes
+    uint64_t ReadCount(uint64_t maxCount)
+    {
+        const uint64_t count = ReadVarint();
+        if (count > maxCount)
+        {
+            hasFailed = true;
+            return 0;
+        }
+        return count;
+    }
+
+    size_t GetNumRemainingBytes() const { return size - position; }
+    bool HasFailed() const { return hasFailed; }
+    void Fail() { hasFailed = true; }
+};
+
+// Maps the handles saved in a snapshot to the ones of the running game. The asset handles are
+// interned per process, so the snapshot carries the asset ids and they are resolved again.
+// Components are copied into the snapshots as they are, their asset and entity fields are
+// found by their reflection (see ECS/Reflection.h) and remapped on load.
+struct SnapshotRemap
+{
+    // [asset handle in the snapshot] -> asset handle in this process
+    std::vector<AssetHandle> assetHandles;
+    // Registry the entities are loaded into, encoded in their handles
+    int registryIndex = 0;
+
+    AssetHandle RemapAssetHandle(AssetHandle assetHandle) const
+    {
+        if (assetHandle < 0 || assetHandle >= static_cast<int>(assetHandles.size()))
+        {
+            return INVALID_ASSET_HANDLE;
+        }
+        return assetHandles[assetHandle];
+    }
+};
+
+#endif
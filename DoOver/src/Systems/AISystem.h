@@ -0,0 +1,210 @@
+#ifndef AISYSTEM_H
+#define AISYSTEM_H
+
+#include "../ECS/ECS.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/AIComponent.h"
+#include "../Components/PathFollowComponent.h"
+#include "../Components/ProjectileEmitterComponent.h"
+#include "../Components/DormantComponent.h"
+#include "../Components/SimulationLodComponent.h"
+#include "../Components/BoxColliderComponent.h"
+#include "../Resources/TickTimeResource.h"
+#include "../Physics/CollisionQueries.h"
+#include "../Jobs/JobSystem.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <string>
+
+// The entity the enemies go after
+const std::string AI_TARGET_TAG = "player";
+// Past its range times this, a target is lost, so it isn't lost and found again at the edge
+const float AI_RANGE_HYSTERESIS = 1.25f;
+// A chase asks for a new path once the target moved this far from the goal, in world pixels
+const float AI_REPATH_DISTANCE = 64.0f;
+// Closer to home than this the entity is back
+const float AI_HOME_RADIUS = 32.0f;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// AI system
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Steps the state machines of the enemies. Each enemy thinks at the think rate, not every
+// tick: the ticks take turns through the enemies, so a tick thinks for a slice of them and
+// the cost of the AI is spread evenly whatever the number of enemies. Between two thoughts
+// the entity keeps doing what it decided, the navigation system drives it to the goal it set
+// and its emitter keeps the aim. The slices only depend on the ticks, replays think alike.
+// An enemy only sees the target with no obstacle in between, the lines of sight of a slice
+// are cast together on the workers. An enemy at mid range only thinks on one of its turns
+// out of its tick divisor.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class AISystem: public System
+{
+private:
+    // Thoughts owed to the enemies, a fraction of one carries over to the next tick
+    double thinkBudget = 0.0;
+    // The next enemy to think
+    size_t nextEntity = 0;
+    int numThoughts = 0;
+    // The enemies thinking this tick and their line of sight to the target
+    std::vector<Entity> thinkers;
+    std::vector<RaycastQuery> sightQueries;
+    std::vector<RaycastResult> sightResults;
+    // [entity id] -> turns let go by an enemy at mid range since its last thought
+    std::vector<int> lodTurns;
+
+    bool TakeLodTurn(Entity entity)
+    {
+        if (entity.GetId() >= static_cast<int>(lodTurns.size()))
+        {
+            lodTurns.resize(entity.GetId() + 1);
+        }
+        int& turns = lodTurns[entity.GetId()];
+        if (++turns < entity.GetComponent<SimulationLodComponent>().tickDivisor)
+        {
+            return false;
+        }
+        turns = 0;
+        return true;
+    }
+
+    static void Think(Entity entity, bool hasTarget, glm::vec2 targetPosition, bool isVisible)
+    {
+        auto& ai = entity.GetComponent<AIComponent>();
+        const glm::vec2 position = entity.GetComponent<TransformComponent>().position;
+        const float distance = hasTarget ? glm::distance(position, targetPosition) : -1.0f;
+        const bool isInSight = hasTarget && isVisible && distance <= ai.sightRange;
+
+        switch (ai.state)
+        {
+        case AI_STATE_IDLE:
+        case AI_STATE_RETURN:
+            if (isInSight)
+            {
+                ai.state = AI_STATE_CHASE;
+            }
+            else if (ai.state == AI_STATE_RETURN && glm::distance(position, ai.home) <= AI_HOME_RADIUS)
+            {
+                ai.state = AI_STATE_IDLE;
+            }
+            break;
+        case AI_STATE_CHASE:
+            if (!hasTarget || distance > ai.sightRange * AI_RANGE_HYSTERESIS)
+            {
+                ai.state = AI_STATE_RETURN;
+            }
+            else if (isVisible && distance <= ai.attackRange)
+            {
+                ai.state = AI_STATE_ATTACK;
+            }
+            break;
+        case AI_STATE_ATTACK:
+            if (!hasTarget || !isVisible || distance > ai.attackRange * AI_RANGE_HYSTERESIS)
+            {
+                ai.state = AI_STATE_CHASE;
+            }
+            break;
+        }
+
+        if (entity.HasComponent<PathFollowComponent>())
+        {
+            auto& pathFollow = entity.GetComponent<PathFollowComponent>();
+            switch (ai.state)
+            {
+            case AI_STATE_CHASE:
+                if (glm::distance(pathFollow.goal, targetPosition) > AI_REPATH_DISTANCE)
+                {
+                    pathFollow.goal = targetPosition;
+                }
+                break;
+            case AI_STATE_ATTACK:
+                // Holds the ground it reached
+                if (glm::distance(pathFollow.goal, position) > AI_REPATH_DISTANCE)
+                {
+                    pathFollow.goal = position;
+                }
+                break;
+            default:
+                pathFollow.goal = ai.home;
+                break;
+            }
+        }
+        // The emitter keeps the speed of its projectiles, only their direction follows the target
+        if (ai.state == AI_STATE_ATTACK && entity.HasComponent<ProjectileEmitterComponent>() && distance > 0.0f)
+        {
+            auto& projectileEmitter = entity.GetComponent<ProjectileEmitterComponent>();
+            projectileEmitter.projectileVelocity = (targetPosition - position) / distance * glm::length(projectileEmitter.projectileVelocity);
+        }
+    }
+
+public:
+    AISystem()
+    {
+        RequireComponent<TransformComponent>();
+        RequireComponent<AIComponent>();
+        // Out of the action, the dormant enemies don't take a slice
+        ExcludeComponent<DormantComponent>();
+        ReadsComponent<TransformComponent>();
+        ReadsComponent<SimulationLodComponent>();
+        WritesComponent<AIComponent>();
+        WritesComponent<PathFollowComponent>();
+        WritesComponent<ProjectileEmitterComponent>();
+        ReadsResource<TickTimeResource>();
+    }
+
+    // thinkRate is per enemy per second, 0 or less thinks for every enemy every tick
+    void Update(const Registry& registry, const CollisionQueries& collisionQueries, JobSystem& jobSystem, float thinkRate)
+    {
+        const double deltaTime = registry.GetResource<TickTimeResource>().deltaTime;
+        const auto& entities = GetSystemEntities();
+        numThoughts = 0;
+        if (entities.empty())
+        {
+            thinkBudget = 0.0;
+            return;
+        }
+
+        int numToThink = entities.size();
+        if (thinkRate > 0.0f)
+        {
+            // Never more than a round, a long tick doesn't think twice for the same enemy
+            thinkBudget = std::min(thinkBudget + entities.size() * thinkRate * deltaTime, static_cast<double>(entities.size()));
+            numToThink = static_cast<int>(thinkBudget);
+            thinkBudget -= numToThink;
+        }
+
+        Entity target(0, 0, 0);
+        const bool hasTarget = registry.FindEntityByTag(AI_TARGET_TAG, target) && target.HasComponent<TransformComponent>();
+        const glm::vec2 targetPosition = hasTarget ? target.GetComponent<TransformComponent>().position : glm::vec2(0);
+        thinkers.clear();
+        sightQueries.clear();
+        for (int i = 0; i < numToThink; i++)
+        {
+            // The enemies removed since shift the rest, the turns go on from the same place
+            if (nextEntity >= entities.size())
+            {
+                nextEntity = 0;
+            }
+            const Entity entity = entities[nextEntity++];
+            if (entity.HasComponent<SimulationLodComponent>() && !TakeLodTurn(entity))
+            {
+                continue;
+            }
+            thinkers.push_back(entity);
+            sightQueries.push_back({entity.GetComponent<TransformComponent>().position, targetPosition, COLLISION_LAYER_OBSTACLE});
+        }
+        if (hasTarget)
+        {
+            collisionQueries.SegmentBatch(sightQueries, sightResults, jobSystem);
+        }
+        for (size_t i = 0; i < thinkers.size(); i++)
+        {
+            Think(thinkers[i], hasTarget, targetPosition, hasTarget && !sightResults[i].isHit);
+        }
+        numThoughts = thinkers.size();
+    }
+
+    // How many enemies thought in the last update
+    int GetNumThoughts() const { return numThoughts; }
+};
+
+#endif
@@ -0,0 +1,304 @@
+#ifndef ACTIVITYSYSTEM_H
+#define ACTIVITYSYSTEM_H
+
+#include "../ECS/ECS.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/SpriteComponent.h"
+#include "../Components/AnimationComponent.h"
+#include "../Components/ProjectileEmitterComponent.h"
+#include "../Components/AIComponent.h"
+#include "../Components/DormantComponent.h"
+#include "../Components/SimulationLodComponent.h"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Entities run at the full rate this far past the edges of the camera
+const int ACTIVITY_MARGIN = 512;
+// And at the reduced rate up to this far, past it they are frozen
+const int ACTIVITY_REDUCED_MARGIN = 1536;
+const int ACTIVITY_REDUCED_TICK_DIVISOR = 4;
+const int ACTIVITY_CELL_SIZE = 512;
+// Ticks over which every entity is put back in the cell of its position once, so the ones
+// that move follow along without all being looked at every tick
+const int ACTIVITY_REBIN_TICKS = 30;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Activity system
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Sets the simulation level of detail of the animated sprites, the projectile emitters and
+// the AI by their distance from the camera: they are binned in a coarse grid, and when the
+// camera moves into or out of a cell the whole cell changes tier at once. Near the camera
+// they run at the full rate, at mid range they are tagged with a SimulationLodComponent and
+// run on one tick out of ACTIVITY_REDUCED_TICK_DIVISOR, far away they are tagged with a
+// DormantComponent, which the systems exclude.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class ActivitySystem: public System
+{
+private:
+    struct CellRange
+    {
+        int minX = 0;
+        int minY = 0;
+        int maxX = -1;
+        int maxY = -1;
+
+        bool Contains(int x, int y) const { return x >= minX && x <= maxX && y >= minY && y <= maxY; }
+        bool operator==(const CellRange& other) const { return minX == other.minX && minY == other.minY && maxX == other.maxX && maxY == other.maxY; }
+    };
+
+    enum ActivityTier
+    {
+        ACTIVITY_TIER_FULL,
+        ACTIVITY_TIER_REDUCED,
+        ACTIVITY_TIER_FROZEN
+    };
+
+    struct ActivityRecord
+    {
+        int cellX = 0;
+        int cellY = 0;
+        // Position of the entity in its cell, -1 when the entity isn't binned
+        int indexInCell = -1;
+        ActivityTier tier = ACTIVITY_TIER_FULL;
+    };
+
+    // [cell key] -> entities whose position was last seen in the cell
+    std::unordered_map<uint64_t, std::vector<Entity>> cells;
+    // [entity id] -> where the entity is binned
+    std::vector<ActivityRecord> records;
+    std::vector<Entity> addedEntities;
+    CellRange fullCells;
+    // Holds the full rate cells
+    CellRange reducedCells;
+    int rebinCursor = 0;
+    int numDormantEntities = 0;
+    int numReducedEntities = 0;
+
+    static uint64_t GetCellKey(int cellX, int cellY)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(cellX)) << 32) | static_cast<uint32_t>(cellY);
+    }
+
+    static int GetCell(float position)
+    {
+        return static_cast<int>(std::floor(position / ACTIVITY_CELL_SIZE));
+    }
+
+    static CellRange GetCellRange(const SDL_Rect& camera, int margin)
+    {
+        CellRange range;
+        range.minX = GetCell(static_cast<float>(camera.x - margin));
+        range.minY = GetCell(static_cast<float>(camera.y - margin));
+        range.maxX = GetCell(static_cast<float>(camera.x + camera.w + margin));
+        range.maxY = GetCell(static_cast<float>(camera.y + camera.h + margin));
+        return range;
+    }
+
+    // Only what the tiers slow down is worth binning, the fixed sprites are always in view
+    static bool CanSleep(Entity entity)
+    {
+        if (!entity.HasComponent<AnimationComponent>() && !entity.HasComponent<ProjectileEmitterComponent>() && !entity.HasComponent<AIComponent>())
+        {
+            return false;
+        }
+        return !entity.HasComponent<SpriteComponent>() || !entity.GetComponent<SpriteComponent>().isFixed;
+    }
+
+    void InsertIntoCell(Entity entity, ActivityRecord& record, int cellX, int cellY)
+    {
+        auto& cell = cells[GetCellKey(cellX, cellY)];
+        record.cellX = cellX;
+        record.cellY = cellY;
+        record.indexInCell = static_cast<int>(cell.size());
+        cell.push_back(entity);
+    }
+
+    void RemoveFromCell(ActivityRecord& record)
+    {
+        auto cellIt = cells.find(GetCellKey(record.cellX, record.cellY));
+        auto& cell = cellIt->second;
+        const Entity last = cell.back();
+        cell[record.indexInCell] = last;
+        records[last.GetId()].indexInCell = record.indexInCell;
+        cell.pop_back();
+        if (cell.empty())
+        {
+            cells.erase(cellIt);
+        }
+        record.indexInCell = -1;
+    }
+
+    ActivityTier GetTier(int cellX, int cellY) const
+    {
+        if (fullCells.Contains(cellX, cellY))
+        {
+            return ACTIVITY_TIER_FULL;
+        }
+        return reducedCells.Contains(cellX, cellY) ? ACTIVITY_TIER_REDUCED : ACTIVITY_TIER_FROZEN;
+    }
+
+    // Trades the tag of the old tier for the one of the new tier
+    void SetTier(Entity entity, ActivityRecord& record, ActivityTier tier)
+    {
+        if (record.tier == tier)
+        {
+            return;
+        }
+        if (record.tier == ACTIVITY_TIER_FROZEN)
+        {
+            entity.RemoveComponent<DormantComponent>();
+            numDormantEntities--;
+        }
+        else if (record.tier == ACTIVITY_TIER_REDUCED)
+        {
+            entity.RemoveComponent<SimulationLodComponent>();
+            numReducedEntities--;
+        }
+        if (tier == ACTIVITY_TIER_FROZEN)
+        {
+            entity.AddComponent<DormantComponent>();
+            numDormantEntities++;
+        }
+        else if (tier == ACTIVITY_TIER_REDUCED)
+        {
+            entity.AddComponent<SimulationLodComponent>(ACTIVITY_REDUCED_TICK_DIVISOR, entity.GetId() % ACTIVITY_REDUCED_TICK_DIVISOR);
+            numReducedEntities++;
+        }
+        record.tier = tier;
+    }
+
+    // Every entity of the cells in the range
+    template <typename TFunc>
+    void ForEachEntityIn(const CellRange& range, TFunc func)
+    {
+        for (int cellY = range.minY; cellY <= range.maxY; cellY++)
+        {
+            for (int cellX = range.minX; cellX <= range.maxX; cellX++)
+            {
+                auto cell = cells.find(GetCellKey(cellX, cellY));
+                if (cell == cells.end())
+                {
+                    continue;
+                }
+                for (auto entity: cell->second)
+                {
+                    func(entity);
+                }
+            }
+        }
+    }
+
+public:
+    ActivitySystem()
+    {
+        RequireComponent<TransformComponent>();
+        // Tags and untags the entities
+        RunsExclusively();
+        RecordsCommands();
+    }
+
+    void OnEntityAdded(Entity entity) override
+    {
+        addedEntities.push_back(entity);
+    }
+
+    void OnEntityRemoved(Entity entity) override
+    {
+        const int entityId = entity.GetId();
+        if (entityId < static_cast<int>(records.size()) && records[entityId].indexInCell != -1)
+        {
+            auto& record = records[entityId];
+            RemoveFromCell(record);
+            numDormantEntities -= record.tier == ACTIVITY_TIER_FROZEN;
+            numReducedEntities -= record.tier == ACTIVITY_TIER_REDUCED;
+            record.tier = ACTIVITY_TIER_FULL;
+        }
+    }
+
+    void Update(const SDL_Rect& camera)
+    {
+        const CellRange cameraFullCells = GetCellRange(camera, ACTIVITY_MARGIN);
+        const CellRange cameraReducedCells = GetCellRange(camera, ACTIVITY_REDUCED_MARGIN);
+
+        // The camera moved to other cells: only the cells it reached or left behind can change
+        // tier, the ones past the reduced range stay frozen
+        if (!(cameraFullCells == fullCells) || !(cameraReducedCells == reducedCells))
+        {
+            const CellRange previousReducedCells = reducedCells;
+            fullCells = cameraFullCells;
+            reducedCells = cameraReducedCells;
+            auto updateTier = [this](Entity entity)
+            {
+                auto& record = records[entity.GetId()];
+                SetTier(entity, record, GetTier(record.cellX, record.cellY));
+            };
+            ForEachEntityIn(previousReducedCells, updateTier);
+            ForEachEntityIn(reducedCells, updateTier);
+        }
+
+        // The new entities start at their tags' tier and are moved to the one of their cell
+        for (auto entity: addedEntities)
+        {
+            if (!HasEntity(entity) || !entity.GetRegistry()->IsAlive(entity) || !CanSleep(entity))
+            {
+                continue;
+            }
+            if (entity.GetId() >= static_cast<int>(records.size()))
+            {
+                records.resize(entity.GetId() + 1);
+            }
+            auto& record = records[entity.GetId()];
+            if (record.indexInCell != -1)
+            {
+                continue;
+            }
+            const auto& position = entity.GetComponent<TransformComponent>().position;
+            InsertIntoCell(entity, record, GetCell(position.x), GetCell(position.y));
+            record.tier = entity.HasComponent<DormantComponent>() ? ACTIVITY_TIER_FROZEN : entity.HasComponent<SimulationLodComponent>() ? ACTIVITY_TIER_REDUCED : ACTIVITY_TIER_FULL;
+            numDormantEntities += record.tier == ACTIVITY_TIER_FROZEN;
+            numReducedEntities += record.tier == ACTIVITY_TIER_REDUCED;
+            SetTier(entity, record, GetTier(record.cellX, record.cellY));
+        }
+        addedEntities.clear();
+
+        // A slice of the entities is checked for having moved to another cell
+        const auto& entities = GetSystemEntities();
+        const int numEntities = static_cast<int>(entities.size());
+        const int numRebinned = std::min(numEntities, (numEntities + ACTIVITY_REBIN_TICKS - 1) / ACTIVITY_REBIN_TICKS);
+        for (int i = 0; i < numRebinned; i++)
+        {
+            rebinCursor = rebinCursor < numEntities ? rebinCursor : 0;
+            const Entity entity = entities[rebinCursor++];
+            if (entity.GetId() >= static_cast<int>(records.size()) || records[entity.GetId()].indexInCell == -1)
+            {
+                continue;
+            }
+            auto& record = records[entity.GetId()];
+            const auto& position = entity.GetComponent<TransformComponent>().position;
+            const int cellX = GetCell(position.x);
+            const int cellY = GetCell(position.y);
+            if (cellX != record.cellX || cellY != record.cellY)
+            {
+                RemoveFromCell(record);
+                InsertIntoCell(entity, record, cellX, cellY);
+                SetTier(entity, record, GetTier(cellX, cellY));
+            }
+        }
+    }
+
+    int GetNumDormantEntities() const
+    {
+        return numDormantEntities;
+    }
+
+    int GetNumReducedEntities() const
+    {
+        return numReducedEntities;
+    }
+};
+
+#endif
@@ -2,30 +2,147 @@
 #define ANIMATIONSYSTEM_H
 
 #include "../ECS/ECS.h"
+#include "../EventBus/EventBus.h"
 #include "../Components/SpriteComponent.h"
 #include "../Components/AnimationComponent.h"
-#include <SDL2/SDL.h>
+#include "../Components/DormantComponent.h"
+#include "../Components/SimulationLodComponent.h"
+#include "../Components/DirectionalSpriteComponent.h"
+#include "../Events/AnimationMarkerEvent.h"
+#include "../Animation/AnimationClip.h"
+#include "../Clock/FrameClock.h"
+#include <cmath>
+#include <vector>
 
 class AnimationSystem: public System
 {
+private:
+    AnimationLibrary animationLibrary;
+    // Animations added since the last update, they are started there
+    std::vector<Entity> addedEntities;
+
+    // Moves the animation forward, returns whether it changed frame
+    static bool Step(Entity entity, AnimationComponent& animation, const AnimationClip& clip, uint64_t elapsedMicrosecs, EventBus* eventBus)
+    {
+        const int numFrames = static_cast<int>(clip.frames.size());
+        // The clip may have been replaced by a shorter one
+        int frame = animation.currentFrame < numFrames ? animation.currentFrame : 0;
+        uint64_t frameMicrosecs = animation.frameMicrosecs + elapsedMicrosecs;
+        // Whole laps of a looping clip change nothing
+        if (clip.isLoop && frameMicrosecs >= clip.durationMicrosecs)
+        {
+            frameMicrosecs %= clip.durationMicrosecs;
+        }
+        while (frameMicrosecs >= clip.frames[frame].durationMicrosecs)
+        {
+            if (frame + 1 == numFrames && !clip.isLoop)
+            {
+                // A clip that doesn't loop holds its last frame
+                frameMicrosecs = 0;
+                break;
+            }
+            frameMicrosecs -= clip.frames[frame].durationMicrosecs;
+            frame = frame + 1 < numFrames ? frame + 1 : 0;
+            if (eventBus && clip.frames[frame].marker != NO_ANIMATION_MARKER)
+            {
+                eventBus->QueueEvent<AnimationMarkerEvent>(entity, animation.clip, frame, clip.frames[frame].marker);
+            }
+        }
+        animation.frameMicrosecs = static_cast<uint32_t>(frameMicrosecs);
+        const bool hasFrameChanged = frame != animation.currentFrame;
+        animation.currentFrame = frame;
+        return hasFrameChanged;
+    }
+
+    // The frames of a directional sprite are in its first row, it shows them in the row of
+    // its direction
+    static SDL_Rect GetFrameRect(Entity entity, const SpriteComponent& sprite, const SDL_Rect& frame)
+    {
+        SDL_Rect srcRect = frame;
+        if (entity.HasComponent<DirectionalSpriteComponent>())
+        {
+            srcRect.y += sprite.height * entity.GetComponent<DirectionalSpriteComponent>().direction;
+        }
+        return srcRect;
+    }
+
 public:
     AnimationSystem()
     {
         RequireComponent<SpriteComponent>();
         RequireComponent<AnimationComponent>();
+        // Far from the camera nobody sees the frames change, they catch up on waking
+        ExcludeComponent<DormantComponent>();
+        ReadsComponent<DirectionalSpriteComponent>();
+        ReadsComponent<SimulationLodComponent>();
+        WritesComponent<SpriteComponent>();
+        WritesComponent<AnimationComponent>();
+    }
+
+    void OnEntityAdded(Entity entity) override
+    {
+        addedEntities.push_back(entity);
     }
 
-    void Update()
+    // The clips are added before the entities playing them
+    AnimationLibrary& GetAnimationLibrary()
     {
-        for (auto entity: GetSystemEntities())
+        return animationLibrary;
+    }
+
+    // Each animation moves by the fixed tick step and only writes the sprite when its frame
+    // changes, the marker events are queued for the end of the tick
+    void Update(const FrameClock& frameClock, std::unique_ptr<JobSystem>& jobSystem, std::unique_ptr<EventBus>& eventBus)
+    {
+        const double millisecs = frameClock.GetMillisecs();
+        for (auto entity: addedEntities)
         {
-            auto& sprite = entity.GetComponent<SpriteComponent>();
+            if (!HasEntity(entity) || !entity.GetRegistry()->IsAlive(entity))
+            {
+                continue;
+            }
+            auto& sprite = entity.PatchComponent<SpriteComponent>();
             auto& animation = entity.GetComponent<AnimationComponent>();
-
-            animation.currentFrame = static_cast<int>((SDL_GetTicks() - animation.startTime) * animation.frameSpeedRate / 1000.0) % animation.numFrames;
-            sprite.srcRect.x = animation.currentFrame * sprite.width;
+            if (animation.clip < 0 || animation.clip >= animationLibrary.GetNumClips())
+            {
+                const int firstRow = entity.HasComponent<DirectionalSpriteComponent>() ? 0 : sprite.srcRect.y;
+                animation.clip = animationLibrary.GetStripClip(animation.numFrames, animation.frameSpeedRate, animation.isLoop, {0, firstRow, sprite.width, sprite.height});
+            }
+            // Catch up with the start time, which may be in the past
+            const AnimationClip& clip = animationLibrary.GetClip(animation.clip);
+            animation.currentFrame = 0;
+            animation.frameMicrosecs = 0;
+            Step(entity, animation, clip, static_cast<uint64_t>(std::max(0.0, (millisecs - animation.startTime) * 1000.0)), nullptr);
+            sprite.srcRect = GetFrameRect(entity, sprite, clip.frames[animation.currentFrame].srcRect);
         }
+        addedEntities.clear();
+
+        const uint64_t elapsedMicrosecs = std::llround(frameClock.GetDeltaTime() * 1000000.0);
+        const uint32_t tick = frameClock.GetTick();
+        EventBus* bus = eventBus.get();
+        const AnimationLibrary& library = animationLibrary;
+        ParallelEach(*jobSystem, [elapsedMicrosecs, tick, bus, &library](Entity entity)
+        {
+            // At mid range an animation steps over the ticks it skipped at once
+            uint64_t entityElapsedMicrosecs = elapsedMicrosecs;
+            if (entity.HasComponent<SimulationLodComponent>())
+            {
+                const auto& lod = entity.GetComponent<SimulationLodComponent>();
+                if (!lod.IsTickDue(tick))
+                {
+                    return;
+                }
+                entityElapsedMicrosecs *= lod.tickDivisor;
+            }
+            auto& animation = entity.GetComponent<AnimationComponent>();
+            const AnimationClip& clip = library.GetClip(animation.clip);
+            if (Step(entity, animation, clip, entityElapsedMicrosecs, bus))
+            {
+                auto& sprite = entity.PatchComponent<SpriteComponent>();
+                sprite.srcRect = GetFrameRect(entity, sprite, clip.frames[animation.currentFrame].srcRect);
+            }
+        });
     }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -4,7 +4,12 @@
 #include "../ECS/ECS.h"
 #include "../Components/CameraFollowComponent.h"
 #include "../Components/TransformComponent.h"
+#include "../Renderer/Viewport.h"
+#include "../Resources/MapBoundsResource.h"
 #include <SDL2/SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 class CameraMovementSystem: public System
 {
@@ -13,28 +18,75 @@ public:
     {
         RequireComponent<CameraFollowComponent>();
         RequireComponent<TransformComponent>();
+        ReadsComponent<CameraFollowComponent>();
+        ReadsComponent<TransformComponent>();
+        ReadsResource<MapBoundsResource>();
     }
 
-    void Update(SDL_Rect& camera)
+    // Follows the interpolated position, so the cameras stay in sync with the rendered sprites.
+    // Each viewport follows a single entity, the first one given the component for it, and
+    // eases towards it over the deltaTime seconds of the frame. The cameras stay inside the
+    // MapBoundsResource of the registry, when it has one.
+    void Update(const Registry& registry, std::vector<Viewport>& viewports, double interpolation = 1.0, double deltaTime = 0.0)
     {
-        for (auto entity: GetSystemEntities())
+        const MapBoundsResource mapBounds = registry.HasResource<MapBoundsResource>() ? registry.GetResource<MapBoundsResource>() : MapBoundsResource();
+        for (size_t i = 0; i < viewports.size(); i++)
         {
-            auto transform = entity.GetComponent<TransformComponent>();
+            Viewport& viewport = viewports[i];
+            // The zoomed camera keeps its center
+            const float width = viewport.screenRect.w / viewport.zoom;
+            const float height = viewport.screenRect.h / viewport.zoom;
+            viewport.camera.x += (viewport.camera.w - width) / 2;
+            viewport.camera.y += (viewport.camera.h - height) / 2;
+            viewport.camera.w = width;
+            viewport.camera.h = height;
 
-            if (transform.position.x + (camera.w / 2) < Game::mapWidth) 
+            for (auto entity: GetSystemEntities())
             {
-                camera.x = transform.position.x - (Game::windowWidth / 2);
+                if (entity.GetComponent<CameraFollowComponent>().viewportIndex == static_cast<int>(i))
+                {
+                    Follow(entity, viewport, interpolation, deltaTime);
+                    break;
+                }
             }
-            if (transform.position.y + (camera.h / 2) < Game::mapHeight) 
-            {
-                camera.y = transform.position.y - (Game::windowHeight / 2);
-            }
-            // Keep camera rectangle view inside the screen limits
-            camera.x = camera.x < 0 ? 0 : camera.x;
-            camera.y = camera.y < 0 ? 0 : camera.y;
-            camera.x = (camera.x + camera.w > Game::mapWidth) ? Game::mapWidth - camera.w : camera.x;
-            camera.y = (camera.y + camera.h > Game::mapHeight) ? Game::mapHeight - camera.h : camera.y;
+            Clamp(viewport.camera, mapBounds);
+        }
+    }
+
+    static void Follow(Entity entity, Viewport& viewport, double interpolation, double deltaTime)
+    {
+        const auto& transform = entity.GetComponent<TransformComponent>();
+        const float damping = entity.GetComponent<CameraFollowComponent>().damping;
+        const glm::vec2 position = glm::mix(transform.previousPosition, transform.position, static_cast<float>(interpolation));
+        SDL_FRect& camera = viewport.camera;
+
+        const float targetX = position.x - camera.w / 2;
+        const float targetY = position.y - camera.h / 2;
+        // The first frame on the entity snaps, the camera doesn't glide in from the corner of the map
+        if (damping <= 0.0f || !viewport.isFollowing)
+        {
+            camera.x = targetX;
+            camera.y = targetY;
+            viewport.isFollowing = true;
+            return;
+        }
+        // Framerate independent, the same part of the gap is left after a second at any frame rate
+        const float blend = 1.0f - std::exp(-damping * static_cast<float>(deltaTime));
+        camera.x += (targetX - camera.x) * blend;
+        camera.y += (targetY - camera.y) * blend;
+    }
+
+    // Keeps the camera inside the map, centered on a map smaller than the view
+    static void Clamp(SDL_FRect& camera, const MapBoundsResource& mapBounds)
+    {
+        if (mapBounds.width <= 0 || mapBounds.height <= 0)
+        {
+            return;
         }
+        const float mapWidth = mapBounds.width;
+        const float mapHeight = mapBounds.height;
+        camera.x = camera.w >= mapWidth ? (mapWidth - camera.w) / 2 : std::max(0.0f, std::min(camera.x, mapWidth - camera.w));
+        camera.y = camera.h >= mapHeight ? (mapHeight - camera.h) / 2 : std::max(0.0f, std::min(camera.y, mapHeight - camera.h));
     }
 };
 
@@ -0,0 +1,105 @@
+#ifndef COLLISIONRESPONSESYSTEM_H
+#define COLLISIONRESPONSESYSTEM_H
+
+#include "../ECS/ECS.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/BoxColliderComponent.h"
+#include "../Components/ProjectileComponent.h"
+#include "../Physics/AABB.h"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Collision response system
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Pushes the solid bodies out of each other, from the pairs the collision system found this
+// tick. A pair is separated along the axis it overlaps the least, the static collider stays
+// where it is and two moving ones go half the way each. Each push is measured from where the
+// pushes before it left the boxes. The triggers and the projectiles are only reported.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class CollisionResponseSystem: public System
+{
+private:
+    int numSeparations = 0;
+
+    static bool IsSolid(Entity entity)
+    {
+        const auto& collider = entity.GetComponent<BoxColliderComponent>();
+        return collider.layer != 0 && !collider.isTrigger && !entity.HasComponent<ProjectileComponent>();
+    }
+
+    static AABB GetBox(Entity entity)
+    {
+        const auto& transform = entity.GetComponent<TransformComponent>();
+        const auto& collider = entity.GetComponent<BoxColliderComponent>();
+        const float x = transform.position.x + collider.offset.x;
+        const float y = transform.position.y + collider.offset.y;
+        return AABB(x, y, x + collider.width, y + collider.height);
+    }
+
+    static void Push(Entity entity, glm::vec2 offset)
+    {
+        if (offset != glm::vec2(0))
+        {
+            entity.PatchComponent<TransformComponent>().position += offset;
+        }
+    }
+
+public:
+    CollisionResponseSystem()
+    {
+        RequireComponent<TransformComponent>();
+        RequireComponent<BoxColliderComponent>();
+        ReadsComponent<BoxColliderComponent>();
+        ReadsComponent<ProjectileComponent>();
+        WritesComponent<TransformComponent>();
+    }
+
+    void Update(const std::vector<std::pair<Entity, Entity>>& collisions)
+    {
+        numSeparations = 0;
+        for (const auto& [a, b]: collisions)
+        {
+            if (!a.GetRegistry()->IsAlive(a) || !b.GetRegistry()->IsAlive(b) || !IsSolid(a) || !IsSolid(b))
+            {
+                continue;
+            }
+            const bool isAStatic = a.GetComponent<BoxColliderComponent>().isStatic;
+            const bool isBStatic = b.GetComponent<BoxColliderComponent>().isStatic;
+            if (isAStatic && isBStatic)
+            {
+                continue;
+            }
+            const AABB boxA = GetBox(a);
+            const AABB boxB = GetBox(b);
+            const float overlapX = std::min(boxA.maxX, boxB.maxX) - std::max(boxA.minX, boxB.minX);
+            const float overlapY = std::min(boxA.maxY, boxB.maxY) - std::max(boxA.minY, boxB.minY);
+            // Apart already, e.g. pushed out by an earlier pair
+            if (overlapX <= 0.0f || overlapY <= 0.0f)
+            {
+                continue;
+            }
+
+            // From a to b, along the axis of the smallest overlap
+            glm::vec2 separation(0);
+            if (overlapX < overlapY)
+            {
+                separation.x = (boxA.minX + boxA.maxX < boxB.minX + boxB.maxX) ? overlapX : -overlapX;
+            }
+            else
+            {
+                separation.y = (boxA.minY + boxA.maxY < boxB.minY + boxB.maxY) ? overlapY : -overlapY;
+            }
+            const float shareOfA = isAStatic ? 0.0f : (isBStatic ? 1.0f : 0.5f);
+            Push(a, -separation * shareOfA);
+            Push(b, separation * (1.0f - shareOfA));
+            numSeparations++;
+        }
+    }
+
+    // Of the last update
+    int GetNumSeparations() const { return numSeparations; }
+};
+
+#endif
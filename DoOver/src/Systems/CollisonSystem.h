@@ -3,72 +3,540 @@
 
 #include "../ECS/ECS.h"
 #include "../EventBus/EventBus.h"
-#include "../Events/CollisionEvent.h"
+#include "../Events/CollisionEnterEvent.h"
+#include "../Events/CollisionStayEvent.h"
+#include "../Events/CollisionExitEvent.h"
+#include "../Trace/EventTrace.h"
 #include "../Components/TransformComponent.h"
 #include "../Components/BoxColliderComponent.h"
+#include "../Components/SleepingComponent.h"
+#include "../Physics/SpatialHashGrid.h"
+#include "../Physics/SweepAndPrune.h"
+#include "../Physics/AABBPairBatch.h"
+#include "../Physics/StaticColliderGrid.h"
+#include "../Physics/CollisionPairCache.h"
+#include "../Physics/CollisionQueries.h"
+#include "../Physics/BroadphaseTuner.h"
+#include <algorithm>
 
 class CollisionSystem: public System
 {
+private:
+    BroadphaseMode broadphaseMode;
+    // Of the spatial hash
+    int cellSize = DEFAULT_CELL_SIZE;
+    std::unique_ptr<IBroadphase> broadphase;
+    // Picks the mode and cell size from the boxes seen at runtime, when asked to. A change it
+    // wants is made at the start of the next update, so the queries between two updates
+    // always have a filled broadphase.
+    BroadphaseTuner tuner;
+    bool isAutoTuning = false;
+    bool hasRetune = false;
+    BroadphaseMode retuneMode = BROADPHASE_SPATIAL_HASH;
+    int retuneCellSize = DEFAULT_CELL_SIZE;
+    std::vector<std::pair<Entity, Entity>> candidatePairs;
+    std::vector<std::pair<Entity, Entity>> collisions;
+
+    // Events are only emitted when a contact starts or ends, stay events are opt-in
+    CollisionPairCache pairCache;
+    std::vector<std::pair<Entity, Entity>> enteredCollisions;
+    std::vector<std::pair<Entity, Entity>> stayedCollisions;
+    std::vector<std::pair<Entity, Entity>> exitedCollisions;
+    bool isEmittingStayEvents = false;
+    // The pairs are sorted by entity ids, whatever order the broadphase and the cache found them in
+    bool isOrdered = false;
+
+    static bool IsPairBefore(const std::pair<Entity, Entity>& a, const std::pair<Entity, Entity>& b)
+    {
+        return a.first.GetId() != b.first.GetId() ? a.first.GetId() < b.first.GetId() : a.second.GetId() < b.second.GetId();
+    }
+
+    // Boxes of a dynamic entity on the last two frames, the continuous ones are swept between them
+    struct ColliderBoxes
+    {
+        AABB previous;
+        AABB current;
+        bool hasPrevious = false;
+        bool isContinuous = false;
+        // Its box is kept in the broadphase as it was, without an update every frame
+        bool isSleeping = false;
+    };
+
+    // [entity id] -> boxes of the entity
+    std::vector<ColliderBoxes> boxes;
+    AABBPairBatch narrowphase;
+    std::vector<int> narrowphasePairIndices;
+    std::vector<int> overlapIndices;
+
+    // Only the dynamic colliders go through the per-frame broadphase, the static ones are
+    // queried from a grid rebuilt when a static collider joins or leaves the system
+    std::vector<Entity> dynamicEntities;
+    std::vector<int> entityIdToDynamicIndex;
+    StaticColliderGrid staticColliders;
+    bool areStaticCollidersDirty = false;
+    std::vector<int> staticIndices;
+
+    // The commit of the component changes gone through last
+    uint32_t changeVersion = 0;
+    std::vector<Entity> changedEntities;
+
+    // A static collider that moved or changed shape puts the grid out of date, a sleeping one
+    // is woken up. Only the colliders changed since the last update are looked at.
+    void ApplyChanges(const Registry& registry)
+    {
+        changedEntities.clear();
+        const bool hasTransformChanges = registry.GetChangedEntities<TransformComponent>(changeVersion, changedEntities);
+        const bool hasColliderChanges = registry.GetChangedEntities<BoxColliderComponent>(changeVersion, changedEntities);
+        changeVersion = registry.GetChangeVersion();
+        if (!hasTransformChanges || !hasColliderChanges)
+        {
+            areStaticCollidersDirty = true;
+            for (auto entity: dynamicEntities)
+            {
+                WakeEntity(entity);
+            }
+            return;
+        }
+        for (auto entity: changedEntities)
+        {
+            if (!HasEntity(entity) || !registry.IsAlive(entity))
+            {
+                continue;
+            }
+            if (entity.GetComponent<BoxColliderComponent>().isStatic)
+            {
+                areStaticCollidersDirty = true;
+            }
+            else
+            {
+                WakeEntity(entity);
+            }
+        }
+    }
+
+    bool IsDynamic(Entity entity) const
+    {
+        const int entityId = entity.GetId();
+        return entityId < static_cast<int>(entityIdToDynamicIndex.size()) && entityIdToDynamicIndex[entityId] != -1;
+    }
+
+    bool IsSleeping(Entity entity) const
+    {
+        return IsDynamic(entity) && boxes[entity.GetId()].isSleeping;
+    }
+
+    void SetSleeping(Entity entity, bool isSleeping)
+    {
+        boxes[entity.GetId()].isSleeping = isSleeping;
+        broadphase->SetSleeping(entity, isSleeping);
+    }
+
+    // Updated from this frame on, its tag goes with the next Registry::Update
+    void WakeEntity(Entity entity)
+    {
+        if (IsSleeping(entity))
+        {
+            SetSleeping(entity, false);
+            entity.RemoveComponent<SleepingComponent>();
+        }
+    }
+
+    void RebuildStaticColliders()
+    {
+        std::vector<StaticCollider> colliders;
+        for (auto entity: GetSystemEntities())
+        {
+            const auto& collider = entity.GetComponent<BoxColliderComponent>();
+            if (collider.isStatic)
+            {
+                colliders.push_back({entity, GetBox(entity), collider.layer, collider.mask});
+            }
+        }
+        staticColliders.Build(std::move(colliders));
+        areStaticCollidersDirty = false;
+        // The network clients rebuild it with every snapshot they load
+        LOGGER_DEBUG("Static colliders rebuilt with {} entities", staticColliders.GetSize());
+    }
+
+    static AABB GetBox(Entity entity)
+    {
+        return GetBox(entity.GetComponent<TransformComponent>(), entity.GetComponent<BoxColliderComponent>());
+    }
+
+    static AABB GetBox(const TransformComponent& transform, const BoxColliderComponent& collider)
+    {
+        const float x = transform.position.x + collider.offset.x;
+        const float y = transform.position.y + collider.offset.y;
+        return AABB(x, y, x + collider.width, y + collider.height);
+    }
+
 public:
     CollisionSystem()
     {
         RequireComponent<TransformComponent>();
         RequireComponent<BoxColliderComponent>();
+        // Collision events run the damage handlers, which kill entities
+        RunsExclusively();
+
+        SetBroadphaseMode(BROADPHASE_SPATIAL_HASH);
     }
 
-    void Update(std::unique_ptr<EventBus>& eventBus)
+    // The grid suits boxes of similar sizes, sweep and prune handles widely varying sizes better
+    void SetBroadphaseMode(BroadphaseMode mode)
     {
-        auto entities = GetSystemEntities();
-        // Loop all the entities that the system is interested in
-        for (auto i = entities.begin(); i != entities.end(); i++)
+        broadphaseMode = mode;
+        // The sleeping boxes go into the new broadphase on the next update, the others are
+        // updated anyway and keep the box they sweep from
+        for (auto& entityBoxes: boxes)
+        {
+            if (entityBoxes.isSleeping)
+            {
+                entityBoxes.hasPrevious = false;
+            }
+        }
+        if (mode == BROADPHASE_SWEEP_AND_PRUNE)
+        {
+            broadphase = std::make_unique<SweepAndPrune>();
+        }
+        else
         {
-            Entity a = *i;
-            auto aTransform = a.GetComponent<TransformComponent>();
-            auto aCollider = a.GetComponent<BoxColliderComponent>();
+            broadphase = std::make_unique<SpatialHashGrid>(cellSize);
+        }
+    }
+
+    // Of the grid, about the size of the common boxes, before the first update
+    void SetBroadphaseCellSize(int cellSize)
+    {
+        this->cellSize = cellSize;
+        SetBroadphaseMode(broadphaseMode);
+    }
+
+    BroadphaseMode GetBroadphaseMode() const
+    {
+        return broadphaseMode;
+    }
+
+    int GetBroadphaseCellSize() const
+    {
+        return cellSize;
+    }
 
-            // Loop all the entities that still need to be checked (to the right of i)
-            for (auto j = i; j != entities.end(); j++)
+    // Let the BroadphaseTuner change the mode and cell size set above as the boxes change
+    void SetAutoTuneBroadphase(bool isAutoTuning)
+    {
+        this->isAutoTuning = isAutoTuning;
+        hasRetune = false;
+    }
+
+    // As of the tuner's last look, updated while auto tuning only
+    const BroadphaseStats& GetBroadphaseStats() const
+    {
+        return tuner.GetStats();
+    }
+
+    const IBroadphase& GetBroadphase() const
+    {
+        return *broadphase;
+    }
+
+    // For the queries of what isn't an entity, e.g. the particles
+    const StaticColliderGrid& GetStaticColliders() const
+    {
+        return staticColliders;
+    }
+
+    // The raycasts and overlaps of gameplay and AI, against the colliders as of the last update
+    CollisionQueries GetQueries() const
+    {
+        return CollisionQueries(*broadphase, staticColliders);
+    }
+
+    // Emit a CollisionStayEvent on every frame a contact lasts
+    void SetEmitStayEvents(bool isEmittingStayEvents)
+    {
+        this->isEmittingStayEvents = isEmittingStayEvents;
+    }
+
+    // Finds and reports the collisions in the same order on every run, for the deterministic mode
+    void SetOrdered(bool isOrdered)
+    {
+        this->isOrdered = isOrdered;
+    }
+
+    void OnEntityAdded(Entity entity) override
+    {
+        if (entity.GetComponent<BoxColliderComponent>().isStatic)
+        {
+            areStaticCollidersDirty = true;
+            return;
+        }
+        if (entity.GetId() >= static_cast<int>(entityIdToDynamicIndex.size()))
+        {
+            entityIdToDynamicIndex.resize(entity.GetId() + 1, -1);
+            boxes.resize(entity.GetId() + 1);
+        }
+        boxes[entity.GetId()].hasPrevious = false;
+        boxes[entity.GetId()].isSleeping = entity.HasComponent<SleepingComponent>();
+        entityIdToDynamicIndex[entity.GetId()] = dynamicEntities.size();
+        dynamicEntities.push_back(entity);
+    }
+
+    void OnEntityRemoved(Entity entity) override
+    {
+        const int entityId = entity.GetId();
+        if (entityId >= static_cast<int>(entityIdToDynamicIndex.size()) || entityIdToDynamicIndex[entityId] == -1)
+        {
+            areStaticCollidersDirty = true;
+            return;
+        }
+        // The broadphase only drops by itself the boxes it no longer gets
+        if (boxes[entityId].isSleeping)
+        {
+            boxes[entityId].isSleeping = false;
+            broadphase->Remove(entity);
+        }
+        const int index = entityIdToDynamicIndex[entityId];
+        const Entity last = dynamicEntities.back();
+        dynamicEntities[index] = last;
+        entityIdToDynamicIndex[last.GetId()] = index;
+        dynamicEntities.pop_back();
+        entityIdToDynamicIndex[entityId] = -1;
+    }
+
+    // The bodies the MovementSystem puts to sleep keep their boxes in the broadphase, until
+    // they wake up
+    void ObserveSleepingBodies(Registry& registry)
+    {
+        registry.ObserveComponent<SleepingComponent>([this](const std::vector<Entity>& entities)
+        {
+            for (auto entity: entities)
+            {
+                if (HasEntity(entity) && IsDynamic(entity) && !IsSleeping(entity))
+                {
+                    SetSleeping(entity, true);
+                }
+            }
+        },
+        [this](const std::vector<Entity>& entities)
+        {
+            for (auto entity: entities)
+            {
+                // A killed entity leaves the system right after
+                if (HasEntity(entity) && IsSleeping(entity))
+                {
+                    SetSleeping(entity, false);
+                }
+            }
+        });
+    }
+
+    // Brings the grid of the static colliders up to date, for the queries between the updates
+    void UpdateStaticColliders(const Registry& registry)
+    {
+        ApplyChanges(registry);
+        if (areStaticCollidersDirty)
+        {
+            RebuildStaticColliders();
+        }
+    }
+
+    // The colliders the entity overlaps where everything is now, without the broadphase and
+    // without any event. The client side prediction re-runs the collisions of its own
+    // entities only, the static grid must be up to date (see UpdateStaticColliders).
+    void FindCollisions(Entity entity, std::vector<Entity>& others)
+    {
+        const auto& collider = entity.GetComponent<BoxColliderComponent>();
+        if (collider.layer == 0)
+        {
+            return;
+        }
+        const AABB box = GetBox(entity);
+        staticIndices.clear();
+        staticColliders.Query(box, collider.layer, collider.mask, staticIndices);
+        for (auto index: staticIndices)
+        {
+            others.push_back(staticColliders.GetCollider(index).entity);
+        }
+        for (auto other: dynamicEntities)
+        {
+            const auto& otherCollider = other.GetComponent<BoxColliderComponent>();
+            if (other != entity && (collider.layer & otherCollider.mask) && (otherCollider.layer & collider.mask) && box.Overlaps(GetBox(other)))
+            {
+                others.push_back(other);
+            }
+        }
+    }
+
+    void Update(Registry& registry, std::unique_ptr<EventBus>& eventBus)
+    {
+        UpdateStaticColliders(registry);
+
+        if (hasRetune)
+        {
+            hasRetune = false;
+            LOGGER_INFO("Broadphase retuned to {} with {}px cells", retuneMode == BROADPHASE_SWEEP_AND_PRUNE ? "sweep and prune" : "the spatial hash", retuneCellSize);
+            cellSize = retuneCellSize;
+            SetBroadphaseMode(retuneMode);
+        }
+        const bool isSampling = isAutoTuning && tuner.BeginFrame(broadphaseMode, cellSize);
+
+        // Refresh the dynamic boxes in the broadphase, it drops the entities that left the system.
+        // The transforms and colliders are read side by side when a group owns them, see Game::Setup.
+        broadphase->BeginFrame();
+        registry.View<TransformComponent, BoxColliderComponent>().Each([this, isSampling](Entity entity, const TransformComponent& transform, const BoxColliderComponent& collider)
+        {
+            // Static, or not matched by the system yet
+            const int entityId = entity.GetId();
+            if (entityId >= static_cast<int>(entityIdToDynamicIndex.size()) || entityIdToDynamicIndex[entityId] == -1)
+            {
+                return;
+            }
+            auto& entityBoxes = boxes[entityId];
+            // Nothing moved it since it fell asleep, the broadphase still has its box
+            if (entityBoxes.isSleeping && entityBoxes.hasPrevious)
+            {
+                return;
+            }
+            // A collider on no layer is switched off (e.g. a parked pooled entity), it is swept
+            // from where it is once it gets a layer again
+            if (collider.layer == 0)
+            {
+                entityBoxes.hasPrevious = false;
+                return;
+            }
+            entityBoxes.current = GetBox(transform, collider);
+            entityBoxes.previous = entityBoxes.hasPrevious ? entityBoxes.previous : entityBoxes.current;
+            entityBoxes.hasPrevious = true;
+            entityBoxes.isContinuous = collider.isContinuous;
+
+            // Continuous colliders take the whole area they swept this frame into the broadphase
+            const AABB box = collider.isContinuous ? Union(entityBoxes.previous, entityBoxes.current) : entityBoxes.current;
+            broadphase->Update(entity, box, collider.layer, collider.mask);
+            if (isSampling)
+            {
+                tuner.SampleBox(entityBoxes.current);
+            }
+            if (entityBoxes.isSleeping)
             {
-                Entity b = *j;
+                broadphase->SetSleeping(entity, true);
+            }
+        });
+        broadphase->EndFrame();
+
+        // Only the candidate pairs go to the narrowphase, tested in batches
+        candidatePairs.clear();
+        broadphase->QueryPairs(candidatePairs);
 
-                // Bypass if we are trying to test the same entity
-                if (a == b)
+        collisions.clear();
+        narrowphase.Clear();
+        narrowphase.Reserve(candidatePairs.size());
+        narrowphasePairIndices.clear();
+        for (int i = 0; i < static_cast<int>(candidatePairs.size()); i++)
+        {
+            const auto& a = boxes[candidatePairs[i].first.GetId()];
+            const auto& b = boxes[candidatePairs[i].second.GetId()];
+            if (a.isContinuous || b.isContinuous)
+            {
+                float timeOfImpact;
+                if (SweepAABB(a.previous, a.current, b.previous, b.current, timeOfImpact))
                 {
-                    continue;
+                    collisions.push_back(candidatePairs[i]);
                 }
+                continue;
+            }
+            narrowphase.Add(a.current, b.current);
+            narrowphasePairIndices.push_back(i);
+        }
+        overlapIndices.clear();
+        narrowphase.FindOverlaps(overlapIndices);
+
+        for (auto index: overlapIndices)
+        {
+            collisions.push_back(candidatePairs[narrowphasePairIndices[index]]);
+        }
+        if (isSampling)
+        {
+            hasRetune = tuner.EndFrame(static_cast<int>(candidatePairs.size()), static_cast<int>(collisions.size()), broadphase->GetNumCells(), retuneMode, retuneCellSize);
+        }
+
+        // Dynamic against static colliders, the static ones never test against each other
+        for (auto entity: dynamicEntities)
+        {
+            const auto& collider = entity.GetComponent<BoxColliderComponent>();
+            if (collider.layer == 0)
+            {
+                continue;
+            }
+            const auto& entityBoxes = boxes[entity.GetId()];
+            const AABB box = entityBoxes.isContinuous ? Union(entityBoxes.previous, entityBoxes.current) : entityBoxes.current;
 
-                auto bTransform = b.GetComponent<TransformComponent>();
-                auto bCollider = b.GetComponent<BoxColliderComponent>();
-
-                bool collisionHappend = CheckAABBCollision(
-                    aTransform.position.x + aCollider.offset.x,
-                    aTransform.position.y + aCollider.offset.y,
-                    aCollider.width,
-                    aCollider.height,
-                    bTransform.position.x + bCollider.offset.x,
-                    bTransform.position.y + bCollider.offset.y,
-                    bCollider.width,
-                    bCollider.height
-                );
-
-                if (collisionHappend)
+            staticIndices.clear();
+            staticColliders.Query(box, collider.layer, collider.mask, staticIndices);
+            for (auto index: staticIndices)
+            {
+                const auto& staticCollider = staticColliders.GetCollider(index);
+                float timeOfImpact;
+                if (!entityBoxes.isContinuous || SweepAABB(entityBoxes.previous, entityBoxes.current, staticCollider.box, staticCollider.box, timeOfImpact))
                 {
-                    Logger::Log("Entity " + std::to_string(a.GetId()) + " is colliding with entity " + std::to_string(b.GetId()));
-                    
-                    eventBus->EmitEvent<CollisionEvent>(a, b);
+                    collisions.emplace_back(entity, staticCollider.entity);
                 }
             }
         }
+
+        // Keep this frame boxes to sweep from on the next one
+        for (auto entity: dynamicEntities)
+        {
+            auto& entityBoxes = boxes[entity.GetId()];
+            entityBoxes.previous = entityBoxes.current;
+        }
+
+        // Queue the events once the collision pass is done, their handlers run after the systems
+        // of this tick (see Game::Update) and may kill entities
+        enteredCollisions.clear();
+        stayedCollisions.clear();
+        exitedCollisions.clear();
+        if (isOrdered)
+        {
+            std::sort(collisions.begin(), collisions.end(), IsPairBefore);
+        }
+        pairCache.Update(collisions, enteredCollisions, stayedCollisions, exitedCollisions);
+        if (isOrdered)
+        {
+            // In the order of the cache's hash table
+            std::sort(exitedCollisions.begin(), exitedCollisions.end(), IsPairBefore);
+        }
+
+        // A new contact wakes a sleeping body up, whatever ran into it
+        for (const auto& collision: enteredCollisions)
+        {
+            WakeEntity(collision.first);
+            WakeEntity(collision.second);
+        }
+
+        for (const auto& collision: enteredCollisions)
+        {
+            LOGGER_DEBUG("Entity {} started colliding with entity {}", collision.first.GetId(), collision.second.GetId());
+            EventTrace::RecordCollision(TRACE_COLLISION_ENTER, collision.first.GetHandle(), collision.second.GetHandle());
+            eventBus->QueueEvent<CollisionEnterEvent>(collision.first, collision.second);
+        }
+        if (isEmittingStayEvents)
+        {
+            for (const auto& collision: stayedCollisions)
+            {
+                eventBus->QueueEvent<CollisionStayEvent>(collision.first, collision.second);
+            }
+        }
+        for (const auto& collision: exitedCollisions)
+        {
+            EventTrace::RecordCollision(TRACE_COLLISION_EXIT, collision.first.GetHandle(), collision.second.GetHandle());
+            eventBus->QueueEvent<CollisionExitEvent>(collision.first, collision.second);
+        }
     }
 
-    bool CheckAABBCollision(double aX, double aY, double aW, double aH, double bX, double bY, double bW, double bH)
+    // The pairs found colliding on the last update
+    const std::vector<std::pair<Entity, Entity>>& GetCollisions() const
     {
-        return (
-            aX < bX + bW &&
-            aX + aW > bX &&
-            aY < bY + bH &&
-            aY + aH > bY
-        );
+        return collisions;
     }
 };
 
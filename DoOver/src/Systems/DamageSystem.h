@@ -2,34 +2,84 @@
 #define DAMAGESYSTEM_H
 
 #include "../ECS/ECS.h"
-#include "../EventBus/EventBus.h"
-#include "../Events/CollisionEvent.h"
+#include "../ECS/EntityPool.h"
 #include "../Components/BoxColliderComponent.h"
+#include "../Components/ProjectileComponent.h"
+#include "../Components/HealthComponent.h"
+#include "DeathSystem.h"
+#include <utility>
+#include <vector>
 
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Damage system
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Resolves the projectile hits of a tick from the pairs the collision system found, in one
+// pass over them rather than an event per pair: the damage of the projectile goes to the
+// buffer of the death system, which takes it off the health of the target at the end of
+// the tick, and the projectile goes back to its pool, so it hits once even when it
+// overlaps several colliders. The triggers don't stop projectiles, and neither does the
+// emitter of a projectile, its parent in the registry, which is credited with the kill.
+/////////////////////////////////////////////////////////////////////////////////////////////
 class DamageSystem: public System
 {
-public:
-    DamageSystem()
-    {
-        RequireComponent<BoxColliderComponent>();
-    }
+private:
+    int numHits = 0;
 
-    void SubscribeToEvents(std::unique_ptr<EventBus>& eventBus)
+    // False when the first entity isn't a projectile hitting the second
+    bool Hit(Entity projectile, Entity target, EntityPool& projectilePool, DeathSystem& deathSystem)
     {
-        eventBus->SubscribeToEvent<CollisionEvent>(this, &DamageSystem::OnCollision);
+        if (!projectile.HasComponent<ProjectileComponent>() || target.HasComponent<ProjectileComponent>())
+        {
+            return false;
+        }
+        // Already given back this tick, after hitting another collider
+        const auto& projectileComponent = projectile.GetComponent<ProjectileComponent>();
+        if (!projectileComponent.isActive || target.GetComponent<BoxColliderComponent>().isTrigger)
+        {
+            return true;
+        }
+        Entity emitter = projectile;
+        const bool hasEmitter = projectile.GetRegistry()->GetEntityParent(projectile, emitter);
+        if (hasEmitter && emitter == target)
+        {
+            return true;
+        }
+
+        numHits++;
+        if (target.HasComponent<HealthComponent>() && hasEmitter)
+        {
+            deathSystem.AddDamage(target, projectileComponent.hitPercentDamage, emitter);
+        }
+        else if (target.HasComponent<HealthComponent>())
+        {
+            deathSystem.AddDamage(target, projectileComponent.hitPercentDamage);
+        }
+        projectilePool.Release(projectile);
+        return true;
     }
 
-    void OnCollision(CollisionEvent& event)
+public:
+    DamageSystem()
     {
-        Logger::Log("The damage system received an event collision between entities " + std::to_string(event.a.GetId()) + " and " + std::to_string(event.b.GetId()));
-        //event.a.Kill();
-        //event.b.Kill();
+        RequireComponent<BoxColliderComponent>();
+        // Gives projectiles back to their pool
+        RunsExclusively();
     }
 
-    void Update()
+    void Update(const std::vector<std::pair<Entity, Entity>>& collisions, EntityPool& projectilePool, DeathSystem& deathSystem)
     {
-
+        numHits = 0;
+        for (const auto& collision: collisions)
+        {
+            if (!Hit(collision.first, collision.second, projectilePool, deathSystem))
+            {
+                Hit(collision.second, collision.first, projectilePool, deathSystem);
+            }
+        }
     }
+
+    // Of the last update
+    int GetNumHits() const { return numHits; }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,190 @@
+#ifndef DEATHSYSTEM_H
+#define DEATHSYSTEM_H
+
+#include "../ECS/ECS.h"
+#include "../ECS/EntityPool.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/SpriteComponent.h"
+#include "../Components/BoxColliderComponent.h"
+#include "../Components/HealthComponent.h"
+#include "../Components/DeathEffectComponent.h"
+#include "../Particles/ParticleSystem.h"
+#include <deque>
+#include <memory>
+#include <vector>
+
+// The wrecks on the map at once, the oldest one is taken away for a new one past this
+const int DEATH_MAX_WRECKS = 32;
+const glm::vec2 DEATH_WRECK_PARK_POSITION = glm::vec2(-100000.0f, -100000.0f);
+const float DEATH_BURST_SPEED = 160.0f;
+const float DEATH_BURST_LIFE_SECONDS = 0.8f;
+const float DEATH_BURST_SIZE = 4.0f;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Death system
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The end of the damage pipeline. The damage of a tick is added up per entity as the hits
+// come, then applied in one pass: each damaged entity loses its health once, whatever the
+// number of hits, and the ones it brought to 0 die together. Their death effects play, a
+// particle burst and a wreck taken from a pool of sprites, and their kills reach the
+// registry as one batch, which it destroys in its next update. Each kill is credited to
+// the source of the last hit of the tick, e.g. the emitter of the projectile.
+/////////////////////////////////////////////////////////////////////////////////////////////
+struct EntityKill
+{
+    Entity entity;
+    Entity killer;
+    // False when the damage came from no entity
+    bool hasKiller;
+};
+
+class DeathSystem: public System
+{
+private:
+    struct PendingDamage
+    {
+        int damage;
+        Entity source;
+        bool hasSource;
+    };
+
+    // [entity id] -> the damage it took this tick
+    std::vector<PendingDamage> pendingDamage;
+    std::vector<Entity> damagedEntities;
+    std::vector<EntityKill> kills;
+    // The wrecks out of the pool, the oldest first
+    std::deque<Entity> wrecks;
+
+    void PlayDeathEffect(Entity entity, EntityPool& wreckPool, ParticleSystem& particleSystem)
+    {
+        const auto& deathEffect = entity.GetComponent<DeathEffectComponent>();
+        const auto& transform = entity.GetComponent<TransformComponent>();
+        glm::vec2 center = transform.position;
+        if (entity.HasComponent<BoxColliderComponent>())
+        {
+            const auto& collider = entity.GetComponent<BoxColliderComponent>();
+            center += collider.offset + glm::vec2(collider.width, collider.height) * transform.scale * 0.5f;
+        }
+        if (deathEffect.burstCount > 0)
+        {
+            particleSystem.EmitBurst(GetAssetHandle("bullet-image"), center, deathEffect.burstCount, DEATH_BURST_SPEED, DEATH_BURST_LIFE_SECONDS, DEATH_BURST_SIZE);
+        }
+
+        // The wreck takes the place and the look of the entity, with the sprite of the wreck
+        if (deathEffect.wreckAssetHandle == INVALID_ASSET_HANDLE || !entity.HasComponent<SpriteComponent>())
+        {
+            return;
+        }
+        if (static_cast<int>(wrecks.size()) >= DEATH_MAX_WRECKS)
+        {
+            wreckPool.Release(wrecks.front());
+            wrecks.pop_front();
+        }
+        const Entity wreck = wreckPool.Acquire();
+        auto& wreckTransform = wreck.PatchComponent<TransformComponent>();
+        wreckTransform.position = transform.position;
+        wreckTransform.previousPosition = transform.position;
+        wreckTransform.scale = transform.scale;
+        wreckTransform.rotation = transform.rotation;
+        const auto& sprite = entity.GetComponent<SpriteComponent>();
+        auto& wreckSprite = wreck.PatchComponent<SpriteComponent>();
+        wreckSprite = SpriteComponent("", sprite.width, sprite.height, sprite.zIndex);
+        wreckSprite.assetHandle = deathEffect.wreckAssetHandle;
+        wrecks.push_back(wreck);
+    }
+
+    void AddPendingDamage(Entity entity, int damage, Entity source, bool hasSource)
+    {
+        if (damage <= 0)
+        {
+            return;
+        }
+        const size_t entityId = entity.GetId();
+        if (entityId >= pendingDamage.size())
+        {
+            pendingDamage.resize(entityId + 1, PendingDamage{0, entity, false});
+        }
+        auto& pending = pendingDamage[entityId];
+        if (pending.damage == 0)
+        {
+            damagedEntities.push_back(entity);
+        }
+        pending.damage += damage;
+        pending.source = source;
+        pending.hasSource = hasSource;
+    }
+
+public:
+    DeathSystem()
+    {
+        RequireComponent<HealthComponent>();
+        // Kills entities and takes wrecks from their pool
+        RunsExclusively();
+    }
+
+    static std::unique_ptr<EntityPool> CreateWreckPool(Registry& registry)
+    {
+        return std::make_unique<EntityPool>(registry, [](Entity wreck)
+        {
+            wreck.AddComponent<TransformComponent>(DEATH_WRECK_PARK_POSITION, glm::vec2(1.0, 1.0), 0.0);
+            wreck.AddComponent<SpriteComponent>();
+        }, &ParkWreck);
+    }
+
+    static void ParkWreck(Entity wreck)
+    {
+        auto& transform = wreck.PatchComponent<TransformComponent>();
+        transform.position = DEATH_WRECK_PARK_POSITION;
+        transform.previousPosition = DEATH_WRECK_PARK_POSITION;
+    }
+
+    // Taken off the health at the end of the tick, with the rest of the damage of the entity
+    void AddDamage(Entity entity, int damage)
+    {
+        AddPendingDamage(entity, damage, entity, false);
+    }
+
+    // The same, the source is credited with the kill when its hit comes last
+    void AddDamage(Entity entity, int damage, Entity source)
+    {
+        AddPendingDamage(entity, damage, source, true);
+    }
+
+    void Update(EntityPool& wreckPool, ParticleSystem& particleSystem)
+    {
+        kills.clear();
+        for (auto entity: damagedEntities)
+        {
+            const PendingDamage pending = pendingDamage[entity.GetId()];
+            pendingDamage[entity.GetId()].damage = 0;
+            // Killed by something else since the hit
+            if (!entity.GetRegistry()->IsAlive(entity) || !entity.HasComponent<HealthComponent>())
+            {
+                continue;
+            }
+            auto& health = entity.GetComponent<HealthComponent>();
+            const bool wasAlive = health.healthPercentage > 0;
+            health.healthPercentage -= pending.damage;
+            if (wasAlive && health.healthPercentage <= 0)
+            {
+                kills.push_back({entity, pending.source, pending.hasSource});
+            }
+        }
+        damagedEntities.clear();
+
+        for (auto kill: kills)
+        {
+            if (kill.entity.HasComponent<DeathEffectComponent>() && kill.entity.HasComponent<TransformComponent>())
+            {
+                PlayDeathEffect(kill.entity, wreckPool, particleSystem);
+            }
+            kill.entity.Kill();
+        }
+    }
+
+    // Of the last update, the killers may have died since
+    const std::vector<EntityKill>& GetKills() const { return kills; }
+    int GetNumKills() const { return kills.size(); }
+};
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef DIRECTIONALSPRITESYSTEM_H
+#define DIRECTIONALSPRITESYSTEM_H
+
+#include "../ECS/ECS.h"
+#include "../Components/SpriteComponent.h"
+#include "../Components/RigidBodyComponent.h"
+#include "../Components/DirectionalSpriteComponent.h"
+#include <glm/glm.hpp>
+#include <cmath>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Directional sprite system
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Faces the sprites where their entity moves. The directions of a sprite are the rows of one
+// region (a sheet, or a directional texture stacked at load), so turning only moves the
+// source rectangle: the sprite keeps its texture and batches with the rest. The axis the
+// entity moves most along wins, a stopped entity keeps its last direction, and the sprite is
+// only patched when the direction changes.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class DirectionalSpriteSystem: public System
+{
+private:
+    static SpriteDirection GetDirection(glm::vec2 velocity)
+    {
+        if (std::abs(velocity.x) >= std::abs(velocity.y))
+        {
+            return velocity.x < 0.0f ? SPRITE_DIRECTION_LEFT : SPRITE_DIRECTION_RIGHT;
+        }
+        return velocity.y < 0.0f ? SPRITE_DIRECTION_UP : SPRITE_DIRECTION_DOWN;
+    }
+
+    static void Face(Entity entity, SpriteDirection direction)
+    {
+        entity.GetComponent<DirectionalSpriteComponent>().direction = direction;
+        auto& sprite = entity.PatchComponent<SpriteComponent>();
+        sprite.srcRect.y = sprite.height * direction;
+    }
+
+public:
+    DirectionalSpriteSystem()
+    {
+        RequireComponent<SpriteComponent>();
+        RequireComponent<RigidBodyComponent>();
+        RequireComponent<DirectionalSpriteComponent>();
+        ReadsComponent<RigidBodyComponent>();
+        WritesComponent<SpriteComponent>();
+        WritesComponent<DirectionalSpriteComponent>();
+    }
+
+    // Shows the direction the entity was given before it first moves
+    void OnEntityAdded(Entity entity) override
+    {
+        Face(entity, entity.GetComponent<DirectionalSpriteComponent>().direction);
+    }
+
+    void Update()
+    {
+        for (auto entity: GetSystemEntities())
+        {
+            const glm::vec2 velocity = entity.GetComponent<RigidBodyComponent>().velocity;
+            if (velocity.x == 0.0f && velocity.y == 0.0f)
+            {
+                continue;
+            }
+            const SpriteDirection direction = GetDirection(velocity);
+            if (direction != entity.GetComponent<DirectionalSpriteComponent>().direction)
+            {
+                Face(entity, direction);
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef FLOWFIELDSYSTEM_H
+#define FLOWFIELDSYSTEM_H
+
+#include "../ECS/ECS.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/RigidBodyComponent.h"
+#include "../Components/FlowFollowComponent.h"
+#include "../Navigation/FlowField.h"
+#include "MovementSystem.h"
+#include <glm/glm.hpp>
+
+// Closer to the goal than this the entities stop, so a crowd doesn't jitter on top of it
+const float FLOW_FIELD_ARRIVE_RADIUS = 24.0f;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Flow field system
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Sets the velocity of the entities following the flow field from the direction of the cell
+// they are in, a lookup per entity however many go to the goal. In the goal's cell they head
+// straight for the goal. Without a field, or where the goal can't be reached, they stop.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class FlowFieldSystem: public System
+{
+public:
+    FlowFieldSystem()
+    {
+        RequireComponent<TransformComponent>();
+        RequireComponent<RigidBodyComponent>();
+        RequireComponent<FlowFollowComponent>();
+        ReadsComponent<TransformComponent>();
+        ReadsComponent<FlowFollowComponent>();
+        WritesComponent<RigidBodyComponent>();
+    }
+
+    void Update(const FlowFieldTracker& flowFieldTracker)
+    {
+        const FlowField* field = flowFieldTracker.GetField();
+        const glm::vec2 goal = flowFieldTracker.GetGoal();
+        for (auto entity: GetSystemEntities())
+        {
+            const auto& transform = entity.GetComponent<TransformComponent>();
+            const float speed = entity.GetComponent<FlowFollowComponent>().speed;
+            if (!field)
+            {
+                MovementSystem::SetVelocity(entity, glm::vec2(0));
+                continue;
+            }
+            if (field->GetCell(transform.position) != field->GetGoalCell())
+            {
+                MovementSystem::SetVelocity(entity, field->GetDirection(transform.position) * speed);
+                continue;
+            }
+            const glm::vec2 toGoal = goal - transform.position;
+            MovementSystem::SetVelocity(entity, glm::length(toGoal) > FLOW_FIELD_ARRIVE_RADIUS ? glm::normalize(toGoal) * speed : glm::vec2(0));
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,298 @@
+#ifndef HIERARCHYSYSTEM_H
+#define HIERARCHYSYSTEM_H
+
+#include "../ECS/ECS.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/HierarchyComponent.h"
+#include "../Memory/FrameArena.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Chains deeper than this are taken for a cycle and cut there
+const int MAX_HIERARCHY_DEPTH = 32;
+// Below this many roots the update isn't worth spreading over the job system
+const int HIERARCHY_PARALLEL_MIN_ROOTS = 256;
+const int HIERARCHY_ROOTS_PER_GRAIN = 64;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Hierarchy system
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Works out the transform of the attached entities from their parents'. The entities are
+// kept sorted by root, and by depth inside a root, so a parent is always computed before
+// its children in one pass over an array. Only the entities whose parent transform or local
+// values changed are computed again, along with what hangs under them, and the roots are
+// independent of each other so they are spread over the job system.
+// A root is an entity with no HierarchyComponent, its transform is moved as usual. When a
+// parent is killed its children stay where they last were.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class HierarchySystem: public System
+{
+private:
+    struct HierarchyNode
+    {
+        Entity entity;
+        Entity parent;
+        // Position of the parent in the nodes, -1 when the parent is the root
+        int parentNode;
+    };
+
+    struct HierarchyGroup
+    {
+        Entity root;
+        int begin;
+        int end;
+    };
+
+    // Grouped by root, each parent before its children
+    std::vector<HierarchyNode> nodes;
+    std::vector<uint8_t> isNodeDirty;
+    std::vector<HierarchyGroup> groups;
+    // [entity id] -> position in the nodes, or in the groups for the roots, -1 for neither
+    std::vector<int> entityIdToNode;
+    std::vector<int> entityIdToGroup;
+    bool isOrderDirty = true;
+
+    // The commit of the component changes gone through last
+    uint32_t changeVersion = 0;
+    std::vector<Entity> changedEntities;
+
+    // The root an entity hangs from and how deep, following the parents
+    static Entity FindRoot(Entity entity, int& depth)
+    {
+        const Registry& registry = *entity.GetRegistry();
+        depth = 0;
+        Entity current = entity;
+        while (depth < MAX_HIERARCHY_DEPTH)
+        {
+            const Entity parent = current.GetComponent<HierarchyComponent>().parent;
+            if (!registry.IsAlive(parent) || parent == entity)
+            {
+                break;
+            }
+            depth++;
+            if (!parent.HasComponent<HierarchyComponent>())
+            {
+                return parent;
+            }
+            current = parent;
+        }
+        if (depth == MAX_HIERARCHY_DEPTH)
+        {
+            Logger::War("Entity " + std::to_string(entity.GetId()) + " is in a parent cycle, it is detached");
+        }
+        // Detached, it is its own root and keeps its transform
+        depth = 0;
+        return entity;
+    }
+
+    void SetIndex(std::vector<int>& entityIdTo, int entityId, int index)
+    {
+        if (entityId >= static_cast<int>(entityIdTo.size()))
+        {
+            entityIdTo.resize(entityId + 1, -1);
+        }
+        entityIdTo[entityId] = index;
+    }
+
+    void RebuildOrder(FrameArena& frameArena)
+    {
+        for (const auto& node: nodes)
+        {
+            entityIdToNode[node.entity.GetId()] = -1;
+        }
+        for (const auto& group: groups)
+        {
+            entityIdToGroup[group.root.GetId()] = -1;
+        }
+
+        struct SortedNode
+        {
+            Entity root;
+            int depth;
+            Entity entity;
+        };
+        std::pmr::vector<SortedNode> sortedNodes(&frameArena);
+        sortedNodes.reserve(GetSystemEntities().size());
+        for (auto entity: GetSystemEntities())
+        {
+            int depth;
+            const Entity root = FindRoot(entity, depth);
+            if (root != entity)
+            {
+                sortedNodes.push_back({root, depth, entity});
+            }
+        }
+        std::sort(sortedNodes.begin(), sortedNodes.end(), [](const SortedNode& a, const SortedNode& b)
+        {
+            return a.root != b.root ? a.root < b.root : a.depth < b.depth;
+        });
+
+        nodes.clear();
+        groups.clear();
+        for (const auto& sortedNode: sortedNodes)
+        {
+            if (groups.empty() || groups.back().root != sortedNode.root)
+            {
+                SetIndex(entityIdToGroup, sortedNode.root.GetId(), groups.size());
+                groups.push_back({sortedNode.root, static_cast<int>(nodes.size()), static_cast<int>(nodes.size())});
+            }
+            const Entity parent = sortedNode.entity.GetComponent<HierarchyComponent>().parent;
+            SetIndex(entityIdToNode, sortedNode.entity.GetId(), nodes.size());
+            nodes.push_back({sortedNode.entity, parent, parent == sortedNode.root ? -1 : entityIdToNode[parent.GetId()]});
+            groups.back().end++;
+        }
+        isNodeDirty.assign(nodes.size(), 1);
+        isOrderDirty = false;
+    }
+
+    // A root that moved dirties the entities attached to it, one whose local values changed
+    // itself, the parents attached to the hierarchy pass their change down during the update
+    void ApplyChanges(const Registry& registry)
+    {
+        changedEntities.clear();
+        const bool hasTransformChanges = registry.GetChangedEntities<TransformComponent>(changeVersion, changedEntities);
+        const int numTransformChanges = changedEntities.size();
+        const bool hasHierarchyChanges = registry.GetChangedEntities<HierarchyComponent>(changeVersion, changedEntities);
+        changeVersion = registry.GetChangeVersion();
+        if (!hasTransformChanges || !hasHierarchyChanges)
+        {
+            isOrderDirty = true;
+            return;
+        }
+
+        for (int i = 0; i < static_cast<int>(changedEntities.size()); i++)
+        {
+            const Entity entity = changedEntities[i];
+            const int entityId = entity.GetId();
+            if (!registry.IsAlive(entity))
+            {
+                continue;
+            }
+            if (i < numTransformChanges)
+            {
+                if (entityId < static_cast<int>(entityIdToGroup.size()) && entityIdToGroup[entityId] != -1)
+                {
+                    const auto& group = groups[entityIdToGroup[entityId]];
+                    for (int node = group.begin; node < group.end; node++)
+                    {
+                        isNodeDirty[node] = isNodeDirty[node] || nodes[node].parentNode == -1;
+                    }
+                }
+                continue;
+            }
+            if (entityId < static_cast<int>(entityIdToNode.size()) && entityIdToNode[entityId] != -1)
+            {
+                const int node = entityIdToNode[entityId];
+                // Attached somewhere else, the order changes
+                if (entity.GetComponent<HierarchyComponent>().parent != nodes[node].parent)
+                {
+                    isOrderDirty = true;
+                    return;
+                }
+                isNodeDirty[node] = 1;
+            }
+            else if (HasEntity(entity))
+            {
+                // Was detached and may be attached again
+                isOrderDirty = true;
+                return;
+            }
+        }
+    }
+
+    static glm::vec2 ToWorld(const glm::vec2& parentPosition, const TransformComponent& parent, const HierarchyComponent& hierarchy)
+    {
+        const float radians = glm::radians(parent.rotation);
+        const float cosine = std::cos(radians);
+        const float sine = std::sin(radians);
+        const glm::vec2 offset = hierarchy.localPosition * parent.scale;
+        return parentPosition + glm::vec2(offset.x * cosine - offset.y * sine, offset.x * sine + offset.y * cosine);
+    }
+
+    void UpdateGroup(const HierarchyGroup& group)
+    {
+        // The children of a killed root stay put until they are detached
+        if (!group.root.GetRegistry()->IsAlive(group.root))
+        {
+            std::fill(isNodeDirty.begin() + group.begin, isNodeDirty.begin() + group.end, 0);
+            return;
+        }
+        for (int node = group.begin; node < group.end; node++)
+        {
+            const auto& hierarchyNode = nodes[node];
+            const int parentNode = hierarchyNode.parentNode;
+            if (!isNodeDirty[node] && (parentNode == -1 || !isNodeDirty[parentNode]))
+            {
+                continue;
+            }
+            isNodeDirty[node] = 1;
+
+            const auto& parent = hierarchyNode.parent.GetComponent<TransformComponent>();
+            const auto& hierarchy = hierarchyNode.entity.GetComponent<HierarchyComponent>();
+            auto& transform = hierarchyNode.entity.PatchComponent<TransformComponent>();
+            // Both positions follow the parent's, so the rendering interpolates them alike
+            transform.position = ToWorld(parent.position, parent, hierarchy);
+            transform.previousPosition = ToWorld(parent.previousPosition, parent, hierarchy);
+            transform.scale = parent.scale * hierarchy.localScale;
+            transform.rotation = parent.rotation + hierarchy.localRotation;
+        }
+        // The children looked at their parent's flag, the pass over the group is done
+        std::fill(isNodeDirty.begin() + group.begin, isNodeDirty.begin() + group.end, 0);
+    }
+
+public:
+    HierarchySystem()
+    {
+        RequireComponent<TransformComponent>();
+        RequireComponent<HierarchyComponent>();
+        // The roots are read too, which are moved by the systems writing the transforms
+        WritesComponent<TransformComponent>();
+        ReadsComponent<HierarchyComponent>();
+    }
+
+    void OnEntityAdded(Entity entity) override
+    {
+        isOrderDirty = true;
+    }
+
+    void OnEntityRemoved(Entity entity) override
+    {
+        isOrderDirty = true;
+    }
+
+    void Update(const Registry& registry, std::unique_ptr<JobSystem>& jobSystem, FrameArena& frameArena)
+    {
+        ApplyChanges(registry);
+        if (isOrderDirty)
+        {
+            RebuildOrder(frameArena);
+        }
+
+        const int numGroups = groups.size();
+        if (numGroups < HIERARCHY_PARALLEL_MIN_ROOTS || jobSystem->GetNumWorkers() == 0)
+        {
+            for (const auto& group: groups)
+            {
+                UpdateGroup(group);
+            }
+            return;
+        }
+        jobSystem->ParallelFor(numGroups, HIERARCHY_ROOTS_PER_GRAIN, [this](int begin, int end)
+        {
+            for (int i = begin; i < end; i++)
+            {
+                UpdateGroup(groups[i]);
+            }
+        });
+    }
+
+    int GetNumRoots() const
+    {
+        return groups.size();
+    }
+};
+
+#endif
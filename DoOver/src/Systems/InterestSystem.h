@@ -0,0 +1,345 @@
+#ifndef INTERESTSYSTEM_H
+#define INTERESTSYSTEM_H
+
+#include "../ECS/ECS.h"
+#include "../Components/TransformComponent.h"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Entities are of interest this far past the edges of a view, so they don't pop in
+const int INTEREST_MARGIN = 256;
+const int INTEREST_CELL_SIZE = 256;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Interest system
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Which entities each observer (a network client, an AI sensor) has in its area of interest.
+// The entities are binned in a coarse grid by position and the observers register with the
+// cells their view covers. An entity only changes cell when its transform changed, and an
+// observer only when its view moved to other cells, so the visible sets are kept up to date
+// from those changes alone, never by scanning the entities per observer. Each observer also
+// gets the entities that entered and left its area since its changes were last cleared.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class InterestSystem: public System
+{
+private:
+    struct CellRange
+    {
+        int minX = 0;
+        int minY = 0;
+        int maxX = -1;
+        int maxY = -1;
+        bool Contains(int x, int y) const { return x >= minX && x <= maxX && y >= minY && y <= maxY; }
+        bool operator==(const CellRange& other) const { return minX == other.minX && minY == other.minY && maxX == other.maxX && maxY == other.maxY; }
+    };
+
+    struct InterestRecord
+    {
+        int cellX = 0;
+        int cellY = 0;
+        // Position of the entity in its cell, -1 when the entity isn't binned
+        int indexInCell = -1;
+    };
+
+    struct Cell
+    {
+        std::vector<Entity> entities;
+        // The observers whose area covers the cell
+        std::vector<int> observerIds;
+    };
+
+    struct Observer
+    {
+        bool isActive = false;
+        CellRange cells;
+        // [entity id] -> in the area
+        std::vector<bool> isEntityVisible;
+        int numVisibleEntities = 0;
+        std::vector<Entity> enteredEntities;
+        std::vector<Entity> leftEntities;
+    };
+
+    // [cell key] -> entities binned in the cell and the observers covering it
+    std::unordered_map<uint64_t, Cell> cells;
+    // [entity id] -> where the entity is binned
+    std::vector<InterestRecord> records;
+    std::vector<Entity> addedEntities;
+    std::vector<Observer> observers;
+    std::vector<Entity> changedEntities;
+    uint32_t changeVersion = 0;
+
+    static uint64_t GetCellKey(int cellX, int cellY)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(cellX)) << 32) | static_cast<uint32_t>(cellY);
+    }
+
+    static int GetCell(float position)
+    {
+        return static_cast<int>(std::floor(position / INTEREST_CELL_SIZE));
+    }
+
+    void SetVisible(Observer& observer, Entity entity, bool isVisible)
+    {
+        const int entityId = entity.GetId();
+        if (entityId >= static_cast<int>(observer.isEntityVisible.size()))
+        {
+            observer.isEntityVisible.resize(entityId + 1, false);
+        }
+        if (observer.isEntityVisible[entityId] == isVisible)
+        {
+            return;
+        }
+        observer.isEntityVisible[entityId] = isVisible;
+        observer.numVisibleEntities += isVisible ? 1 : -1;
+        (isVisible ? observer.enteredEntities : observer.leftEntities).push_back(entity);
+    }
+
+    void InsertIntoCell(Entity entity, InterestRecord& record, int cellX, int cellY)
+    {
+        auto& cell = cells[GetCellKey(cellX, cellY)];
+        record.cellX = cellX;
+        record.cellY = cellY;
+        record.indexInCell = static_cast<int>(cell.entities.size());
+        cell.entities.push_back(entity);
+    }
+
+    void RemoveFromCell(InterestRecord& record)
+    {
+        auto cellIt = cells.find(GetCellKey(record.cellX, record.cellY));
+        auto& entities = cellIt->second.entities;
+        const Entity last = entities.back();
+        entities[record.indexInCell] = last;
+        records[last.GetId()].indexInCell = record.indexInCell;
+        entities.pop_back();
+        if (entities.empty() && cellIt->second.observerIds.empty())
+        {
+            cells.erase(cellIt);
+        }
+        record.indexInCell = -1;
+    }
+
+    const std::vector<int>& GetCellObservers(int cellX, int cellY) const
+    {
+        static const std::vector<int> noObserverIds;
+        auto cell = cells.find(GetCellKey(cellX, cellY));
+        return cell == cells.end() ? noObserverIds : cell->second.observerIds;
+    }
+
+    // An entity moving within the area of an observer neither leaves nor enters it
+    void MoveToCell(Entity entity, InterestRecord& record, int cellX, int cellY)
+    {
+        const std::vector<int> previousObserverIds = GetCellObservers(record.cellX, record.cellY);
+        RemoveFromCell(record);
+        InsertIntoCell(entity, record, cellX, cellY);
+        const std::vector<int>& observerIds = GetCellObservers(cellX, cellY);
+        for (auto observerId: previousObserverIds)
+        {
+            if (std::find(observerIds.begin(), observerIds.end(), observerId) == observerIds.end())
+            {
+                SetVisible(observers[observerId], entity, false);
+            }
+        }
+        for (auto observerId: observerIds)
+        {
+            if (std::find(previousObserverIds.begin(), previousObserverIds.end(), observerId) == previousObserverIds.end())
+            {
+                SetVisible(observers[observerId], entity, true);
+            }
+        }
+    }
+
+    // Every cell of the range not in the other one
+    template <typename TFunc>
+    void ForEachCellLeaving(const CellRange& range, const CellRange& other, TFunc func)
+    {
+        for (int cellY = range.minY; cellY <= range.maxY; cellY++)
+        {
+            for (int cellX = range.minX; cellX <= range.maxX; cellX++)
+            {
+                if (!other.Contains(cellX, cellY))
+                {
+                    func(cellX, cellY);
+                }
+            }
+        }
+    }
+
+    void RemoveObserverFromCells(int observerId, const CellRange& range, const CellRange& keptRange)
+    {
+        Observer& observer = observers[observerId];
+        ForEachCellLeaving(range, keptRange, [this, observerId, &observer](int cellX, int cellY)
+        {
+            auto cellIt = cells.find(GetCellKey(cellX, cellY));
+            if (cellIt == cells.end())
+            {
+                return;
+            }
+            auto& observerIds = cellIt->second.observerIds;
+            observerIds.erase(std::remove(observerIds.begin(), observerIds.end(), observerId), observerIds.end());
+            for (auto entity: cellIt->second.entities)
+            {
+                SetVisible(observer, entity, false);
+            }
+            if (cellIt->second.entities.empty() && observerIds.empty())
+            {
+                cells.erase(cellIt);
+            }
+        });
+    }
+
+public:
+    InterestSystem()
+    {
+        RequireComponent<TransformComponent>();
+        ReadsComponent<TransformComponent>();
+    }
+
+    void OnEntityAdded(Entity entity) override
+    {
+        addedEntities.push_back(entity);
+    }
+
+    void OnEntityRemoved(Entity entity) override
+    {
+        const int entityId = entity.GetId();
+        if (entityId >= static_cast<int>(records.size()) || records[entityId].indexInCell == -1)
+        {
+            return;
+        }
+        auto& record = records[entityId];
+        for (auto observerId: GetCellObservers(record.cellX, record.cellY))
+        {
+            SetVisible(observers[observerId], entity, false);
+        }
+        RemoveFromCell(record);
+    }
+
+    // Bins the new entities and moves the ones whose transform changed to their new cell
+    void Update(const Registry& registry)
+    {
+        for (auto entity: addedEntities)
+        {
+            if (!HasEntity(entity) || !registry.IsAlive(entity))
+            {
+                continue;
+            }
+            if (entity.GetId() >= static_cast<int>(records.size()))
+            {
+                records.resize(entity.GetId() + 1);
+            }
+            auto& record = records[entity.GetId()];
+            if (record.indexInCell != -1)
+            {
+                continue;
+            }
+            const auto& position = entity.GetComponent<TransformComponent>().position;
+            InsertIntoCell(entity, record, GetCell(position.x), GetCell(position.y));
+            for (auto observerId: GetCellObservers(record.cellX, record.cellY))
+            {
+                SetVisible(observers[observerId], entity, true);
+            }
+        }
+        addedEntities.clear();
+
+        // Without the history of the changes every entity is looked at
+        changedEntities.clear();
+        if (!registry.GetChangedEntities<TransformComponent>(changeVersion, changedEntities))
+        {
+            changedEntities = GetSystemEntities();
+        }
+        changeVersion = registry.GetChangeVersion();
+        for (auto entity: changedEntities)
+        {
+            if (!HasEntity(entity) || !registry.IsAlive(entity) || entity.GetId() >= static_cast<int>(records.size()) || records[entity.GetId()].indexInCell == -1)
+            {
+                continue;
+            }
+            auto& record = records[entity.GetId()];
+            const auto& position = entity.GetComponent<TransformComponent>().position;
+            const int cellX = GetCell(position.x);
+            const int cellY = GetCell(position.y);
+            if (cellX != record.cellX || cellY != record.cellY)
+            {
+                MoveToCell(entity, record, cellX, cellY);
+            }
+        }
+    }
+
+    // Adds the observer or moves its area, the entities of the cells it reaches enter it and
+    // the ones of the cells it left leave it
+    void SetObserverView(int observerId, const SDL_Rect& view)
+    {
+        if (observerId >= static_cast<int>(observers.size()))
+        {
+            observers.resize(observerId + 1);
+        }
+        CellRange viewCells;
+        viewCells.minX = GetCell(static_cast<float>(view.x - INTEREST_MARGIN));
+        viewCells.minY = GetCell(static_cast<float>(view.y - INTEREST_MARGIN));
+        viewCells.maxX = GetCell(static_cast<float>(view.x + view.w + INTEREST_MARGIN));
+        viewCells.maxY = GetCell(static_cast<float>(view.y + view.h + INTEREST_MARGIN));
+        Observer& observer = observers[observerId];
+        if (observer.isActive && viewCells == observer.cells)
+        {
+            return;
+        }
+        const CellRange previousCells = observer.cells;
+        observer.isActive = true;
+        observer.cells = viewCells;
+        RemoveObserverFromCells(observerId, previousCells, viewCells);
+        ForEachCellLeaving(viewCells, previousCells, [this, observerId, &observer](int cellX, int cellY)
+        {
+            auto& cell = cells[GetCellKey(cellX, cellY)];
+            cell.observerIds.push_back(observerId);
+            for (auto entity: cell.entities)
+            {
+                SetVisible(observer, entity, true);
+            }
+        });
+    }
+
+    // The observer id can be reused by the next one
+    void RemoveObserver(int observerId)
+    {
+        if (observerId >= static_cast<int>(observers.size()) || !observers[observerId].isActive)
+        {
+            return;
+        }
+        RemoveObserverFromCells(observerId, observers[observerId].cells, CellRange());
+        observers[observerId] = Observer();
+    }
+
+    // [entity id] -> in the area of the observer, the ids past the end are not
+    const std::vector<bool>& GetVisibleEntities(int observerId) const
+    {
+        return observers[observerId].isEntityVisible;
+    }
+
+    int GetNumVisibleEntities(int observerId) const
+    {
+        return observers[observerId].numVisibleEntities;
+    }
+
+    // Since the last ClearObserverChanges, an entity that came and went is in both
+    const std::vector<Entity>& GetEnteredEntities(int observerId) const
+    {
+        return observers[observerId].enteredEntities;
+    }
+
+    const std::vector<Entity>& GetLeftEntities(int observerId) const
+    {
+        return observers[observerId].leftEntities;
+    }
+
+    void ClearObserverChanges(int observerId)
+    {
+        observers[observerId].enteredEntities.clear();
+        observers[observerId].leftEntities.clear();
+    }
+};
+
+#endif
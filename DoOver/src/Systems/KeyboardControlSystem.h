@@ -2,11 +2,10 @@
 #define KEYBOARDCONTROLSYSTEM_H
 
 #include "../ECS/ECS.h"
-#include "../EventBus/EventBus.h"
-#include "../Events/KeyPressedEvent.h"
+#include "../Input/InputState.h"
 #include "../Components/KeyboardControlledComponent.h"
-#include "../Components/SpriteComponent.h"
 #include "../Components/RigidBodyComponent.h"
+#include "MovementSystem.h"
 
 class KeyboardControlSystem: public System
 {
@@ -14,49 +13,56 @@ public:
     KeyboardControlSystem()
     {
         RequireComponent<KeyboardControlledComponent>();
-        RequireComponent<SpriteComponent>();
         RequireComponent<RigidBodyComponent>();
+        ReadsComponent<KeyboardControlledComponent>();
+        WritesComponent<RigidBodyComponent>();
     }
 
-    void SubscribeToEvents(std::unique_ptr<EventBus>& eventBus)
+    // Also replayed by the client side prediction on the entities it re-simulates. The sprite
+    // turns with the velocity, see DirectionalSpriteSystem.
+    static void ApplyAction(Entity entity, InputAction action)
     {
-        eventBus->SubscribeToEvent<KeyPressedEvent>(this, &KeyboardControlSystem::OnKeyPressed);
+        const auto keyboardControl = entity.GetComponent<KeyboardControlledComponent>();
+
+        switch (action)
+        {
+        case INPUT_ACTION_MOVE_UP:
+            MovementSystem::SetVelocity(entity, keyboardControl.upVelocity);
+            break;
+        case INPUT_ACTION_MOVE_RIGHT:
+            MovementSystem::SetVelocity(entity, keyboardControl.rightVelocity);
+            break;
+        case INPUT_ACTION_MOVE_DOWN:
+            MovementSystem::SetVelocity(entity, keyboardControl.downVelocity);
+            break;
+        case INPUT_ACTION_MOVE_LEFT:
+            MovementSystem::SetVelocity(entity, keyboardControl.leftVelocity);
+            break;
+        default:
+            break;
+        }
     }
 
-    void OnKeyPressed(KeyPressedEvent& event)
+    // The direction pressed on the tick sets the velocity, it is kept once released.
+    // The entities are only gone through on the ticks something was pressed.
+    void Update(const InputState& inputState)
     {
+        const InputActions pressedActions = inputState.GetPressedActions();
+        if (pressedActions.none())
+        {
+            return;
+        }
         for (auto entity: GetSystemEntities())
         {
-            const auto keyboardControl = entity.GetComponent<KeyboardControlledComponent>();
-            auto& sprite = entity.GetComponent<SpriteComponent>();
-            auto& rigidBody = entity.GetComponent<RigidBodyComponent>();
-
-            switch (event.symbol)
+            for (int action = 0; action < INPUT_ACTION_COUNT; action++)
             {
-            case SDLK_UP:
-                rigidBody.velocity = keyboardControl.upVelocity;
-                sprite.srcRect.y = sprite.height * 0;
-                break;
-            case SDLK_RIGHT:
-                rigidBody.velocity = keyboardControl.rightVelocity;
-                sprite.srcRect.y = sprite.height * 1;
-                break;
-            case SDLK_DOWN:
-                rigidBody.velocity = keyboardControl.downVelocity;
-                sprite.srcRect.y = sprite.height * 2;
-                break;
-            case SDLK_LEFT:
-                rigidBody.velocity = keyboardControl.leftVelocity;
-                sprite.srcRect.y = sprite.height * 3;
-                break;
+                if (pressedActions[action])
+                {
+                    ApplyAction(entity, static_cast<InputAction>(action));
+                }
             }
         }
     }
-
-    void Update()
-    {
-
-    }
 };
 
 #endif /* KEYBOARDCONTROLSYSTEM_H */
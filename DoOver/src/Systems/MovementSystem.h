@@ -4,30 +4,267 @@
 #include "../ECS/ECS.h"
 #include "../Components/TransformComponent.h"
 #include "../Components/RigidBodyComponent.h"
+#include "../Components/SleepingComponent.h"
+#include "../Components/PhysicsMaterialComponent.h"
+#include "../Resources/TickTimeResource.h"
+#include "../Physics/Integration.h"
+
+// Chunks integrated by each job, a chunk holds a few hundred entities
+const int MOVEMENT_CHUNKS_PER_GRAIN = 4;
+// Ticks a rigid body rests before it is put to sleep
+const int RIGID_BODY_SLEEP_TICKS = 60;
 
 class MovementSystem: public System
 {
+private:
+    // The archetype chunks of the moving entities, gathered again every update
+    struct MovementRun
+    {
+        const int* entityIds;
+        int count;
+        TransformComponent* transforms;
+        RigidBodyComponent* rigidBodies;
+        // Null for the chunks of the bodies without forces, the kernel integrates them
+        const PhysicsMaterialComponent* materials;
+    };
+    std::vector<MovementRun> runs;
+    // The sleeping and the bodies with a material are left out of the kernel chunks
+    Signature kernelExcludedSignature;
+
+    // [entity id] -> ticks the body has been resting, each id is only written by the job
+    // integrating it
+    std::vector<int> restingTicks;
+    // The commit of the rigid body changes gone through last
+    uint32_t changeVersion = 0;
+    std::vector<Entity> changedEntities;
+
+    static bool IsResting(const TransformComponent& transform, const RigidBodyComponent& rigidBody, const PhysicsMaterialComponent* material = nullptr)
+    {
+        return rigidBody.velocity == glm::vec2(0) && transform.previousPosition == transform.position && (!material || material->acceleration == glm::vec2(0));
+    }
+
+    // Of a body with forces, the velocity is only flagged when they changed it
+    static void IntegrateBody(Registry& registry, int entityId, TransformComponent& transform, RigidBodyComponent& rigidBody, const PhysicsMaterialComponent& material, float step)
+    {
+        const glm::vec2 velocity = rigidBody.velocity;
+        Integration::IntegrateBody(transform, rigidBody, material, step);
+        registry.MarkComponentChanged<TransformComponent>(entityId);
+        if (rigidBody.velocity != velocity)
+        {
+            registry.MarkComponentChanged<RigidBodyComponent>(entityId);
+        }
+    }
+
+    // Counts the ticks of a resting body, and puts it to sleep once it rested long enough
+    void CountResting(Registry& registry, int entityId, bool isResting)
+    {
+        int& ticks = restingTicks[entityId];
+        if (!isResting)
+        {
+            ticks = 0;
+        }
+        else if (++ticks == RIGID_BODY_SLEEP_TICKS)
+        {
+            registry.GetThreadCommands().AddComponent<SleepingComponent>(registry.GetEntity(entityId));
+        }
+    }
+
+    // The kernel rewrites the resting bodies as they are, only the moving ones are flagged
+    void Integrate(Registry& registry, const MovementRun& run, float step)
+    {
+        if (run.materials)
+        {
+            for (int row = 0; row < run.count; row++)
+            {
+                const bool isResting = IsResting(run.transforms[row], run.rigidBodies[row], &run.materials[row]);
+                if (!isResting)
+                {
+                    IntegrateBody(registry, run.entityIds[row], run.transforms[row], run.rigidBodies[row], run.materials[row], step);
+                }
+                CountResting(registry, run.entityIds[row], isResting);
+            }
+            return;
+        }
+        for (int row = 0; row < run.count; row++)
+        {
+            const bool isResting = IsResting(run.transforms[row], run.rigidBodies[row]);
+            if (!isResting)
+            {
+                registry.MarkComponentChanged<TransformComponent>(run.entityIds[row]);
+            }
+            CountResting(registry, run.entityIds[row], isResting);
+        }
+        Integration::IntegratePositions(run.transforms, run.rigidBodies, run.count, step);
+    }
+
+    // The sleeping bodies given a velocity since the last update are woken up, and moved on
+    // this tick already since the system only gets them back at the next Registry::Update
+    void WakeMovedBodies(Registry& registry, float step)
+    {
+        changedEntities.clear();
+        const bool hasChanges = registry.GetChangedEntities<RigidBodyComponent>(changeVersion, changedEntities);
+        changeVersion = registry.GetChangeVersion();
+        if (!hasChanges)
+        {
+            // Too far behind, every sleeping body is looked at
+            changedEntities.clear();
+            registry.View<RigidBodyComponent, SleepingComponent>().Each([this](Entity entity, const RigidBodyComponent&, const SleepingComponent&)
+            {
+                changedEntities.push_back(entity);
+            });
+        }
+        for (auto entity: changedEntities)
+        {
+            if (!registry.IsAlive(entity) || !entity.HasComponent<SleepingComponent>() || !entity.HasComponent<TransformComponent>())
+            {
+                continue;
+            }
+            auto& rigidBody = entity.GetComponent<RigidBodyComponent>();
+            if (rigidBody.velocity == glm::vec2(0))
+            {
+                continue;
+            }
+            auto& transform = entity.GetComponent<TransformComponent>();
+            if (entity.HasComponent<PhysicsMaterialComponent>())
+            {
+                IntegrateBody(registry, entity.GetId(), transform, rigidBody, entity.GetComponent<PhysicsMaterialComponent>(), step);
+            }
+            else
+            {
+                registry.MarkComponentChanged<TransformComponent>(entity.GetId());
+                transform.previousPosition = transform.position;
+                transform.position += rigidBody.velocity * step;
+            }
+            registry.GetThreadCommands().RemoveComponent<SleepingComponent>(entity);
+        }
+    }
+
 public:
     MovementSystem()
     {
         RequireComponent<TransformComponent>();
         RequireComponent<RigidBodyComponent>();
+        ExcludeComponent<SleepingComponent>();
+        WritesComponent<TransformComponent>();
+        WritesComponent<RigidBodyComponent>();
+        ReadsComponent<PhysicsMaterialComponent>();
+        ReadsResource<TickTimeResource>();
+
+        kernelExcludedSignature = GetExcludedSignature();
+        kernelExcludedSignature.set(Component<PhysicsMaterialComponent>::GetId());
     }
 
-    void Update(double deltaTime)
+    // Back from sleep or new, the body rests for the whole count again before it sleeps
+    void OnEntityAdded(Entity entity) override
     {
-        // Loop all entities that the system is interested in
-        for (auto entity: GetSystemEntities())
+        if (entity.GetId() >= static_cast<int>(restingTicks.size()))
         {
-            // Update entity position based on its velocity
-            auto& transform = entity.GetComponent<TransformComponent>();
-            const auto rigidbody = entity.GetComponent<RigidBodyComponent>();
+            restingTicks.resize(entity.GetId() + 1);
+        }
+        restingTicks[entity.GetId()] = 0;
+    }
 
-            transform.position.x += rigidbody.velocity.x * deltaTime;
-            transform.position.y += rigidbody.velocity.y * deltaTime;
+    // The velocity writers go through it so a sleeping body wakes up, a write that changes
+    // nothing isn't flagged and lets the body sleep
+    static void SetVelocity(Entity entity, glm::vec2 velocity)
+    {
+        if (entity.GetComponent<RigidBodyComponent>().velocity != velocity)
+        {
+            entity.PatchComponent<RigidBodyComponent>().velocity = velocity;
         }
+    }
 
+    // Steps the TickTimeResource of the registry
+    void Update(Registry& registry, std::unique_ptr<JobSystem>& jobSystem)
+    {
+        // The positions are floats, the step is converted once instead of per component
+        const float step = static_cast<float>(registry.GetResource<TickTimeResource>().deltaTime);
+        WakeMovedBodies(registry, step);
+
+        // The archetype chunks keep the transforms and rigid bodies contiguous, they are
+        // integrated by the SIMD kernel a chunk at a time. The chunks of the bodies with forces
+        // are integrated a body at a time.
+        runs.clear();
+        int numRunEntities = 0;
+        const bool hasChunks = registry.View<TransformComponent, RigidBodyComponent>().EachChunk(
+            [this, &numRunEntities](const int* entityIds, int count, TransformComponent* transforms, RigidBodyComponent* rigidBodies)
+        {
+            runs.push_back({entityIds, count, transforms, rigidBodies, nullptr});
+            numRunEntities += count;
+        }, kernelExcludedSignature);
+        registry.View<TransformComponent, RigidBodyComponent, PhysicsMaterialComponent>().EachChunk(
+            [this, &numRunEntities](const int* entityIds, int count, TransformComponent* transforms, RigidBodyComponent* rigidBodies, PhysicsMaterialComponent* materials)
+        {
+            runs.push_back({entityIds, count, transforms, rigidBodies, materials});
+            numRunEntities += count;
+        }, GetExcludedSignature());
+        if (hasChunks)
+        {
+            if (numRunEntities < PARALLEL_EACH_MIN_ENTITIES || jobSystem->GetNumWorkers() == 0)
+            {
+                for (const auto& run: runs)
+                {
+                    Integrate(registry, run, step);
+                }
+                return;
+            }
+            jobSystem->ParallelFor(runs.size(), MOVEMENT_CHUNKS_PER_GRAIN, [this, &registry, step](int begin, int end)
+            {
+                for (int i = begin; i < end; i++)
+                {
+                    Integrate(registry, runs[i], step);
+                }
+            });
+            return;
+        }
+
+        // The pools don't line the two components up, each entity is integrated on its own
+        ParallelEach(*jobSystem, [this, &registry, step](Entity entity)
+        {
+            // Update entity position based on its velocity, the ones at rest are left unchanged
+            auto& rigidbody = entity.GetComponent<RigidBodyComponent>();
+            const PhysicsMaterialComponent* material = entity.HasComponent<PhysicsMaterialComponent>() ? &entity.GetComponent<PhysicsMaterialComponent>() : nullptr;
+            const bool isResting = IsResting(entity.GetComponent<TransformComponent>(), rigidbody, material);
+            CountResting(registry, entity.GetId(), isResting);
+            if (isResting)
+            {
+                return;
+            }
+            if (material)
+            {
+                IntegrateBody(registry, entity.GetId(), entity.GetComponent<TransformComponent>(), rigidbody, *material, step);
+                return;
+            }
+            auto& transform = entity.PatchComponent<TransformComponent>();
+
+            transform.previousPosition = transform.position;
+            transform.position += rigidbody.velocity * step;
+        });
+    }
+
+    // Integrates the given entities only, the client side prediction re-simulates its own
+    // entities without the rest of the world
+    void Update(const std::vector<Entity>& entities, double deltaTime)
+    {
+        const float step = static_cast<float>(deltaTime);
+        for (auto entity: entities)
+        {
+            const auto& rigidbody = entity.GetComponent<RigidBodyComponent>();
+            const PhysicsMaterialComponent* material = entity.HasComponent<PhysicsMaterialComponent>() ? &entity.GetComponent<PhysicsMaterialComponent>() : nullptr;
+            if (IsResting(entity.GetComponent<TransformComponent>(), rigidbody, material))
+            {
+                continue;
+            }
+            if (material)
+            {
+                Integration::IntegrateBody(entity.PatchComponent<TransformComponent>(), entity.PatchComponent<RigidBodyComponent>(), *material, step);
+                continue;
+            }
+            auto& transform = entity.PatchComponent<TransformComponent>();
+            transform.previousPosition = transform.position;
+            transform.position += rigidbody.velocity * step;
+        }
     }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,114 @@
+#ifndef NAVIGATIONSYSTEM_H
+#define NAVIGATIONSYSTEM_H
+
+#include "../ECS/ECS.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/RigidBodyComponent.h"
+#include "../Components/PathFollowComponent.h"
+#include "../Navigation/Pathfinder.h"
+#include "MovementSystem.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Navigation system
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Drives the entities with a path to follow: a path to the goal is requested from the
+// pathfinder whenever the goal changes, and once it arrives the velocity points at the next
+// waypoint until the last one is reached. The entities wait in place for their path.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class NavigationSystem: public System
+{
+private:
+    struct Navigation
+    {
+        glm::vec2 goal = glm::vec2(0);
+        PathRequestId requestId = INVALID_PATH_REQUEST;
+        Path path;
+        size_t nextWaypoint = 0;
+        // Set once the goal was asked for, until the goal changes
+        bool isRequested = false;
+    };
+
+    // [entity id] -> how it gets to its goal
+    std::vector<Navigation> navigations;
+
+    Navigation& GetNavigation(Entity entity)
+    {
+        if (entity.GetId() >= static_cast<int>(navigations.size()))
+        {
+            navigations.resize(entity.GetId() + 1);
+        }
+        return navigations[entity.GetId()];
+    }
+
+public:
+    NavigationSystem()
+    {
+        RequireComponent<TransformComponent>();
+        RequireComponent<RigidBodyComponent>();
+        RequireComponent<PathFollowComponent>();
+        ReadsComponent<TransformComponent>();
+        ReadsComponent<PathFollowComponent>();
+        WritesComponent<RigidBodyComponent>();
+    }
+
+    void OnEntityAdded(Entity entity) override
+    {
+        GetNavigation(entity) = Navigation();
+    }
+
+    void OnEntityRemoved(Entity entity) override
+    {
+        // Keeps the capacity of the path for the next entity with this id
+        Navigation& navigation = GetNavigation(entity);
+        navigation.path.clear();
+        navigation.isRequested = false;
+        navigation.requestId = INVALID_PATH_REQUEST;
+    }
+
+    void Update(Pathfinder& pathfinder, double deltaTime)
+    {
+        for (auto entity: GetSystemEntities())
+        {
+            const auto& pathFollow = entity.GetComponent<PathFollowComponent>();
+            const auto& transform = entity.GetComponent<TransformComponent>();
+            Navigation& navigation = GetNavigation(entity);
+
+            if (!navigation.isRequested || navigation.goal != pathFollow.goal)
+            {
+                pathfinder.CancelRequest(navigation.requestId);
+                navigation.goal = pathFollow.goal;
+                navigation.requestId = pathfinder.RequestPath(transform.position, pathFollow.goal);
+                navigation.path.clear();
+                navigation.nextWaypoint = 0;
+                navigation.isRequested = true;
+            }
+            if (navigation.requestId != INVALID_PATH_REQUEST)
+            {
+                const PathStatus status = pathfinder.TakePath(navigation.requestId, navigation.path);
+                if (status == PATH_STATUS_PENDING)
+                {
+                    MovementSystem::SetVelocity(entity, glm::vec2(0));
+                    continue;
+                }
+                navigation.requestId = INVALID_PATH_REQUEST;
+            }
+
+            // Past a waypoint once a step would overshoot it
+            const float step = pathFollow.speed * static_cast<float>(deltaTime);
+            while (navigation.nextWaypoint < navigation.path.size() && glm::distance(transform.position, navigation.path[navigation.nextWaypoint]) <= step)
+            {
+                navigation.nextWaypoint++;
+            }
+            if (navigation.nextWaypoint >= navigation.path.size())
+            {
+                MovementSystem::SetVelocity(entity, glm::vec2(0));
+                continue;
+            }
+            MovementSystem::SetVelocity(entity, glm::normalize(navigation.path[navigation.nextWaypoint] - transform.position) * pathFollow.speed);
+        }
+    }
+};
+
+#endif
@@ -2,13 +2,26 @@
 #define PROJECTILEEMITSYSTEM_H
 
 #include "../ECS/ECS.h"
+#include "../ECS/EntityPool.h"
 #include "../Components/TransformComponent.h"
 #include "../Components/RigidBodyComponent.h"
 #include "../Components/SpriteComponent.h"
 #include "../Components/BoxColliderComponent.h"
 #include "../Components/ProjectileComponent.h"
 #include "../Components/ProjectileEmitterComponent.h"
-#include <SDL2/SDL.h>
+#include "../Components/DormantComponent.h"
+#include "../Components/SimulationLodComponent.h"
+#include "../Clock/FrameClock.h"
+#include "../Clock/TimerWheel.h"
+#include "../Audio/AudioEngine.h"
+#include "../Physics/Broadphase.h"
+#include "MovementSystem.h"
+#include <vector>
+
+// Projectiles created over the first ticks of a level, the pool grows past it when more are in flight
+const int PROJECTILE_POOL_SIZE = 256;
+// Parked projectiles wait far out of view, the renderer culls them
+const glm::vec2 PROJECTILE_PARK_POSITION = glm::vec2(-100000.0f, -100000.0f);
 
 class ProjectileEmitSystem: public System
 {
@@ -17,36 +30,153 @@ public:
     {
         RequireComponent<ProjectileEmitterComponent>();
         RequireComponent<TransformComponent>();
+        // Dormant emitters hold their fire, they fire as soon as they wake up once overdue
+        ExcludeComponent<DormantComponent>();
+        // Acquires the projectiles, which may create entities
+        RunsExclusively();
+    }
+
+    // The pool the emitters take their projectiles from, ProjectileLifecycleSystem gives them back
+    // once they expire
+    static std::unique_ptr<EntityPool> CreateProjectilePool(Registry& registry)
+    {
+        auto projectilePool = std::make_unique<EntityPool>(registry, [](Entity projectile)
+        {
+            projectile.AddComponent<TransformComponent>(PROJECTILE_PARK_POSITION, glm::vec2(1.0, 1.0), 0.0);
+            projectile.AddComponent<RigidBodyComponent>(glm::vec2(0));
+            projectile.AddComponent<SpriteComponent>("bullet-image", 4, 4, 4);
+            projectile.AddComponent<BoxColliderComponent>(4, 4, glm::vec2(0), 0, 0, false, true);
+            projectile.AddComponent<ProjectileComponent>(false, 0, 0, 0.0, false);
+        }, &ParkProjectile);
+        // Over the first ticks, the level starts without waiting for them
+        projectilePool->PrewarmLazily(PROJECTILE_POOL_SIZE);
+        return projectilePool;
+    }
+
+    static void ParkProjectile(Entity projectile)
+    {
+        auto& transform = projectile.PatchComponent<TransformComponent>();
+        transform.position = PROJECTILE_PARK_POSITION;
+        transform.previousPosition = PROJECTILE_PARK_POSITION;
+        MovementSystem::SetVelocity(projectile, glm::vec2(0));
+        // A collider on no layer is skipped by the collision system
+        auto& collider = projectile.PatchComponent<BoxColliderComponent>();
+        collider.layer = 0;
+        collider.mask = 0;
+        projectile.GetComponent<ProjectileComponent>().isActive = false;
+        projectile.GetRegistry()->RemoveEntityParent(projectile);
+    }
+
+    void OnEntityAdded(Entity entity) override
+    {
+        addedEmitters.push_back(entity);
     }
 
-    void Update(std::unique_ptr<Registry>& registry)
+    // Only the emitters whose timer is due fire, the others cost nothing this tick. The sounds
+    // of the shots go to the audio engine in one batch, which plays each of them once. The
+    // emitters with a target range look for their target in the broadphase of the colliders.
+    void Update(const FrameClock& frameClock, TimerWheel& timerWheel, EntityPool& projectilePool, AudioEngine& audioEngine, const IBroadphase& broadphase)
     {
-        for (auto entity: GetSystemEntities())
+        emittedSounds.clear();
+        const double millisecs = frameClock.GetMillisecs();
+        for (auto entity: addedEmitters)
         {
+            if (!HasEntity(entity) || !entity.GetRegistry()->IsAlive(entity))
+            {
+                continue;
+            }
             auto& projectileEmitter = entity.GetComponent<ProjectileEmitterComponent>();
-            const auto transform = entity.GetComponent<TransformComponent>();
+            const double delay = projectileEmitter.lastEmissionTime + projectileEmitter.repeatFrequency - millisecs;
+            if (delay < 0.0)
+            {
+                Emit(entity, frameClock, timerWheel, projectilePool, broadphase);
+            }
+            else
+            {
+                projectileEmitter.nextEmissionTick = timerWheel.Schedule(frameClock.GetTick() + frameClock.GetTicksAfter(delay), TIMER_PROJECTILE_EMISSION, entity);
+            }
+        }
+        addedEmitters.clear();
 
-            // Check if its time to re-emit a new projectile
-            if (static_cast<int>(SDL_GetTicks() - projectileEmitter.lastEmissionTime) > projectileEmitter.repeatFrequency)
+        for (const auto& timer: timerWheel.GetDueTimers(TIMER_PROJECTILE_EMISSION))
+        {
+            // The emitter may be gone, or added again since with a timer of its own
+            if (!HasEntity(timer.entity) || !timer.entity.GetRegistry()->IsAlive(timer.entity) ||
+                timer.entity.GetComponent<ProjectileEmitterComponent>().nextEmissionTick != timer.tick)
             {
-                glm::vec2 projectilePosition = transform.position;
-                if (entity.HasComponent<SpriteComponent>())
-                {
-                    const auto sprite = entity.GetComponent<SpriteComponent>();
-                    projectilePosition.x += (transform.scale.x * sprite.width / 2);
-                    projectilePosition.y += (transform.scale.y * sprite.height / 2);
-                }
-                // Add a new projectile entity to the registry
-                Entity projectile = registry->CreateEntity();
-                projectile.AddComponent<TransformComponent>(projectilePosition, glm::vec2(1.0, 1.0), 0.0);
-                projectile.AddComponent<RigidBodyComponent>(projectileEmitter.projectileVelocity);
-                projectile.AddComponent<SpriteComponent>("bullet-image", 4, 4, 4);
-                projectile.AddComponent<BoxColliderComponent>(4, 4);
-                projectile.AddComponent<ProjectileComponent>(projectileEmitter.isFriendly, projectileEmitter.hitPercentDamage, projectileEmitter.projectileDuration);
-
-                projectileEmitter.lastEmissionTime = SDL_GetTicks();
+                continue;
             }
+            Emit(timer.entity, frameClock, timerWheel, projectilePool, broadphase);
+        }
+
+        audioEngine.PlaySpatial(emittedSounds);
+    }
+
+private:
+    // Emitters added since the last update, they get their first timer there
+    std::vector<Entity> addedEmitters;
+    // The sounds of the shots fired this tick, where they were fired
+    std::vector<SpatialSound> emittedSounds;
+    std::vector<BroadphaseHit> targets;
+
+    void Emit(Entity entity, const FrameClock& frameClock, TimerWheel& timerWheel, EntityPool& projectilePool, const IBroadphase& broadphase)
+    {
+        const double millisecs = frameClock.GetMillisecs();
+        auto& projectileEmitter = entity.GetComponent<ProjectileEmitterComponent>();
+        const auto& transform = entity.GetComponent<TransformComponent>();
+
+        glm::vec2 projectilePosition = transform.position;
+        if (entity.HasComponent<SpriteComponent>())
+        {
+            const auto& sprite = entity.GetComponent<SpriteComponent>();
+            projectilePosition.x += (transform.scale.x * sprite.width / 2);
+            projectilePosition.y += (transform.scale.y * sprite.height / 2);
         }
+        projectileEmitter.lastEmissionTime = millisecs;
+        // At mid range the emitter fires as many times less often as its tick divisor
+        const int tickDivisor = entity.HasComponent<SimulationLodComponent>() ? entity.GetComponent<SimulationLodComponent>().tickDivisor : 1;
+        projectileEmitter.nextEmissionTick = timerWheel.Schedule(frameClock.GetTick() + frameClock.GetTicksAfter(projectileEmitter.repeatFrequency * tickDivisor), TIMER_PROJECTILE_EMISSION, entity);
+        const ProjectileEmitterComponent emitter = projectileEmitter;
+
+        glm::vec2 projectileVelocity = emitter.projectileVelocity;
+        if (emitter.targetRange > 0.0f)
+        {
+            targets.clear();
+            const uint32_t hostileLayers = emitter.isFriendly ? COLLISION_LAYER_ENEMY : COLLISION_LAYER_PLAYER;
+            broadphase.QueryNearest(projectilePosition, emitter.targetRange, hostileLayers, 1, targets);
+            if (targets.empty())
+            {
+                return;
+            }
+            const AABB& targetBox = targets.front().box;
+            const glm::vec2 toTarget = glm::vec2((targetBox.minX + targetBox.maxX) / 2, (targetBox.minY + targetBox.maxY) / 2) - projectilePosition;
+            const float distance = glm::length(toTarget);
+            projectileVelocity = distance > 0.0f ? toTarget / distance * glm::length(emitter.projectileVelocity) : emitter.projectileVelocity;
+        }
+        if (emitter.soundAssetHandle != INVALID_ASSET_HANDLE)
+        {
+            emittedSounds.push_back({emitter.soundAssetHandle, projectilePosition, AUDIO_PRIORITY_LOW});
+        }
+
+        // Take a projectile from the pool and set it off, its components are already there
+        Entity projectile = projectilePool.Acquire();
+        auto& projectileTransform = projectile.PatchComponent<TransformComponent>();
+        projectileTransform.position = projectilePosition;
+        projectileTransform.previousPosition = projectilePosition;
+        MovementSystem::SetVelocity(projectile, projectileVelocity);
+        auto& collider = projectile.PatchComponent<BoxColliderComponent>();
+        collider.layer = emitter.isFriendly ? COLLISION_LAYER_FRIENDLY_PROJECTILE : COLLISION_LAYER_ENEMY_PROJECTILE;
+        collider.mask = emitter.isFriendly ? COLLISION_MASK_FRIENDLY_PROJECTILE : COLLISION_MASK_ENEMY_PROJECTILE;
+        auto& projectileComponent = projectile.GetComponent<ProjectileComponent>();
+        projectileComponent.isFriendly = emitter.isFriendly;
+        projectileComponent.hitPercentDamage = emitter.hitPercentDamage;
+        projectileComponent.duration = emitter.projectileDuration;
+        projectileComponent.startTime = millisecs;
+        projectileComponent.isActive = true;
+        // Flies on when the emitter dies, it is pooled and can't die with it
+        projectile.GetRegistry()->SetEntityParent(projectile, entity, ORPHAN_DETACHED);
+        // ProjectileLifecycleSystem gives it back when the timer comes due
+        projectileComponent.expiryTick = timerWheel.Schedule(frameClock.GetTick() + frameClock.GetTicksAfter(emitter.projectileDuration), TIMER_PROJECTILE_EXPIRY, projectile);
     }
 };
 
@@ -2,7 +2,12 @@
 #define PROJECTILELIFECYCLESYSTEM_H
 
 #include "../ECS/ECS.h"
+#include "../ECS/EntityPool.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/RigidBodyComponent.h"
+#include "../Components/BoxColliderComponent.h"
 #include "../Components/ProjectileComponent.h"
+#include "../Clock/TimerWheel.h"
 
 class ProjectileLifecycleSystem: public System
 {
@@ -10,19 +15,32 @@ public:
     ProjectileLifecycleSystem()
     {
         RequireComponent<ProjectileComponent>();
+        // Parking a projectile resets these
+        WritesComponent<ProjectileComponent>();
+        WritesComponent<TransformComponent>();
+        WritesComponent<RigidBodyComponent>();
+        WritesComponent<BoxColliderComponent>();
     }
 
-    void Update()
+    // ProjectileEmitSystem schedules the expiry when it fires, a tick only visits the
+    // projectiles that expire
+    void Update(const TimerWheel& timerWheel, EntityPool& projectilePool)
     {
-        for (auto entity: GetSystemEntities())
+        for (const auto& timer: timerWheel.GetDueTimers(TIMER_PROJECTILE_EXPIRY))
         {
-            auto projectile = entity.GetComponent<ProjectileComponent>();
-
-            // Kill projectiles after they reach their duration limit
-            if (SDL_GetTicks() - static_cast<int>(projectile.startTime > projectile.duration))
+            // The projectile may have been given back and fired again since it was scheduled
+            if (!HasEntity(timer.entity) || !timer.entity.GetRegistry()->IsAlive(timer.entity))
+            {
+                continue;
+            }
+            const auto& projectile = timer.entity.GetComponent<ProjectileComponent>();
+            if (!projectile.isActive || projectile.expiryTick != timer.tick)
             {
-                entity.Kill();
+                continue;
             }
+
+            // Give projectiles back to the pool after they reach their duration limit
+            projectilePool.Release(timer.entity);
         }
     }
 };
@@ -4,10 +4,31 @@
 #include "../ECS/ECS.h"
 #include "../Components/TransformComponent.h"
 #include "../Components/BoxColliderComponent.h"
+#include "../Physics/Broadphase.h"
+#include "../Renderer/RenderCommandList.h"
 #include <SDL2/SDL.h>
+#include <vector>
 
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Render collider system
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The debug view of the colliders. The rectangles under the camera are gathered per color and
+// each color is recorded as one SDL_RenderDrawRects, so thousands of bullets stay cheap to
+// look at. The occupied cells of the broadphase can be drawn under them.
+/////////////////////////////////////////////////////////////////////////////////////////////
 class RenderColliderSystem: public System
 {
+private:
+    std::vector<SDL_Rect> dynamicRects;
+    std::vector<SDL_Rect> staticRects;
+    std::vector<SDL_Rect> cellRects;
+    std::vector<AABB> cells;
+
+    static bool IsOnScreen(const SDL_Rect& rect, const SDL_FRect& camera)
+    {
+        return rect.x + rect.w >= 0 && rect.x < camera.w && rect.y + rect.h >= 0 && rect.y < camera.h;
+    }
+
 public:
     RenderColliderSystem()
     {
@@ -15,24 +36,50 @@ public:
         RequireComponent<BoxColliderComponent>();
     }
 
-    void Update(SDL_Renderer* renderer, const SDL_Rect& camera)
+    // The cells are only drawn with a broadphase given
+    void Update(RenderCommandList& commandList, const SDL_FRect& camera, double interpolation = 1.0, const IBroadphase* broadphase = nullptr)
     {
+        dynamicRects.clear();
+        staticRects.clear();
+        cellRects.clear();
+
+        if (broadphase)
+        {
+            cells.clear();
+            broadphase->GetDebugCells(cells);
+            for (const auto& cell: cells)
+            {
+                const SDL_Rect cellRect = {static_cast<int>(cell.minX - camera.x), static_cast<int>(cell.minY - camera.y), static_cast<int>(cell.maxX - cell.minX), static_cast<int>(cell.maxY - cell.minY)};
+                if (IsOnScreen(cellRect, camera))
+                {
+                    cellRects.push_back(cellRect);
+                }
+            }
+        }
+
         for (auto entity: GetSystemEntities())
         {
-            const auto transform = entity.GetComponent<TransformComponent>();
-            const auto collider = entity.GetComponent<BoxColliderComponent>();
+            const auto& transform = entity.GetComponent<TransformComponent>();
+            const auto& collider = entity.GetComponent<BoxColliderComponent>();
+            const glm::vec2 position = glm::mix(transform.previousPosition, transform.position, static_cast<float>(interpolation));
 
-            SDL_Rect colliderRect = 
+            const SDL_Rect colliderRect =
             {
-                static_cast<int>(transform.position.x + collider.offset.x - camera.x),
-                static_cast<int>(transform.position.y + collider.offset.y - camera.y),
+                static_cast<int>(position.x + collider.offset.x - camera.x),
+                static_cast<int>(position.y + collider.offset.y - camera.y),
                 static_cast<int>(collider.width * transform.scale.x),
                 static_cast<int>(collider.height * transform.scale.y)
             };
-            SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
-            SDL_RenderDrawRect(renderer, &colliderRect);
+            if (IsOnScreen(colliderRect, camera))
+            {
+                (collider.isStatic ? staticRects : dynamicRects).push_back(colliderRect);
+            }
         }
+
+        commandList.AddRects(cellRects, {60, 60, 120, 255});
+        commandList.AddRects(staticRects, {255, 160, 0, 255});
+        commandList.AddRects(dynamicRects, {255, 0, 0, 255});
     }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,81 @@
+#ifndef RENDERHEALTHBARSYSTEM_H
+#define RENDERHEALTHBARSYSTEM_H
+
+#include "../ECS/ECS.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/HealthComponent.h"
+#include "../Components/SpriteComponent.h"
+#include "../Renderer/SpriteBatch.h"
+#include <SDL2/SDL.h>
+#include <algorithm>
+
+// Above the top left of the entity, as wide as its sprite or HEALTH_BAR_WIDTH without one
+const float HEALTH_BAR_WIDTH = 32.0f;
+const float HEALTH_BAR_HEIGHT = 4.0f;
+const float HEALTH_BAR_OFFSET = 8.0f;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Render health bar system
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Draws a bar over every entity with health under the camera. The bars are untextured quads
+// of one sprite batch, so all of them, backgrounds included, are a single draw call.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class RenderHealthBarSystem: public System
+{
+private:
+    SpriteBatch spriteBatch;
+
+    static SDL_Color GetHealthColor(int healthPercentage)
+    {
+        if (healthPercentage >= 70)
+        {
+            return {0, 255, 0, 255};
+        }
+        if (healthPercentage >= 30)
+        {
+            return {255, 255, 0, 255};
+        }
+        return {255, 0, 0, 255};
+    }
+
+public:
+    RenderHealthBarSystem()
+    {
+        RequireComponent<TransformComponent>();
+        RequireComponent<HealthComponent>();
+    }
+
+    void Update(RenderCommandList& commandList, const SDL_FRect& camera, double interpolation = 1.0)
+    {
+        spriteBatch.Begin(commandList);
+        for (auto entity: GetSystemEntities())
+        {
+            const auto& transform = entity.GetComponent<TransformComponent>();
+            const glm::vec2 position = glm::mix(transform.previousPosition, transform.position, static_cast<float>(interpolation));
+            const bool hasSprite = entity.HasComponent<SpriteComponent>();
+            if (hasSprite && entity.GetComponent<SpriteComponent>().isFixed)
+            {
+                continue;
+            }
+            const float width = hasSprite ? entity.GetComponent<SpriteComponent>().width * transform.scale.x : HEALTH_BAR_WIDTH;
+            const float x = position.x - camera.x;
+            const float y = position.y - camera.y - HEALTH_BAR_OFFSET;
+            if (x + width <= 0 || x >= camera.w || y + HEALTH_BAR_HEIGHT <= 0 || y >= camera.h)
+            {
+                continue;
+            }
+
+            const int healthPercentage = std::max(0, std::min(100, entity.GetComponent<HealthComponent>().healthPercentage));
+            spriteBatch.DrawRect({x, y, width, HEALTH_BAR_HEIGHT}, {40, 40, 40, 255});
+            spriteBatch.DrawRect({x, y, width * healthPercentage / 100.0f, HEALTH_BAR_HEIGHT}, GetHealthColor(healthPercentage));
+        }
+        spriteBatch.End();
+    }
+
+    int GetNumDrawCalls() const
+    {
+        return spriteBatch.GetNumDrawCalls();
+    }
+};
+
+#endif
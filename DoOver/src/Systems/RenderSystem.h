@@ -5,10 +5,173 @@
 #include "../Components/TransformComponent.h"
 #include "../Components/SpriteComponent.h"
 #include "../AssetStore/AssetStore.h"
+#include "../Components/RigidBodyComponent.h"
+#include "../Renderer/SpriteBatch.h"
+#include "../Renderer/RenderQueue.h"
+#include "../Renderer/SpriteCullBatch.h"
+#include "../Renderer/Viewport.h"
+#include "../Components/BoxColliderComponent.h"
+#include "../Physics/StaticColliderGrid.h"
 #include <SDL2/SDL.h>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
 
 class RenderSystem: public System
 {
+private:
+    // What a sprite needs to be drawn, without copying the components
+    struct RenderableSprite
+    {
+        int entityId;
+        int drawOrder;
+        AssetHandle assetHandle;
+        SDL_Texture* texture;
+        SDL_Rect srcRect;
+        SDL_FRect dstRect;
+        float rotation;
+        SDL_RendererFlip flip;
+    };
+
+    // [viewport] -> the sprites it shows
+    std::vector<std::vector<RenderableSprite>> viewportSprites;
+    // The fixed sprites (e.g. the radar), drawn over the world by RenderWidgets
+    std::vector<RenderableSprite> renderableWidgets;
+    std::vector<RenderableSprite> sortScratch;
+    // The sprites that may be on a screen, resolved once and culled against every viewport
+    // at once by the batch, at the same index
+    std::vector<RenderableSprite> candidateSprites;
+    SpriteCullBatch cullBatch;
+    std::vector<int> visibleIndices;
+    RenderQueue renderQueue;
+    SpriteBatch spriteBatch;
+    SpriteBatch widgetBatch;
+    int numDrawCalls = 0;
+    int numSprites = 0;
+
+    // The commit of the component changes gone through last
+    uint32_t changeVersion = 0;
+    std::vector<Entity> changedEntities;
+
+    static const int STATIC_SPRITE_CELL_SIZE = 256;
+
+    // Sprites that never move (no rigid body, e.g. the tiles) are kept in a grid so only the
+    // ones under the camera are visited, the moving and fixed ones are culled one by one
+    std::vector<Entity> dynamicEntities;
+    std::vector<int> entityIdToDynamicIndex;
+    StaticColliderGrid staticSprites = StaticColliderGrid(STATIC_SPRITE_CELL_SIZE);
+    bool areStaticSpritesDirty = false;
+    std::vector<int> visibleStaticIndices;
+
+    static bool IsStaticSprite(Entity entity)
+    {
+        return !entity.HasComponent<RigidBodyComponent>() && !entity.GetComponent<SpriteComponent>().isFixed;
+    }
+
+    bool IsDynamic(Entity entity) const
+    {
+        return entity.GetId() < static_cast<int>(entityIdToDynamicIndex.size()) && entityIdToDynamicIndex[entity.GetId()] != -1;
+    }
+
+    void AddDynamicEntity(Entity entity)
+    {
+        if (entity.GetId() >= static_cast<int>(entityIdToDynamicIndex.size()))
+        {
+            entityIdToDynamicIndex.resize(entity.GetId() + 1, -1);
+        }
+        entityIdToDynamicIndex[entity.GetId()] = dynamicEntities.size();
+        dynamicEntities.push_back(entity);
+    }
+
+    // Swapped with the last one so the removal is O(1)
+    void RemoveDynamicEntity(Entity entity)
+    {
+        const int index = entityIdToDynamicIndex[entity.GetId()];
+        const Entity last = dynamicEntities.back();
+        dynamicEntities[index] = last;
+        entityIdToDynamicIndex[last.GetId()] = index;
+        dynamicEntities.pop_back();
+        entityIdToDynamicIndex[entity.GetId()] = -1;
+    }
+
+    void RebuildStaticSprites()
+    {
+        std::vector<StaticCollider> sprites;
+        for (auto entity: GetSystemEntities())
+        {
+            if (!IsStaticSprite(entity))
+            {
+                continue;
+            }
+            const auto& transform = entity.GetComponent<TransformComponent>();
+            const auto& sprite = entity.GetComponent<SpriteComponent>();
+            const AABB box(transform.position.x, transform.position.y, transform.position.x + sprite.width * transform.scale.x, transform.position.y + sprite.height * transform.scale.y);
+            sprites.push_back({entity, box, COLLISION_MASK_ALL, COLLISION_MASK_ALL});
+        }
+        staticSprites.Build(std::move(sprites));
+        areStaticSpritesDirty = false;
+    }
+
+    // Only the sprites changed since the last frame are looked at: a static one that moved or
+    // was resized puts the grid out of date, one that changed layer the draw order
+    void ApplyChanges(const Registry& registry)
+    {
+        changedEntities.clear();
+        const bool hasTransformChanges = registry.GetChangedEntities<TransformComponent>(changeVersion, changedEntities);
+        const bool hasSpriteChanges = registry.GetChangedEntities<SpriteComponent>(changeVersion, changedEntities);
+        changeVersion = registry.GetChangeVersion();
+        if (!hasTransformChanges || !hasSpriteChanges)
+        {
+            areStaticSpritesDirty = true;
+            renderQueue.MarkDirty();
+            return;
+        }
+        for (auto entity: changedEntities)
+        {
+            if (!HasEntity(entity) || !registry.IsAlive(entity))
+            {
+                continue;
+            }
+            areStaticSpritesDirty = areStaticSpritesDirty || IsStaticSprite(entity);
+            if (!renderQueue.IsInLayer(entity, entity.GetComponent<SpriteComponent>().zIndex))
+            {
+                renderQueue.MarkDirty();
+            }
+        }
+    }
+
+    // Resolved once for all the viewports, it is culled against them by the batch
+    void AddRenderableSprite(Entity entity, std::unique_ptr<AssetStore>& assetStore, double interpolation)
+    {
+        const auto& transform = entity.GetComponent<TransformComponent>();
+        const auto& sprite = entity.GetComponent<SpriteComponent>();
+        const glm::vec2 position = glm::mix(transform.previousPosition, transform.position, static_cast<float>(interpolation));
+
+        RenderableSprite renderableSprite;
+        renderableSprite.entityId = entity.GetId();
+        renderableSprite.drawOrder = renderQueue.GetDrawOrder(entity.GetId());
+        renderableSprite.rotation = transform.rotation;
+        renderableSprite.flip = sprite.flip;
+        // Packed sprites sample their rectangle of the atlas page, streamed ones of the mip there is
+        const auto& region = assetStore->GetTextureRegion(sprite.assetHandle);
+        renderableSprite.assetHandle = sprite.assetHandle;
+        renderableSprite.texture = region.texture;
+        renderableSprite.srcRect = region.GetSrcRect(sprite.srcRect);
+        const float width = sprite.width * transform.scale.x;
+        const float height = sprite.height * transform.scale.y;
+
+        // The fixed sprites are placed on the window, the few there are go without culling
+        if (sprite.isFixed)
+        {
+            renderableSprite.dstRect = {static_cast<float>(static_cast<int>(position.x)), static_cast<float>(static_cast<int>(position.y)), width, height};
+            renderableWidgets.push_back(renderableSprite);
+            assetStore->UseTexture(sprite.assetHandle);
+            return;
+        }
+        candidateSprites.push_back(renderableSprite);
+        cullBatch.Add(position, width, height, renderableSprite.rotation);
+    }
+
 public:
     RenderSystem()
     {
@@ -16,60 +179,151 @@ public:
         RequireComponent<SpriteComponent>();
     }
 
-    void Update(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, SDL_Rect& camera) 
+    void OnEntityAdded(Entity entity) override
     {
-        // Create a vector with both Sprite and Transform component of all entities
-        struct RenderableEntity 
+        renderQueue.MarkDirty();
+        if (IsStaticSprite(entity))
         {
-            TransformComponent transformComponent;
-            SpriteComponent spriteComponent;
-        };
+            areStaticSpritesDirty = true;
+            return;
+        }
+        AddDynamicEntity(entity);
+    }
 
-        std::vector<RenderableEntity> renderableEntities; 
-        for (auto entity: GetSystemEntities()) 
+    void OnEntityRemoved(Entity entity) override
+    {
+        renderQueue.MarkDirty();
+        if (!IsDynamic(entity))
         {
-            RenderableEntity renderableEntity;
-            renderableEntity.spriteComponent = entity.GetComponent<SpriteComponent>();
-            renderableEntity.transformComponent = entity.GetComponent<TransformComponent>();
-            renderableEntities.emplace_back(renderableEntity);
+            areStaticSpritesDirty = true;
+            return;
         }
+        RemoveDynamicEntity(entity);
+    }
 
-        // Sort the vector by the z-index value
-        std::sort(renderableEntities.begin(), renderableEntities.end(), [](const RenderableEntity& a, const RenderableEntity& b) 
+    // A sprite that gains or loses its rigid body stays in the system, the registry tells it
+    // to move between the grid and the dynamic sprites
+    void ObserveRigidBodies(Registry& registry)
+    {
+        registry.ObserveComponent<RigidBodyComponent>([this](const std::vector<Entity>& entities)
         {
-            return a.spriteComponent.zIndex < b.spriteComponent.zIndex;
+            for (auto entity: entities)
+            {
+                if (HasEntity(entity) && !IsDynamic(entity))
+                {
+                    AddDynamicEntity(entity);
+                    areStaticSpritesDirty = true;
+                }
+            }
+        },
+        [this](const std::vector<Entity>& entities)
+        {
+            for (auto entity: entities)
+            {
+                // A killed entity leaves the system right after
+                if (HasEntity(entity) && IsDynamic(entity) && IsStaticSprite(entity))
+                {
+                    RemoveDynamicEntity(entity);
+                    areStaticSpritesDirty = true;
+                }
+            }
         });
+    }
+
+    // Culls the sprites for all the viewports in one pass over the grid, Render then draws the
+    // ones of each viewport. interpolation is how far the frame is between the last two
+    // simulation ticks ([0, 1]).
+    void Update(const Registry& registry, std::unique_ptr<AssetStore>& assetStore, const std::vector<Viewport>& viewports, double interpolation = 1.0)
+    {
+        ApplyChanges(registry);
+        if (areStaticSpritesDirty)
+        {
+            RebuildStaticSprites();
+        }
+        if (renderQueue.IsDirty())
+        {
+            renderQueue.Rebuild(GetSystemEntities());
+        }
 
-        // Loop all entities that the system is interested in
-        for (auto entity: renderableEntities) 
+        viewportSprites.resize(viewports.size());
+        for (auto& renderableSprites: viewportSprites)
         {
-            const auto transform = entity.transformComponent;
-            const auto sprite = entity.spriteComponent;
+            renderableSprites.clear();
+        }
+        renderableWidgets.clear();
+        candidateSprites.clear();
+        cullBatch.Clear();
+        numDrawCalls = 0;
+        numSprites = 0;
 
-            // Set the source rectangle of our original sprite texture
-            SDL_Rect srcRect = sprite.srcRect;
+        // The static sprites under any of the cameras, each is then tested against every camera
+        const SDL_Rect bounds = GetCamerasBounds(viewports);
+        visibleStaticIndices.clear();
+        staticSprites.Query(AABB(bounds.x, bounds.y, bounds.x + bounds.w, bounds.y + bounds.h), COLLISION_MASK_ALL, COLLISION_MASK_ALL, visibleStaticIndices);
+        for (auto index: visibleStaticIndices)
+        {
+            AddRenderableSprite(staticSprites.GetCollider(index).entity, assetStore, interpolation);
+        }
+        for (auto entity: dynamicEntities)
+        {
+            AddRenderableSprite(entity, assetStore, interpolation);
+        }
 
-            // Set the destination rectangle with the x,y position to be rendered
-            SDL_Rect dstRect = 
+        for (size_t i = 0; i < viewports.size(); i++)
+        {
+            visibleIndices.clear();
+            cullBatch.Cull(viewports[i].camera, visibleIndices);
+            for (auto index: visibleIndices)
             {
-                static_cast<int>(transform.position.x - (sprite.isFixed ? 0 : camera.x)),
-                static_cast<int>(transform.position.y - (sprite.isFixed ? 0 : camera.y)),
-                static_cast<int>(sprite.width * transform.scale.x),
-                static_cast<int>(sprite.height * transform.scale.y)
-            };
-
-            // Draw the texture on the destination renderer
-            SDL_RenderCopyEx(
-                renderer,
-                assetStore->GetTexture(sprite.assetId),
-                &srcRect,
-                &dstRect,
-                transform.rotation,
-                NULL,
-                SDL_FLIP_NONE
-            );
+                // Not rounded to the pixel, the moving sprites would jitter against the smooth camera
+                RenderableSprite& renderableSprite = viewportSprites[i].emplace_back(candidateSprites[index]);
+                renderableSprite.dstRect = cullBatch.GetDstRect(index);
+                // Only the streamed textures of the sprites on screen are paged in
+                assetStore->UseTexture(renderableSprite.assetHandle);
+            }
+        }
+    }
+
+    // The sprites of a viewport, into the viewport set on the command list
+    void Render(RenderCommandList& commandList, int viewportIndex)
+    {
+        auto& renderableSprites = viewportSprites[viewportIndex];
+        // Draw by layer, grouped by asset inside a layer so the sprites sharing a texture are batched together
+        RenderQueue::SortByDrawOrder(renderableSprites, sortScratch);
+
+        spriteBatch.Begin(commandList);
+        for (const auto& renderableSprite: renderableSprites)
+        {
+            spriteBatch.Draw(renderableSprite.texture, renderableSprite.srcRect, renderableSprite.dstRect, renderableSprite.rotation, {255, 255, 255, 255}, renderableSprite.flip);
+        }
+        spriteBatch.End();
+        numDrawCalls += spriteBatch.GetNumDrawCalls();
+        numSprites += spriteBatch.GetNumSprites();
+    }
+
+    // The fixed sprites gathered by the last Update, in the HUD pass after the world
+    void RenderWidgets(RenderCommandList& commandList)
+    {
+        RenderQueue::SortByDrawOrder(renderableWidgets, sortScratch);
+        widgetBatch.Begin(commandList);
+        for (const auto& renderableWidget: renderableWidgets)
+        {
+            widgetBatch.Draw(renderableWidget.texture, renderableWidget.srcRect, renderableWidget.dstRect, renderableWidget.rotation, {255, 255, 255, 255}, renderableWidget.flip);
         }
+        widgetBatch.End();
+        numDrawCalls += widgetBatch.GetNumDrawCalls();
+        numSprites += widgetBatch.GetNumSprites();
+    }
+
+    int GetNumDrawCalls() const
+    {
+        return numDrawCalls;
+    }
+
+    int GetNumSprites() const
+    {
+        return numSprites;
     }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,161 @@
+#ifndef RENDERTEXTSYSTEM_H
+#define RENDERTEXTSYSTEM_H
+
+#include "../ECS/ECS.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/TextLabelComponent.h"
+#include "../AssetStore/AssetStore.h"
+#include "../Renderer/SpriteBatch.h"
+#include "../Renderer/TextRenderer.h"
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Render text system
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Draws the text labels over the sprites. Each label keeps the quads it was laid out into,
+// they are only laid out again when the label was patched since the last frame (or once its
+// font is loaded), so a label that doesn't change costs the drawing of its quads alone.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class RenderTextSystem: public System
+{
+private:
+    struct CachedLabel
+    {
+        std::vector<GlyphQuad> quads;
+        // Laid out in pixels of the font, before the scale
+        SDL_FPoint size = {0.0f, 0.0f};
+        bool isDirty = true;
+    };
+
+    // [entity id] -> the label laid out
+    std::vector<CachedLabel> cachedLabels;
+    SpriteBatch spriteBatch;
+
+    uint32_t changeVersion = 0;
+    std::vector<Entity> changedEntities;
+    int numLayouts = 0;
+
+    CachedLabel& GetCachedLabel(Entity entity)
+    {
+        if (entity.GetId() >= static_cast<int>(cachedLabels.size()))
+        {
+            cachedLabels.resize(entity.GetId() + 1);
+        }
+        return cachedLabels[entity.GetId()];
+    }
+
+    void ApplyChanges(const Registry& registry)
+    {
+        changedEntities.clear();
+        const bool hasChanges = registry.GetChangedEntities<TextLabelComponent>(changeVersion, changedEntities);
+        changeVersion = registry.GetChangeVersion();
+        if (!hasChanges)
+        {
+            for (auto entity: GetSystemEntities())
+            {
+                GetCachedLabel(entity).isDirty = true;
+            }
+            return;
+        }
+        for (auto entity: changedEntities)
+        {
+            if (HasEntity(entity) && registry.IsAlive(entity))
+            {
+                GetCachedLabel(entity).isDirty = true;
+            }
+        }
+    }
+
+    // The labels of the world, or the fixed ones placed on the window
+    void DrawLabels(RenderCommandList& commandList, const AssetStore& assetStore, const SDL_FRect& camera, double interpolation, bool isFixed)
+    {
+        spriteBatch.Begin(commandList);
+        for (auto entity: GetSystemEntities())
+        {
+            const auto& label = entity.GetComponent<TextLabelComponent>();
+            if (label.isFixed != isFixed)
+            {
+                continue;
+            }
+            const FontAtlas* font = assetStore.GetFont(label.fontAssetHandle);
+            if (!font)
+            {
+                continue;
+            }
+            CachedLabel& cachedLabel = GetCachedLabel(entity);
+            if (cachedLabel.isDirty)
+            {
+                cachedLabel.quads.clear();
+                cachedLabel.size = font->Layout(label.text, cachedLabel.quads);
+                cachedLabel.isDirty = false;
+                numLayouts++;
+            }
+
+            const auto& transform = entity.GetComponent<TransformComponent>();
+            const glm::vec2 position = glm::mix(transform.previousPosition, transform.position, static_cast<float>(interpolation)) + label.offset;
+            const float x = position.x - camera.x;
+            const float y = position.y - camera.y;
+            if (x + cachedLabel.size.x * label.scale <= 0 || x >= camera.w || y + cachedLabel.size.y * label.scale <= 0 || y >= camera.h)
+            {
+                continue;
+            }
+            TextRenderer::DrawQuads(spriteBatch, *font, cachedLabel.quads, x, y, label.scale, label.color);
+        }
+        spriteBatch.End();
+    }
+
+public:
+    RenderTextSystem()
+    {
+        RequireComponent<TransformComponent>();
+        RequireComponent<TextLabelComponent>();
+    }
+
+    void OnEntityAdded(Entity entity) override
+    {
+        GetCachedLabel(entity).isDirty = true;
+    }
+
+    void OnEntityRemoved(Entity entity) override
+    {
+        // Keeps the capacity of the quads for the next entity with this id
+        CachedLabel& cachedLabel = GetCachedLabel(entity);
+        cachedLabel.quads.clear();
+        cachedLabel.isDirty = true;
+    }
+
+    // Takes the labels patched since the last frame, once per frame before they are drawn
+    void Update(const Registry& registry)
+    {
+        ApplyChanges(registry);
+        numLayouts = 0;
+    }
+
+    // The labels of the world under the camera of a viewport
+    void Render(RenderCommandList& commandList, const AssetStore& assetStore, const SDL_FRect& camera, double interpolation = 1.0)
+    {
+        DrawLabels(commandList, assetStore, camera, interpolation, false);
+    }
+
+    // The fixed labels, on the whole window over all the viewports
+    void RenderFixed(RenderCommandList& commandList, const AssetStore& assetStore, int windowWidth, int windowHeight, double interpolation = 1.0)
+    {
+        const SDL_FRect window = {0.0f, 0.0f, static_cast<float>(windowWidth), static_cast<float>(windowHeight)};
+        DrawLabels(commandList, assetStore, window, interpolation, true);
+    }
+
+    // Labels laid out in the last frame, none when no text changed
+    int GetNumLayouts() const
+    {
+        return numLayouts;
+    }
+
+    int GetNumDrawCalls() const
+    {
+        return spriteBatch.GetNumDrawCalls();
+    }
+};
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef SCRIPTSYSTEM_H
+#define SCRIPTSYSTEM_H
+
+#include "../ECS/ECS.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/RigidBodyComponent.h"
+#include "../Components/ScriptComponent.h"
+#include "../Scripting/ScriptEngine.h"
+
+class ScriptSystem: public System
+{
+private:
+    // [script handle] -> entities running the script, gathered again on every tick
+    std::vector<ScriptBatch> batches;
+
+    // Entities that joined or left the system since the last update, their behaviours are
+    // started and stopped there since the hooks have no script engine at hand
+    std::vector<Entity> addedEntities;
+    std::vector<Entity> removedEntities;
+    // [entity id] -> behaviour id, -1 if the entity runs none
+    std::vector<int> entityIdToBehaviour;
+    // [behaviour id] -> entity running it
+    std::vector<Entity> behaviourEntities;
+
+    void StartBehaviours(ScriptEngine& scriptEngine)
+    {
+        for (auto entity: removedEntities)
+        {
+            const int entityId = entity.GetId();
+            if (entityId < static_cast<int>(entityIdToBehaviour.size()) && entityIdToBehaviour[entityId] != -1)
+            {
+                scriptEngine.StopBehaviour(entityIdToBehaviour[entityId]);
+                entityIdToBehaviour[entityId] = -1;
+            }
+        }
+        removedEntities.clear();
+
+        for (auto entity: addedEntities)
+        {
+            // Added and removed again before the update, or listed twice
+            const int entityId = entity.GetId();
+            if (!HasEntity(entity) || (entityId < static_cast<int>(entityIdToBehaviour.size()) && entityIdToBehaviour[entityId] != -1))
+            {
+                continue;
+            }
+            const int behaviourId = scriptEngine.StartBehaviour(entity.GetComponent<ScriptComponent>().scriptHandle, entityId);
+            if (behaviourId == -1)
+            {
+                continue;
+            }
+            if (entityId >= static_cast<int>(entityIdToBehaviour.size()))
+            {
+                entityIdToBehaviour.resize(entityId + 1, -1);
+            }
+            entityIdToBehaviour[entityId] = behaviourId;
+            if (behaviourId >= static_cast<int>(behaviourEntities.size()))
+            {
+                behaviourEntities.resize(behaviourId + 1, entity);
+            }
+            behaviourEntities[behaviourId] = entity;
+        }
+        addedEntities.clear();
+    }
+
+public:
+    ScriptSystem()
+    {
+        RequireComponent<TransformComponent>();
+        RequireComponent<RigidBodyComponent>();
+        RequireComponent<ScriptComponent>();
+        ReadsComponent<ScriptComponent>();
+        WritesComponent<TransformComponent>();
+        WritesComponent<RigidBodyComponent>();
+    }
+
+    void OnEntityAdded(Entity entity) override
+    {
+        addedEntities.push_back(entity);
+    }
+
+    void OnEntityRemoved(Entity entity) override
+    {
+        removedEntities.push_back(entity);
+    }
+
+    // One Lua call per script instead of one per entity, then the behaviours due this tick
+    void Update(ScriptEngine& scriptEngine, double deltaTime)
+    {
+        StartBehaviours(scriptEngine);
+
+        for (auto& batch: batches)
+        {
+            batch.Clear();
+        }
+        for (auto entity: GetSystemEntities())
+        {
+            const AssetHandle scriptHandle = entity.GetComponent<ScriptComponent>().scriptHandle;
+            if (scriptHandle >= static_cast<int>(batches.size()))
+            {
+                batches.resize(scriptHandle + 1);
+            }
+            batches[scriptHandle].Add(entity.GetId(), entity.PatchComponent<TransformComponent>(), entity.PatchComponent<RigidBodyComponent>());
+        }
+        for (int scriptHandle = 0; scriptHandle < static_cast<int>(batches.size()); scriptHandle++)
+        {
+            if (batches[scriptHandle].GetSize() > 0)
+            {
+                scriptEngine.RunUpdate(scriptHandle, batches[scriptHandle], deltaTime);
+            }
+        }
+
+        scriptEngine.RunBehaviours(deltaTime, [this](int behaviourId, ScriptEntity& scriptEntity)
+        {
+            const Entity entity = behaviourEntities[behaviourId];
+            if (!HasEntity(entity))
+            {
+                return false;
+            }
+            scriptEntity.transform = &entity.PatchComponent<TransformComponent>();
+            scriptEntity.rigidBody = &entity.PatchComponent<RigidBodyComponent>();
+            return true;
+        });
+    }
+};
+
+#endif /* SCRIPTSYSTEM_H */
@@ -0,0 +1,81 @@
+#ifndef SPATIALSORTSYSTEM_H
+#define SPATIALSORTSYSTEM_H
+
+#include "../ECS/ECS.h"
+#include "../Components/TransformComponent.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Seconds of simulation between two sorts, the entities drift apart slowly
+const double SPATIAL_SORT_DEFAULT_SECONDS = 10.0;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Spatial sort system
+/////////////////////////////////////////////////////////////////////////////////////////////
+// As entities are created, killed and move around, the order they are stored in has less
+// and less to do with where they are, and the loops that go from an entity to its neighbours
+// (the broadphase, the culling, the AI) jump around in memory. Every now and then this puts
+// the stored components in the Z-order (Morton code) of the entity positions: the positions
+// are quantized to 16 bits each over the bounds of the entities and their bits interleaved,
+// so the entities close in the world are mostly close in memory. The entities without a
+// transform keep their place after the others.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class SpatialSortSystem: public System
+{
+private:
+    // [entity id] -> Morton code of its position, reused by every sort
+    std::vector<uint32_t> keys;
+
+    // The 16 bits of value spread to the even bits
+    static uint32_t SpreadBits(uint32_t value)
+    {
+        value &= 0xFFFF;
+        value = (value | (value << 8)) & 0x00FF00FF;
+        value = (value | (value << 4)) & 0x0F0F0F0F;
+        value = (value | (value << 2)) & 0x33333333;
+        value = (value | (value << 1)) & 0x55555555;
+        return value;
+    }
+
+public:
+    SpatialSortSystem()
+    {
+        RequireComponent<TransformComponent>();
+    }
+
+    static uint32_t GetMortonCode(uint32_t x, uint32_t y)
+    {
+        return SpreadBits(x) | (SpreadBits(y) << 1);
+    }
+
+    // Between two ticks, on the thread that updates the registry
+    void Update(Registry& registry)
+    {
+        const auto& entities = GetSystemEntities();
+        if (entities.size() < 2)
+        {
+            return;
+        }
+        glm::vec2 min(entities[0].GetComponent<TransformComponent>().position);
+        glm::vec2 max(min);
+        for (auto entity: entities)
+        {
+            const glm::vec2& position = entity.GetComponent<TransformComponent>().position;
+            min = glm::min(min, position);
+            max = glm::max(max, position);
+        }
+        const glm::vec2 scale = 65535.0f / glm::max(max - min, glm::vec2(1.0f));
+
+        keys.assign(registry.GetNumEntityIds(), UINT32_MAX);
+        for (auto entity: entities)
+        {
+            const glm::vec2 cell = glm::clamp((entity.GetComponent<TransformComponent>().position - min) * scale, glm::vec2(0.0f), glm::vec2(65535.0f));
+            keys[entity.GetId()] = GetMortonCode(static_cast<uint32_t>(cell.x), static_cast<uint32_t>(cell.y));
+        }
+        registry.SortEntities(keys);
+    }
+};
+
+#endif
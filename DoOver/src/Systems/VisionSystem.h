@@ -0,0 +1,45 @@
+#ifndef VISIONSYSTEM_H
+#define VISIONSYSTEM_H
+
+#include "../ECS/ECS.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/VisionComponent.h"
+#include "../Tilemap/FogOfWar.h"
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Vision system
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Lifts the fog of war around the entities with a vision. Their cells are gathered each
+// tick, the fog only stamps its cells again when one of them changed.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class VisionSystem: public System
+{
+private:
+    std::vector<FogObserver> observers;
+
+public:
+    VisionSystem()
+    {
+        RequireComponent<TransformComponent>();
+        RequireComponent<VisionComponent>();
+        ReadsComponent<TransformComponent>();
+        ReadsComponent<VisionComponent>();
+    }
+
+    void Update(FogOfWar& fogOfWar)
+    {
+        if (!fogOfWar.IsEnabled())
+        {
+            return;
+        }
+        observers.clear();
+        for (auto entity: GetSystemEntities())
+        {
+            observers.push_back(fogOfWar.GetObserver(entity.GetComponent<TransformComponent>().position, entity.GetComponent<VisionComponent>().radius));
+        }
+        fogOfWar.Update(observers);
+    }
+};
+
+#endif
@@ -0,0 +1,142 @@
+#include "FogOfWar.h"
+#include "../Logger/Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+FogOfWar::~FogOfWar()
+{
+    Clear();
+}
+
+void FogOfWar::Reset(int mapWidth, int mapHeight, float cellSize)
+{
+    Clear();
+    if (mapWidth <= 0 || mapHeight <= 0 || cellSize <= 0.0f)
+    {
+        return;
+    }
+    this->cellSize = cellSize;
+    numCols = static_cast<int>(std::ceil(mapWidth / cellSize));
+    numRows = static_cast<int>(std::ceil(mapHeight / cellSize));
+    cells.assign(numCols * numRows, FOG_UNEXPLORED);
+    isTextureDirty = true;
+}
+
+void FogOfWar::Clear()
+{
+    ReleaseTexture();
+    cells.clear();
+    observers.clear();
+    pixels.clear();
+    numCols = 0;
+    numRows = 0;
+}
+
+void FogOfWar::ReleaseTexture()
+{
+    SDL_DestroyTexture(texture);
+    texture = nullptr;
+    isTextureDirty = true;
+}
+
+FogObserver FogOfWar::GetObserver(glm::vec2 position, float radius) const
+{
+    FogObserver observer;
+    observer.col = std::max(0, std::min(numCols - 1, static_cast<int>(std::floor(position.x / cellSize))));
+    observer.row = std::max(0, std::min(numRows - 1, static_cast<int>(std::floor(position.y / cellSize))));
+    observer.radius = std::max(0, static_cast<int>(std::ceil(radius / cellSize)));
+    return observer;
+}
+
+void FogOfWar::StampDisc(const FogObserver& observer, FogState state)
+{
+    const int radiusSquared = observer.radius * observer.radius;
+    const int minRow = std::max(0, observer.row - observer.radius);
+    const int maxRow = std::min(numRows - 1, observer.row + observer.radius);
+    for (int row = minRow; row <= maxRow; row++)
+    {
+        // The half width of the disc on this row
+        const int dy = row - observer.row;
+        const int halfWidth = static_cast<int>(std::sqrt(static_cast<float>(radiusSquared - dy * dy)));
+        const int minCol = std::max(0, observer.col - halfWidth);
+        const int maxCol = std::min(numCols - 1, observer.col + halfWidth);
+        for (int col = minCol; col <= maxCol; col++)
+        {
+            cells[row * numCols + col] = state;
+        }
+    }
+}
+
+bool FogOfWar::Update(const std::vector<FogObserver>& observers)
+{
+    if (cells.empty() || observers == this->observers)
+    {
+        return false;
+    }
+    // What was in sight is explored, then the discs in sight now are stamped over it
+    for (const auto& observer: this->observers)
+    {
+        StampDisc(observer, FOG_EXPLORED);
+    }
+    for (const auto& observer: observers)
+    {
+        StampDisc(observer, FOG_VISIBLE);
+    }
+    this->observers = observers;
+    isTextureDirty = true;
+    return true;
+}
+
+bool FogOfWar::IsVisible(glm::vec2 position) const
+{
+    if (cells.empty())
+    {
+        return true;
+    }
+    const int col = static_cast<int>(std::floor(position.x / cellSize));
+    const int row = static_cast<int>(std::floor(position.y / cellSize));
+    if (col < 0 || row < 0 || col >= numCols || row >= numRows)
+    {
+        return false;
+    }
+    return cells[row * numCols + col] == FOG_VISIBLE;
+}
+
+void FogOfWar::Upload(SDL_Renderer* renderer)
+{
+    if (cells.empty() || !isTextureDirty)
+    {
+        return;
+    }
+    if (!texture)
+    {
+        texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, numCols, numRows);
+        if (!texture)
+        {
+            Logger::Err("Unable to create the fog of war texture: " + std::string(SDL_GetError()));
+            return;
+        }
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+        // One texel per cell, blended with its neighbours once stretched over the map
+        SDL_SetTextureScaleMode(texture, SDL_ScaleModeLinear);
+    }
+
+    pixels.resize(cells.size());
+    for (size_t i = 0; i < cells.size(); i++)
+    {
+        const Uint8 alpha = cells[i] == FOG_VISIBLE ? 0 : cells[i] == FOG_EXPLORED ? FOG_EXPLORED_ALPHA : FOG_UNEXPLORED_ALPHA;
+        pixels[i] = {0, 0, 0, alpha};
+    }
+    SDL_UpdateTexture(texture, NULL, pixels.data(), numCols * sizeof(SDL_Color));
+    isTextureDirty = false;
+}
+
+void FogOfWar::Render(RenderCommandList& commandList, const SDL_FRect& camera) const
+{
+    if (!texture)
+    {
+        return;
+    }
+    commandList.AddCopy(texture, {-camera.x, -camera.y, numCols * cellSize, numRows * cellSize});
+}
@@ -0,0 +1,82 @@
+#ifndef FOGOFWAR_H
+#define FOGOFWAR_H
+
+#include "../Renderer/RenderCommandList.h"
+#include <SDL2/SDL.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+// How dark each state of a cell is drawn
+const Uint8 FOG_UNEXPLORED_ALPHA = 230;
+const Uint8 FOG_EXPLORED_ALPHA = 140;
+
+enum FogState : uint8_t
+{
+    FOG_UNEXPLORED,
+    // Seen before, not in sight anymore
+    FOG_EXPLORED,
+    FOG_VISIBLE
+};
+
+// Who lifts the fog around it, in cells
+struct FogObserver
+{
+    int col;
+    int row;
+    int radius;
+
+    bool operator==(const FogObserver& other) const { return col == other.col && row == other.row && radius == other.radius; }
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Fog of war
+/////////////////////////////////////////////////////////////////////////////////////////////
+// What the observers see of the map, one cell per tile. The cells are only stamped again
+// when an observer moves to another cell, and only the discs of the observers change. The
+// grid is uploaded to a texture of one texel per cell, stretched over the map with linear
+// filtering: the frame draws a single copy with soft edges, with no work per pixel.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class FogOfWar
+{
+private:
+    int numCols = 0;
+    int numRows = 0;
+    // In world pixels
+    float cellSize = 0.0f;
+    // [row * numCols + col]
+    std::vector<FogState> cells;
+    // As they were stamped last
+    std::vector<FogObserver> observers;
+    bool isTextureDirty = false;
+    SDL_Texture* texture = nullptr;
+    std::vector<SDL_Color> pixels;
+
+    // Sets the cells of the disc that are on the map
+    void StampDisc(const FogObserver& observer, FogState state);
+
+public:
+    FogOfWar() = default;
+    ~FogOfWar();
+
+    // Covers a map of this size in world pixels, unexplored
+    void Reset(int mapWidth, int mapHeight, float cellSize);
+    // Releases the grid and the texture, the fog is off until the next reset
+    void Clear();
+    // Drops the texture, e.g. once the render device is lost, the next upload creates it again
+    void ReleaseTexture();
+
+    bool IsEnabled() const { return !cells.empty(); }
+    // The cell of a position in world pixels, clamped to the map
+    FogObserver GetObserver(glm::vec2 position, float radius) const;
+
+    // Returns false when no observer changed cell, the cells are left as they are
+    bool Update(const std::vector<FogObserver>& observers);
+    bool IsVisible(glm::vec2 position) const;
+
+    // Writes the cells changed since the last upload into the texture, on the renderer's thread
+    void Upload(SDL_Renderer* renderer);
+    // Over the world drawn through the camera
+    void Render(RenderCommandList& commandList, const SDL_FRect& camera) const;
+};
+
+#endif
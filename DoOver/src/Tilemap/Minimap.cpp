@@ -0,0 +1,123 @@
+#include "Minimap.h"
+#include "../Logger/Logger.h"
+#include "../Components/BoxColliderComponent.h"
+#include <algorithm>
+#include <string>
+
+Minimap::~Minimap()
+{
+    Clear();
+}
+
+void Minimap::Update(SDL_Renderer* renderer, const Tilemap& tilemap)
+{
+    if (tilemap.GetWidth() <= 0 || tilemap.GetHeight() <= 0)
+    {
+        return;
+    }
+    const bool isCreated = !texture;
+    if (isCreated)
+    {
+        mapWidth = tilemap.GetWidth();
+        mapHeight = tilemap.GetHeight();
+        scale = static_cast<float>(MINIMAP_WIDTH) / tilemap.GetWidth();
+        width = MINIMAP_WIDTH;
+        height = std::max(1, static_cast<int>(tilemap.GetHeight() * scale));
+        texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+        if (!texture)
+        {
+            Logger::Err("Unable to create the minimap texture: " + std::string(SDL_GetError()));
+            return;
+        }
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    }
+    else if (drawnBakeVersion == tilemap.GetBakeVersion())
+    {
+        return;
+    }
+
+    // The chunks already on the cache are drawn over, the ones streamed out are kept
+    SDL_Texture* previousTarget = SDL_GetRenderTarget(renderer);
+    SDL_SetRenderTarget(renderer, texture);
+    if (isCreated)
+    {
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 160);
+        SDL_RenderClear(renderer);
+    }
+    tilemap.DrawChunks(renderer, scale);
+    SDL_SetRenderTarget(renderer, previousTarget);
+    drawnBakeVersion = tilemap.GetBakeVersion();
+}
+
+void Minimap::UpdateBlips(const IBroadphase& broadphase, double time)
+{
+    if (!texture || time < nextBlipTime)
+    {
+        return;
+    }
+    // Kept on the interval, a slow frame doesn't shift the ones after it
+    nextBlipTime = std::max(nextBlipTime + MINIMAP_BLIP_INTERVAL, time);
+    FindBlips(broadphase, COLLISION_LAYER_PLAYER, playerBlips);
+    FindBlips(broadphase, COLLISION_LAYER_ENEMY, enemyBlips);
+}
+
+void Minimap::FindBlips(const IBroadphase& broadphase, uint32_t layers, std::vector<SDL_Rect>& blips)
+{
+    // The circle around the whole map
+    const glm::vec2 center(mapWidth / 2.0f, mapHeight / 2.0f);
+    blipHits.clear();
+    broadphase.QueryRadius(center, glm::length(center), layers, blipHits);
+    blips.clear();
+    for (const auto& hit: blipHits)
+    {
+        const float x = (hit.box.minX + hit.box.maxX) / 2.0f * scale;
+        const float y = (hit.box.minY + hit.box.maxY) / 2.0f * scale;
+        blips.push_back({static_cast<int>(x) - MINIMAP_BLIP_SIZE / 2, static_cast<int>(y) - MINIMAP_BLIP_SIZE / 2, MINIMAP_BLIP_SIZE, MINIMAP_BLIP_SIZE});
+    }
+}
+
+void Minimap::AddBlips(RenderCommandList& commandList, const std::vector<SDL_Rect>& blips, int x, int y, SDL_Color color)
+{
+    blipRects.clear();
+    for (const auto& blip: blips)
+    {
+        blipRects.push_back({x + blip.x, y + blip.y, blip.w, blip.h});
+    }
+    commandList.AddFilledRects(blipRects, color);
+}
+
+void Minimap::Render(RenderCommandList& commandList, const std::vector<Viewport>& viewports, int windowWidth, int windowHeight)
+{
+    if (!texture)
+    {
+        return;
+    }
+    const int x = windowWidth - width - MINIMAP_MARGIN;
+    const int y = windowHeight - height - MINIMAP_MARGIN;
+    commandList.AddCopy(texture, {static_cast<float>(x), static_cast<float>(y), static_cast<float>(width), static_cast<float>(height)});
+
+    cameraRects.clear();
+    for (const auto& viewport: viewports)
+    {
+        cameraRects.push_back
+        ({
+            x + static_cast<int>(viewport.camera.x * scale),
+            y + static_cast<int>(viewport.camera.y * scale),
+            std::max(1, static_cast<int>(viewport.camera.w * scale)),
+            std::max(1, static_cast<int>(viewport.camera.h * scale))
+        });
+    }
+    commandList.AddRects(cameraRects, {255, 255, 255, 255});
+    AddBlips(commandList, enemyBlips, x, y, {255, 60, 60, 255});
+    AddBlips(commandList, playerBlips, x, y, {60, 255, 60, 255});
+}
+
+void Minimap::Clear()
+{
+    SDL_DestroyTexture(texture);
+    texture = nullptr;
+    drawnBakeVersion = 0;
+    playerBlips.clear();
+    enemyBlips.clear();
+    nextBlipTime = 0.0;
+}
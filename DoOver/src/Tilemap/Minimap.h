@@ -0,0 +1,71 @@
+#ifndef MINIMAP_H
+#define MINIMAP_H
+
+#include "Tilemap.h"
+#include "../Renderer/RenderCommandList.h"
+#include "../Renderer/Viewport.h"
+#include "../Physics/Broadphase.h"
+#include <SDL2/SDL.h>
+#include <vector>
+
+// Width in pixels of the minimap, its height follows the map
+const int MINIMAP_WIDTH = 240;
+// Between the minimap and the corner of the window
+const int MINIMAP_MARGIN = 16;
+// Seconds between two refreshes of the blips, they are drawn where they were in between
+const double MINIMAP_BLIP_INTERVAL = 0.1;
+// Side in minimap pixels of the square of an entity
+const int MINIMAP_BLIP_SIZE = 3;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Minimap
+/////////////////////////////////////////////////////////////////////////////////////////////
+// A low resolution view of the whole map in the corner of the window. The baked chunks are
+// drawn once into a cached texture, again only when chunks were baked since, so a frame
+// costs a single copy plus the outlines of the cameras. The chunks streamed out stay on it,
+// the map shows what was explored. The players and enemies are blips over it, found in the
+// broadphase of the collision system rather than by going through the entities, at 10 Hz
+// only, and drawn as one batch of squares per side.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class Minimap
+{
+private:
+    SDL_Texture* texture = nullptr;
+    int width = 0;
+    int height = 0;
+    // Minimap pixels per world pixel
+    float scale = 0.0f;
+    // Of the tilemap when the cache was last drawn
+    unsigned int drawnBakeVersion = 0;
+    std::vector<SDL_Rect> cameraRects;
+    // Of the map, in world pixels
+    float mapWidth = 0.0f;
+    float mapHeight = 0.0f;
+
+    // In minimap pixels, offset to the corner they are drawn in by Render
+    std::vector<SDL_Rect> playerBlips;
+    std::vector<SDL_Rect> enemyBlips;
+    std::vector<SDL_Rect> blipRects;
+    // Reused by every refresh
+    std::vector<BroadphaseHit> blipHits;
+    double nextBlipTime = 0.0;
+
+    void FindBlips(const IBroadphase& broadphase, uint32_t layers, std::vector<SDL_Rect>& blips);
+    void AddBlips(RenderCommandList& commandList, const std::vector<SDL_Rect>& blips, int x, int y, SDL_Color color);
+
+public:
+    Minimap() = default;
+    ~Minimap();
+
+    // Draws the chunks baked since the last update into the cache, on the renderer's thread
+    void Update(SDL_Renderer* renderer, const Tilemap& tilemap);
+    // Finds the blips again once MINIMAP_BLIP_INTERVAL went by since the last time, time in
+    // seconds. Reads the broadphase, not while the simulation runs.
+    void UpdateBlips(const IBroadphase& broadphase, double time);
+    // In the bottom right corner of the window, with where each viewport looks
+    void Render(RenderCommandList& commandList, const std::vector<Viewport>& viewports, int windowWidth, int windowHeight);
+    // Releases the cache, the next update draws it again, e.g. once the render targets are lost
+    void Clear();
+};
+
+#endif
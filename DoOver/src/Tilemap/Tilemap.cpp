@@ -0,0 +1,547 @@
+#include "Tilemap.h"
+#include "./TilemapFormat.h"
+#include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <cstring>
+
+Tilemap::Tilemap()
+{
+    Logger::Log("Tilemap constructor called!");
+}
+
+Tilemap::~Tilemap()
+{
+    DestroyChunks();
+    Logger::Log("Tilemap destructor called!");
+}
+
+bool Tilemap::Load(const std::string& mapFilePath, const std::string& tilesetAssetId, int tileSize, double tileScale)
+{
+    // Read in one go, the parser works on the whole buffer
+    std::ifstream mapFile(mapFilePath, std::ios::binary);
+    if (!mapFile.is_open())
+    {
+        Clear();
+        Logger::Err("Unable to open the tilemap " + mapFilePath);
+        return false;
+    }
+    const std::string mapData((std::istreambuf_iterator<char>(mapFile)), std::istreambuf_iterator<char>());
+
+    if (!LoadFromMemory(mapData.data(), mapData.size(), tilesetAssetId, tileSize, tileScale))
+    {
+        Logger::Err("Unable to parse the tilemap " + mapFilePath);
+        return false;
+    }
+    Logger::Log("Tilemap loaded from " + mapFilePath + " with " + std::to_string(numCols) + "x" + std::to_string(numRows) + " tiles");
+    return true;
+}
+
+bool Tilemap::LoadFromMemory(const char* mapData, size_t mapSize, const std::string& tilesetAssetId, int tileSize, double tileScale)
+{
+    Clear();
+
+    TilemapData tilemap;
+    if (!ParseTilemap(mapData, mapSize, tilemap))
+    {
+        return false;
+    }
+    SetLayout(tilesetAssetId, tileSize, tileScale, tilemap.numCols, tilemap.numRows);
+    if (isLayoutOnly)
+    {
+        return true;
+    }
+
+    // Split the tiles between the chunks
+    for (int chunkRow = 0; chunkRow < GetNumChunkRows(); chunkRow++)
+    {
+        for (int chunkCol = 0; chunkCol < GetNumChunkCols(); chunkCol++)
+        {
+            Chunk chunk = CreateChunk(chunkCol, chunkRow);
+            const int firstCol = chunkCol * chunkTiles;
+            const int firstRow = chunkRow * chunkTiles;
+            for (int row = 0; row < chunk.area.h / tileSize; row++)
+            {
+                for (int col = 0; col < chunk.area.w / tileSize; col++)
+                {
+                    const TilemapTile& tile = tilemap.tiles[(firstRow + row) * numCols + firstCol + col];
+                    chunk.tiles.push_back({tile.col * tileSize, tile.row * tileSize});
+                }
+            }
+            chunks.push_back(std::move(chunk));
+        }
+    }
+    return true;
+}
+
+bool Tilemap::Stream(const std::string& tmbFilePath, const std::string& tilesetAssetId, int tileSize, double tileScale)
+{
+    Clear();
+
+    std::ifstream tmbFile(tmbFilePath, std::ios::binary);
+    TilemapBinaryHeader header;
+    if (!tmbFile.is_open() || !tmbFile.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    {
+        Logger::Err("Unable to open the tilemap " + tmbFilePath);
+        return false;
+    }
+    if (std::memcmp(header.magic, TILEMAP_BINARY_MAGIC, sizeof(header.magic)) != 0 || header.version != TILEMAP_BINARY_VERSION || header.tilesetCols == 0)
+    {
+        Logger::Err("The tilemap " + tmbFilePath + " is not a binary tilemap, only .tmb files are streamed");
+        return false;
+    }
+
+    SetLayout(tilesetAssetId, tileSize, tileScale, header.numCols, header.numRows);
+    streamState = std::make_shared<StreamState>();
+    streamState->filePath = tmbFilePath;
+    streamState->tilesetCols = header.tilesetCols;
+    isChunkRequested.assign(GetNumChunkCols() * GetNumChunkRows(), false);
+
+    Logger::Log("Tilemap " + tmbFilePath + " streamed with " + std::to_string(numCols) + "x" + std::to_string(numRows) + " tiles");
+    return true;
+}
+
+void Tilemap::SetChunkSpawner(ChunkSpawner spawner)
+{
+    chunkSpawner = spawner;
+}
+
+void Tilemap::SetDirect(bool isDirect)
+{
+    this->isDirect = isDirect;
+}
+
+void Tilemap::SetLayoutOnly(bool isLayoutOnly)
+{
+    this->isLayoutOnly = isLayoutOnly;
+}
+
+void Tilemap::SetTileAnimations(const std::vector<TileAnimation>& animations)
+{
+    tileAnimations.clear();
+    for (const auto& animation: animations)
+    {
+        if (!animation.frames.empty() && animation.frameSpeedRate > 0)
+        {
+            tileAnimations.push_back(animation);
+        }
+    }
+}
+
+bool Tilemap::IsStreaming() const
+{
+    return streamState != nullptr;
+}
+
+void Tilemap::UpdateStreaming(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, JobSystem& jobSystem, const SDL_Rect& camera)
+{
+    assetStore->UseTexture(tilesetAssetHandle);
+    if (!streamState)
+    {
+        return;
+    }
+
+    // Chunks are wanted slightly ahead of the camera, and kept a bit longer so a camera
+    // going back and forth over a chunk border does not reload it every frame
+    const SDL_Rect loadRange = GetChunkRange(camera, TILEMAP_STREAM_MARGIN);
+    const SDL_Rect keepRange = GetChunkRange(camera, TILEMAP_STREAM_MARGIN + 1);
+    const auto isInRange = [](const SDL_Rect& range, const Chunk& chunk)
+    {
+        return chunk.chunkCol >= range.x && chunk.chunkCol < range.x + range.w && chunk.chunkRow >= range.y && chunk.chunkRow < range.y + range.h;
+    };
+
+    // Bake the chunks read since the last frame
+    std::vector<Chunk> loadedChunks;
+    {
+        std::lock_guard<std::mutex> lock(streamState->mutex);
+        loadedChunks.swap(streamState->loadedChunks);
+    }
+    const TextureRegion& tileset = assetStore->GetTextureRegion(tilesetAssetId);
+    for (auto& chunk: loadedChunks)
+    {
+        if (!isInRange(keepRange, chunk))
+        {
+            isChunkRequested[chunk.chunkRow * GetNumChunkCols() + chunk.chunkCol] = false;
+            continue;
+        }
+        BakeChunk(renderer, tileset, chunk);
+        if (chunkSpawner)
+        {
+            const SDL_Rect worldArea =
+            {
+                static_cast<int>(chunk.area.x * tileScale),
+                static_cast<int>(chunk.area.y * tileScale),
+                static_cast<int>(chunk.area.w * tileScale),
+                static_cast<int>(chunk.area.h * tileScale)
+            };
+            chunkSpawner(worldArea, chunk.spawnedEntities);
+        }
+        chunks.push_back(std::move(chunk));
+    }
+
+    // Unload the chunks left behind
+    for (auto chunk = chunks.begin(); chunk != chunks.end();)
+    {
+        if (isInRange(keepRange, *chunk))
+        {
+            chunk++;
+            continue;
+        }
+        UnloadChunk(*chunk);
+        isChunkRequested[chunk->chunkRow * GetNumChunkCols() + chunk->chunkCol] = false;
+        chunk = chunks.erase(chunk);
+    }
+
+    // Read the chunks coming into view
+    for (int chunkRow = loadRange.y; chunkRow < loadRange.y + loadRange.h; chunkRow++)
+    {
+        for (int chunkCol = loadRange.x; chunkCol < loadRange.x + loadRange.w; chunkCol++)
+        {
+            const int chunkIndex = chunkRow * GetNumChunkCols() + chunkCol;
+            if (isChunkRequested[chunkIndex])
+            {
+                continue;
+            }
+            isChunkRequested[chunkIndex] = true;
+
+            Chunk chunk = CreateChunk(chunkCol, chunkRow);
+            const std::shared_ptr<StreamState> state = streamState;
+            const int mapNumCols = numCols;
+            const int mapTileSize = tileSize;
+            jobSystem.Schedule([state, chunk, mapNumCols, mapTileSize]() mutable
+            {
+                PROFILE_SCOPE("Tilemap chunk read");
+                ReadChunk(*state, mapNumCols, chunk, mapTileSize);
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->loadedChunks.push_back(std::move(chunk));
+            });
+        }
+    }
+}
+
+void Tilemap::ReadChunk(const StreamState& streamState, int numCols, Chunk& chunk, int tileSize)
+{
+    const int chunkCols = chunk.area.w / tileSize;
+    const int chunkRows = chunk.area.h / tileSize;
+    const int firstCol = chunk.area.x / tileSize;
+    const int firstRow = chunk.area.y / tileSize;
+    chunk.tiles.assign(chunkCols * chunkRows, {0, 0});
+
+    // One read per row of the chunk, the rows of the map are contiguous in the file
+    std::ifstream tmbFile(streamState.filePath, std::ios::binary);
+    std::vector<uint16_t> rowTiles(chunkCols);
+    for (int row = 0; row < chunkRows; row++)
+    {
+        const std::streamoff offset = sizeof(TilemapBinaryHeader) + (static_cast<std::streamoff>(firstRow + row) * numCols + firstCol) * sizeof(uint16_t);
+        tmbFile.seekg(offset);
+        if (!tmbFile.read(reinterpret_cast<char*>(rowTiles.data()), chunkCols * sizeof(uint16_t)))
+        {
+            Logger::Err("The tilemap " + streamState.filePath + " is truncated");
+            return;
+        }
+        for (int col = 0; col < chunkCols; col++)
+        {
+            chunk.tiles[row * chunkCols + col] = {rowTiles[col] % streamState.tilesetCols * tileSize, rowTiles[col] / streamState.tilesetCols * tileSize};
+        }
+    }
+}
+
+void Tilemap::Bake(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore)
+{
+    const TextureRegion& tileset = assetStore->GetTextureRegion(tilesetAssetId);
+    if (!tileset.texture || chunks.empty())
+    {
+        return;
+    }
+
+    for (auto& chunk: chunks)
+    {
+        BakeChunk(renderer, tileset, chunk);
+    }
+    Logger::Log("Tilemap baked into " + std::to_string(chunks.size()) + " chunks");
+}
+
+void Tilemap::BakeChunk(SDL_Renderer* renderer, const TextureRegion& tileset, Chunk& chunk)
+{
+    SDL_DestroyTexture(chunk.texture);
+    chunk.texture = nullptr;
+    this->tileset = tileset;
+    if (!tileset.texture)
+    {
+        return;
+    }
+
+    chunk.animatedTiles.clear();
+    for (int i = 0; i < static_cast<int>(chunk.tiles.size()); i++)
+    {
+        for (int animation = 0; animation < static_cast<int>(tileAnimations.size()); animation++)
+        {
+            const TilemapTile& firstFrame = tileAnimations[animation].frames[0];
+            if (chunk.tiles[i].x == firstFrame.col * tileSize && chunk.tiles[i].y == firstFrame.row * tileSize)
+            {
+                chunk.animatedTiles.push_back({i, animation});
+                break;
+            }
+        }
+    }
+    if (isDirect)
+    {
+        bakeVersion++;
+        return;
+    }
+
+    chunk.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, chunk.area.w, chunk.area.h);
+    if (!chunk.texture)
+    {
+        Logger::Err("Unable to create a tilemap chunk texture: " + std::string(SDL_GetError()));
+        return;
+    }
+    SDL_SetTextureBlendMode(chunk.texture, SDL_BLENDMODE_BLEND);
+
+    SDL_Texture* previousTarget = SDL_GetRenderTarget(renderer);
+    SDL_SetRenderTarget(renderer, chunk.texture);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
+
+    const int chunkCols = chunk.area.w / tileSize;
+    for (int i = 0; i < static_cast<int>(chunk.tiles.size()); i++)
+    {
+        const SDL_Point& tile = chunk.tiles[i];
+        SDL_Rect srcRect = tileset.GetSrcRect({tile.x, tile.y, tileSize, tileSize});
+        SDL_Rect dstRect = {(i % chunkCols) * tileSize, (i / chunkCols) * tileSize, tileSize, tileSize};
+        SDL_RenderCopy(renderer, tileset.texture, &srcRect, &dstRect);
+    }
+    SDL_SetRenderTarget(renderer, previousTarget);
+    bakeVersion++;
+}
+
+bool Tilemap::Render(RenderCommandList& commandList, const SDL_FRect& camera, double time)
+{
+    // The chunks don't overlap, the camera is filled when the parts of them in it add up to it
+    double coveredArea = 0.0;
+    const float worldTileSize = static_cast<float>(tileSize * tileScale);
+    animationBatch.Begin(commandList);
+    for (const auto& chunk: chunks)
+    {
+        const SDL_FRect dstRect =
+        {
+            static_cast<float>(chunk.area.x * tileScale - camera.x),
+            static_cast<float>(chunk.area.y * tileScale - camera.y),
+            static_cast<float>(chunk.area.w * tileScale),
+            static_cast<float>(chunk.area.h * tileScale)
+        };
+
+        // Skip the chunks outside the camera, and the ones not baked yet
+        const bool isBaked = isDirect ? tileset.texture != nullptr : chunk.texture != nullptr;
+        if (!isBaked || dstRect.x + dstRect.w <= 0 || dstRect.y + dstRect.h <= 0 || dstRect.x >= camera.w || dstRect.y >= camera.h)
+        {
+            continue;
+        }
+        const int chunkCols = chunk.area.w / tileSize;
+        if (isDirect)
+        {
+            // Only the tiles of the chunk under the camera, in the batch of the animated tiles
+            const int chunkRows = chunk.area.h / tileSize;
+            const int firstCol = std::max(0, static_cast<int>(-dstRect.x / worldTileSize));
+            const int firstRow = std::max(0, static_cast<int>(-dstRect.y / worldTileSize));
+            const int endCol = std::min(chunkCols, static_cast<int>((camera.w - dstRect.x) / worldTileSize) + 1);
+            const int endRow = std::min(chunkRows, static_cast<int>((camera.h - dstRect.y) / worldTileSize) + 1);
+            for (int row = firstRow; row < endRow; row++)
+            {
+                for (int col = firstCol; col < endCol; col++)
+                {
+                    const SDL_Point& tile = chunk.tiles[row * chunkCols + col];
+                    const SDL_FRect tileRect = {dstRect.x + col * worldTileSize, dstRect.y + row * worldTileSize, worldTileSize, worldTileSize};
+                    animationBatch.Draw(tileset.texture, tileset.GetSrcRect({tile.x, tile.y, tileSize, tileSize}), tileRect, 0.0f);
+                }
+            }
+        }
+        else
+        {
+            commandList.AddCopy(chunk.texture, dstRect);
+        }
+        for (const auto& animatedTile: chunk.animatedTiles)
+        {
+            const SDL_FRect tileRect = {dstRect.x + (animatedTile.first % chunkCols) * worldTileSize, dstRect.y + (animatedTile.first / chunkCols) * worldTileSize, worldTileSize, worldTileSize};
+            if (tileRect.x + tileRect.w <= 0 || tileRect.y + tileRect.h <= 0 || tileRect.x >= camera.w || tileRect.y >= camera.h)
+            {
+                continue;
+            }
+            const TileAnimation& animation = tileAnimations[animatedTile.second];
+            const TilemapTile& frame = animation.frames[static_cast<int>(time * animation.frameSpeedRate) % animation.frames.size()];
+            const SDL_Rect srcRect = tileset.GetSrcRect({frame.col * tileSize, frame.row * tileSize, tileSize, tileSize});
+            animationBatch.Draw(tileset.texture, srcRect, tileRect, 0.0f);
+        }
+        const double coveredWidth = std::min(dstRect.x + dstRect.w, camera.w) - std::max(dstRect.x, 0.0f);
+        const double coveredHeight = std::min(dstRect.y + dstRect.h, camera.h) - std::max(dstRect.y, 0.0f);
+        coveredArea += coveredWidth * coveredHeight;
+    }
+    // The animated tiles over all the chunks, a single draw
+    animationBatch.End();
+    const double cameraArea = static_cast<double>(camera.w) * camera.h;
+    return cameraArea > 0.0 && coveredArea >= cameraArea * (1.0 - TILEMAP_COVERAGE_TOLERANCE);
+}
+
+void Tilemap::DrawChunks(SDL_Renderer* renderer, float scale) const
+{
+    if (isDirect)
+    {
+        DrawTiles(renderer, scale);
+        return;
+    }
+    for (const auto& chunk: chunks)
+    {
+        if (!chunk.texture)
+        {
+            continue;
+        }
+        const SDL_FRect dstRect =
+        {
+            static_cast<float>(chunk.area.x * tileScale * scale),
+            static_cast<float>(chunk.area.y * tileScale * scale),
+            static_cast<float>(chunk.area.w * tileScale * scale),
+            static_cast<float>(chunk.area.h * tileScale * scale)
+        };
+        SDL_RenderCopyF(renderer, chunk.texture, NULL, &dstRect);
+    }
+}
+
+void Tilemap::DrawTiles(SDL_Renderer* renderer, float scale) const
+{
+    if (!tileset.texture)
+    {
+        return;
+    }
+    const float tileWorldSize = static_cast<float>(tileSize * tileScale * scale);
+    for (const auto& chunk: chunks)
+    {
+        const int chunkCols = chunk.area.w / tileSize;
+        for (int i = 0; i < static_cast<int>(chunk.tiles.size()); i++)
+        {
+            const SDL_Point& tile = chunk.tiles[i];
+            const SDL_Rect srcRect = tileset.GetSrcRect({tile.x, tile.y, tileSize, tileSize});
+            const SDL_FRect dstRect =
+            {
+                static_cast<float>(chunk.area.x * tileScale * scale) + (i % chunkCols) * tileWorldSize,
+                static_cast<float>(chunk.area.y * tileScale * scale) + (i / chunkCols) * tileWorldSize,
+                tileWorldSize,
+                tileWorldSize
+            };
+            SDL_RenderCopyF(renderer, tileset.texture, &srcRect, &dstRect);
+        }
+    }
+}
+
+void Tilemap::SetLayout(const std::string& tilesetAssetId, int tileSize, double tileScale, int numCols, int numRows)
+{
+    this->tilesetAssetId = tilesetAssetId;
+    tilesetAssetHandle = GetAssetHandle(tilesetAssetId);
+    this->tileSize = tileSize;
+    this->tileScale = tileScale;
+    this->numCols = numCols;
+    this->numRows = numRows;
+    chunkTiles = std::max(1, TILEMAP_CHUNK_SIZE / tileSize);
+}
+
+Tilemap::Chunk Tilemap::CreateChunk(int chunkCol, int chunkRow) const
+{
+    Chunk chunk;
+    chunk.chunkCol = chunkCol;
+    chunk.chunkRow = chunkRow;
+    const int firstCol = chunkCol * chunkTiles;
+    const int firstRow = chunkRow * chunkTiles;
+    chunk.area =
+    {
+        firstCol * tileSize,
+        firstRow * tileSize,
+        std::min(chunkTiles, numCols - firstCol) * tileSize,
+        std::min(chunkTiles, numRows - firstRow) * tileSize
+    };
+    return chunk;
+}
+
+void Tilemap::UnloadChunk(Chunk& chunk)
+{
+    SDL_DestroyTexture(chunk.texture);
+    chunk.texture = nullptr;
+    for (auto entity: chunk.spawnedEntities)
+    {
+        entity.Kill();
+    }
+    chunk.spawnedEntities.clear();
+}
+
+SDL_Rect Tilemap::GetChunkRange(const SDL_Rect& camera, int margin) const
+{
+    const double chunkWorldSize = chunkTiles * tileSize * tileScale;
+    const int firstChunkCol = std::max(0, static_cast<int>(camera.x / chunkWorldSize) - margin);
+    const int firstChunkRow = std::max(0, static_cast<int>(camera.y / chunkWorldSize) - margin);
+    const int lastChunkCol = std::min(GetNumChunkCols() - 1, static_cast<int>((camera.x + camera.w) / chunkWorldSize) + margin);
+    const int lastChunkRow = std::min(GetNumChunkRows() - 1, static_cast<int>((camera.y + camera.h) / chunkWorldSize) + margin);
+    return {firstChunkCol, firstChunkRow, std::max(0, lastChunkCol - firstChunkCol + 1), std::max(0, lastChunkRow - firstChunkRow + 1)};
+}
+
+int Tilemap::GetNumChunkCols() const
+{
+    return (numCols + chunkTiles - 1) / chunkTiles;
+}
+
+int Tilemap::GetNumChunkRows() const
+{
+    return (numRows + chunkTiles - 1) / chunkTiles;
+}
+
+void Tilemap::DestroyChunks()
+{
+    for (auto& chunk: chunks)
+    {
+        SDL_DestroyTexture(chunk.texture);
+    }
+    chunks.clear();
+}
+
+void Tilemap::Clear()
+{
+    for (auto& chunk: chunks)
+    {
+        UnloadChunk(chunk);
+    }
+    chunks.clear();
+    streamState.reset();
+    isChunkRequested.clear();
+    tileAnimations.clear();
+    tileset = TextureRegion();
+    numCols = 0;
+    numRows = 0;
+}
+
+bool Tilemap::IsBaked() const
+{
+    if (isDirect)
+    {
+        return !chunks.empty() && tileset.texture != nullptr;
+    }
+    return !chunks.empty() && std::all_of(chunks.begin(), chunks.end(), [](const Chunk& chunk) { return chunk.texture != nullptr; });
+}
+
+bool Tilemap::IsTilesetChanged(const AssetStore& assetStore) const
+{
+    return !chunks.empty() && tileset.texture && assetStore.GetTextureRegion(tilesetAssetHandle).texture != tileset.texture;
+}
+
+int Tilemap::GetWidth() const
+{
+    return numCols * tileSize * tileScale;
+}
+
+int Tilemap::GetHeight() const
+{
+    return numRows * tileSize * tileScale;
+}
+
+int Tilemap::GetNumChunks() const
+{
+    return chunks.size();
+}
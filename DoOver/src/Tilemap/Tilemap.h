@@ -0,0 +1,163 @@
+#ifndef TILEMAP_H
+#define TILEMAP_H
+
+#include "../AssetStore/AssetStore.h"
+#include "../ECS/ECS.h"
+#include "../Jobs/JobSystem.h"
+#include "../Renderer/RenderCommandList.h"
+#include "../Renderer/SpriteBatch.h"
+#include "./TilemapFormat.h"
+#include <SDL2/SDL.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <functional>
+
+// Size in texels of the textures the tiles are baked into
+const int TILEMAP_CHUNK_SIZE = 1024;
+// Chunks around the ones under the camera that are streamed in ahead of it
+const int TILEMAP_STREAM_MARGIN = 1;
+// Share of the camera the chunks may miss, from rounding, and still count as filling it
+const double TILEMAP_COVERAGE_TOLERANCE = 1e-5;
+
+// The tiles of the map showing the first frame cycle through the others
+struct TileAnimation
+{
+    std::vector<TilemapTile> frames;
+    // Frames per second
+    int frameSpeedRate = 1;
+};
+
+// Called when a streamed chunk comes in, the entities it spawns are killed when it goes out
+typedef std::function<void(const SDL_Rect& worldArea, std::vector<Entity>& spawnedEntities)> ChunkSpawner;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Tilemap
+/////////////////////////////////////////////////////////////////////////////////////////////
+// The static tile layer of a level, kept out of the ECS: the tiles are baked once into
+// chunk textures at the tileset resolution, and each frame only the chunks under the
+// camera are drawn, scaled to the world size. The animated tiles are baked with their first
+// frame and listed per chunk, only they are drawn again over the chunk, in one batch, with
+// the frame of a clock shared by every tile of an animation.
+//
+// Large maps are streamed instead of loaded: only the chunks around the camera are
+// resident, their tiles are read from the .tmb file on the job system and baked when
+// they arrive, so the memory follows the visible area instead of the map size.
+//
+// Drawn directly, the chunks only hold their tiles and have no texture: the tiles on screen
+// are drawn from the tileset with the animated ones, all in one batch, so the whole map is a
+// single draw without any render target.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class Tilemap
+{
+private:
+    struct Chunk
+    {
+        int chunkCol = 0;
+        int chunkRow = 0;
+        SDL_Rect area = {0, 0, 0, 0}; // In tileset pixels, relative to the map origin
+        // [row * area.w / tileSize + col] -> position of the tile in the tileset
+        std::vector<SDL_Point> tiles;
+        SDL_Texture* texture = nullptr;
+        // [i] -> the tile, the animation it shows, listed when the chunk is baked
+        std::vector<std::pair<int, int>> animatedTiles;
+        std::vector<Entity> spawnedEntities;
+    };
+
+    // Shared with the streaming jobs, which may still run after the tilemap is gone
+    struct StreamState
+    {
+        std::string filePath;
+        int tilesetCols = 0;
+        std::mutex mutex;
+        std::vector<Chunk> loadedChunks;
+    };
+
+    std::string tilesetAssetId;
+    AssetHandle tilesetAssetHandle = INVALID_ASSET_HANDLE;
+    int tileSize = 0;
+    double tileScale = 1.0;
+    int numCols = 0;
+    int numRows = 0;
+    // Tiles on each side of a chunk
+    int chunkTiles = 1;
+    std::vector<Chunk> chunks;
+
+    std::shared_ptr<StreamState> streamState;
+    // [chunkRow * numChunkCols + chunkCol] -> whether the chunk is resident or being read
+    std::vector<bool> isChunkRequested;
+    ChunkSpawner chunkSpawner;
+    std::vector<TileAnimation> tileAnimations;
+    // As the chunks were last baked from, the animated tiles are drawn from it
+    TextureRegion tileset;
+    SpriteBatch animationBatch;
+    bool isDirect = false;
+    bool isLayoutOnly = false;
+    // Counts the chunks baked, for the caches drawn from them
+    unsigned int bakeVersion = 0;
+
+    void SetLayout(const std::string& tilesetAssetId, int tileSize, double tileScale, int numCols, int numRows);
+    Chunk CreateChunk(int chunkCol, int chunkRow) const;
+    void BakeChunk(SDL_Renderer* renderer, const TextureRegion& tileset, Chunk& chunk);
+    void UnloadChunk(Chunk& chunk);
+    void DestroyChunks();
+    // DrawChunks of a map drawn directly, tile by tile
+    void DrawTiles(SDL_Renderer* renderer, float scale) const;
+    int GetNumChunkCols() const;
+    int GetNumChunkRows() const;
+    // Chunks overlapping the camera, grown by margin chunks on each side
+    SDL_Rect GetChunkRange(const SDL_Rect& camera, int margin) const;
+
+    static void ReadChunk(const StreamState& streamState, int numCols, Chunk& chunk, int tileSize);
+
+public:
+    Tilemap();
+    ~Tilemap();
+
+    // Reads a .map or .tmb file (see TilemapFormat.h), the size of the map comes from the file
+    bool Load(const std::string& mapFilePath, const std::string& tilesetAssetId, int tileSize, double tileScale);
+    // Same, from the contents of the file (e.g. mapped from the asset pack)
+    bool LoadFromMemory(const char* mapData, size_t mapSize, const std::string& tilesetAssetId, int tileSize, double tileScale);
+
+    // Opens a .tmb file to be streamed by UpdateStreaming, only its header is read here
+    bool Stream(const std::string& tmbFilePath, const std::string& tilesetAssetId, int tileSize, double tileScale);
+    void SetChunkSpawner(ChunkSpawner spawner);
+    // Draws the tiles from the tileset each frame instead of baking the chunk textures: a quad
+    // per tile on screen for no render target and none of their memory
+    void SetDirect(bool isDirect);
+    // Only the size of the maps loaded from now on is kept, not their tiles, for a game that
+    // never draws them
+    void SetLayoutOnly(bool isLayoutOnly);
+    // Set once the map is loaded, before its chunks are baked
+    void SetTileAnimations(const std::vector<TileAnimation>& animations);
+    // Marks the tileset as drawn, so a streamed one is paged in. Then requests the chunks
+    // coming into view, bakes the ones read since the last frame and unloads the ones left
+    // behind, which a loaded map has none of.
+    void UpdateStreaming(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, JobSystem& jobSystem, const SDL_Rect& camera);
+    bool IsStreaming() const;
+
+    // Renders the tiles into the chunk textures, again whenever the render targets are lost
+    void Bake(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore);
+    // False until the tileset is loaded and the chunks are baked
+    bool IsBaked() const;
+    // The tileset the chunks were baked from was swapped, e.g. a streamed one for its other mip
+    bool IsTilesetChanged(const AssetStore& assetStore) const;
+
+    // The camera is in world pixels, zoomed by the scale of the viewport it is drawn into.
+    // Returns true when the chunks drawn fill the camera, the tiles are opaque ground so
+    // nothing recorded under them in the viewport can be seen. Time in seconds picks the frame
+    // of the animated tiles.
+    bool Render(RenderCommandList& commandList, const SDL_FRect& camera, double time);
+    // Draws the resident chunks into the current render target, the world scaled by scale
+    void DrawChunks(SDL_Renderer* renderer, float scale) const;
+    unsigned int GetBakeVersion() const { return bakeVersion; }
+    void Clear();
+
+    // Size of the map in world pixels
+    int GetWidth() const;
+    int GetHeight() const;
+    int GetNumChunks() const;
+};
+
+#endif
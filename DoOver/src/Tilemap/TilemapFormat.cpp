@@ -0,0 +1,140 @@
+#include "./TilemapFormat.h"
+#include "../Logger/Logger.h"
+#include <cstring>
+#include <algorithm>
+
+bool ParseTilemap(const char* data, size_t size, TilemapData& tilemap)
+{
+    if (size >= sizeof(TILEMAP_BINARY_MAGIC) && std::memcmp(data, TILEMAP_BINARY_MAGIC, sizeof(TILEMAP_BINARY_MAGIC)) == 0)
+    {
+        return ParseBinaryTilemap(data, size, tilemap);
+    }
+    return ParseTextTilemap(data, size, tilemap);
+}
+
+bool ParseTextTilemap(const char* data, size_t size, TilemapData& tilemap)
+{
+    tilemap = TilemapData();
+
+    int line = 1;
+    int numColsInRow = 0;
+    size_t index = 0;
+    while (index < size)
+    {
+        const char ch = data[index];
+
+        // Separators, and the end of a row
+        if (ch == ',' || ch == ' ' || ch == '\t' || ch == '\r')
+        {
+            index++;
+            continue;
+        }
+        if (ch == '\n')
+        {
+            if (numColsInRow > 0)
+            {
+                if (tilemap.numRows == 0)
+                {
+                    tilemap.numCols = numColsInRow;
+                }
+                else if (numColsInRow != tilemap.numCols)
+                {
+                    Logger::Err("Tilemap line " + std::to_string(line) + " has " + std::to_string(numColsInRow) + " tiles instead of " + std::to_string(tilemap.numCols));
+                    tilemap = TilemapData();
+                    return false;
+                }
+                tilemap.numRows++;
+            }
+            numColsInRow = 0;
+            line++;
+            index++;
+            continue;
+        }
+
+        // A tile, exactly two digits
+        const bool isTile = index + 1 < size && ch >= '0' && ch <= '9' && data[index + 1] >= '0' && data[index + 1] <= '9' &&
+            (index + 2 == size || data[index + 2] < '0' || data[index + 2] > '9');
+        if (!isTile)
+        {
+            Logger::Err("Tilemap line " + std::to_string(line) + " has an invalid tile, tiles are two digits: row and column");
+            tilemap = TilemapData();
+            return false;
+        }
+        tilemap.tiles.push_back({static_cast<uint16_t>(data[index + 1] - '0'), static_cast<uint16_t>(ch - '0')});
+        numColsInRow++;
+        index += 2;
+    }
+
+    // The last row may not end with a new line
+    if (numColsInRow > 0)
+    {
+        if (tilemap.numRows > 0 && numColsInRow != tilemap.numCols)
+        {
+            Logger::Err("Tilemap line " + std::to_string(line) + " has " + std::to_string(numColsInRow) + " tiles instead of " + std::to_string(tilemap.numCols));
+            tilemap = TilemapData();
+            return false;
+        }
+        tilemap.numCols = numColsInRow;
+        tilemap.numRows++;
+    }
+    return true;
+}
+
+bool ParseBinaryTilemap(const char* data, size_t size, TilemapData& tilemap)
+{
+    tilemap = TilemapData();
+
+    TilemapBinaryHeader header;
+    if (size < sizeof(header))
+    {
+        Logger::Err("The binary tilemap is truncated");
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, TILEMAP_BINARY_MAGIC, sizeof(header.magic)) != 0 || header.version != TILEMAP_BINARY_VERSION || header.tilesetCols == 0)
+    {
+        Logger::Err("The binary tilemap is invalid or was built by another version, rebuild it with make tilemaps");
+        return false;
+    }
+    const size_t numTiles = static_cast<size_t>(header.numCols) * header.numRows;
+    if (size < sizeof(header) + numTiles * sizeof(uint16_t))
+    {
+        Logger::Err("The binary tilemap is truncated");
+        return false;
+    }
+
+    tilemap.numCols = header.numCols;
+    tilemap.numRows = header.numRows;
+    tilemap.tiles.resize(numTiles);
+    const char* tileData = data + sizeof(header);
+    for (size_t i = 0; i < numTiles; i++)
+    {
+        uint16_t tile;
+        std::memcpy(&tile, tileData + i * sizeof(tile), sizeof(tile));
+        tilemap.tiles[i] = {static_cast<uint16_t>(tile % header.tilesetCols), static_cast<uint16_t>(tile / header.tilesetCols)};
+    }
+    return true;
+}
+
+std::vector<char> WriteBinaryTilemap(const TilemapData& tilemap)
+{
+    TilemapBinaryHeader header;
+    std::memcpy(header.magic, TILEMAP_BINARY_MAGIC, sizeof(header.magic));
+    header.version = TILEMAP_BINARY_VERSION;
+    header.numCols = tilemap.numCols;
+    header.numRows = tilemap.numRows;
+    header.tilesetCols = 1;
+    for (const auto& tile: tilemap.tiles)
+    {
+        header.tilesetCols = std::max<uint32_t>(header.tilesetCols, tile.col + 1);
+    }
+
+    std::vector<char> data(sizeof(header) + tilemap.tiles.size() * sizeof(uint16_t));
+    std::memcpy(data.data(), &header, sizeof(header));
+    for (size_t i = 0; i < tilemap.tiles.size(); i++)
+    {
+        const uint16_t tile = tilemap.tiles[i].row * header.tilesetCols + tilemap.tiles[i].col;
+        std::memcpy(data.data() + sizeof(header) + i * sizeof(tile), &tile, sizeof(tile));
+    }
+    return data;
+}
@@ -0,0 +1,52 @@
+#ifndef TILEMAPFORMAT_H
+#define TILEMAPFORMAT_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Tilemap formats
+/////////////////////////////////////////////////////////////////////////////////////////////
+// .map: text, one line per row, tiles separated by commas. Each tile is two digits, its row
+//       and column in the tileset (e.g. "21" is row 2, column 1).
+// .tmb: binary, a header followed by one uint16 per tile (row * tilesetCols + col), built
+//       from the .map files by tools/TilemapConverter.cpp (make tilemaps).
+// The dimensions come from the file in both cases.
+/////////////////////////////////////////////////////////////////////////////////////////////
+const char TILEMAP_BINARY_MAGIC[4] = {'D', 'T', 'M', 'B'};
+const uint32_t TILEMAP_BINARY_VERSION = 1;
+
+struct TilemapBinaryHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t numCols;
+    uint32_t numRows;
+    uint32_t tilesetCols;
+};
+
+// A tile: its column and row in the tileset
+struct TilemapTile
+{
+    uint16_t col;
+    uint16_t row;
+};
+
+struct TilemapData
+{
+    int numCols = 0;
+    int numRows = 0;
+    // [row * numCols + col]
+    std::vector<TilemapTile> tiles;
+};
+
+// Parses either format, told apart by the binary magic. Errors are logged, and leave tilemap empty.
+bool ParseTilemap(const char* data, size_t size, TilemapData& tilemap);
+bool ParseTextTilemap(const char* data, size_t size, TilemapData& tilemap);
+bool ParseBinaryTilemap(const char* data, size_t size, TilemapData& tilemap);
+
+std::vector<char> WriteBinaryTilemap(const TilemapData& tilemap);
+
+#endif
@@ -0,0 +1,133 @@
+#include "./EventTrace.h"
+#include "../ECS/ECS.h"
+#include "../Logger/Logger.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+// Records are appended to the front buffer, the writer thread empties the back buffer
+struct EventTraceWriter
+{
+    std::FILE* file = nullptr;
+    std::vector<uint8_t> frontBuffer;
+    std::vector<uint8_t> backBuffer;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool isStopping = false;
+    std::thread writer;
+
+    // A trace still open at exit is written out
+    ~EventTraceWriter()
+    {
+        if (writer.joinable())
+        {
+            EventTrace::Close();
+        }
+    }
+
+    void Write()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            condition.wait(lock, [this]() { return !backBuffer.empty() || isStopping; });
+            if (!backBuffer.empty())
+            {
+                // The producers keep filling the front buffer meanwhile
+                std::vector<uint8_t> buffer;
+                buffer.swap(backBuffer);
+                lock.unlock();
+                std::fwrite(buffer.data(), 1, buffer.size(), file);
+                buffer.clear();
+                lock.lock();
+                if (backBuffer.empty() && backBuffer.capacity() < buffer.capacity())
+                {
+                    backBuffer.swap(buffer);
+                }
+                condition.notify_all();
+                continue;
+            }
+            if (isStopping)
+            {
+                return;
+            }
+        }
+    }
+};
+
+static EventTraceWriter traceWriter;
+
+bool EventTrace::Open(const std::string& filePath)
+{
+    Close();
+
+    traceWriter.file = std::fopen(filePath.c_str(), "wb");
+    if (!traceWriter.file)
+    {
+        Logger::Err("Unable to open the event trace " + filePath);
+        return false;
+    }
+    EventTraceHeader header;
+    std::memcpy(header.magic, EVENT_TRACE_MAGIC, sizeof(header.magic));
+    header.version = EVENT_TRACE_VERSION;
+    header.entityIdBits = ENTITY_ID_BITS;
+    header.entityVersionBits = ENTITY_VERSION_BITS;
+    std::fwrite(&header, sizeof(header), 1, traceWriter.file);
+
+    traceWriter.frontBuffer.reserve(EVENT_TRACE_BUFFER_SIZE);
+    traceWriter.backBuffer.reserve(EVENT_TRACE_BUFFER_SIZE);
+    traceWriter.isStopping = false;
+    traceWriter.writer = std::thread(&EventTraceWriter::Write, &traceWriter);
+    isRecording = true;
+
+    Logger::Log("Recording the event trace to " + filePath);
+    return true;
+}
+
+void EventTrace::Close()
+{
+    if (!isRecording)
+    {
+        return;
+    }
+    isRecording = false;
+
+    {
+        std::unique_lock<std::mutex> lock(traceWriter.mutex);
+        traceWriter.condition.wait(lock, []() { return traceWriter.backBuffer.empty(); });
+        traceWriter.backBuffer.swap(traceWriter.frontBuffer);
+        traceWriter.isStopping = true;
+    }
+    traceWriter.condition.notify_all();
+    traceWriter.writer.join();
+
+    std::fclose(traceWriter.file);
+    traceWriter.file = nullptr;
+}
+
+void EventTrace::Write(EventTraceType type, const uint32_t* values, int numValues)
+{
+    uint8_t record[1 + 4 * 4];
+    const uint32_t recordTick = tick.load(std::memory_order_relaxed);
+    record[0] = static_cast<uint8_t>(type);
+    std::memcpy(record + 1, &recordTick, sizeof(recordTick));
+    std::memcpy(record + 5, values, numValues * sizeof(uint32_t));
+    const size_t recordSize = 5 + numValues * sizeof(uint32_t);
+
+    std::unique_lock<std::mutex> lock(traceWriter.mutex);
+    if (!isRecording)
+    {
+        return;
+    }
+    if (traceWriter.frontBuffer.size() + recordSize > EVENT_TRACE_BUFFER_SIZE)
+    {
+        // Hand the full buffer over, waiting only if the writer is still busy with the other one
+        traceWriter.condition.wait(lock, []() { return traceWriter.backBuffer.empty(); });
+        traceWriter.backBuffer.swap(traceWriter.frontBuffer);
+        traceWriter.condition.notify_all();
+    }
+    traceWriter.frontBuffer.insert(traceWriter.frontBuffer.end(), record, record + recordSize);
+}
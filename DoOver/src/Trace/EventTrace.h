@@ -0,0 +1,106 @@
+#ifndef EVENTTRACE_H
+#define EVENTTRACE_H
+
+#include <cstdint>
+#include <string>
+#include <atomic>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Event trace
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Compact binary log of the gameplay events, for post-mortem analysis. Each record is the
+// event type (1 byte), the simulation tick and the event values (4 bytes each), appended
+// to one of two buffers while a background thread writes the other one to the file.
+// tools/TraceDecoder.cpp turns a trace into CSV or JSON (make tracedecoder).
+/////////////////////////////////////////////////////////////////////////////////////////////
+const char EVENT_TRACE_MAGIC[4] = {'D', 'O', 'T', 'R'};
+const uint32_t EVENT_TRACE_VERSION = 1;
+// Size of each of the two buffers
+const int EVENT_TRACE_BUFFER_SIZE = 64 * 1024;
+
+enum EventTraceType
+{
+    TRACE_ENTITY_CREATED = 1, // entity
+    TRACE_ENTITY_KILLED,      // entity
+    TRACE_COLLISION_ENTER,    // entity a, entity b
+    TRACE_COLLISION_EXIT,     // entity a, entity b
+    TRACE_DAMAGE,             // target entity, source entity, amount
+    TRACE_NUM_TYPES
+};
+
+// Values following the type and tick of a record, 0 for unknown types
+inline int GetEventTraceNumValues(int type)
+{
+    switch (type)
+    {
+        case TRACE_ENTITY_CREATED: return 1;
+        case TRACE_ENTITY_KILLED: return 1;
+        case TRACE_COLLISION_ENTER: return 2;
+        case TRACE_COLLISION_EXIT: return 2;
+        case TRACE_DAMAGE: return 3;
+    }
+    return 0;
+}
+
+// Entity values are the raw handles, the header says how to split them
+struct EventTraceHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t entityIdBits;
+    uint32_t entityVersionBits;
+};
+
+class EventTrace
+{
+private:
+    static inline std::atomic<bool> isRecording{false};
+    static inline std::atomic<uint32_t> tick{0};
+
+    static void Write(EventTraceType type, const uint32_t* values, int numValues);
+
+public:
+    static bool Open(const std::string& filePath);
+    // Writes what is left and closes the file
+    static void Close();
+    static bool IsRecording() { return isRecording.load(std::memory_order_relaxed); }
+
+    // The simulation tick stamped on the records
+    static void SetTick(uint32_t tick) { EventTrace::tick.store(tick, std::memory_order_relaxed); }
+
+    static void RecordEntityCreated(uint32_t entity)
+    {
+        if (IsRecording())
+        {
+            Write(TRACE_ENTITY_CREATED, &entity, 1);
+        }
+    }
+
+    static void RecordEntityKilled(uint32_t entity)
+    {
+        if (IsRecording())
+        {
+            Write(TRACE_ENTITY_KILLED, &entity, 1);
+        }
+    }
+
+    static void RecordCollision(EventTraceType type, uint32_t a, uint32_t b)
+    {
+        if (IsRecording())
+        {
+            const uint32_t values[] = {a, b};
+            Write(type, values, 2);
+        }
+    }
+
+    static void RecordDamage(uint32_t target, uint32_t source, int amount)
+    {
+        if (IsRecording())
+        {
+            const uint32_t values[] = {target, source, static_cast<uint32_t>(amount)};
+            Write(TRACE_DAMAGE, values, 3);
+        }
+    }
+};
+
+#endif
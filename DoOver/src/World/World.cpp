@@ -0,0 +1,80 @@
+#include "World.h"
+#include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
+#include "../Resources/TickTimeResource.h"
+
+World::World(const std::string& name, std::unique_ptr<AssetStore>& assetStore, std::unique_ptr<JobSystem>& jobSystem, double deltaTime, StorageMode storageMode)
+    : name(name), assetStore(assetStore), jobSystem(jobSystem)
+{
+    frameClock = std::make_unique<FrameClock>(deltaTime);
+    timerWheel = std::make_unique<TimerWheel>();
+    registry = std::make_unique<Registry>(storageMode);
+    eventBus = std::make_unique<EventBus>();
+    scheduler = std::make_unique<Scheduler>(*jobSystem);
+    Logger::Log("World " + name + " created");
+}
+
+World::~World()
+{
+    if (stepThread.joinable())
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            isStopping = true;
+        }
+        stepChanged.notify_all();
+        stepThread.join();
+    }
+    Logger::Log("World " + name + " destroyed");
+}
+
+void World::Step()
+{
+    PROFILE_SCOPE("World::Step");
+    registry->SetResource<TickTimeResource>(frameClock->GetDeltaTime(), frameClock->GetTick());
+    registry->Update();
+    timerWheel->Advance(frameClock->GetTick());
+    scheduler->Run();
+    eventBus->DispatchQueuedEvents();
+    frameClock->Tick();
+}
+
+void World::StartStep()
+{
+    if (!stepThread.joinable())
+    {
+        stepThread = std::thread(&World::StepLoop, this);
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        isStepRequested = true;
+    }
+    stepChanged.notify_all();
+}
+
+void World::WaitForStep()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    stepChanged.wait(lock, [this]() { return !isStepRequested; });
+}
+
+void World::StepLoop()
+{
+#ifdef ENABLE_PROFILER
+    Profiler::SetThreadName("World " + name);
+#endif
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        stepChanged.wait(lock, [this]() { return isStepRequested || isStopping; });
+        if (isStopping)
+        {
+            return;
+        }
+        lock.unlock();
+        Step();
+        lock.lock();
+        isStepRequested = false;
+        stepChanged.notify_all();
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include "../ECS/ECS.h"
+#include "../AssetStore/AssetStore.h"
+#include "../EventBus/EventBus.h"
+#include "../Jobs/JobSystem.h"
+#include "../Scheduler/Scheduler.h"
+#include "../Clock/FrameClock.h"
+#include "../Clock/TimerWheel.h"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// World
+/////////////////////////////////////////////////////////////////////////////////////////////
+// A simulation of its own next to the game's, e.g. a minimap preview, a lobby or an
+// instanced arena. It has its own registry, systems, events, clock and timers, and shares
+// the asset store and the job system workers. A world is stepped on the calling thread, or
+// on a thread of its own so several worlds advance in parallel. The component ids are
+// compile-time constants and each registry has its own slot in the entity handles, so the
+// worlds share no ECS state.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class World
+{
+private:
+    std::string name;
+    // Owned by the game, referenced the way the systems take them
+    std::unique_ptr<AssetStore>& assetStore;
+    std::unique_ptr<JobSystem>& jobSystem;
+    std::unique_ptr<FrameClock> frameClock;
+    std::unique_ptr<TimerWheel> timerWheel;
+    std::unique_ptr<Registry> registry;
+    std::unique_ptr<EventBus> eventBus;
+    std::unique_ptr<Scheduler> scheduler;
+
+    // Background thread of the world, started by the first StartStep()
+    std::thread stepThread;
+    std::mutex mutex;
+    std::condition_variable stepChanged;
+    bool isStepRequested = false;
+    bool isStopping = false;
+
+    void StepLoop();
+
+public:
+    World(const std::string& name, std::unique_ptr<AssetStore>& assetStore, std::unique_ptr<JobSystem>& jobSystem, double deltaTime, StorageMode storageMode = DEFAULT_STORAGE_MODE);
+    ~World();
+
+    // One simulation tick: the registry update, the timers due, the systems and the events
+    void Step();
+
+    // Runs Step() on the world's thread, WaitForStep() returns once it is done. Nothing else
+    // may touch the world in between.
+    void StartStep();
+    void WaitForStep();
+
+    const std::string& GetName() const { return name; }
+    std::unique_ptr<AssetStore>& GetAssetStore() { return assetStore; }
+    std::unique_ptr<JobSystem>& GetJobSystem() { return jobSystem; }
+    std::unique_ptr<EventBus>& GetEventBus() { return eventBus; }
+    FrameClock& GetFrameClock() const { return *frameClock; }
+    TimerWheel& GetTimerWheel() const { return *timerWheel; }
+    Registry& GetRegistry() const { return *registry; }
+    // The systems a step runs, added like the game's
+    Scheduler& GetScheduler() const { return *scheduler; }
+};
+
+#endif
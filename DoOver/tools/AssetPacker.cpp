@@ -0,0 +1,169 @@
+#define SDL_MAIN_HANDLED
+#include "../src/AssetStore/AssetPack.h"
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Asset packer
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Usage: assetpacker [--compact] <output.pak> <files...>
+// Images are decoded to RGBA32 here, so the game only maps and uploads them. With --compact
+// they are cut to 16 bit texels, in the format their alpha needs. Any other file is stored as
+// it is. The paths are stored as given, run it from the game directory.
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+bool IsImage(const std::string& path)
+{
+    const std::string extensions[] = {".png", ".jpg", ".jpeg", ".bmp", ".tga"};
+    for (const auto& extension: extensions)
+    {
+        if (path.size() >= extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The 16 bit format that keeps the alpha of the RGBA32 surface: none, on or off, or any
+AssetPackEntryType GetCompactType(SDL_Surface* surface)
+{
+    bool isOpaque = true;
+    bool isCutOut = true;
+    SDL_LockSurface(surface);
+    for (int y = 0; y < surface->h; y++)
+    {
+        const uint8_t* row = static_cast<uint8_t*>(surface->pixels) + y * surface->pitch;
+        for (int x = 0; x < surface->w; x++)
+        {
+            const uint8_t alpha = row[x * 4 + 3];
+            isOpaque &= alpha == 255;
+            isCutOut &= alpha == 0 || alpha == 255;
+        }
+    }
+    SDL_UnlockSurface(surface);
+    return isOpaque ? ASSET_PACK_IMAGE_RGB565 : isCutOut ? ASSET_PACK_IMAGE_ARGB1555 : ASSET_PACK_IMAGE_ARGB4444;
+}
+
+bool ReadEntry(const std::string& path, bool isCompact, AssetPackEntry& entry, std::vector<uint8_t>& contents)
+{
+    const std::string packedPath = NormalizeAssetPackPath(path);
+    if (packedPath.size() >= ASSET_PACK_MAX_PATH)
+    {
+        std::cerr << "Skipping " << path << ", the path is longer than " << ASSET_PACK_MAX_PATH - 1 << " characters" << std::endl;
+        return false;
+    }
+    std::memset(&entry, 0, sizeof(entry));
+    std::memcpy(entry.path, packedPath.c_str(), packedPath.size());
+
+    if (IsImage(path))
+    {
+        SDL_Surface* loaded = IMG_Load(path.c_str());
+        if (!loaded)
+        {
+            std::cerr << "Skipping " << path << ": " << IMG_GetError() << std::endl;
+            return false;
+        }
+        SDL_Surface* surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+        SDL_FreeSurface(loaded);
+
+        entry.type = ASSET_PACK_IMAGE_RGBA32;
+        if (isCompact)
+        {
+            entry.type = GetCompactType(surface);
+            const Uint32 format = entry.type == ASSET_PACK_IMAGE_RGB565 ? SDL_PIXELFORMAT_RGB565 : entry.type == ASSET_PACK_IMAGE_ARGB1555 ? SDL_PIXELFORMAT_ARGB1555 : SDL_PIXELFORMAT_ARGB4444;
+            SDL_Surface* compact = SDL_ConvertSurfaceFormat(surface, format, 0);
+            SDL_FreeSurface(surface);
+            surface = compact;
+        }
+        entry.width = surface->w;
+        entry.height = surface->h;
+        entry.pitch = surface->w * surface->format->BytesPerPixel;
+        contents.resize(static_cast<size_t>(entry.pitch) * entry.height);
+        SDL_LockSurface(surface);
+        for (int y = 0; y < surface->h; y++)
+        {
+            std::memcpy(&contents[y * entry.pitch], static_cast<uint8_t*>(surface->pixels) + y * surface->pitch, entry.pitch);
+        }
+        SDL_UnlockSurface(surface);
+        SDL_FreeSurface(surface);
+    }
+    else
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+        {
+            std::cerr << "Skipping " << path << ", unable to open it" << std::endl;
+            return false;
+        }
+        contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        entry.type = ASSET_PACK_RAW;
+    }
+    entry.size = contents.size();
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    const bool isCompact = argc > 1 && std::strcmp(argv[1], "--compact") == 0;
+    const int firstArg = isCompact ? 2 : 1;
+    if (argc < firstArg + 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " [--compact] <output.pak> <files...>" << std::endl;
+        return 1;
+    }
+    const char* packFilePath = argv[firstArg];
+    IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG);
+
+    std::vector<AssetPackEntry> entries;
+    std::vector<std::vector<uint8_t>> contents;
+    for (int i = firstArg + 1; i < argc; i++)
+    {
+        AssetPackEntry entry;
+        std::vector<uint8_t> entryContents;
+        if (ReadEntry(argv[i], isCompact, entry, entryContents))
+        {
+            entries.push_back(entry);
+            contents.push_back(std::move(entryContents));
+        }
+    }
+
+    // The data follows the entry table, each entry aligned
+    uint64_t offset = sizeof(AssetPackHeader) + entries.size() * sizeof(AssetPackEntry);
+    for (auto& entry: entries)
+    {
+        offset = (offset + ASSET_PACK_ALIGNMENT - 1) / ASSET_PACK_ALIGNMENT * ASSET_PACK_ALIGNMENT;
+        entry.offset = offset;
+        offset += entry.size;
+    }
+
+    std::ofstream pack(packFilePath, std::ios::binary);
+    if (!pack.is_open())
+    {
+        std::cerr << "Unable to write " << packFilePath << std::endl;
+        return 1;
+    }
+    AssetPackHeader header;
+    std::memcpy(header.magic, ASSET_PACK_MAGIC, sizeof(header.magic));
+    header.version = ASSET_PACK_VERSION;
+    header.numEntries = entries.size();
+    header.reserved = 0;
+    pack.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    pack.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(AssetPackEntry));
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        const std::vector<char> padding(entries[i].offset - static_cast<uint64_t>(pack.tellp()), 0);
+        pack.write(padding.data(), padding.size());
+        pack.write(reinterpret_cast<const char*>(contents[i].data()), contents[i].size());
+    }
+
+    std::cerr << "Packed " << entries.size() << " files into " << packFilePath << " (" << offset << " bytes)" << std::endl;
+    IMG_Quit();
+    return 0;
+}
@@ -0,0 +1,351 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Performance gate
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Usage: perfgate [options] store <commit> <results...>
+//        perfgate [options] compare <results...>
+// Options: --baselines DIR (./perf), --machine NAME (the host name), --against COMMIT (the
+// last one stored for the machine), --alpha A (0.01), --threshold PERCENT (5)
+//
+// The results are the JSON of the ECS benchmark, whose benchmarks list the time of each
+// repetition, and the CSV the game writes with --report, the tick times and the time of each
+// profiler scope per frame. Store copies them under DIR/machine/commit, the baseline later
+// runs on the same machine are compared with. Compare tests every metric found in both with
+// a one-sided Mann-Whitney U test: a metric fails when its samples are slower than the
+// baseline's at the alpha level AND its median is more than the threshold slower, a change
+// too small to matter passes however significant. The report lists each metric of each file
+// (the scopes of a scenario are its breakdown per system) and the exit code is 1 when any
+// metric failed, 2 when the gate couldn't run.
+/////////////////////////////////////////////////////////////////////////////////////////////
+const std::string DEFAULT_BASELINES_DIR = "./perf";
+const std::string LATEST_FILE_NAME = "LATEST";
+const double DEFAULT_ALPHA = 0.01;
+const double DEFAULT_THRESHOLD_PERCENT = 5.0;
+// Fewer samples on either side than this can't tell anything apart
+const size_t MIN_SAMPLES = 3;
+
+// [metric] -> its samples, in the unit of the file
+typedef std::map<std::string, std::vector<double>> Samples;
+
+struct Comparison
+{
+    std::string metric;
+    double baseMedian;
+    double median;
+    double changePercent;
+    // One-sided, that the new samples are slower, and that they are faster
+    double slowerP;
+    double fasterP;
+};
+
+double GetMedian(std::vector<double> samples)
+{
+    std::sort(samples.begin(), samples.end());
+    const size_t middle = samples.size() / 2;
+    return samples.size() % 2 ? samples[middle] : (samples[middle - 1] + samples[middle]) / 2.0;
+}
+
+// The p-values of the new samples being slower and faster than the baseline's, from the
+// normal approximation of U with the correction for ties and for continuity
+void MannWhitneyU(const std::vector<double>& base, const std::vector<double>& samples, double& slowerP, double& fasterP)
+{
+    struct Ranked
+    {
+        double value;
+        bool isNew;
+    };
+    std::vector<Ranked> all;
+    all.reserve(base.size() + samples.size());
+    for (double value: base)
+    {
+        all.push_back({value, false});
+    }
+    for (double value: samples)
+    {
+        all.push_back({value, true});
+    }
+    std::sort(all.begin(), all.end(), [](const Ranked& a, const Ranked& b) { return a.value < b.value; });
+
+    // Tied values share the mean of their ranks
+    const double n = static_cast<double>(all.size());
+    double newRankSum = 0.0;
+    double tieSum = 0.0;
+    for (size_t i = 0; i < all.size();)
+    {
+        size_t end = i + 1;
+        while (end < all.size() && all[end].value == all[i].value)
+        {
+            end++;
+        }
+        const double rank = (i + 1 + end) / 2.0;
+        for (size_t j = i; j < end; j++)
+        {
+            newRankSum += all[j].isNew ? rank : 0.0;
+        }
+        const double numTied = static_cast<double>(end - i);
+        tieSum += numTied * numTied * numTied - numTied;
+        i = end;
+    }
+
+    const double n1 = static_cast<double>(samples.size());
+    const double n2 = static_cast<double>(base.size());
+    const double u = newRankSum - n1 * (n1 + 1.0) / 2.0;
+    const double mean = n1 * n2 / 2.0;
+    const double variance = n1 * n2 / 12.0 * ((n + 1.0) - tieSum / (n * (n - 1.0)));
+    if (variance <= 0.0)
+    {
+        // Every sample the same value
+        slowerP = 1.0;
+        fasterP = 1.0;
+        return;
+    }
+    const double deviation = std::sqrt(variance);
+    slowerP = 0.5 * std::erfc((u - mean - 0.5) / deviation / std::sqrt(2.0));
+    fasterP = 0.5 * std::erfc((mean - u - 0.5) / deviation / std::sqrt(2.0));
+}
+
+// A benchmark per line, as EcsBenchmark writes them: its name and its "samples" array
+bool ReadBenchmarkJson(const std::string& filePath, Samples& samples)
+{
+    std::ifstream file(filePath);
+    if (!file)
+    {
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line))
+    {
+        const size_t nameKey = line.find("\"name\": \"");
+        const size_t samplesKey = line.find("\"samples\": [");
+        if (nameKey == std::string::npos || samplesKey == std::string::npos)
+        {
+            continue;
+        }
+        const size_t nameBegin = nameKey + std::strlen("\"name\": \"");
+        const std::string name = line.substr(nameBegin, line.find('"', nameBegin) - nameBegin);
+        const size_t valuesBegin = samplesKey + std::strlen("\"samples\": [");
+        std::stringstream values(line.substr(valuesBegin, line.find(']', valuesBegin) - valuesBegin));
+        std::string value;
+        while (std::getline(values, value, ','))
+        {
+            samples[name].push_back(std::strtod(value.c_str(), nullptr));
+        }
+    }
+    return true;
+}
+
+// metric,value lines under a header, as ScenarioReport::WriteSamples writes them
+bool ReadSamplesCsv(const std::string& filePath, Samples& samples)
+{
+    std::ifstream file(filePath);
+    std::string line;
+    if (!file || !std::getline(file, line))
+    {
+        return false;
+    }
+    while (std::getline(file, line))
+    {
+        const size_t comma = line.rfind(',');
+        if (comma != std::string::npos)
+        {
+            samples[line.substr(0, comma)].push_back(std::strtod(line.c_str() + comma + 1, nullptr));
+        }
+    }
+    return true;
+}
+
+bool ReadResults(const std::string& filePath, Samples& samples)
+{
+    const std::string extension = std::filesystem::path(filePath).extension().string();
+    return extension == ".json" ? ReadBenchmarkJson(filePath, samples) : ReadSamplesCsv(filePath, samples);
+}
+
+std::string GetHostName()
+{
+#ifdef _WIN32
+    const char* name = std::getenv("COMPUTERNAME");
+    return name ? name : "unknown";
+#else
+    char name[256] = {};
+    return gethostname(name, sizeof(name) - 1) == 0 && name[0] ? name : "unknown";
+#endif
+}
+
+int Store(const std::filesystem::path& machineDir, const std::string& commit, const std::vector<std::string>& resultFiles)
+{
+    const std::filesystem::path commitDir = machineDir / commit;
+    std::error_code error;
+    std::filesystem::create_directories(commitDir, error);
+    for (const auto& resultFile: resultFiles)
+    {
+        Samples samples;
+        if (!ReadResults(resultFile, samples) || samples.empty())
+        {
+            std::cerr << "Unable to read the results " << resultFile << std::endl;
+            return 2;
+        }
+        const std::filesystem::path target = commitDir / std::filesystem::path(resultFile).filename();
+        if (!std::filesystem::copy_file(resultFile, target, std::filesystem::copy_options::overwrite_existing, error))
+        {
+            std::cerr << "Unable to store " << resultFile << " in " << commitDir.string() << std::endl;
+            return 2;
+        }
+        std::cout << "Stored " << samples.size() << " metrics of " << resultFile << std::endl;
+    }
+    std::ofstream(machineDir / LATEST_FILE_NAME) << commit << "\n";
+    std::cout << "Baseline " << commit << " stored in " << commitDir.string() << std::endl;
+    return 0;
+}
+
+int Compare(const std::filesystem::path& machineDir, std::string against, const std::vector<std::string>& resultFiles, double alpha, double thresholdPercent)
+{
+    if (against.empty())
+    {
+        std::ifstream(machineDir / LATEST_FILE_NAME) >> against;
+    }
+    const std::filesystem::path commitDir = machineDir / against;
+    if (against.empty() || !std::filesystem::is_directory(commitDir))
+    {
+        std::cerr << "No baseline in " << (against.empty() ? machineDir : commitDir).string() << ", store one with perfgate store first" << std::endl;
+        return 2;
+    }
+
+    std::cout << "Against the baseline " << against << ", alpha " << alpha << ", threshold " << thresholdPercent << "%" << std::endl;
+    int numFailed = 0;
+    int numCompared = 0;
+    for (const auto& resultFile: resultFiles)
+    {
+        const std::string fileName = std::filesystem::path(resultFile).filename().string();
+        Samples baseSamples;
+        Samples samples;
+        if (!ReadResults(resultFile, samples))
+        {
+            std::cerr << "Unable to read the results " << resultFile << std::endl;
+            return 2;
+        }
+        if (!ReadResults((commitDir / fileName).string(), baseSamples))
+        {
+            std::cout << "\n" << fileName << ": not in the baseline, skipped" << std::endl;
+            continue;
+        }
+
+        std::cout << "\n" << fileName << "\n" << std::left << std::setw(40) << "metric" << std::right << std::setw(12) << "base" << std::setw(12) << "new"
+            << std::setw(10) << "change" << std::setw(12) << "p" << "  verdict" << std::endl;
+        for (const auto& metric: samples)
+        {
+            const auto base = baseSamples.find(metric.first);
+            if (base == baseSamples.end() || base->second.size() < MIN_SAMPLES || metric.second.size() < MIN_SAMPLES)
+            {
+                std::cout << std::left << std::setw(40) << metric.first << std::right << std::setw(12) << "-" << std::setw(12) << GetMedian(metric.second)
+                    << std::setw(10) << "-" << std::setw(12) << "-" << "  new" << std::endl;
+                continue;
+            }
+            Comparison comparison = {metric.first, GetMedian(base->second), GetMedian(metric.second), 0.0, 1.0, 1.0};
+            comparison.changePercent = comparison.baseMedian > 0.0 ? (comparison.median / comparison.baseMedian - 1.0) * 100.0 : 0.0;
+            MannWhitneyU(base->second, metric.second, comparison.slowerP, comparison.fasterP);
+
+            const char* verdict = "same";
+            double p = std::min(comparison.slowerP, comparison.fasterP);
+            if (comparison.slowerP < alpha && comparison.changePercent > thresholdPercent)
+            {
+                verdict = "SLOWER";
+                p = comparison.slowerP;
+                numFailed++;
+            }
+            else if (comparison.fasterP < alpha && comparison.changePercent < -thresholdPercent)
+            {
+                verdict = "faster";
+                p = comparison.fasterP;
+            }
+            numCompared++;
+            std::cout << std::left << std::setw(40) << comparison.metric << std::right << std::setw(12) << comparison.baseMedian << std::setw(12) << comparison.median
+                << std::setw(9) << std::fixed << std::setprecision(1) << comparison.changePercent << "%" << std::defaultfloat << std::setprecision(6)
+                << std::setw(12) << p << "  " << verdict << std::endl;
+        }
+        for (const auto& base: baseSamples)
+        {
+            if (samples.find(base.first) == samples.end())
+            {
+                std::cout << std::left << std::setw(40) << base.first << std::right << std::setw(12) << GetMedian(base.second) << std::setw(12) << "-"
+                    << std::setw(10) << "-" << std::setw(12) << "-" << "  gone" << std::endl;
+            }
+        }
+    }
+
+    if (numFailed > 0)
+    {
+        std::cout << "\nFAIL: " << numFailed << " of " << numCompared << " metrics slower" << std::endl;
+        return 1;
+    }
+    std::cout << "\nPASS: " << numCompared << " metrics compared" << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string baselinesDir = DEFAULT_BASELINES_DIR;
+    std::string machine;
+    std::string against;
+    double alpha = DEFAULT_ALPHA;
+    double thresholdPercent = DEFAULT_THRESHOLD_PERCENT;
+    std::vector<std::string> arguments;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--baselines") == 0 && i + 1 < argc)
+        {
+            baselinesDir = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--machine") == 0 && i + 1 < argc)
+        {
+            machine = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--against") == 0 && i + 1 < argc)
+        {
+            against = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--alpha") == 0 && i + 1 < argc)
+        {
+            alpha = std::strtod(argv[++i], nullptr);
+        }
+        else if (std::strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+        {
+            thresholdPercent = std::strtod(argv[++i], nullptr);
+        }
+        else
+        {
+            arguments.push_back(argv[i]);
+        }
+    }
+
+    const bool isStore = arguments.size() >= 3 && arguments[0] == "store";
+    const bool isCompare = arguments.size() >= 2 && arguments[0] == "compare";
+    if (!isStore && !isCompare)
+    {
+        std::cerr << "Usage: " << argv[0] << " [options] store <commit> <results...>\n"
+            << "       " << argv[0] << " [options] compare <results...>\n"
+            << "Options: --baselines DIR, --machine NAME, --against COMMIT, --alpha A, --threshold PERCENT" << std::endl;
+        return 2;
+    }
+    const std::filesystem::path machineDir = std::filesystem::path(baselinesDir) / (machine.empty() ? GetHostName() : machine);
+    if (isStore)
+    {
+        return Store(machineDir, arguments[1], std::vector<std::string>(arguments.begin() + 2, arguments.end()));
+    }
+    return Compare(machineDir, against, std::vector<std::string>(arguments.begin() + 1, arguments.end()), alpha, thresholdPercent);
+}
@@ -0,0 +1,64 @@
+#include "../src/Tilemap/TilemapFormat.h"
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Tilemap converter
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Usage: tilemapconverter <files.map...>
+// Writes a .tmb next to each .map, Tilemap::Load reads both formats.
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Convert(const std::string& mapFilePath)
+{
+    std::ifstream mapFile(mapFilePath, std::ios::binary);
+    if (!mapFile.is_open())
+    {
+        std::cerr << "Unable to open " << mapFilePath << std::endl;
+        return false;
+    }
+    const std::string mapData((std::istreambuf_iterator<char>(mapFile)), std::istreambuf_iterator<char>());
+
+    TilemapData tilemap;
+    if (!ParseTextTilemap(mapData.data(), mapData.size(), tilemap))
+    {
+        std::cerr << "Unable to parse " << mapFilePath << std::endl;
+        return false;
+    }
+
+    const size_t extension = mapFilePath.rfind('.');
+    const std::string binaryFilePath = (extension == std::string::npos ? mapFilePath : mapFilePath.substr(0, extension)) + ".tmb";
+    const std::vector<char> binaryData = WriteBinaryTilemap(tilemap);
+    std::ofstream binaryFile(binaryFilePath, std::ios::binary);
+    if (!binaryFile.is_open())
+    {
+        std::cerr << "Unable to write " << binaryFilePath << std::endl;
+        return false;
+    }
+    binaryFile.write(binaryData.data(), binaryData.size());
+
+    std::cerr << mapFilePath << " -> " << binaryFilePath << " (" << tilemap.numCols << "x" << tilemap.numRows << " tiles, "
+              << mapData.size() << " -> " << binaryData.size() << " bytes)" << std::endl;
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <files.map...>" << std::endl;
+        return 1;
+    }
+
+    int numFailed = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!Convert(argv[i]))
+        {
+            numFailed++;
+        }
+    }
+    return numFailed == 0 ? 0 : 1;
+}
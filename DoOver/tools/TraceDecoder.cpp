@@ -0,0 +1,104 @@
+#include "../src/Trace/EventTrace.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Trace decoder
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Usage: tracedecoder <eventtrace.bin> [--json]
+// Prints the records of an event trace as CSV (tick,event,a,b,amount), or as a JSON array.
+// Entities are written as id:version.
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* GetEventName(int type)
+{
+    switch (type)
+    {
+        case TRACE_ENTITY_CREATED: return "entity_created";
+        case TRACE_ENTITY_KILLED: return "entity_killed";
+        case TRACE_COLLISION_ENTER: return "collision_enter";
+        case TRACE_COLLISION_EXIT: return "collision_exit";
+        case TRACE_DAMAGE: return "damage";
+    }
+    return "unknown";
+}
+
+std::string EntityToString(uint32_t handle, const EventTraceHeader& header)
+{
+    const uint32_t id = handle & ((1u << header.entityIdBits) - 1);
+    const uint32_t version = (handle >> header.entityIdBits) & ((1u << header.entityVersionBits) - 1);
+    return std::to_string(id) + ":" + std::to_string(version);
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <eventtrace.bin> [--json]" << std::endl;
+        return 1;
+    }
+    const bool isJson = argc > 2 && std::strcmp(argv[2], "--json") == 0;
+
+    std::ifstream traceFile(argv[1], std::ios::binary);
+    const std::vector<char> trace((std::istreambuf_iterator<char>(traceFile)), std::istreambuf_iterator<char>());
+    EventTraceHeader header;
+    if (trace.size() < sizeof(header))
+    {
+        std::cerr << "Unable to read the event trace " << argv[1] << std::endl;
+        return 1;
+    }
+    std::memcpy(&header, trace.data(), sizeof(header));
+    if (std::memcmp(header.magic, EVENT_TRACE_MAGIC, sizeof(header.magic)) != 0 || header.version != EVENT_TRACE_VERSION)
+    {
+        std::cerr << argv[1] << " is not an event trace of this version" << std::endl;
+        return 1;
+    }
+
+    std::cout << (isJson ? "[\n" : "tick,event,a,b,amount\n");
+    size_t offset = sizeof(header);
+    int numRecords = 0;
+    while (offset + 5 <= trace.size())
+    {
+        const int type = static_cast<uint8_t>(trace[offset]);
+        const int numValues = GetEventTraceNumValues(type);
+        if (numValues == 0 || offset + 5 + numValues * sizeof(uint32_t) > trace.size())
+        {
+            std::cerr << "Corrupted or truncated record at byte " << offset << ", stopping" << std::endl;
+            break;
+        }
+        uint32_t tick;
+        uint32_t values[4] = {0, 0, 0, 0};
+        std::memcpy(&tick, &trace[offset + 1], sizeof(tick));
+        std::memcpy(values, &trace[offset + 5], numValues * sizeof(uint32_t));
+        offset += 5 + numValues * sizeof(uint32_t);
+
+        const std::string a = EntityToString(values[0], header);
+        const std::string b = numValues > 1 ? EntityToString(values[1], header) : "";
+        const std::string amount = type == TRACE_DAMAGE ? std::to_string(static_cast<int32_t>(values[2])) : "";
+        if (isJson)
+        {
+            std::cout << (numRecords > 0 ? ",\n" : "") << "  {\"tick\": " << tick << ", \"event\": \"" << GetEventName(type) << "\", \"a\": \"" << a << "\"";
+            if (!b.empty())
+            {
+                std::cout << ", \"b\": \"" << b << "\"";
+            }
+            if (!amount.empty())
+            {
+                std::cout << ", \"amount\": " << amount;
+            }
+            std::cout << "}";
+        }
+        else
+        {
+            std::cout << tick << "," << GetEventName(type) << "," << a << "," << b << "," << amount << "\n";
+        }
+        numRecords++;
+    }
+    std::cout << (isJson ? "\n]\n" : "");
+    std::cerr << numRecords << " records" << std::endl;
+    return 0;
+}